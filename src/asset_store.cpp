@@ -0,0 +1,471 @@
+#include "asset_store.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <LittleFS.h>
+#endif
+
+namespace {
+constexpr const char* kLvimgPrefix = "lvimg:";
+constexpr std::size_t kIdHexDigits = 16;
+
+std::size_t bytesPerPixel(AssetFormat format) {
+    switch (format) {
+        case AssetFormat::RGB565: return 2;
+        case AssetFormat::RGB565A: return 3;
+        default: return 0;
+    }
+}
+
+bool validFormat(std::uint8_t format) {
+    return format >= static_cast<std::uint8_t>(AssetFormat::RGB565) &&
+           format <= static_cast<std::uint8_t>(AssetFormat::JPEG);
+}
+
+bool parseDimension(std::string_view text, std::uint16_t& value) {
+    if (text.empty() || text.size() > 5) {
+        return false;
+    }
+    std::uint32_t parsed = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        parsed = parsed * 10 + static_cast<std::uint32_t>(c - '0');
+    }
+    if (parsed == 0 || parsed > 0xFFFF) {
+        return false;
+    }
+    value = static_cast<std::uint16_t>(parsed);
+    return true;
+}
+
+bool decodeLvimg(std::string_view value, AssetHeader& header, std::vector<std::uint8_t>& payload,
+                 std::string& error) {
+    value.remove_prefix(std::strlen(kLvimgPrefix));
+    const std::size_t format_end = value.find(':');
+    const std::size_t size_end = format_end == std::string_view::npos ? format_end : value.find(':', format_end + 1);
+    if (size_end == std::string_view::npos) {
+        error = "malformed lvimg payload";
+        return false;
+    }
+    AssetFormat format;
+    if (!parseAssetFormat(value.substr(0, format_end), format) || !bytesPerPixel(format)) {
+        error = "unsupported lvimg format";
+        return false;
+    }
+    const std::string_view size = value.substr(format_end + 1, size_end - format_end - 1);
+    const std::size_t x = size.find('x');
+    std::uint16_t width = 0;
+    std::uint16_t height = 0;
+    if (x == std::string_view::npos || !parseDimension(size.substr(0, x), width) ||
+        !parseDimension(size.substr(x + 1), height)) {
+        error = "invalid lvimg dimensions";
+        return false;
+    }
+    if (!decodeBase64(value.substr(size_end + 1), payload)) {
+        error = "invalid lvimg base64";
+        return false;
+    }
+    return makeAssetHeader(format, width, height, payload.size(), header, error);
+}
+
+bool decodeDataUrl(std::string_view value, AssetHeader& header, std::vector<std::uint8_t>& payload,
+                   std::string& error) {
+    const std::size_t comma = value.find(',');
+    if (comma == std::string_view::npos || value.substr(0, comma).find(";base64") == std::string_view::npos) {
+        error = "data URL is not base64";
+        return false;
+    }
+    const std::string_view mime = value.substr(5, value.find_first_of(";,") - 5);
+    AssetFormat format;
+    if (mime == "image/png") {
+        format = AssetFormat::PNG;
+    } else if (mime == "image/jpeg" || mime == "image/jpg") {
+        format = AssetFormat::JPEG;
+    } else {
+        error = "unsupported image type";
+        return false;
+    }
+    if (!decodeBase64(value.substr(comma + 1), payload)) {
+        error = "invalid data URL base64";
+        return false;
+    }
+    return makeAssetHeader(format, 0, 0, payload.size(), header, error);
+}
+}
+
+AssetHasher::AssetHasher(const AssetHeader& header) {
+    const std::uint8_t shape[5] = {header.format,
+                                   static_cast<std::uint8_t>(header.width), static_cast<std::uint8_t>(header.width >> 8),
+                                   static_cast<std::uint8_t>(header.height), static_cast<std::uint8_t>(header.height >> 8)};
+    update(shape, sizeof(shape));
+}
+
+void AssetHasher::update(const std::uint8_t* data, std::size_t length) {
+    for (std::size_t i = 0; i < length; ++i) {
+        state_ = (state_ ^ data[i]) * 1099511628211ull;
+    }
+}
+
+const char* assetFormatName(AssetFormat format) {
+    switch (format) {
+        case AssetFormat::RGB565: return "rgb565";
+        case AssetFormat::RGB565A: return "rgb565a";
+        case AssetFormat::PNG: return "png";
+        case AssetFormat::JPEG: return "jpeg";
+    }
+    return "unknown";
+}
+
+bool parseAssetFormat(std::string_view name, AssetFormat& format) {
+    for (AssetFormat candidate : {AssetFormat::RGB565, AssetFormat::RGB565A, AssetFormat::PNG, AssetFormat::JPEG}) {
+        if (name == assetFormatName(candidate)) {
+            format = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* assetMimeType(AssetFormat format) {
+    switch (format) {
+        case AssetFormat::PNG: return "image/png";
+        case AssetFormat::JPEG: return "image/jpeg";
+        default: return "application/octet-stream";
+    }
+}
+
+bool makeAssetHeader(AssetFormat format, std::uint16_t width, std::uint16_t height, std::size_t data_size,
+                     AssetHeader& header, std::string& error) {
+    if (!validFormat(static_cast<std::uint8_t>(format))) {
+        error = "unknown asset format";
+        return false;
+    }
+    if (data_size == 0 || data_size > kAssetMaxBytes) {
+        error = "asset must be 1 to " + std::to_string(kAssetMaxBytes) + " bytes";
+        return false;
+    }
+    const std::size_t bpp = bytesPerPixel(format);
+    if (bpp && (width == 0 || height == 0 || data_size != static_cast<std::size_t>(width) * height * bpp)) {
+        error = "pixel data does not match the image dimensions";
+        return false;
+    }
+    header = AssetHeader{};
+    header.magic = kAssetMagic;
+    header.version = kAssetVersion;
+    header.format = static_cast<std::uint8_t>(format);
+    header.width = width;
+    header.height = height;
+    header.data_size = static_cast<std::uint32_t>(data_size);
+    return true;
+}
+
+std::string assetRef(AssetId id) {
+    char ref[32];
+    std::snprintf(ref, sizeof(ref), "%s%016" PRIx64, kAssetRefPrefix, id);
+    return ref;
+}
+
+bool parseAssetRef(std::string_view value, AssetId& id) {
+    const std::size_t prefix = std::strlen(kAssetRefPrefix);
+    if (value.size() != prefix + kIdHexDigits || value.substr(0, prefix) != kAssetRefPrefix) {
+        return false;
+    }
+    AssetId parsed = 0;
+    for (char c : value.substr(prefix)) {
+        const int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+        if (digit < 0) {
+            return false;
+        }
+        parsed = (parsed << 4) | static_cast<AssetId>(digit);
+    }
+    id = parsed;
+    return true;
+}
+
+std::string assetPath(AssetId id) {
+    char path[48];
+    std::snprintf(path, sizeof(path), "%s/%016" PRIx64 ".img", kAssetDirectory, id);
+    return path;
+}
+
+bool isInlineImage(std::string_view value) {
+    return value.substr(0, std::strlen(kLvimgPrefix)) == kLvimgPrefix || value.substr(0, 11) == "data:image/";
+}
+
+bool decodeInlineImage(std::string_view value, AssetHeader& header, std::vector<std::uint8_t>& payload,
+                       std::string& error) {
+    if (value.substr(0, std::strlen(kLvimgPrefix)) == kLvimgPrefix) {
+        return decodeLvimg(value, header, payload, error);
+    }
+    if (value.substr(0, 11) == "data:image/") {
+        return decodeDataUrl(value, header, payload, error);
+    }
+    error = "not an inline image";
+    return false;
+}
+
+bool decodeBase64(std::string_view text, std::vector<std::uint8_t>& out) {
+    out.clear();
+    out.reserve(text.size() / 4 * 3);
+    std::uint32_t bits = 0;
+    int pending = 0;
+    for (char c : text) {
+        int value;
+        if (c >= 'A' && c <= 'Z') {
+            value = c - 'A';
+        } else if (c >= 'a' && c <= 'z') {
+            value = c - 'a' + 26;
+        } else if (c >= '0' && c <= '9') {
+            value = c - '0' + 52;
+        } else if (c == '+') {
+            value = 62;
+        } else if (c == '/') {
+            value = 63;
+        } else if (c == '=') {
+            break;
+        } else if (c == '\r' || c == '\n') {
+            continue;
+        } else {
+            return false;
+        }
+        bits = (bits << 6) | static_cast<std::uint32_t>(value);
+        pending += 6;
+        if (pending >= 8) {
+            pending -= 8;
+            out.push_back(static_cast<std::uint8_t>(bits >> pending));
+        }
+    }
+    return !out.empty();
+}
+
+std::vector<AssetId> referencedAssets(const DeviceConfig& config) {
+    std::vector<AssetId> ids;
+    for (const std::string* value : {&config.images.header_logo, &config.images.splash_logo,
+                                     &config.images.background_image, &config.images.sleep_logo,
+                                     &config.header.logo_base64, &config.display.sleep_icon_base64}) {
+        AssetId id;
+        if (parseAssetRef(*value, id)) {
+            ids.push_back(id);
+        }
+    }
+    return ids;
+}
+
+#ifdef ARDUINO
+namespace {
+constexpr const char* kUploadTempPath = "/assets/upload.tmp";
+constexpr const char* kPutTempPath = "/assets/put.tmp";
+
+bool parseAssetName(const char* name, AssetId& id) {
+    const char* base = std::strrchr(name, '/');
+    base = base ? base + 1 : name;
+    if (std::strlen(base) != kIdHexDigits + 4 || std::strcmp(base + kIdHexDigits, ".img") != 0) {
+        return false;
+    }
+    return parseAssetRef(std::string(kAssetRefPrefix) + std::string(base, kIdHexDigits), id);
+}
+}
+
+AssetStore& AssetStore::instance() {
+    static AssetStore store;
+    return store;
+}
+
+bool AssetStore::begin() {
+    if (!LittleFS.exists(kAssetDirectory) && !LittleFS.mkdir(kAssetDirectory)) {
+        Serial.println("[AssetStore] Failed to create /assets");
+        return false;
+    }
+    // Left behind by a reset mid-write; the asset it would have become was never referenced
+    LittleFS.remove(kUploadTempPath);
+    LittleFS.remove(kPutTempPath);
+    return true;
+}
+
+bool AssetStore::put(const AssetHeader& header, const std::uint8_t* payload, AssetId& id, std::string& error) {
+    AssetHasher hasher(header);
+    hasher.update(payload, header.data_size);
+    id = hasher.id();
+    if (exists(id)) {
+        return true;
+    }
+
+    File file = LittleFS.open(kPutTempPath, FILE_WRITE);
+    if (!file) {
+        error = "could not create asset file";
+        return false;
+    }
+    const bool written = file.write(reinterpret_cast<const std::uint8_t*>(&header), sizeof(header)) == sizeof(header) &&
+                         file.write(payload, header.data_size) == header.data_size;
+    file.close();
+    if (!written) {
+        LittleFS.remove(kPutTempPath);
+        error = "asset write failed (flash full?)";
+        return false;
+    }
+    return commit(kPutTempPath, id, error);
+}
+
+bool AssetStore::internInline(std::string& value, std::string& error) {
+    if (!isInlineImage(value)) {
+        return true;
+    }
+    AssetHeader header;
+    std::vector<std::uint8_t> payload;
+    AssetId id;
+    if (!decodeInlineImage(value, header, payload, error) || !put(header, payload.data(), id, error)) {
+        return false;
+    }
+    value = assetRef(id);
+    return true;
+}
+
+bool AssetStore::beginUpload(const AssetHeader& header, std::string& error) {
+    abortUpload();
+    upload_ = LittleFS.open(kUploadTempPath, FILE_WRITE);
+    if (!upload_) {
+        error = "could not create asset file";
+        return false;
+    }
+    if (upload_.write(reinterpret_cast<const std::uint8_t*>(&header), sizeof(header)) != sizeof(header)) {
+        abortUpload();
+        error = "asset write failed (flash full?)";
+        return false;
+    }
+    upload_header_ = header;
+    upload_hash_ = AssetHasher(header);
+    upload_received_ = 0;
+    upload_failed_ = false;
+    return true;
+}
+
+bool AssetStore::writeUpload(const std::uint8_t* data, std::size_t length) {
+    if (!upload_ || upload_failed_) {
+        return false;
+    }
+    if (upload_received_ + length > upload_header_.data_size || upload_.write(data, length) != length) {
+        upload_failed_ = true;
+        return false;
+    }
+    upload_hash_.update(data, length);
+    upload_received_ += length;
+    return true;
+}
+
+bool AssetStore::finishUpload(AssetId& id, std::string& error) {
+    if (!upload_) {
+        error = "no upload in progress";
+        return false;
+    }
+    upload_.close();
+    if (upload_failed_ || upload_received_ != upload_header_.data_size) {
+        LittleFS.remove(kUploadTempPath);
+        error = upload_failed_ ? "asset write failed" : "upload ended early";
+        return false;
+    }
+    id = upload_hash_.id();
+    if (!commit(kUploadTempPath, id, error)) {
+        return false;
+    }
+    last_upload_ = id;
+    return true;
+}
+
+void AssetStore::abortUpload() {
+    if (upload_) {
+        upload_.close();
+        LittleFS.remove(kUploadTempPath);
+    }
+}
+
+bool AssetStore::exists(AssetId id) const {
+    return LittleFS.exists(assetPath(id).c_str());
+}
+
+bool AssetStore::load(AssetId id, AssetHeader& header, std::vector<std::uint8_t>& payload, std::string& error) const {
+    File file = open(id, header);
+    if (!file) {
+        error = "asset missing or damaged";
+        return false;
+    }
+    payload.resize(header.data_size);
+    const std::size_t read = file.read(payload.data(), payload.size());
+    file.close();
+    AssetHasher hasher(header);
+    hasher.update(payload.data(), payload.size());
+    if (read != payload.size() || hasher.id() != id) {
+        payload.clear();
+        error = "asset contents do not match its id";
+        return false;
+    }
+    return true;
+}
+
+File AssetStore::open(AssetId id, AssetHeader& header) const {
+    File file = LittleFS.open(assetPath(id).c_str(), FILE_READ);
+    if (file && (!readHeader(file, header) || file.size() != sizeof(header) + header.data_size)) {
+        file.close();
+    }
+    return file;
+}
+
+std::vector<AssetStore::Info> AssetStore::list() const {
+    std::vector<Info> assets;
+    File dir = LittleFS.open(kAssetDirectory);
+    if (!dir || !dir.isDirectory()) {
+        return assets;
+    }
+    for (File file = dir.openNextFile(); file; file = dir.openNextFile()) {
+        Info info;
+        if (parseAssetName(file.name(), info.id) && readHeader(file, info.header)) {
+            assets.push_back(info);
+        }
+        file.close();
+    }
+    return assets;
+}
+
+std::size_t AssetStore::collectGarbage(const DeviceConfig& config) {
+    const std::vector<AssetId> live = referencedAssets(config);
+    std::size_t removed = 0;
+    for (const Info& asset : list()) {
+        if (asset.id == last_upload_ || std::find(live.begin(), live.end(), asset.id) != live.end()) {
+            continue;
+        }
+        if (LittleFS.remove(assetPath(asset.id).c_str())) {
+            ++removed;
+        }
+    }
+    if (removed) {
+        Serial.printf("[AssetStore] Removed %u unreferenced assets\n", static_cast<unsigned>(removed));
+    }
+    return removed;
+}
+
+bool AssetStore::readHeader(File& file, AssetHeader& header) {
+    return file.read(reinterpret_cast<std::uint8_t*>(&header), sizeof(header)) == sizeof(header) &&
+           header.magic == kAssetMagic && header.version == kAssetVersion && validFormat(header.format) &&
+           header.data_size <= kAssetMaxBytes;
+}
+
+bool AssetStore::commit(const char* temp_path, AssetId id, std::string& error) {
+    const std::string path = assetPath(id);
+    if (LittleFS.exists(path.c_str())) {
+        LittleFS.remove(temp_path);  // Same content is already stored
+        return true;
+    }
+    if (!LittleFS.rename(temp_path, path.c_str())) {
+        LittleFS.remove(temp_path);
+        error = "could not store asset";
+        return false;
+    }
+    return true;
+}
+#endif
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "config_types.h"
+
+#ifdef ARDUINO
+#include <FS.h>
+#endif
+
+// Image assets live in their own files (/assets/<id>.img), named by a hash of
+// their contents; DeviceConfig only holds "asset:<id>" references. A file is
+// an AssetHeader followed by the payload: LVGL-ready pixels for the RGB565
+// formats, or an encoded PNG/JPEG the device only keeps for the web UI.
+
+enum class AssetFormat : std::uint8_t {
+    RGB565 = 1,   // 2 bytes per pixel, little-endian
+    RGB565A = 2,  // RGB565 then 8-bit alpha, 3 bytes per pixel
+    PNG = 3,
+    JPEG = 4,
+};
+
+struct AssetHeader {
+    std::uint32_t magic;      // kAssetMagic
+    std::uint8_t version;     // kAssetVersion
+    std::uint8_t format;      // AssetFormat
+    std::uint16_t width;      // 0 for encoded formats
+    std::uint16_t height;
+    std::uint16_t reserved;
+    std::uint32_t data_size;  // Payload bytes after the header
+};
+static_assert(sizeof(AssetHeader) == 16, "AssetHeader is part of the file format");
+
+constexpr std::uint32_t kAssetMagic = 0x41474D49;  // "IMGA"
+constexpr std::uint8_t kAssetVersion = 1;
+constexpr std::size_t kAssetMaxBytes = 512 * 1024;
+constexpr const char* kAssetDirectory = "/assets";
+constexpr const char* kAssetRefPrefix = "asset:";
+
+using AssetId = std::uint64_t;
+
+// FNV-1a 64 over the format, the dimensions and the payload, fed in pieces as an upload arrives
+class AssetHasher {
+public:
+    explicit AssetHasher(const AssetHeader& header);
+    void update(const std::uint8_t* data, std::size_t length);
+    AssetId id() const { return state_; }
+
+private:
+    std::uint64_t state_ = 14695981039346656037ull;
+};
+
+const char* assetFormatName(AssetFormat format);
+bool parseAssetFormat(std::string_view name, AssetFormat& format);
+const char* assetMimeType(AssetFormat format);
+// Fills in `header` for a payload of `data_size` bytes, checking it against the format's pixel size
+bool makeAssetHeader(AssetFormat format, std::uint16_t width, std::uint16_t height, std::size_t data_size,
+                     AssetHeader& header, std::string& error);
+
+std::string assetRef(AssetId id);
+bool parseAssetRef(std::string_view value, AssetId& id);
+std::string assetPath(AssetId id);
+// Inline images as older firmware kept them in the config: "lvimg:<format>:<W>x<H>:<base64>" or a base64 data URL
+bool isInlineImage(std::string_view value);
+bool decodeInlineImage(std::string_view value, AssetHeader& header, std::vector<std::uint8_t>& payload,
+                       std::string& error);
+bool decodeBase64(std::string_view text, std::vector<std::uint8_t>& out);
+// Every asset reference `config` holds
+std::vector<AssetId> referencedAssets(const DeviceConfig& config);
+
+#ifdef ARDUINO
+/**
+ * LittleFS side of the store. Identical content maps to the same file, so
+ * storing an image twice costs nothing and replacing one never rewrites the
+ * config's other fields. Uploads stream through a temporary file and are
+ * renamed into place once their size and hash are known; one upload runs at
+ * a time (the web server's task). Files no longer referenced by the config
+ * are removed by collectGarbage().
+ */
+class AssetStore {
+public:
+    struct Info {
+        AssetId id = 0;
+        AssetHeader header{};
+    };
+
+    static AssetStore& instance();
+
+    bool begin();
+
+    bool put(const AssetHeader& header, const std::uint8_t* payload, AssetId& id, std::string& error);
+    // Converts an inline image into an asset and replaces `value` with its reference
+    bool internInline(std::string& value, std::string& error);
+
+    bool beginUpload(const AssetHeader& header, std::string& error);
+    bool writeUpload(const std::uint8_t* data, std::size_t length);
+    bool finishUpload(AssetId& id, std::string& error);
+    void abortUpload();
+
+    bool exists(AssetId id) const;
+    // Reads the payload, checking it still hashes to `id`
+    bool load(AssetId id, AssetHeader& header, std::vector<std::uint8_t>& payload, std::string& error) const;
+    // The file positioned at its payload, for streaming; closed if the header is bad
+    File open(AssetId id, AssetHeader& header) const;
+    std::vector<Info> list() const;
+    // Removes every asset `config` does not reference except the latest upload, which is not referenced yet
+    std::size_t collectGarbage(const DeviceConfig& config);
+
+private:
+    AssetStore() = default;
+
+    static bool readHeader(File& file, AssetHeader& header);
+    bool commit(const char* temp_path, AssetId id, std::string& error);
+
+    File upload_;
+    AssetHeader upload_header_{};
+    AssetHasher upload_hash_{AssetHeader{}};
+    std::size_t upload_received_ = 0;
+    bool upload_failed_ = false;
+    AssetId last_upload_ = 0;
+};
+#endif
@@ -0,0 +1,95 @@
+#include "can_autobaud.h"
+
+#include <array>
+
+#include "can_platform.h"
+#include "can_types.h"
+
+namespace {
+constexpr std::uint32_t kReceiveSliceMs = 10;  // Alerts are polled between receive() waits
+}
+
+bool CanAutoBaud::detect(CanDriver& driver, const CanDriverConfig& base, const CanAutoBaudOptions& options,
+                         CanAutoBaudResult& result) {
+    result = CanAutoBaudResult{};
+
+    std::array<std::uint32_t, kCanBitrates.size()> order{};
+    std::size_t count = 0;
+    if (canBitrateSupported(options.preferred_bitrate)) {
+        order[count++] = options.preferred_bitrate;
+    }
+    for (std::uint32_t bitrate : kCanBitrates) {
+        if (bitrate != options.preferred_bitrate) {
+            order[count++] = bitrate;
+        }
+    }
+
+    CanDriverConfig config = base;
+    config.listen_only = true;
+    const std::uint32_t start = canMillis();
+    std::size_t next = 0;
+    while (canMillis() - start < options.timeout_ms) {
+        config.bitrate = order[next];
+        next = (next + 1) % count;
+
+        std::uint32_t frames = 0;
+        const Verdict verdict = probe(driver, config, options, frames);
+        ++result.probes;
+        if (verdict == Verdict::REJECTED) {
+            ++result.rejected;
+        } else if (verdict == Verdict::LOCKED) {
+            result.locked = true;
+            result.bitrate = config.bitrate;
+            result.frames = frames;
+            break;
+        }
+    }
+    result.elapsed_ms = canMillis() - start;
+
+    if (result.locked) {
+        CAN_LOGF("[CanManager] Auto-baud locked at %lu bps after %lu ms (%lu probes)\n",
+                 static_cast<unsigned long>(result.bitrate), static_cast<unsigned long>(result.elapsed_ms),
+                 static_cast<unsigned long>(result.probes));
+    } else {
+        CAN_LOGF("[CanManager] Auto-baud found no traffic in %lu ms (%lu probes, %lu with errors)\n",
+                 static_cast<unsigned long>(result.elapsed_ms), static_cast<unsigned long>(result.probes),
+                 static_cast<unsigned long>(result.rejected));
+    }
+    return result.locked;
+}
+
+CanAutoBaud::Verdict CanAutoBaud::probe(CanDriver& driver, const CanDriverConfig& config,
+                                        const CanAutoBaudOptions& options, std::uint32_t& frames) {
+    if (!driver.install(config)) {
+        return Verdict::REJECTED;
+    }
+    if (!driver.start()) {
+        driver.uninstall();
+        return Verdict::REJECTED;
+    }
+
+    Verdict verdict = Verdict::SILENT;
+    const std::uint32_t start = canMillis();
+    while (canMillis() - start < options.dwell_ms) {
+        // One error frame rules the rate out: sampling at the wrong rate sees nothing else
+        std::uint32_t alerts = 0;
+        if (driver.readAlerts(alerts, 0) && (alerts & canAlertBit(CanBusAlert::BUS_ERROR))) {
+            verdict = Verdict::REJECTED;
+            break;
+        }
+        CanFrame frame;
+        if (driver.receive(frame, kReceiveSliceMs) && ++frames >= options.min_frames) {
+            // Errors raised alongside the last frame still count against the rate
+            if (driver.readAlerts(alerts, 0) && (alerts & canAlertBit(CanBusAlert::BUS_ERROR))) {
+                verdict = Verdict::REJECTED;
+            } else {
+                verdict = Verdict::LOCKED;
+            }
+            break;
+        }
+    }
+
+    driver.stop();
+    driver.uninstall();
+    return verdict;
+}
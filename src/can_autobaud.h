@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+
+#include "can_driver.h"
+
+struct CanAutoBaudOptions {
+    std::uint32_t preferred_bitrate = 250000;  // Probed first (the last known rate locks in one dwell)
+    std::uint32_t dwell_ms = 250;              // Listening time per candidate rate
+    std::uint32_t timeout_ms = 3000;           // Whole search, cycling through the candidates
+    std::uint32_t min_frames = 3;              // Valid frames needed to lock
+};
+
+struct CanAutoBaudResult {
+    bool locked = false;
+    std::uint32_t bitrate = 0;     // Locked rate, 0 when nothing locked
+    std::uint32_t elapsed_ms = 0;  // Detection time, or the time spent before giving up
+    std::uint32_t frames = 0;      // Valid frames seen at the locked rate
+    std::uint32_t probes = 0;      // Candidate rates listened to
+    std::uint32_t rejected = 0;    // Probes ended by an error frame (or a driver that failed to start)
+};
+
+/**
+ * Bitrate detection by listening.
+ *
+ * Installs the driver in listen-only mode at each rate in kCanBitrates
+ * (preferred rate first) and locks onto the first one that delivers
+ * `min_frames` valid frames without a single bus error. Listen-only means
+ * the probe never acknowledges, transmits or raises error frames, so a
+ * wrong guess is invisible to the rest of the bus. A silent bus cannot be
+ * detected; the search cycles until the timeout and reports no lock.
+ *
+ * The driver must be uninstalled on entry and is left uninstalled.
+ */
+class CanAutoBaud {
+public:
+    static bool detect(CanDriver& driver, const CanDriverConfig& base, const CanAutoBaudOptions& options,
+                       CanAutoBaudResult& result);
+
+private:
+    enum class Verdict : std::uint8_t { LOCKED, REJECTED, SILENT };
+
+    static Verdict probe(CanDriver& driver, const CanDriverConfig& config, const CanAutoBaudOptions& options,
+                         std::uint32_t& frames);
+};
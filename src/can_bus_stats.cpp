@@ -0,0 +1,152 @@
+#include "can_bus_stats.h"
+
+#include "can_types.h"
+
+const char* CanBusStats::alertName(CanBusAlert alert) {
+    switch (alert) {
+        case CanBusAlert::BUS_ERROR: return "bus_error";
+        case CanBusAlert::ERROR_WARNING: return "error_warning";
+        case CanBusAlert::ERROR_PASSIVE: return "error_passive";
+        case CanBusAlert::ERROR_ACTIVE: return "error_active";
+        case CanBusAlert::BUS_OFF: return "bus_off";
+        case CanBusAlert::BUS_RECOVERED: return "bus_recovered";
+        case CanBusAlert::ARBITRATION_LOST: return "arbitration_lost";
+        case CanBusAlert::TX_FAILED: return "tx_failed";
+        case CanBusAlert::RX_QUEUE_FULL: return "rx_queue_full";
+        default: return "unknown";
+    }
+}
+
+CanBusStats::Slot* CanBusStats::slotFor(std::uint32_t pgn) {
+    const std::uint32_t key = pgn + 1;
+    std::size_t index = (key * 2654435761u) >> 25;
+    for (std::size_t probe = 0; probe < kMaxPgns; ++probe, ++index) {
+        Slot& slot = slots_[index & (kMaxPgns - 1)];
+        std::uint32_t current = slot.key.load(std::memory_order_acquire);
+        if (current == key) {
+            return &slot;
+        }
+        if (current == 0) {
+            // RX and TX tasks may race for the same empty slot; the loser sees the winner's key
+            if (slot.key.compare_exchange_strong(current, key, std::memory_order_acq_rel) || current == key) {
+                return &slot;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void CanBusStats::recordRx(std::uint32_t identifier, bool extended, std::uint8_t length, std::uint32_t now_ms) {
+    add(rx_frames_);
+    add(rx_bits_, extended ? canExtendedFrameBits(length) : canStandardFrameBits(length));
+    Slot* slot = slotFor(extended ? j1939PgnFromIdentifier(identifier) : identifier | 0x80000000u);
+    if (!slot) {
+        untracked_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    add(slot->rx);
+    slot->last_rx_ms.store(now_ms, std::memory_order_relaxed);
+}
+
+void CanBusStats::recordTx(std::uint32_t identifier, bool extended, std::uint8_t length, std::uint32_t now_ms) {
+    bump(tx_frames_);
+    bump(tx_bits_, extended ? canExtendedFrameBits(length) : canStandardFrameBits(length));
+    Slot* slot = slotFor(extended ? j1939PgnFromIdentifier(identifier) : identifier | 0x80000000u);
+    if (!slot) {
+        untracked_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    bump(slot->tx);
+    slot->last_tx_ms.store(now_ms, std::memory_order_relaxed);
+}
+
+void CanBusStats::recordAlert(CanBusAlert alert) {
+    if (alert < CanBusAlert::COUNT) {
+        bump(alerts_[static_cast<std::size_t>(alert)]);
+    }
+}
+
+void CanBusStats::tick(std::uint32_t now_ms) {
+    std::lock_guard<std::mutex> lock(tick_mutex_);
+    const std::uint32_t bits = rx_bits_.load(std::memory_order_relaxed) + tx_bits_.load(std::memory_order_relaxed);
+    if (!window_open_) {
+        window_open_ = true;
+        window_start_ms_ = now_ms;
+        window_bits_ = bits;
+        for (Slot& slot : slots_) {
+            slot.window_rx = slot.rx.load(std::memory_order_relaxed);
+            slot.window_tx = slot.tx.load(std::memory_order_relaxed);
+        }
+        return;
+    }
+
+    const std::uint32_t elapsed = now_ms - window_start_ms_;
+    if (elapsed < kWindowMs) {
+        return;
+    }
+
+    const std::uint64_t capacity = static_cast<std::uint64_t>(bitrate_.load(std::memory_order_relaxed)) * elapsed;
+    const std::uint32_t permille =
+        capacity ? static_cast<std::uint32_t>(static_cast<std::uint64_t>(bits - window_bits_) * 1000000u / capacity) : 0;
+    load_permille_.store(permille, std::memory_order_relaxed);
+    if (permille > peak_load_permille_.load(std::memory_order_relaxed)) {
+        peak_load_permille_.store(permille, std::memory_order_relaxed);
+    }
+
+    for (Slot& slot : slots_) {
+        if (slot.key.load(std::memory_order_acquire) == 0) {
+            continue;
+        }
+        const std::uint32_t rx = slot.rx.load(std::memory_order_relaxed);
+        const std::uint32_t tx = slot.tx.load(std::memory_order_relaxed);
+        slot.rx_rate_x10.store((rx - slot.window_rx) * 10000u / elapsed, std::memory_order_relaxed);
+        slot.tx_rate_x10.store((tx - slot.window_tx) * 10000u / elapsed, std::memory_order_relaxed);
+        slot.window_rx = rx;
+        slot.window_tx = tx;
+    }
+    window_start_ms_ = now_ms;
+    window_bits_ = bits;
+}
+
+CanBusSnapshot CanBusStats::snapshot() const {
+    CanBusSnapshot snap;
+    snap.rx_frames = rx_frames_.load(std::memory_order_relaxed);
+    snap.tx_frames = tx_frames_.load(std::memory_order_relaxed);
+    snap.load_percent = load_permille_.load(std::memory_order_relaxed) / 10.0f;
+    snap.peak_load_percent = peak_load_permille_.load(std::memory_order_relaxed) / 10.0f;
+    snap.untracked_frames = untracked_.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < alerts_.size(); ++i) {
+        snap.alerts[i] = alerts_[i].load(std::memory_order_relaxed);
+    }
+    for (const Slot& slot : slots_) {
+        const std::uint32_t key = slot.key.load(std::memory_order_acquire);
+        if (key == 0) {
+            continue;
+        }
+        CanPgnStats entry;
+        entry.pgn = key - 1;
+        entry.rx_frames = slot.rx.load(std::memory_order_relaxed);
+        entry.tx_frames = slot.tx.load(std::memory_order_relaxed);
+        entry.rx_per_sec = slot.rx_rate_x10.load(std::memory_order_relaxed) / 10.0f;
+        entry.tx_per_sec = slot.tx_rate_x10.load(std::memory_order_relaxed) / 10.0f;
+        entry.last_rx_ms = slot.last_rx_ms.load(std::memory_order_relaxed);
+        entry.last_tx_ms = slot.last_tx_ms.load(std::memory_order_relaxed);
+        snap.pgns.push_back(entry);
+    }
+    return snap;
+}
+
+void CanBusStats::reset() {
+    // Keys stay put: a writer may be mid-insert, and the PGN set rarely changes anyway
+    std::lock_guard<std::mutex> lock(tick_mutex_);
+    for (Slot& slot : slots_) {
+        slot.rx_rate_x10.store(0, std::memory_order_relaxed);
+        slot.tx_rate_x10.store(0, std::memory_order_relaxed);
+    }
+    for (auto& alert : alerts_) {
+        alert.store(0, std::memory_order_relaxed);
+    }
+    untracked_.store(0, std::memory_order_relaxed);
+    peak_load_permille_.store(0, std::memory_order_relaxed);
+    window_open_ = false;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+enum class CanBusAlert : std::uint8_t {
+    BUS_ERROR,
+    ERROR_WARNING,    // An error counter crossed the warning limit (96)
+    ERROR_PASSIVE,    // Transition to error passive
+    ERROR_ACTIVE,     // Transition back to error active
+    BUS_OFF,
+    BUS_RECOVERED,
+    ARBITRATION_LOST,
+    TX_FAILED,
+    RX_QUEUE_FULL,
+    COUNT
+};
+
+struct CanPgnStats {
+    std::uint32_t pgn = 0;
+    std::uint32_t rx_frames = 0;
+    std::uint32_t tx_frames = 0;
+    float rx_per_sec = 0.0f;
+    float tx_per_sec = 0.0f;
+    std::uint32_t last_rx_ms = 0;
+    std::uint32_t last_tx_ms = 0;
+};
+
+struct CanBusSnapshot {
+    std::uint32_t rx_frames = 0;
+    std::uint32_t tx_frames = 0;
+    float load_percent = 0.0f;       // Last full window, worst-case stuffing
+    float peak_load_percent = 0.0f;
+    std::array<std::uint32_t, static_cast<std::size_t>(CanBusAlert::COUNT)> alerts{};
+    std::uint32_t untracked_frames = 0;  // Frames whose PGN did not fit in the table
+    // Controller view, filled in by CanManager
+    const char* bus_state = "unknown";
+    std::uint32_t tx_error_counter = 0;
+    std::uint32_t rx_error_counter = 0;
+    std::vector<CanPgnStats> pgns;
+};
+
+/**
+ * Per-PGN traffic counters and bus-load estimate.
+ *
+ * recordRx() has two producers (the RX task and injectRx) and is called
+ * outside CanManager's RX lock, so its counters take a relaxed fetch_add.
+ * recordTx() runs only on the TX task, so its counters have a single writer
+ * and get a relaxed load/store. The CAS that claims a table slot the first
+ * time a PGN is seen is the only other read-modify-write. tick() closes a
+ * measurement window once per second and turns the counter deltas into rates
+ * and a load percentage. Readers take a snapshot of the atomics and never
+ * block the writers.
+ *
+ * 11-bit frames are tracked under 0x80000000 | identifier. Frame counters
+ * are cumulative; reset() clears alert counts and the load peak.
+ */
+class CanBusStats {
+public:
+    static constexpr std::size_t kMaxPgns = 128;   // Power of two
+    static constexpr std::uint32_t kWindowMs = 1000;
+
+    static const char* alertName(CanBusAlert alert);
+
+    void setBitrate(std::uint32_t bitrate) { bitrate_.store(bitrate, std::memory_order_relaxed); }
+
+    void recordRx(std::uint32_t identifier, bool extended, std::uint8_t length, std::uint32_t now_ms);
+    void recordTx(std::uint32_t identifier, bool extended, std::uint8_t length, std::uint32_t now_ms);
+    void recordAlert(CanBusAlert alert);
+
+    // Rolls the rate window; call at least a few times per second from one task
+    void tick(std::uint32_t now_ms);
+
+    CanBusSnapshot snapshot() const;
+    void reset();
+
+private:
+    struct Slot {
+        std::atomic<std::uint32_t> key{0};  // pgn + 1, 0 = empty
+        std::atomic<std::uint32_t> rx{0};
+        std::atomic<std::uint32_t> tx{0};
+        std::atomic<std::uint32_t> last_rx_ms{0};
+        std::atomic<std::uint32_t> last_tx_ms{0};
+        std::atomic<std::uint32_t> rx_rate_x10{0};
+        std::atomic<std::uint32_t> tx_rate_x10{0};
+        std::uint32_t window_rx = 0;  // Counts at the start of the window, touched by tick() only
+        std::uint32_t window_tx = 0;
+    };
+
+    Slot* slotFor(std::uint32_t pgn);
+    static void bump(std::atomic<std::uint32_t>& counter, std::uint32_t amount = 1) {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+    static void add(std::atomic<std::uint32_t>& counter, std::uint32_t amount = 1) {
+        counter.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    std::array<Slot, kMaxPgns> slots_{};
+    std::atomic<std::uint32_t> rx_frames_{0};
+    std::atomic<std::uint32_t> tx_frames_{0};
+    std::atomic<std::uint32_t> rx_bits_{0};
+    std::atomic<std::uint32_t> tx_bits_{0};
+    std::atomic<std::uint32_t> untracked_{0};
+    std::array<std::atomic<std::uint32_t>, static_cast<std::size_t>(CanBusAlert::COUNT)> alerts_{};
+    std::atomic<std::uint32_t> bitrate_{250000};
+    std::atomic<std::uint32_t> load_permille_{0};
+    std::atomic<std::uint32_t> peak_load_permille_{0};
+
+    std::mutex tick_mutex_;  // Window bookkeeping; never taken by the writers
+    std::uint32_t window_start_ms_ = 0;
+    std::uint32_t window_bits_ = 0;
+    bool window_open_ = false;
+};
@@ -0,0 +1,219 @@
+#include "can_button_coalescer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "can_types.h"
+
+namespace {
+// Wrap-safe age of a millisecond timestamp
+std::uint32_t age(std::uint32_t now_ms, std::uint32_t then_ms) {
+    return now_ms - then_ms;
+}
+}
+
+std::uint32_t CanButtonCoalescer::keyFor(const std::string& button) {
+    std::uint32_t hash = 2166136261u;  // FNV-1a
+    for (char c : button) {
+        hash = (hash ^ static_cast<std::uint8_t>(c)) * 16777619u;
+    }
+    return hash ? hash : 1;
+}
+
+void CanButtonCoalescer::configure(const CanCoalesceConfig& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    config_ = config;
+}
+
+CanButtonCoalescer::Decision CanButtonCoalescer::submit(const std::string& button, CanTxRequest& request,
+                                                        std::uint32_t now_ms, std::uint16_t& abandoned_trace) {
+    abandoned_trace = 0;
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.events;
+    Button* entry = config_.enabled ? lookup(keyFor(button), now_ms) : nullptr;
+    if (!entry) {
+        ++stats_.sent;  // Disabled, or every slot is holding a frame: pass straight through
+        return Decision::SEND;
+    }
+    entry->used_ms = now_ms;
+    const bool repeat = entry->has_last && sameCommand(*entry, request) &&
+                        age(now_ms, entry->last_sent_ms) < config_.duplicate_window_ms;
+
+    if (entry->held) {
+        // The held frame never made it out; the newest command replaces it
+        abandoned_trace = entry->pending.trace_id;
+        ++stats_.superseded;
+        if (repeat) {
+            entry->held = false;  // Back to what the bus already has
+            ++stats_.duplicates;
+            return Decision::DROP;
+        }
+        entry->pending = request;
+        return Decision::DEFER;
+    }
+    if (repeat) {
+        ++stats_.duplicates;
+        return Decision::DROP;
+    }
+
+    if (dueAt(j1939PgnFromIdentifier(request.identifier), now_ms) == now_ms) {
+        markSent(*entry, request, now_ms);
+        ++stats_.sent;
+        return Decision::SEND;
+    }
+    entry->held = true;
+    entry->pending = request;
+    ++stats_.deferred;
+    return Decision::DEFER;
+}
+
+void CanButtonCoalescer::forget(const std::string& button, const CanTxRequest& request, std::uint32_t now_ms) {
+    const std::uint32_t key = keyFor(button);
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Button& entry : buttons_) {
+        if (entry.key == key) {
+            entry.has_last = false;
+        }
+    }
+    if (request.spaced) {
+        release(request.identifier, now_ms);
+    }
+}
+
+void CanButtonCoalescer::transmitted(std::uint32_t identifier, std::uint32_t now_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    release(identifier, now_ms);
+}
+
+std::uint32_t CanButtonCoalescer::poll(std::uint32_t now_ms) {
+    std::array<CanTxRequest, kMaxButtons> ready{};
+    std::array<std::uint32_t, kMaxButtons> keys{};
+    std::size_t count = 0;
+    std::uint32_t next = kIdle;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (Button& entry : buttons_) {
+            if (!entry.key || !entry.held) {
+                continue;
+            }
+            const std::uint32_t due = dueAt(j1939PgnFromIdentifier(entry.pending.identifier), now_ms);
+            if (due != now_ms) {
+                next = std::min(next, due - now_ms);
+                continue;
+            }
+            entry.held = false;
+            markSent(entry, entry.pending, now_ms);
+            ++stats_.sent;
+            keys[count] = entry.key;
+            ready[count++] = entry.pending;
+        }
+    }
+
+    // The sink takes the TX queue lock; call it without mutex_ held
+    for (std::size_t i = 0; i < count; ++i) {
+        if (sink_ && sink_(ready[i])) {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (Button& entry : buttons_) {
+            if (entry.key == keys[i]) {
+                entry.has_last = false;  // Not on the bus after all; the next press is not a duplicate
+            }
+        }
+        release(ready[i].identifier, now_ms);
+    }
+    return next;
+}
+
+void CanButtonCoalescer::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    buttons_.fill(Button{});
+    pgns_.fill(PgnSlot{});
+}
+
+CanCoalesceStats CanButtonCoalescer::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void CanButtonCoalescer::resetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_ = CanCoalesceStats{};
+}
+
+CanButtonCoalescer::Button* CanButtonCoalescer::lookup(std::uint32_t key, std::uint32_t now_ms) {
+    Button* victim = nullptr;
+    for (Button& entry : buttons_) {
+        if (entry.key == key) {
+            return &entry;
+        }
+        if (entry.held) {
+            continue;
+        }
+        if (!victim || !entry.key || (victim->key && age(now_ms, entry.used_ms) > age(now_ms, victim->used_ms))) {
+            victim = &entry;
+        }
+    }
+    if (victim) {
+        *victim = Button{};
+        victim->key = key;
+    }
+    return victim;
+}
+
+CanButtonCoalescer::PgnSlot* CanButtonCoalescer::pgnSlot(std::uint32_t pgn, bool create) {
+    PgnSlot* victim = nullptr;
+    for (PgnSlot& slot : pgns_) {
+        if (slot.used && slot.pgn == pgn) {
+            return &slot;
+        }
+        if (!victim || !slot.used || (victim->used && slot.last_sent_ms < victim->last_sent_ms)) {
+            victim = &slot;
+        }
+    }
+    if (!create) {
+        return nullptr;
+    }
+    victim->used = true;
+    victim->pgn = pgn;
+    return victim;
+}
+
+std::uint32_t CanButtonCoalescer::dueAt(std::uint32_t pgn, std::uint32_t now_ms) {
+    PgnSlot* slot = pgnSlot(pgn, false);
+    if (slot && slot->in_flight) {
+        if (age(now_ms, slot->last_sent_ms) < kMaxInFlightMs) {
+            return slot->last_sent_ms + kMaxInFlightMs;  // transmitted() wakes the protocol task sooner
+        }
+        slot->in_flight = false;
+    }
+    if (!slot || age(now_ms, slot->last_sent_ms) >= config_.min_spacing_ms) {
+        return now_ms;
+    }
+    return slot->last_sent_ms + config_.min_spacing_ms;
+}
+
+void CanButtonCoalescer::markSent(Button& entry, CanTxRequest& request, std::uint32_t now_ms) {
+    entry.has_last = true;
+    entry.last_identifier = request.identifier & ~0xFFu;
+    entry.last_length = request.length;
+    std::memcpy(entry.last_data, request.data, sizeof(entry.last_data));
+    entry.last_sent_ms = now_ms;
+    PgnSlot* slot = pgnSlot(j1939PgnFromIdentifier(request.identifier), true);
+    slot->in_flight = config_.min_spacing_ms > 0;
+    slot->last_sent_ms = now_ms;
+    request.spaced = slot->in_flight;
+}
+
+void CanButtonCoalescer::release(std::uint32_t identifier, std::uint32_t now_ms) {
+    PgnSlot* slot = pgnSlot(j1939PgnFromIdentifier(identifier), false);
+    if (slot && slot->in_flight) {
+        slot->in_flight = false;
+        slot->last_sent_ms = now_ms;
+    }
+}
+
+bool CanButtonCoalescer::sameCommand(const Button& entry, const CanTxRequest& request) {
+    return entry.last_identifier == (request.identifier & ~0xFFu) && entry.last_length == request.length &&
+           std::memcmp(entry.last_data, request.data, request.length) == 0;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "can_tx_queue.h"
+#include "config_types.h"
+
+struct CanCoalesceStats {
+    std::uint32_t events = 0;      // Button actions submitted
+    std::uint32_t sent = 0;        // Frames released to the TX queue (immediately or after a hold)
+    std::uint32_t duplicates = 0;  // Dropped: same command as the one this button last put on the bus
+    std::uint32_t deferred = 0;    // Held for PGN spacing
+    std::uint32_t superseded = 0;  // Held frames replaced by a newer command from the same button
+};
+
+/**
+ * Debounce and coalescing in front of the TX queue for button actions.
+ *
+ * Each button (keyed by its id) remembers the last command it put on the
+ * bus. A repeat of that command inside the duplicate window is dropped.
+ * Spacing is measured on the wire: a released frame is marked `spaced` and
+ * its PGN stays busy until CanManager reports it through transmitted() from
+ * the TX-complete path, and the next button frame on that PGN is held until
+ * min_spacing_ms after that. While held, a newer command from the same
+ * button replaces the held one, so only the latest state goes out. Held
+ * frames are released by poll(), which the protocol task runs, so the final
+ * state always reaches the bus even when the touch stream stops.
+ *
+ * A tap shorter than the spacing can therefore collapse to its release;
+ * that is the intended debounce. Sequences are not coalesced here (they
+ * have their own overlap policy).
+ */
+class CanButtonCoalescer {
+public:
+    enum class Decision : std::uint8_t { SEND, DROP, DEFER };
+
+    static constexpr std::size_t kMaxButtons = 32;   // Least recently used idle entries are recycled
+    static constexpr std::size_t kMaxPgns = 16;
+    static constexpr std::uint32_t kIdle = UINT32_MAX;
+    // A released frame the TX path never reports back (queue cleared underneath it) frees its PGN after this
+    static constexpr std::uint32_t kMaxInFlightMs = 1000;
+
+    // Returns true when the frame was accepted for transmission
+    using Sink = bool (*)(const CanTxRequest& request);
+
+    void configure(const CanCoalesceConfig& config);
+    void setSink(Sink sink) { sink_ = sink; }
+
+    // SEND: the caller enqueues the request now (and calls forget() if that fails); it may come back with
+    // `spaced` set. DROP: already on the bus. DEFER: held and released by poll().
+    // The trace id of a dropped or replaced request is returned in abandoned_trace (0 = none).
+    Decision submit(const std::string& button, CanTxRequest& request, std::uint32_t now_ms,
+                    std::uint16_t& abandoned_trace);
+    // The SEND request could not be queued; the button's next command is not treated as a duplicate
+    void forget(const std::string& button, const CanTxRequest& request, std::uint32_t now_ms);
+    // A `spaced` request left the controller (or failed for good); spacing on its PGN counts from now_ms
+    void transmitted(std::uint32_t identifier, std::uint32_t now_ms);
+    // Releases held frames whose spacing has passed; returns ms until the next one, kIdle when none is held
+    std::uint32_t poll(std::uint32_t now_ms);
+    void clear();
+
+    CanCoalesceStats stats() const;
+    void resetStats();
+
+    static std::uint32_t keyFor(const std::string& button);
+
+private:
+    struct Button {
+        std::uint32_t key = 0;       // 0 = free
+        bool has_last = false;
+        std::uint32_t last_identifier = 0;  // Source address masked off (the TX path stamps its own)
+        std::uint8_t last_length = 0;
+        std::uint8_t last_data[8] = {};
+        std::uint32_t last_sent_ms = 0;
+        std::uint32_t used_ms = 0;
+        bool held = false;
+        CanTxRequest pending{};
+    };
+
+    struct PgnSlot {
+        std::uint32_t pgn = 0;
+        bool used = false;
+        bool in_flight = false;          // Released, not yet reported by transmitted()
+        std::uint32_t last_sent_ms = 0;  // Release time while in flight, then when it left the controller
+    };
+
+    Button* lookup(std::uint32_t key, std::uint32_t now_ms);
+    PgnSlot* pgnSlot(std::uint32_t pgn, bool create);
+    // Due time for a frame on `pgn`, or now when it may go out immediately
+    std::uint32_t dueAt(std::uint32_t pgn, std::uint32_t now_ms);
+    void markSent(Button& button, CanTxRequest& request, std::uint32_t now_ms);
+    void release(std::uint32_t identifier, std::uint32_t now_ms);
+    static bool sameCommand(const Button& button, const CanTxRequest& request);
+
+    mutable std::mutex mutex_;
+    CanCoalesceConfig config_{};
+    std::array<Button, kMaxButtons> buttons_{};
+    std::array<PgnSlot, kMaxPgns> pgns_{};
+    CanCoalesceStats stats_{};
+    Sink sink_ = nullptr;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+
+#include "can_bus_stats.h"
+#include "can_filter_planner.h"
+
+struct CanFrame {
+    std::uint32_t identifier = 0;
+    bool extended = true;
+    std::uint8_t length = 0;
+    std::uint8_t data[8] = {};
+    std::uint64_t timestamp_us = 0;  // Set by receive(): when the controller handed the frame over (canMicros)
+};
+
+// Controller states; the values match twai_state_t so BUS_STATE trace records read the same on every backend
+enum class CanDriverState : std::uint8_t { STOPPED = 0, RUNNING = 1, BUS_OFF = 2, RECOVERING = 3 };
+
+struct CanDriverStatus {
+    CanDriverState state = CanDriverState::STOPPED;
+    std::uint32_t tx_error_counter = 0;
+    std::uint32_t rx_error_counter = 0;
+    std::uint32_t rx_missed = 0;  // Frames lost because the driver RX queue was full
+    std::uint32_t tx_pending = 0;  // Frames queued in the driver or on the wire, not yet completed
+};
+
+struct CanDriverConfig {
+    int tx_pin = -1;
+    int rx_pin = -1;
+    std::uint32_t bitrate = 250000;  // One of kCanBitrates; install() fails otherwise
+    bool listen_only = false;        // Never ACKs, transmits or sends error frames (auto-baud probing)
+    CanFilterPlan filter{};  // ACCEPT_ALL unless filtering is enabled
+    std::uint32_t tx_queue_len = 8;
+    std::uint32_t rx_queue_len = 16;
+};
+
+// readAlerts() reports one bit per CanBusAlert
+constexpr std::uint32_t canAlertBit(CanBusAlert alert) {
+    return 1u << static_cast<std::uint32_t>(alert);
+}
+
+// Plus this one per completed transmission; it timestamps TX completion rather than counting as bus health
+constexpr std::uint32_t kCanAlertTxSuccess = 1u << 31;
+static_assert(static_cast<std::uint32_t>(CanBusAlert::COUNT) < 31, "CanBusAlert bits overlap kCanAlertTxSuccess");
+
+// Result codes share esp_err_t values so TX_FAIL trace records read the same on every backend
+constexpr int kCanDriverOk = 0;
+constexpr int kCanDriverFail = -1;
+constexpr int kCanDriverInvalidState = 0x103;
+constexpr int kCanDriverNotSupported = 0x106;  // transmit() in listen-only mode
+constexpr int kCanDriverTimeout = 0x107;
+
+/**
+ * The controller under CanManager: TWAI on the device, a VirtualCanBus node
+ * on host builds. Calls mirror the TWAI driver (install/start, a bounded TX
+ * queue, blocking receive and alert reads) so CanManager keeps one code path.
+ * transmit() returns once the frame is queued in the controller; failures on
+ * the wire are reported through the TX_FAILED alert.
+ */
+class CanDriver {
+public:
+    virtual ~CanDriver() = default;
+
+    virtual const char* name() const = 0;
+    virtual bool install(const CanDriverConfig& config) = 0;
+    virtual void uninstall() = 0;
+    virtual bool start() = 0;
+    virtual void stop() = 0;
+    virtual int transmit(const CanFrame& frame, std::uint32_t timeout_ms) = 0;
+    virtual bool receive(CanFrame& frame, std::uint32_t timeout_ms) = 0;
+    virtual bool readAlerts(std::uint32_t& alerts, std::uint32_t timeout_ms) = 0;
+    virtual bool getStatus(CanDriverStatus& status) const = 0;
+    virtual bool initiateRecovery() = 0;
+};
@@ -0,0 +1,198 @@
+#include "can_driver_twai.h"
+
+#ifdef ARDUINO
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <driver/twai.h>
+
+#include <algorithm>
+
+#include "can_platform.h"
+
+// CH422G I2C configuration for CAN transceiver power
+// NOTE: CH422G uses REGISTER addresses as I2C device addresses (unique protocol)
+#define CH422G_REG_WR_IO    0x38  // Output control register I2C address
+#define CH422G_USB_SEL_HIGH 0x2A  // USB_SEL (bit 5) = HIGH, enables CAN transceiver
+
+namespace {
+constexpr struct {
+    uint32_t mask;
+    CanBusAlert alert;
+} kAlertMap[] = {
+    {TWAI_ALERT_BUS_ERROR, CanBusAlert::BUS_ERROR},
+    {TWAI_ALERT_ABOVE_ERR_WARN, CanBusAlert::ERROR_WARNING},
+    {TWAI_ALERT_ERR_PASS, CanBusAlert::ERROR_PASSIVE},
+    {TWAI_ALERT_ERR_ACTIVE, CanBusAlert::ERROR_ACTIVE},
+    {TWAI_ALERT_BUS_OFF, CanBusAlert::BUS_OFF},
+    {TWAI_ALERT_BUS_RECOVERED, CanBusAlert::BUS_RECOVERED},
+    {TWAI_ALERT_ARB_LOST, CanBusAlert::ARBITRATION_LOST},
+    {TWAI_ALERT_TX_FAILED, CanBusAlert::TX_FAILED},
+    {TWAI_ALERT_RX_QUEUE_FULL, CanBusAlert::RX_QUEUE_FULL},
+};
+
+bool timingFor(uint32_t bitrate, twai_timing_config_t& timing) {
+    switch (bitrate) {
+        case 125000: {
+            const twai_timing_config_t preset = TWAI_TIMING_CONFIG_125KBITS();
+            timing = preset;
+            return true;
+        }
+        case 250000: {
+            const twai_timing_config_t preset = TWAI_TIMING_CONFIG_250KBITS();
+            timing = preset;
+            return true;
+        }
+        case 500000: {
+            const twai_timing_config_t preset = TWAI_TIMING_CONFIG_500KBITS();
+            timing = preset;
+            return true;
+        }
+        case 1000000: {
+            const twai_timing_config_t preset = TWAI_TIMING_CONFIG_1MBITS();
+            timing = preset;
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+}
+
+TwaiCanDriver& TwaiCanDriver::instance() {
+    static TwaiCanDriver driver;
+    return driver;
+}
+
+bool TwaiCanDriver::enableTransceiver() {
+    // CRITICAL: Enable CAN transceiver via CH422G I2C expander BEFORE starting TWAI
+    // The SN65HVD230 CAN transceiver power is controlled by USB_SEL pin on CH422G
+    // Without this, GPIO19 RX will not receive any CAN messages
+    // NOTE: CH422G has unique I2C protocol - register address IS the I2C device address
+    // I2C is already initialized by panel library - just write directly
+    Serial.println("[CanManager] Enabling CAN transceiver via CH422G...");
+
+    // Write to CH422G register 0x38 (WR_IO) to set USB_SEL HIGH
+    // beginTransmission takes the REGISTER address, not a device address!
+    Wire.beginTransmission(CH422G_REG_WR_IO);  // 0x38, not 0x24!
+    Wire.write(CH422G_USB_SEL_HIGH);            // 0x2A
+    int i2c_result = Wire.endTransmission();
+
+    if (i2c_result == 0) {
+        Serial.println("[CanManager] ✓ CAN transceiver enabled (USB_SEL=HIGH)");
+    } else {
+        Serial.printf("[CanManager] ⚠ CH422G I2C write failed (err=%d) - CAN may not work\n", i2c_result);
+    }
+
+    delay(50); // Give transceiver time to power up
+    return i2c_result == 0;
+}
+
+bool TwaiCanDriver::install(const CanDriverConfig& config) {
+    twai_timing_config_t t_config;
+    if (!timingFor(config.bitrate, t_config)) {
+        Serial.printf("[CanManager] Unsupported bitrate %lu bps\n", static_cast<unsigned long>(config.bitrate));
+        return false;
+    }
+
+    if (!transceiver_enabled_) {
+        transceiver_enabled_ = enableTransceiver();
+    }
+
+    twai_general_config_t g_config = TWAI_GENERAL_CONFIG_DEFAULT(static_cast<gpio_num_t>(config.tx_pin),
+                                                                 static_cast<gpio_num_t>(config.rx_pin),
+                                                                 config.listen_only ? TWAI_MODE_LISTEN_ONLY
+                                                                                    : TWAI_MODE_NORMAL);
+    g_config.tx_queue_len = config.tx_queue_len;
+    g_config.rx_queue_len = config.rx_queue_len;
+    g_config.alerts_enabled = 0;
+    for (const auto& entry : kAlertMap) {
+        g_config.alerts_enabled |= entry.mask;
+    }
+    g_config.alerts_enabled |= TWAI_ALERT_TX_SUCCESS;
+
+    twai_filter_config_t f_config = TWAI_FILTER_CONFIG_ACCEPT_ALL();
+    if (config.filter.mode != CanFilterPlan::Mode::ACCEPT_ALL) {
+        f_config.acceptance_code = config.filter.acceptance_code;
+        f_config.acceptance_mask = config.filter.acceptance_mask;
+        f_config.single_filter = config.filter.mode == CanFilterPlan::Mode::SINGLE;
+    }
+
+    if (twai_driver_install(&g_config, &t_config, &f_config) != ESP_OK) {
+        Serial.println("[CanManager] Failed to install TWAI driver");
+        return false;
+    }
+    installed_ = true;
+    return true;
+}
+
+void TwaiCanDriver::uninstall() {
+    if (installed_) {
+        twai_driver_uninstall();
+        installed_ = false;
+    }
+}
+
+bool TwaiCanDriver::start() {
+    return twai_start() == ESP_OK;
+}
+
+void TwaiCanDriver::stop() {
+    twai_stop();
+}
+
+int TwaiCanDriver::transmit(const CanFrame& frame, std::uint32_t timeout_ms) {
+    twai_message_t message = {};
+    message.identifier = frame.identifier;
+    message.extd = frame.extended ? 1 : 0;
+    message.data_length_code = frame.length;
+    memcpy(message.data, frame.data, frame.length);
+    return twai_transmit(&message, pdMS_TO_TICKS(timeout_ms));
+}
+
+bool TwaiCanDriver::receive(CanFrame& frame, std::uint32_t timeout_ms) {
+    twai_message_t message;
+    if (twai_receive(&message, pdMS_TO_TICKS(timeout_ms)) != ESP_OK) {
+        return false;
+    }
+    // The RX task is the highest-priority CAN task, so this is within a few us of the driver's ISR
+    frame.timestamp_us = canMicros();
+    frame.identifier = message.identifier;
+    frame.extended = message.extd;
+    frame.length = std::min<uint8_t>(message.data_length_code, 8);
+    memcpy(frame.data, message.data, sizeof(frame.data));
+    return true;
+}
+
+bool TwaiCanDriver::readAlerts(std::uint32_t& alerts, std::uint32_t timeout_ms) {
+    uint32_t raw = 0;
+    if (twai_read_alerts(&raw, pdMS_TO_TICKS(timeout_ms)) != ESP_OK) {
+        return false;
+    }
+    alerts = (raw & TWAI_ALERT_TX_SUCCESS) ? kCanAlertTxSuccess : 0;
+    for (const auto& entry : kAlertMap) {
+        if (raw & entry.mask) {
+            alerts |= canAlertBit(entry.alert);
+        }
+    }
+    return true;
+}
+
+bool TwaiCanDriver::getStatus(CanDriverStatus& status) const {
+    twai_status_info_t info;
+    if (!installed_ || twai_get_status_info(&info) != ESP_OK) {
+        return false;
+    }
+    status.state = static_cast<CanDriverState>(info.state);
+    status.tx_error_counter = info.tx_error_counter;
+    status.rx_error_counter = info.rx_error_counter;
+    status.rx_missed = info.rx_missed_count;
+    status.tx_pending = info.msgs_to_tx;
+    return true;
+}
+
+bool TwaiCanDriver::initiateRecovery() {
+    return twai_initiate_recovery() == ESP_OK;
+}
+
+#endif
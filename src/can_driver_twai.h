@@ -0,0 +1,32 @@
+#pragma once
+
+#ifdef ARDUINO
+
+#include "can_driver.h"
+
+// ESP32-S3 TWAI controller behind the SN65HVD230 transceiver on the Waveshare board
+class TwaiCanDriver : public CanDriver {
+public:
+    static TwaiCanDriver& instance();
+
+    const char* name() const override { return "twai"; }
+    bool install(const CanDriverConfig& config) override;
+    void uninstall() override;
+    bool start() override;
+    void stop() override;
+    int transmit(const CanFrame& frame, std::uint32_t timeout_ms) override;
+    bool receive(CanFrame& frame, std::uint32_t timeout_ms) override;
+    bool readAlerts(std::uint32_t& alerts, std::uint32_t timeout_ms) override;
+    bool getStatus(CanDriverStatus& status) const override;
+    bool initiateRecovery() override;
+
+private:
+    TwaiCanDriver() = default;
+
+    bool enableTransceiver();
+
+    bool installed_ = false;
+    bool transceiver_enabled_ = false;  // Auto-baud reinstalls once per candidate rate
+};
+
+#endif
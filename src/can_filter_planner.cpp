@@ -0,0 +1,197 @@
+#include "can_filter_planner.h"
+
+#include <algorithm>
+
+#include "can_types.h"
+
+namespace {
+constexpr std::uint32_t kIdBits = 0x1FFFFFFF;
+constexpr unsigned kDualShift = 13;  // Dual filters only see ID bits 28..13
+constexpr std::uint32_t kAnySource = 0xFF;
+
+unsigned popcount(std::uint32_t value) {
+    unsigned count = 0;
+    while (value) {
+        value &= value - 1;
+        ++count;
+    }
+    return count;
+}
+
+float coverage(unsigned compared_bits) {
+    return 1.0f / static_cast<float>(1ull << compared_bits);
+}
+}
+
+void CanFilterPlanner::clear() {
+    rule_count_ = 0;
+    slots_.fill(kEmpty);
+}
+
+bool CanFilterPlanner::addRule(const CanFilterRule& rule) {
+    CanFilterRule normalized = rule;
+    normalized.pgn = pgnFromIdentifier(rule.pgn << 8);  // Strips the DA byte of PDU1 PGNs
+    const std::uint32_t rule_key = key(normalized.pgn, normalized.source_address);
+    if (contains(rule_key)) {
+        return true;
+    }
+    if (rule_count_ >= kMaxRules) {
+        return false;
+    }
+    rules_[rule_count_++] = normalized;
+    insert(rule_key);
+    return true;
+}
+
+bool CanFilterPlanner::addPgnRange(std::uint32_t first_pgn, std::uint32_t last_pgn) {
+    for (std::uint32_t pgn = first_pgn; pgn <= last_pgn; ++pgn) {
+        if (!addRule(CanFilterRule{pgn, kAnySource})) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::uint32_t CanFilterPlanner::pgnFromIdentifier(std::uint32_t identifier) {
+    return j1939PgnFromIdentifier(identifier);
+}
+
+std::uint32_t CanFilterPlanner::key(std::uint32_t pgn, std::uint8_t source_address) {
+    return (pgn << 8) | source_address;
+}
+
+bool CanFilterPlanner::contains(std::uint32_t value) const {
+    std::size_t index = (value * 2654435761u) >> 24;
+    for (std::size_t probe = 0; probe < kHashSlots; ++probe) {
+        const std::uint32_t slot = slots_[(index + probe) & (kHashSlots - 1)];
+        if (slot == value) {
+            return true;
+        }
+        if (slot == kEmpty) {
+            return false;
+        }
+    }
+    return false;
+}
+
+void CanFilterPlanner::insert(std::uint32_t value) {
+    std::size_t index = (value * 2654435761u) >> 24;
+    while (slots_[index & (kHashSlots - 1)] != kEmpty) {
+        ++index;
+    }
+    slots_[index & (kHashSlots - 1)] = value;
+}
+
+bool CanFilterPlanner::wants(std::uint32_t identifier) const {
+    const std::uint32_t pgn = pgnFromIdentifier(identifier);
+    return contains(key(pgn, kAnySource)) || contains(key(pgn, identifier & 0xFF));
+}
+
+CanFilterPlanner::Match CanFilterPlanner::matchFor(const CanFilterRule& rule) {
+    Match match;
+    const bool pdu1 = ((rule.pgn >> 8) & 0xFF) < 240;
+    // Priority and reserved bits are never compared; PDU1 frames may be addressed to anyone
+    match.care = pdu1 ? (0x3FFu << 16) : (0x3FFFFu << 8);
+    match.value = (rule.pgn << 8) & match.care;
+    if (rule.source_address != kAnySource) {
+        match.care |= 0xFF;
+        match.value |= rule.source_address;
+    }
+    return match;
+}
+
+CanFilterPlanner::Match CanFilterPlanner::merge(const Match* matches, std::size_t count) {
+    Match merged = matches[0];
+    for (std::size_t i = 1; i < count; ++i) {
+        merged.care &= matches[i].care & ~(matches[i].value ^ merged.value);
+        merged.value &= merged.care;
+    }
+    return merged;
+}
+
+CanFilterPlan CanFilterPlanner::plan(const std::vector<std::uint32_t>* sample) const {
+    CanFilterPlan best;
+    if (rule_count_ == 0) {
+        return best;  // Nothing configured: accept everything
+    }
+
+    std::vector<Match> matches;
+    matches.reserve(rule_count_);
+    for (std::size_t i = 0; i < rule_count_; ++i) {
+        matches.push_back(matchFor(rules_[i]));
+    }
+    std::sort(matches.begin(), matches.end(), [](const Match& a, const Match& b) { return a.value < b.value; });
+
+    auto cost = [&](const CanFilterPlan& candidate) -> float {
+        if (sample && !sample->empty()) {
+            std::size_t accepted = 0;
+            for (std::uint32_t id : *sample) {
+                accepted += hardwareAccepts(candidate, id) ? 1 : 0;
+            }
+            return static_cast<float>(accepted);
+        }
+        return candidate.id_space_fraction;
+    };
+
+    // Single filter: one code/mask over all 29 bits
+    const Match all = merge(matches.data(), matches.size());
+    best.mode = CanFilterPlan::Mode::SINGLE;
+    best.acceptance_code = all.value << 3;
+    best.acceptance_mask = ~(all.care << 3);
+    best.id_space_fraction = coverage(popcount(all.care));
+    float best_cost = cost(best);
+
+    // Dual filter: split the sorted rules into two contiguous groups; rules that share a PF end up together
+    for (std::size_t split = 1; split < matches.size(); ++split) {
+        const Match first = merge(matches.data(), split);
+        const Match second = merge(matches.data() + split, matches.size() - split);
+        const std::uint32_t first_care = (first.care >> kDualShift) & 0xFFFF;
+        const std::uint32_t second_care = (second.care >> kDualShift) & 0xFFFF;
+
+        CanFilterPlan candidate;
+        candidate.mode = CanFilterPlan::Mode::DUAL;
+        candidate.acceptance_code = (((first.value >> kDualShift) & 0xFFFF) << 16) |
+                                    ((second.value >> kDualShift) & 0xFFFF);
+        candidate.acceptance_mask = ((~first_care & 0xFFFF) << 16) | (~second_care & 0xFFFF);
+        candidate.id_space_fraction =
+            std::min(1.0f, coverage(popcount(first_care)) + coverage(popcount(second_care)));
+
+        const float candidate_cost = cost(candidate);
+        if (candidate_cost < best_cost) {
+            best = candidate;
+            best_cost = candidate_cost;
+        }
+    }
+    return best;
+}
+
+bool CanFilterPlanner::hardwareAccepts(const CanFilterPlan& plan, std::uint32_t identifier) {
+    identifier &= kIdBits;
+    switch (plan.mode) {
+        case CanFilterPlan::Mode::ACCEPT_ALL:
+            return true;
+        case CanFilterPlan::Mode::SINGLE:
+            return (((identifier << 3) ^ plan.acceptance_code) & ~plan.acceptance_mask) == 0;
+        case CanFilterPlan::Mode::DUAL: {
+            const std::uint32_t high = identifier >> kDualShift;
+            const bool first = ((high ^ (plan.acceptance_code >> 16)) & ~(plan.acceptance_mask >> 16) & 0xFFFF) == 0;
+            const bool second = ((high ^ plan.acceptance_code) & ~plan.acceptance_mask & 0xFFFF) == 0;
+            return first || second;
+        }
+    }
+    return true;
+}
+
+CanFilterReport CanFilterPlanner::evaluate(const CanFilterPlan& plan,
+                                           const std::vector<std::uint32_t>& identifiers) const {
+    CanFilterReport report;
+    for (std::uint32_t id : identifiers) {
+        const bool accepted = hardwareAccepts(plan, id);
+        const bool wanted = wants(id);
+        ++report.frames;
+        report.hw_accepted += accepted ? 1 : 0;
+        report.wanted += wanted ? 1 : 0;
+        report.missed += (wanted && !accepted) ? 1 : 0;
+    }
+    return report;
+}
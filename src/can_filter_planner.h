@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A J1939 PGN the panel wants to receive, optionally from one source only
+struct CanFilterRule {
+    std::uint32_t pgn = 0;
+    std::uint8_t source_address = 0xFF;  // 0xFF = any source (never a valid sender address)
+};
+
+// Acceptance code/mask in TWAI register layout (mask bit 1 = don't care)
+struct CanFilterPlan {
+    enum class Mode : std::uint8_t { ACCEPT_ALL, SINGLE, DUAL };
+
+    Mode mode = Mode::ACCEPT_ALL;
+    std::uint32_t acceptance_code = 0;
+    std::uint32_t acceptance_mask = 0xFFFFFFFF;
+    float id_space_fraction = 1.0f;  // Share of all 29-bit IDs the hardware lets through
+};
+
+struct CanFilterReport {
+    std::uint32_t frames = 0;        // Frames in the sample
+    std::uint32_t hw_accepted = 0;   // Frames the hardware filter would pass to the CPU
+    std::uint32_t wanted = 0;        // Frames matching a rule
+    std::uint32_t missed = 0;        // Wanted frames the hardware filter would drop (must be 0)
+
+    float passRate() const { return frames ? static_cast<float>(hw_accepted) / frames : 0.0f; }
+};
+
+/**
+ * Plans TWAI acceptance filters for a set of wanted PGNs.
+ *
+ * The hardware offers either one 29-bit code/mask or two filters that only
+ * see ID bits 28..13, so it can rarely express the exact set. The planner
+ * picks whichever layout lets the fewest unwanted frames through (measured
+ * against a traffic sample when one is given, otherwise by ID-space
+ * coverage) and keeps an exact software set for the remainder.
+ *
+ * Plain C++ so it can be exercised off-device with recorded traffic.
+ */
+class CanFilterPlanner {
+public:
+    static constexpr std::size_t kMaxRules = 64;
+
+    void clear();
+    bool addRule(const CanFilterRule& rule);
+    bool addPgnRange(std::uint32_t first_pgn, std::uint32_t last_pgn);
+    std::size_t ruleCount() const { return rule_count_; }
+
+    CanFilterPlan plan(const std::vector<std::uint32_t>* sample = nullptr) const;
+
+    // Exact software check used behind the hardware filter
+    bool wants(std::uint32_t identifier) const;
+
+    static bool hardwareAccepts(const CanFilterPlan& plan, std::uint32_t identifier);
+    CanFilterReport evaluate(const CanFilterPlan& plan, const std::vector<std::uint32_t>& identifiers) const;
+
+    static std::uint32_t pgnFromIdentifier(std::uint32_t identifier);
+
+private:
+    struct Match {
+        std::uint32_t value = 0;  // 29-bit identifier bits that must match
+        std::uint32_t care = 0;   // 1 = bit is compared
+    };
+
+    static constexpr std::size_t kHashSlots = 256;  // Power of two, at least twice kMaxRules
+    static constexpr std::uint32_t kEmpty = 0xFFFFFFFF;
+
+    static Match matchFor(const CanFilterRule& rule);
+    static Match merge(const Match* matches, std::size_t count);
+    static std::uint32_t key(std::uint32_t pgn, std::uint8_t source_address);
+    bool contains(std::uint32_t key) const;
+    void insert(std::uint32_t key);
+
+    std::array<CanFilterRule, kMaxRules> rules_{};
+    std::size_t rule_count_ = 0;
+    std::array<std::uint32_t, kHashSlots> slots_ = makeEmptySlots();
+
+    static std::array<std::uint32_t, kHashSlots> makeEmptySlots() {
+        std::array<std::uint32_t, kHashSlots> slots{};
+        slots.fill(kEmpty);
+        return slots;
+    }
+};
@@ -0,0 +1,2128 @@
+// Host bench for the CAN stack: CanManager on a VirtualCanBus node with one peer controller, measuring TX/RX
+// throughput (and that per-PGN stats count every frame from both RX producers), enqueueTx latency per
+// priority on a saturated bus, request/response and press-to-wire latency without hardware, plus auto-baud
+// detection against a bus running at another rate and button-press coalescing under synthetic touch streams
+// and acceptance filtering (the filter planner against random rule sets and traffic, then filtering switched
+// on in CanManager). Checks that need exact timing run first, on a virtual clock (canSetClock) before
+// CanManager starts its tasks: CAN sequence step gaps (the sequence worker then runs a ramp on the real
+// bus), 64 periodic frames on a simulated wire, J1939 transport sessions (BAM and RTS/CTS with packets lost,
+// reordered or never sent) between two transports on a virtual bus, and J1939 address claim between several
+// nodes on one. The signal decoder is timed over 100k random frames and checked against a bit-by-bit
+// reference, and flight recorder segments are built in memory and read back through CanLogReader (across an
+// esp_timer wrap, with a torn tail and a bad CRC) and rendered as candump and ASC lines; the replay engine
+// then plays recordings at 1x, 10x and 50x on simulated time, checked frame by frame against the recorded
+// gaps, and the traffic generator against the bus load it was asked for. Last, the TX path runs on a sink
+// controller to time what trace records cost per frame at this build's CAN_TRACE_LEVEL. Built by the
+// PlatformIO `native` environment (pio run -e native, then .pio/build/native/program); the device firmware
+// never sees this file.
+
+#ifndef ARDUINO
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "can_autobaud.h"
+#include "can_filter_planner.h"
+#include "can_log_format.h"
+#include "can_manager.h"
+#include "can_periodic.h"
+#include "can_replay.h"
+#include "can_sequence.h"
+#include "can_signal_db.h"
+#include "can_virtual_bus.h"
+#include "j1939_address_claim.h"
+#include "j1939_transport.h"
+
+namespace {
+constexpr std::uint32_t kBitrate = 250000;
+constexpr std::uint32_t kTxFrames = 2000;
+constexpr std::uint32_t kRxFrames = 2000;
+constexpr std::uint32_t kRoundTrips = 200;
+constexpr std::uint32_t kPresses = 100;
+constexpr std::uint32_t kAlertSettleMs = 50;
+constexpr std::uint32_t kForeignBitrate = 500000;  // Auto-baud bench: a bus the panel is not configured for
+constexpr std::uint32_t kForeignPeriodMs = 10;
+constexpr std::uint32_t kTouchSettleMs = 150;  // Longer than any hold; every final state is on the wire
+constexpr std::uint32_t kEnqueueSamples = 500;      // Per priority level; ~2 s of wire at kBitrate
+constexpr double kEnqueueP99BoundUs = 100.0;        // One 8-byte frame at 250 kbit/s is ~540 us on the wire
+constexpr double kEnqueueMaxBoundUs = 5000.0;       // Host preemption headroom; the old sendFrame blocked 50-150 ms
+constexpr std::uint32_t kTxCostFrames = 200000;     // Per run; the best of kTxCostRuns counts
+constexpr std::uint32_t kTxCostRuns = 5;
+constexpr double kTraceCostBoundNs = 2000.0;        // Per frame over the level-0 build: <2% of a frame at 1 Mbit/s
+constexpr std::uint32_t kPeerRequestId = 0x18EF8021;  // Proprietary A, peer 0x21 -> panel 0x80
+constexpr std::uint32_t kPanelReplyId = 0x18EF2180;
+
+// Virtual time for the checks that run before CanManager starts
+std::atomic<std::uint64_t> g_virtual_us{0};
+
+std::uint64_t virtualMicros() {
+    return g_virtual_us.load();
+}
+
+void setVirtualMs(std::uint32_t ms) {
+    g_virtual_us.store(static_cast<std::uint64_t>(ms) * 1000);
+}
+
+double elapsedMs(std::uint64_t start_us) {
+    return static_cast<double>(canMicros() - start_us) / 1000.0;
+}
+
+void printBusLoad(const VirtualCanBus& bus, const VirtualCanBus::Stats& before, double elapsed_ms) {
+    const VirtualCanBus::Stats after = bus.stats();
+    std::printf("    wire: %u frames, %u error frames, %.1f%% busy\n", after.frames - before.frames,
+                after.error_frames - before.error_frames,
+                100.0 * static_cast<double>(after.busy_us - before.busy_us) / (elapsed_ms * 1000.0));
+}
+
+// Panel -> peer: frames queued through the TX scheduler until the peer has seen them all
+bool benchTx(CanManager& can, VirtualCanBus& bus, VirtualCanBus::Node& peer) {
+    std::printf("TX throughput (%u frames)\n", kTxFrames);
+    const VirtualCanBus::Stats before = bus.stats();
+    const std::uint64_t start = canMicros();
+
+    std::atomic<std::uint32_t> received{0};
+    std::thread reader([&]() {
+        CanFrame frame;
+        while (received.load() < kTxFrames && peer.receive(frame, 1000)) {
+            received.fetch_add(1);
+        }
+    });
+
+    std::uint32_t queued = 0;
+    while (queued < kTxFrames) {
+        CanTxRequest request;
+        request.identifier = 0x18FF5080;
+        request.length = 8;
+        std::memcpy(request.data, &queued, sizeof(queued));
+        if (can.enqueueTx(request)) {
+            ++queued;
+        } else {
+            canDelayMs(1);  // Queue full; the scheduler drains at wire speed
+        }
+    }
+    reader.join();
+
+    const double ms = elapsedMs(start);
+    std::printf("    %u/%u delivered in %.1f ms (%.0f frames/s)\n", received.load(), kTxFrames, ms,
+                received.load() * 1000.0 / ms);
+    printBusLoad(bus, before, ms);
+    return received.load() == kTxFrames;
+}
+
+// enqueueTx() call time per priority with the queue kept nearly full and the wire 100% busy: each round
+// queues one frame per priority, then waits only until the scheduler has made room for the next round. The
+// call must never wait for the bus. Priorities 0-6 are J1939 frames, 7 a standard 11-bit frame
+bool benchEnqueueLatency(CanManager& can, VirtualCanBus& bus, VirtualCanBus::Node& peer) {
+    using Clock = std::chrono::steady_clock;
+    constexpr std::size_t kLevels = CanTxQueue::kPriorityLevels;
+    std::printf("Enqueue latency, saturated bus (%u calls per priority)\n", kEnqueueSamples);
+    const VirtualCanBus::Stats before = bus.stats();
+    const std::uint64_t start = canMicros();
+
+    std::atomic<bool> running{true};
+    std::thread reader([&]() {
+        CanFrame frame;
+        while (running.load()) {
+            peer.receive(frame, 10);
+        }
+    });
+
+    std::vector<std::vector<double>> samples(kLevels);
+    std::vector<std::uint32_t> accepted(kLevels, 0);
+    for (std::uint32_t i = 0; i < kEnqueueSamples; ++i) {
+        while (can.txStats().queue_depth > CanTxQueue::kCapacity - kLevels) {
+            canDelayMs(1);  // 25+ frames (~13 ms of wire) still queued; the bus never idles
+        }
+        for (std::uint8_t priority = 0; priority < kLevels; ++priority) {
+            CanTxRequest request;
+            if (priority == CanTxRequest::kStandardFramePriority) {
+                request.extended = false;
+                request.identifier = 0x321;
+            } else {
+                request.identifier = (static_cast<std::uint32_t>(priority) << 26) | 0x00FF5380;
+            }
+            request.length = 8;
+            std::memcpy(request.data, &i, sizeof(i));
+            const Clock::time_point call = Clock::now();
+            accepted[priority] += can.enqueueTx(request);
+            samples[priority].push_back(std::chrono::duration<double, std::micro>(Clock::now() - call).count());
+        }
+    }
+    while (can.txStats().queue_depth > 0) {
+        canDelayMs(1);
+    }
+    const double ms = elapsedMs(start);
+    canDelayMs(kAlertSettleMs);
+    running.store(false);
+    reader.join();
+
+    bool ok = true;
+    for (std::size_t priority = 0; priority < kLevels; ++priority) {
+        std::vector<double>& calls = samples[priority];
+        std::sort(calls.begin(), calls.end());
+        const double p50 = calls[calls.size() / 2];
+        const double p99 = calls[calls.size() * 99 / 100];
+        const bool within = p99 <= kEnqueueP99BoundUs && calls.back() <= kEnqueueMaxBoundUs;
+        std::printf("    priority %zu: p50 %6.2f us  p99 %6.2f us  max %8.2f us  (%u/%u accepted)%s\n", priority, p50,
+                    p99, calls.back(), accepted[priority], kEnqueueSamples, within ? "" : "  OVER BOUND");
+        ok &= within && accepted[priority] == kEnqueueSamples;
+    }
+    std::printf("    bound: p99 <= %.0f us, max <= %.0f us\n", kEnqueueP99BoundUs, kEnqueueMaxBoundUs);
+    printBusLoad(bus, before, ms);
+    return ok;
+}
+
+// Peer -> panel: back-to-back frames drained by the RX task into the ring
+bool benchRx(CanManager& can, VirtualCanBus& bus, VirtualCanBus::Node& peer) {
+    std::printf("RX throughput (%u frames)\n", kRxFrames);
+    CanRxCursor cursor = can.openRxCursor();
+    const VirtualCanBus::Stats before = bus.stats();
+    const std::uint64_t start = canMicros();
+
+    std::thread writer([&]() {
+        CanFrame frame;
+        frame.identifier = 0x0CF00421;
+        frame.length = 8;
+        for (std::uint32_t i = 0; i < kRxFrames; ++i) {
+            std::memcpy(frame.data, &i, sizeof(i));
+            while (peer.transmit(frame, 100) != kCanDriverOk) {
+            }
+        }
+    });
+
+    std::uint32_t received = 0;
+    std::uint32_t out_of_order = 0;
+    CanRxMessage msg;
+    while (received < kRxFrames && can.readRx(cursor, msg, 1000)) {
+        if (msg.identifier != 0x0CF00421) {
+            continue;
+        }
+        std::uint32_t sequence = 0;
+        std::memcpy(&sequence, msg.data, sizeof(sequence));
+        out_of_order += sequence != received;
+        ++received;
+    }
+    writer.join();
+
+    const double ms = elapsedMs(start);
+    std::printf("    %u/%u received in %.1f ms (%.0f frames/s), %u out of order, %u missed by the driver\n",
+                received, kRxFrames, ms, received * 1000.0 / ms, out_of_order, can.rxStats().driver_missed);
+    printBusLoad(bus, before, ms);
+    return received == kRxFrames && out_of_order == 0;
+}
+
+// Peer frames through the RX task and injectRx() from another thread, on one PGN at once: the per-PGN
+// counters are bumped outside the RX lock, so both producers' frames must all be counted
+bool checkRxStatsProducers(CanManager& can, VirtualCanBus::Node& peer) {
+    const std::uint32_t pgn = j1939PgnFromIdentifier(0x0CF00421);
+    auto pgnRx = [&]() -> std::uint32_t {
+        for (const CanPgnStats& entry : can.busStats().pgns) {
+            if (entry.pgn == pgn) {
+                return entry.rx_frames;
+            }
+        }
+        return 0;
+    };
+    const std::uint32_t before = pgnRx();
+
+    std::thread writer([&]() {
+        CanFrame frame;
+        frame.identifier = 0x0CF00421;
+        frame.length = 8;
+        for (std::uint32_t i = 0; i < kRxFrames; ++i) {
+            while (peer.transmit(frame, 100) != kCanDriverOk) {
+            }
+        }
+    });
+    std::thread injector([&]() {
+        const std::uint8_t data[8] = {};
+        for (std::uint32_t i = 0; i < kRxFrames; ++i) {
+            can.injectRx(0x0CF00422, true, data, sizeof(data));  // Same PGN, another source address
+            std::this_thread::sleep_for(std::chrono::microseconds(500));  // About the wire's pace
+        }
+    });
+    writer.join();
+    injector.join();
+
+    std::uint32_t counted = pgnRx() - before;
+    for (int waited = 0; counted < 2 * kRxFrames && waited < 1000; ++waited) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));  // The RX task may still be draining
+        counted = pgnRx() - before;
+    }
+    const bool ok = counted == 2 * kRxFrames;
+    std::printf("    bus stats, RX task and injectRx on PGN 0x%05X: %u/%u counted%s\n", static_cast<unsigned>(pgn),
+                counted, 2 * kRxFrames, ok ? "" : "  FAIL");
+    return ok;
+}
+
+// Peer request -> panel reply, timed at the peer from transmit() to receive()
+bool benchRoundTrip(CanManager& can, VirtualCanBus::Node& peer) {
+    std::printf("Round trip (%u request/response pairs)\n", kRoundTrips);
+    std::atomic<bool> running{true};
+    std::thread responder([&]() {
+        CanRxCursor cursor = can.openRxCursor();
+        CanRxMessage msg;
+        while (running.load()) {
+            if (!can.readRx(cursor, msg, 10) || msg.identifier != kPeerRequestId) {
+                continue;
+            }
+            CanTxRequest reply;
+            reply.identifier = kPanelReplyId;
+            reply.fixed_source = true;
+            reply.length = msg.length;
+            std::memcpy(reply.data, msg.data, sizeof(reply.data));
+            can.enqueueTx(reply);
+        }
+    });
+
+    std::vector<double> samples;
+    CanFrame request;
+    request.identifier = kPeerRequestId;
+    request.length = 8;
+    for (std::uint32_t i = 0; i < kRoundTrips; ++i) {
+        std::memcpy(request.data, &i, sizeof(i));
+        const std::uint64_t start = canMicros();
+        if (peer.transmit(request, 100) != kCanDriverOk) {
+            continue;
+        }
+        CanFrame reply;
+        while (peer.receive(reply, 100)) {
+            if (reply.identifier == kPanelReplyId && std::memcmp(reply.data, request.data, 8) == 0) {
+                samples.push_back(static_cast<double>(canMicros() - start));
+                break;
+            }
+        }
+    }
+    running.store(false);
+    responder.join();
+
+    if (samples.empty()) {
+        std::printf("    no replies\n");
+        return false;
+    }
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (double sample : samples) {
+        sum += sample;
+    }
+    std::printf("    %zu/%u replies: min %.0f us, p50 %.0f us, p99 %.0f us, max %.0f us, mean %.0f us\n",
+                samples.size(), kRoundTrips, samples.front(), samples[samples.size() / 2],
+                samples[samples.size() * 99 / 100], samples.back(), sum / samples.size());
+    return samples.size() == kRoundTrips;
+}
+
+// Synthetic presses through the latency tracer: touch edge, event, TX queue, driver and TX-complete alert
+bool benchPresses(CanManager& can, VirtualCanBus::Node& peer) {
+    std::printf("Press to wire (%u presses)\n", kPresses);
+    CanLatencyTracer& tracer = CanLatencyTracer::instance();
+    tracer.reset();
+    for (std::uint32_t i = 0; i < kPresses; ++i) {
+        tracer.touchEdge(canMicros());
+        CanTxRequest request;
+        request.identifier = 0x18FF4180;
+        request.length = 8;
+        std::memcpy(request.data, &i, sizeof(i));
+        request.trace_id = tracer.beginPress(canMicros());
+        can.enqueueTx(request);
+        CanFrame frame;
+        while (peer.receive(frame, 100) && frame.identifier != request.identifier) {
+        }
+        canDelayMs(2);  // Presses are human-paced; let the alert task report completion
+    }
+    canDelayMs(kAlertSettleMs);
+
+    const CanLatencySnapshot lat = tracer.snapshot();
+    std::printf("    %u presses, %u on the wire, %u abandoned\n", lat.presses, lat.completed, lat.abandoned);
+    for (std::size_t i = 0; i < lat.stages.size(); ++i) {
+        const CanLatencySnapshot::Stage& stage = lat.stages[i];
+        std::printf("    %-18s p50 %6u us  p99 %6u us  max %6u us\n",
+                    CanLatencyTracer::stageName(static_cast<CanLatencyStage>(i)), stage.p50_us, stage.p99_us,
+                    stage.max_us);
+    }
+    return lat.completed == kPresses;
+}
+
+struct WireFrame {
+    std::uint32_t identifier;
+    std::uint8_t data0;
+    std::uint64_t at_us;
+};
+
+// Frames the peer sees on `pgn` while `stream` runs, plus the settle time after it
+template <typename Stream>
+std::vector<WireFrame> captureTouchStream(VirtualCanBus::Node& peer, std::uint32_t pgn, Stream stream) {
+    std::vector<WireFrame> frames;
+    std::atomic<bool> running{true};
+    std::thread reader([&]() {
+        CanFrame frame;
+        while (running.load()) {
+            if (peer.receive(frame, 10) && j1939PgnFromIdentifier(frame.identifier) == pgn) {
+                frames.push_back({frame.identifier, frame.data[0], frame.timestamp_us});  // End of frame on the wire
+            }
+        }
+    });
+    stream();
+    canDelayMs(kTouchSettleMs);
+    running.store(false);
+    reader.join();
+    return frames;
+}
+
+ButtonConfig touchButton(const char* id, std::uint32_t pgn, std::uint8_t on, std::uint8_t off) {
+    ButtonConfig button;
+    button.id = id;
+    button.can.enabled = true;
+    button.can.pgn = pgn;
+    button.can.length = 8;
+    button.can.data[0] = on;
+    button.can_off = button.can;
+    button.can_off.data[0] = off;
+    return button;
+}
+
+double minGapMs(const std::vector<WireFrame>& frames) {
+    double gap = 0;
+    for (std::size_t i = 1; i < frames.size(); ++i) {
+        const double ms = static_cast<double>(frames[i].at_us - frames[i - 1].at_us) / 1000.0;
+        gap = i == 1 ? ms : std::min(gap, ms);
+    }
+    return gap;
+}
+
+bool reportTouchStream(const char* name, std::uint32_t events, const std::vector<WireFrame>& frames, bool final_ok) {
+    std::printf("    %-22s %3u events -> %2zu frames, min gap %5.1f ms, final state %s\n", name, events,
+                frames.size(), minGapMs(frames), final_ok ? "ok" : "WRONG");
+    return final_ok;
+}
+
+// Synthetic touch streams through sendButtonAction/sendButtonReleaseAction: frames on the wire vs events
+bool benchCoalescing(CanManager& can, VirtualCanBus::Node& peer) {
+    CanCoalesceConfig config;
+    std::printf("Button coalescing (window %u ms, spacing %u ms)\n", config.duplicate_window_ms,
+                config.min_spacing_ms);
+    can.configureCoalescing(config);
+    can.resetCoalesceStats();
+    bool ok = true;
+
+    // Contact chatter: one click reported 30 times, 4 ms apart
+    const ButtonConfig chatter = touchButton("chatter", 0xFF10, 0x01, 0x00);
+    const std::uint32_t chatter_events = 30;
+    std::vector<WireFrame> frames = captureTouchStream(peer, 0xFF10, [&]() {
+        for (std::uint32_t i = 0; i < chatter_events; ++i) {
+            can.sendButtonAction(chatter);
+            canDelayMs(4);
+        }
+    });
+    ok &= reportTouchStream("chatter", chatter_events, frames, frames.size() == 1 && frames.back().data0 == 0x01);
+
+    // Nervous thumb on a momentary button: press/release every 6 ms, ending released
+    const ButtonConfig thumb = touchButton("thumb", 0xFF20, 0x01, 0x00);
+    const std::uint32_t thumb_events = 40;
+    frames = captureTouchStream(peer, 0xFF20, [&]() {
+        for (std::uint32_t i = 0; i < thumb_events; ++i) {
+            if (i % 2 == 0) {
+                can.sendButtonAction(thumb);
+            } else {
+                can.sendButtonReleaseAction(thumb);
+            }
+            canDelayMs(6);
+        }
+    });
+    // Spacing runs from TX completion at millisecond resolution, so wire gaps can read up to 1 ms short
+    ok &= reportTouchStream("press/release", thumb_events, frames, !frames.empty() && frames.back().data0 == 0x00);
+    ok &= minGapMs(frames) >= config.min_spacing_ms - 1;
+
+    // A row of switches on one PGN swiped in 2 ms steps, twice: every switch's last state must arrive
+    std::vector<ButtonConfig> row;
+    const char* const ids[] = {"row_1", "row_2", "row_3", "row_4", "row_5", "row_6"};
+    for (std::uint8_t i = 0; i < 6; ++i) {
+        row.push_back(touchButton(ids[i], 0xFF30, static_cast<std::uint8_t>(0x10 + i), static_cast<std::uint8_t>(0x20 + i)));
+    }
+    frames = captureTouchStream(peer, 0xFF30, [&]() {
+        for (const ButtonConfig& button : row) {
+            can.sendButtonAction(button);
+            canDelayMs(2);
+        }
+        for (const ButtonConfig& button : row) {
+            can.sendButtonReleaseAction(button);
+            canDelayMs(2);
+        }
+    });
+    bool row_ok = true;
+    for (std::uint8_t i = 0; i < 6; ++i) {
+        std::uint8_t last = 0;
+        for (const WireFrame& frame : frames) {
+            if ((frame.data0 & 0x0F) == i) {
+                last = frame.data0;
+            }
+        }
+        row_ok &= last == 0x20 + i;
+    }
+    ok &= reportTouchStream("shared PGN swipe", 12, frames, row_ok);
+    ok &= minGapMs(frames) >= config.min_spacing_ms - 1;
+
+    const CanCoalesceStats stats = can.coalesceStats();
+    std::printf("    totals: %u events, %u sent, %u duplicates, %u deferred, %u superseded\n", stats.events,
+                stats.sent, stats.duplicates, stats.deferred, stats.superseded);
+    return ok && stats.events == chatter_events + thumb_events + 12;
+}
+
+struct SentStep {
+    std::uint32_t pgn;
+    std::uint32_t at_ms;
+};
+
+std::vector<SentStep> g_sent_steps;
+constexpr std::uint32_t kRefusedPgn = 0xFF7F;  // The sink refuses these, like a full TX queue
+
+bool recordStep(const CanSequenceEngine::Step& step) {
+    const std::uint32_t pgn = j1939PgnFromIdentifier(step.identifier);
+    g_sent_steps.push_back({pgn, canMillis()});
+    return pgn != kRefusedPgn;
+}
+
+CanSequenceConfig sequence(const char* id, const char* group, std::uint16_t start_delay_ms,
+                           std::initializer_list<std::pair<std::uint32_t, std::uint16_t>> steps) {
+    CanSequenceConfig config;
+    config.id = id;
+    config.group = group;
+    config.start_delay_ms = start_delay_ms;
+    for (const auto& entry : steps) {
+        CanSequenceStep step;
+        step.pgn = entry.first;
+        step.delay_ms = entry.second;
+        config.steps.push_back(step);
+    }
+    return config;
+}
+
+// Runs the engine on virtual time until `until_ms` or until it goes idle, jumping straight to each due step
+void runSequencesUntil(CanSequenceEngine& engine, std::uint32_t until_ms) {
+    while (true) {
+        const std::uint32_t now = canMillis();
+        const std::uint32_t wait = engine.tick(now);
+        if (wait == CanSequenceEngine::kIdle || now + wait > until_ms) {
+            setVirtualMs(until_ms);
+            return;
+        }
+        setVirtualMs(now + wait);
+    }
+}
+
+bool expectSteps(const char* name, const std::vector<SentStep>& expected) {
+    bool same = g_sent_steps.size() == expected.size();
+    for (std::size_t i = 0; same && i < expected.size(); ++i) {
+        same = g_sent_steps[i].pgn == expected[i].pgn && g_sent_steps[i].at_ms == expected[i].at_ms;
+    }
+    std::printf("    %-28s %zu steps: %s\n", name, g_sent_steps.size(), same ? "ok" : "WRONG");
+    if (!same) {
+        for (const SentStep& step : g_sent_steps) {
+            std::printf("        PGN 0x%05X at %u ms\n", step.pgn, step.at_ms);
+        }
+    }
+    g_sent_steps.clear();
+    return same;
+}
+
+// Step gaps, group cancellation, queued overlap and PREVIOUS_OK aborts, timed on the virtual clock
+bool checkSequenceTiming() {
+    std::printf("CAN sequences (virtual clock)\n");
+    CanSequenceEngine& engine = CanSequenceEngine::instance();
+    std::vector<CanSequenceConfig> sequences;
+    sequences.push_back(sequence("on", "lights", 5, {{0xFF01, 20}, {0xFF02, 35}, {0xFF03, 0}, {0xFF04, 10}}));
+    sequences.push_back(sequence("off", "lights", 0, {{0xFF11, 10}, {0xFF12, 10}}));
+    sequences.push_back(sequence("pulse", "", 0, {{0xFF21, 15}, {0xFF22, 15}}));
+    sequences.back().overlap = "queue";
+    sequences.push_back(sequence("refused", "", 0, {{0xFF31, 5}, {kRefusedPgn, 5}, {0xFF32, 5}}));
+    std::string error;
+    if (!engine.load(sequences, error)) {
+        std::printf("    load failed: %s\n", error.c_str());
+        return false;
+    }
+    engine.setSink(recordStep);
+    g_sent_steps.clear();
+    bool ok = true;
+
+    setVirtualMs(1000);
+    engine.start("on");
+    runSequencesUntil(engine, 2000);
+    ok &= expectSteps("gaps", {{0xFF01, 1005}, {0xFF02, 1025}, {0xFF03, 1060}, {0xFF04, 1060}});
+
+    engine.start("on");
+    runSequencesUntil(engine, 2030);
+    engine.start("off");  // Same group: the rest of "on" never goes out
+    runSequencesUntil(engine, 3000);
+    ok &= expectSteps("group cancel", {{0xFF01, 2005}, {0xFF02, 2025}, {0xFF11, 2030}, {0xFF12, 2040}});
+
+    engine.start("pulse");
+    runSequencesUntil(engine, 3010);
+    engine.start("pulse");  // Queued behind the running one, not restarted
+    runSequencesUntil(engine, 4000);
+    ok &= expectSteps("queued overlap",
+                      {{0xFF21, 3000}, {0xFF22, 3015}, {0xFF21, 3030}, {0xFF22, 3045}});
+
+    engine.start("refused");
+    runSequencesUntil(engine, 5000);
+    ok &= expectSteps("abort after refused step", {{0xFF31, 4000}, {kRefusedPgn, 4005}});
+
+    engine.cancelAll();
+    engine.load({}, error);
+    engine.setSink(nullptr);
+    return ok;
+}
+
+// The sequence worker on the real clock: steps reach the peer with at least the configured gaps
+bool benchSequenceOnBus(VirtualCanBus::Node& peer) {
+    std::printf("CAN sequence on the bus (worker task)\n");
+    CanSequenceEngine& engine = CanSequenceEngine::instance();
+    std::vector<CanSequenceConfig> sequences;
+    sequences.push_back(sequence("ramp", "", 0, {{0xFF41, 30}, {0xFF42, 20}, {0xFF43, 10}}));
+    std::string error;
+    if (!engine.load(sequences, error) || !engine.start("ramp")) {
+        std::printf("    sequence failed to start: %s\n", error.c_str());
+        return false;
+    }
+
+    std::vector<WireFrame> frames;
+    CanFrame frame;
+    while (frames.size() < 3 && peer.receive(frame, 500)) {
+        const std::uint32_t pgn = j1939PgnFromIdentifier(frame.identifier);
+        if (pgn >= 0xFF41 && pgn <= 0xFF43) {
+            frames.push_back({frame.identifier, frame.data[0], frame.timestamp_us});
+        }
+    }
+    engine.load({}, error);
+
+    const std::uint32_t gaps[] = {30, 20};
+    bool ok = frames.size() == 3;
+    for (std::size_t i = 1; ok && i < frames.size(); ++i) {
+        const double ms = static_cast<double>(frames[i].at_us - frames[i - 1].at_us) / 1000.0;
+        std::printf("    step %zu -> %zu: %5.1f ms (configured %u)\n", i, i + 1, ms, gaps[i - 1]);
+        ok &= ms >= gaps[i - 1] - 1;
+    }
+    std::printf("    %zu/3 steps on the wire\n", frames.size());
+    return ok;
+}
+
+// 64 cyclic frames from 10 ms to 1 s, about 60% of a 250 kbps bus
+constexpr std::uint32_t kPeriodicSimMs = 10000;
+const struct {
+    std::uint32_t period_ms;
+    std::uint32_t count;
+} kPeriodicMix[] = {{10, 2}, {20, 6}, {50, 10}, {100, 16}, {250, 14}, {500, 10}, {1000, 6}};
+
+// A simulated 250 kbps wire behind the scheduler's sink: frames wait for the one ahead to finish
+struct PeriodicWire {
+    std::uint64_t free_at_us = 0;
+    std::vector<std::uint32_t> max_wait_us;  // Per entry, indexed by PGN low byte
+    std::vector<std::uint32_t> waits_us;
+    std::uint32_t released_this_ms = 0;
+    std::uint64_t current_ms = 0;
+    std::uint32_t max_released_per_ms = 0;
+};
+PeriodicWire g_wire;
+
+bool sendOnWire(std::uint32_t identifier, const std::uint8_t*, std::uint8_t length) {
+    const std::uint64_t now = g_virtual_us.load();
+    const std::uint64_t start = std::max(now, g_wire.free_at_us);
+    g_wire.free_at_us = start + canExtendedFrameBits(length) * 1000000ull / kBitrate;
+    const std::uint32_t wait = static_cast<std::uint32_t>(start - now);
+    std::uint32_t& entry_max = g_wire.max_wait_us[identifier >> 8 & 0xFF];
+    entry_max = std::max(entry_max, wait);
+    g_wire.waits_us.push_back(wait);
+
+    if (now / 1000 != g_wire.current_ms) {
+        g_wire.current_ms = now / 1000;
+        g_wire.released_this_ms = 0;
+    }
+    g_wire.max_released_per_ms = std::max(g_wire.max_released_per_ms, ++g_wire.released_this_ms);
+    return true;
+}
+
+struct PeriodicRun {
+    float load_percent = 0;
+    std::uint32_t max_wait_us = 0;
+    std::uint32_t p99_wait_us = 0;
+    std::uint32_t max_per_ms = 0;
+    bool complete = true;  // Every frame sent once per period, none missed or rejected
+};
+
+// Runs the scheduler for kPeriodicSimMs of virtual time; the timer fires 20-150 us after it was due
+PeriodicRun simulatePeriodic(bool spread, bool report) {
+    CanPeriodicScheduler& scheduler = CanPeriodicScheduler::instance();
+    std::vector<CanPeriodicConfig> configs;
+    for (const auto& group : kPeriodicMix) {
+        for (std::uint32_t i = 0; i < group.count; ++i) {
+            CanPeriodicConfig config;
+            config.id = "p" + std::to_string(configs.size());
+            config.pgn = 0xFF00 | static_cast<std::uint32_t>(configs.size());  // PGN low byte = entry
+            config.period_ms = group.period_ms;
+            config.phase_ms = spread ? -1 : 0;
+            configs.push_back(config);
+        }
+    }
+
+    g_wire = PeriodicWire{};
+    g_wire.max_wait_us.assign(configs.size(), 0);
+    setVirtualMs(0);
+    std::string error;
+    scheduler.load(configs, error);
+    scheduler.resetStats();
+
+    const std::uint64_t end_us = static_cast<std::uint64_t>(kPeriodicSimMs) * 1000;
+    std::uint64_t now = 0;
+    while (now < end_us) {
+        g_virtual_us.store(now);
+        const std::uint64_t wait = scheduler.tick(now);
+        now += wait + 20 + canRandom() % 131;
+    }
+
+    PeriodicRun run;
+    run.load_percent = scheduler.busLoadPercent(kBitrate);
+    run.max_per_ms = g_wire.max_released_per_ms;
+    std::sort(g_wire.waits_us.begin(), g_wire.waits_us.end());
+    run.max_wait_us = g_wire.waits_us.back();
+    run.p99_wait_us = g_wire.waits_us[g_wire.waits_us.size() * 99 / 100];
+    const std::vector<CanPeriodicScheduler::EntryStats> stats = scheduler.stats();
+    for (std::size_t i = 0; i < stats.size(); ++i) {
+        const CanPeriodicScheduler::EntryStats& entry = stats[i];
+        run.complete &= entry.sent >= kPeriodicSimMs / entry.period_ms - 1 && entry.missed == 0 && entry.rejected == 0;
+        if (report) {
+            std::printf("    %-4s %4u ms at phase %3u: %4u sent, release late avg %3u max %3u us, wire wait max %4u us\n",
+                        entry.id.c_str(), entry.period_ms, entry.phase_ms, entry.sent, entry.avg_late_us,
+                        entry.max_late_us, g_wire.max_wait_us[i]);
+        }
+    }
+    return run;
+}
+
+// Per-message jitter for 64 cyclic frames with spread phases, then the same frames all at phase 0
+bool simulatePeriodicLoad() {
+    std::printf("Periodic frames (64 on a simulated %u bps wire, %u ms virtual)\n", kBitrate, kPeriodicSimMs);
+    CanPeriodicScheduler& scheduler = CanPeriodicScheduler::instance();
+    scheduler.setClock(virtualMicros);
+    scheduler.setSink(sendOnWire);
+
+    const PeriodicRun spread = simulatePeriodic(true, true);
+    const PeriodicRun aligned = simulatePeriodic(false, false);
+    std::printf("    bus load %.1f%%\n", spread.load_percent);
+    std::printf("    spread phases : wire wait p99 %5u us, max %5u us, at most %2u frames released in one ms\n",
+                spread.p99_wait_us, spread.max_wait_us, spread.max_per_ms);
+    std::printf("    all at phase 0: wire wait p99 %5u us, max %5u us, at most %2u frames released in one ms\n",
+                aligned.p99_wait_us, aligned.max_wait_us, aligned.max_per_ms);
+
+    std::string error;
+    scheduler.load({}, error);
+    scheduler.setSink(nullptr);
+    scheduler.setClock(nullptr);
+    return spread.complete && aligned.complete && spread.max_wait_us < aligned.max_wait_us &&
+           spread.max_per_ms < aligned.max_per_ms;
+}
+
+constexpr std::uint8_t kTpSender = 0x21;
+constexpr std::uint8_t kTpReceiver = 0x80;
+constexpr std::uint8_t kTpGlobal = 0xFF;
+constexpr std::uint32_t kTpPgn = 0xFECA;  // DM1, the usual multi-packet message
+constexpr std::uint32_t kTpLimitMs = 8000;
+constexpr std::uint32_t kBamMaxGapMs = 200;  // J1939-21: BAM packets 50..200 ms apart
+
+// What happens to frames between the wire and the transport reading them
+struct TpImpairment {
+    std::vector<std::uint8_t> lose_dt;  // TP.DT sequence numbers lost the first time they arrive
+    std::uint8_t delay_dt = 0;          // Held back until the next TP.DT has been read
+    std::uint8_t cut_after_dt = 0;      // Every TP.DT after this many is lost: the sender went quiet
+    bool lose_first_cts = false;
+    bool receiver_deaf = false;         // The receiver never reads anything
+};
+
+struct TpOutcome {
+    bool delivered = false;
+    bool intact = false;
+    int sender_done = -1;              // -1 not called, 0 failed, 1 succeeded
+    std::uint32_t now_ms = 0;
+    std::uint32_t done_ms = 0;
+    std::uint32_t closed_ms = 0;       // When the receiver's session went away
+    std::uint32_t last_dt_ms = 0;      // Last TP.DT the receiver read
+    std::uint32_t min_dt_gap_ms = UINT32_MAX;
+    std::uint32_t max_dt_gap_ms = 0;
+    std::uint8_t abort_source = 0;     // Last TP.CM abort on the wire
+    std::uint8_t abort_reason = 0;
+    std::vector<std::uint8_t> payload;
+    J1939TransportStats rx;
+};
+
+// The protocol classes take plain function sinks; these put each one's frames on its own bus node
+VirtualCanBus::Node* g_sink_nodes[8] = {};
+
+template <int Index>
+bool nodeSink(std::uint32_t identifier, const std::uint8_t* data, std::uint8_t length) {
+    CanFrame frame;
+    frame.identifier = identifier;
+    frame.length = length;
+    std::memcpy(frame.data, data, length);
+    return g_sink_nodes[Index]->transmit(frame, 0) == kCanDriverOk;
+}
+
+using NodeSink = bool (*)(std::uint32_t, const std::uint8_t*, std::uint8_t);
+constexpr NodeSink kNodeSinks[] = {nodeSink<0>, nodeSink<1>, nodeSink<2>, nodeSink<3>,
+                                   nodeSink<4>, nodeSink<5>, nodeSink<6>, nodeSink<7>};
+
+void tpDelivered(const J1939Message& message, void* context) {
+    TpOutcome& outcome = *static_cast<TpOutcome*>(context);
+    outcome.delivered = true;
+    outcome.intact = message.pgn == kTpPgn && message.source_address == kTpSender &&
+                     message.length == outcome.payload.size() &&
+                     std::memcmp(message.data, outcome.payload.data(), message.length) == 0;
+}
+
+void tpDone(std::uint32_t, std::uint8_t, bool success, void* context) {
+    TpOutcome& outcome = *static_cast<TpOutcome*>(context);
+    outcome.sender_done = success ? 1 : 0;
+    outcome.done_ms = outcome.now_ms;
+}
+
+// One transfer from kTpSender to `destination` (kTpGlobal for BAM) in 1 ms ticks of virtual time, until both
+// transports are idle and the wire is drained
+TpOutcome runTransfer(std::uint8_t destination, std::uint16_t size, TpImpairment impairment) {
+    TpOutcome outcome;
+    for (std::uint16_t i = 0; i < size; ++i) {
+        outcome.payload.push_back(static_cast<std::uint8_t>(i * 7 + 3));
+    }
+
+    setVirtualMs(0);  // Before the bus exists: it must never see time go backwards
+    VirtualCanBus bus(kBitrate);
+    bus.setClock(virtualMicros);
+    VirtualCanBus::Node& sender_node = bus.addNode("tp_sender");
+    VirtualCanBus::Node& receiver_node = bus.addNode("tp_receiver");
+    CanDriverConfig config;
+    config.bitrate = kBitrate;
+    config.rx_queue_len = 64;
+    sender_node.install(config);
+    sender_node.start();
+    receiver_node.install(config);
+    receiver_node.start();
+    g_sink_nodes[0] = &sender_node;
+    g_sink_nodes[1] = &receiver_node;
+
+    J1939Transport sender;
+    J1939Transport receiver;
+    sender.begin();
+    sender.setAddress(kTpSender);
+    sender.setSink(kNodeSinks[0]);
+    receiver.begin();
+    receiver.setAddress(kTpReceiver);
+    receiver.setSink(kNodeSinks[1]);
+    receiver.addHandler(tpDelivered, &outcome);
+
+    sender.send(kTpPgn, 6, destination, outcome.payload.data(), size, 0, tpDone, &outcome);
+
+    bool receiver_open = false;
+    bool idle = false;
+    std::uint8_t dt_read = 0;
+    bool held = false;
+    CanFrame held_frame;
+    CanFrame frame;
+    for (std::uint32_t now = 0; now <= kTpLimitMs; ++now) {
+        outcome.now_ms = now;
+        setVirtualMs(now);
+        bus.advance();
+
+        auto noteAbort = [&](const CanFrame& cm) {
+            if (((cm.identifier >> 16) & 0xFF) == (J1939Transport::kPgnTpCm >> 8) && cm.data[0] == 255) {
+                outcome.abort_source = cm.identifier & 0xFF;
+                outcome.abort_reason = cm.data[1];
+            }
+        };
+
+        while (receiver_node.receive(frame, 0)) {
+            noteAbort(frame);
+            if (impairment.receiver_deaf) {
+                continue;
+            }
+            const bool dt = ((frame.identifier >> 16) & 0xFF) == (J1939Transport::kPgnTpDt >> 8);
+            if (dt) {
+                auto lost = std::find(impairment.lose_dt.begin(), impairment.lose_dt.end(), frame.data[0]);
+                if (lost != impairment.lose_dt.end()) {
+                    impairment.lose_dt.erase(lost);
+                    continue;
+                }
+                if (impairment.cut_after_dt && dt_read >= impairment.cut_after_dt) {
+                    continue;
+                }
+                if (frame.data[0] == impairment.delay_dt && !held) {
+                    impairment.delay_dt = 0;
+                    held = true;
+                    held_frame = frame;
+                    continue;
+                }
+                const std::uint32_t arrived_ms = static_cast<std::uint32_t>(frame.timestamp_us / 1000);
+                if (dt_read) {
+                    outcome.min_dt_gap_ms = std::min(outcome.min_dt_gap_ms, arrived_ms - outcome.last_dt_ms);
+                    outcome.max_dt_gap_ms = std::max(outcome.max_dt_gap_ms, arrived_ms - outcome.last_dt_ms);
+                }
+                outcome.last_dt_ms = arrived_ms;
+                ++dt_read;
+            }
+            receiver.onFrame(frame.identifier, frame.data, frame.length, now);
+            if (dt && held) {
+                held = false;
+                receiver.onFrame(held_frame.identifier, held_frame.data, held_frame.length, now);
+            }
+        }
+
+        while (sender_node.receive(frame, 0)) {
+            noteAbort(frame);
+            if (impairment.lose_first_cts && frame.data[0] == 17) {
+                impairment.lose_first_cts = false;
+                continue;
+            }
+            sender.onFrame(frame.identifier, frame.data, frame.length, now);
+        }
+
+        if (!idle) {
+            sender.tick(now);
+            receiver.tick(now);
+        }
+        if (receiver.activeSessions()) {
+            receiver_open = true;
+        } else if (receiver_open) {
+            receiver_open = false;
+            outcome.closed_ms = now;
+        }
+        if (idle) {
+            break;  // Both went idle last tick; the frames that closed them have now been read
+        }
+        idle = sender.activeSessions() == 0 && receiver.activeSessions() == 0;
+    }
+    outcome.rx = receiver.stats();
+    g_sink_nodes[0] = g_sink_nodes[1] = nullptr;
+    return outcome;
+}
+
+bool reportTransfer(const char* name, const TpOutcome& outcome, bool ok) {
+    std::printf("    %-40s %s", name, outcome.delivered ? (outcome.intact ? "delivered" : "corrupted") : "not delivered");
+    if (outcome.closed_ms) {
+        std::printf(", receiver closed at %u ms", outcome.closed_ms);
+    }
+    if (outcome.abort_reason) {
+        std::printf(", abort %u from 0x%02X", outcome.abort_reason, outcome.abort_source);
+    }
+    std::printf(", sender %s at %u ms, %u re-requests: %s\n",
+                outcome.sender_done < 0 ? "open" : outcome.sender_done ? "done" : "failed", outcome.done_ms,
+                outcome.rx.rx_retransmits, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+// J1939-21 sessions between two transports on a virtual bus: BAM and RTS/CTS clean, with a packet lost or
+// out of order, and with a party that stops answering
+bool checkTransportConformance() {
+    std::printf("J1939 transport conformance (virtual bus and clock)\n");
+    constexpr std::uint16_t kBamSize = 100;  // 15 packets
+    constexpr std::uint16_t kRtsSize = 280;  // 40 packets, three CTS windows
+    const std::uint32_t t1 = J1939Transport::kT1Ms;
+    bool ok = true;
+
+    TpOutcome r = runTransfer(kTpGlobal, kBamSize, {});
+    ok &= reportTransfer("BAM", r,
+                         r.intact && r.sender_done == 1 && r.min_dt_gap_ms >= J1939Transport::kBamGapMs &&
+                             r.max_dt_gap_ms <= kBamMaxGapMs);
+
+    TpImpairment reorder;
+    reorder.delay_dt = 4;
+    r = runTransfer(kTpGlobal, kBamSize, reorder);
+    ok &= reportTransfer("BAM, packet 4 after 5", r, r.intact);
+
+    TpImpairment loss;
+    loss.lose_dt = {6};
+    r = runTransfer(kTpGlobal, kBamSize, loss);
+    ok &= reportTransfer("BAM, packet 6 lost", r,
+                         !r.delivered && r.rx.rx_aborted == 1 && r.closed_ms >= r.last_dt_ms + t1 &&
+                             r.closed_ms <= r.last_dt_ms + t1 + 1);
+
+    TpImpairment cut;
+    cut.cut_after_dt = 8;
+    r = runTransfer(kTpGlobal, kBamSize, cut);
+    ok &= reportTransfer("BAM, sender quiet after 8 packets", r,
+                         !r.delivered && r.rx.rx_aborted == 1 && r.closed_ms >= r.last_dt_ms + t1 &&
+                             r.closed_ms <= r.last_dt_ms + t1 + 1);
+
+    r = runTransfer(kTpReceiver, kRtsSize, {});
+    ok &= reportTransfer("RTS/CTS", r, r.intact && r.sender_done == 1 && r.rx.rx_retransmits == 0 && !r.abort_reason);
+
+    loss.lose_dt = {7, 30};
+    r = runTransfer(kTpReceiver, kRtsSize, loss);
+    ok &= reportTransfer("RTS/CTS, packets 7 and 30 lost", r,
+                         r.intact && r.sender_done == 1 && r.rx.rx_retransmits == 2 && !r.abort_reason);
+
+    reorder.delay_dt = 10;
+    r = runTransfer(kTpReceiver, kRtsSize, reorder);
+    ok &= reportTransfer("RTS/CTS, packet 10 after 11", r,
+                         r.intact && r.sender_done == 1 && r.rx.rx_retransmits == 0);
+
+    TpImpairment cts;
+    cts.lose_first_cts = true;
+    r = runTransfer(kTpReceiver, kRtsSize, cts);
+    ok &= reportTransfer("RTS/CTS, first CTS lost", r,
+                         r.intact && r.sender_done == 1 && r.rx.rx_retransmits == 1 && r.done_ms >= t1);
+
+    cut.cut_after_dt = 20;
+    r = runTransfer(kTpReceiver, kRtsSize, cut);
+    ok &= reportTransfer("RTS/CTS, sender quiet after 20 packets", r,
+                         !r.delivered && r.sender_done == 0 && r.abort_source == kTpReceiver &&
+                             r.abort_reason == 3 && r.rx.rx_retransmits == J1939Transport::kMaxRetransmits &&
+                             r.rx.rx_aborted == 1);
+
+    TpImpairment deaf;
+    deaf.receiver_deaf = true;
+    r = runTransfer(kTpReceiver, kRtsSize, deaf);
+    ok &= reportTransfer("RTS/CTS, receiver silent", r,
+                         !r.delivered && r.sender_done == 0 && r.abort_source == kTpSender && r.abort_reason == 3 &&
+                             r.done_ms == J1939Transport::kT3Ms);
+    return ok;
+}
+
+struct ClaimNode {
+    const char* name;
+    std::uint32_t identity;       // Lower NAME wins; everything else in the NAME is equal
+    std::uint8_t preferred;
+    bool arbitrary = true;
+    bool fixed = false;           // j1939.address_claim = false
+    std::uint32_t start_ms = 0;
+};
+
+struct ClaimResult {
+    J1939AddressClaim::State state;
+    std::uint8_t address;
+    std::uint32_t contentions;
+    std::uint32_t frames_sent;  // Claim frames carrying this node's NAME
+};
+
+// Address claim on one virtual bus: every node is its own J1939AddressClaim on its own bus node, run in 1 ms
+// ticks of virtual time; a global request for Address Claimed goes out at `request_ms` (0 = none). `wire`
+// gets every frame the other nodes sent
+std::vector<ClaimResult> runClaims(const std::vector<ClaimNode>& specs, std::uint32_t run_ms,
+                                   std::uint32_t request_ms, std::vector<CanFrame>& wire) {
+    setVirtualMs(0);
+    VirtualCanBus bus(kBitrate);
+    bus.setClock(virtualMicros);
+    VirtualCanBus::Node& requester = bus.addNode("requester");
+    CanDriverConfig config;
+    config.bitrate = kBitrate;
+    config.rx_queue_len = 64;
+    requester.install(config);
+    requester.start();
+
+    std::vector<std::unique_ptr<J1939AddressClaim>> claims;
+    std::vector<VirtualCanBus::Node*> nodes;
+    for (std::size_t i = 0; i < specs.size(); ++i) {
+        VirtualCanBus::Node& node = bus.addNode(specs[i].name);
+        node.install(config);
+        node.start();
+        nodes.push_back(&node);
+        g_sink_nodes[i] = &node;
+
+        J1939Name name;
+        name.arbitrary_address_capable = specs[i].arbitrary;
+        name.identity_number = specs[i].identity;
+        claims.emplace_back(new J1939AddressClaim());
+        claims[i]->setSink(kNodeSinks[i]);
+        claims[i]->setRandom([]() -> std::uint32_t { return canRandom(); });
+        claims[i]->configure(name, specs[i].preferred, 0x80, 0x87);
+    }
+
+    CanFrame frame;
+    for (std::uint32_t now = 0; now <= run_ms; ++now) {
+        setVirtualMs(now);
+        for (std::size_t i = 0; i < specs.size(); ++i) {
+            if (now == specs[i].start_ms) {
+                if (specs[i].fixed) {
+                    claims[i]->assignFixed();
+                } else {
+                    claims[i]->start(now);
+                }
+            }
+        }
+        if (request_ms && now == request_ms) {
+            CanFrame request;
+            request.identifier = buildJ1939Identifier(6, J1939AddressClaim::kPgnRequest, 0xF9, 0xFF);
+            request.length = 3;
+            request.data[0] = J1939AddressClaim::kPgnAddressClaimed & 0xFF;
+            request.data[1] = (J1939AddressClaim::kPgnAddressClaimed >> 8) & 0xFF;
+            requester.transmit(request, 0);
+        }
+        bus.advance();
+        while (requester.receive(frame, 0)) {
+            wire.push_back(frame);  // The requester hears everyone
+        }
+        for (std::size_t i = 0; i < specs.size(); ++i) {
+            while (nodes[i]->receive(frame, 0)) {
+                claims[i]->onFrame(frame.identifier, frame.data, frame.length, now);
+            }
+            claims[i]->tick(now);
+        }
+    }
+
+    std::vector<ClaimResult> results;
+    for (std::size_t i = 0; i < specs.size(); ++i) {
+        ClaimResult result{claims[i]->state(), claims[i]->address(), claims[i]->contentions(), 0};
+        for (const CanFrame& seen : wire) {
+            std::uint64_t name = 0;
+            for (int b = 7; b >= 0; --b) {
+                name = (name << 8) | seen.data[b];
+            }
+            result.frames_sent += name == claims[i]->name() ? 1 : 0;  // Claims and Cannot Claim carry the NAME
+        }
+        results.push_back(result);
+        g_sink_nodes[i] = nullptr;
+    }
+    return results;
+}
+
+const char* claimStateName(J1939AddressClaim::State state) {
+    static const char* const kNames[] = {"idle", "claiming", "claimed", "cannot claim", "fixed"};
+    return kNames[static_cast<int>(state)];
+}
+
+void printClaims(const std::vector<ClaimNode>& specs, const std::vector<ClaimResult>& results) {
+    for (std::size_t i = 0; i < specs.size(); ++i) {
+        std::printf("        %-8s prefers 0x%02X -> 0x%02X %-12s %u contentions, %u claim frames\n", specs[i].name,
+                    specs[i].preferred, results[i].address, claimStateName(results[i].state),
+                    results[i].contentions, results[i].frames_sent);
+    }
+}
+
+std::uint32_t framesFrom(const std::vector<CanFrame>& wire, std::uint8_t source) {
+    std::uint32_t count = 0;
+    for (const CanFrame& frame : wire) {
+        count += (frame.identifier & 0xFF) == source ? 1 : 0;
+    }
+    return count;
+}
+
+// Several J1939AddressClaim nodes contending on one virtual bus: six claimers for three addresses, a loser
+// that cannot move, and a fixed-address node (claiming off) on an address others claim
+bool checkAddressClaim() {
+    using State = J1939AddressClaim::State;
+    std::printf("J1939 address claim (virtual bus and clock)\n");
+    bool ok = true;
+
+    const std::vector<ClaimNode> crowd = {{"panel_1", 1, 0x80}, {"panel_2", 2, 0x80}, {"panel_3", 3, 0x81},
+                                          {"panel_4", 4, 0x81}, {"panel_5", 5, 0x82}, {"panel_6", 6, 0x80}};
+    std::vector<CanFrame> wire;
+    std::vector<ClaimResult> results = runClaims(crowd, 1000, 0, wire);
+    bool crowd_ok = results[0].address == 0x80;
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        crowd_ok &= results[i].state == State::CLAIMED && results[i].address >= 0x80 && results[i].address <= 0x87;
+        for (std::size_t j = 0; j < i; ++j) {
+            crowd_ok &= results[i].address != results[j].address;
+        }
+    }
+    std::printf("    six claimers, three preferred addresses: %s\n", crowd_ok ? "ok" : "FAIL");
+    printClaims(crowd, results);
+    ok &= crowd_ok;
+
+    // Neither can move; arbitrary-capable nodes would always lose to them (that bit leads the NAME)
+    const std::vector<ClaimNode> stuck = {{"gauge_1", 1, 0x80, false}, {"gauge_2", 2, 0x80, false}};
+    wire.clear();
+    results = runClaims(stuck, 1000, 600, wire);
+    const bool stuck_ok = results[0].state == State::CLAIMED && results[0].address == 0x80 &&
+                          results[1].state == State::CANNOT_CLAIM &&
+                          results[1].address == J1939AddressClaim::kNullAddress &&
+                          framesFrom(wire, J1939AddressClaim::kNullAddress) == 2;  // Once on losing, once on request
+    std::printf("    loser without arbitrary addressing: %s\n", stuck_ok ? "ok" : "FAIL");
+    printClaims(stuck, results);
+    ok &= stuck_ok;
+
+    // The fixed node has the higher NAME, so a claiming node in its place would move off 0x80
+    std::vector<ClaimNode> fixed = {{"fixed", 9, 0x80}, {"ecu", 1, 0x80}, {"late", 20, 0x80}};
+    fixed[0].fixed = true;
+    fixed[2].start_ms = 300;
+    wire.clear();
+    results = runClaims(fixed, 1000, 600, wire);
+    const bool fixed_ok = results[0].state == State::FIXED && results[0].address == 0x80 &&
+                          results[0].frames_sent == 0 && results[0].contentions >= 2 &&
+                          results[1].state == State::CLAIMED && results[1].address == 0x80 &&
+                          results[2].state == State::CLAIMED && results[2].address != 0x80;
+    std::printf("    fixed address among claimers: %s\n", fixed_ok ? "ok" : "FAIL");
+    printClaims(fixed, results);
+    ok &= fixed_ok;
+    return ok;
+}
+
+// Small LCG so every run sees the same rule sets and traffic
+struct BenchRandom {
+    std::uint32_t state;
+    std::uint32_t next() {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+    std::uint32_t below(std::uint32_t n) { return next() % n; }
+};
+
+// J1939-21 PGN of an identifier written out independently of CanFilterPlanner (DA dropped for PDU1)
+std::uint32_t referencePgn(std::uint32_t identifier) {
+    const std::uint32_t data_page = (identifier >> 24) & 0x3;
+    const std::uint32_t pf = (identifier >> 16) & 0xFF;
+    const std::uint32_t ps = (identifier >> 8) & 0xFF;
+    return (data_page << 16) | (pf << 8) | (pf < 240 ? 0 : ps);
+}
+
+bool referenceWants(const std::vector<CanFilterRule>& rules, std::uint32_t identifier) {
+    for (const CanFilterRule& rule : rules) {
+        if (referencePgn(rule.pgn << 8) == referencePgn(identifier) &&
+            (rule.source_address == 0xFF || rule.source_address == (identifier & 0xFF))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Up to 24 rules: PDU1 and PDU2 PGNs on both data pages, a third pinned to one sender, some in short runs
+std::vector<CanFilterRule> randomRules(BenchRandom& rng) {
+    std::vector<CanFilterRule> rules;
+    const std::uint32_t count = 1 + rng.below(24);
+    while (rules.size() < count) {
+        const std::uint32_t pf = rng.below(2) ? rng.below(240) : 240 + rng.below(16);
+        const std::uint32_t pgn = (rng.below(4) == 0 ? 0x10000u : 0u) | (pf << 8) | rng.below(256);
+        const std::uint8_t source = rng.below(3) == 0 ? static_cast<std::uint8_t>(rng.below(0xFE)) : 0xFF;
+        const std::uint32_t run = rng.below(4) == 0 ? 2 + rng.below(6) : 1;
+        for (std::uint32_t i = 0; i < run && rules.size() < count; ++i) {
+            rules.push_back(CanFilterRule{pgn + i, source});
+        }
+    }
+    return rules;
+}
+
+// Traffic for a rule set: frames for the rules (any priority and DA, sometimes the wrong sender), the same
+// identifiers with one bit flipped, and unrelated identifiers
+std::vector<std::uint32_t> randomTraffic(BenchRandom& rng, const std::vector<CanFilterRule>& rules,
+                                         std::uint32_t frames) {
+    std::vector<std::uint32_t> ids;
+    ids.reserve(frames);
+    for (std::uint32_t i = 0; i < frames; ++i) {
+        const CanFilterRule& rule = rules[rng.below(static_cast<std::uint32_t>(rules.size()))];
+        std::uint32_t id = (rng.below(8) << 26) | (rule.pgn << 8);
+        if (((rule.pgn >> 8) & 0xFF) < 240) {
+            id = (id & ~0xFF00u) | (rng.below(256) << 8);
+        }
+        id |= rule.source_address != 0xFF && rng.below(4) != 0 ? rule.source_address : rng.below(0xFE);
+        switch (rng.below(5)) {
+            case 0:
+            case 1:
+                break;
+            case 2:
+            case 3:
+                id ^= 1u << rng.below(29);
+                break;
+            default:
+                id = rng.next() & 0x1FFFFFFF;
+                break;
+        }
+        ids.push_back(id);
+    }
+    return ids;
+}
+
+// Random rule sets against random traffic: the hardware plan, with and without a traffic sample, must pass
+// every frame the exact set wants, and the exact set must agree with the reference
+bool checkFilterCoverage() {
+    constexpr std::uint32_t kRuleSets = 500;
+    constexpr std::uint32_t kFramesPerSet = 2000;
+    std::printf("Filter planner coverage (%u random rule sets, %u frames each)\n", kRuleSets, kFramesPerSet);
+
+    BenchRandom rng{0x1939};
+    CanFilterPlanner planner;
+    std::uint32_t mismatched = 0;
+    std::uint32_t missed = 0;
+    CanFilterReport blind_total;
+    CanFilterReport sampled_total;
+    for (std::uint32_t set = 0; set < kRuleSets; ++set) {
+        const std::vector<CanFilterRule> rules = randomRules(rng);
+        planner.clear();
+        for (const CanFilterRule& rule : rules) {
+            planner.addRule(rule);
+        }
+        const std::vector<std::uint32_t> traffic = randomTraffic(rng, rules, kFramesPerSet);
+        for (std::uint32_t id : traffic) {
+            mismatched += planner.wants(id) != referenceWants(rules, id) ? 1 : 0;
+        }
+
+        const CanFilterReport blind = planner.evaluate(planner.plan(), traffic);
+        const CanFilterReport sampled = planner.evaluate(planner.plan(&traffic), traffic);
+        missed += blind.missed + sampled.missed;
+        blind_total.frames += blind.frames;
+        blind_total.hw_accepted += blind.hw_accepted;
+        blind_total.wanted += blind.wanted;
+        sampled_total.frames += sampled.frames;
+        sampled_total.hw_accepted += sampled.hw_accepted;
+    }
+
+    std::printf("    wanted %5.1f%% of frames; hardware passes %5.1f%% (ID-space plan), %5.1f%% (sampled plan)\n",
+                100.0f * blind_total.wanted / blind_total.frames, 100.0f * blind_total.passRate(),
+                100.0f * sampled_total.passRate());
+    std::printf("    wanted frames dropped: %u, exact-set disagreements with reference: %u\n", missed, mismatched);
+    return missed == 0 && mismatched == 0;
+}
+
+// Filtering switched on in CanManager (the TWAI filter on the panel node, then the exact set): every frame
+// a configured PGN wants reaches consumers and nothing else does
+bool benchFilterOnPanel(CanManager& can, VirtualCanBus::Node& peer) {
+    constexpr std::uint32_t kFrames = 1000;
+    DeviceConfig config;
+    config.can_filter.enabled = true;
+    for (std::uint32_t pgn : {0xFF01u, 0xFF02u, 0xFF10u, 0xEF00u}) {
+        CanMessage msg;
+        msg.pgn = pgn;
+        config.can_library.push_back(msg);
+    }
+    CanSignalConfig signal;
+    signal.pgn = 0xFEEE;  // Engine temperature, from the engine ECU only
+    signal.source_address = 0x00;
+    config.can_signals.push_back(signal);
+    config.can_filter.extra_pgns.push_back(0x1FF20);
+
+    std::vector<CanFilterRule> rules;
+    for (const CanMessage& msg : config.can_library) {
+        rules.push_back(CanFilterRule{msg.pgn});
+    }
+    for (std::uint32_t pgn = 0xFF50; pgn <= 0xFF5F; ++pgn) {
+        rules.push_back(CanFilterRule{pgn});
+    }
+    for (std::uint32_t pgn : {0xEE00u, 0xEA00u, 0xEC00u, 0xEB00u, 0x1FF20u}) {
+        rules.push_back(CanFilterRule{pgn});
+    }
+    rules.push_back(CanFilterRule{signal.pgn, signal.source_address});
+
+    BenchRandom rng{0x0CF0};
+    const std::vector<std::uint32_t> traffic = randomTraffic(rng, rules, kFrames);
+    std::uint32_t wanted = 0;
+    for (std::uint32_t id : traffic) {
+        wanted += referenceWants(rules, id) ? 1 : 0;
+    }
+
+    std::printf("Filtering on the panel (%u frames, %u wanted)\n", kFrames, wanted);
+    if (!can.configureFilters(config)) {
+        std::printf("    panel failed to restart with filters\n");
+        return false;
+    }
+    CanRxCursor cursor = can.openRxCursor();
+    const CanRxStats before = can.rxStats();
+    std::thread writer([&]() {
+        CanFrame frame;
+        frame.length = 8;
+        for (std::uint32_t id : traffic) {
+            frame.identifier = id;
+            while (peer.transmit(frame, 100) != kCanDriverOk) {
+            }
+        }
+    });
+
+    std::uint32_t delivered = 0;
+    std::uint32_t unwanted = 0;
+    CanRxMessage msg;
+    while (can.readRx(cursor, msg, 200)) {
+        ++delivered;
+        unwanted += referenceWants(rules, msg.identifier) ? 0 : 1;
+    }
+    writer.join();
+    const CanRxStats after = can.rxStats();
+    const std::uint32_t hw_passed = (after.frames - before.frames) + (after.filtered - before.filtered);
+    std::printf("    %u delivered (%u unwanted), %u past the hardware filter, %u missed by the driver\n", delivered,
+                unwanted, hw_passed, after.driver_missed - before.driver_missed);
+
+    DeviceConfig unfiltered;
+    const bool restored = can.configureFilters(unfiltered);
+    return delivered == wanted && unwanted == 0 && hw_passed < kFrames && restored;
+}
+
+// DBC semantics bit by bit: Intel counts up from the start bit, Motorola walks down from it (byte by byte,
+// most significant first). False when the signal is not (entirely) inside `length` bytes.
+bool referenceRaw(const CanSignalConfig& signal, const std::uint8_t* data, std::uint8_t length, std::int64_t& raw) {
+    std::uint64_t bits = 0;
+    int bit = signal.start_bit;
+    for (int i = 0; i < signal.length; ++i) {
+        if (bit < 0 || bit > 63 || bit / 8 >= length) {
+            return false;
+        }
+        const std::uint64_t value = (data[bit / 8] >> (bit % 8)) & 1;
+        if (signal.little_endian) {
+            bits |= value << i;
+            ++bit;
+        } else {
+            bits = (bits << 1) | value;
+            bit = bit % 8 == 0 ? bit + 15 : bit - 1;
+        }
+    }
+    if (signal.is_signed && signal.length < 64 && (bits >> (signal.length - 1)) & 1) {
+        bits |= ~0ull << signal.length;
+    }
+    raw = static_cast<std::int64_t>(bits);
+    return true;
+}
+
+struct DecodedSignal {
+    std::uint16_t index;
+    std::int64_t raw;
+    float value;
+    bool operator<(const DecodedSignal& other) const { return index < other.index; }
+    bool operator==(const DecodedSignal& other) const {
+        return index == other.index && raw == other.raw && value == other.value;
+    }
+};
+
+// Subscribers cannot be removed, so the capture stays registered and is switched off after the bench
+std::atomic<bool> g_capture_signals{false};
+std::vector<DecodedSignal> g_captured;
+
+void captureSignal(const CanSignalValue& value, void*) {
+    if (g_capture_signals.load(std::memory_order_relaxed)) {
+        g_captured.push_back(DecodedSignal{value.index, value.raw, value.value});
+    }
+}
+
+CanSignalConfig signalConfig(const char* name, std::uint32_t pgn, std::uint8_t start_bit, std::uint8_t length,
+                             bool little_endian, bool is_signed, float scale, float offset) {
+    CanSignalConfig signal;
+    signal.name = name;
+    signal.pgn = pgn;
+    signal.start_bit = start_bit;
+    signal.length = length;
+    signal.little_endian = little_endian;
+    signal.is_signed = is_signed;
+    signal.scale = scale;
+    signal.offset = offset;
+    return signal;
+}
+
+// 107 signals: a few J1939 engine signals and edge cases, then 100 random layouts on 20 proprietary PGNs,
+// a quarter of them pinned to one sender
+std::vector<CanSignalConfig> benchSignals(BenchRandom& rng) {
+    std::vector<CanSignalConfig> signals = {
+        signalConfig("engine_speed", 0xF004, 24, 16, true, false, 0.125f, 0.0f),
+        signalConfig("engine_torque", 0xF004, 16, 8, true, false, 1.0f, -125.0f),
+        signalConfig("coolant_temp", 0xFEEE, 0, 8, true, false, 1.0f, -40.0f),
+        signalConfig("vehicle_speed", 0xFEF1, 8, 16, true, false, 1.0f / 256, 0.0f),
+        signalConfig("motorola_16", 0xFF10, 7, 16, false, false, 1.0f, 0.0f),
+        signalConfig("signed_12", 0xFF10, 16, 12, true, true, 1.0f, 0.0f),
+        signalConfig("full_64", 0xFF11, 0, 64, true, false, 1.0f, 0.0f),
+    };
+    signals[2].source_address = 0x00;  // Coolant from the engine ECU only
+    const std::uint8_t frame[8] = {};
+    while (signals.size() < 107) {
+        CanSignalConfig signal = signalConfig("", 0xFF20 + signals.size() % 20, rng.below(64),
+                                              1 + rng.below(16), rng.below(2) == 0, rng.below(3) == 0,
+                                              rng.below(2) ? 0.5f : 1.0f, rng.below(2) ? -10.0f : 0.0f);
+        std::int64_t raw = 0;
+        if (!referenceRaw(signal, frame, 8, raw)) {
+            continue;  // Runs off the frame; draw another layout
+        }
+        signal.name = "signal_" + std::to_string(signals.size());
+        signal.source_address = rng.below(4) == 0 ? static_cast<std::uint8_t>(rng.below(4)) : 0xFF;
+        signals.push_back(signal);
+    }
+    return signals;
+}
+
+// 100k random frames through CanSignalDatabase::decode, timed, then checked signal by signal against
+// referenceRaw; plus known values for the engine signals and the edge cases
+bool benchSignalDecoder() {
+    constexpr std::uint32_t kFrames = 100000;
+    BenchRandom rng{0xF004};
+    const std::vector<CanSignalConfig> signals = benchSignals(rng);
+    CanSignalDatabase& db = CanSignalDatabase::instance();
+    std::string error;
+    if (!db.load(signals, error)) {
+        std::printf("Signal decoder: load failed: %s\n", error.c_str());
+        return false;
+    }
+    std::printf("Signal decoder (%zu signals, %u frames)\n", signals.size(), kFrames);
+
+    const std::uint32_t pgns[] = {0xF004, 0xFEEE, 0xFEF1, 0xFF10, 0xFF11, 0xFF25, 0xFF2A, 0xFF33, 0xE800, 0xFEF0};
+    std::vector<CanRxMessage> frames(kFrames);
+    for (CanRxMessage& frame : frames) {
+        frame.identifier = (6u << 26) | (pgns[rng.below(10)] << 8) | rng.below(6);
+        frame.length = rng.below(8) == 0 ? static_cast<std::uint8_t>(1 + rng.below(7)) : 8;
+        for (std::uint8_t& byte : frame.data) {
+            byte = static_cast<std::uint8_t>(rng.next());
+        }
+    }
+
+    // Wall time: canMicros() is the virtual clock while this runs
+    using Clock = std::chrono::steady_clock;
+    std::size_t decoded = 0;
+    const Clock::time_point start = Clock::now();
+    for (const CanRxMessage& frame : frames) {
+        decoded += db.decode(frame.identifier, frame.data, frame.length, 0);
+    }
+    const double table_ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / kFrames;
+
+    // What a decoder without the table does: every signal checked and extracted bit by bit for every frame
+    std::size_t reference_decoded = 0;
+    const Clock::time_point reference_start = Clock::now();
+    for (const CanRxMessage& frame : frames) {
+        const std::uint32_t pgn = referencePgn(frame.identifier);
+        for (const CanSignalConfig& signal : signals) {
+            std::int64_t raw = 0;
+            if (referencePgn(signal.pgn << 8) == pgn &&
+                (signal.source_address == 0xFF || signal.source_address == (frame.identifier & 0xFF)) &&
+                referenceRaw(signal, frame.data, frame.length, raw)) {
+                ++reference_decoded;
+            }
+        }
+    }
+    const double reference_ns =
+        std::chrono::duration<double, std::nano>(Clock::now() - reference_start).count() / kFrames;
+
+    db.subscribe(captureSignal, nullptr);
+    g_capture_signals.store(true);
+    std::uint32_t mismatched = 0;
+    std::vector<DecodedSignal> expected;
+    for (const CanRxMessage& frame : frames) {
+        expected.clear();
+        const std::uint32_t pgn = referencePgn(frame.identifier);
+        for (std::size_t i = 0; i < signals.size(); ++i) {
+            const CanSignalConfig& signal = signals[i];
+            std::int64_t raw = 0;
+            if (referencePgn(signal.pgn << 8) == pgn &&
+                (signal.source_address == 0xFF || signal.source_address == (frame.identifier & 0xFF)) &&
+                referenceRaw(signal, frame.data, frame.length, raw)) {
+                expected.push_back(DecodedSignal{static_cast<std::uint16_t>(i), raw,
+                                                 static_cast<float>(raw) * signal.scale + signal.offset});
+            }
+        }
+        g_captured.clear();
+        db.decode(frame.identifier, frame.data, frame.length, 0);
+        std::sort(g_captured.begin(), g_captured.end());
+        mismatched += g_captured == expected ? 0 : 1;
+    }
+
+    // Known values: bytes 12 34 56 78 9A BC DE F0
+    const std::uint8_t known[8] = {0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF0};
+    auto decodeOne = [&](std::uint32_t identifier, std::uint8_t length, const char* name) -> std::int64_t {
+        g_captured.clear();
+        db.decode(identifier, known, length, 0);
+        for (const DecodedSignal& value : g_captured) {
+            if (value.index == db.find(name)) {
+                return value.raw;
+            }
+        }
+        return -1;
+    };
+    const bool known_ok = decodeOne(0x0CF00411, 8, "engine_speed") == 0x9A78 &&
+                          decodeOne(0x0CF00411, 8, "engine_torque") == 0x56 &&
+                          decodeOne(0x18FEEE00, 8, "coolant_temp") == 0x12 &&
+                          decodeOne(0x18FEEE01, 8, "coolant_temp") == -1 &&  // Wrong sender
+                          decodeOne(0x18FF1022, 8, "motorola_16") == 0x1234 &&
+                          decodeOne(0x18FF1022, 8, "signed_12") == 0x856 - 4096 &&
+                          static_cast<std::uint64_t>(decodeOne(0x18FF1100, 8, "full_64")) == 0xF0DEBC9A78563412ull &&
+                          decodeOne(0x18FF1022, 1, "motorola_16") == -1;  // Short frame: not present
+    g_capture_signals.store(false);
+    g_captured.clear();
+    db.load({}, error);
+
+    std::printf("    sorted table      : %6.1f ns per frame, %zu signals decoded\n", table_ns, decoded);
+    std::printf("    bit-by-bit, linear: %6.1f ns per frame, %zu signals decoded\n", reference_ns,
+                reference_decoded);
+    std::printf("    frames decoded differently from the reference: %u, known values %s\n", mismatched,
+                known_ok ? "ok" : "wrong");
+    return decoded == reference_decoded && mismatched == 0 && known_ok;
+}
+
+// Flight recorder segments, built in memory the way CanRecorder::seal/writePending lay them out on flash
+struct LogBytes {
+    std::vector<std::uint8_t> data;
+    std::size_t position = 0;
+};
+
+std::size_t readLogBytes(void* context, std::uint8_t* buffer, std::size_t length) {
+    LogBytes& bytes = *static_cast<LogBytes*>(context);
+    const std::size_t count = std::min(length, bytes.data.size() - bytes.position);
+    std::memcpy(buffer, bytes.data.data() + bytes.position, count);
+    bytes.position += count;
+    return count;
+}
+
+template <typename T>
+void appendLog(std::vector<std::uint8_t>& out, const T* items, std::size_t count) {
+    const std::uint8_t* raw = reinterpret_cast<const std::uint8_t*>(items);
+    out.insert(out.end(), raw, raw + count * sizeof(T));
+}
+
+// Record k of the segment: extended RX, TX, an 11-bit RX, a bus-state event and a short injected frame, in turn
+CanTraceRecord logRecord(std::uint64_t start_us, std::uint32_t k) {
+    CanTraceRecord rec{};
+    rec.timestamp_us = static_cast<std::uint32_t>(start_us + k * 2000ull);  // esp_timer's low 32 bits
+    rec.identifier = 0x18FEF100 | k;
+    rec.event = static_cast<std::uint8_t>(CanTraceEvent::RX);
+    rec.length = 8;
+    for (std::uint8_t i = 0; i < 8; ++i) {
+        rec.data[i] = static_cast<std::uint8_t>(k * 16 + i);
+    }
+    switch (k % 5) {
+        case 1:
+            rec.event = static_cast<std::uint8_t>(CanTraceEvent::TX);
+            break;
+        case 2:
+            rec.identifier = 0x123;
+            rec.length = 3;
+            rec.arg = kCanTraceStandardFrame;
+            break;
+        case 3:
+            rec.event = static_cast<std::uint8_t>(CanTraceEvent::BUS_STATE);
+            rec.identifier = 0;
+            rec.length = 0;
+            rec.arg = 1;
+            break;
+        case 4:
+            rec.length = 2;
+            rec.arg = kCanTraceVirtualFrame;
+            break;
+    }
+    return rec;
+}
+
+// One segment of `blocks` blocks of kLogPerBlock records; block b reports b records dropped before it
+constexpr std::uint32_t kLogPerBlock = 5;
+
+std::vector<std::uint8_t> buildSegment(const CanLogSegmentHeader& header, std::uint32_t blocks) {
+    std::vector<std::uint8_t> out;
+    appendLog(out, &header, 1);
+    for (std::uint32_t b = 0; b < blocks; ++b) {
+        CanTraceRecord records[kLogPerBlock];
+        for (std::uint32_t i = 0; i < kLogPerBlock; ++i) {
+            records[i] = logRecord(header.start_us, b * kLogPerBlock + i);
+        }
+        CanLogBlockHeader block{};
+        block.magic = kCanLogBlockMagic;
+        block.sequence = b;
+        block.count = kLogPerBlock;
+        block.dropped = b;
+        block.crc = canLogCrc32(reinterpret_cast<const std::uint8_t*>(records), sizeof(records));
+        appendLog(out, &block, 1);
+        appendLog(out, records, kLogPerBlock);
+    }
+    return out;
+}
+
+struct LogReadback {
+    std::vector<CanLogEntry> entries;
+    bool valid = false;
+    bool truncated = false;
+    std::uint32_t dropped = 0;
+};
+
+LogReadback readSegment(std::vector<std::uint8_t> data) {
+    LogBytes bytes{std::move(data)};
+    CanLogReader reader(readLogBytes, &bytes);
+    LogReadback result;
+    CanLogEntry entry;
+    while (reader.next(entry)) {
+        result.entries.push_back(entry);
+    }
+    result.valid = reader.valid();
+    result.truncated = reader.truncated();
+    result.dropped = reader.dropped();
+    return result;
+}
+
+// Every record read back intact with its unwrapped time, up to the first bad block
+bool sameRecords(const CanLogSegmentHeader& header, const LogReadback& readback, std::uint32_t expected) {
+    if (readback.entries.size() != expected) {
+        return false;
+    }
+    for (std::uint32_t k = 0; k < expected; ++k) {
+        const CanTraceRecord rec = logRecord(header.start_us, k);
+        const CanLogEntry& entry = readback.entries[k];
+        const std::uint64_t time_us = header.start_unix_us + k * 2000ull;
+        if (std::memcmp(&entry.record, &rec, sizeof(rec)) != 0 || entry.time_us != time_us) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Segments written across an esp_timer wrap, read back whole, with a torn tail, with a corrupted block and
+// with a foreign header; then the candump and ASC lines tools/can_log_convert.py would also produce
+bool checkLogRoundTrip() {
+    constexpr std::uint32_t kBlocks = 3;
+    std::printf("Flight recorder segments (%u blocks of %u records)\n", kBlocks, kLogPerBlock);
+
+    CanLogSegmentHeader header{};
+    header.magic = kCanLogSegmentMagic;
+    header.version = kCanLogVersion;
+    header.record_size = sizeof(CanTraceRecord);
+    header.segment = 7;
+    header.start_us = 0x1FFFFC000ull;  // 16.4 ms before the low 32 bits wrap: records 9 onwards are past it
+    header.start_unix_us = 1700000000000000ull;
+    const std::vector<std::uint8_t> segment = buildSegment(header, kBlocks);
+    const std::size_t block_bytes = sizeof(CanLogBlockHeader) + kLogPerBlock * sizeof(CanTraceRecord);
+
+    const LogReadback whole = readSegment(segment);
+    const bool whole_ok = whole.valid && !whole.truncated && whole.dropped == 0 + 1 + 2 &&
+                          sameRecords(header, whole, kBlocks * kLogPerBlock);
+
+    std::vector<std::uint8_t> torn = segment;
+    torn.resize(torn.size() - 7);  // Reset mid-append: the last block is short
+    const LogReadback torn_back = readSegment(torn);
+    const bool torn_ok = torn_back.valid && torn_back.truncated && torn_back.dropped == 0 + 1 &&
+                         sameRecords(header, torn_back, 2 * kLogPerBlock);
+
+    std::vector<std::uint8_t> corrupt = segment;
+    corrupt[sizeof(header) + block_bytes + sizeof(CanLogBlockHeader) + 5] ^= 0x40;  // A bit flipped in block 1
+    const LogReadback corrupt_back = readSegment(corrupt);
+    const bool corrupt_ok = corrupt_back.valid && corrupt_back.truncated && corrupt_back.dropped == 0 &&
+                            sameRecords(header, corrupt_back, kLogPerBlock);
+
+    CanLogSegmentHeader foreign = header;
+    foreign.record_size = 16;
+    const LogReadback foreign_back = readSegment(buildSegment(foreign, 1));
+    const bool foreign_ok = !foreign_back.valid && foreign_back.entries.empty();
+
+    // Lines for records 0-4 and 10 (past the wrap); the bus-state event has none
+    static const char* const kCandump[] = {
+        "(1700000000.000000) can0 18FEF100#0001020304050607\n",
+        "(1700000000.002000) can0 18FEF101#1011121314151617\n",
+        "(1700000000.004000) can0 123#202122\n",
+        "",
+        "(1700000000.008000) can0 18FEF104#4041\n",
+    };
+    static const char* const kAsc[] = {
+        "      0.000000 1  18FEF100x       Rx   d 8 00 01 02 03 04 05 06 07\n",
+        "      0.002000 1  18FEF101x       Tx   d 8 10 11 12 13 14 15 16 17\n",
+        "      0.004000 1  123             Rx   d 3 20 21 22\n",
+        "",
+        "      0.008000 1  18FEF104x       Rx   d 2 40 41\n",
+    };
+    bool lines_ok = whole.entries.size() > 10;
+    char line[96];
+    for (std::uint32_t k = 0; lines_ok && k < 5; ++k) {
+        const CanLogEntry& entry = whole.entries[k];
+        lines_ok = canLogFormatCandump(entry, "can0", line, sizeof(line)) == std::strlen(kCandump[k]) &&
+                   std::strncmp(line, kCandump[k], std::strlen(kCandump[k])) == 0 &&
+                   canLogFormatAsc(entry, header.start_unix_us, line, sizeof(line)) == std::strlen(kAsc[k]) &&
+                   std::strncmp(line, kAsc[k], std::strlen(kAsc[k])) == 0;
+    }
+    lines_ok = lines_ok && canLogFormatCandump(whole.entries[10], "can0", line, sizeof(line)) > 0 &&
+               std::strcmp(line, "(1700000000.020000) can0 18FEF10A#A0A1A2A3A4A5A6A7\n") == 0;
+
+    std::printf("    whole segment: %zu records, %u dropped before them, %s\n", whole.entries.size(), whole.dropped,
+                whole_ok ? "ok" : "wrong");
+    std::printf("    torn tail: %zu records, %s; bad CRC in block 1: %zu records, %s; foreign header: %s\n",
+                torn_back.entries.size(), torn_ok ? "ok" : "wrong", corrupt_back.entries.size(),
+                corrupt_ok ? "ok" : "wrong", foreign_ok ? "rejected" : "accepted");
+    std::printf("    candump/ASC lines: %s\n", lines_ok ? "ok" : "wrong");
+    return whole_ok && torn_ok && corrupt_ok && foreign_ok && lines_ok;
+}
+
+// Replay and the traffic generator on simulated time: tick() is called whenever the delay it returned runs out,
+// the way the replay task sleeps between frames on the device
+struct ReplayCapture {
+    std::uint64_t now_us = 0;
+    std::uint32_t refuse = 0;  // Sink refusals still to hand out (TX queue full)
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> frames;  // When the sink saw it, recorded offset
+};
+
+bool captureReplay(const CanReplayFrame& frame, void* context) {
+    ReplayCapture& capture = *static_cast<ReplayCapture*>(context);
+    if (capture.refuse > 0) {
+        --capture.refuse;
+        return false;
+    }
+    capture.frames.emplace_back(capture.now_us, frame.offset_us);
+    return true;
+}
+
+std::uint32_t runReplay(CanReplayEngine& engine, ReplayCapture& capture, std::uint64_t now_us, std::uint64_t until_us) {
+    std::uint32_t ticks = 0;
+    while (engine.active() && now_us < until_us) {
+        capture.now_us = now_us;
+        const std::uint64_t wait_us = engine.tick(now_us);
+        ++ticks;
+        if (wait_us == CanReplayEngine::kIdle) {
+            break;
+        }
+        now_us += std::max<std::uint64_t>(wait_us, 1);
+    }
+    return ticks;
+}
+
+// A recording from the flight recorder format (loadLog), then 20k frames with random gaps at 1x, 10x and 50x
+// with the sink refusing the first frames; the generator's three patterns against their bus load
+bool checkReplayTiming() {
+    std::printf("Replay timing (simulated clock)\n");
+    bool ok = true;
+
+    CanLogSegmentHeader header{};
+    header.magic = kCanLogSegmentMagic;
+    header.version = kCanLogVersion;
+    header.record_size = sizeof(CanTraceRecord);
+    header.start_us = 0x1FFFFC000ull;
+    const std::vector<std::uint8_t> segment = buildSegment(header, 3);
+    std::vector<CanReplayFrame> loaded;
+    std::vector<CanReplayFrame> loaded_tx;
+    std::string error;
+    LogBytes bytes{segment};
+    CanLogReader reader(readLogBytes, &bytes);
+    LogBytes bytes_tx{segment};
+    CanLogReader reader_tx(readLogBytes, &bytes_tx);
+    bool load_ok = CanReplayEngine::loadLog(reader, false, loaded, error) &&
+                   CanReplayEngine::loadLog(reader_tx, true, loaded_tx, error) && loaded.size() == 9 &&
+                   loaded_tx.size() == 12;
+    for (std::size_t i = 0; load_ok && i < loaded.size(); ++i) {
+        // RX records are k = 0, 2, 4, 5, 7, 9, ... (every 5 records: RX, TX, 11-bit RX, state, injected RX)
+        const std::uint32_t k = static_cast<std::uint32_t>(i / 3 * 5 + (i % 3) * 2);
+        const CanTraceRecord rec = logRecord(header.start_us, k);
+        load_ok = loaded[i].offset_us == k * 2000 && loaded[i].identifier == rec.identifier &&
+                  loaded[i].length == rec.length && loaded[i].extended == (k % 5 != 2) &&
+                  std::memcmp(loaded[i].data, rec.data, sizeof(rec.data)) == 0;
+    }
+    std::printf("    loadLog: %zu RX frames, %zu with TX, offsets across the esp_timer wrap %s\n", loaded.size(),
+                loaded_tx.size(), load_ok ? "ok" : "wrong");
+    ok &= load_ok;
+
+    constexpr std::uint32_t kFrames = 20000;
+    constexpr std::uint32_t kRefusals = 3;
+    constexpr std::uint64_t kStartUs = 1000;
+    BenchRandom rng{0x5EED};
+    std::vector<CanReplayFrame> recording(kFrames);
+    std::uint32_t offset = 0;
+    for (std::uint32_t i = 0; i < kFrames; ++i) {
+        recording[i].offset_us = offset;
+        recording[i].identifier = i;
+        offset += rng.below(8) == 0 ? 0 : 100 + rng.below(900);  // Some back-to-back, the rest 0.1-1 ms apart
+    }
+
+    for (float speed : {1.0f, 10.0f, 50.0f}) {
+        CanReplayEngine engine;
+        ReplayCapture capture;
+        capture.refuse = kRefusals;
+        engine.setSink(captureReplay, &capture);
+        CanReplayOptions options;
+        options.speed = speed;
+        if (!engine.startReplay(recording, options, kStartUs, error)) {
+            std::printf("    %4.0fx: %s\n", speed, error.c_str());
+            ok = false;
+            continue;
+        }
+        const std::uint32_t ticks = runReplay(engine, capture, kStartUs, UINT64_MAX);
+        const CanReplayEngine::Status status = engine.status();
+
+        // Never early; on time to the microsecond except the refused first frame and the burst behind it
+        bool in_order = capture.frames.size() == kFrames;
+        std::uint32_t early = 0;
+        double max_late_us = 0.0;
+        double max_late_after_retry_us = 0.0;
+        for (std::size_t i = 0; in_order && i < capture.frames.size(); ++i) {
+            in_order = capture.frames[i].second == recording[i].offset_us;
+            const double due_us = kStartUs + capture.frames[i].second / speed;
+            const double late_us = static_cast<double>(capture.frames[i].first) - due_us;
+            early += late_us < -1.0 ? 1 : 0;
+            max_late_us = std::max(max_late_us, late_us);
+            if (due_us > kStartUs + kRefusals * CanReplayEngine::kRetryUs) {
+                max_late_after_retry_us = std::max(max_late_after_retry_us, late_us);
+            }
+        }
+        const bool speed_ok = in_order && early == 0 && max_late_after_retry_us <= 1.0 &&
+                              max_late_us <= kRefusals * CanReplayEngine::kRetryUs + 1.0 &&
+                              status.sent == kFrames && status.rejected == kRefusals && !engine.active();
+        std::printf("    %4.0fx: %u frames in %u ticks, %u refused and retried, max late %6.1f us (%4.1f us after "
+                    "the retries), %u early: %s\n",
+                    speed, status.sent, ticks, status.rejected, max_late_us, max_late_after_retry_us, early,
+                    speed_ok ? "ok" : "wrong");
+        ok &= speed_ok;
+    }
+
+    {
+        CanReplayEngine engine;
+        ReplayCapture capture;
+        engine.setSink(captureReplay, &capture);
+        CanReplayOptions options;
+        options.loop = true;
+        std::vector<CanReplayFrame> short_recording(recording.begin(), recording.begin() + 100);
+        engine.startReplay(short_recording, options, 0, error);
+        runReplay(engine, capture, 0, 3 * (short_recording.back().offset_us + 1));
+        const CanReplayEngine::Status status = engine.status();
+        const bool loop_ok = engine.active() && status.loops >= 2 && capture.frames.size() >= 200;
+        engine.stop();
+        std::printf("    loop: %u passes, %zu frames: %s\n", status.loops, capture.frames.size(),
+                    loop_ok ? "ok" : "wrong");
+        ok &= loop_ok;
+    }
+
+    // 10 s of generator time at 50x; bus share from the frames emitted at 250 kbps
+    const struct {
+        const char* name;
+        CanTrafficProfile::Pattern pattern;
+        float expected_percent;  // RAMP averages half the target, BURST the duty share of it
+    } kPatterns[] = {
+        {"constant", CanTrafficProfile::Pattern::CONSTANT, 40.0f},
+        {"ramp", CanTrafficProfile::Pattern::RAMP, 20.0f},
+        {"burst", CanTrafficProfile::Pattern::BURST, 8.0f},
+    };
+    for (const auto& entry : kPatterns) {
+        CanReplayEngine engine;
+        ReplayCapture capture;
+        engine.setSink(captureReplay, &capture);
+        CanReplayOptions options;
+        options.speed = 50.0f;
+        CanTrafficProfile profile;
+        profile.pattern = entry.pattern;
+        profile.load_percent = 40.0f;
+        profile.period_ms = 1000;
+        profile.duty_percent = 20;
+        engine.startGenerator(profile, options, 0, error);
+        runReplay(engine, capture, 0, 200000);
+        const float load_percent = 100.0f * capture.frames.size() * canExtendedFrameBits(profile.length) /
+                                   (10.0f * profile.bitrate);
+        const bool load_ok = std::fabs(load_percent - entry.expected_percent) <= entry.expected_percent * 0.05f;
+        std::printf("    generator %-8s: %5zu frames, %4.1f%% bus load (%4.1f%% expected): %s\n", entry.name,
+                    capture.frames.size(), load_percent, entry.expected_percent, load_ok ? "ok" : "wrong");
+        ok &= load_ok;
+    }
+    return ok;
+}
+
+// Listen-only probe on a 500 kbps bus with traffic: cold (configured 250 kbps first) and warm (last lock first)
+bool benchAutoBaud() {
+    std::printf("Auto-baud (bus at %u bps, frame every %u ms)\n", kForeignBitrate, kForeignPeriodMs);
+    VirtualCanBus bus(kForeignBitrate);
+    VirtualCanBus::Node& ecu = bus.addNode("ecu");
+    VirtualCanBus::Node& gateway = bus.addNode("gateway");  // Acknowledges; the probe never does
+    VirtualCanBus::Node& probe = bus.addNode("probe");
+    CanDriverConfig config;
+    config.bitrate = kForeignBitrate;
+    if (!ecu.install(config) || !ecu.start() || !gateway.install(config) || !gateway.start()) {
+        std::printf("    bus nodes failed to start\n");
+        return false;
+    }
+
+    std::atomic<bool> running{true};
+    std::thread sender([&]() {
+        CanFrame frame;
+        frame.identifier = 0x0CF00400;
+        frame.length = 8;
+        while (running.load()) {
+            ecu.transmit(frame, 10);
+            canDelayMs(kForeignPeriodMs);
+        }
+    });
+
+    bool ok = true;
+    const std::uint32_t preferred[] = {250000, kForeignBitrate};
+    for (std::uint32_t rate : preferred) {
+        const VirtualCanBus::Stats before = bus.stats();
+        CanAutoBaudOptions options;
+        options.preferred_bitrate = rate;
+        CanAutoBaudResult result;
+        CanAutoBaud::detect(probe, CanDriverConfig{}, options, result);
+        const VirtualCanBus::Stats after = bus.stats();
+        std::printf("    preferred %7u: %s %u bps in %u ms, %u probes (%u rejected), %u error frames on the bus\n",
+                    rate, result.locked ? "locked" : "no lock", result.bitrate, result.elapsed_ms, result.probes,
+                    result.rejected, after.error_frames - before.error_frames);
+        ok &= result.locked && result.bitrate == kForeignBitrate && after.error_frames == before.error_frames;
+    }
+
+    running.store(false);
+    sender.join();
+    return ok;
+}
+
+// A controller with an infinitely fast wire: every transmit() completes at once, so TX runs at CPU speed
+class SinkCanDriver : public CanDriver {
+public:
+    const char* name() const override { return "sink"; }
+    bool install(const CanDriverConfig&) override { return true; }
+    void uninstall() override {}
+    bool start() override { return true; }
+    void stop() override {}
+    int transmit(const CanFrame&, std::uint32_t) override {
+        transmitted_.fetch_add(1, std::memory_order_release);
+        return kCanDriverOk;
+    }
+    bool receive(CanFrame&, std::uint32_t timeout_ms) override {
+        canDelayMs(std::min<std::uint32_t>(timeout_ms, 10));
+        return false;
+    }
+    bool readAlerts(std::uint32_t& alerts, std::uint32_t timeout_ms) override {
+        const std::uint32_t transmitted = transmitted_.load(std::memory_order_acquire);
+        if (transmitted == reported_) {
+            canDelayMs(std::min<std::uint32_t>(timeout_ms, 1));
+            return false;
+        }
+        reported_ = transmitted;
+        alerts = kCanAlertTxSuccess;
+        return true;
+    }
+    bool getStatus(CanDriverStatus& status) const override {
+        status = CanDriverStatus{};
+        status.state = CanDriverState::RUNNING;
+        return true;
+    }
+    bool initiateRecovery() override { return false; }
+
+    std::uint32_t transmitted() const { return transmitted_.load(std::memory_order_acquire); }
+
+private:
+    std::atomic<std::uint32_t> transmitted_{0};
+    std::uint32_t reported_ = 0;  // Alert task only
+};
+
+struct TxPathCost {
+    double enqueue_ns = 0;  // One accepted enqueueTx() call
+    double frame_ns = 0;    // enqueueTx through the scheduler's transmitNow(), frames back to back
+};
+
+// The TX path CAN_TRACE_LEVEL compiles trace records into, on a sink controller so the wire never limits it.
+// Comparing levels takes two builds (native_trace_off has CAN_TRACE_LEVEL 0): --tx-cost-out saves this
+// build's cost and --tx-cost-baseline fails this build if it costs more than kTraceCostBoundNs per frame over
+// a saved one. The bound is against the wire, not zero: the Serial.printf path the trace replaced cost
+// milliseconds per frame
+bool benchTxPathCost(CanManager& can, const char* out_path, const char* baseline_path) {
+    using Clock = std::chrono::steady_clock;
+    std::printf("TX path cost, CAN_TRACE_LEVEL %d (%u frames, best of %u runs)\n", CAN_TRACE_LEVEL, kTxCostFrames,
+                kTxCostRuns);
+    SinkCanDriver sink;
+    can.setDriver(&sink);
+    if (!can.begin(CanManager::DEFAULT_TX_PIN, CanManager::DEFAULT_RX_PIN, kBitrate)) {
+        return false;
+    }
+
+    TxPathCost cost;
+    for (std::uint32_t run = 0; run < kTxCostRuns; ++run) {
+        const std::uint32_t base = sink.transmitted();
+        double enqueue_ns = 0;
+        std::uint32_t queued = 0;
+        const Clock::time_point start = Clock::now();
+        while (queued < kTxCostFrames) {
+            // Half a queue at a time, so no call takes the queue-full path (which records a TX_REJECT)
+            while (can.txStats().queue_depth > CanTxQueue::kCapacity / 2) {
+                std::this_thread::yield();
+            }
+            for (std::size_t i = 0; i < CanTxQueue::kCapacity / 2 && queued < kTxCostFrames; ++i) {
+                CanTxRequest request;
+                request.identifier = 0x18FF5480;
+                request.length = 8;
+                std::memcpy(request.data, &queued, sizeof(queued));
+                const Clock::time_point call = Clock::now();
+                if (!can.enqueueTx(request)) {
+                    break;
+                }
+                enqueue_ns += std::chrono::duration<double, std::nano>(Clock::now() - call).count();
+                ++queued;
+            }
+        }
+        while (sink.transmitted() - base < kTxCostFrames) {
+            std::this_thread::yield();
+        }
+        const double frame_ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / kTxCostFrames;
+        enqueue_ns /= kTxCostFrames;
+        cost.enqueue_ns = run == 0 ? enqueue_ns : std::min(cost.enqueue_ns, enqueue_ns);
+        cost.frame_ns = run == 0 ? frame_ns : std::min(cost.frame_ns, frame_ns);
+    }
+    can.stop();
+    std::printf("    enqueueTx %.0f ns per call, %.0f ns per frame through transmitNow\n", cost.enqueue_ns,
+                cost.frame_ns);
+
+    if (out_path) {
+        FILE* file = std::fopen(out_path, "w");
+        if (!file || std::fprintf(file, "%d %.1f %.1f\n", CAN_TRACE_LEVEL, cost.enqueue_ns, cost.frame_ns) < 0) {
+            std::printf("    cannot write %s\n", out_path);
+            if (file) {
+                std::fclose(file);
+            }
+            return false;
+        }
+        std::fclose(file);
+    }
+    if (!baseline_path) {
+        return true;
+    }
+    FILE* file = std::fopen(baseline_path, "r");
+    int level = 0;
+    TxPathCost baseline;
+    const bool read = file && std::fscanf(file, "%d %lf %lf", &level, &baseline.enqueue_ns, &baseline.frame_ns) == 3;
+    if (file) {
+        std::fclose(file);
+    }
+    if (!read) {
+        std::printf("    cannot read baseline %s\n", baseline_path);
+        return false;
+    }
+    const double delta = cost.frame_ns - baseline.frame_ns;
+    std::printf("    vs CAN_TRACE_LEVEL %d: enqueueTx %+.0f ns, %+.0f ns per frame (bound %.0f ns)\n", level,
+                cost.enqueue_ns - baseline.enqueue_ns, delta, kTraceCostBoundNs);
+    return delta <= kTraceCostBoundNs;
+}
+}
+
+int main(int argc, char** argv) {
+    const char* tx_cost_out = nullptr;
+    const char* tx_cost_baseline = nullptr;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--tx-cost-out") == 0) {
+            tx_cost_out = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--tx-cost-baseline") == 0) {
+            tx_cost_baseline = argv[i + 1];
+        }
+    }
+
+    canSetClock(virtualMicros);
+    bool ok = checkSequenceTiming();
+    ok &= simulatePeriodicLoad();
+    ok &= checkTransportConformance();
+    ok &= checkAddressClaim();
+    ok &= checkFilterCoverage();
+    ok &= benchSignalDecoder();
+    ok &= checkLogRoundTrip();
+    ok &= checkReplayTiming();
+    canSetClock(nullptr);
+
+    VirtualCanBus bus(kBitrate);
+    VirtualCanBus::Node& panel = bus.addNode("virtual");
+    VirtualCanBus::Node& peer = bus.addNode("peer");
+
+    CanDriverConfig peer_config;
+    peer_config.bitrate = kBitrate;
+    peer_config.rx_queue_len = 64;  // The bench reads in bursts; the panel keeps the TWAI default
+    if (!peer.install(peer_config) || !peer.start()) {
+        std::printf("Peer failed to start\n");
+        return 1;
+    }
+
+    CanManager& can = CanManager::instance();
+    can.setDriver(&panel);
+    if (!can.begin(CanManager::DEFAULT_TX_PIN, CanManager::DEFAULT_RX_PIN, kBitrate)) {
+        return 1;
+    }
+    DeviceConfig config;
+    config.j1939.address_claim = false;  // Fixed address; no claim traffic in the measurements
+    can.configureAddressing(config);
+
+    ok &= benchTx(can, bus, peer);
+    ok &= benchEnqueueLatency(can, bus, peer);
+    ok &= benchRx(can, bus, peer);
+    ok &= checkRxStatsProducers(can, peer);
+    ok &= benchRoundTrip(can, peer);
+    ok &= benchPresses(can, peer);
+    ok &= benchCoalescing(can, peer);
+    ok &= benchSequenceOnBus(peer);
+    ok &= benchFilterOnPanel(can, peer);
+    ok &= benchAutoBaud();
+
+    const CanTxStats tx = can.txStats();
+    std::printf("CanManager: %u sent, %u failed, %u rejected (queue full), high water %u\n", tx.sent, tx.failed,
+                tx.rejected, tx.queue_high_water);
+    can.stop();
+    ok &= benchTxPathCost(can, tx_cost_out, tx_cost_baseline);
+    return ok ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,200 @@
+#include "can_latency.h"
+
+#include <algorithm>
+
+namespace {
+constexpr std::uint32_t kSubBuckets = 4;
+constexpr std::uint32_t kMaxExponent = 23;  // Values from 2^24 us share the last bucket
+
+std::uint32_t elapsed(std::uint64_t from_us, std::uint64_t to_us) {
+    if (to_us <= from_us) {
+        return 0;
+    }
+    return static_cast<std::uint32_t>(std::min<std::uint64_t>(to_us - from_us, UINT32_MAX));
+}
+}
+
+std::size_t LatencyHistogram::bucketFor(std::uint32_t value_us) {
+    if (value_us < kSubBuckets) {
+        return value_us;
+    }
+    std::uint32_t exponent = 31 - static_cast<std::uint32_t>(__builtin_clz(value_us));
+    if (exponent > kMaxExponent) {
+        return kBuckets - 1;
+    }
+    const std::uint32_t mantissa = (value_us >> (exponent - 2)) & (kSubBuckets - 1);
+    return kSubBuckets + (exponent - 2) * kSubBuckets + mantissa;
+}
+
+std::uint32_t LatencyHistogram::bucketUpper(std::size_t index) {
+    if (index < kSubBuckets) {
+        return static_cast<std::uint32_t>(index);
+    }
+    const std::uint32_t exponent = static_cast<std::uint32_t>((index - kSubBuckets) / kSubBuckets) + 2;
+    const std::uint32_t mantissa = static_cast<std::uint32_t>((index - kSubBuckets) % kSubBuckets);
+    return ((kSubBuckets + mantissa + 1) << (exponent - 2)) - 1;
+}
+
+void LatencyHistogram::record(std::uint32_t value_us) {
+    ++buckets_[bucketFor(value_us)];
+    ++count_;
+    max_ = std::max(max_, value_us);
+    sum_ += value_us;
+}
+
+void LatencyHistogram::reset() {
+    buckets_.fill(0);
+    count_ = 0;
+    max_ = 0;
+    sum_ = 0;
+}
+
+std::uint32_t LatencyHistogram::percentile(float fraction) const {
+    if (!count_) {
+        return 0;
+    }
+    // Rank of the sample at `fraction`, 1-based, so p50 of two samples is the first
+    const std::uint32_t rank = std::max<std::uint32_t>(1, static_cast<std::uint32_t>(fraction * count_ + 0.999f));
+    std::uint32_t seen = 0;
+    for (std::size_t i = 0; i < kBuckets; ++i) {
+        seen += buckets_[i];
+        if (seen >= rank) {
+            return std::min(bucketUpper(i), max_);
+        }
+    }
+    return max_;
+}
+
+CanLatencyTracer& CanLatencyTracer::instance() {
+    static CanLatencyTracer tracer;
+    return tracer;
+}
+
+const char* CanLatencyTracer::stageName(CanLatencyStage stage) {
+    switch (stage) {
+        case CanLatencyStage::TOUCH_TO_EVENT: return "touch_to_event";
+        case CanLatencyStage::EVENT_TO_ENQUEUE: return "event_to_enqueue";
+        case CanLatencyStage::ENQUEUE_TO_DRIVER: return "enqueue_to_driver";
+        case CanLatencyStage::DRIVER_TO_WIRE: return "driver_to_wire";
+        case CanLatencyStage::PRESS_TO_WIRE: return "press_to_wire";
+        default: return "unknown";
+    }
+}
+
+std::uint16_t CanLatencyTracer::beginPress(std::uint64_t now_us) {
+    const std::uint32_t touch = touch_us_.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Reuse the oldest slot; a press still pending there never made it to the wire
+    Pending* slot = &pending_[0];
+    for (Pending& pending : pending_) {
+        if (!pending.id) {
+            slot = &pending;
+            break;
+        }
+        if (pending.event_us < slot->event_us) {
+            slot = &pending;
+        }
+    }
+    if (slot->id) {
+        ++abandoned_;
+    }
+
+    *slot = Pending{};
+    slot->id = next_id_;
+    next_id_ = next_id_ == UINT16_MAX ? 1 : next_id_ + 1;
+    slot->event_us = now_us;
+    // The edge belongs to this press only if it is recent and no earlier press took it
+    const std::uint32_t touch_age = static_cast<std::uint32_t>(now_us) - touch;
+    if (touch != consumed_touch_us_ && touch_age <= kTouchWindowUs) {
+        slot->touch_us = now_us - touch_age;
+        consumed_touch_us_ = touch;
+        record(CanLatencyStage::TOUCH_TO_EVENT, slot->touch_us, now_us);
+    }
+    ++presses_;
+    return slot->id;
+}
+
+void CanLatencyTracer::enqueued(std::uint16_t id, std::uint64_t now_us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (Pending* pending = find(id)) {
+        pending->enqueue_us = now_us;
+        record(CanLatencyStage::EVENT_TO_ENQUEUE, pending->event_us, now_us);
+    }
+}
+
+void CanLatencyTracer::handedToDriver(std::uint16_t id, std::uint64_t now_us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (Pending* pending = find(id)) {
+        pending->driver_us = now_us;
+        record(CanLatencyStage::ENQUEUE_TO_DRIVER, pending->enqueue_us, now_us);
+    }
+}
+
+void CanLatencyTracer::completed(std::uint16_t id, std::uint64_t now_us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Pending* pending = find(id);
+    if (!pending || !pending->driver_us) {
+        return;
+    }
+    record(CanLatencyStage::DRIVER_TO_WIRE, pending->driver_us, now_us);
+    record(CanLatencyStage::PRESS_TO_WIRE, pending->touch_us ? pending->touch_us : pending->event_us, now_us);
+    ++completed_;
+    pending->id = 0;
+}
+
+void CanLatencyTracer::abandon(std::uint16_t id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (Pending* pending = find(id)) {
+        pending->id = 0;
+        ++abandoned_;
+    }
+}
+
+CanLatencySnapshot CanLatencyTracer::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    CanLatencySnapshot snap;
+    for (std::size_t i = 0; i < histograms_.size(); ++i) {
+        const LatencyHistogram& histogram = histograms_[i];
+        CanLatencySnapshot::Stage& stage = snap.stages[i];
+        stage.count = histogram.count();
+        stage.p50_us = histogram.percentile(0.50f);
+        stage.p99_us = histogram.percentile(0.99f);
+        stage.max_us = histogram.max();
+        stage.mean_us = histogram.mean();
+    }
+    snap.presses = presses_;
+    snap.completed = completed_;
+    snap.abandoned = abandoned_;
+    snap.last = last_;
+    return snap;
+}
+
+void CanLatencyTracer::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (LatencyHistogram& histogram : histograms_) {
+        histogram.reset();
+    }
+    last_.fill(0);
+    presses_ = 0;
+    completed_ = 0;
+    abandoned_ = 0;
+}
+
+CanLatencyTracer::Pending* CanLatencyTracer::find(std::uint16_t id) {
+    if (!id) {
+        return nullptr;
+    }
+    for (Pending& pending : pending_) {
+        if (pending.id == id) {
+            return &pending;
+        }
+    }
+    return nullptr;
+}
+
+void CanLatencyTracer::record(CanLatencyStage stage, std::uint64_t from_us, std::uint64_t to_us) {
+    const std::uint32_t value = elapsed(from_us, to_us);
+    histograms_[static_cast<std::size_t>(stage)].record(value);
+    last_[static_cast<std::size_t>(stage)] = value;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+enum class CanLatencyStage : std::uint8_t {
+    TOUCH_TO_EVENT,     // Touch read that saw the finger land/lift -> LVGL event handler
+    EVENT_TO_ENQUEUE,   // Event handler -> TX queue accepted the frame
+    ENQUEUE_TO_DRIVER,  // TX queue -> frame handed to the controller
+    DRIVER_TO_WIRE,     // Controller queue -> TX-complete alert
+    PRESS_TO_WIRE,      // Touch read (or the event, without one) -> TX-complete alert
+    COUNT
+};
+
+/**
+ * Log-linear latency histogram: exact below 4 us, then four buckets per
+ * power of two (at most 25% wide), saturating at about 16.7 s. Percentiles
+ * report the bucket's upper edge, clamped to the largest sample.
+ */
+class LatencyHistogram {
+public:
+    static constexpr std::size_t kBuckets = 92;
+
+    void record(std::uint32_t value_us);
+    void reset();
+
+    std::uint32_t count() const { return count_; }
+    std::uint32_t max() const { return max_; }
+    std::uint32_t mean() const { return count_ ? static_cast<std::uint32_t>(sum_ / count_) : 0; }
+    std::uint32_t percentile(float fraction) const;
+
+    static std::size_t bucketFor(std::uint32_t value_us);
+    static std::uint32_t bucketUpper(std::size_t index);
+
+private:
+    std::array<std::uint32_t, kBuckets> buckets_{};
+    std::uint32_t count_ = 0;
+    std::uint32_t max_ = 0;
+    std::uint64_t sum_ = 0;
+};
+
+struct CanLatencySnapshot {
+    struct Stage {
+        std::uint32_t count = 0;
+        std::uint32_t p50_us = 0;
+        std::uint32_t p99_us = 0;
+        std::uint32_t max_us = 0;
+        std::uint32_t mean_us = 0;
+    };
+    std::array<Stage, static_cast<std::size_t>(CanLatencyStage::COUNT)> stages{};
+    std::uint32_t presses = 0;     // Presses that started a trace
+    std::uint32_t completed = 0;   // Reached the TX-complete alert
+    std::uint32_t abandoned = 0;   // No frame, rejected, failed on the wire, or evicted while pending
+    std::array<std::uint32_t, static_cast<std::size_t>(CanLatencyStage::COUNT)> last{};  // Most recent press, us
+};
+
+/**
+ * Press-to-wire latency for action buttons.
+ *
+ * A press is stamped where it crosses each layer: the touch read that saw
+ * the edge (lvgl_port_tp_read), the LVGL event that handled it
+ * (actionButtonEvent), the TX queue accepting its frame, the TX task
+ * handing it to the controller, and the controller's TX-complete alert.
+ * The press id rides along in CanTxRequest::trace_id. Presses are rare, so
+ * everything but touchEdge() takes a mutex; touchEdge() runs on every touch
+ * read and only stores a word.
+ */
+class CanLatencyTracer {
+public:
+    static constexpr std::size_t kMaxPending = 8;
+    static constexpr std::uint64_t kTouchWindowUs = 250000;  // An older touch edge is not this press
+
+    static CanLatencyTracer& instance();
+    static const char* stageName(CanLatencyStage stage);
+
+    void touchEdge(std::uint64_t now_us) {
+        touch_us_.store(static_cast<std::uint32_t>(now_us), std::memory_order_relaxed);
+    }
+
+    // Returns the press id for CanTxRequest::trace_id (never 0)
+    std::uint16_t beginPress(std::uint64_t now_us);
+    void enqueued(std::uint16_t id, std::uint64_t now_us);
+    void handedToDriver(std::uint16_t id, std::uint64_t now_us);
+    void completed(std::uint16_t id, std::uint64_t now_us);
+    // The press produced no frame on the wire; id 0 is ignored
+    void abandon(std::uint16_t id);
+
+    CanLatencySnapshot snapshot() const;
+    void reset();
+
+private:
+    struct Pending {
+        std::uint16_t id = 0;  // 0 = free
+        std::uint64_t touch_us = 0;
+        std::uint64_t event_us = 0;
+        std::uint64_t enqueue_us = 0;
+        std::uint64_t driver_us = 0;
+    };
+
+    CanLatencyTracer() = default;
+
+    Pending* find(std::uint16_t id);
+    void record(CanLatencyStage stage, std::uint64_t from_us, std::uint64_t to_us);
+
+    std::atomic<std::uint32_t> touch_us_{0};  // Low word: a 32-bit atomic stays lock-free on the ESP32
+    mutable std::mutex mutex_;
+    std::uint32_t consumed_touch_us_ = 0;
+    std::uint16_t next_id_ = 1;
+    std::array<Pending, kMaxPending> pending_{};
+    std::array<LatencyHistogram, static_cast<std::size_t>(CanLatencyStage::COUNT)> histograms_{};
+    std::array<std::uint32_t, static_cast<std::size_t>(CanLatencyStage::COUNT)> last_{};
+    std::uint32_t presses_ = 0;
+    std::uint32_t completed_ = 0;
+    std::uint32_t abandoned_ = 0;
+};
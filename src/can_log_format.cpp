@@ -0,0 +1,161 @@
+#include "can_log_format.h"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+
+namespace {
+bool isFrame(const CanTraceRecord& rec) {
+    return rec.event == static_cast<std::uint8_t>(CanTraceEvent::RX) ||
+           rec.event == static_cast<std::uint8_t>(CanTraceEvent::TX);
+}
+
+bool isStandard(const CanTraceRecord& rec) {
+    return (rec.arg & kCanTraceStandardFrame) != 0;
+}
+
+// snprintf that keeps a running offset and never runs past the end
+void append(char* buffer, std::size_t size, std::size_t& pos, const char* fmt, ...) __attribute__((format(printf, 4, 5)));
+void append(char* buffer, std::size_t size, std::size_t& pos, const char* fmt, ...) {
+    if (pos >= size) {
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    const int written = std::vsnprintf(buffer + pos, size - pos, fmt, args);
+    va_end(args);
+    if (written > 0) {
+        pos = std::min(size, pos + static_cast<std::size_t>(written));
+    }
+}
+}
+
+std::uint32_t canLogCrc32(const std::uint8_t* data, std::size_t length, std::uint32_t crc) {
+    crc = ~crc;
+    for (std::size_t i = 0; i < length; ++i) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+bool CanLogReader::readExact(std::uint8_t* buffer, std::size_t length) {
+    std::size_t total = 0;
+    while (total < length) {
+        const std::size_t got = source_(context_, buffer + total, length - total);
+        if (got == 0) {
+            return false;
+        }
+        total += got;
+    }
+    return true;
+}
+
+bool CanLogReader::loadBlock() {
+    CanLogBlockHeader block{};
+    std::uint8_t* raw = reinterpret_cast<std::uint8_t*>(&block);
+    const std::size_t got = source_(context_, raw, sizeof(block));
+    if (got == 0) {
+        state_ = State::DONE;
+        return false;
+    }
+    if ((got < sizeof(block) && !readExact(raw + got, sizeof(block) - got)) || block.magic != kCanLogBlockMagic ||
+        block.count == 0 || block.count > kCanLogRecordsPerBlock) {
+        state_ = State::TORN;
+        return false;
+    }
+
+    block_.resize(block.count);
+    std::uint8_t* records = reinterpret_cast<std::uint8_t*>(block_.data());
+    const std::size_t bytes = block.count * sizeof(CanTraceRecord);
+    if (!readExact(records, bytes) || canLogCrc32(records, bytes) != block.crc) {
+        state_ = State::TORN;
+        return false;
+    }
+    dropped_ += block.dropped;
+    position_ = 0;
+    return true;
+}
+
+bool CanLogReader::next(CanLogEntry& out) {
+    if (state_ == State::START) {
+        if (!readExact(reinterpret_cast<std::uint8_t*>(&header_), sizeof(header_)) ||
+            header_.magic != kCanLogSegmentMagic || header_.record_size != sizeof(CanTraceRecord)) {
+            state_ = State::BAD_HEADER;
+            return false;
+        }
+        last_us_ = header_.start_us;
+        state_ = State::BLOCKS;
+    }
+
+    while (state_ == State::BLOCKS) {
+        if (position_ < block_.size()) {
+            out.record = block_[position_++];
+            // Records carry the low 32 bits of esp_timer; unwrap against the previous one
+            const std::int32_t delta = static_cast<std::int32_t>(out.record.timestamp_us - static_cast<std::uint32_t>(last_us_));
+            last_us_ += delta;
+            out.time_us = header_.start_unix_us ? header_.start_unix_us + (last_us_ - header_.start_us) : last_us_;
+            return true;
+        }
+        loadBlock();
+    }
+    return false;
+}
+
+std::size_t canLogFormatCandump(const CanLogEntry& entry, const char* interface, char* buffer, std::size_t size) {
+    const CanTraceRecord& rec = entry.record;
+    if (!isFrame(rec) || size == 0) {
+        return 0;
+    }
+    std::size_t pos = 0;
+    append(buffer, size, pos, "(%llu.%06llu) %s ", static_cast<unsigned long long>(entry.time_us / 1000000),
+           static_cast<unsigned long long>(entry.time_us % 1000000), interface);
+    if (isStandard(rec)) {
+        append(buffer, size, pos, "%03lX#", static_cast<unsigned long>(rec.identifier & 0x7FF));
+    } else {
+        append(buffer, size, pos, "%08lX#", static_cast<unsigned long>(rec.identifier & 0x1FFFFFFF));
+    }
+    for (std::uint8_t i = 0; i < rec.length && i < 8; ++i) {
+        append(buffer, size, pos, "%02X", rec.data[i]);
+    }
+    append(buffer, size, pos, "\n");
+    return pos;
+}
+
+std::size_t canLogFormatAsc(const CanLogEntry& entry, std::uint64_t base_us, char* buffer, std::size_t size) {
+    const CanTraceRecord& rec = entry.record;
+    if (!isFrame(rec) || size == 0) {
+        return 0;
+    }
+    const std::uint64_t relative = entry.time_us - base_us;
+    const bool tx = rec.event == static_cast<std::uint8_t>(CanTraceEvent::TX);
+    std::size_t pos = 0;
+    append(buffer, size, pos, "%7llu.%06llu 1  ", static_cast<unsigned long long>(relative / 1000000),
+           static_cast<unsigned long long>(relative % 1000000));
+    if (isStandard(rec)) {
+        append(buffer, size, pos, "%-15lX", static_cast<unsigned long>(rec.identifier & 0x7FF));
+    } else {
+        append(buffer, size, pos, "%lXx%-6s", static_cast<unsigned long>(rec.identifier & 0x1FFFFFFF), "");
+    }
+    append(buffer, size, pos, " %s   d %u", tx ? "Tx" : "Rx", rec.length);
+    for (std::uint8_t i = 0; i < rec.length && i < 8; ++i) {
+        append(buffer, size, pos, " %02X", rec.data[i]);
+    }
+    append(buffer, size, pos, "\n");
+    return pos;
+}
+
+std::size_t canLogAscHeader(char* buffer, std::size_t size) {
+    std::size_t pos = 0;
+    append(buffer, size, pos, "date Thu Jan 1 00:00:00.000 1970\nbase hex  timestamps absolute\n"
+                              "no internal events logged\nBegin Triggerblock\n");
+    return pos;
+}
+
+std::size_t canLogAscFooter(char* buffer, std::size_t size) {
+    std::size_t pos = 0;
+    append(buffer, size, pos, "End TriggerBlock\n");
+    return pos;
+}
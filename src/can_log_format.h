@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "can_trace.h"
+
+// Flight recorder files (/canlog/NNNNNNNN.clg), little-endian, shared with
+// tools/can_log_convert.py. A segment is one header followed by blocks; each
+// block carries its own CRC so a block torn by a reset is detected and
+// everything before it is still readable.
+struct CanLogSegmentHeader {
+    std::uint32_t magic;          // kCanLogSegmentMagic
+    std::uint16_t version;
+    std::uint16_t record_size;    // sizeof(CanTraceRecord)
+    std::uint32_t segment;        // File sequence number
+    std::uint32_t reserved;
+    std::uint64_t start_us;       // esp_timer time when the segment was opened
+    std::uint64_t start_unix_us;  // Wall clock at the same instant, 0 when unknown
+};
+static_assert(sizeof(CanLogSegmentHeader) == 32, "CanLogSegmentHeader is part of the file format");
+
+struct CanLogBlockHeader {
+    std::uint32_t magic;     // kCanLogBlockMagic
+    std::uint32_t sequence;  // Increments per block across segments
+    std::uint16_t count;     // Records that follow
+    std::uint16_t reserved;
+    std::uint32_t dropped;   // Records lost before this block (trace overrun or full pool)
+    std::uint32_t crc;       // CRC-32 (zlib) of the records
+};
+static_assert(sizeof(CanLogBlockHeader) == 20, "CanLogBlockHeader is part of the file format");
+
+constexpr std::uint32_t kCanLogSegmentMagic = 0x474F4C43;  // "CLOG"
+constexpr std::uint32_t kCanLogBlockMagic = 0x4B4C4243;    // "CBLK"
+constexpr std::uint16_t kCanLogVersion = 1;
+constexpr std::size_t kCanLogBlockBytes = 4096;
+constexpr std::size_t kCanLogRecordsPerBlock =
+    (kCanLogBlockBytes - sizeof(CanLogBlockHeader)) / sizeof(CanTraceRecord);
+
+// Frame record flags in CanTraceRecord::arg
+constexpr std::uint16_t kCanTraceStandardFrame = 0x0001;  // 11-bit identifier
+constexpr std::uint16_t kCanTraceVirtualFrame = 0x0002;   // Injected by replay/generator, never on the wire
+
+std::uint32_t canLogCrc32(const std::uint8_t* data, std::size_t length, std::uint32_t crc = 0);
+
+struct CanLogEntry {
+    CanTraceRecord record;
+    std::uint64_t time_us = 0;  // Unwrapped; Unix time when the segment knew it, else time since boot
+};
+
+/**
+ * Sequential reader for one segment. Pulls bytes through a caller-supplied
+ * source so the same code serves LittleFS files, HTTP streams and host tests.
+ * Stops at the end of the data or at the first block that fails its CRC.
+ */
+class CanLogReader {
+public:
+    using Source = std::size_t (*)(void* context, std::uint8_t* buffer, std::size_t length);
+
+    CanLogReader(Source source, void* context) : source_(source), context_(context) {}
+
+    bool next(CanLogEntry& out);
+
+    bool valid() const { return state_ != State::BAD_HEADER; }
+    bool truncated() const { return state_ == State::TORN; }
+    std::uint32_t dropped() const { return dropped_; }
+    const CanLogSegmentHeader& header() const { return header_; }
+
+private:
+    enum class State : std::uint8_t { START, BLOCKS, DONE, TORN, BAD_HEADER };
+
+    bool readExact(std::uint8_t* buffer, std::size_t length);
+    bool loadBlock();
+
+    Source source_;
+    void* context_;
+    State state_ = State::START;
+    CanLogSegmentHeader header_{};
+    std::vector<CanTraceRecord> block_;
+    std::size_t position_ = 0;
+    std::uint64_t last_us_ = 0;
+    std::uint32_t dropped_ = 0;
+};
+
+// Text renderings of frame records; return 0 for records that have no line (state events)
+std::size_t canLogFormatCandump(const CanLogEntry& entry, const char* interface, char* buffer, std::size_t size);
+std::size_t canLogFormatAsc(const CanLogEntry& entry, std::uint64_t base_us, char* buffer, std::size_t size);
+std::size_t canLogAscHeader(char* buffer, std::size_t size);
+std::size_t canLogAscFooter(char* buffer, std::size_t size);
@@ -1,77 +1,166 @@
 #include "can_manager.h"
 
-#include <driver/twai.h>
-#include <freertos/FreeRTOS.h>
-#include <Wire.h>
-
 #include <algorithm>
-
-// CH422G I2C configuration for CAN transceiver power
-// NOTE: CH422G uses REGISTER addresses as I2C device addresses (unique protocol)
-#define CH422G_REG_WR_IO    0x38  // Output control register I2C address
-#define CH422G_USB_SEL_HIGH 0x2A  // USB_SEL (bit 5) = HIGH, enables CAN transceiver
-#define I2C_SDA_PIN         8
-#define I2C_SCL_PIN         9
+#include <cstdio>
+#include <cstring>
+
+#ifdef ARDUINO
+#include <LittleFS.h>
+#endif
+
+#include "can_driver_twai.h"
+#include "can_log_format.h"
+#include "can_module_status.h"
+#include "can_periodic.h"
+#include "can_recorder.h"
+#include "can_sequence.h"
+#include "can_signal_db.h"
+#include "can_trace.h"
 
 CanManager& CanManager::instance() {
     static CanManager manager;
     return manager;
 }
 
-bool CanManager::begin(gpio_num_t tx_pin, gpio_num_t rx_pin, std::uint32_t bitrate) {
+CanManager::CanManager() {
+#ifdef ARDUINO
+    driver_ = &TwaiCanDriver::instance();
+#endif
+}
+
+bool CanManager::begin(int tx_pin, int rx_pin, std::uint32_t bitrate) {
     tx_pin_ = tx_pin;
     rx_pin_ = rx_pin;
+    configured_bitrate_ = bitrate;
     bitrate_ = bitrate;
 
-    Serial.printf("[CanManager] Initializing TWAI on TX=GPIO%d, RX=GPIO%d, Bitrate=%lu\n", tx_pin_, rx_pin_, bitrate_);
-
-    // CRITICAL: Enable CAN transceiver via CH422G I2C expander BEFORE starting TWAI
-    // The SN65HVD230 CAN transceiver power is controlled by USB_SEL pin on CH422G
-    // Without this, GPIO19 RX will not receive any CAN messages
-    // NOTE: CH422G has unique I2C protocol - register address IS the I2C device address
-    // I2C is already initialized by panel library - just write directly
-    Serial.println("[CanManager] Enabling CAN transceiver via CH422G...");
-    
-    // Write to CH422G register 0x38 (WR_IO) to set USB_SEL HIGH
-    // beginTransmission takes the REGISTER address, not a device address!
-    Wire.beginTransmission(CH422G_REG_WR_IO);  // 0x38, not 0x24!
-    Wire.write(CH422G_USB_SEL_HIGH);            // 0x2A
-    int i2c_result = Wire.endTransmission();
-    
-    if (i2c_result == 0) {
-        Serial.println("[CanManager] ✓ CAN transceiver enabled (USB_SEL=HIGH)");
-    } else {
-        Serial.printf("[CanManager] ⚠ CH422G I2C write failed (err=%d) - CAN may not work\n", i2c_result);
+    if (!driver_) {
+        CAN_LOGF("[CanManager] No CAN driver set\n");
+        ready_ = false;
+        return false;
     }
-    
-    delay(50); // Give transceiver time to power up
-
-    twai_general_config_t g_config = TWAI_GENERAL_CONFIG_DEFAULT(tx_pin_, rx_pin_, TWAI_MODE_NORMAL);
-    g_config.tx_queue_len = 8;
-    g_config.rx_queue_len = 16;
-    g_config.alerts_enabled = TWAI_ALERT_TX_SUCCESS | TWAI_ALERT_TX_FAILED | TWAI_ALERT_BUS_ERROR | TWAI_ALERT_BUS_OFF | TWAI_ALERT_ERR_PASS;
-
-    if (bitrate_ != 250000) {
-        Serial.println("[CanManager] Unsupported bitrate requested. Falling back to 250 kbps.");
+    if (!canBitrateSupported(bitrate)) {
+        CAN_LOGF("[CanManager] Unsupported bitrate %lu bps (125000, 250000, 500000 or 1000000)\n",
+                 static_cast<unsigned long>(bitrate));
+        ready_ = false;
+        return false;
+    }
+    CAN_LOGF("[CanManager] Initializing %s on TX=GPIO%d, RX=GPIO%d, Bitrate=%lu%s\n", driver_->name(), tx_pin_,
+             rx_pin_, static_cast<unsigned long>(bitrate_), auto_baud_ ? " (auto-baud)" : "");
+
+    CanDriverConfig driver_config;
+    driver_config.tx_pin = tx_pin_;
+    driver_config.rx_pin = rx_pin_;
+    if (auto_baud_) {
+        // A restart re-probes the last locked rate first, so it locks within one dwell on a busy bus
+        CanAutoBaudOptions options;
+        options.preferred_bitrate = auto_baud_result_.locked ? auto_baud_result_.bitrate : bitrate;
+        CanAutoBaudResult result;
+        if (CanAutoBaud::detect(*driver_, driver_config, options, result)) {
+            bitrate_ = result.bitrate;
+        } else {
+            CAN_LOGF("[CanManager] Auto-baud fell back to %lu bps\n", static_cast<unsigned long>(bitrate_));
+        }
+        auto_baud_result_ = result;
+    }
+    driver_config.bitrate = bitrate_;
+    if (filter_enabled_ && filter_plan_.mode != CanFilterPlan::Mode::ACCEPT_ALL) {
+        driver_config.filter = filter_plan_;
+        CAN_LOGF("[CanManager] Acceptance filter %s code=0x%08lX mask=0x%08lX (%u PGN rules)\n",
+                 filter_plan_.mode == CanFilterPlan::Mode::SINGLE ? "single" : "dual",
+                 static_cast<unsigned long>(filter_plan_.acceptance_code),
+                 static_cast<unsigned long>(filter_plan_.acceptance_mask),
+                 static_cast<unsigned>(filter_planner_.ruleCount()));
     }
 
-    const twai_timing_config_t t_config = TWAI_TIMING_CONFIG_250KBITS();
-    const twai_filter_config_t f_config = TWAI_FILTER_CONFIG_ACCEPT_ALL();
+    if (!driver_->install(driver_config)) {
+        CAN_LOGF("[CanManager] Failed to install CAN driver\n");
+        ready_ = false;
+        return false;
+    }
 
-    if (twai_driver_install(&g_config, &t_config, &f_config) != ESP_OK) {
-        Serial.println("[CanManager] Failed to install TWAI driver");
+    if (!driver_->start()) {
+        CAN_LOGF("[CanManager] Failed to start CAN driver\n");
+        driver_->uninstall();
         ready_ = false;
         return false;
     }
 
-    if (twai_start() != ESP_OK) {
-        Serial.println("[CanManager] Failed to start TWAI driver");
+    if (!rx_ring_.init(RX_RING_CAPACITY)) {
+        CAN_LOGF("[CanManager] Failed to allocate RX ring\n");
+        driver_->stop();
+        driver_->uninstall();
         ready_ = false;
         return false;
     }
+    legacy_cursor_ = rx_ring_.openCursor();
+
+    CanTrace::instance().startDrainTask();
+
+    CanSequenceEngine& sequences = CanSequenceEngine::instance();
+    sequences.setSink([](const CanSequenceEngine::Step& step) {
+        CanTxRequest request;
+        request.identifier = step.identifier;
+        request.extended = true;
+        request.length = step.length;
+        memcpy(request.data, step.data, sizeof(request.data));
+        return CanManager::instance().enqueueTx(request);
+    });
+    sequences.startWorker();
+
+    address_claim_.setSink([](std::uint32_t identifier, const std::uint8_t* data, std::uint8_t length) {
+        CanTxRequest request;
+        request.identifier = identifier;
+        request.extended = true;
+        request.fixed_source = true;
+        request.length = length;
+        memcpy(request.data, data, sizeof(request.data));
+        return CanManager::instance().enqueueTx(request);
+    });
+    address_claim_.setRandom([]() -> std::uint32_t { return canRandom(); });
+
+    transport_.begin();
+    transport_.setSink([](std::uint32_t identifier, const std::uint8_t* data, std::uint8_t length) {
+        CanTxRequest request;
+        request.identifier = identifier;
+        request.extended = true;
+        request.length = length;
+        memcpy(request.data, data, sizeof(request.data));
+        return CanManager::instance().enqueueTx(request);
+    });
+
+    CanPeriodicScheduler& periodic = CanPeriodicScheduler::instance();
+    periodic.setSink([](std::uint32_t identifier, const std::uint8_t* data, std::uint8_t length) {
+        CanTxRequest request;
+        request.identifier = identifier;
+        request.extended = true;
+        request.length = length;
+        memcpy(request.data, data, sizeof(request.data));
+        return CanManager::instance().enqueueTx(request);
+    });
+    periodic.start();
+
+    CanModuleStatus::instance().setSink([](std::uint32_t identifier, const std::uint8_t* data, std::uint8_t length) {
+        CanTxRequest request;
+        request.identifier = identifier;
+        request.extended = true;
+        request.length = length;
+        memcpy(request.data, data, sizeof(request.data));
+        return CanManager::instance().enqueueTx(request);
+    });
+
+    button_coalescer_.setSink([](const CanTxRequest& request) { return CanManager::instance().enqueueTx(request); });
+
+    bus_stats_.setBitrate(bitrate_);
 
     ready_ = true;
-    Serial.println("[CanManager] TWAI bus ready at 250 kbps");
+    if (!startRxTask() || !startTxTask() || !startProtoTask() || !startAlertTask()) {
+        CAN_LOGF("[CanManager] Failed to start CAN tasks\n");
+        stop();
+        return false;
+    }
+
+    CAN_LOGF("[CanManager] CAN bus ready at %lu bps\n", static_cast<unsigned long>(bitrate_));
     return true;
 }
 
@@ -79,345 +168,953 @@ void CanManager::stop() {
     if (!ready_) {
         return;
     }
-    twai_stop();
-    twai_driver_uninstall();
-    ready_ = false;
-    Serial.println("[CanManager] TWAI driver stopped");
+    ready_ = false;  // Refuse new TX requests while the tasks wind down
+    replay_.stop();
+    CanPeriodicScheduler::instance().stop();
+    CanSequenceEngine::instance().stopWorker();
+    stopAlertTask();
+    stopProtoTask();
+    stopTxTask();
+    stopRxTask();
+    driver_->stop();
+    driver_->uninstall();
+    clearDriverFifo();
+    button_coalescer_.clear();
+    CAN_LOGF("[CanManager] CAN driver stopped\n");
 }
 
-bool CanManager::sendButtonAction(const ButtonConfig& button) {
+bool CanManager::sendButtonAction(const ButtonConfig& button, uint16_t press_id) {
+    if (!button.sequence.empty()) {
+        CanLatencyTracer::instance().abandon(press_id);  // Sequence frames are paced by the engine, not traced
+        return startSequence(button.sequence);
+    }
     if (!button.can.enabled) {
-        Serial.printf("[CanManager] Button '%s' has no CAN frame assigned\n", button.label.c_str());
+        CanLatencyTracer::instance().abandon(press_id);
+        CAN_LOGF("[CanManager] Button '%s' has no CAN frame assigned\n", button.label.c_str());
         return false;
     }
-    return sendFrame(button.can);
+    return sendButtonFrame(button, button.can, press_id);
 }
 
-bool CanManager::sendButtonReleaseAction(const ButtonConfig& button) {
+bool CanManager::sendButtonReleaseAction(const ButtonConfig& button, uint16_t press_id) {
+    if (!button.sequence_off.empty()) {
+        CanLatencyTracer::instance().abandon(press_id);
+        return startSequence(button.sequence_off);
+    }
     if (!button.can_off.enabled) {
-        Serial.printf("[CanManager] Button '%s' has no CAN OFF frame assigned\n", button.label.c_str());
+        CanLatencyTracer::instance().abandon(press_id);
+        CAN_LOGF("[CanManager] Button '%s' has no CAN OFF frame assigned\n", button.label.c_str());
         return false;
     }
-    return sendFrame(button.can_off);
+    return sendButtonFrame(button, button.can_off, press_id);
 }
 
-bool CanManager::sendFrame(const CanFrameConfig& frame) {
+bool CanManager::sendButtonFrame(const ButtonConfig& button, const CanFrameConfig& frame, uint16_t press_id) {
+    CanLatencyTracer& tracer = CanLatencyTracer::instance();
     if (!ready_) {
-        Serial.println("[CanManager] TWAI bus not initialized");
+        tracer.abandon(press_id);
+        CAN_LOGF("[CanManager] CAN bus not initialized\n");
         return false;
     }
 
-    // Check for bus errors and recover if needed
-    twai_status_info_t status;
-    if (twai_get_status_info(&status) == ESP_OK) {
-        if (status.state == TWAI_STATE_BUS_OFF) {
-            Serial.println("[CanManager] Bus-off detected, initiating recovery");
-            twai_initiate_recovery();
-            vTaskDelay(pdMS_TO_TICKS(100));
-        } else if (status.state == TWAI_STATE_RECOVERING) {
-            Serial.println("[CanManager] Bus is recovering, waiting...");
-            vTaskDelay(pdMS_TO_TICKS(50));
-        }
+    CanTxRequest request = requestFor(frame);
+    request.trace_id = press_id;
+    uint16_t replaced_trace = 0;
+    const CanButtonCoalescer::Decision decision =
+        button_coalescer_.submit(button.id, request, canMillis(), replaced_trace);
+    tracer.abandon(replaced_trace);
+    switch (decision) {
+        case CanButtonCoalescer::Decision::SEND:
+            if (enqueueTx(request)) {
+                return true;
+            }
+            button_coalescer_.forget(button.id, request, canMillis());
+            return false;
+        case CanButtonCoalescer::Decision::DROP:
+            tracer.abandon(press_id);  // The bus already carries this command
+            return true;
+        case CanButtonCoalescer::Decision::DEFER:
+        default:
+            proto_task_.notify();  // Re-plan the protocol task's wait around the held frame
+            return true;
+    }
+}
+
+CanTxRequest CanManager::requestFor(const CanFrameConfig& frame) const {
+    CanTxRequest request;
+    request.identifier = buildIdentifier(frame);
+    request.extended = true;
+    request.length = std::min<uint8_t>(frame.length, 8);  // Use actual data length, not frame.data.size()
+    for (std::size_t i = 0; i < request.length; ++i) {
+        request.data[i] = frame.data[i];
     }
+    return request;
+}
 
-    twai_message_t message = {};
-    message.identifier = buildIdentifier(frame);
-    message.extd = 1;
-    message.data_length_code = frame.length;  // Use actual data length, not frame.data.size()
-    for (std::size_t i = 0; i < frame.length; ++i) {
-        message.data[i] = frame.data[i];
-    }
-
-    // VERBOSE LOGGING: Show exactly what we're sending
-    Serial.printf("[CanManager] TX Frame: ID=0x%08lX, Len=%d, Data=", 
-                  static_cast<unsigned long>(message.identifier), message.data_length_code);
-    for (std::size_t i = 0; i < message.data_length_code; ++i) {
-        Serial.printf("%02X ", message.data[i]);
-    }
-    Serial.println();
-    Serial.printf("[CanManager]   PGN=0x%05lX, Pri=%u, SA=0x%02X, DA=0x%02X\n",
-                  static_cast<unsigned long>(frame.pgn), frame.priority, 
-                  frame.source_address, frame.destination_address);
-
-    esp_err_t result = twai_transmit(&message, pdMS_TO_TICKS(50));
-    if (result != ESP_OK) {
-        Serial.printf("[CanManager] ✗ TX FAILED (err=%d)\n", static_cast<int>(result));
-        // Log the bus state for debugging
-        if (twai_get_status_info(&status) == ESP_OK) {
-            Serial.printf("[CanManager]   Bus state: %d, TX errors: %lu, RX errors: %lu\n",
-                         status.state, status.tx_error_counter, status.rx_error_counter);
+bool CanManager::sendFrame(const CanFrameConfig& frame, CanTxCallback callback, void* context, uint16_t press_id) {
+    if (!ready_) {
+        CanLatencyTracer::instance().abandon(press_id);
+        CAN_LOGF("[CanManager] CAN bus not initialized\n");
+        return false;
+    }
+
+    CanTxRequest request = requestFor(frame);
+    request.callback = callback;
+    request.context = context;
+    request.trace_id = press_id;
+    return enqueueTx(request);
+}
+
+bool CanManager::enqueueTx(const CanTxRequest& request) {
+    if (!ready_ || !tx_task_.started()) {
+        CanLatencyTracer::instance().abandon(request.trace_id);
+        return false;
+    }
+
+    CanTxRequest queued = request;
+    queued.enqueued_ms = canMillis();
+    if (queued.extended && !queued.fixed_source) {
+        // Every frame goes out under the claimed address; without one we must stay silent
+        if (address_claim_.state() == J1939AddressClaim::State::CANNOT_CLAIM) {
+            tx_rejected_.fetch_add(1, std::memory_order_relaxed);
+            CanLatencyTracer::instance().abandon(request.trace_id);
+            CAN_TRACE_ERROR(CanTraceEvent::TX_REJECT, request.identifier, 0);
+            return false;
         }
+        queued.identifier = (queued.identifier & ~0xFFu) | address_claim_.address();
+    }
+
+    tx_lock_.lock();
+    const bool accepted = tx_queue_.push(queued);
+    tx_lock_.unlock();
+
+    if (!accepted) {
+        tx_rejected_.fetch_add(1, std::memory_order_relaxed);
+        CanLatencyTracer::instance().abandon(request.trace_id);
+        CAN_TRACE_ERROR(CanTraceEvent::TX_REJECT, request.identifier, 0);
         return false;
     }
 
-    Serial.println("[CanManager] ✓ TX SUCCESS");
+    tx_queued_.fetch_add(1, std::memory_order_relaxed);
+    if (queued.trace_id) {
+        CanLatencyTracer::instance().enqueued(queued.trace_id, canMicros());
+    }
+    tx_task_.notify();
     return true;
 }
 
-std::uint32_t CanManager::buildIdentifier(const CanFrameConfig& frame) const {
-    const std::uint8_t priority = frame.priority & 0x7;
-    const std::uint8_t data_page = (frame.pgn >> 16) & 0x01;
-    const std::uint8_t pdu_format = (frame.pgn >> 8) & 0xFF;
-    std::uint8_t pdu_specific = frame.pgn & 0xFF;
+bool CanManager::dequeueTx(CanTxRequest& request) {
+    tx_lock_.lock();
+    const bool found = tx_queue_.pop(request);
+    tx_lock_.unlock();
+    return found;
+}
 
-    if (pdu_format < 240) {
-        // PDU1 - destination specific
-        pdu_specific = frame.destination_address;
+CanTxStats CanManager::txStats() const {
+    CanTxStats stats;
+    stats.queued = tx_queued_.load(std::memory_order_relaxed);
+    stats.sent = tx_sent_.load(std::memory_order_relaxed);
+    stats.failed = tx_failed_.load(std::memory_order_relaxed);
+    stats.rejected = tx_rejected_.load(std::memory_order_relaxed);
+    stats.recoveries = tx_recoveries_.load(std::memory_order_relaxed);
+
+    tx_lock_.lock();
+    stats.queue_depth = tx_queue_.size();
+    stats.queue_high_water = tx_queue_.highWater();
+    tx_lock_.unlock();
+    return stats;
+}
+
+bool CanManager::startTxTask() {
+    if (tx_task_active_.load()) {
+        return true;
     }
+    tx_running_.store(true);
+    tx_task_active_.store(true);
+    if (!tx_task_.start("can_tx", TX_TASK_STACK, TX_TASK_PRIORITY, TX_TASK_CORE, txTaskEntry, this)) {
+        tx_running_.store(false);
+        tx_task_active_.store(false);
+        return false;
+    }
+    return true;
+}
+
+void CanManager::stopTxTask() {
+    if (!tx_task_.started()) {
+        return;
+    }
+    tx_running_.store(false);
+    tx_task_.notify();
+    const uint32_t start = canMillis();
+    while (tx_task_active_.load() && canMillis() - start < 500) {
+        canDelayMs(5);
+    }
+    tx_task_.reset();
+
+    // Anything still queued will never reach the bus; let the owners know
+    CanTxRequest request;
+    while (dequeueTx(request)) {
+        tx_failed_.fetch_add(1, std::memory_order_relaxed);
+        CanLatencyTracer::instance().abandon(request.trace_id);
+        if (request.callback) {
+            request.callback(request, false, request.context);
+        }
+    }
+}
 
-    return (static_cast<std::uint32_t>(priority) << 26) |
-           (static_cast<std::uint32_t>(0) << 25) |
-           (static_cast<std::uint32_t>(data_page) << 24) |
-           (static_cast<std::uint32_t>(pdu_format) << 16) |
-           (static_cast<std::uint32_t>(pdu_specific) << 8) |
-           (static_cast<std::uint32_t>(frame.source_address));
+void CanManager::txTaskEntry(void* arg) {
+    static_cast<CanManager*>(arg)->txTaskLoop();
 }
 
-bool CanManager::receiveMessage(CanRxMessage& msg, uint32_t timeout_ms) {
-    if (!ready_) {
+void CanManager::txTaskLoop() {
+    while (tx_running_.load(std::memory_order_relaxed)) {
+        tx_task_.wait(100);
+
+        CanTxRequest request;
+        while (tx_running_.load(std::memory_order_relaxed) && dequeueTx(request)) {
+            // Hold the frame while the controller recovers from bus-off instead of dropping it
+            bool bus_ok = ensureBusRunning();
+            const uint32_t wait_start = canMillis();
+            while (!bus_ok && tx_running_.load(std::memory_order_relaxed) && canMillis() - wait_start < TX_BUS_WAIT_MS) {
+                canDelayMs(10);
+                bus_ok = ensureBusRunning();
+            }
+
+            const bool success = bus_ok && transmitNow(request);
+            if (success) {
+                tx_sent_.fetch_add(1, std::memory_order_relaxed);
+                bus_stats_.recordTx(request.identifier, request.extended, request.length, canMillis());
+            } else {
+                tx_failed_.fetch_add(1, std::memory_order_relaxed);
+                CanLatencyTracer::instance().abandon(request.trace_id);
+                if (request.spaced) {
+                    button_coalescer_.transmitted(request.identifier, canMillis());
+                    proto_task_.notify();
+                }
+            }
+            if (request.callback) {
+                request.callback(request, success, request.context);
+            }
+        }
+    }
+
+    tx_task_active_.store(false);
+}
+
+bool CanManager::ensureBusRunning() {
+    CanDriverStatus status;
+    if (!driver_->getStatus(status)) {
         return false;
     }
 
-    twai_message_t rx_msg;
-    esp_err_t result = twai_receive(&rx_msg, pdMS_TO_TICKS(timeout_ms));
-    
-    if (result != ESP_OK) {
+    switch (status.state) {
+        case CanDriverState::RUNNING:
+            return true;
+        case CanDriverState::BUS_OFF:
+            CAN_TRACE_STATE(CanTraceEvent::BUS_RECOVERY, status.tx_error_counter);
+            tx_recoveries_.fetch_add(1, std::memory_order_relaxed);
+            driver_->initiateRecovery();
+            return false;
+        case CanDriverState::RECOVERING:
+            return false;
+        case CanDriverState::STOPPED:
+            // Recovery completes in the stopped state; the driver must be restarted
+            CAN_TRACE_STATE(CanTraceEvent::BUS_STATE, static_cast<uint8_t>(status.state));
+            return driver_->start();
+        default:
+            return false;
+    }
+}
+
+bool CanManager::transmitNow(const CanTxRequest& request) {
+    CanFrame frame;
+    frame.identifier = request.identifier;
+    frame.extended = request.extended;
+    frame.length = request.length;
+    memcpy(frame.data, request.data, request.length);
+
+    // Frame logging is deferred to the trace drain task ("cantrace on" to echo)
+    const int result = driver_->transmit(frame, TX_DRIVER_TIMEOUT_MS);
+    if (result != kCanDriverOk) {
+        CAN_TRACE_ERROR(CanTraceEvent::TX_FAIL, frame.identifier, static_cast<uint16_t>(result));
         return false;
     }
 
-    msg.identifier = rx_msg.identifier;
-    msg.length = rx_msg.data_length_code;
-    msg.timestamp = millis();
-    
-    for (uint8_t i = 0; i < msg.length && i < 8; i++) {
-        msg.data[i] = rx_msg.data[i];
+    // The alert task shares this core at a lower priority, so the frame is in the FIFO before its completion is read
+    if (request.trace_id) {
+        CanLatencyTracer::instance().handedToDriver(request.trace_id, canMicros());
+    }
+    DriverTx evicted;
+    tx_lock_.lock();
+    if (driver_fifo_count_ == DRIVER_FIFO_SIZE) {
+        // Completions were lost (driver restarted underneath us); the oldest entry can no longer be matched
+        evicted = driver_fifo_[driver_fifo_head_];
+        driver_fifo_head_ = (driver_fifo_head_ + 1) % DRIVER_FIFO_SIZE;
+        --driver_fifo_count_;
+    }
+    driver_fifo_[(driver_fifo_head_ + driver_fifo_count_) % DRIVER_FIFO_SIZE] =
+        DriverTx{request.trace_id, request.spaced, request.identifier};
+    ++driver_fifo_count_;
+    tx_lock_.unlock();
+    CanLatencyTracer::instance().abandon(evicted.trace_id);
+    if (evicted.spaced) {
+        button_coalescer_.transmitted(evicted.identifier, canMillis());
+    }
+    // When the alert task can run alongside (host threads), the frame may have completed before its entry
+    // went in; settle that now so a spaced PGN does not wait for the next frame's alert to be released
+    CanDriverStatus status;
+    if (request.spaced && driver_->getStatus(status)) {
+        completeDriverTx(kCanAlertTxSuccess, status.tx_pending, canMicros());
     }
 
+    CAN_TRACE_FRAME(CanTraceEvent::TX, frame.identifier, frame.data, frame.length,
+                    frame.extended ? 0 : kCanTraceStandardFrame);
     return true;
 }
 
-std::vector<CanRxMessage> CanManager::receiveAll(uint32_t timeout_ms) {
-    std::vector<CanRxMessage> messages;
-    
-    uint32_t start_time = millis();
-    while (millis() - start_time < timeout_ms) {
-        CanRxMessage msg;
-        if (receiveMessage(msg, 10)) {
-            messages.push_back(msg);
+// Everything the driver no longer counts as pending has left the FIFO's head, in order
+void CanManager::completeDriverTx(uint32_t alerts, uint32_t tx_pending, uint64_t now_us) {
+    std::array<DriverTx, DRIVER_FIFO_SIZE> done;
+    std::size_t count = 0;
+    tx_lock_.lock();
+    while (driver_fifo_count_ > tx_pending) {
+        done[count++] = driver_fifo_[driver_fifo_head_];
+        driver_fifo_head_ = (driver_fifo_head_ + 1) % DRIVER_FIFO_SIZE;
+        --driver_fifo_count_;
+    }
+    tx_lock_.unlock();
+
+    // A TX_FAILED in the same read as a success cannot be told apart; only failure-only reads abandon
+    const bool sent = alerts & kCanAlertTxSuccess;
+    CanLatencyTracer& tracer = CanLatencyTracer::instance();
+    bool spaced = false;
+    for (std::size_t i = 0; i < count; ++i) {
+        if (done[i].spaced) {
+            // Button spacing runs from here, after the frame left the controller, not from when it was queued
+            button_coalescer_.transmitted(done[i].identifier, canMillis());
+            spaced = true;
+        }
+        if (!done[i].trace_id) {
+            continue;
+        }
+        if (sent) {
+            tracer.completed(done[i].trace_id, now_us);
         } else {
-            break;
+            tracer.abandon(done[i].trace_id);
         }
     }
-    
-    return messages;
+    if (spaced) {
+        proto_task_.notify();  // Held button frames may be due now
+    }
 }
 
-// Helper for J1939 PGN transmission (non-blocking, no ACK wait)
-bool CanManager::sendJ1939Pgn(uint8_t priority, uint32_t pgn, uint8_t source_addr, const uint8_t data[8]) {
-    if (!ready_) {
-        Serial.println("[CanManager] TWAI not ready");
+void CanManager::clearDriverFifo() {
+    completeDriverTx(0, 0, 0);
+}
+
+std::uint32_t CanManager::buildIdentifier(const CanFrameConfig& frame) const {
+    return buildJ1939Identifier(frame.priority, frame.pgn, frame.source_address, frame.destination_address);
+}
+
+bool CanManager::startRxTask() {
+    if (rx_task_active_.load()) {
+        return true;
+    }
+    rx_running_.store(true);
+    rx_task_active_.store(true);
+    if (!rx_task_.start("can_rx", RX_TASK_STACK, RX_TASK_PRIORITY, RX_TASK_CORE, rxTaskEntry, this)) {
+        rx_running_.store(false);
+        rx_task_active_.store(false);
         return false;
     }
+    return true;
+}
 
-    // Build J1939 29-bit identifier: [Priority(3) | Reserved(1) | DataPage(1) | PDU Format(8) | PDU Specific(8) | Source Address(8)]
-    uint32_t identifier = ((uint32_t)(priority & 0x7) << 26) | ((pgn & 0x3FFFF) << 8) | source_addr;
+void CanManager::stopRxTask() {
+    rx_running_.store(false);
+    // The task wakes from receive() at least every 100 ms to notice the flag
+    const uint32_t start = canMillis();
+    while (rx_task_active_.load() && canMillis() - start < 500) {
+        canDelayMs(5);
+    }
+    rx_task_.reset();
+}
+
+void CanManager::rxTaskEntry(void* arg) {
+    static_cast<CanManager*>(arg)->rxTaskLoop();
+}
 
-    twai_message_t msg = {};
+void CanManager::rxTaskLoop() {
+    CAN_LOGF("[CanManager] RX task draining the %s driver\n", driver_->name());
+
+    CanFrame frame;
+    while (rx_running_.load(std::memory_order_relaxed)) {
+        if (!driver_->receive(frame, 100)) {
+            continue;
+        }
+
+        deliverRx(frame.identifier, frame.extended, frame.data, std::min<uint8_t>(frame.length, 8), frame.timestamp_us,
+                  frame.extended ? 0 : kCanTraceStandardFrame);
+    }
+
+    rx_task_active_.store(false);
+}
+
+bool CanManager::deliverRx(uint32_t identifier, bool extended, const uint8_t* data, uint8_t length,
+                           uint64_t timestamp_us, uint16_t trace_flags) {
+    // Arrival time from the driver boundary, not when this task got around to the frame
+    const uint32_t now = static_cast<uint32_t>(timestamp_us / 1000);
+    CanRxMessage msg;
     msg.identifier = identifier;
-    msg.extd = 1;  // Extended 29-bit ID
-    msg.data_length_code = 8;
-    memcpy(msg.data, data, 8);
+    msg.length = length;
+    msg.timestamp = now;
+    msg.timestamp_us = timestamp_us;
+    memcpy(msg.data, data, sizeof(msg.data));
+
+    // Counts every frame on the wire, filtered or not; the counters are atomics, so this stays out of the lock
+    bus_stats_.recordRx(identifier, extended, length, now);
+
+    // Uncontended unless a replay is injecting; keeps the ring single-producer
+    rx_lock_.lock();
+    // The hardware filter is coarse; the exact PGN set decides what consumers see
+    const bool wanted = !filter_enabled_ || (extended && filter_planner_.wants(identifier));
+    if (wanted) {
+        rx_ring_.push(msg);
+    }
+    rx_lock_.unlock();
 
-    // Non-blocking transmit with 50ms timeout
-    esp_err_t result = twai_transmit(&msg, pdMS_TO_TICKS(50));
-    if (result != ESP_OK) {
-        Serial.printf("[CanManager] TX queue fail: %s\n", esp_err_to_name(result));
+    if (!wanted) {
+        rx_filtered_.fetch_add(1, std::memory_order_relaxed);
         return false;
     }
+    rx_frames_.fetch_add(1, std::memory_order_relaxed);
+    proto_task_.notify();
+    CAN_TRACE_FRAME(CanTraceEvent::RX, msg.identifier, msg.data, msg.length, trace_flags);
+    (void)trace_flags;  // Below CAN_TRACE_LEVEL_FRAME the macro drops it
+    return true;
+}
+
+bool CanManager::injectRx(uint32_t identifier, bool extended, const uint8_t* data, uint8_t length) {
+    if (!ready_ || !data) {
+        return false;
+    }
+    uint8_t padded[8] = {};
+    length = std::min<uint8_t>(length, 8);
+    memcpy(padded, data, length);
+    deliverRx(identifier, extended, padded, length, canMicros(),
+              (extended ? 0 : kCanTraceStandardFrame) | kCanTraceVirtualFrame);
+    return true;  // Filtered frames count as delivered, as they would on the wire
+}
 
-    Serial.printf("[CanManager] TX PGN=0x%05lX data=%02X %02X %02X %02X %02X %02X %02X %02X\n",
-                  (unsigned long)pgn, data[0], data[1], data[2], data[3], 
-                  data[4], data[5], data[6], data[7]);
+bool CanManager::startReplay(uint32_t segment, CanReplayTarget target, const CanReplayOptions& options,
+                             std::string& error) {
+    if (!ready_) {
+        error = "CAN bus not initialized";
+        return false;
+    }
+    const std::string path = CanRecorder::segmentPath(segment);
+    CanRecorder::instance().flush();
+    std::vector<CanReplayFrame> frames;
+#ifdef ARDUINO
+    File file = LittleFS.open(path.c_str(), FILE_READ);
+    if (!file) {
+        error = "No such segment";
+        return false;
+    }
+    CanLogReader reader([](void* context, uint8_t* buffer, size_t length) -> size_t {
+        return static_cast<File*>(context)->read(buffer, length);
+    }, &file);
+    // Large enough to land in PSRAM; sized from the file so loading never regrows it
+    frames.reserve(std::min<size_t>(CanReplayEngine::kMaxFrames, file.size() / sizeof(CanTraceRecord) + 1));
+    const bool loaded = CanReplayEngine::loadLog(reader, options.include_tx, frames, error);
+    file.close();
+#else
+    // Host builds read recorder segments relative to the working directory
+    std::FILE* file = std::fopen(path.c_str() + 1, "rb");
+    if (!file) {
+        error = "No such segment";
+        return false;
+    }
+    CanLogReader reader([](void* context, uint8_t* buffer, size_t length) -> size_t {
+        return std::fread(buffer, 1, length, static_cast<std::FILE*>(context));
+    }, file);
+    const bool loaded = CanReplayEngine::loadLog(reader, options.include_tx, frames, error);
+    std::fclose(file);
+#endif
+    if (!loaded || !startReplayTask()) {
+        if (loaded) {
+            error = "Failed to start replay task";
+        }
+        return false;
+    }
+
+    replay_target_.store(target);
+    const size_t count = frames.size();
+    if (!replay_.startReplay(std::move(frames), options, canMicros(), error)) {
+        return false;
+    }
+    replay_task_.notify();
+    CAN_LOGF("[CanManager] Replaying %s (%u frames) at %.1fx to the %s bus\n", path.c_str(),
+                  static_cast<unsigned>(count), options.speed, target == CanReplayTarget::BUS ? "real" : "virtual");
     return true;
 }
 
-// Background task for Infinitybox Output1 ON sequence
-static void infinityboxOutput1OnTask(void* pvParameters) {
-    const uint8_t SA_TOOL = 0x80;
-    const uint32_t PGN_FF01 = 0x00FF01;
-    const uint32_t PGN_FF02 = 0x00FF02;
+bool CanManager::startGenerator(const CanTrafficProfile& profile, CanReplayTarget target,
+                                const CanReplayOptions& options, std::string& error) {
+    if (!ready_) {
+        error = "CAN bus not initialized";
+        return false;
+    }
+    if (!startReplayTask()) {
+        error = "Failed to start replay task";
+        return false;
+    }
+    replay_target_.store(target);
+    CanTrafficProfile scaled = profile;
+    scaled.bitrate = bitrate_;  // Load percentages are of the bus as it runs now
+    if (!replay_.startGenerator(scaled, options, canMicros(), error)) {
+        return false;
+    }
+    replay_task_.notify();
+    CAN_LOGF("[CanManager] Generating %.1f%% bus load at %.1fx to the %s bus\n", profile.load_percent,
+                  options.speed, target == CanReplayTarget::BUS ? "real" : "virtual");
+    return true;
+}
 
-    vTaskDelay(pdMS_TO_TICKS(100));  // Let web handler return first
+bool CanManager::startReplayTask() {
+    if (replay_task_.started()) {
+        return true;
+    }
+    replay_.setSink([](const CanReplayFrame& frame, void* context) {
+        auto* self = static_cast<CanManager*>(context);
+        if (self->replay_target_.load(std::memory_order_relaxed) == CanReplayTarget::VIRTUAL) {
+            return self->injectRx(frame.identifier, frame.extended, frame.data, frame.length);
+        }
+        // Recorded frames keep their original source addresses; bench use only
+        CanTxRequest request;
+        request.identifier = frame.identifier;
+        request.extended = frame.extended;
+        request.fixed_source = true;
+        request.length = frame.length;
+        memcpy(request.data, frame.data, sizeof(request.data));
+        return self->enqueueTx(request);
+    }, this);
+    return replay_task_.start("can_replay", REPLAY_TASK_STACK, REPLAY_TASK_PRIORITY, REPLAY_TASK_CORE,
+                              replayTaskEntry, this);
+}
 
-    Serial.println("[Task] Infinitybox Output1 ON sequence starting");
+void CanManager::replayTaskEntry(void* arg) {
+    static_cast<CanManager*>(arg)->replayTaskLoop();
+}
 
-    // Baseline FF02 00
-    uint8_t ff02_00[8] = {0x00, 0, 0, 0, 0, 0, 0, 0};
-    if (CanManager::instance().sendJ1939Pgn(6, PGN_FF02, SA_TOOL, ff02_00)) {
-        vTaskDelay(pdMS_TO_TICKS(10));
+void CanManager::replayTaskLoop() {
+    while (true) {
+        if (!replay_.active()) {
+            replay_task_.wait(CanTask::kWaitForever);
+            continue;
+        }
+        const uint64_t wait_us = replay_.tick(canMicros());
+        // At least one tick so the loop task on this core keeps running during a 50x replay;
+        // frames due within the same tick go out together
+        const uint32_t wait_ms = wait_us == CanReplayEngine::kIdle
+                                     ? REPLAY_MAX_WAIT_MS
+                                     : std::min<uint32_t>(wait_us / 1000, REPLAY_MAX_WAIT_MS);
+        replay_task_.wait(std::max<uint32_t>(1, wait_ms));
+    }
+}
 
-        // FF01 A0 00
-        uint8_t ff01_a0[8] = {0xA0, 0x00, 0, 0, 0, 0, 0, 0};
-        if (CanManager::instance().sendJ1939Pgn(6, PGN_FF01, SA_TOOL, ff01_a0)) {
-            vTaskDelay(pdMS_TO_TICKS(10));
+bool CanManager::startAlertTask() {
+    if (alert_task_active_.load()) {
+        return true;
+    }
+    alert_running_.store(true);
+    alert_task_active_.store(true);
+    if (!alert_task_.start("can_alert", ALERT_TASK_STACK, ALERT_TASK_PRIORITY, ALERT_TASK_CORE, alertTaskEntry, this)) {
+        alert_running_.store(false);
+        alert_task_active_.store(false);
+        return false;
+    }
+    return true;
+}
 
-            // FF02 80 00
-            uint8_t ff02_80[8] = {0x80, 0x00, 0, 0, 0, 0, 0, 0};
-            if (CanManager::instance().sendJ1939Pgn(6, PGN_FF02, SA_TOOL, ff02_80)) {
-                vTaskDelay(pdMS_TO_TICKS(10));
+void CanManager::stopAlertTask() {
+    alert_running_.store(false);
+    // The task wakes from readAlerts() every ALERT_POLL_MS to notice the flag
+    const uint32_t start = canMillis();
+    while (alert_task_active_.load() && canMillis() - start < 500) {
+        canDelayMs(5);
+    }
+    alert_task_.reset();
+}
 
-                // FF01 20 00
-                uint8_t ff01_20[8] = {0x20, 0x00, 0, 0, 0, 0, 0, 0};
-                if (CanManager::instance().sendJ1939Pgn(6, PGN_FF01, SA_TOOL, ff01_20)) {
-                    vTaskDelay(pdMS_TO_TICKS(10));
+void CanManager::alertTaskEntry(void* arg) {
+    static_cast<CanManager*>(arg)->alertTaskLoop();
+}
 
-                    // FF02 back to 00
-                    CanManager::instance().sendJ1939Pgn(6, PGN_FF02, SA_TOOL, ff02_00);
+void CanManager::alertTaskLoop() {
+    static constexpr CanBusAlert kAlerts[] = {
+        CanBusAlert::BUS_ERROR,
+        CanBusAlert::ERROR_WARNING,
+        CanBusAlert::ERROR_PASSIVE,
+        CanBusAlert::ERROR_ACTIVE,
+        CanBusAlert::BUS_OFF,
+        CanBusAlert::BUS_RECOVERED,
+        CanBusAlert::ARBITRATION_LOST,
+        CanBusAlert::TX_FAILED,
+        CanBusAlert::RX_QUEUE_FULL,
+    };
+    constexpr uint32_t kStateAlerts = canAlertBit(CanBusAlert::ERROR_PASSIVE) | canAlertBit(CanBusAlert::ERROR_ACTIVE) |
+                                      canAlertBit(CanBusAlert::BUS_OFF) | canAlertBit(CanBusAlert::BUS_RECOVERED);
+    constexpr uint32_t kTxDoneAlerts = kCanAlertTxSuccess | canAlertBit(CanBusAlert::TX_FAILED);
+
+    while (alert_running_.load(std::memory_order_relaxed)) {
+        uint32_t alerts = 0;
+        if (driver_->readAlerts(alerts, ALERT_POLL_MS)) {
+            const uint64_t now_us = canMicros();
+            for (CanBusAlert alert : kAlerts) {
+                if (alerts & canAlertBit(alert)) {
+                    bus_stats_.recordAlert(alert);
+                }
+            }
+            CanDriverStatus status;
+            if ((alerts & (kStateAlerts | kTxDoneAlerts)) && driver_->getStatus(status)) {
+                if (alerts & kStateAlerts) {
+                    CAN_TRACE_STATE(CanTraceEvent::BUS_STATE, static_cast<uint8_t>(status.state));
+                }
+                if (alerts & kTxDoneAlerts) {
+                    completeDriverTx(alerts, status.tx_pending, now_us);
                 }
             }
         }
+        bus_stats_.tick(canMillis());
     }
 
-    Serial.println("[Task] Infinitybox Output1 ON sequence complete");
-    vTaskDelete(NULL);
+    alert_task_active_.store(false);
 }
 
-// Non-blocking wrapper - starts background task
-bool CanManager::sendInfinityboxOutput1On() {
-    if (!ready_) {
-        Serial.println("[CanManager] TWAI not ready");
-        return false;
+CanBusSnapshot CanManager::busStats() const {
+    CanBusSnapshot snap = bus_stats_.snapshot();
+    CanDriverStatus status;
+    if (ready_ && driver_->getStatus(status)) {
+        switch (status.state) {
+            case CanDriverState::STOPPED: snap.bus_state = "stopped"; break;
+            case CanDriverState::RUNNING:
+                snap.bus_state = status.tx_error_counter >= 128 || status.rx_error_counter >= 128 ? "error_passive"
+                                                                                                  : "running";
+                break;
+            case CanDriverState::BUS_OFF: snap.bus_state = "bus_off"; break;
+            case CanDriverState::RECOVERING: snap.bus_state = "recovering"; break;
+            default: break;
+        }
+        snap.tx_error_counter = status.tx_error_counter;
+        snap.rx_error_counter = status.rx_error_counter;
+    } else if (!ready_) {
+        snap.bus_state = "not_ready";
     }
-    if (xTaskCreate(infinityboxOutput1OnTask, "Inf1On", 2048, NULL, 1, NULL) == pdTRUE) {
-        Serial.println("[CanManager] Started Output1 ON background task");
+    return snap;
+}
+
+bool CanManager::startProtoTask() {
+    if (proto_task_active_.load()) {
         return true;
     }
-    return false;
+    proto_running_.store(true);
+    proto_task_active_.store(true);
+    if (!proto_task_.start("can_proto", PROTO_TASK_STACK, PROTO_TASK_PRIORITY, PROTO_TASK_CORE, protoTaskEntry, this)) {
+        proto_running_.store(false);
+        proto_task_active_.store(false);
+        return false;
+    }
+    return true;
 }
 
-// Background task for Infinitybox Output1 OFF sequence
-static void infinityboxOutput1OffTask(void* pvParameters) {
-    const uint8_t SA_TOOL = 0x80;
-    const uint32_t PGN_FF01 = 0x00FF01;
-    const uint32_t PGN_FF02 = 0x00FF02;
+void CanManager::stopProtoTask() {
+    proto_running_.store(false);
+    proto_task_.notify();
+    const uint32_t start = canMillis();
+    while (proto_task_active_.load() && canMillis() - start < 500) {
+        canDelayMs(5);
+    }
+    proto_task_.reset();
+}
 
-    Serial.println("[Task] Infinitybox Output1 OFF sequence starting");
+void CanManager::protoTaskEntry(void* arg) {
+    static_cast<CanManager*>(arg)->protoTaskLoop();
+}
 
-    uint8_t ff02_00[8] = {0x00, 0, 0, 0, 0, 0, 0, 0};
-    uint8_t ff01_20[8] = {0x20, 0x00, 0, 0, 0, 0, 0, 0};
+// J1939 protocol work (address claim, transport sessions, signal decoding, module status
+// polls) runs off the RX task so reassembly and handler callbacks never delay draining the driver.
+void CanManager::protoTaskLoop() {
+    CanRxCursor cursor = rx_ring_.openCursor();
+    uint32_t dropped_seen = 0;
+    CanRxMessage msg;
+    CanModuleStatus& modules = CanModuleStatus::instance();
+    bool restart_claim = address_claim_enabled_;
+    while (proto_running_.load(std::memory_order_relaxed)) {
+        if (restart_claim) {
+            restart_claim = false;
+            address_claim_.start(canMillis());  // Claims are re-sent whenever the bus (re)starts
+        }
+        while (rx_ring_.pop(cursor, msg)) {
+            address_claim_.onFrame(msg.identifier, msg.data, msg.length, msg.timestamp);
+            transport_.onFrame(msg.identifier, msg.data, msg.length, msg.timestamp);
+            CanSignalDatabase::instance().decode(msg.identifier, msg.data, msg.length, msg.timestamp);
+            modules.onFrame(msg.identifier, msg.data, msg.length, msg.timestamp);
+        }
+        if (cursor.dropped != dropped_seen) {
+            proto_dropped_.fetch_add(cursor.dropped - dropped_seen, std::memory_order_relaxed);
+            dropped_seen = cursor.dropped;
+        }
+        const uint32_t now = canMillis();
+        const uint32_t claim_wait = address_claim_.tick(now);
+        if (transport_.address() != address_claim_.address()) {
+            transport_.setAddress(address_claim_.address());
+        }
+        const uint32_t wait_ms = std::min({transport_.tick(now), claim_wait, modules.tick(now),
+                                           button_coalescer_.poll(now), PROTO_MAX_WAIT_MS});
+        proto_task_.wait(wait_ms);
+    }
+    proto_task_active_.store(false);
+}
 
-    CanManager::instance().sendJ1939Pgn(6, PGN_FF02, SA_TOOL, ff02_00);
-    vTaskDelay(pdMS_TO_TICKS(10));
-    CanManager::instance().sendJ1939Pgn(6, PGN_FF01, SA_TOOL, ff01_20);
-    vTaskDelay(pdMS_TO_TICKS(10));
-    CanManager::instance().sendJ1939Pgn(6, PGN_FF02, SA_TOOL, ff02_00);
+bool CanManager::sendJ1939Message(uint32_t pgn, uint8_t priority, uint8_t destination, const uint8_t* data,
+                                  uint16_t length, J1939Transport::CompletionHandler done, void* context) {
+    if (!ready_ || !data) {
+        return false;
+    }
+    if (length > 8) {
+        const bool started = transport_.send(pgn, priority, destination, data, length, canMillis(), done, context);
+        if (started) {
+            proto_task_.notify();  // Start pacing right away
+        }
+        return started;
+    }
 
-    Serial.println("[Task] Infinitybox Output1 OFF sequence complete");
-    vTaskDelete(NULL);
+    CanTxRequest request;
+    request.identifier = buildJ1939Identifier(priority, pgn, transport_.address(), destination);
+    request.extended = true;
+    request.length = static_cast<uint8_t>(length);
+    memcpy(request.data, data, length);
+    return enqueueTx(request);
 }
 
-// Non-blocking wrapper - starts background task
-bool CanManager::sendInfinityboxOutput1Off() {
+void CanManager::configureAddressing(const DeviceConfig& config) {
+    const J1939Config& cfg = config.j1939;
+    J1939Name name;
+    name.arbitrary_address_capable = cfg.arbitrary_address_capable;
+    name.industry_group = cfg.industry_group;
+    name.vehicle_system = cfg.vehicle_system;
+    name.vehicle_system_instance = cfg.vehicle_system_instance;
+    name.function = cfg.function;
+    name.function_instance = cfg.function_instance;
+    name.ecu_instance = cfg.ecu_instance;
+    name.manufacturer_code = cfg.manufacturer_code;
+    // Two panels on one vehicle must not share a NAME, so default to the low MAC bits
+    name.identity_number = cfg.identity_number ? cfg.identity_number
+                                               : static_cast<uint32_t>(canDeviceId() & 0x1FFFFF);
+
+    const bool changed = address_claim_.configure(name, cfg.preferred_address, cfg.address_min, cfg.address_max);
+    const bool was_enabled = address_claim_enabled_;
+    address_claim_enabled_ = cfg.address_claim;
+
+    if (!cfg.address_claim) {
+        address_claim_.assignFixed();
+    } else if (changed || !was_enabled || address_claim_.state() == J1939AddressClaim::State::IDLE) {
+        address_claim_.start(canMillis());
+    }
+    transport_.setAddress(address_claim_.address());
+    CAN_LOGF("[CanManager] J1939 NAME 0x%016llX, source address 0x%02X%s\n",
+                  static_cast<unsigned long long>(address_claim_.name()), address_claim_.address(),
+                  cfg.address_claim ? " (claiming)" : " (fixed)");
+}
+
+bool CanManager::addJ1939Handler(J1939Transport::MessageHandler handler, void* context) {
+    return transport_.addHandler(handler, context);
+}
+
+bool CanManager::readRx(CanRxCursor& cursor, CanRxMessage& msg, uint32_t timeout_ms) {
     if (!ready_) {
-        Serial.println("[CanManager] TWAI not ready");
         return false;
     }
-    if (xTaskCreate(infinityboxOutput1OffTask, "Inf1Off", 2048, NULL, 1, NULL) == pdTRUE) {
-        Serial.println("[CanManager] Started Output1 OFF background task");
-        return true;
-    }
-    return false;
-}
-
-// Background task for Infinitybox Output9 ON sequence
-// EXACT 5-message sequence from working sketch
-static void infinityboxOutput9OnTask(void* pvParameters) {
-    const uint8_t SA_TOOL = 0x80;
-    const uint32_t PGN_FF01 = 0x00FF01;
-    const uint32_t PGN_FF02 = 0x00FF02;
-
-    vTaskDelay(pdMS_TO_TICKS(100));  // Let web handler return first
-
-    Serial.println("[Task] Infinitybox Output9 ON sequence starting (5 messages)");
-
-    uint8_t ff02_00[8] = {0x00, 0, 0, 0, 0, 0, 0, 0};
-    uint8_t ff02_80[8] = {0x80, 0x00, 0, 0, 0, 0, 0, 0};
-    uint8_t ff01_2080[8] = {0x20, 0x80, 0, 0, 0, 0, 0, 0};
-
-    // Message 1: FF02 00
-    if (CanManager::instance().sendJ1939Pgn(6, PGN_FF02, SA_TOOL, ff02_00)) {
-        vTaskDelay(pdMS_TO_TICKS(10));
-        // Message 2: FF01 20 80
-        if (CanManager::instance().sendJ1939Pgn(6, PGN_FF01, SA_TOOL, ff01_2080)) {
-            vTaskDelay(pdMS_TO_TICKS(10));
-            // Message 3: FF02 80
-            if (CanManager::instance().sendJ1939Pgn(6, PGN_FF02, SA_TOOL, ff02_80)) {
-                vTaskDelay(pdMS_TO_TICKS(10));
-                // Message 4: FF01 20 80 (repeat)
-                if (CanManager::instance().sendJ1939Pgn(6, PGN_FF01, SA_TOOL, ff01_2080)) {
-                    vTaskDelay(pdMS_TO_TICKS(10));
-                    // Message 5: FF02 00
-                    CanManager::instance().sendJ1939Pgn(6, PGN_FF02, SA_TOOL, ff02_00);
-                }
-            }
+
+    const uint32_t start = canMillis();
+    while (!rx_ring_.pop(cursor, msg)) {
+        if (canMillis() - start >= timeout_ms) {
+            return false;
         }
+        canDelayMs(1);
     }
-
-    Serial.println("[Task] Infinitybox Output9 ON sequence complete");
-    vTaskDelete(NULL);
+    return true;
 }
 
-// Non-blocking wrapper - starts background task
-bool CanManager::sendInfinityboxOutput9On() {
+std::vector<CanRxMessage> CanManager::readAll(CanRxCursor& cursor, std::size_t max_messages, uint32_t timeout_ms) {
+    std::vector<CanRxMessage> messages;
     if (!ready_) {
-        Serial.println("[CanManager] TWAI not ready");
-        return false;
+        return messages;
     }
-    if (xTaskCreate(infinityboxOutput9OnTask, "Inf9On", 4096, NULL, 1, NULL) == pdTRUE) {
-        Serial.println("[CanManager] Started Output9 ON background task");
-        return true;
+
+    messages.reserve(std::min<std::size_t>(max_messages, rx_ring_.available(cursor) + 1));
+    CanRxMessage msg;
+    if (!readRx(cursor, msg, timeout_ms)) {
+        return messages;
     }
-    return false;
+    messages.push_back(msg);
+    while (messages.size() < max_messages && rx_ring_.pop(cursor, msg)) {
+        messages.push_back(msg);
+    }
+    return messages;
 }
 
-// Background task for Infinitybox Output9 OFF sequence
-// EXACT 3-message sequence from working sketch
-static void infinityboxOutput9OffTask(void* pvParameters) {
-    const uint8_t SA_TOOL = 0x80;
-    const uint32_t PGN_FF01 = 0x00FF01;
-    const uint32_t PGN_FF02 = 0x00FF02;
+CanRxStats CanManager::rxStats() const {
+    CanRxStats stats;
+    stats.frames = rx_frames_.load(std::memory_order_relaxed);
+    stats.proto_dropped = proto_dropped_.load(std::memory_order_relaxed);
+    stats.filtered = rx_filtered_.load(std::memory_order_relaxed);
 
-    vTaskDelay(pdMS_TO_TICKS(100));  // Let web handler return first
+    CanDriverStatus status;
+    if (ready_ && driver_->getStatus(status)) {
+        stats.driver_missed = status.rx_missed;
+    }
+    return stats;
+}
 
-    Serial.println("[Task] Infinitybox Output9 OFF sequence starting (3 messages)");
+bool CanManager::configureFilters(const DeviceConfig& config) {
+    CanFilterPlanner planner;
+    bool complete = true;
+    for (const CanMessage& msg : config.can_library) {
+        complete &= planner.addRule(CanFilterRule{msg.pgn});
+    }
+    complete &= planner.addPgnRange(0xFF50, 0xFF5F);  // Module status replies
+    complete &= planner.addRule(CanFilterRule{J1939AddressClaim::kPgnAddressClaimed});
+    complete &= planner.addRule(CanFilterRule{J1939AddressClaim::kPgnRequest});
+    complete &= planner.addRule(CanFilterRule{J1939Transport::kPgnTpCm});
+    complete &= planner.addRule(CanFilterRule{J1939Transport::kPgnTpDt});
+    for (const CanSignalConfig& signal : config.can_signals) {
+        complete &= planner.addRule(CanFilterRule{signal.pgn, signal.source_address});
+    }
+    for (std::uint32_t pgn : config.can_filter.extra_pgns) {
+        complete &= planner.addRule(CanFilterRule{pgn});
+    }
+
+    // A truncated rule set would silently drop wanted frames; keep accepting everything instead
+    const bool enable = config.can_filter.enabled && complete;
+    if (config.can_filter.enabled && !complete) {
+        CAN_LOGF("[CanManager] Too many PGNs for the filter planner; filtering disabled\n");
+    }
 
-    uint8_t ff02_00[8] = {0x00, 0, 0, 0, 0, 0, 0, 0};
-    uint8_t ff01_20[8] = {0x20, 0x00, 0, 0, 0, 0, 0, 0};
+    const CanFilterPlan plan = planner.plan();
+    const bool changed = enable != filter_enabled_ ||
+                         (enable && (plan.mode != filter_plan_.mode ||
+                                     plan.acceptance_code != filter_plan_.acceptance_code ||
+                                     plan.acceptance_mask != filter_plan_.acceptance_mask));
 
-    // Message 1: FF02 00
-    if (CanManager::instance().sendJ1939Pgn(6, PGN_FF02, SA_TOOL, ff02_00)) {
-        vTaskDelay(pdMS_TO_TICKS(10));
-        // Message 2: FF01 20 00
-        if (CanManager::instance().sendJ1939Pgn(6, PGN_FF01, SA_TOOL, ff01_20)) {
-            vTaskDelay(pdMS_TO_TICKS(10));
-            // Message 3: FF02 00
-            CanManager::instance().sendJ1939Pgn(6, PGN_FF02, SA_TOOL, ff02_00);
+    const bool was_ready = ready_;
+    if (changed && was_ready) {
+        stop();  // Filters can only be changed with the driver uninstalled
+    }
+    filter_planner_ = planner;
+    filter_plan_ = plan;
+    filter_enabled_ = enable;
+    if (changed && was_ready) {
+        return begin(tx_pin_, rx_pin_, configured_bitrate_);
+    }
+    return true;
+}
+
+bool CanManager::configureBus(const CanBusConfig& config) {
+    const bool changed = config.bitrate != configured_bitrate_ || config.auto_baud != auto_baud_;
+    auto_baud_ = config.auto_baud;
+    if (!changed) {
+        return true;
+    }
+    if (!ready_) {
+        configured_bitrate_ = config.bitrate;  // Applied by the next begin()
+        return true;
+    }
+    stop();  // The bitrate is part of the driver install
+    return begin(tx_pin_, rx_pin_, config.bitrate);
+}
+
+CanFilterReport CanManager::predictFilter(uint32_t sample_ms) {
+    std::vector<uint32_t> sample;
+    CanRxCursor cursor = rx_ring_.openCursor();
+    CanRxMessage msg;
+    const uint32_t start = canMillis();
+    while (canMillis() - start < sample_ms) {
+        if (readRx(cursor, msg, 10)) {
+            sample.push_back(msg.identifier);
         }
     }
+    return filter_planner_.evaluate(filter_plan_, sample);
+}
 
-    Serial.println("[Task] Infinitybox Output9 OFF sequence complete");
-    vTaskDelete(NULL);
+bool CanManager::receiveMessage(CanRxMessage& msg, uint32_t timeout_ms) {
+    return readRx(legacy_cursor_, msg, timeout_ms);
 }
 
-// Non-blocking wrapper - starts background task
-bool CanManager::sendInfinityboxOutput9Off() {
+std::vector<CanRxMessage> CanManager::receiveAll(uint32_t timeout_ms) {
+    std::vector<CanRxMessage> messages;
+    
+    uint32_t start_time = canMillis();
+    while (canMillis() - start_time < timeout_ms) {
+        CanRxMessage msg;
+        if (receiveMessage(msg, 10)) {
+            messages.push_back(msg);
+        } else {
+            break;
+        }
+    }
+    
+    return messages;
+}
+
+// Helper for J1939 PGN transmission (non-blocking, no ACK wait)
+bool CanManager::sendJ1939Pgn(uint8_t priority, uint32_t pgn, const uint8_t data[8], CanTxCallback callback,
+                              void* context) {
     if (!ready_) {
-        Serial.println("[CanManager] TWAI not ready");
+        CAN_LOGF("[CanManager] CAN bus not ready\n");
         return false;
     }
-    if (xTaskCreate(infinityboxOutput9OffTask, "Inf9Off", 4096, NULL, 1, NULL) == pdTRUE) {
-        Serial.println("[CanManager] Started Output9 OFF background task");
-        return true;
+
+    // Build J1939 29-bit identifier: [Priority(3) | Reserved(1) | DataPage(1) | PDU Format(8) | PDU Specific(8) | Source Address(8)]
+    // The source byte is filled in by enqueueTx
+    CanTxRequest request;
+    request.identifier = ((uint32_t)(priority & 0x7) << 26) | ((pgn & 0x3FFFF) << 8);
+    request.extended = true;  // Extended 29-bit ID
+    request.length = 8;
+    memcpy(request.data, data, 8);
+    request.callback = callback;
+    request.context = context;
+
+    return enqueueTx(request);
+}
+
+// Infinitybox output commands are data-driven sequences (see ConfigManager defaults);
+// the engine's worker paces the frames so callers never block or spawn tasks.
+bool CanManager::startSequence(const std::string& id) {
+    if (!ready_) {
+        CAN_LOGF("[CanManager] CAN bus not ready\n");
+        return false;
+    }
+    if (!CanSequenceEngine::instance().start(id)) {
+        CAN_LOGF("[CanManager] Sequence '%s' not started\n", id.c_str());
+        return false;
     }
-    return false;
+    return true;
+}
+
+bool CanManager::sendInfinityboxOutput1On() {
+    return startSequence("infinitybox_output1_on");
+}
+
+bool CanManager::sendInfinityboxOutput1Off() {
+    return startSequence("infinitybox_output1_off");
+}
+
+bool CanManager::sendInfinityboxOutput9On() {
+    return startSequence("infinitybox_output9_on");
+}
+
+bool CanManager::sendInfinityboxOutput9Off() {
+    return startSequence("infinitybox_output9_off");
 }
@@ -1,17 +1,42 @@
 #pragma once
 
-#include <Arduino.h>
-#include <hal/gpio_types.h>
+#include <array>
+#include <atomic>
+#include <string>
 #include <vector>
 
+#include "can_autobaud.h"
+#include "can_bus_stats.h"
+#include "can_button_coalescer.h"
+#include "can_driver.h"
+#include "can_filter_planner.h"
+#include "can_latency.h"
+#include "can_platform.h"
+#include "can_replay.h"
+#include "can_rx_ring.h"
+#include "can_tx_queue.h"
+#include "j1939_address_claim.h"
+#include "j1939_transport.h"
+#include "can_types.h"
 #include "config_types.h"
 
-// Struct for received CAN messages (different from CanMessage in config_types.h)
-struct CanRxMessage {
-    uint32_t identifier;
-    uint8_t data[8];
-    uint8_t length;
-    uint32_t timestamp;
+using CanRxCursor = CanRxRing::Cursor;
+
+struct CanRxStats {
+    uint32_t frames = 0;          // Frames pulled from the driver by the RX task
+    uint32_t proto_dropped = 0;   // Frames the protocol task lost to ring overwrites (other consumers: Cursor::dropped)
+    uint32_t driver_missed = 0;   // Frames the driver dropped (RX queue full)
+    uint32_t filtered = 0;        // Frames past the hardware filter that the software set rejected
+};
+
+struct CanTxStats {
+    uint32_t queued = 0;        // Frames accepted by the TX queue
+    uint32_t sent = 0;          // Frames handed to the driver
+    uint32_t failed = 0;        // Frames the scheduler gave up on
+    uint32_t rejected = 0;      // Enqueue attempts refused because the queue was full
+    uint32_t recoveries = 0;    // Bus-off recoveries initiated by the scheduler
+    uint32_t queue_depth = 0;
+    uint32_t queue_high_water = 0;
 };
 
 class CanManager {
@@ -21,38 +46,217 @@ public:
     // GPIO pin configuration - VERIFIED WORKING:
     // TX=GPIO20, RX=GPIO19 is the CORRECT configuration for this board
     // (The pins were incorrectly swapped in a recent commit)
-    static constexpr gpio_num_t DEFAULT_TX_PIN = static_cast<gpio_num_t>(20);
-    static constexpr gpio_num_t DEFAULT_RX_PIN = static_cast<gpio_num_t>(19);
+    static constexpr int DEFAULT_TX_PIN = 20;
+    static constexpr int DEFAULT_RX_PIN = 19;
+
+    // RX task drains the TWAI driver continuously into a PSRAM ring
+    static constexpr std::size_t RX_RING_CAPACITY = 2048;
+    static constexpr uint32_t RX_TASK_STACK = 3072;
+    static constexpr uint32_t RX_TASK_PRIORITY = 5;
+    static constexpr int RX_TASK_CORE = 1;
+
+    // TX scheduler owns driver transmits and bus-off recovery so callers never block
+    static constexpr uint32_t TX_TASK_STACK = 3072;
+    static constexpr uint32_t TX_TASK_PRIORITY = 4;
+    static constexpr int TX_TASK_CORE = 1;
+    static constexpr uint32_t TX_DRIVER_TIMEOUT_MS = 50;
+    static constexpr uint32_t TX_BUS_WAIT_MS = 1000;  // How long a frame may wait for bus-off recovery
+    static constexpr uint32_t PROTO_TASK_STACK = 4096;
+    static constexpr uint32_t PROTO_TASK_PRIORITY = 3;
+    static constexpr int PROTO_TASK_CORE = 1;
+    static constexpr uint32_t PROTO_MAX_WAIT_MS = 100;
+    // Alert task turns TWAI alerts into counters and rolls the bus-load window
+    static constexpr uint32_t ALERT_TASK_STACK = 2560;
+    static constexpr uint32_t ALERT_TASK_PRIORITY = 2;
+    static constexpr int ALERT_TASK_CORE = 1;
+    static constexpr uint32_t ALERT_POLL_MS = 250;
+    // Replay task is created on first use; below the protocol task so virtual frames never outrun it
+    static constexpr uint32_t REPLAY_TASK_STACK = 3072;
+    static constexpr uint32_t REPLAY_TASK_PRIORITY = 2;
+    static constexpr int REPLAY_TASK_CORE = 1;
+    static constexpr uint32_t REPLAY_MAX_WAIT_MS = 100;
 
-    bool begin(gpio_num_t tx_pin = DEFAULT_TX_PIN, gpio_num_t rx_pin = DEFAULT_RX_PIN, std::uint32_t bitrate = 250000);
+    // The controller backend: TWAI on the device by default; host builds must set one (e.g. a VirtualCanBus node)
+    void setDriver(CanDriver* driver) { driver_ = driver; }
+    CanDriver* driver() const { return driver_; }
+
+    bool begin(int tx_pin = DEFAULT_TX_PIN, int rx_pin = DEFAULT_RX_PIN, std::uint32_t bitrate = 250000);
     void stop();
-    bool sendButtonAction(const ButtonConfig& button);
-    bool sendButtonReleaseAction(const ButtonConfig& button);
-    bool sendFrame(const CanFrameConfig& frame);
+    // press_id: CanLatencyTracer::beginPress() for the UI press behind the action, 0 when untraced.
+    // Button frames pass through the coalescer: repeats are dropped and frames may be held briefly.
+    bool sendButtonAction(const ButtonConfig& button, uint16_t press_id = 0);
+    bool sendButtonReleaseAction(const ButtonConfig& button, uint16_t press_id = 0);
+    void configureCoalescing(const CanCoalesceConfig& config) { button_coalescer_.configure(config); }
+    CanCoalesceStats coalesceStats() const { return button_coalescer_.stats(); }
+    void resetCoalesceStats() { button_coalescer_.resetStats(); }
+    // Non-blocking: queues the frame for the TX scheduler and returns immediately
+    bool sendFrame(const CanFrameConfig& frame, CanTxCallback callback = nullptr, void* context = nullptr,
+                   uint16_t press_id = 0);
+    bool enqueueTx(const CanTxRequest& request);
+    CanTxStats txStats() const;
     
     bool receiveMessage(CanRxMessage& msg, uint32_t timeout_ms = 10);
     std::vector<CanRxMessage> receiveAll(uint32_t timeout_ms = 100);
 
+    // Independent consumers: each cursor sees every frame received after it was opened
+    CanRxCursor openRxCursor() const { return rx_ring_.openCursor(); }
+    bool readRx(CanRxCursor& cursor, CanRxMessage& msg, uint32_t timeout_ms = 0);
+    std::vector<CanRxMessage> readAll(CanRxCursor& cursor, std::size_t max_messages, uint32_t timeout_ms = 0);
+    uint32_t rxPending(const CanRxCursor& cursor) const { return rx_ring_.available(cursor); }
+    CanRxStats rxStats() const;
+    // Per-PGN counters and rates, alert counts, bus load and controller state
+    CanBusSnapshot busStats() const;
+    void resetBusStats() { bus_stats_.reset(); }
+
+    // Virtual bus: delivers a frame to every RX consumer (ring, protocol task, stats, trace) as if received
+    bool injectRx(uint32_t identifier, bool extended, const uint8_t* data, uint8_t length);
+
+    // Replays a flight recorder segment, or generates synthetic load, onto the bus or the virtual bus
+    bool startReplay(uint32_t segment, CanReplayTarget target, const CanReplayOptions& options, std::string& error);
+    bool startGenerator(const CanTrafficProfile& profile, CanReplayTarget target, const CanReplayOptions& options,
+                        std::string& error);
+    void stopReplay() { replay_.stop(); }
+    CanReplayEngine::Status replayStatus() const { return replay_.status(); }
+    CanReplayTarget replayTarget() const { return replay_target_.load(); }
+
+    // Bitrate from config.can_bus; with auto_baud, begin() first listens for the rate the bus actually uses
+    // and falls back to the configured one. Reinstalls the driver when either setting changes.
+    bool configureBus(const CanBusConfig& config);
+    uint32_t bitrate() const { return bitrate_; }  // Active rate (the detected one after an auto-baud lock)
+    uint32_t configuredBitrate() const { return configured_bitrate_; }
+    bool autoBaudEnabled() const { return auto_baud_; }
+    const CanAutoBaudResult& autoBaudResult() const { return auto_baud_result_; }
+
+    // Acceptance filtering from the configured PGN set; reinstalls the driver when the plan changes
+    bool configureFilters(const DeviceConfig& config);
+    const CanFilterPlan& filterPlan() const { return filter_plan_; }
+    std::size_t filterRuleCount() const { return filter_planner_.ruleCount(); }
+    // Samples live traffic and predicts what the planned filter would let through (run with filtering off)
+    CanFilterReport predictFilter(uint32_t sample_ms);
+
+    // Runs a configured CAN sequence (DeviceConfig::can_sequences) by id
+    bool startSequence(const std::string& id);
+
     // Infinitybox-specific command sequences (J1939 protocol)
     bool sendInfinityboxOutput1On();
     bool sendInfinityboxOutput1Off();
     bool sendInfinityboxOutput9On();
     bool sendInfinityboxOutput9Off();
 
-    // Helper for sending J1939 PGN (used by background tasks)
-    bool sendJ1939Pgn(uint8_t priority, uint32_t pgn, uint8_t source_addr, const uint8_t data[8]);
+    // J1939 addressing: claims config.j1939.preferred_address (or a free one; used as is when address_claim is
+    // off) and stamps it on every outbound extended frame, whatever source_address the frame config carries
+    void configureAddressing(const DeviceConfig& config);
+    uint8_t sourceAddress() const { return address_claim_.address(); }
+    J1939AddressClaim::State addressState() const { return address_claim_.state(); }
+    uint64_t j1939Name() const { return address_claim_.name(); }
+    uint32_t addressContentions() const { return address_claim_.contentions(); }
+
+    // J1939 messages of any length: single frame up to 8 bytes, transport protocol above
+    // (BAM for destination 0xFF, RTS/CTS otherwise). Reassembled inbound messages go to the handlers.
+    bool sendJ1939Message(uint32_t pgn, uint8_t priority, uint8_t destination, const uint8_t* data, uint16_t length,
+                          J1939Transport::CompletionHandler done = nullptr, void* context = nullptr);
+    bool addJ1939Handler(J1939Transport::MessageHandler handler, void* context = nullptr);
+    J1939TransportStats transportStats() const { return transport_.stats(); }
+
+    // Helper for sending a single J1939 PGN from our address; queued like sendFrame
+    bool sendJ1939Pgn(uint8_t priority, uint32_t pgn, const uint8_t data[8], CanTxCallback callback = nullptr,
+                      void* context = nullptr);
 
     bool isReady() const { return ready_; }
-    gpio_num_t txPin() const { return tx_pin_; }
-    gpio_num_t rxPin() const { return rx_pin_; }
+    int txPin() const { return tx_pin_; }
+    int rxPin() const { return rx_pin_; }
 
 private:
-    CanManager() = default;
+    CanManager();
 
+    CanDriver* driver_ = nullptr;
     bool ready_ = false;
-    gpio_num_t tx_pin_ = DEFAULT_TX_PIN;
-    gpio_num_t rx_pin_ = DEFAULT_RX_PIN;
+    int tx_pin_ = DEFAULT_TX_PIN;
+    int rx_pin_ = DEFAULT_RX_PIN;
     std::uint32_t bitrate_ = 250000;
+    std::uint32_t configured_bitrate_ = 250000;
+    bool auto_baud_ = false;
+    CanAutoBaudResult auto_baud_result_{};
+
+    CanRxRing rx_ring_;
+    CanRxCursor legacy_cursor_{};
+    CanSpinLock rx_lock_;  // One ring producer at a time (RX task, injectRx)
+    CanTask rx_task_;
+    std::atomic<bool> rx_running_{false};
+    std::atomic<bool> rx_task_active_{false};
+    std::atomic<uint32_t> rx_frames_{0};
+    std::atomic<uint32_t> rx_filtered_{0};
+    std::atomic<uint32_t> proto_dropped_{0};
+
+    J1939Transport transport_;
+    J1939AddressClaim address_claim_;
+    bool address_claim_enabled_ = false;
+    CanTask proto_task_;
+    std::atomic<bool> proto_running_{false};
+    std::atomic<bool> proto_task_active_{false};
+
+    CanBusStats bus_stats_;
+    CanTask alert_task_;
+    std::atomic<bool> alert_running_{false};
+    std::atomic<bool> alert_task_active_{false};
+
+    CanReplayEngine replay_;
+    std::atomic<CanReplayTarget> replay_target_{CanReplayTarget::VIRTUAL};
+    CanTask replay_task_;
+
+    CanFilterPlanner filter_planner_;
+    CanFilterPlan filter_plan_{};
+    bool filter_enabled_ = false;
+
+    CanButtonCoalescer button_coalescer_;
+    CanTxQueue tx_queue_;
+    mutable CanSpinLock tx_lock_;  // Also guards the driver FIFO below
+    // Frames in the driver's TX queue, oldest first; TX-complete alerts are matched by count
+    struct DriverTx {
+        uint16_t trace_id = 0;
+        bool spaced = false;  // Report to the button coalescer when it completes
+        uint32_t identifier = 0;
+    };
+    static constexpr std::size_t DRIVER_FIFO_SIZE = 16;
+    std::array<DriverTx, DRIVER_FIFO_SIZE> driver_fifo_{};
+    std::size_t driver_fifo_head_ = 0;
+    std::size_t driver_fifo_count_ = 0;
+    CanTask tx_task_;
+    std::atomic<bool> tx_running_{false};
+    std::atomic<bool> tx_task_active_{false};
+    std::atomic<uint32_t> tx_queued_{0};
+    std::atomic<uint32_t> tx_sent_{0};
+    std::atomic<uint32_t> tx_failed_{0};
+    std::atomic<uint32_t> tx_rejected_{0};
+    std::atomic<uint32_t> tx_recoveries_{0};
 
     std::uint32_t buildIdentifier(const CanFrameConfig& frame) const;
+    bool startRxTask();
+    void stopRxTask();
+    static void rxTaskEntry(void* arg);
+    void rxTaskLoop();
+    bool deliverRx(uint32_t identifier, bool extended, const uint8_t* data, uint8_t length, uint64_t timestamp_us,
+                   uint16_t trace_flags);
+    bool startReplayTask();
+    static void replayTaskEntry(void* arg);
+    void replayTaskLoop();
+    bool startProtoTask();
+    void stopProtoTask();
+    static void protoTaskEntry(void* arg);
+    bool sendButtonFrame(const ButtonConfig& button, const CanFrameConfig& frame, uint16_t press_id);
+    CanTxRequest requestFor(const CanFrameConfig& frame) const;
+    void protoTaskLoop();
+    bool startAlertTask();
+    void stopAlertTask();
+    static void alertTaskEntry(void* arg);
+    void alertTaskLoop();
+    bool startTxTask();
+    void stopTxTask();
+    static void txTaskEntry(void* arg);
+    void txTaskLoop();
+    bool dequeueTx(CanTxRequest& request);
+    bool ensureBusRunning();
+    bool transmitNow(const CanTxRequest& request);
+    void completeDriverTx(uint32_t alerts, uint32_t tx_pending, uint64_t now_us);
+    void clearDriverFifo();
 };
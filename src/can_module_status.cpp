@@ -0,0 +1,255 @@
+#include "can_module_status.h"
+
+#include <algorithm>
+
+#include "can_types.h"
+
+namespace {
+constexpr std::uint8_t kPollPriority = 6;
+constexpr std::uint32_t kCurrentStepMa = 10;
+constexpr std::uint32_t kIdleWaitMs = 1000;
+
+// Wrap-safe "a is at or after b" for millisecond timestamps
+bool reached(std::uint32_t now_ms, std::uint32_t due_ms) {
+    return static_cast<std::int32_t>(now_ms - due_ms) >= 0;
+}
+}
+
+CanModuleStatus& CanModuleStatus::instance() {
+    static CanModuleStatus status;
+    return status;
+}
+
+std::uint8_t CanModuleStatus::outputCount(const std::string& type) {
+    return type == "inmotion" ? 4 : 10;
+}
+
+const char* CanModuleStatus::stateName(CanOutputState state) {
+    switch (state) {
+        case CanOutputState::OFF: return "off";
+        case CanOutputState::ON: return "on";
+        case CanOutputState::FAULT: return "fault";
+        default: return "unknown";
+    }
+}
+
+bool CanModuleStatus::load(const std::vector<CanModuleConfig>& modules, std::string& error) {
+    if (modules.size() > kMaxModules) {
+        error = "Too many CAN modules";
+        return false;
+    }
+    for (std::size_t i = 0; i < modules.size(); ++i) {
+        const CanModuleConfig& cfg = modules[i];
+        if (cfg.address < 1 || cfg.address > 16) {
+            error = "CAN module '" + cfg.id + "' address must be 1-16";
+            return false;
+        }
+        for (std::size_t j = 0; j < i; ++j) {
+            if (modules[j].id == cfg.id) {
+                error = "Duplicate CAN module id '" + cfg.id + "'";
+                return false;
+            }
+            if (modules[j].address == cfg.address) {
+                error = "CAN modules '" + modules[j].id + "' and '" + cfg.id + "' share address " +
+                        std::to_string(cfg.address);
+                return false;
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        count_ = modules.size();
+        for (std::size_t i = 0; i < count_; ++i) {
+            const CanModuleConfig& cfg = modules[i];
+            Module& module = modules_[i];
+            module = Module{};
+            module.id = cfg.id;
+            module.name = cfg.name;
+            module.type = cfg.type;
+            module.address = cfg.address;
+            module.outputs = outputCount(cfg.type);
+            module.poll_interval_ms = cfg.poll_interval_ms;
+        }
+    }
+    bump();
+    return true;
+}
+
+std::uint32_t CanModuleStatus::staleAfterMs(const Module& module) const {
+    return module.poll_interval_ms ? module.poll_interval_ms * kStaleIntervals : kListenOnlyStaleMs;
+}
+
+std::uint32_t CanModuleStatus::tick(std::uint32_t now_ms) {
+    std::uint32_t wait_ms = kIdleWaitMs;
+    std::array<std::uint8_t, kMaxModules> due{};
+    std::size_t due_count = 0;
+    bool changed = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (std::size_t i = 0; i < count_; ++i) {
+            Module& module = modules_[i];
+            if (module.online && reached(now_ms, module.last_reply_ms + staleAfterMs(module))) {
+                module.online = false;
+                for (CanOutputStatus& status : module.status) {
+                    status = CanOutputStatus{};
+                }
+                changed = true;
+            }
+            if (module.online) {
+                wait_ms = std::min(wait_ms, module.last_reply_ms + staleAfterMs(module) - now_ms);
+            }
+
+            if (!module.poll_interval_ms) {
+                continue;
+            }
+            if (!module.poll_scheduled) {
+                // Spread first polls so a panel full of modules does not answer in one burst
+                module.next_poll_ms = now_ms + static_cast<std::uint32_t>(i) * 20;
+                module.poll_scheduled = true;
+            }
+            if (reached(now_ms, module.next_poll_ms)) {
+                due[due_count++] = module.address;
+                ++module.polls;
+                module.next_poll_ms += module.poll_interval_ms;
+                if (reached(now_ms, module.next_poll_ms)) {
+                    module.next_poll_ms = now_ms + module.poll_interval_ms;  // Fell behind; skip missed polls
+                }
+            }
+            wait_ms = std::min(wait_ms, module.next_poll_ms - now_ms);
+        }
+    }
+    if (changed) {
+        bump();
+    }
+    // The sink takes the TX queue lock; never call it with mutex_ held
+    for (std::size_t i = 0; i < due_count; ++i) {
+        sendPoll(due[i]);
+    }
+    return wait_ms;
+}
+
+bool CanModuleStatus::pollNow(std::uint8_t address) {
+    if (address < 1 || address > 16) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (std::size_t i = 0; i < count_; ++i) {
+            if (modules_[i].address == address) {
+                ++modules_[i].polls;
+            }
+        }
+    }
+    return sendPoll(address);
+}
+
+bool CanModuleStatus::sendPoll(std::uint8_t address) {
+    if (!sink_) {
+        return false;
+    }
+    const std::uint8_t data[8] = {kPollCommand, 0, 0, 0, 0, 0, 0, 0};
+    return sink_(buildJ1939Identifier(kPollPriority, pollPgn(address), 0, 0xFF), data, sizeof(data));
+}
+
+bool CanModuleStatus::decodeStatus(const std::uint8_t* data, std::uint8_t length, std::uint8_t outputs,
+                                   CanOutputStatus* status) {
+    if (length < 4) {
+        return false;
+    }
+    const std::uint16_t on_bits = static_cast<std::uint16_t>(data[0] | (data[1] << 8));
+    const std::uint16_t fault_bits = static_cast<std::uint16_t>(data[2] | (data[3] << 8));
+    bool changed = false;
+    for (std::uint8_t i = 0; i < outputs; ++i) {
+        const std::uint16_t bit = static_cast<std::uint16_t>(1u << i);
+        const CanOutputState state = (fault_bits & bit) ? CanOutputState::FAULT
+                                     : (on_bits & bit) ? CanOutputState::ON
+                                                       : CanOutputState::OFF;
+        changed |= status[i].state != state;
+        status[i].state = state;
+    }
+    if (length >= 7 && data[4] >= 1 && data[4] <= outputs) {
+        const std::uint32_t current = static_cast<std::uint32_t>(data[5] | (data[6] << 8)) * kCurrentStepMa;
+        CanOutputStatus& target = status[data[4] - 1];
+        const std::uint16_t current_ma = static_cast<std::uint16_t>(std::min<std::uint32_t>(current, UINT16_MAX));
+        changed |= target.current_ma != current_ma;
+        target.current_ma = current_ma;
+    }
+    return changed;
+}
+
+bool CanModuleStatus::onFrame(std::uint32_t identifier, const std::uint8_t* data, std::uint8_t length,
+                              std::uint32_t now_ms) {
+    const std::uint32_t pgn = j1939PgnFromIdentifier(identifier);
+    if ((pgn & 0x3FFF0) != 0xFF50) {
+        return false;
+    }
+    bool changed = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Module* module = nullptr;
+        for (std::size_t i = 0; i < count_; ++i) {
+            if (replyPgn(modules_[i].address) == pgn) {
+                module = &modules_[i];
+                break;
+            }
+        }
+        if (!module) {
+            return false;
+        }
+        ++module->replies;
+        module->last_reply_ms = now_ms;
+        changed = !module->online;
+        module->online = true;
+        changed |= decodeStatus(data, length, module->outputs, module->status.data());
+    }
+    if (changed) {
+        bump();
+    }
+    return true;
+}
+
+int CanModuleStatus::find(const std::string& id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::size_t i = 0; i < count_; ++i) {
+        if (modules_[i].id == id) {
+            return static_cast<int>(i);
+        }
+    }
+    return kNotFound;
+}
+
+CanOutputStatus CanModuleStatus::output(int module, std::uint8_t output) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (module < 0 || static_cast<std::size_t>(module) >= count_ || output < 1 ||
+        output > modules_[module].outputs) {
+        return CanOutputStatus{};
+    }
+    return modules_[module].status[output - 1];
+}
+
+std::vector<CanModuleSnapshot> CanModuleStatus::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<CanModuleSnapshot> result;
+    result.reserve(count_);
+    for (std::size_t i = 0; i < count_; ++i) {
+        const Module& module = modules_[i];
+        CanModuleSnapshot snap;
+        snap.id = module.id;
+        snap.name = module.name;
+        snap.type = module.type;
+        snap.address = module.address;
+        snap.online = module.online;
+        snap.last_reply_ms = module.last_reply_ms;
+        snap.polls = module.polls;
+        snap.replies = module.replies;
+        snap.outputs.assign(module.status.begin(), module.status.begin() + module.outputs);
+        result.push_back(std::move(snap));
+    }
+    return result;
+}
+
+std::size_t CanModuleStatus::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_;
+}
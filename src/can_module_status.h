@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "config_types.h"
+
+enum class CanOutputState : std::uint8_t { UNKNOWN, OFF, ON, FAULT };
+
+struct CanOutputStatus {
+    CanOutputState state = CanOutputState::UNKNOWN;
+    std::uint16_t current_ma = 0;  // Last reported load current; stays put between reports
+};
+
+struct CanModuleSnapshot {
+    std::string id;
+    std::string name;
+    std::string type;
+    std::uint8_t address = 0;
+    bool online = false;
+    std::uint32_t last_reply_ms = 0;
+    std::uint32_t polls = 0;
+    std::uint32_t replies = 0;
+    std::vector<CanOutputStatus> outputs;
+};
+
+/**
+ * Output state of POWERCELL / inMOTION modules, as the modules report it.
+ *
+ * Each configured module is polled on PGN FF4x (x = address, 16 -> 0) and
+ * answers on FF5x. tick() sends the due polls and onFrame() decodes the
+ * replies into a per-output table; both run on the CAN protocol task, never
+ * on loop(). A module that misses three poll intervals goes offline and its
+ * outputs fall back to UNKNOWN.
+ *
+ * Status reply payload (decodeStatus()):
+ *   bytes 0-1  output on bits, byte 0 bit 0 = output 1
+ *   bytes 2-3  output fault bits, same positions
+ *   byte  4    output whose current follows (1-based, 0 = none)
+ *   bytes 5-6  that output's current, little endian, 10 mA per bit
+ *
+ * Consumers do not get callbacks: every change bumps generation(), and the
+ * UI compares it once per frame, so a burst of replies costs one redraw.
+ */
+class CanModuleStatus {
+public:
+    static constexpr std::size_t kMaxModules = MAX_CAN_MODULES;
+    static constexpr std::size_t kMaxOutputs = 10;
+    static constexpr std::uint32_t kStaleIntervals = 3;
+    static constexpr std::uint32_t kListenOnlyStaleMs = 5000;  // Offline timeout for modules that are not polled
+    static constexpr std::uint8_t kPollCommand = 0x11;
+    static constexpr int kNotFound = -1;
+
+    // Returns true when the frame was accepted for transmission
+    using FrameSink = bool (*)(std::uint32_t identifier, const std::uint8_t* data, std::uint8_t length);
+
+    static CanModuleStatus& instance();
+
+    bool load(const std::vector<CanModuleConfig>& modules, std::string& error);
+    void setSink(FrameSink sink) { sink_ = sink; }
+
+    // Sends due polls, ages out silent modules; returns ms until the next poll or timeout
+    std::uint32_t tick(std::uint32_t now_ms);
+    // Returns true when the frame was a status reply from a configured module
+    bool onFrame(std::uint32_t identifier, const std::uint8_t* data, std::uint8_t length, std::uint32_t now_ms);
+    // Polls any address now (configured or not); the reply shows up on the next tick/onFrame
+    bool pollNow(std::uint8_t address);
+
+    int find(const std::string& id) const;
+    CanOutputStatus output(int module, std::uint8_t output) const;  // output is 1-based
+    std::vector<CanModuleSnapshot> snapshot() const;
+    std::size_t size() const;
+    std::uint32_t generation() const { return generation_.load(std::memory_order_acquire); }
+
+    static std::uint8_t outputCount(const std::string& type);
+    static std::uint32_t pollPgn(std::uint8_t address) { return 0xFF40 + (address & 0x0F); }
+    static std::uint32_t replyPgn(std::uint8_t address) { return 0xFF50 + (address & 0x0F); }
+    static const char* stateName(CanOutputState state);
+    // Applies one status payload; returns true when any output changed
+    static bool decodeStatus(const std::uint8_t* data, std::uint8_t length, std::uint8_t outputs,
+                             CanOutputStatus* status);
+
+private:
+    CanModuleStatus() = default;
+
+    struct Module {
+        std::string id;
+        std::string name;
+        std::string type;
+        std::uint8_t address = 0;
+        std::uint8_t outputs = 0;
+        std::uint32_t poll_interval_ms = 0;
+        std::uint32_t next_poll_ms = 0;
+        bool poll_scheduled = false;  // next_poll_ms is set (the clock has been seen)
+        bool online = false;
+        std::uint32_t last_reply_ms = 0;
+        std::uint32_t polls = 0;
+        std::uint32_t replies = 0;
+        std::array<CanOutputStatus, kMaxOutputs> status{};
+    };
+
+    bool sendPoll(std::uint8_t address);
+    std::uint32_t staleAfterMs(const Module& module) const;
+    void bump() { generation_.fetch_add(1, std::memory_order_acq_rel); }
+
+    mutable std::mutex mutex_;
+    std::array<Module, kMaxModules> modules_{};
+    std::size_t count_ = 0;
+    FrameSink sink_ = nullptr;
+    std::atomic<std::uint32_t> generation_{1};
+};
@@ -0,0 +1,267 @@
+#include "can_periodic.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "can_types.h"
+
+#ifdef ARDUINO
+#include <esp_timer.h>
+#endif
+
+namespace {
+constexpr std::uint32_t kMinPeriodMs = 10;
+constexpr std::uint64_t kMinTimerDelayUs = 50;  // esp_timer rejects/coalesces shorter one-shots
+}
+
+CanPeriodicScheduler& CanPeriodicScheduler::instance() {
+    static CanPeriodicScheduler scheduler;
+    return scheduler;
+}
+
+bool CanPeriodicScheduler::load(const std::vector<CanPeriodicConfig>& entries, std::string& error) {
+    std::vector<CanPeriodicConfig> active;
+    for (const CanPeriodicConfig& cfg : entries) {
+        if (!cfg.enabled) {
+            continue;
+        }
+        if (cfg.period_ms < kMinPeriodMs) {
+            error = "Periodic frame '" + cfg.id + "' period below 10 ms";
+            return false;
+        }
+        active.push_back(cfg);
+    }
+    if (active.size() > kMaxEntries) {
+        error = "Too many periodic CAN frames";
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        count_ = active.size();
+        for (std::size_t i = 0; i < count_; ++i) {
+            const CanPeriodicConfig& cfg = active[i];
+            Entry& entry = entries_[i];
+            entry = Entry{};
+            entry.id = cfg.id;
+            entry.identifier = buildJ1939Identifier(cfg.priority, cfg.pgn, cfg.source_address, cfg.destination_address);
+            entry.length = std::min<std::uint8_t>(cfg.length, 8);
+            std::memcpy(entry.data, cfg.data.data(), sizeof(entry.data));
+            entry.period_ms = cfg.period_ms;
+        }
+        assignPhases(active);
+
+        const std::uint64_t now_us = now();
+        for (std::size_t i = 0; i < count_; ++i) {
+            entries_[i].next_due_us = now_us + static_cast<std::uint64_t>(entries_[i].phase_ms) * 1000;
+        }
+    }
+
+    if (running_) {
+        armTimer(0);
+    }
+    return true;
+}
+
+void CanPeriodicScheduler::assignPhases(const std::vector<CanPeriodicConfig>& configs) {
+    std::uint32_t horizon = kMinPeriodMs;
+    for (std::size_t i = 0; i < count_; ++i) {
+        horizon = std::max(horizon, entries_[i].period_ms);
+    }
+    horizon = std::min(horizon, kPhaseHorizonMs);
+
+    // Frames occupying each 1 ms slot of the window
+    std::vector<std::uint16_t> occupancy(horizon, 0);
+    auto occupy = [&](std::uint32_t phase, std::uint32_t period) {
+        for (std::uint32_t t = phase; t < horizon; t += period) {
+            ++occupancy[t];
+        }
+    };
+
+    std::vector<std::size_t> automatic;
+    for (std::size_t i = 0; i < count_; ++i) {
+        if (configs[i].phase_ms >= 0) {
+            entries_[i].phase_ms = static_cast<std::uint32_t>(configs[i].phase_ms) % entries_[i].period_ms;
+            occupy(entries_[i].phase_ms, entries_[i].period_ms);
+        } else {
+            automatic.push_back(i);
+        }
+    }
+
+    // Shortest periods are the most constrained, so they pick first
+    std::stable_sort(automatic.begin(), automatic.end(), [this](std::size_t a, std::size_t b) {
+        return entries_[a].period_ms < entries_[b].period_ms;
+    });
+
+    for (std::size_t index : automatic) {
+        Entry& entry = entries_[index];
+        const std::uint32_t candidates = std::min(entry.period_ms, horizon);
+        std::uint32_t best_phase = 0;
+        std::uint32_t best_cost = UINT32_MAX;
+        for (std::uint32_t phase = 0; phase < candidates && best_cost != 0; ++phase) {
+            std::uint32_t cost = 0;
+            for (std::uint32_t t = phase; t < horizon; t += entry.period_ms) {
+                cost += occupancy[t];
+            }
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_phase = phase;
+            }
+        }
+        entry.phase_ms = best_phase;
+        occupy(best_phase, entry.period_ms);
+    }
+}
+
+std::uint64_t CanPeriodicScheduler::tick(std::uint64_t now_us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::uint64_t next_wait = kIdle;
+
+    for (std::size_t i = 0; i < count_; ++i) {
+        Entry& entry = entries_[i];
+        const std::uint64_t period_us = static_cast<std::uint64_t>(entry.period_ms) * 1000;
+
+        if (now_us >= entry.next_due_us) {
+            const std::uint64_t late_us = now_us - entry.next_due_us;
+            const bool ok = sink_ ? sink_(entry.identifier, entry.data, entry.length) : false;
+            if (ok) {
+                ++entry.sent;
+            } else {
+                ++entry.rejected;
+            }
+            entry.max_late_us = std::max<std::uint32_t>(entry.max_late_us, static_cast<std::uint32_t>(late_us));
+            entry.total_late_us += late_us;
+
+            // Stay on the original grid; if the timer ran a full period late, skip rather than burst
+            entry.next_due_us += period_us;
+            if (entry.next_due_us <= now_us) {
+                const std::uint64_t skipped = (now_us - entry.next_due_us) / period_us + 1;
+                entry.missed += static_cast<std::uint32_t>(skipped);
+                entry.next_due_us += skipped * period_us;
+            }
+        }
+
+        next_wait = std::min(next_wait, entry.next_due_us - now_us);
+    }
+    return next_wait;
+}
+
+std::vector<CanPeriodicScheduler::EntryStats> CanPeriodicScheduler::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<EntryStats> out;
+    out.reserve(count_);
+    for (std::size_t i = 0; i < count_; ++i) {
+        const Entry& entry = entries_[i];
+        const std::uint32_t samples = entry.sent + entry.rejected;
+        EntryStats stats;
+        stats.id = entry.id;
+        stats.period_ms = entry.period_ms;
+        stats.phase_ms = entry.phase_ms;
+        stats.sent = entry.sent;
+        stats.rejected = entry.rejected;
+        stats.missed = entry.missed;
+        stats.max_late_us = entry.max_late_us;
+        stats.avg_late_us = samples ? static_cast<std::uint32_t>(entry.total_late_us / samples) : 0;
+        out.push_back(std::move(stats));
+    }
+    return out;
+}
+
+void CanPeriodicScheduler::resetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::size_t i = 0; i < count_; ++i) {
+        Entry& entry = entries_[i];
+        entry.sent = 0;
+        entry.rejected = 0;
+        entry.missed = 0;
+        entry.max_late_us = 0;
+        entry.total_late_us = 0;
+    }
+}
+
+std::size_t CanPeriodicScheduler::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_;
+}
+
+float CanPeriodicScheduler::busLoadPercent(std::uint32_t bitrate) const {
+    if (bitrate == 0) {
+        return 0.0f;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    float bits_per_second = 0.0f;
+    for (std::size_t i = 0; i < count_; ++i) {
+        bits_per_second += canExtendedFrameBits(entries_[i].length) * 1000.0f / entries_[i].period_ms;
+    }
+    return bits_per_second * 100.0f / bitrate;
+}
+
+std::uint64_t CanPeriodicScheduler::now() const {
+    return clock_ ? clock_() : 0;
+}
+
+#ifdef ARDUINO
+void CanPeriodicScheduler::armTimer(std::uint64_t delay_us) {
+    if (!timer_ || delay_us == kIdle) {
+        return;
+    }
+    auto handle = static_cast<esp_timer_handle_t>(timer_);
+    esp_timer_stop(handle);  // Not running is fine
+    esp_timer_start_once(handle, std::max(delay_us, kMinTimerDelayUs));
+}
+
+void CanPeriodicScheduler::start() {
+    if (running_) {
+        return;
+    }
+    if (!clock_) {
+        clock_ = []() -> std::uint64_t { return static_cast<std::uint64_t>(esp_timer_get_time()); };
+    }
+    if (!timer_) {
+        esp_timer_create_args_t args = {};
+        args.callback = [](void* arg) {
+            auto* self = static_cast<CanPeriodicScheduler*>(arg);
+            const std::uint64_t wait_us = self->tick(self->now());
+            if (self->running_) {
+                self->armTimer(wait_us);
+            }
+        };
+        args.arg = this;
+        args.dispatch_method = ESP_TIMER_TASK;
+        args.name = "can_periodic";
+        esp_timer_handle_t handle = nullptr;
+        if (esp_timer_create(&args, &handle) != ESP_OK) {
+            return;
+        }
+        timer_ = handle;
+    }
+    running_ = true;
+
+    // Re-anchor the schedule so frames don't all fire at once after a pause
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const std::uint64_t now_us = now();
+        for (std::size_t i = 0; i < count_; ++i) {
+            entries_[i].next_due_us = now_us + static_cast<std::uint64_t>(entries_[i].phase_ms) * 1000;
+        }
+    }
+    armTimer(0);
+}
+
+void CanPeriodicScheduler::stop() {
+    running_ = false;
+    if (timer_) {
+        esp_timer_stop(static_cast<esp_timer_handle_t>(timer_));
+    }
+}
+#else
+void CanPeriodicScheduler::armTimer(std::uint64_t) {}
+
+void CanPeriodicScheduler::start() {
+    running_ = true;
+}
+
+void CanPeriodicScheduler::stop() {
+    running_ = false;
+}
+#endif
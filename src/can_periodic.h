@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "config_types.h"
+
+/**
+ * Cyclic CAN transmit scheduler (heartbeats, keep-alives, LOC refresh).
+ *
+ * Holds up to MAX_CAN_PERIODIC frames, each with its own period and phase
+ * offset, and drives all of them from a single one-shot esp_timer that is
+ * re-armed for the earliest due frame. Frames configured without a phase
+ * are placed where they overlap least with frames already scheduled, so the
+ * bus sees a steady trickle instead of bursts on common period boundaries.
+ *
+ * tick() takes the time explicitly so the schedule can run against a
+ * simulated clock.
+ */
+class CanPeriodicScheduler {
+public:
+    static constexpr std::size_t kMaxEntries = MAX_CAN_PERIODIC;
+    static constexpr std::uint64_t kIdle = UINT64_MAX;
+    static constexpr std::uint32_t kPhaseHorizonMs = 10000;  // Window used when spreading phases
+
+    struct EntryStats {
+        std::string id;
+        std::uint32_t period_ms = 0;
+        std::uint32_t phase_ms = 0;
+        std::uint32_t sent = 0;
+        std::uint32_t rejected = 0;      // TX queue refused the frame
+        std::uint32_t missed = 0;        // Whole periods skipped because the timer ran late
+        std::uint32_t max_late_us = 0;   // Worst release jitter
+        std::uint32_t avg_late_us = 0;
+    };
+
+    // Returns true when the frame was accepted for transmission
+    using FrameSink = bool (*)(std::uint32_t identifier, const std::uint8_t* data, std::uint8_t length);
+    using Clock = std::uint64_t (*)();
+
+    static CanPeriodicScheduler& instance();
+
+    bool load(const std::vector<CanPeriodicConfig>& entries, std::string& error);
+
+    // Sends every due frame and returns microseconds until the next one (kIdle when empty)
+    std::uint64_t tick(std::uint64_t now_us);
+
+    std::vector<EntryStats> stats() const;
+    void resetStats();
+    std::size_t size() const;
+    // Share of the bus the configured frames occupy (worst-case stuffing)
+    float busLoadPercent(std::uint32_t bitrate) const;
+
+    void setSink(FrameSink sink) { sink_ = sink; }
+    void setClock(Clock clock) { clock_ = clock; }
+    void start();
+    void stop();
+
+private:
+    CanPeriodicScheduler() = default;
+
+    struct Entry {
+        std::string id;
+        std::uint32_t identifier = 0;
+        std::uint8_t data[8] = {};
+        std::uint8_t length = 0;
+        std::uint32_t period_ms = 0;
+        std::uint32_t phase_ms = 0;
+        std::uint64_t next_due_us = 0;
+        std::uint32_t sent = 0;
+        std::uint32_t rejected = 0;
+        std::uint32_t missed = 0;
+        std::uint32_t max_late_us = 0;
+        std::uint64_t total_late_us = 0;
+    };
+
+    void assignPhases(const std::vector<CanPeriodicConfig>& configs);
+    std::uint64_t now() const;
+    void armTimer(std::uint64_t delay_us);
+
+    mutable std::mutex mutex_;
+    std::array<Entry, kMaxEntries> entries_{};
+    std::size_t count_ = 0;
+    FrameSink sink_ = nullptr;
+    Clock clock_ = nullptr;
+    void* timer_ = nullptr;  // esp_timer_handle_t on device
+    std::atomic<bool> running_{false};
+};
@@ -0,0 +1,154 @@
+#include "can_platform.h"
+
+#ifdef ARDUINO
+#include <esp_random.h>
+#include <esp_timer.h>
+#include <freertos/task.h>
+#else
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#endif
+
+#ifdef ARDUINO
+std::uint32_t canMillis() {
+    return millis();
+}
+
+std::uint64_t canMicros() {
+    return static_cast<std::uint64_t>(esp_timer_get_time());
+}
+
+void canDelayMs(std::uint32_t ms) {
+    vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+std::uint32_t canRandom() {
+    return esp_random();
+}
+
+std::uint64_t canDeviceId() {
+    return ESP.getEfuseMac();
+}
+
+bool CanTask::start(const char* name, std::uint32_t stack, std::uint32_t priority, int core, Entry entry, void* arg) {
+    entry_ = entry;
+    arg_ = arg;
+    // The handle is written before the task first runs, so it can be notified right away
+    if (xTaskCreatePinnedToCore(trampoline, name, stack, this, priority, reinterpret_cast<TaskHandle_t*>(&handle_),
+                                core) != pdPASS) {
+        handle_ = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void CanTask::trampoline(void* self) {
+    auto* task = static_cast<CanTask*>(self);
+    task->entry_(task->arg_);
+    vTaskDelete(nullptr);
+}
+
+void CanTask::notify() {
+    if (handle_) {
+        xTaskNotifyGive(static_cast<TaskHandle_t>(handle_));
+    }
+}
+
+std::uint32_t CanTask::wait(std::uint32_t timeout_ms) {
+    return ulTaskNotifyTake(pdTRUE, timeout_ms == kWaitForever ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms));
+}
+
+void CanSpinLock::lock() {
+    portENTER_CRITICAL(&mux_);
+}
+
+void CanSpinLock::unlock() {
+    portEXIT_CRITICAL(&mux_);
+}
+#else
+namespace {
+std::atomic<CanClock> g_clock{nullptr};
+
+std::uint64_t steadyMicros() {
+    static const auto origin = std::chrono::steady_clock::now();
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin).count());
+}
+}
+
+void canSetClock(CanClock clock) {
+    g_clock.store(clock);
+}
+
+std::uint32_t canMillis() {
+    return static_cast<std::uint32_t>(canMicros() / 1000);
+}
+
+std::uint64_t canMicros() {
+    const CanClock clock = g_clock.load();
+    return clock ? clock() : steadyMicros();
+}
+
+void canDelayMs(std::uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+std::uint32_t canRandom() {
+    static std::mt19937 generator(0x4A313933);  // Fixed seed keeps host runs reproducible
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    return generator();
+}
+
+std::uint64_t canDeviceId() {
+    return 0x00A1B2C3D4E5ull;
+}
+
+// Stack size, priority and core have no host equivalent; the thread runs at normal priority
+bool CanTask::start(const char*, std::uint32_t, std::uint32_t, int, Entry entry, void* arg) {
+    entry_ = entry;
+    arg_ = arg;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_ = 0;
+    }
+    handle_ = this;
+    std::thread(trampoline, this).detach();
+    return true;
+}
+
+void CanTask::trampoline(void* self) {
+    auto* task = static_cast<CanTask*>(self);
+    task->entry_(task->arg_);
+}
+
+void CanTask::notify() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++pending_;
+    }
+    wake_.notify_one();
+}
+
+std::uint32_t CanTask::wait(std::uint32_t timeout_ms) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (timeout_ms == kWaitForever) {
+        wake_.wait(lock, [this]() { return pending_ != 0; });
+    } else {
+        wake_.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this]() { return pending_ != 0; });
+    }
+    const std::uint32_t taken = pending_;
+    pending_ = 0;
+    return taken;
+}
+
+void CanSpinLock::lock() {
+    mutex_.lock();
+}
+
+void CanSpinLock::unlock() {
+    mutex_.unlock();
+}
+#endif
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#else
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#endif
+
+// OS layer under CanManager: time, delays, tasks and a short-section lock.
+// FreeRTOS and esp_timer on the device; std::thread and std::chrono on host
+// builds, where the clock can be replaced to run the CAN stack on simulated time.
+
+#ifdef ARDUINO
+#define CAN_LOGF(...) Serial.printf(__VA_ARGS__)
+#else
+#define CAN_LOGF(...) std::printf(__VA_ARGS__)
+#endif
+
+std::uint32_t canMillis();
+std::uint64_t canMicros();
+void canDelayMs(std::uint32_t ms);
+std::uint32_t canRandom();
+std::uint64_t canDeviceId();  // Stable per unit (eFuse MAC on the device)
+
+#ifndef ARDUINO
+using CanClock = std::uint64_t (*)();
+void canSetClock(CanClock clock);  // nullptr restores the steady clock
+#endif
+
+/**
+ * A pinned task with a notification counter (a FreeRTOS task on the device,
+ * a detached std::thread on host). The object must outlive the task.
+ */
+class CanTask {
+public:
+    static constexpr std::uint32_t kWaitForever = UINT32_MAX;
+    using Entry = void (*)(void* arg);
+
+    bool start(const char* name, std::uint32_t stack, std::uint32_t priority, int core, Entry entry, void* arg);
+    // Forget the task once it has returned from its entry function
+    void reset() { handle_ = nullptr; }
+    bool started() const { return handle_ != nullptr; }
+
+    void notify();
+    // Called by the task itself; returns the notifications taken (0 on timeout)
+    std::uint32_t wait(std::uint32_t timeout_ms);
+
+private:
+    static void trampoline(void* self);
+
+    Entry entry_ = nullptr;
+    void* arg_ = nullptr;
+    void* handle_ = nullptr;  // TaskHandle_t on device
+#ifndef ARDUINO
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::uint32_t pending_ = 0;
+#endif
+};
+
+// Guards a few instructions shared between tasks (a critical section on the device)
+class CanSpinLock {
+public:
+    void lock();
+    void unlock();
+
+private:
+#ifdef ARDUINO
+    portMUX_TYPE mux_ = portMUX_INITIALIZER_UNLOCKED;
+#else
+    std::mutex mutex_;
+#endif
+};
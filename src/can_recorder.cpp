@@ -0,0 +1,338 @@
+#include "can_recorder.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+#include "psram_alloc.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <sys/time.h>
+#endif
+
+namespace {
+constexpr std::uint32_t kMinSegmentKb = 16;
+constexpr std::uint32_t kWriterIdleMs = 1000;
+constexpr std::uint32_t kCollectorStack = 3072;
+constexpr std::uint32_t kWriterStack = 4096;
+constexpr std::uint64_t kUnixTimeValid = 1600000000ull;  // Clock set from NTP/OTA, not the 1970 default
+
+#ifdef ARDUINO
+bool parseSegmentName(const char* name, std::uint32_t& index) {
+    const char* base = std::strrchr(name, '/');
+    base = base ? base + 1 : name;
+    unsigned long value = 0;
+    char suffix[8] = {};
+    if (std::sscanf(base, "%8lu.%7s", &value, suffix) != 2 || std::strcmp(suffix, "clg") != 0) {
+        return false;
+    }
+    index = static_cast<std::uint32_t>(value);
+    return true;
+}
+#endif
+}
+
+CanRecorder& CanRecorder::instance() {
+    static CanRecorder recorder;
+    return recorder;
+}
+
+std::string CanRecorder::segmentPath(std::uint32_t index) {
+    char path[32];
+    std::snprintf(path, sizeof(path), "%s/%08lu.clg", kDirectory, static_cast<unsigned long>(index));
+    return path;
+}
+
+bool CanRecorder::allocate() {
+    if (pool_) {
+        return true;
+    }
+    void* storage = psramAlloc(kBlockPool * sizeof(Block));
+    if (!storage) {
+        return false;
+    }
+    pool_ = new (storage) Block[kBlockPool];
+    return true;
+}
+
+void CanRecorder::configure(const CanRecorderConfig& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    config_ = config;
+    config_.max_segment_kb = std::max(config_.max_segment_kb, kMinSegmentKb);
+    config_.max_total_kb = std::max(config_.max_total_kb, config_.max_segment_kb);
+    if (config_.enabled && !allocate()) {
+        config_.enabled = false;
+    }
+    flush_interval_ms_.store(config_.flush_interval_ms);
+    enabled_.store(config_.enabled);
+    if (config_.enabled) {
+        startTasks();
+    }
+}
+
+CanRecorder::Status CanRecorder::status() const {
+    Status result;
+    result.enabled = enabled_.load();
+    result.blocks_written = blocks_written_.load(std::memory_order_relaxed);
+    result.records_written = records_written_.load(std::memory_order_relaxed);
+    result.records_dropped = records_dropped_.load(std::memory_order_relaxed);
+    result.write_errors = write_errors_.load(std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        result.segment = segment_;
+    }
+    for (const SegmentInfo& info : segments()) {
+        result.bytes_on_disk += info.size;
+    }
+    return result;
+}
+
+// Collector: runs on the CAN core, only copies records; never touches flash
+void CanRecorder::collect(std::uint32_t now_ms) {
+    CanTrace& trace = CanTrace::instance();
+    if (!enabled_.load(std::memory_order_relaxed)) {
+        cursor_ = trace.openCursor();  // Resume from "now" when re-enabled
+        cursor_dropped_seen_ = 0;
+        return;
+    }
+
+    CanTraceRecord rec;
+    while (trace.pop(cursor_, rec)) {
+        if (sealed_.load(std::memory_order_relaxed) - written_.load(std::memory_order_acquire) >= kBlockPool) {
+            ++pending_dropped_;  // Every block is still queued for flash
+            records_dropped_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        Block& block = pool_[sealed_.load(std::memory_order_relaxed) % kBlockPool];
+        if (fill_count_ == 0) {
+            fill_started_ms_ = now_ms;
+        }
+        block.records[fill_count_++] = rec;
+        if (fill_count_ == kCanLogRecordsPerBlock) {
+            seal();
+        }
+    }
+
+    if (cursor_.dropped != cursor_dropped_seen_) {
+        const std::uint32_t lost = cursor_.dropped - cursor_dropped_seen_;
+        cursor_dropped_seen_ = cursor_.dropped;
+        pending_dropped_ += lost;
+        records_dropped_.fetch_add(lost, std::memory_order_relaxed);
+    }
+
+    const bool flush = flush_requested_.exchange(false);
+    if (fill_count_ && (flush || now_ms - fill_started_ms_ >= flush_interval_ms_.load(std::memory_order_relaxed))) {
+        seal();
+    }
+}
+
+void CanRecorder::seal() {
+    const std::uint32_t sealed = sealed_.load(std::memory_order_relaxed);
+    Block& block = pool_[sealed % kBlockPool];
+    block.header.magic = kCanLogBlockMagic;
+    block.header.sequence = block_sequence_++;
+    block.header.count = static_cast<std::uint16_t>(fill_count_);
+    block.header.reserved = 0;
+    block.header.dropped = pending_dropped_;
+    block.header.crc = 0;  // Filled in by the writer, off the CAN core
+    pending_dropped_ = 0;
+    fill_count_ = 0;
+    sealed_.store(sealed + 1, std::memory_order_release);
+#ifdef ARDUINO
+    if (writer_handle_) {
+        xTaskNotifyGive(static_cast<TaskHandle_t>(writer_handle_));
+    }
+#endif
+}
+
+#ifdef ARDUINO
+void CanRecorder::startTasks() {
+    if (tasks_started_) {
+        return;
+    }
+    TaskHandle_t writer = nullptr;
+    if (xTaskCreatePinnedToCore(writerTask, "can_logw", kWriterStack, this, 1, &writer, 0) != pdPASS) {
+        Serial.println("[CanRecorder] Failed to start writer task");
+        return;
+    }
+    writer_handle_ = writer;
+    cursor_ = CanTrace::instance().openCursor();
+    // Below the RX/TX/protocol tasks on the CAN core; the trace ring absorbs its 20 ms period
+    if (xTaskCreatePinnedToCore(collectorTask, "can_log", kCollectorStack, this, 2, nullptr, 1) != pdPASS) {
+        Serial.println("[CanRecorder] Failed to start collector task");
+        return;
+    }
+    tasks_started_ = true;
+}
+
+void CanRecorder::collectorTask(void* arg) {
+    auto* self = static_cast<CanRecorder*>(arg);
+    while (true) {
+        self->collect(millis());
+        vTaskDelay(pdMS_TO_TICKS(kCollectIntervalMs));
+    }
+}
+
+void CanRecorder::writerTask(void* arg) {
+    auto* self = static_cast<CanRecorder*>(arg);
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(kWriterIdleMs));
+        self->writePending();
+        if (!self->enabled_.load()) {
+            std::lock_guard<std::mutex> lock(self->mutex_);
+            self->closeSegment();
+        }
+    }
+}
+
+void CanRecorder::writePending() {
+    while (written_.load(std::memory_order_relaxed) != sealed_.load(std::memory_order_acquire)) {
+        const std::uint32_t index = written_.load(std::memory_order_relaxed);
+        Block& block = pool_[index % kBlockPool];
+        const std::size_t record_bytes = block.header.count * sizeof(CanTraceRecord);
+        block.header.crc = canLogCrc32(reinterpret_cast<const std::uint8_t*>(block.records), record_bytes);
+        const std::size_t bytes = sizeof(CanLogBlockHeader) + record_bytes;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (file_ && segment_bytes_ + bytes > config_.max_segment_kb * 1024u) {
+                closeSegment();
+            }
+            if (!file_) {
+                openSegment();
+            }
+            // Header and records are contiguous in the block, so each block is a single append
+            if (file_ && file_.write(reinterpret_cast<const std::uint8_t*>(&block), bytes) == bytes) {
+                file_.flush();
+                segment_bytes_ += bytes;
+                blocks_written_.fetch_add(1, std::memory_order_relaxed);
+                records_written_.fetch_add(block.header.count, std::memory_order_relaxed);
+            } else {
+                write_errors_.fetch_add(1, std::memory_order_relaxed);
+                records_dropped_.fetch_add(block.header.count, std::memory_order_relaxed);
+                closeSegment();
+            }
+        }
+        written_.store(index + 1, std::memory_order_release);
+    }
+}
+
+bool CanRecorder::openSegment() {
+    if (!LittleFS.exists(kDirectory) && !LittleFS.mkdir(kDirectory)) {
+        return false;
+    }
+
+    const std::uint32_t segment_bytes = config_.max_segment_kb * 1024u;
+    enforceBudget(segment_bytes);
+
+    std::uint32_t next = 1;
+    for (const SegmentInfo& info : segments()) {
+        next = std::max(next, info.index + 1);
+    }
+
+    const std::string path = segmentPath(next);
+    file_ = LittleFS.open(path.c_str(), FILE_WRITE);
+    if (!file_) {
+        Serial.printf("[CanRecorder] Cannot create %s\n", path.c_str());
+        return false;
+    }
+
+    CanLogSegmentHeader header{};
+    header.magic = kCanLogSegmentMagic;
+    header.version = kCanLogVersion;
+    header.record_size = sizeof(CanTraceRecord);
+    header.segment = next;
+    header.start_us = static_cast<std::uint64_t>(esp_timer_get_time());
+    timeval now{};
+    gettimeofday(&now, nullptr);
+    if (static_cast<std::uint64_t>(now.tv_sec) > kUnixTimeValid) {
+        header.start_unix_us = static_cast<std::uint64_t>(now.tv_sec) * 1000000ull + now.tv_usec;
+    }
+    if (file_.write(reinterpret_cast<const std::uint8_t*>(&header), sizeof(header)) != sizeof(header)) {
+        file_.close();
+        return false;
+    }
+    file_.flush();
+    segment_ = next;
+    segment_bytes_ = sizeof(header);
+    Serial.printf("[CanRecorder] Recording to %s\n", path.c_str());
+    return true;
+}
+
+void CanRecorder::closeSegment() {
+    if (file_) {
+        file_.close();
+    }
+    segment_bytes_ = 0;
+}
+
+void CanRecorder::enforceBudget(std::uint32_t incoming_bytes) {
+    std::vector<SegmentInfo> existing = segments();
+    std::uint32_t total = 0;
+    for (const SegmentInfo& info : existing) {
+        total += info.size;
+    }
+
+    const std::uint32_t budget = config_.max_total_kb * 1024u;
+    auto oldest = existing.begin();
+    // Whole oldest segments go first; LittleFS spreads the freed blocks across the partition
+    while (oldest != existing.end() &&
+           (total + incoming_bytes > budget || LittleFS.totalBytes() - LittleFS.usedBytes() < incoming_bytes * 2)) {
+        LittleFS.remove(segmentPath(oldest->index).c_str());
+        total -= oldest->size;
+        ++oldest;
+    }
+}
+
+std::vector<CanRecorder::SegmentInfo> CanRecorder::segments() const {
+    std::vector<SegmentInfo> result;
+    File dir = LittleFS.open(kDirectory);
+    if (!dir || !dir.isDirectory()) {
+        return result;
+    }
+    for (File entry = dir.openNextFile(); entry; entry = dir.openNextFile()) {
+        SegmentInfo info;
+        if (!entry.isDirectory() && parseSegmentName(entry.name(), info.index)) {
+            info.size = static_cast<std::uint32_t>(entry.size());
+            result.push_back(info);
+        }
+    }
+    std::sort(result.begin(), result.end(),
+              [](const SegmentInfo& a, const SegmentInfo& b) { return a.index < b.index; });
+    return result;
+}
+#else
+void CanRecorder::startTasks() {
+    tasks_started_ = true;
+}
+
+void CanRecorder::collectorTask(void*) {}
+void CanRecorder::writerTask(void*) {}
+
+// Host builds have no filesystem: blocks are consumed and counted
+void CanRecorder::writePending() {
+    while (written_.load() != sealed_.load()) {
+        const std::uint32_t index = written_.load();
+        blocks_written_.fetch_add(1);
+        records_written_.fetch_add(pool_[index % kBlockPool].header.count);
+        written_.store(index + 1);
+    }
+}
+
+bool CanRecorder::openSegment() {
+    return false;
+}
+
+void CanRecorder::closeSegment() {}
+void CanRecorder::enforceBudget(std::uint32_t) {}
+
+std::vector<CanRecorder::SegmentInfo> CanRecorder::segments() const {
+    return {};
+}
+#endif
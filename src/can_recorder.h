@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "can_log_format.h"
+#include "can_trace.h"
+#include "config_types.h"
+
+#ifdef ARDUINO
+#include <FS.h>
+#endif
+
+/**
+ * CAN flight recorder.
+ *
+ * Reads the CAN trace (RX/TX frames and bus state events, microsecond
+ * timestamps taken on the CAN tasks) through its own cursor and appends it
+ * to segment files under /canlog on LittleFS.
+ *
+ * Two tasks keep flash latency away from the bus: a collector on the CAN
+ * core copies records into a pool of 4 KB PSRAM blocks, and a writer on the
+ * other core appends whole CRC-protected blocks and syncs after each one.
+ * Partial blocks are sealed after flush_interval_ms so an idle bus costs
+ * almost no flash writes. Each boot starts a new segment, segments rotate at
+ * max_segment_kb, and the oldest are deleted to stay within max_total_kb.
+ */
+class CanRecorder {
+public:
+    static constexpr std::size_t kBlockPool = 8;
+    static constexpr std::uint32_t kCollectIntervalMs = 20;
+    static constexpr const char* kDirectory = "/canlog";
+
+    struct Status {
+        bool enabled = false;
+        std::uint32_t segment = 0;           // Segment being written (0 before the first block)
+        std::uint32_t blocks_written = 0;
+        std::uint32_t records_written = 0;
+        std::uint32_t records_dropped = 0;   // Trace overrun or every block still waiting for flash
+        std::uint32_t write_errors = 0;
+        std::uint32_t bytes_on_disk = 0;
+    };
+
+    struct SegmentInfo {
+        std::uint32_t index = 0;
+        std::uint32_t size = 0;
+    };
+
+    static CanRecorder& instance();
+
+    void configure(const CanRecorderConfig& config);
+    // Asks the collector to seal the partial block on its next pass so a download sees the latest frames
+    void flush() { flush_requested_.store(true); }
+
+    Status status() const;
+    std::vector<SegmentInfo> segments() const;
+    static std::string segmentPath(std::uint32_t index);
+
+private:
+    CanRecorder() = default;
+
+    struct Block {
+        CanLogBlockHeader header;
+        CanTraceRecord records[kCanLogRecordsPerBlock];
+    };
+
+    bool allocate();
+    void startTasks();
+    void collect(std::uint32_t now_ms);
+    void seal();
+    void writePending();
+    bool openSegment();
+    void closeSegment();
+    void enforceBudget(std::uint32_t incoming_bytes);
+    static void collectorTask(void* arg);
+    static void writerTask(void* arg);
+
+    mutable std::mutex mutex_;  // Config and the open segment
+    CanRecorderConfig config_{};
+    std::atomic<bool> enabled_{false};
+    std::atomic<bool> flush_requested_{false};
+    std::atomic<std::uint32_t> flush_interval_ms_{5000};
+    bool tasks_started_ = false;
+    void* writer_handle_ = nullptr;  // TaskHandle_t on device
+
+    Block* pool_ = nullptr;
+    std::atomic<std::uint32_t> sealed_{0};   // Blocks handed to the writer (collector increments)
+    std::atomic<std::uint32_t> written_{0};  // Blocks returned by the writer
+    std::uint32_t fill_count_ = 0;           // Records in the block being filled (collector only)
+    std::uint32_t fill_started_ms_ = 0;
+    std::uint32_t pending_dropped_ = 0;
+    std::uint32_t block_sequence_ = 0;
+    CanTrace::Cursor cursor_{};
+    std::uint32_t cursor_dropped_seen_ = 0;
+
+#ifdef ARDUINO
+    fs::File file_;
+#endif
+    std::uint32_t segment_ = 0;
+    std::uint32_t segment_bytes_ = 0;
+
+    std::atomic<std::uint32_t> blocks_written_{0};
+    std::atomic<std::uint32_t> records_written_{0};
+    std::atomic<std::uint32_t> records_dropped_{0};
+    std::atomic<std::uint32_t> write_errors_{0};
+};
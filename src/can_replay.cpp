@@ -0,0 +1,271 @@
+#include "can_replay.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "can_types.h"
+
+namespace {
+constexpr float kMinLoadPercent = 0.1f;
+constexpr float kRampFloor = 0.01f;  // Lowest share of the target a ramp drops to, so it never stalls
+constexpr std::uint32_t kMinPeriodMs = 100;
+
+// Generator defaults: engine and vehicle broadcasts a truck bus always carries (source address 0x00)
+constexpr std::uint32_t kDefaultIdentifiers[] = {
+    0x0CF00400,  // EEC1, priority 3, 10-20 ms on a real engine
+    0x18FEF100,  // CCVS
+    0x18FEEE00,  // ET1
+    0x18FEEF00,  // EFL/P1
+    0x18FEF200,  // LFE1
+    0x18FEF500,  // AMB
+    0x18FEF700,  // VEP1
+};
+}
+
+const char* CanReplayEngine::modeName(Mode mode) {
+    switch (mode) {
+        case Mode::IDLE: return "idle";
+        case Mode::REPLAY: return "replay";
+        case Mode::GENERATOR: return "generator";
+    }
+    return "unknown";
+}
+
+bool CanReplayEngine::loadLog(CanLogReader& reader, bool include_tx, std::vector<CanReplayFrame>& out,
+                              std::string& error) {
+    out.clear();
+    CanLogEntry entry;
+    std::uint64_t first_us = 0;
+    while (out.size() < kMaxFrames && reader.next(entry)) {
+        const CanTraceRecord& rec = entry.record;
+        const bool rx = rec.event == static_cast<std::uint8_t>(CanTraceEvent::RX);
+        const bool tx = rec.event == static_cast<std::uint8_t>(CanTraceEvent::TX);
+        if (!rx && !(tx && include_tx)) {
+            continue;
+        }
+        if (out.empty()) {
+            first_us = entry.time_us;
+        }
+        const std::uint64_t offset = entry.time_us - first_us;
+        if (offset > UINT32_MAX) {
+            break;  // Over 71 minutes in one segment; replay what fits
+        }
+
+        CanReplayFrame frame;
+        frame.offset_us = static_cast<std::uint32_t>(offset);
+        frame.identifier = rec.identifier;
+        frame.length = std::min<std::uint8_t>(rec.length, 8);
+        frame.extended = (rec.arg & kCanTraceStandardFrame) == 0;
+        std::memcpy(frame.data, rec.data, sizeof(frame.data));
+        out.push_back(frame);
+    }
+
+    if (!reader.valid()) {
+        error = "Not a CAN log segment";
+        return false;
+    }
+    if (out.empty()) {
+        error = "Segment holds no frames";
+        return false;
+    }
+    return true;
+}
+
+bool CanReplayEngine::startReplay(std::vector<CanReplayFrame> frames, const CanReplayOptions& options,
+                                  std::uint64_t now_us, std::string& error) {
+    if (frames.empty()) {
+        error = "Nothing to replay";
+        return false;
+    }
+    if (!(options.speed >= kMinSpeed && options.speed <= kMaxSpeed)) {
+        error = "Speed must be between 0.1 and 50";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    options_ = options;
+    frames_ = std::move(frames);
+    total_ = static_cast<std::uint32_t>(frames_.size());
+    position_ = 0;
+    start_us_ = now_us;
+    sent_ = rejected_ = loops_ = max_late_us_ = 0;
+    elapsed_us_ = 0;
+    mode_.store(Mode::REPLAY);
+    return true;
+}
+
+bool CanReplayEngine::startGenerator(const CanTrafficProfile& profile, const CanReplayOptions& options,
+                                     std::uint64_t now_us, std::string& error) {
+    if (!(options.speed >= kMinSpeed && options.speed <= kMaxSpeed)) {
+        error = "Speed must be between 0.1 and 50";
+        return false;
+    }
+    if (!(profile.load_percent >= kMinLoadPercent && profile.load_percent <= 100.0f)) {
+        error = "Load must be between 0.1 and 100 percent";
+        return false;
+    }
+    if (profile.pattern != CanTrafficProfile::Pattern::CONSTANT && profile.period_ms < kMinPeriodMs) {
+        error = "Pattern period below 100 ms";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    options_ = options;
+    profile_ = profile;
+    profile_.length = std::min<std::uint8_t>(profile_.length, 8);
+    profile_.duty_percent = std::min<std::uint8_t>(std::max<std::uint8_t>(profile_.duty_percent, 1), 100);
+    if (profile_.bitrate == 0) {
+        profile_.bitrate = 250000;
+    }
+    if (profile_.identifiers.empty()) {
+        profile_.identifiers.assign(std::begin(kDefaultIdentifiers), std::end(kDefaultIdentifiers));
+    }
+    frames_.clear();
+    frames_.shrink_to_fit();
+    total_ = 0;
+    position_ = 0;
+    start_us_ = now_us;
+    next_generated_us_ = 0;
+    generated_ = 0;
+    sent_ = rejected_ = loops_ = max_late_us_ = 0;
+    elapsed_us_ = 0;
+    mode_.store(Mode::GENERATOR);
+    return true;
+}
+
+void CanReplayEngine::stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    mode_.store(Mode::IDLE);
+    frames_.clear();
+    frames_.shrink_to_fit();
+}
+
+std::uint64_t CanReplayEngine::tick(std::uint64_t now_us) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::uint64_t virtual_us = scaled(now_us);
+    switch (mode_.load(std::memory_order_relaxed)) {
+        case Mode::REPLAY: return tickReplay(now_us, virtual_us);
+        case Mode::GENERATOR: return tickGenerator(now_us, virtual_us);
+        case Mode::IDLE: break;
+    }
+    return kIdle;
+}
+
+std::uint64_t CanReplayEngine::tickReplay(std::uint64_t now_us, std::uint64_t virtual_us) {
+    elapsed_us_ = virtual_us;
+    std::uint32_t burst = 0;
+    while (position_ < frames_.size()) {
+        const CanReplayFrame& frame = frames_[position_];
+        if (frame.offset_us > virtual_us) {
+            return realDelay(frame.offset_us - virtual_us);
+        }
+        if (burst++ == kMaxFramesPerTick) {
+            return 0;
+        }
+        if (!emit(frame, virtual_us, frame.offset_us)) {
+            return kRetryUs;
+        }
+        ++position_;
+    }
+
+    if (options_.loop) {
+        ++loops_;
+        position_ = 0;
+        start_us_ = now_us;
+        return 0;
+    }
+    mode_.store(Mode::IDLE);
+    frames_.clear();
+    frames_.shrink_to_fit();  // The recording can be most of a megabyte of PSRAM
+    return kIdle;
+}
+
+std::uint64_t CanReplayEngine::tickGenerator(std::uint64_t, std::uint64_t virtual_us) {
+    elapsed_us_ = virtual_us;
+    const std::uint64_t period_us = static_cast<std::uint64_t>(profile_.period_ms) * 1000;
+    const float frame_bits = static_cast<float>(canExtendedFrameBits(profile_.length));
+    std::uint32_t burst = 0;
+
+    while (next_generated_us_ <= virtual_us) {
+        const float load = generatorLoad(next_generated_us_);
+        if (load <= 0.0f) {
+            next_generated_us_ = (next_generated_us_ / period_us + 1) * period_us;  // Idle until the next burst
+            continue;
+        }
+        if (burst++ == kMaxFramesPerTick) {
+            return 0;
+        }
+
+        CanReplayFrame frame;
+        frame.offset_us = static_cast<std::uint32_t>(next_generated_us_);
+        frame.identifier = profile_.identifiers[generated_ % profile_.identifiers.size()];
+        frame.length = profile_.length;
+        std::memset(frame.data, 0xFF, sizeof(frame.data));
+        for (std::uint8_t i = 0; i < 4 && i < frame.length; ++i) {
+            frame.data[i] = static_cast<std::uint8_t>(generated_ >> (8 * i));
+        }
+        if (!emit(frame, virtual_us, next_generated_us_)) {
+            return kRetryUs;
+        }
+        ++generated_;
+
+        const float interval_us = frame_bits * 1000000.0f / (static_cast<float>(profile_.bitrate) * load);
+        next_generated_us_ += std::max<std::uint64_t>(1, static_cast<std::uint64_t>(interval_us));
+    }
+    return realDelay(next_generated_us_ - virtual_us);
+}
+
+float CanReplayEngine::generatorLoad(std::uint64_t virtual_us) const {
+    const float target = profile_.load_percent / 100.0f;
+    const std::uint64_t period_us = static_cast<std::uint64_t>(profile_.period_ms) * 1000;
+    switch (profile_.pattern) {
+        case CanTrafficProfile::Pattern::CONSTANT:
+            return target;
+        case CanTrafficProfile::Pattern::RAMP: {
+            const float phase = static_cast<float>(virtual_us % period_us) / static_cast<float>(period_us);
+            return target * std::max(phase, kRampFloor);
+        }
+        case CanTrafficProfile::Pattern::BURST:
+            return virtual_us % period_us < period_us * profile_.duty_percent / 100 ? target : 0.0f;
+    }
+    return target;
+}
+
+bool CanReplayEngine::emit(const CanReplayFrame& frame, std::uint64_t virtual_us, std::uint64_t due_us) {
+    if (!sink_ || !sink_(frame, context_)) {
+        ++rejected_;
+        return false;
+    }
+    ++sent_;
+    const std::uint64_t late_us = virtual_us > due_us ? realDelay(virtual_us - due_us) : 0;
+    max_late_us_ = std::max<std::uint32_t>(max_late_us_, static_cast<std::uint32_t>(std::min<std::uint64_t>(late_us, UINT32_MAX)));
+    return true;
+}
+
+std::uint64_t CanReplayEngine::scaled(std::uint64_t now_us) const {
+    if (now_us <= start_us_) {
+        return 0;
+    }
+    return static_cast<std::uint64_t>(static_cast<double>(now_us - start_us_) * options_.speed);
+}
+
+std::uint64_t CanReplayEngine::realDelay(std::uint64_t scaled_us) const {
+    return static_cast<std::uint64_t>(std::ceil(static_cast<double>(scaled_us) / options_.speed));
+}
+
+CanReplayEngine::Status CanReplayEngine::status() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Status result;
+    result.mode = mode_.load();
+    result.speed = options_.speed;
+    result.loop = options_.loop;
+    result.position = static_cast<std::uint32_t>(position_);
+    result.total = total_;
+    result.sent = sent_;
+    result.rejected = rejected_;
+    result.loops = loops_;
+    result.max_late_us = max_late_us_;
+    result.elapsed_us = elapsed_us_;
+    return result;
+}
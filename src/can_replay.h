@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "can_log_format.h"
+
+struct CanReplayFrame {
+    std::uint32_t offset_us = 0;  // From the first frame of the recording
+    std::uint32_t identifier = 0;
+    std::uint8_t data[8] = {};
+    std::uint8_t length = 0;
+    bool extended = true;
+};
+
+// Where replayed/generated frames go: into the RX path as if received, or out through the TX queue
+enum class CanReplayTarget : std::uint8_t { VIRTUAL, BUS };
+
+struct CanReplayOptions {
+    float speed = 1.0f;       // Playback rate, kMinSpeed..kMaxSpeed
+    bool loop = false;        // Start over at the end of a recording
+    bool include_tx = false;  // Also replay frames the panel itself sent while recording
+};
+
+struct CanTrafficProfile {
+    enum class Pattern : std::uint8_t {
+        CONSTANT,  // load_percent all the time
+        RAMP,      // 0 to load_percent over period_ms, then again
+        BURST      // load_percent for duty_percent of each period_ms, idle otherwise
+    };
+
+    Pattern pattern = Pattern::CONSTANT;
+    float load_percent = 30.0f;
+    std::uint32_t period_ms = 10000;
+    std::uint8_t duty_percent = 20;
+    std::uint8_t length = 8;
+    std::uint32_t bitrate = 250000;
+    std::vector<std::uint32_t> identifiers;  // 29-bit identifiers cycled in order; empty = common J1939 broadcasts
+};
+
+/**
+ * Re-injects a recorded CAN log or a synthetic traffic pattern.
+ *
+ * Replay walks frames loaded from a flight recorder segment and releases each
+ * one when the scaled clock reaches its original offset, so inter-frame gaps
+ * are preserved at any speed. The generator emits frames at the rate that
+ * gives the requested bus load for the profile's pattern, stamping a sequence
+ * counter in the first four data bytes.
+ *
+ * tick() takes the time explicitly, like CanPeriodicScheduler, so host tests
+ * can run a recording against a simulated clock. A frame the sink refuses
+ * (TX queue full) is retried on the next tick rather than dropped.
+ */
+class CanReplayEngine {
+public:
+    static constexpr std::uint64_t kIdle = UINT64_MAX;
+    static constexpr float kMinSpeed = 0.1f;
+    static constexpr float kMaxSpeed = 50.0f;
+    static constexpr std::size_t kMaxFrames = 32768;        // ~640 KB of PSRAM
+    static constexpr std::uint32_t kMaxFramesPerTick = 256;  // Bounds one tick when far behind
+    static constexpr std::uint32_t kRetryUs = 1000;
+
+    enum class Mode : std::uint8_t { IDLE, REPLAY, GENERATOR };
+
+    struct Status {
+        Mode mode = Mode::IDLE;
+        float speed = 1.0f;
+        bool loop = false;
+        std::uint32_t position = 0;   // Next frame of the recording
+        std::uint32_t total = 0;      // Frames in the recording (0 for the generator)
+        std::uint32_t sent = 0;
+        std::uint32_t rejected = 0;   // Sink refusals, each retried
+        std::uint32_t loops = 0;
+        std::uint32_t max_late_us = 0;
+        std::uint64_t elapsed_us = 0; // Recording time covered so far
+    };
+
+    using FrameSink = bool (*)(const CanReplayFrame& frame, void* context);
+
+    static const char* modeName(Mode mode);
+
+    // Reads frame records from a segment; false when nothing usable was found
+    static bool loadLog(CanLogReader& reader, bool include_tx, std::vector<CanReplayFrame>& out, std::string& error);
+
+    bool startReplay(std::vector<CanReplayFrame> frames, const CanReplayOptions& options, std::uint64_t now_us,
+                     std::string& error);
+    bool startGenerator(const CanTrafficProfile& profile, const CanReplayOptions& options, std::uint64_t now_us,
+                        std::string& error);
+    void stop();
+
+    // Emits every due frame and returns microseconds until the next one (kIdle when stopped)
+    std::uint64_t tick(std::uint64_t now_us);
+
+    Status status() const;
+    bool active() const { return mode_.load(std::memory_order_relaxed) != Mode::IDLE; }
+    void setSink(FrameSink sink, void* context) {
+        sink_ = sink;
+        context_ = context;
+    }
+
+private:
+    std::uint64_t scaled(std::uint64_t now_us) const;
+    std::uint64_t realDelay(std::uint64_t scaled_us) const;
+    std::uint64_t tickReplay(std::uint64_t now_us, std::uint64_t virtual_us);
+    std::uint64_t tickGenerator(std::uint64_t now_us, std::uint64_t virtual_us);
+    // Bus share the profile asks for at a point in generator time, 0..1
+    float generatorLoad(std::uint64_t virtual_us) const;
+    bool emit(const CanReplayFrame& frame, std::uint64_t virtual_us, std::uint64_t due_us);
+
+    mutable std::mutex mutex_;
+    std::atomic<Mode> mode_{Mode::IDLE};
+    FrameSink sink_ = nullptr;
+    void* context_ = nullptr;
+
+    CanReplayOptions options_{};
+    std::uint64_t start_us_ = 0;
+    std::vector<CanReplayFrame> frames_;
+    std::uint32_t total_ = 0;
+    std::size_t position_ = 0;
+
+    CanTrafficProfile profile_{};
+    std::uint64_t next_generated_us_ = 0;  // Generator time of the next frame
+    std::uint32_t generated_ = 0;
+
+    std::uint32_t sent_ = 0;
+    std::uint32_t rejected_ = 0;
+    std::uint32_t loops_ = 0;
+    std::uint32_t max_late_us_ = 0;
+    std::uint64_t elapsed_us_ = 0;
+};
@@ -0,0 +1,100 @@
+#include "can_rx_ring.h"
+
+#include <new>
+
+#include "psram_alloc.h"
+
+CanRxRing::~CanRxRing() {
+    if (slots_) {
+        for (std::size_t i = 0; i < capacity_; ++i) {
+            slots_[i].~Slot();
+        }
+        psramFree(slots_);
+    }
+}
+
+bool CanRxRing::init(std::size_t capacity) {
+    if (slots_) {
+        return true;
+    }
+
+    std::size_t rounded = 2;
+    while (rounded < capacity) {
+        rounded <<= 1;
+    }
+
+    void* storage = psramAlloc(rounded * sizeof(Slot));
+    if (!storage) {
+        return false;
+    }
+
+    slots_ = static_cast<Slot*>(storage);
+    for (std::size_t i = 0; i < rounded; ++i) {
+        Slot* slot = new (&slots_[i]) Slot();
+        // A slot only matches a reader when seq == index + 1, so seeding it with
+        // its own index marks it as "not yet written" for every lap.
+        slot->seq.store(static_cast<std::uint32_t>(i), std::memory_order_relaxed);
+    }
+    capacity_ = rounded;
+    mask_ = static_cast<std::uint32_t>(rounded - 1);
+    head_.store(0, std::memory_order_release);
+    return true;
+}
+
+void CanRxRing::push(const CanRxMessage& msg) {
+    const std::uint32_t index = head_.load(std::memory_order_relaxed);
+    Slot& slot = slots_[index & mask_];
+
+    // Mark busy (value never equals index + 1), publish data, then release the slot
+    slot.seq.store(index, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.msg = msg;
+    slot.seq.store(index + 1, std::memory_order_release);
+    head_.store(index + 1, std::memory_order_release);
+}
+
+CanRxRing::Cursor CanRxRing::openCursor() const {
+    Cursor cursor;
+    cursor.next = head_.load(std::memory_order_acquire);
+    return cursor;
+}
+
+std::uint32_t CanRxRing::available(const Cursor& cursor) const {
+    const std::uint32_t behind = head_.load(std::memory_order_acquire) - cursor.next;
+    return behind > capacity_ ? static_cast<std::uint32_t>(capacity_) : behind;
+}
+
+bool CanRxRing::pop(Cursor& cursor, CanRxMessage& out) {
+    if (!slots_) {
+        return false;
+    }
+
+    while (true) {
+        const std::uint32_t head = head_.load(std::memory_order_acquire);
+        const std::uint32_t behind = head - cursor.next;
+        if (behind == 0) {
+            return false;
+        }
+
+        if (behind > capacity_) {
+            const std::uint32_t lost = behind - static_cast<std::uint32_t>(capacity_);
+            cursor.dropped += lost;
+            cursor.next = head - static_cast<std::uint32_t>(capacity_);
+        }
+
+        const Slot& slot = slots_[cursor.next & mask_];
+        const std::uint32_t expected = cursor.next + 1;
+        if (slot.seq.load(std::memory_order_acquire) == expected) {
+            out = slot.msg;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) == expected) {
+                ++cursor.next;
+                return true;
+            }
+        }
+
+        // The producer lapped us while we were reading this slot
+        ++cursor.next;
+        ++cursor.dropped;
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "can_types.h"
+
+/**
+ * Single-producer / multi-consumer ring of received CAN frames.
+ *
+ * There is one producer at a time (CanManager serializes the RX task and
+ * virtual-bus injection) and it never blocks: when the ring is full the
+ * oldest frame is overwritten. Every consumer (web API, serial
+ * monitor, logger, UI) owns a Cursor and reads at its own pace; a consumer
+ * that falls more than capacity() frames behind skips ahead and the number
+ * of frames it missed is added to its cursor. Losses are only tracked per
+ * cursor: consumers miss different frames, so a ring-wide sum would count a
+ * frame once for every consumer that missed it.
+ */
+class CanRxRing {
+public:
+    struct Cursor {
+        std::uint32_t next = 0;     // Sequence number of the next frame to read
+        std::uint32_t dropped = 0;  // Frames this consumer lost to overwrites
+    };
+
+    CanRxRing() = default;
+    ~CanRxRing();
+    CanRxRing(const CanRxRing&) = delete;
+    CanRxRing& operator=(const CanRxRing&) = delete;
+
+    // Allocates storage (PSRAM when available). Capacity is rounded up to a power of two.
+    bool init(std::size_t capacity);
+    bool isInitialized() const { return slots_ != nullptr; }
+    std::size_t capacity() const { return capacity_; }
+
+    // Producer side - callers must not push concurrently.
+    void push(const CanRxMessage& msg);
+
+    // Consumer side - safe from any task as long as each cursor has one owner.
+    Cursor openCursor() const;
+    bool pop(Cursor& cursor, CanRxMessage& out);
+    std::uint32_t available(const Cursor& cursor) const;
+
+    std::uint32_t pushed() const { return head_.load(std::memory_order_acquire); }
+
+private:
+    struct Slot {
+        std::atomic<std::uint32_t> seq;
+        CanRxMessage msg;
+    };
+
+    Slot* slots_ = nullptr;
+    std::size_t capacity_ = 0;
+    std::uint32_t mask_ = 0;
+    std::atomic<std::uint32_t> head_{0};
+};
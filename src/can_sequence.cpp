@@ -0,0 +1,307 @@
+#include "can_sequence.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "can_types.h"
+
+namespace {
+constexpr std::uint32_t kWorkerStack = 3072;
+constexpr std::uint32_t kWorkerPriority = 3;  // Above LVGL (2), below the CAN TX scheduler (4)
+
+bool isDue(std::uint32_t now_ms, std::uint32_t due_ms) {
+    return static_cast<std::int32_t>(now_ms - due_ms) >= 0;
+}
+}
+
+CanSequenceEngine& CanSequenceEngine::instance() {
+    static CanSequenceEngine engine;
+    return engine;
+}
+
+CanSequenceEngine::Overlap CanSequenceEngine::parseOverlap(const std::string& value) {
+    if (value == "ignore") return Overlap::IGNORE;
+    if (value == "queue") return Overlap::QUEUE;
+    return Overlap::RESTART;
+}
+
+CanSequenceEngine::Condition CanSequenceEngine::parseCondition(const std::string& value) {
+    return value == "always" ? Condition::ALWAYS : Condition::PREVIOUS_OK;
+}
+
+bool CanSequenceEngine::load(const std::vector<CanSequenceConfig>& sequences, std::string& error) {
+    if (sequences.size() > kMaxSequences) {
+        error = "Too many CAN sequences";
+        return false;
+    }
+
+    std::size_t total_steps = 0;
+    for (std::size_t i = 0; i < sequences.size(); ++i) {
+        const CanSequenceConfig& seq = sequences[i];
+        if (seq.id.empty()) {
+            error = "CAN sequence without id";
+            return false;
+        }
+        if (seq.steps.size() > MAX_CAN_SEQUENCE_STEPS) {
+            error = "CAN sequence '" + seq.id + "' has too many steps";
+            return false;
+        }
+        for (std::size_t j = 0; j < i; ++j) {
+            if (sequences[j].id == seq.id) {
+                error = "Duplicate CAN sequence id '" + seq.id + "'";
+                return false;
+            }
+        }
+        total_steps += seq.steps.size();
+    }
+    if (total_steps > kMaxSteps) {
+        error = "CAN sequence step pool exhausted";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Run& run : runs_) {
+        run.active = false;
+    }
+
+    std::uint16_t next_step = 0;
+    for (std::size_t i = 0; i < sequences.size(); ++i) {
+        const CanSequenceConfig& src = sequences[i];
+        Sequence& dst = sequences_[i];
+        dst.id = src.id;
+        dst.group = src.group;
+        dst.overlap = parseOverlap(src.overlap);
+        dst.start_delay_ms = src.start_delay_ms;
+        dst.first_step = next_step;
+        dst.step_count = static_cast<std::uint16_t>(src.steps.size());
+
+        for (const CanSequenceStep& step_cfg : src.steps) {
+            Step& step = steps_[next_step++];
+            step.identifier = buildJ1939Identifier(step_cfg.priority, step_cfg.pgn,
+                                                   step_cfg.source_address, step_cfg.destination_address);
+            step.length = std::min<std::uint8_t>(step_cfg.length, 8);
+            std::memcpy(step.data, step_cfg.data.data(), sizeof(step.data));
+            step.delay_ms = step_cfg.delay_ms;
+            step.condition = parseCondition(step_cfg.condition);
+        }
+    }
+    sequence_count_ = sequences.size();
+    return true;
+}
+
+int CanSequenceEngine::findSequence(const std::string& id) const {
+    for (std::size_t i = 0; i < sequence_count_; ++i) {
+        if (sequences_[i].id == id) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+CanSequenceEngine::Run* CanSequenceEngine::findRun(std::size_t sequence_index) {
+    for (Run& run : runs_) {
+        if (run.active && run.sequence == sequence_index) {
+            return &run;
+        }
+    }
+    return nullptr;
+}
+
+void CanSequenceEngine::beginRun(Run& run, std::size_t sequence_index, std::uint32_t now_ms) {
+    run.active = true;
+    run.last_ok = true;
+    run.restart_pending = false;
+    run.sending = false;
+    ++run.generation;
+    run.sequence = static_cast<std::uint8_t>(sequence_index);
+    run.next_step = 0;
+    run.due_ms = now_ms + sequences_[sequence_index].start_delay_ms;
+}
+
+bool CanSequenceEngine::hasSequence(const std::string& id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return findSequence(id) >= 0;
+}
+
+bool CanSequenceEngine::start(const std::string& id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const int index = findSequence(id);
+    if (index < 0) {
+        return false;
+    }
+
+    const Sequence& seq = sequences_[index];
+    const std::uint32_t now_ms = canMillis();
+
+    if (!seq.group.empty()) {
+        for (Run& run : runs_) {
+            if (run.active && run.sequence != index && sequences_[run.sequence].group == seq.group) {
+                run.active = false;
+            }
+        }
+    }
+
+    Run* run = findRun(static_cast<std::size_t>(index));
+    if (run) {
+        switch (seq.overlap) {
+            case Overlap::RESTART:
+                beginRun(*run, static_cast<std::size_t>(index), now_ms);
+                break;
+            case Overlap::IGNORE:
+                return false;
+            case Overlap::QUEUE:
+                run->restart_pending = true;
+                break;
+        }
+    } else {
+        auto free_run = std::find_if(runs_.begin(), runs_.end(), [](const Run& r) { return !r.active; });
+        if (free_run == runs_.end()) {
+            return false;
+        }
+        beginRun(*free_run, static_cast<std::size_t>(index), now_ms);
+    }
+
+    wakeWorker();
+    return true;
+}
+
+bool CanSequenceEngine::cancel(const std::string& id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const int index = findSequence(id);
+    if (index < 0) {
+        return false;
+    }
+    Run* run = findRun(static_cast<std::size_t>(index));
+    if (!run) {
+        return false;
+    }
+    run->active = false;
+    return true;
+}
+
+void CanSequenceEngine::cancelAll() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Run& run : runs_) {
+        run.active = false;
+    }
+}
+
+bool CanSequenceEngine::isRunning(const std::string& id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const int index = findSequence(id);
+    if (index < 0) {
+        return false;
+    }
+    for (const Run& run : runs_) {
+        if (run.active && run.sequence == index) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::uint32_t CanSequenceEngine::tick(std::uint32_t now_ms) {
+    while (true) {
+        Step step;
+        Run* run = nullptr;
+        std::uint32_t generation = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            run = takeDueStep(now_ms, step);
+            if (!run) {
+                return nextWait(now_ms);
+            }
+            generation = run->generation;
+        }
+
+        const bool ok = sink_ ? sink_(step) : false;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (run->generation == generation) {
+            run->sending = false;
+            run->last_ok = ok;
+        }
+    }
+}
+
+// Claims the next due step of any run, finishing or restarting runs that reached their end
+CanSequenceEngine::Run* CanSequenceEngine::takeDueStep(std::uint32_t now_ms, Step& step) {
+    for (Run& run : runs_) {
+        while (run.active && !run.sending && isDue(now_ms, run.due_ms)) {
+            const Sequence& seq = sequences_[run.sequence];
+            if (run.next_step >= seq.step_count) {
+                if (run.restart_pending) {
+                    beginRun(run, run.sequence, now_ms);
+                    continue;
+                }
+                run.active = false;
+                break;
+            }
+
+            const Step& next = steps_[seq.first_step + run.next_step];
+            if (next.condition == Condition::PREVIOUS_OK && !run.last_ok) {
+                run.active = false;  // Earlier frame never made it out; don't send half a sequence
+                break;
+            }
+
+            step = next;
+            ++run.next_step;
+            // Gaps are measured from when the frame actually went out, so a late tick never squeezes them
+            run.due_ms = now_ms + next.delay_ms;
+            run.sending = true;
+            return &run;
+        }
+    }
+    return nullptr;
+}
+
+std::uint32_t CanSequenceEngine::nextWait(std::uint32_t now_ms) const {
+    std::uint32_t next_wait = kIdle;
+    for (const Run& run : runs_) {
+        if (run.active) {
+            next_wait = std::min(next_wait, isDue(now_ms, run.due_ms) ? 0 : run.due_ms - now_ms);
+        }
+    }
+    return next_wait;
+}
+
+void CanSequenceEngine::wakeWorker() {
+    if (worker_.started()) {
+        worker_.notify();
+    }
+}
+
+void CanSequenceEngine::workerEntry(void* arg) {
+    auto* engine = static_cast<CanSequenceEngine*>(arg);
+    while (engine->worker_running_.load()) {
+        const std::uint32_t wait_ms = engine->tick(canMillis());
+        engine->worker_.wait(wait_ms == kIdle ? CanTask::kWaitForever : wait_ms);
+    }
+    engine->worker_active_.store(false);
+}
+
+void CanSequenceEngine::startWorker() {
+    if (worker_active_.load()) {
+        return;
+    }
+    worker_running_.store(true);
+    worker_active_.store(true);
+    if (!worker_.start("can_seq", kWorkerStack, kWorkerPriority, 1, workerEntry, this)) {
+        worker_running_.store(false);
+        worker_active_.store(false);
+        CAN_LOGF("[CanSequence] Failed to start worker task\n");
+    }
+}
+
+void CanSequenceEngine::stopWorker() {
+    if (!worker_.started()) {
+        return;
+    }
+    worker_running_.store(false);
+    worker_.notify();
+    const std::uint32_t start = canMillis();
+    while (worker_active_.load() && canMillis() - start < 500) {
+        canDelayMs(5);
+    }
+    worker_.reset();
+}
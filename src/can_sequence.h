@@ -0,0 +1,111 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "can_platform.h"
+#include "config_types.h"
+
+/**
+ * Data-driven CAN sequence engine.
+ *
+ * Sequences from DeviceConfig::can_sequences are compiled into a fixed
+ * step pool and executed by one persistent worker that sleeps until the
+ * next step is due. Starting a sequence never creates a task; overlap
+ * rules decide what happens when the same button is pressed twice and the
+ * optional group cancels sibling sequences (e.g. OFF cancels a running ON).
+ *
+ * Time comes from canMillis(), so host builds can run the engine on a
+ * virtual clock (canSetClock); tick() also takes the time explicitly so a
+ * test can drive it without the worker. Steps are handed to the sink
+ * outside the engine lock, so start() and cancel() never wait on the TX
+ * queue.
+ */
+class CanSequenceEngine {
+public:
+    static constexpr std::size_t kMaxSequences = MAX_CAN_SEQUENCES;
+    static constexpr std::size_t kMaxSteps = 256;  // Shared by all sequences
+    static constexpr std::size_t kMaxRuns = 8;     // Sequences that may run concurrently
+    static constexpr std::uint32_t kIdle = UINT32_MAX;
+
+    enum class Overlap : std::uint8_t { RESTART, IGNORE, QUEUE };
+    enum class Condition : std::uint8_t { ALWAYS, PREVIOUS_OK };
+
+    struct Step {
+        std::uint32_t identifier = 0;
+        std::uint8_t data[8] = {};
+        std::uint8_t length = 0;
+        std::uint16_t delay_ms = 0;
+        Condition condition = Condition::PREVIOUS_OK;
+    };
+
+    // Returns true when the frame was accepted for transmission
+    using StepSink = bool (*)(const Step& step);
+
+    static CanSequenceEngine& instance();
+
+    bool load(const std::vector<CanSequenceConfig>& sequences, std::string& error);
+    bool start(const std::string& id);
+    bool cancel(const std::string& id);
+    void cancelAll();
+    bool isRunning(const std::string& id) const;
+    bool hasSequence(const std::string& id) const;
+
+    // Runs every due step and returns milliseconds until the next one (kIdle when nothing is running).
+    // One caller at a time: the worker, or a test driving the engine on its own clock.
+    std::uint32_t tick(std::uint32_t now_ms);
+
+    // Set before startWorker(); the sink is read without the lock
+    void setSink(StepSink sink) { sink_ = sink; }
+    void startWorker();
+    void stopWorker();  // Runs keep their place and resume with the next startWorker()
+
+private:
+    CanSequenceEngine() = default;
+
+    struct Sequence {
+        std::string id;
+        std::string group;
+        std::uint16_t first_step = 0;
+        std::uint16_t step_count = 0;
+        std::uint16_t start_delay_ms = 0;
+        Overlap overlap = Overlap::RESTART;
+    };
+
+    struct Run {
+        bool active = false;
+        bool last_ok = true;
+        bool restart_pending = false;
+        bool sending = false;        // A step is with the sink; its result decides PREVIOUS_OK
+        std::uint32_t generation = 0;  // Bumped by beginRun so a late sink result never lands on a new run
+        std::uint8_t sequence = 0;
+        std::uint16_t next_step = 0;
+        std::uint32_t due_ms = 0;
+    };
+
+    int findSequence(const std::string& id) const;
+    Run* findRun(std::size_t sequence_index);
+    void beginRun(Run& run, std::size_t sequence_index, std::uint32_t now_ms);
+    Run* takeDueStep(std::uint32_t now_ms, Step& step);
+    std::uint32_t nextWait(std::uint32_t now_ms) const;
+    void wakeWorker();
+    static void workerEntry(void* arg);
+
+    static Overlap parseOverlap(const std::string& value);
+    static Condition parseCondition(const std::string& value);
+
+    mutable std::mutex mutex_;
+    std::array<Step, kMaxSteps> steps_{};
+    std::array<Sequence, kMaxSequences> sequences_{};
+    std::array<Run, kMaxRuns> runs_{};
+    std::size_t sequence_count_ = 0;
+    StepSink sink_ = nullptr;
+    CanTask worker_;
+    std::atomic<bool> worker_running_{false};
+    std::atomic<bool> worker_active_{false};  // Cleared by the worker on its way out
+};
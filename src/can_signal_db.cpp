@@ -0,0 +1,264 @@
+#include "can_signal_db.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "can_types.h"
+
+namespace {
+constexpr std::uint8_t kAnySource = 0xFF;
+
+std::uint32_t slotKey(std::uint32_t pgn, std::uint8_t source_address) {
+    return (pgn << 8) | source_address;
+}
+}
+
+CanSignalDatabase& CanSignalDatabase::instance() {
+    static CanSignalDatabase database;
+    return database;
+}
+
+bool CanSignalDatabase::compile(const CanSignalConfig& signal, std::uint16_t index, Decoder& out,
+                                std::string& error) {
+    if (signal.length == 0 || signal.length > 64 || signal.start_bit > 63) {
+        error = "Signal '" + signal.name + "' has an invalid bit layout";
+        return false;
+    }
+
+    int lsb = 0;
+    int last_byte = 0;
+    if (signal.little_endian) {
+        // Intel: start bit is the LSB and the signal grows towards higher bits
+        lsb = signal.start_bit;
+        const int msb = lsb + signal.length - 1;
+        if (msb > 63) {
+            error = "Signal '" + signal.name + "' extends past the end of the frame";
+            return false;
+        }
+        last_byte = msb / 8;
+        out.order_select = 0;
+    } else {
+        // Motorola: start bit is the MSB; in the byte-swapped word the signal is contiguous
+        const int msb = (7 - signal.start_bit / 8) * 8 + signal.start_bit % 8;
+        lsb = msb - (signal.length - 1);
+        if (lsb < 0) {
+            error = "Signal '" + signal.name + "' extends past the end of the frame";
+            return false;
+        }
+        last_byte = 7 - lsb / 8;
+        out.order_select = ~0ull;
+    }
+
+    out.shift = static_cast<std::uint8_t>(lsb);
+    out.mask = signal.length == 64 ? ~0ull : (1ull << signal.length) - 1;
+    out.sign_bit = signal.is_signed ? 1ull << (signal.length - 1) : 0;
+    out.scale = signal.scale;
+    out.offset = signal.offset;
+    out.min_length = static_cast<std::uint8_t>(last_byte + 1);
+    out.index = index;
+    return true;
+}
+
+bool CanSignalDatabase::load(const std::vector<CanSignalConfig>& signals, std::string& error) {
+    if (signals.size() > kMaxSignals) {
+        error = "Too many CAN signals";
+        return false;
+    }
+
+    std::vector<Info> info;
+    std::vector<std::uint16_t> order;
+    info.reserve(signals.size());
+    order.reserve(signals.size());
+    for (std::size_t i = 0; i < signals.size(); ++i) {
+        const CanSignalConfig& signal = signals[i];
+        if (signal.name.empty()) {
+            error = "CAN signal without a name";
+            return false;
+        }
+        for (const Info& existing : info) {
+            if (existing.name == signal.name) {
+                error = "Duplicate CAN signal '" + signal.name + "'";
+                return false;
+            }
+        }
+        Info entry;
+        entry.name = signal.name;
+        entry.unit = signal.unit;
+        entry.pgn = j1939PgnFromIdentifier(signal.pgn << 8);  // PDU1 PGNs are matched without the DA byte
+        entry.source_address = signal.source_address;
+        info.push_back(std::move(entry));
+        order.push_back(static_cast<std::uint16_t>(i));
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&](std::uint16_t a, std::uint16_t b) {
+        return slotKey(info[a].pgn, info[a].source_address) < slotKey(info[b].pgn, info[b].source_address);
+    });
+
+    std::vector<Decoder> decoders;
+    std::vector<PgnSlot> slots;
+    decoders.reserve(order.size());
+    for (std::uint16_t index : order) {
+        Decoder decoder;
+        if (!compile(signals[index], index, decoder, error)) {
+            return false;
+        }
+        const std::uint32_t key = slotKey(info[index].pgn, info[index].source_address);
+        if (slots.empty() || slots.back().key != key) {
+            PgnSlot slot;
+            slot.key = key;
+            slot.first = static_cast<std::uint16_t>(decoders.size());
+            slots.push_back(slot);
+        }
+        if (++slots.back().count > kMaxSignalsPerPgn) {
+            error = "Too many signals on PGN of '" + signals[index].name + "'";
+            return false;
+        }
+        decoders.push_back(decoder);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    slots_ = std::move(slots);
+    decoders_ = std::move(decoders);
+    info_ = std::move(info);
+    return true;
+}
+
+bool CanSignalDatabase::subscribe(Subscriber subscriber, void* context) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::size_t i = 0; i < kMaxSubscribers; ++i) {
+        if (!subscribers_[i]) {
+            subscribers_[i] = subscriber;
+            subscriber_contexts_[i] = context;
+            return true;
+        }
+    }
+    return false;
+}
+
+int CanSignalDatabase::find(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::size_t i = 0; i < info_.size(); ++i) {
+        if (info_[i].name == name) {
+            return static_cast<int>(i);
+        }
+    }
+    return kNotFound;
+}
+
+const CanSignalDatabase::PgnSlot* CanSignalDatabase::lookup(std::uint32_t key) const {
+    auto it = std::lower_bound(slots_.begin(), slots_.end(), key,
+                               [](const PgnSlot& slot, std::uint32_t value) { return slot.key < value; });
+    return (it != slots_.end() && it->key == key) ? &*it : nullptr;
+}
+
+std::size_t CanSignalDatabase::decodeSlot(const PgnSlot& slot, std::uint64_t little, std::uint64_t big,
+                                          std::uint8_t length, std::uint32_t timestamp, CanSignalValue* out,
+                                          std::size_t produced) {
+    const Decoder* decoder = decoders_.data() + slot.first;
+    for (std::uint16_t i = 0; i < slot.count; ++i, ++decoder) {
+        if (length < decoder->min_length) {
+            continue;  // Short frame: the signal is not present
+        }
+        const std::uint64_t word = little ^ ((little ^ big) & decoder->order_select);
+        const std::uint64_t bits = (word >> decoder->shift) & decoder->mask;
+        const std::int64_t raw = static_cast<std::int64_t>((bits ^ decoder->sign_bit) - decoder->sign_bit);
+
+        CanSignalValue& value = out[produced++];
+        value.index = decoder->index;
+        value.raw = raw;
+        value.value = static_cast<float>(raw) * decoder->scale + decoder->offset;
+        value.timestamp = timestamp;
+
+        Info& info = info_[decoder->index];
+        info.raw = raw;
+        info.value = value.value;
+        info.timestamp = timestamp;
+        ++info.updates;
+    }
+    return produced;
+}
+
+std::size_t CanSignalDatabase::decode(std::uint32_t identifier, const std::uint8_t* data, std::uint8_t length,
+                                      std::uint32_t timestamp) {
+    std::lock_guard<std::mutex> publish(publish_mutex_);
+    std::array<Subscriber, kMaxSubscribers> subscribers;
+    std::array<void*, kMaxSubscribers> contexts;
+    std::size_t produced = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (slots_.empty()) {
+            return 0;
+        }
+        const std::uint32_t pgn = j1939PgnFromIdentifier(identifier);
+        const std::uint8_t source = identifier & 0xFF;
+        const PgnSlot* exact = source != kAnySource ? lookup(slotKey(pgn, source)) : nullptr;
+        const PgnSlot* any = lookup(slotKey(pgn, kAnySource));
+        if (!exact && !any) {
+            return 0;
+        }
+
+        // Unused bytes read as zero so short frames never pick up stale data
+        if (length > 8) {
+            length = 8;
+        }
+        std::uint8_t bytes[8] = {};
+        std::memcpy(bytes, data, length);
+        std::uint64_t little = 0;
+        for (int i = 7; i >= 0; --i) {
+            little = (little << 8) | bytes[i];
+        }
+        const std::uint64_t big = __builtin_bswap64(little);
+
+        if (exact) {
+            produced = decodeSlot(*exact, little, big, length, timestamp, scratch_.data(), produced);
+        }
+        if (any) {
+            produced = decodeSlot(*any, little, big, length, timestamp, scratch_.data(), produced);
+        }
+        subscribers = subscribers_;
+        contexts = subscriber_contexts_;
+    }
+
+    for (std::size_t s = 0; s < kMaxSubscribers && subscribers[s]; ++s) {
+        for (std::size_t i = 0; i < produced; ++i) {
+            subscribers[s](scratch_[i], contexts[s]);
+        }
+    }
+    return produced;
+}
+
+std::vector<CanSignalDatabase::Snapshot> CanSignalDatabase::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Snapshot> result;
+    result.reserve(info_.size());
+    for (const Info& info : info_) {
+        Snapshot entry;
+        entry.name = info.name;
+        entry.unit = info.unit;
+        entry.pgn = info.pgn;
+        entry.source_address = info.source_address;
+        entry.raw = info.raw;
+        entry.value = info.value;
+        entry.timestamp = info.timestamp;
+        entry.updates = info.updates;
+        result.push_back(std::move(entry));
+    }
+    return result;
+}
+
+std::size_t CanSignalDatabase::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return info_.size();
+}
+
+std::vector<std::uint32_t> CanSignalDatabase::pgns() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::uint32_t> result;
+    for (const PgnSlot& slot : slots_) {
+        const std::uint32_t pgn = slot.key >> 8;
+        if (result.empty() || result.back() != pgn) {
+            result.push_back(pgn);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "config_types.h"
+
+// One decoded signal as handed to subscribers
+struct CanSignalValue {
+    std::uint16_t index = 0;     // Position in the database (see CanSignalDatabase::find)
+    std::int64_t raw = 0;        // Extracted bits, sign-extended for signed signals
+    float value = 0.0f;          // raw * scale + offset
+    std::uint32_t timestamp = 0;
+};
+
+/**
+ * DBC-style signal database.
+ *
+ * load() compiles the configured signals into a flat table of decoders
+ * grouped per (PGN, source) and sorted by that key. A received frame costs
+ * one binary search per key (exact source, then "any source") and a fixed
+ * sequence of shifts and masks per signal: both byte orders and the sign
+ * extension are selected with precomputed masks, so extraction has no
+ * data-dependent branches.
+ *
+ * Decoded values are cached for the web API and published to subscribers
+ * outside the table lock; subscribers may query the database but must not
+ * call decode().
+ */
+class CanSignalDatabase {
+public:
+    static constexpr std::size_t kMaxSignals = MAX_CAN_SIGNALS;
+    static constexpr std::size_t kMaxSignalsPerPgn = 64;
+    static constexpr std::size_t kMaxSubscribers = 4;
+    static constexpr int kNotFound = -1;
+
+    struct Snapshot {
+        std::string name;
+        std::string unit;
+        std::uint32_t pgn = 0;
+        std::uint8_t source_address = 0xFF;
+        std::int64_t raw = 0;
+        float value = 0.0f;
+        std::uint32_t timestamp = 0;
+        std::uint32_t updates = 0;
+    };
+
+    using Subscriber = void (*)(const CanSignalValue& value, void* context);
+
+    static CanSignalDatabase& instance();
+
+    bool load(const std::vector<CanSignalConfig>& signals, std::string& error);
+    bool subscribe(Subscriber subscriber, void* context);
+    int find(const std::string& name) const;
+
+    // Decodes every signal carried by the frame; returns how many were published
+    std::size_t decode(std::uint32_t identifier, const std::uint8_t* data, std::uint8_t length,
+                       std::uint32_t timestamp);
+
+    std::vector<Snapshot> snapshot() const;
+    std::size_t size() const;
+    // PGNs referenced by the database, for the acceptance filter
+    std::vector<std::uint32_t> pgns() const;
+
+private:
+    CanSignalDatabase() = default;
+
+    struct Decoder {
+        std::uint64_t order_select = 0;   // All ones for big endian (Motorola) signals
+        std::uint64_t mask = 0;
+        std::uint64_t sign_bit = 0;       // Zero for unsigned signals
+        float scale = 1.0f;
+        float offset = 0.0f;
+        std::uint8_t shift = 0;
+        std::uint8_t min_length = 0;      // Frame bytes needed to cover the signal
+        std::uint16_t index = 0;
+    };
+
+    struct PgnSlot {
+        std::uint32_t key = 0;  // pgn << 8 | source address (0xFF = any)
+        std::uint16_t first = 0;
+        std::uint16_t count = 0;
+    };
+
+    struct Info {
+        std::string name;
+        std::string unit;
+        std::uint32_t pgn = 0;
+        std::uint8_t source_address = 0xFF;
+        std::int64_t raw = 0;
+        float value = 0.0f;
+        std::uint32_t timestamp = 0;
+        std::uint32_t updates = 0;
+    };
+
+    static bool compile(const CanSignalConfig& signal, std::uint16_t index, Decoder& out, std::string& error);
+    const PgnSlot* lookup(std::uint32_t key) const;
+    std::size_t decodeSlot(const PgnSlot& slot, std::uint64_t little, std::uint64_t big, std::uint8_t length,
+                           std::uint32_t timestamp, CanSignalValue* out, std::size_t produced);
+
+    mutable std::mutex mutex_;
+    std::mutex publish_mutex_;  // Serializes decode() so the scratch buffer can live off the caller's stack
+    std::array<CanSignalValue, kMaxSignalsPerPgn * 2> scratch_{};
+    std::vector<PgnSlot> slots_;
+    std::vector<Decoder> decoders_;
+    std::vector<Info> info_;
+    std::array<Subscriber, kMaxSubscribers> subscribers_{};
+    std::array<void*, kMaxSubscribers> subscriber_contexts_{};
+};
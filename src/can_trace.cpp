@@ -0,0 +1,230 @@
+#include "can_trace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+#include "psram_alloc.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <chrono>
+#endif
+
+namespace {
+constexpr std::uint32_t kMask = static_cast<std::uint32_t>(CanTrace::kCapacity - 1);
+constexpr std::uint32_t kDrainIntervalMs = 50;
+
+const char* eventName(std::uint8_t event) {
+    switch (static_cast<CanTraceEvent>(event)) {
+        case CanTraceEvent::TX: return "TX";
+        case CanTraceEvent::TX_FAIL: return "TX_FAIL";
+        case CanTraceEvent::TX_REJECT: return "TX_REJECT";
+        case CanTraceEvent::RX: return "RX";
+        case CanTraceEvent::BUS_STATE: return "BUS_STATE";
+        case CanTraceEvent::BUS_RECOVERY: return "BUS_RECOVERY";
+        default: return "?";
+    }
+}
+
+bool isFrameEvent(std::uint8_t event) {
+    return event == static_cast<std::uint8_t>(CanTraceEvent::TX) ||
+           event == static_cast<std::uint8_t>(CanTraceEvent::RX);
+}
+}
+
+CanTrace& CanTrace::instance() {
+    static CanTrace trace;
+    return trace;
+}
+
+CanTrace::CanTrace() {
+    void* storage = psramAlloc(kCapacity * sizeof(Slot));
+    if (!storage) {
+        return;
+    }
+    slots_ = static_cast<Slot*>(storage);
+    for (std::size_t i = 0; i < kCapacity; ++i) {
+        Slot* slot = new (&slots_[i]) Slot();
+        slot->seq.store(static_cast<std::uint32_t>(i), std::memory_order_relaxed);
+    }
+}
+
+std::uint32_t CanTrace::nowUs() {
+#ifdef ARDUINO
+    return static_cast<std::uint32_t>(esp_timer_get_time());
+#else
+    using namespace std::chrono;
+    return static_cast<std::uint32_t>(
+        duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+void CanTrace::record(CanTraceEvent event, std::uint32_t identifier, const std::uint8_t* data,
+                      std::uint8_t length, std::uint16_t arg) {
+    if (!slots_) {
+        return;
+    }
+
+    // Claim a slot; concurrent producers each get their own index
+    const std::uint32_t index = head_.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = slots_[index & kMask];
+    slot.seq.store(index, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    CanTraceRecord& rec = slot.rec;
+    rec.timestamp_us = nowUs();
+    rec.identifier = identifier;
+    rec.event = static_cast<std::uint8_t>(event);
+    rec.length = std::min<std::uint8_t>(length, 8);
+    rec.arg = arg;
+    if (data && rec.length) {
+        std::memcpy(rec.data, data, rec.length);
+    }
+    if (rec.length < 8) {
+        std::memset(rec.data + rec.length, 0, 8 - rec.length);
+    }
+
+    slot.seq.store(index + 1, std::memory_order_release);
+}
+
+bool CanTrace::pop(Cursor& cursor, CanTraceRecord& out) const {
+    if (!slots_) {
+        return false;
+    }
+
+    const std::uint32_t head = head_.load(std::memory_order_acquire);
+    while (cursor.tail != head) {
+        if (head - cursor.tail > kCapacity) {
+            cursor.dropped += head - cursor.tail - static_cast<std::uint32_t>(kCapacity);
+            cursor.tail = head - static_cast<std::uint32_t>(kCapacity);
+        }
+
+        const Slot& slot = slots_[cursor.tail & kMask];
+        const std::uint32_t seq = slot.seq.load(std::memory_order_acquire);
+        const std::int32_t ahead = static_cast<std::int32_t>(seq - (cursor.tail + 1));
+        if (ahead == 0) {
+            out = slot.rec;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) == seq) {
+                ++cursor.tail;
+                return true;
+            }
+        } else if (ahead < 0) {
+            // Claimed and still being written (seq == tail), or claimed by a producer that has not stored its
+            // seq yet (the previous lap's value); pick it up next pass
+            return false;
+        }
+
+        // A later lap overwrote the slot, possibly while we copied it
+        ++cursor.tail;
+        ++cursor.dropped;
+    }
+    return false;
+}
+
+bool CanTrace::pop(CanTraceRecord& out) {
+    const bool popped = pop(drain_cursor_, out);
+    dropped_.store(drain_cursor_.dropped, std::memory_order_relaxed);
+    return popped;
+}
+
+std::size_t CanTrace::copyRecent(CanTraceRecord* out, std::size_t max_records) const {
+    if (!slots_ || !out) {
+        return 0;
+    }
+
+    const std::uint32_t head = head_.load(std::memory_order_acquire);
+    const std::uint32_t span = static_cast<std::uint32_t>(
+        std::min<std::size_t>({max_records, static_cast<std::size_t>(head), kCapacity}));
+
+    std::size_t copied = 0;
+    for (std::uint32_t index = head - span; index != head; ++index) {
+        const Slot& slot = slots_[index & kMask];
+        if (slot.seq.load(std::memory_order_acquire) != index + 1) {
+            continue;
+        }
+        out[copied] = slot.rec;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) == index + 1) {
+            ++copied;
+        }
+    }
+    return copied;
+}
+
+void CanTrace::format(const CanTraceRecord& rec, char* buffer, std::size_t size) {
+    int written = std::snprintf(buffer, size, "%10lu.%03lu ms %-12s",
+                                static_cast<unsigned long>(rec.timestamp_us / 1000),
+                                static_cast<unsigned long>(rec.timestamp_us % 1000),
+                                eventName(rec.event));
+    if (written < 0 || static_cast<std::size_t>(written) >= size) {
+        return;
+    }
+
+    std::size_t pos = static_cast<std::size_t>(written);
+    if (isFrameEvent(rec.event)) {
+        written = std::snprintf(buffer + pos, size - pos, " ID=0x%08lX [%u]",
+                                static_cast<unsigned long>(rec.identifier), rec.length);
+        for (std::uint8_t i = 0; i < rec.length && written > 0; ++i) {
+            pos += static_cast<std::size_t>(written);
+            if (pos >= size) {
+                return;
+            }
+            written = std::snprintf(buffer + pos, size - pos, " %02X", rec.data[i]);
+        }
+    } else {
+        std::snprintf(buffer + pos, size - pos, " ID=0x%08lX arg=%u",
+                      static_cast<unsigned long>(rec.identifier), rec.arg);
+    }
+}
+
+void CanTrace::drainPending() {
+    CanTraceRecord rec;
+    char line[96];
+    while (pop(rec)) {
+        const bool echo = isFrameEvent(rec.event) ? echo_frames_ : echo_state_;
+        if (!echo) {
+            continue;
+        }
+        format(rec, line, sizeof(line));
+#ifdef ARDUINO
+        Serial.printf("[CanTrace] %s\n", line);
+#else
+        std::printf("[CanTrace] %s\n", line);
+#endif
+    }
+}
+
+#ifdef ARDUINO
+void CanTrace::drainTask(void* arg) {
+    auto* self = static_cast<CanTrace*>(arg);
+    while (true) {
+        self->drainPending();
+        vTaskDelay(pdMS_TO_TICKS(kDrainIntervalMs));
+    }
+}
+
+void CanTrace::startDrainTask() {
+    if (drain_started_) {
+        return;
+    }
+    // Lowest useful priority on the protocol core: formatting never competes with CAN or LVGL
+    if (xTaskCreatePinnedToCore(drainTask, "can_trace", 3072, this, tskIDLE_PRIORITY + 1, nullptr, 0) == pdPASS) {
+        drain_started_ = true;
+    }
+}
+#else
+void CanTrace::drainTask(void* arg) {
+    static_cast<CanTrace*>(arg)->drainPending();
+}
+
+void CanTrace::startDrainTask() {
+    drain_started_ = true;
+}
+#endif
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Deferred binary trace log for the CAN hot path.
+ *
+ * TX/RX/bus-state events are stored as fixed-size binary records in a
+ * lock-free multi-producer ring. Nothing is formatted on the calling task:
+ * a low-priority drain task echoes records to Serial (when enabled) and the
+ * raw records can be dumped on demand over serial or /api/can/trace and
+ * decoded on a PC with tools/can_trace_decode.py.
+ *
+ * CAN_TRACE_LEVEL selects at compile time which events are recorded at all:
+ *   0 = off, 1 = errors, 2 = bus state + errors, 3 = every frame (default).
+ */
+
+#define CAN_TRACE_LEVEL_OFF   0
+#define CAN_TRACE_LEVEL_ERROR 1
+#define CAN_TRACE_LEVEL_STATE 2
+#define CAN_TRACE_LEVEL_FRAME 3
+
+#ifndef CAN_TRACE_LEVEL
+#define CAN_TRACE_LEVEL CAN_TRACE_LEVEL_FRAME
+#endif
+
+enum class CanTraceEvent : std::uint8_t {
+    TX = 1,           // Frame handed to the driver
+    TX_FAIL = 2,      // Driver refused or timed out (arg = esp_err_t)
+    TX_REJECT = 3,    // TX queue full
+    RX = 4,           // Frame received
+    BUS_STATE = 5,    // Controller state change (arg = twai_state_t)
+    BUS_RECOVERY = 6, // Bus-off recovery initiated
+};
+
+// Wire format shared with tools/can_trace_decode.py - keep it 20 bytes, little-endian
+struct CanTraceRecord {
+    std::uint32_t timestamp_us;
+    std::uint32_t identifier;
+    std::uint8_t data[8];
+    std::uint8_t event;
+    std::uint8_t length;
+    std::uint16_t arg;            // Event argument; frame events carry flags (kCanTraceStandardFrame, kCanTraceVirtualFrame)
+};
+static_assert(sizeof(CanTraceRecord) == 20, "CanTraceRecord layout is part of the dump format");
+
+class CanTrace {
+public:
+    static constexpr std::size_t kCapacity = 1024;  // Must be a power of two; lives in PSRAM
+    static constexpr std::uint32_t kDumpMagic = 0x43525443;  // "CTRC"
+    static constexpr std::uint16_t kDumpVersion = 1;
+
+    struct DumpHeader {
+        std::uint32_t magic;
+        std::uint16_t version;
+        std::uint16_t record_size;
+        std::uint32_t count;
+        std::uint32_t dropped;
+    };
+
+    static CanTrace& instance();
+
+    // Producer side: constant cost, safe from any task
+    void record(CanTraceEvent event, std::uint32_t identifier, const std::uint8_t* data,
+                std::uint8_t length, std::uint16_t arg = 0);
+
+    // Consumer side: each cursor has one owner; the drain task keeps its own
+    struct Cursor {
+        std::uint32_t tail = 0;
+        std::uint32_t dropped = 0;  // Records this consumer lost to overwrites or torn slots
+    };
+    Cursor openCursor() const { return Cursor{head_.load(std::memory_order_acquire), 0}; }
+    bool pop(Cursor& cursor, CanTraceRecord& out) const;
+    bool pop(CanTraceRecord& out);
+
+    // Copies up to max_records of the most recent records without consuming them
+    std::size_t copyRecent(CanTraceRecord* out, std::size_t max_records) const;
+
+    static void format(const CanTraceRecord& rec, char* buffer, std::size_t size);
+
+    void startDrainTask();
+    void setEcho(bool frames, bool state) { echo_frames_ = frames; echo_state_ = state; }
+    bool echoFrames() const { return echo_frames_; }
+
+    std::uint32_t recorded() const { return head_.load(std::memory_order_relaxed); }
+    std::uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    CanTrace();
+
+    struct Slot {
+        std::atomic<std::uint32_t> seq;
+        CanTraceRecord rec;
+    };
+
+    static std::uint32_t nowUs();
+    static void drainTask(void* arg);
+    void drainPending();
+
+    Slot* slots_ = nullptr;
+    std::atomic<std::uint32_t> head_{0};
+    Cursor drain_cursor_{};
+    std::atomic<std::uint32_t> dropped_{0};
+    bool echo_frames_ = false;
+    bool echo_state_ = true;
+    bool drain_started_ = false;
+};
+
+#if CAN_TRACE_LEVEL >= CAN_TRACE_LEVEL_FRAME
+#define CAN_TRACE_FRAME(event, id, data, len, ...) CanTrace::instance().record((event), (id), (data), (len), ##__VA_ARGS__)
+#else
+#define CAN_TRACE_FRAME(event, id, data, len, ...) do { } while (0)
+#endif
+
+#if CAN_TRACE_LEVEL >= CAN_TRACE_LEVEL_STATE
+#define CAN_TRACE_STATE(event, arg) CanTrace::instance().record((event), 0, nullptr, 0, (arg))
+#else
+#define CAN_TRACE_STATE(event, arg) do { } while (0)
+#endif
+
+#if CAN_TRACE_LEVEL >= CAN_TRACE_LEVEL_ERROR
+#define CAN_TRACE_ERROR(event, id, arg) CanTrace::instance().record((event), (id), nullptr, 0, (arg))
+#else
+#define CAN_TRACE_ERROR(event, id, arg) do { } while (0)
+#endif
@@ -0,0 +1,63 @@
+#include "can_tx_queue.h"
+
+CanTxQueue::CanTxQueue() {
+    clear();
+}
+
+void CanTxQueue::clear() {
+    head_.fill(kNone);
+    tail_.fill(kNone);
+    for (std::size_t i = 0; i < kCapacity; ++i) {
+        nodes_[i].next = (i + 1 < kCapacity) ? static_cast<std::int16_t>(i + 1) : kNone;
+    }
+    free_ = 0;
+    size_ = 0;
+}
+
+bool CanTxQueue::push(const CanTxRequest& request) {
+    if (free_ == kNone) {
+        return false;
+    }
+
+    const std::int16_t index = free_;
+    Node& node = nodes_[index];
+    free_ = node.next;
+    node.request = request;
+    node.next = kNone;
+
+    const std::uint8_t level = request.priority();
+    if (tail_[level] == kNone) {
+        head_[level] = index;
+    } else {
+        nodes_[tail_[level]].next = index;
+    }
+    tail_[level] = index;
+
+    ++size_;
+    if (size_ > high_water_) {
+        high_water_ = size_;
+    }
+    return true;
+}
+
+bool CanTxQueue::pop(CanTxRequest& out) {
+    for (std::size_t level = 0; level < kPriorityLevels; ++level) {
+        const std::int16_t index = head_[level];
+        if (index == kNone) {
+            continue;
+        }
+
+        Node& node = nodes_[index];
+        out = node.request;
+        head_[level] = node.next;
+        if (head_[level] == kNone) {
+            tail_[level] = kNone;
+        }
+
+        node.next = free_;
+        free_ = index;
+        --size_;
+        return true;
+    }
+    return false;
+}
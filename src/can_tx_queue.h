@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+struct CanTxRequest;
+
+// Invoked from the TX scheduler task once the frame was handed to the bus (or given up on).
+using CanTxCallback = void (*)(const CanTxRequest& request, bool success, void* context);
+
+struct CanTxRequest {
+    std::uint32_t identifier = 0;
+    bool extended = true;
+    std::uint8_t data[8] = {};
+    std::uint8_t length = 0;
+    std::uint32_t enqueued_ms = 0;
+    bool fixed_source = false;  // Keep the SA as given (address claim frames); others get the claimed address
+    std::uint16_t trace_id = 0;  // CanLatencyTracer press that produced this frame, 0 = untraced
+    bool spaced = false;         // Button frame whose PGN the coalescer holds until CanButtonCoalescer::transmitted()
+    CanTxCallback callback = nullptr;
+    void* context = nullptr;
+
+    // 11-bit frames carry no J1939 priority; they queue behind all J1939 traffic
+    static constexpr std::uint8_t kStandardFramePriority = 7;
+
+    // J1939 priority lives in identifier bits 26-28; lower values win arbitration
+    std::uint8_t priority() const {
+        return extended ? static_cast<std::uint8_t>((identifier >> 26) & 0x7) : kStandardFramePriority;
+    }
+};
+
+/**
+ * Bounded priority queue for outbound CAN frames.
+ *
+ * Frames are ordered by J1939 priority (0 first, standard 11-bit frames
+ * last) and FIFO within the same priority, so multi-frame sequences keep
+ * their order. Storage is a fixed node pool; push() fails instead of
+ * allocating when the queue is full. Not thread-safe: CanManager guards
+ * it with a spinlock.
+ */
+class CanTxQueue {
+public:
+    static constexpr std::size_t kCapacity = 32;
+    static constexpr std::size_t kPriorityLevels = 8;
+
+    CanTxQueue();
+
+    bool push(const CanTxRequest& request);
+    bool pop(CanTxRequest& out);
+    void clear();
+
+    std::size_t size() const { return size_; }
+    std::size_t highWater() const { return high_water_; }
+    bool empty() const { return size_ == 0; }
+    bool full() const { return size_ >= kCapacity; }
+
+private:
+    static constexpr std::int16_t kNone = -1;
+
+    struct Node {
+        CanTxRequest request;
+        std::int16_t next = kNone;
+    };
+
+    std::array<Node, kCapacity> nodes_{};
+    std::array<std::int16_t, kPriorityLevels> head_{};
+    std::array<std::int16_t, kPriorityLevels> tail_{};
+    std::int16_t free_ = kNone;
+    std::size_t size_ = 0;
+    std::size_t high_water_ = 0;
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// Struct for received CAN messages (different from CanMessage in config_types.h)
+struct CanRxMessage {
+    uint32_t identifier;
+    uint8_t data[8];
+    uint8_t length;
+    uint32_t timestamp;      // ms, same clock as millis()
+    uint64_t timestamp_us;   // When the driver handed the frame over (esp_timer); timestamp is this / 1000
+};
+
+// J1939 29-bit identifier: [Priority(3) | Reserved(1) | DataPage(1) | PDU Format(8) | PDU Specific(8) | Source Address(8)]
+// PDU1 formats (PF < 240) carry the destination address in the PDU Specific byte.
+inline uint32_t buildJ1939Identifier(uint8_t priority, uint32_t pgn, uint8_t source_address, uint8_t destination_address) {
+    const uint8_t data_page = (pgn >> 16) & 0x01;
+    const uint8_t pdu_format = (pgn >> 8) & 0xFF;
+    uint8_t pdu_specific = pgn & 0xFF;
+    if (pdu_format < 240) {
+        pdu_specific = destination_address;
+    }
+
+    return (static_cast<uint32_t>(priority & 0x7) << 26) |
+           (static_cast<uint32_t>(data_page) << 24) |
+           (static_cast<uint32_t>(pdu_format) << 16) |
+           (static_cast<uint32_t>(pdu_specific) << 8) |
+           static_cast<uint32_t>(source_address);
+}
+
+// PGN carried by a J1939 identifier; PDU1 PGNs drop the destination byte
+inline uint32_t j1939PgnFromIdentifier(uint32_t identifier) {
+    uint32_t pgn = (identifier >> 8) & 0x3FFFF;
+    if (((pgn >> 8) & 0xFF) < 240) {
+        pgn &= 0x3FF00;
+    }
+    return pgn;
+}
+
+// Bitrates every CAN backend supports (TWAI timing presets), slowest first
+constexpr std::array<uint32_t, 4> kCanBitrates = {125000, 250000, 500000, 1000000};
+
+inline bool canBitrateSupported(uint32_t bitrate) {
+    for (uint32_t supported : kCanBitrates) {
+        if (supported == bitrate) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Worst-case bit count of an extended (29-bit) data frame including stuff bits
+// and the 3-bit interframe space: 54 stuffable header/CRC bits + data, 13 fixed bits.
+inline uint32_t canExtendedFrameBits(uint8_t length) {
+    const uint32_t stuffable = 54 + 8u * length;
+    return stuffable + 13 + (stuffable - 1) / 4;
+}
+
+// Same for a standard (11-bit) data frame: 34 stuffable bits + data
+inline uint32_t canStandardFrameBits(uint8_t length) {
+    const uint32_t stuffable = 34 + 8u * length;
+    return stuffable + 13 + (stuffable - 1) / 4;
+}
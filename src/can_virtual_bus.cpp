@@ -0,0 +1,446 @@
+#include "can_virtual_bus.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "can_platform.h"
+#include "can_types.h"
+
+namespace {
+constexpr std::uint32_t kErrorFrameBits = 20;          // Error flag, delimiter and intermission
+constexpr std::uint32_t kRecoveryBits = 128 * 11;      // Bus-off recovery: 128 occurrences of 11 recessive bits
+constexpr std::uint32_t kWarningLimit = 96;
+constexpr std::uint32_t kPassiveLimit = 128;
+constexpr std::uint32_t kBusOffLimit = 255;
+constexpr std::uint64_t kMinWaitUs = 50;
+
+// Arbitration field as the wire sends it, so a lower key wins: base ID, then RTR/SRR, then IDE, then the ID extension
+std::uint64_t arbitrationKey(const CanFrame& frame) {
+    if (frame.extended) {
+        const std::uint64_t base = (frame.identifier >> 18) & 0x7FF;
+        return (base << 20) | (1u << 19) | (1u << 18) | (frame.identifier & 0x3FFFF);
+    }
+    return static_cast<std::uint64_t>(frame.identifier & 0x7FF) << 20;
+}
+
+std::uint32_t frameBits(const CanFrame& frame) {
+    return frame.extended ? canExtendedFrameBits(frame.length) : canStandardFrameBits(frame.length);
+}
+
+bool accepts(const CanDriverConfig& config, const CanFrame& frame) {
+    if (config.filter.mode == CanFilterPlan::Mode::ACCEPT_ALL) {
+        return true;
+    }
+    // Planned filters only describe 29-bit identifiers
+    return frame.extended && CanFilterPlanner::hardwareAccepts(config.filter, frame.identifier);
+}
+}
+
+VirtualCanBus::VirtualCanBus(std::uint32_t bitrate) : bitrate_(bitrate ? bitrate : 250000) {}
+
+VirtualCanBus::Node& VirtualCanBus::addNode(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    nodes_.push_back(std::unique_ptr<Node>(new Node(*this, name)));
+    return *nodes_.back();
+}
+
+void VirtualCanBus::setBitrate(std::uint32_t bitrate) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bitrate_ = bitrate ? bitrate : bitrate_;
+}
+
+std::uint32_t VirtualCanBus::bitrate() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bitrate_;
+}
+
+void VirtualCanBus::setClock(Clock clock) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    clock_ = clock;
+    idle_since_us_ = now();
+    in_flight_ = InFlight{};
+}
+
+void VirtualCanBus::injectErrors(std::uint32_t frames, Node* node) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (node) {
+        node->error_budget_ += frames;
+    } else {
+        injected_errors_ += frames;
+    }
+}
+
+void VirtualCanBus::setConnected(Node& node, bool connected) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    node.connected_ = connected;
+    node.attempt_at_us_ = 0;
+}
+
+std::uint64_t VirtualCanBus::advance() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return process(now());
+}
+
+VirtualCanBus::Stats VirtualCanBus::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+std::uint64_t VirtualCanBus::now() const {
+    return clock_ ? clock_() : canMicros();
+}
+
+std::uint64_t VirtualCanBus::bitsToUs(std::uint32_t bits) const {
+    return (static_cast<std::uint64_t>(bits) * 1000000 + bitrate_ - 1) / bitrate_;
+}
+
+std::uint64_t VirtualCanBus::process(std::uint64_t now_us) {
+    bool changed = false;
+    std::uint64_t next = UINT64_MAX;
+
+    for (auto& owned : nodes_) {
+        Node& node = *owned;
+        if (node.status_.state == CanDriverState::RECOVERING) {
+            if (node.recovered_at_us_ <= now_us) {
+                node.status_.state = CanDriverState::STOPPED;  // Like TWAI: recovered, but start() is required
+                node.status_.tx_error_counter = 0;
+                node.status_.rx_error_counter = 0;
+                node.passive_ = false;
+                node.warning_ = false;
+                node.alerts_ |= canAlertBit(CanBusAlert::BUS_RECOVERED);
+                changed = true;
+            } else {
+                next = std::min(next, node.recovered_at_us_);
+            }
+        }
+
+        // A node cut off from the wire retransmits into silence until it is error passive
+        if (!node.connected_ && node.status_.state == CanDriverState::RUNNING && !node.tx_.empty() && !node.passive_) {
+            const Node::Pending& head = node.tx_.front();
+            const std::uint64_t attempt_us = bitsToUs(frameBits(head.frame) + kErrorFrameBits);
+            if (node.attempt_at_us_ < head.queued_us) {
+                node.attempt_at_us_ = head.queued_us + attempt_us;
+            }
+            while (!node.passive_ && node.status_.state == CanDriverState::RUNNING && node.attempt_at_us_ <= now_us) {
+                transmitError(node, 8);
+                updateState(node);
+                node.attempt_at_us_ += attempt_us;
+                changed = true;
+            }
+            if (!node.passive_ && node.status_.state == CanDriverState::RUNNING) {
+                next = std::min(next, node.attempt_at_us_);
+            }
+        }
+    }
+
+    while (true) {
+        if (in_flight_.active) {
+            if (in_flight_.end_us > now_us) {
+                next = std::min(next, in_flight_.end_us);
+                break;
+            }
+            complete();
+            changed = true;
+            continue;
+        }
+
+        std::uint64_t earliest = UINT64_MAX;
+        for (auto& node : nodes_) {
+            if (node->connected_ && node->status_.state == CanDriverState::RUNNING && !node->tx_.empty()) {
+                earliest = std::min(earliest, node->tx_.front().queued_us);
+            }
+        }
+        if (earliest == UINT64_MAX) {
+            break;
+        }
+        // A start is only committed once the clock has moved past it, so frames queued in the same instant arbitrate
+        const std::uint64_t start = std::max(idle_since_us_, earliest);
+        if (start >= now_us) {
+            next = std::min(next, start);
+            break;
+        }
+
+        // Every node with a frame ready when the bus went idle arbitrates; the lowest key wins
+        Node* winner = nullptr;
+        for (auto& node : nodes_) {
+            if (!node->connected_ || node->status_.state != CanDriverState::RUNNING || node->tx_.empty() ||
+                node->tx_.front().queued_us > start) {
+                continue;
+            }
+            if (!winner || arbitrationKey(node->tx_.front().frame) < arbitrationKey(winner->tx_.front().frame)) {
+                winner = node.get();
+            }
+        }
+        for (auto& node : nodes_) {
+            if (node.get() != winner && node->connected_ && node->status_.state == CanDriverState::RUNNING &&
+                !node->tx_.empty() && node->tx_.front().queued_us <= start) {
+                node->alerts_ |= canAlertBit(CanBusAlert::ARBITRATION_LOST);
+                ++stats_.arbitration_lost;
+            }
+        }
+        in_flight_.node = winner;
+        in_flight_.end_us = start + bitsToUs(frameBits(winner->tx_.front().frame));
+        in_flight_.active = true;
+    }
+
+    if (changed) {
+        changed_.notify_all();
+    }
+    return next;
+}
+
+void VirtualCanBus::complete() {
+    in_flight_.active = false;
+    Node& sender = *in_flight_.node;
+    const std::uint64_t end_us = in_flight_.end_us;
+    const CanFrame frame = sender.tx_.front().frame;
+    stats_.busy_us += bitsToUs(frameBits(frame));
+
+    bool destroyed = sender.config_.bitrate != bitrate_;
+    if (!destroyed && sender.error_budget_) {
+        --sender.error_budget_;
+        destroyed = true;
+    } else if (!destroyed && injected_errors_) {
+        --injected_errors_;
+        destroyed = true;
+    }
+
+    bool acknowledged = false;
+    for (auto& node : nodes_) {
+        if (node.get() != &sender && node->connected_ && node->status_.state == CanDriverState::RUNNING &&
+            node->config_.bitrate == bitrate_ && !node->config_.listen_only) {
+            acknowledged = true;
+        }
+    }
+
+    if (destroyed || !acknowledged) {
+        // The frame stays queued and is retransmitted once the error frame has passed
+        ++stats_.error_frames;
+        stats_.busy_us += bitsToUs(kErrorFrameBits);
+        idle_since_us_ = end_us + bitsToUs(kErrorFrameBits);
+        // An acknowledgement error does not raise the counter of an error-passive transmitter
+        transmitError(sender, destroyed || !sender.passive_ ? 8 : 0);
+        if (destroyed) {
+            for (auto& node : nodes_) {
+                if (node.get() != &sender && node->connected_ && node->status_.state == CanDriverState::RUNNING) {
+                    receiveError(*node);
+                    updateState(*node);
+                }
+            }
+        }
+        updateState(sender);
+        return;
+    }
+
+    sender.tx_.pop_front();
+    sender.alerts_ |= kCanAlertTxSuccess;
+    if (sender.status_.tx_error_counter) {
+        --sender.status_.tx_error_counter;
+    }
+    updateState(sender);
+    ++stats_.frames;
+    idle_since_us_ = end_us;
+
+    for (auto& owned : nodes_) {
+        Node& node = *owned;
+        if (&node == &sender || !node.connected_ || node.status_.state != CanDriverState::RUNNING) {
+            continue;
+        }
+        if (node.config_.bitrate != bitrate_) {
+            receiveError(node);  // Sampling at the wrong rate only ever sees errors
+            updateState(node);
+            continue;
+        }
+        if (node.status_.rx_error_counter) {
+            --node.status_.rx_error_counter;
+            updateState(node);
+        }
+        if (!accepts(node.config_, frame)) {
+            continue;
+        }
+        if (node.rx_.size() < node.config_.rx_queue_len) {
+            node.rx_.push_back(frame);
+            node.rx_.back().timestamp_us = end_us;  // End of frame, when a controller raises its RX interrupt
+        } else {
+            ++node.status_.rx_missed;
+            node.alerts_ |= canAlertBit(CanBusAlert::RX_QUEUE_FULL);
+        }
+    }
+}
+
+void VirtualCanBus::transmitError(Node& node, std::uint32_t tec_increase) {
+    node.status_.tx_error_counter += tec_increase;
+    node.alerts_ |= canAlertBit(CanBusAlert::BUS_ERROR);
+}
+
+void VirtualCanBus::receiveError(Node& node) {
+    node.status_.rx_error_counter = std::min<std::uint32_t>(node.status_.rx_error_counter + 1, kBusOffLimit);
+    node.alerts_ |= canAlertBit(CanBusAlert::BUS_ERROR);
+}
+
+void VirtualCanBus::updateState(Node& node) {
+    if (node.status_.state != CanDriverState::RUNNING) {
+        return;
+    }
+    CanDriverStatus& status = node.status_;
+    if (status.tx_error_counter > kBusOffLimit) {
+        status.state = CanDriverState::BUS_OFF;
+        node.alerts_ |= canAlertBit(CanBusAlert::BUS_OFF);
+        if (!node.tx_.empty()) {
+            node.tx_.clear();
+            node.alerts_ |= canAlertBit(CanBusAlert::TX_FAILED);
+        }
+        if (in_flight_.active && in_flight_.node == &node) {
+            in_flight_.active = false;
+        }
+        return;
+    }
+
+    const bool warning = status.tx_error_counter >= kWarningLimit || status.rx_error_counter >= kWarningLimit;
+    if (warning && !node.warning_) {
+        node.alerts_ |= canAlertBit(CanBusAlert::ERROR_WARNING);
+    }
+    node.warning_ = warning;
+
+    const bool passive = status.tx_error_counter >= kPassiveLimit || status.rx_error_counter >= kPassiveLimit;
+    if (passive != node.passive_) {
+        node.alerts_ |= canAlertBit(passive ? CanBusAlert::ERROR_PASSIVE : CanBusAlert::ERROR_ACTIVE);
+    }
+    node.passive_ = passive;
+}
+
+template <typename Ready>
+bool VirtualCanBus::waitFor(std::unique_lock<std::mutex>& lock, std::uint32_t timeout_ms, Ready ready) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (true) {
+        const std::uint64_t now_us = now();
+        const std::uint64_t next = process(now_us);
+        if (ready()) {
+            return true;
+        }
+        const auto real_now = std::chrono::steady_clock::now();
+        if (real_now >= deadline) {
+            return false;
+        }
+        auto until = deadline;
+        if (next != UINT64_MAX) {
+            const std::uint64_t delta = std::max(next > now_us ? next - now_us : 0, kMinWaitUs);
+            until = std::min(deadline, real_now + std::chrono::microseconds(delta));
+        }
+        changed_.wait_until(lock, until);
+    }
+}
+
+bool VirtualCanBus::Node::install(const CanDriverConfig& config) {
+    std::lock_guard<std::mutex> lock(bus_.mutex_);
+    if (installed_ || !canBitrateSupported(config.bitrate)) {
+        return false;
+    }
+    installed_ = true;
+    config_ = config;
+    config_.tx_queue_len = std::max<std::uint32_t>(config_.tx_queue_len, 1);
+    config_.rx_queue_len = std::max<std::uint32_t>(config_.rx_queue_len, 1);
+    status_ = CanDriverStatus{};
+    passive_ = false;
+    warning_ = false;
+    tx_.clear();
+    rx_.clear();
+    alerts_ = 0;
+    return true;
+}
+
+void VirtualCanBus::Node::uninstall() {
+    std::lock_guard<std::mutex> lock(bus_.mutex_);
+    installed_ = false;
+    status_.state = CanDriverState::STOPPED;
+    tx_.clear();
+    rx_.clear();
+    if (bus_.in_flight_.active && bus_.in_flight_.node == this) {
+        bus_.in_flight_.active = false;
+    }
+}
+
+bool VirtualCanBus::Node::start() {
+    std::lock_guard<std::mutex> lock(bus_.mutex_);
+    if (!installed_ || status_.state != CanDriverState::STOPPED) {
+        return false;
+    }
+    status_.state = CanDriverState::RUNNING;
+    bus_.changed_.notify_all();
+    return true;
+}
+
+void VirtualCanBus::Node::stop() {
+    std::lock_guard<std::mutex> lock(bus_.mutex_);
+    status_.state = CanDriverState::STOPPED;
+    tx_.clear();
+    if (bus_.in_flight_.active && bus_.in_flight_.node == this) {
+        bus_.in_flight_.active = false;
+    }
+}
+
+int VirtualCanBus::Node::transmit(const CanFrame& frame, std::uint32_t timeout_ms) {
+    std::unique_lock<std::mutex> lock(bus_.mutex_);
+    auto running = [this]() { return installed_ && status_.state == CanDriverState::RUNNING; };
+    if (!running()) {
+        return kCanDriverInvalidState;
+    }
+    if (config_.listen_only) {
+        return kCanDriverNotSupported;
+    }
+    if (tx_.size() >= config_.tx_queue_len &&
+        !bus_.waitFor(lock, timeout_ms, [&]() { return tx_.size() < config_.tx_queue_len || !running(); })) {
+        return kCanDriverTimeout;
+    }
+    if (!running()) {
+        return kCanDriverInvalidState;
+    }
+    Pending pending;
+    pending.frame = frame;
+    pending.frame.length = std::min<std::uint8_t>(frame.length, 8);
+    pending.queued_us = bus_.now();
+    tx_.push_back(pending);
+    bus_.process(pending.queued_us);
+    bus_.changed_.notify_all();
+    return kCanDriverOk;
+}
+
+bool VirtualCanBus::Node::receive(CanFrame& frame, std::uint32_t timeout_ms) {
+    std::unique_lock<std::mutex> lock(bus_.mutex_);
+    if (!bus_.waitFor(lock, timeout_ms, [this]() { return !rx_.empty(); })) {
+        return false;
+    }
+    frame = rx_.front();
+    rx_.pop_front();
+    return true;
+}
+
+bool VirtualCanBus::Node::readAlerts(std::uint32_t& alerts, std::uint32_t timeout_ms) {
+    std::unique_lock<std::mutex> lock(bus_.mutex_);
+    if (!bus_.waitFor(lock, timeout_ms, [this]() { return alerts_ != 0; })) {
+        return false;
+    }
+    alerts = alerts_;
+    alerts_ = 0;
+    return true;
+}
+
+bool VirtualCanBus::Node::getStatus(CanDriverStatus& status) const {
+    std::lock_guard<std::mutex> lock(bus_.mutex_);
+    if (!installed_) {
+        return false;
+    }
+    status = status_;
+    status.tx_pending = static_cast<std::uint32_t>(tx_.size());
+    return true;
+}
+
+bool VirtualCanBus::Node::initiateRecovery() {
+    std::lock_guard<std::mutex> lock(bus_.mutex_);
+    if (status_.state != CanDriverState::BUS_OFF) {
+        return false;
+    }
+    status_.state = CanDriverState::RECOVERING;
+    recovered_at_us_ = bus_.now() + bus_.bitsToUs(kRecoveryBits);
+    return true;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "can_driver.h"
+
+/**
+ * In-process CAN bus with any number of controller nodes.
+ *
+ * Each node is a CanDriver, so CanManager (and test peers) run on it
+ * unchanged. The wire is modelled frame by frame: queued frames arbitrate
+ * by identifier (standard beats extended on an equal base ID), a frame
+ * occupies the bus for its worst-case stuffed length at the configured
+ * bitrate, and every other running node receives it through its acceptance
+ * filter. Error counters follow ISO 11898: TEC +8 per transmit error,
+ * REC +1 per receive error, error passive at 128, bus-off above 255 and
+ * recovery after 128 x 11 recessive bits. A frame nobody acknowledges is
+ * retransmitted, as on a bus with a single node. A node configured with a
+ * different bitrate only produces and sees errors. A listen-only node
+ * receives but never acknowledges or transmits.
+ *
+ * Time comes from a clock function (canMicros() by default); host tests can
+ * install a simulated clock and call advance() to run the wire. Blocking
+ * calls wait in real time but never longer than their timeout.
+ */
+class VirtualCanBus {
+public:
+    using Clock = std::uint64_t (*)();
+
+    struct Stats {
+        std::uint32_t frames = 0;
+        std::uint32_t error_frames = 0;
+        std::uint32_t arbitration_lost = 0;
+        std::uint64_t busy_us = 0;  // Wire time used by frames and error frames
+    };
+
+    class Node : public CanDriver {
+    public:
+        const char* name() const override { return name_.c_str(); }
+        bool install(const CanDriverConfig& config) override;
+        void uninstall() override;
+        bool start() override;
+        void stop() override;
+        int transmit(const CanFrame& frame, std::uint32_t timeout_ms) override;
+        bool receive(CanFrame& frame, std::uint32_t timeout_ms) override;
+        bool readAlerts(std::uint32_t& alerts, std::uint32_t timeout_ms) override;
+        bool getStatus(CanDriverStatus& status) const override;
+        bool initiateRecovery() override;
+
+    private:
+        friend class VirtualCanBus;
+        struct Pending {
+            CanFrame frame;
+            std::uint64_t queued_us = 0;
+        };
+
+        Node(VirtualCanBus& bus, std::string name) : bus_(bus), name_(std::move(name)) {}
+
+        VirtualCanBus& bus_;
+        std::string name_;
+        bool installed_ = false;
+        bool connected_ = true;
+        bool passive_ = false;
+        bool warning_ = false;
+        CanDriverConfig config_{};
+        CanDriverStatus status_{};
+        std::deque<Pending> tx_;
+        std::deque<CanFrame> rx_;
+        std::uint32_t alerts_ = 0;
+        std::uint64_t recovered_at_us_ = 0;
+        std::uint64_t attempt_at_us_ = 0;  // Next unacknowledged retry while disconnected
+        std::uint32_t error_budget_ = 0;  // Transmissions still to be hit by injected errors
+    };
+
+    explicit VirtualCanBus(std::uint32_t bitrate = 250000);
+    VirtualCanBus(const VirtualCanBus&) = delete;
+    VirtualCanBus& operator=(const VirtualCanBus&) = delete;
+
+    Node& addNode(const std::string& name);
+
+    void setBitrate(std::uint32_t bitrate);
+    std::uint32_t bitrate() const;
+    void setClock(Clock clock);
+
+    // Error injection: the next `frames` transmissions (from `node`, or from anyone) are destroyed by a bit error
+    void injectErrors(std::uint32_t frames, Node* node = nullptr);
+    // A disconnected node neither receives nor gets its frames acknowledged
+    void setConnected(Node& node, bool connected);
+
+    // Runs the wire up to now (the clock) and returns the time of the next event, UINT64_MAX when idle
+    std::uint64_t advance();
+    Stats stats() const;
+
+private:
+    struct InFlight {
+        Node* node = nullptr;
+        std::uint64_t end_us = 0;
+        bool active = false;
+    };
+
+    std::uint64_t now() const;
+    std::uint64_t process(std::uint64_t now_us);
+    void complete();
+    void transmitError(Node& node, std::uint32_t tec_increase);
+    void receiveError(Node& node);
+    void updateState(Node& node);
+    std::uint64_t bitsToUs(std::uint32_t bits) const;
+    // Blocks until `ready` holds or the timeout passes, running the wire meanwhile
+    template <typename Ready>
+    bool waitFor(std::unique_lock<std::mutex>& lock, std::uint32_t timeout_ms, Ready ready);
+
+    mutable std::mutex mutex_;
+    std::condition_variable changed_;
+    std::vector<std::unique_ptr<Node>> nodes_;
+    std::uint32_t bitrate_;
+    Clock clock_ = nullptr;
+    std::uint64_t idle_since_us_ = 0;
+    InFlight in_flight_{};
+    std::uint32_t injected_errors_ = 0;
+    Stats stats_{};
+};
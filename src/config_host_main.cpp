@@ -0,0 +1,563 @@
+// Host bench for config persistence: boot-time load of a 20-page / 240-button
+// configuration from the JSON file older firmware wrote versus the binary
+// config image, and that an image from a writer with shorter records reads
+// back with the missing fields at their defaults; the save after a one-button edit with images inline versus as
+// asset references; a one-label edit from the web UI sent as the whole config
+// (POST /api/config) versus as a JSON Patch (PATCH /api/config); and GET
+// /api/config built as one document versus streamed in chunks. Each reports
+// time and peak heap. Last, the internal RAM a loaded config holds. Built by the PlatformIO `native_config`
+// environment (pio run -e native_config, then .pio/build/native_config/program);
+// the device firmware never sees this file.
+
+#ifndef ARDUINO
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "asset_store.h"
+#include "can_log_format.h"
+#include "config_json.h"
+#include "config_json_stream.h"
+#include "config_patch.h"
+#include "config_store.h"
+
+namespace {
+constexpr int kIterations = 20;
+constexpr std::size_t kLegacyDocumentBytes = 524288;  // ConfigManager's JSON document before the binary image
+constexpr std::size_t kConfigPostDocumentBytes = 2097152;  // web_server.cpp's kConfigJsonLimit
+constexpr std::size_t kConfigPatchDocumentBytes = 16384;   // web_server.cpp's kConfigPatchJsonLimit
+constexpr std::size_t kResponseChunkBytes = 1436;  // What AsyncWebServer offers a chunked filler: one TCP segment less framing
+constexpr std::uint16_t kLogoWidth = 160;  // rgb565a header logo, 40 KB of base64 inline
+constexpr std::uint16_t kLogoHeight = 64;
+constexpr std::size_t kLogoBase64Bytes = kLogoWidth * kLogoHeight * 4;  // 3 bytes a pixel, 4 chars per 3 bytes
+constexpr std::size_t kSplashBase64Bytes = 48 * 1024;
+
+// Heap accounting shared by operator new and the JSON document allocator. psramAlloc is plain
+// malloc on the host, so what it serves is not counted: these figures stand for internal RAM.
+std::size_t g_heap_now = 0;
+std::size_t g_heap_peak = 0;
+std::size_t g_blocks_now = 0;
+std::size_t g_allocations = 0;
+
+void* trackedAlloc(std::size_t bytes) {
+    auto* block = static_cast<std::size_t*>(std::malloc(bytes + sizeof(std::max_align_t)));
+    if (!block) {
+        return nullptr;
+    }
+    *block = bytes;
+    g_heap_now += bytes;
+    ++g_blocks_now;
+    ++g_allocations;
+    g_heap_peak = g_heap_now > g_heap_peak ? g_heap_now : g_heap_peak;
+    return reinterpret_cast<std::uint8_t*>(block) + sizeof(std::max_align_t);
+}
+
+void trackedFree(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+    auto* block = reinterpret_cast<std::size_t*>(static_cast<std::uint8_t*>(ptr) - sizeof(std::max_align_t));
+    g_heap_now -= *block;
+    --g_blocks_now;
+    std::free(block);
+}
+
+struct TrackedJsonAllocator {
+    void* allocate(std::size_t bytes) { return trackedAlloc(bytes); }
+    void deallocate(void* ptr) { trackedFree(ptr); }
+    void* reallocate(void* ptr, std::size_t bytes) {
+        void* fresh = trackedAlloc(bytes);
+        if (fresh && ptr) {
+            const std::size_t old = *reinterpret_cast<std::size_t*>(static_cast<std::uint8_t*>(ptr) -
+                                                                    sizeof(std::max_align_t));
+            std::memcpy(fresh, ptr, old < bytes ? old : bytes);
+        }
+        trackedFree(ptr);
+        return fresh;
+    }
+};
+using TrackedJsonDocument = BasicJsonDocument<TrackedJsonAllocator>;
+
+std::string fakeBase64(std::size_t bytes) {
+    static const char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out(bytes, 'A');
+    std::uint32_t state = 0x12345678;
+    for (char& c : out) {
+        state = state * 1664525u + 1013904223u;
+        c = kAlphabet[state >> 26];
+    }
+    return out;
+}
+
+DeviceConfig largeConfig() {
+    static const char* const kColors[] = {"#FF8A00", "#1ABC9C", "#2980B9", "#9B59B6", "#E74C3C", "#27AE60"};
+    DeviceConfig config = buildDefaultConfig();
+    config.images.header_logo = "lvimg:rgb565a:" + std::to_string(kLogoWidth) + "x" + std::to_string(kLogoHeight) + ":" +
+                                fakeBase64(kLogoBase64Bytes);
+    config.images.splash_logo = "data:image/jpeg;base64," + fakeBase64(kSplashBase64Bytes);
+    config.pages.clear();
+    for (std::size_t p = 0; p < MAX_PAGES; ++p) {
+        PageConfig page;
+        page.id = "page_" + std::to_string(p);
+        page.name = "Page " + std::to_string(p + 1);
+        page.rows = 3;
+        page.cols = 4;
+        page.bg_color = "#101010";
+        for (std::size_t b = 0; b < MAX_BUTTONS_PER_PAGE; ++b) {
+            ButtonConfig button;
+            button.id = page.id + "_btn_" + std::to_string(b);
+            button.label = "Output " + std::to_string(p * MAX_BUTTONS_PER_PAGE + b + 1);
+            button.color = kColors[b % 6];
+            button.row = static_cast<std::uint8_t>(b / 4);
+            button.col = static_cast<std::uint8_t>(b % 4);
+            button.momentary = b % 3 == 0;
+            button.can.enabled = true;
+            button.can.pgn = 0xFF01;
+            button.can.priority = 6;
+            button.can.length = 8;
+            button.can.data[0] = static_cast<std::uint8_t>(b);
+            button.can.data[1] = 0x80;
+            button.can_off = button.can;
+            button.can_off.enabled = button.momentary;
+            button.can_off.data[1] = 0x00;
+            page.buttons.push_back(button);
+        }
+        config.pages.push_back(page);
+    }
+    return config;
+}
+
+struct LoadResult {
+    double mean_us = 0;
+    std::size_t peak_bytes = 0;
+    bool ok = true;
+};
+
+template <typename Load>
+LoadResult measure(Load load) {
+    LoadResult result;
+    double total_us = 0;
+    for (int i = 0; i < kIterations; ++i) {
+        DeviceConfig config;
+        const std::size_t base = g_heap_now;
+        g_heap_peak = base;
+        const auto start = std::chrono::steady_clock::now();
+        result.ok &= load(config);
+        total_us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        result.peak_bytes = std::max(result.peak_bytes, g_heap_peak - base);
+        result.ok &= config.pages.size() == MAX_PAGES && config.pages.back().buttons.size() == MAX_BUTTONS_PER_PAGE;
+    }
+    result.mean_us = total_us / kIterations;
+    return result;
+}
+
+// What ConfigManager does on the device, minus the LittleFS write of the payload
+bool moveImagesToAssets(DeviceConfig& config) {
+    for (std::string* value : {&config.images.header_logo, &config.images.splash_logo}) {
+        AssetHeader header;
+        std::vector<std::uint8_t> payload;
+        std::string error;
+        if (!decodeInlineImage(*value, header, payload, error)) {
+            std::printf("    asset: %s\n", error.c_str());
+            return false;
+        }
+        AssetHasher hasher(header);
+        hasher.update(payload.data(), payload.size());
+        *value = assetRef(hasher.id());
+    }
+    return true;
+}
+
+// One save after a button colour change: encode the whole config (writeToStorage's input)
+LoadResult measureSave(DeviceConfig& config, std::size_t& bytes) {
+    static const char* const kEdits[] = {"#FF0000", "#00FF00"};
+    LoadResult result;
+    double total_us = 0;
+    for (int i = 0; i < kIterations; ++i) {
+        config.pages[3].buttons[5].color = kEdits[i % 2];
+        const std::size_t base = g_heap_now;
+        g_heap_peak = base;
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<std::uint8_t> image;
+        encodeConfigImage(config, image);
+        bytes = image.size();
+        total_us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        result.peak_bytes = std::max(result.peak_bytes, g_heap_peak - base);
+    }
+    result.mean_us = total_us / kIterations;
+    return result;
+}
+
+// One label edit as the web handlers receive it: parse the body, then fold it into the live config
+template <typename Update>
+LoadResult measureUpdate(DeviceConfig& config, Update update) {
+    LoadResult result;
+    double total_us = 0;
+    for (int i = 0; i < kIterations; ++i) {
+        const std::size_t base = g_heap_now;
+        g_heap_peak = base;
+        const auto start = std::chrono::steady_clock::now();
+        result.ok &= update(config, i);
+        total_us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        result.peak_bytes = std::max(result.peak_bytes, g_heap_peak - base);
+    }
+    result.mean_us = total_us / kIterations;
+    return result;
+}
+
+std::string labelFor(int run) {
+    return run % 2 ? "Fog lights" : "Work lights";
+}
+
+// `image` as a writer from before the fields from byte `cut` on were appended to `section`'s records would
+// have written it: the same sections and strings, those records `cut` bytes long
+std::vector<std::uint8_t> shortenRecords(const std::vector<std::uint8_t>& image, ConfigSection section,
+                                         std::size_t cut) {
+    ConfigImageHeader header;
+    std::memcpy(&header, image.data(), sizeof(header));
+    std::vector<ConfigImageSection> table(header.section_count);
+    std::memcpy(table.data(), image.data() + sizeof(header), table.size() * sizeof(ConfigImageSection));
+
+    std::vector<std::uint8_t> out(sizeof(header) + table.size() * sizeof(ConfigImageSection));
+    for (ConfigImageSection& entry : table) {
+        const std::size_t record_size = entry.id == static_cast<std::uint16_t>(section) ? cut : entry.record_size;
+        const std::size_t offset = (out.size() + 3) & ~std::size_t(3);
+        out.resize(offset);
+        for (std::uint32_t i = 0; i < entry.count; ++i) {
+            const std::uint8_t* record = image.data() + entry.offset + i * entry.record_size;
+            out.insert(out.end(), record, record + record_size);
+        }
+        entry.offset = static_cast<std::uint32_t>(offset);
+        entry.record_size = static_cast<std::uint16_t>(record_size);
+    }
+    std::memcpy(out.data() + sizeof(header), table.data(), table.size() * sizeof(ConfigImageSection));
+    header.size = static_cast<std::uint32_t>(out.size());
+    header.crc = canLogCrc32(out.data() + sizeof(header), out.size() - sizeof(header));
+    std::memcpy(out.data(), &header, sizeof(header));
+    return out;
+}
+
+// An image from a writer that predates the trailing fields of the device, page and button records: what
+// it did have must come through, what it did not must come out at the config structs' defaults
+bool checkOlderWriter(const DeviceConfig& source, const std::vector<std::uint8_t>& image_file) {
+    std::vector<std::uint8_t> older = shortenRecords(image_file, ConfigSection::DEVICE,
+                                                     offsetof(ConfigImageDevice, j1939_address_claim));
+    older = shortenRecords(older, ConfigSection::PAGES, offsetof(ConfigImagePage, nav_button_radius));
+    older = shortenRecords(older, ConfigSection::BUTTONS, offsetof(ConfigImageButton, font_family));
+
+    DeviceConfig config;
+    ConfigImage view;
+    std::string error;
+    if (!view.open(older.data(), older.size(), error) || !decodeConfigImage(view, config, error) ||
+        config.pages.size() != source.pages.size()) {
+        return false;
+    }
+
+    const J1939Config j1939{};
+    const PageConfig page_defaults{};
+    const ButtonConfig button_defaults{};
+    bool ok = config.theme.accent_color == source.theme.accent_color &&
+              config.can_bus.bitrate == source.can_bus.bitrate &&
+              config.j1939.address_claim == j1939.address_claim &&
+              config.j1939.preferred_address == j1939.preferred_address &&
+              config.j1939.address_max == j1939.address_max;
+    for (std::size_t p = 0; ok && p < config.pages.size(); ++p) {
+        const PageConfig& page = config.pages[p];
+        ok = page.name == source.pages[p].name && page.buttons.size() == source.pages[p].buttons.size() &&
+             page.nav_button_radius == page_defaults.nav_button_radius && page.rows == page_defaults.rows &&
+             page.cols == page_defaults.cols;
+        for (std::size_t b = 0; ok && b < page.buttons.size(); ++b) {
+            const ButtonConfig& button = page.buttons[b];
+            ok = button.label == source.pages[p].buttons[b].label &&
+                 button.font_family == button_defaults.font_family &&
+                 button.text_align == button_defaults.text_align && button.row_span == button_defaults.row_span &&
+                 button.col_span == button_defaults.col_span && button.font_size == button_defaults.font_size &&
+                 button.corner_radius == button_defaults.corner_radius;
+        }
+    }
+    return ok;
+}
+
+// A removed theme, page or button field comes back at its config_types.h default, whichever section it is in
+bool checkPatchRemove(const DeviceConfig& source) {
+    DeviceConfig config = source;
+    config.theme.accent_color = "#123456";
+    config.pages[0].text_color = "#ABCDEF";
+    config.pages[0].buttons[0].text_align = "top-left";
+    const char* body = "[{\"op\":\"remove\",\"path\":\"/theme/accent_color\"},"
+                       "{\"op\":\"remove\",\"path\":\"/pages/0/text_color\"},"
+                       "{\"op\":\"remove\",\"path\":\"/pages/0/buttons/0/text_align\"}]";
+    TrackedJsonDocument doc(kConfigPatchDocumentBytes);
+    if (deserializeJson(doc, body)) {
+        return false;
+    }
+    ConfigPatchResult result;
+    std::string error;
+    return applyConfigPatch(doc.as<JsonArrayConst>(), config, result, error) &&
+           config.theme.accent_color == ThemeConfig{}.accent_color &&
+           config.pages[0].text_color == PageConfig{}.text_color &&
+           config.pages[0].buttons[0].text_align == ButtonConfig{}.text_align;
+}
+
+// A section too large for the stream's biggest piece document (decodeConfigJson does not cap extra_pgns)
+// fails the stream where it stands: the body ends before that section and is never closed, so it cannot
+// be taken for a whole config
+bool checkStreamOverflow(const DeviceConfig& source) {
+    DeviceConfig config = source;
+    config.can_filter.extra_pgns.assign(4096, 0xFEF1);
+    ConfigJsonStream stream(config);
+    std::uint8_t chunk[kResponseChunkBytes];
+    std::string body;
+    for (std::size_t n; (n = stream.fill(chunk, sizeof(chunk))) > 0;) {
+        body.append(reinterpret_cast<const char*>(chunk), n);
+    }
+    TrackedJsonDocument doc(kLegacyDocumentBytes);
+    return stream.failed() && stream.fill(chunk, sizeof(chunk)) == 0 &&
+           body.find("extra_pgns") == std::string::npos && deserializeJson(doc, body);
+}
+}
+
+void* operator new(std::size_t bytes) {
+    void* ptr = trackedAlloc(bytes);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    trackedFree(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    trackedFree(ptr);
+}
+
+int main() {
+    const DeviceConfig source = largeConfig();
+
+    // The "files": what ConfigManager wrote before and writes now
+    std::string json_file;
+    {
+        TrackedJsonDocument doc(kLegacyDocumentBytes);
+        encodeConfigJson(source, doc);
+        serializeJson(doc, json_file);
+    }
+    std::vector<std::uint8_t> image_file;
+    encodeConfigImage(source, image_file);
+
+    std::printf("Config load (%zu pages x %zu buttons, %zu KB of base64 images, %d runs)\n", MAX_PAGES,
+                MAX_BUTTONS_PER_PAGE, (kLogoBase64Bytes + kSplashBase64Bytes) / 1024, kIterations);
+
+    // Before: the whole file through a 512 KB document, then decodeConfigJson
+    const LoadResult json = measure([&](DeviceConfig& config) {
+        TrackedJsonDocument doc(kLegacyDocumentBytes);
+        if (deserializeJson(doc, json_file)) {
+            return false;
+        }
+        std::string error;
+        return decodeConfigJson(doc.as<JsonVariantConst>(), config, error);
+    });
+
+    // After: one buffer holding the file, checked and read in place
+    const LoadResult image = measure([&](DeviceConfig& config) {
+        auto* buffer = static_cast<std::uint8_t*>(trackedAlloc(image_file.size()));
+        std::memcpy(buffer, image_file.data(), image_file.size());  // Stands in for the LittleFS read
+        ConfigImage view;
+        std::string error;
+        const bool ok = view.open(buffer, image_file.size(), error) && decodeConfigImage(view, config, error);
+        trackedFree(buffer);
+        return ok;
+    });
+
+    std::printf("    json : %7zu byte file, load %8.0f us, peak heap %7zu bytes\n", json_file.size(), json.mean_us,
+                json.peak_bytes);
+    std::printf("    image: %7zu byte file, load %8.0f us, peak heap %7zu bytes\n", image_file.size(), image.mean_us,
+                image.peak_bytes);
+
+    // The image must carry exactly what the JSON did
+    DeviceConfig from_image;
+    ConfigImage view;
+    std::string error;
+    std::vector<std::uint8_t> again;
+    const bool round_trip = view.open(image_file.data(), image_file.size(), error) &&
+                            decodeConfigImage(view, from_image, error) &&
+                            (encodeConfigImage(from_image, again), again == image_file);
+    std::printf("    round trip: %s\n", round_trip ? "identical" : error.empty() ? "differs" : error.c_str());
+    const bool older_writer = checkOlderWriter(source, image_file);
+    std::printf("    older writer: %s\n", older_writer ? "missing fields at defaults" : "wrong");
+
+    // Saving after an edit: every image byte rewritten each time, versus a 22-byte reference per image
+    DeviceConfig inline_images = source;
+    DeviceConfig asset_refs = source;
+    const bool moved = moveImagesToAssets(asset_refs);
+    std::size_t inline_bytes = 0;
+    std::size_t ref_bytes = 0;
+    const LoadResult save_inline = measureSave(inline_images, inline_bytes);
+    const LoadResult save_refs = measureSave(asset_refs, ref_bytes);
+    std::string json_inline;
+    std::string json_refs;
+    {
+        TrackedJsonDocument doc(kLegacyDocumentBytes);
+        encodeConfigJson(inline_images, doc);
+        serializeJson(doc, json_inline);
+        doc.clear();
+        encodeConfigJson(asset_refs, doc);
+        serializeJson(doc, json_refs);
+    }
+    std::printf("Config save after one button colour change (%d runs)\n", kIterations);
+    std::printf("    inline images: %7zu byte image, save %8.0f us, peak heap %7zu bytes, /api/config %7zu bytes\n",
+                inline_bytes, save_inline.mean_us, save_inline.peak_bytes, json_inline.size());
+    std::printf("    asset refs   : %7zu byte image, save %8.0f us, peak heap %7zu bytes, /api/config %7zu bytes\n",
+                ref_bytes, save_refs.mean_us, save_refs.peak_bytes, json_refs.size());
+
+    // Editing one button label from the web UI: the whole config (images stay out, as the UI sends it)
+    // through the POST handler's document and updateFromJson's copy-and-decode, versus one patch operation
+    std::string post_body;
+    {
+        TrackedJsonDocument doc(kLegacyDocumentBytes);
+        encodeConfigJson(asset_refs, doc);
+        doc.remove("images");
+        serializeJson(doc, post_body);
+    }
+    DeviceConfig posted = asset_refs;
+    const LoadResult full_update = measureUpdate(posted, [&](DeviceConfig& config, int run) {
+        const std::string label = "\"label\":\"" + asset_refs.pages[7].buttons[4].label + "\"";
+        std::string body = post_body;
+        body.replace(body.find(label), label.size(), "\"label\":\"" + labelFor(run) + "\"");
+        TrackedJsonDocument doc(kConfigPostDocumentBytes);
+        if (deserializeJson(doc, body)) {
+            return false;
+        }
+        DeviceConfig incoming = config;
+        std::string error;
+        if (!decodeConfigJson(doc.as<JsonVariantConst>(), incoming, error)) {
+            return false;
+        }
+        config = std::move(incoming);
+        return config.pages[7].buttons[4].label == labelFor(run);
+    });
+    DeviceConfig patched = asset_refs;
+    std::size_t patch_bytes = 0;
+    const LoadResult patch_update = measureUpdate(patched, [&](DeviceConfig& config, int run) {
+        const std::string body = "[{\"op\":\"replace\",\"path\":\"/pages/7/buttons/4/label\",\"value\":\"" +
+                                 labelFor(run) + "\"}]";
+        patch_bytes = body.size();
+        TrackedJsonDocument doc(kConfigPatchDocumentBytes);
+        if (deserializeJson(doc, body)) {
+            return false;
+        }
+        ConfigPatchResult result;
+        std::string error;
+        if (!applyConfigPatch(doc.as<JsonArrayConst>(), config, result, error)) {
+            std::printf("    patch: %s\n", error.c_str());
+            return false;
+        }
+        return config.pages[7].buttons[4].label == labelFor(run) && result.changed.size() == 1;
+    });
+    std::vector<std::uint8_t> posted_image;
+    std::vector<std::uint8_t> patched_image;
+    encodeConfigImage(posted, posted_image);
+    encodeConfigImage(patched, patched_image);
+    const bool same_result = posted_image == patched_image;
+    std::printf("Config update after one button label edit (%d runs)\n", kIterations);
+    std::printf("    POST  : %7zu byte body, decode %8.0f us, peak heap %7zu bytes\n", post_body.size(),
+                full_update.mean_us, full_update.peak_bytes);
+    std::printf("    PATCH : %7zu byte body, decode %8.0f us, peak heap %7zu bytes\n", patch_bytes, patch_update.mean_us,
+                patch_update.peak_bytes);
+    std::printf("    resulting configs: %s\n", same_result ? "identical" : "differ");
+    const bool patch_remove = checkPatchRemove(asset_refs);
+    std::printf("    removed fields: %s\n", patch_remove ? "at defaults" : "wrong");
+
+
+    // GET /api/config on the live config (images as asset references). Before: ConfigManager::toJson's
+    // 512 KB document and std::string, then the handler's String copy. After: the chunked stream, each
+    // chunk dropped as the TCP send would.
+    std::size_t whole_bytes = 0;
+    const LoadResult get_whole = measureUpdate(patched, [&](DeviceConfig& config, int) {
+        TrackedJsonDocument doc(kLegacyDocumentBytes);
+        encodeConfigJson(config, doc);
+        std::string json_text;
+        serializeJson(doc, json_text);
+        const std::string payload(json_text.c_str());  // String payload(json.c_str())
+        whole_bytes = payload.size();
+        return !doc.overflowed();
+    });
+    std::size_t streamed_bytes = 0;
+    std::size_t chunks = 0;
+    const LoadResult get_stream = measureUpdate(patched, [&](DeviceConfig& config, int) {
+        ConfigJsonStream stream(config);
+        std::uint8_t chunk[kResponseChunkBytes];
+        streamed_bytes = 0;
+        chunks = 0;
+        for (std::size_t n; (n = stream.fill(chunk, sizeof(chunk))) > 0; ++chunks) {
+            streamed_bytes += n;
+        }
+        return true;
+    });
+    std::string whole_body;
+    {
+        TrackedJsonDocument doc(kLegacyDocumentBytes);
+        encodeConfigJson(patched, doc);
+        serializeJson(doc, whole_body);
+    }
+    std::string streamed_body;
+    {
+        ConfigJsonStream stream(patched);
+        std::uint8_t chunk[kResponseChunkBytes];
+        for (std::size_t n; (n = stream.fill(chunk, sizeof(chunk))) > 0;) {
+            streamed_body.append(reinterpret_cast<const char*>(chunk), n);
+        }
+    }
+    const bool same_body = whole_body == streamed_body;
+    std::printf("GET /api/config (%d runs)\n", kIterations);
+    std::printf("    document: %7zu byte body, encode %8.0f us, peak heap %7zu bytes\n", whole_bytes, get_whole.mean_us,
+                get_whole.peak_bytes);
+    std::printf("    streamed: %7zu byte body, encode %8.0f us, peak heap %7zu bytes (%zu chunks of %zu)\n",
+                streamed_bytes, get_stream.mean_us, get_stream.peak_bytes, chunks, kResponseChunkBytes);
+    std::printf("    bodies: %s\n", same_body ? "identical" : "differ");
+    const bool stream_overflow = checkStreamOverflow(asset_refs);
+    std::printf("    oversized section: %s\n", stream_overflow ? "stream failed, body unterminated" : "wrong");
+
+    // Boot: the live config decoded from its image. Blocks still held afterwards are what it leaves
+    // scattered through internal RAM; allocations counts the churn on the way.
+    std::vector<std::uint8_t> live_image;
+    encodeConfigImage(asset_refs, live_image);
+    bool live_ok = false;
+    std::size_t live_bytes = 0;
+    std::size_t live_blocks = 0;
+    std::size_t live_allocations = 0;
+    std::size_t live_peak = 0;
+    {
+        const std::size_t base = g_heap_now;
+        const std::size_t base_blocks = g_blocks_now;
+        const std::size_t base_allocations = g_allocations;
+        g_heap_peak = base;
+        DeviceConfig live;
+        ConfigImage live_view;
+        std::string live_error;
+        live_ok = live_view.open(live_image.data(), live_image.size(), live_error) &&
+                  decodeConfigImage(live_view, live, live_error);
+        live_bytes = g_heap_now - base;
+        live_blocks = g_blocks_now - base_blocks;
+        live_allocations = g_allocations - base_allocations;
+        live_peak = g_heap_peak - base;
+    }
+    std::printf("Loaded config in internal RAM (%zu pages x %zu buttons)\n", MAX_PAGES, MAX_BUTTONS_PER_PAGE);
+    std::printf("    held %7zu bytes in %5zu blocks, high-water %7zu bytes, %5zu allocations while loading\n",
+                live_bytes, live_blocks, live_peak, live_allocations);
+
+    return json.ok && image.ok && round_trip && older_writer && moved && full_update.ok && patch_update.ok && same_result && patch_remove && live_ok &&
+                   get_whole.ok && get_stream.ok && same_body && stream_overflow
+               ? 0
+               : 1;
+}
+
+#endif
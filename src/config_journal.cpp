@@ -0,0 +1,371 @@
+#include "config_journal.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "can_log_format.h"
+#include "config_store.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <LittleFS.h>
+#endif
+
+namespace {
+constexpr std::size_t kMergeGap = 8;                  // Unchanged bytes a patch absorbs rather than split
+constexpr std::uint32_t kMaxImageBytes = 1024 * 1024;  // Sanity bound on a record's image_size
+
+bool validImage(const std::vector<std::uint8_t>& image) {
+    ConfigImage view;
+    std::string error;
+    return view.open(image.data(), image.size(), error);
+}
+
+std::uint32_t imageCrc(const std::vector<std::uint8_t>& image) {
+    ConfigImageHeader header;
+    std::memcpy(&header, image.data(), sizeof(header));
+    return header.crc;
+}
+
+std::uint32_t recordCrc(ConfigJournalRecord record, const std::uint8_t* payload) {
+    record.crc = 0;
+    const std::uint32_t crc = canLogCrc32(reinterpret_cast<const std::uint8_t*>(&record), sizeof(record));
+    return canLogCrc32(payload, record.payload_size, crc);
+}
+
+template <typename T>
+void appendBytes(std::vector<std::uint8_t>& out, const T& value) {
+    const auto* bytes = reinterpret_cast<const std::uint8_t*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+}
+
+ConfigJournal::Recovery ConfigJournal::recover(std::vector<std::uint8_t>& image, std::string& report) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.replayed_records = 0;
+    stats_.torn_tail = false;
+    stats_.promoted_temp = false;
+    live_.clear();
+    base_size_ = 0;
+    base_crc_ = 0;
+    stats_.journal_bytes = 0;
+    stats_.journal_records = 0;
+
+    std::vector<std::uint8_t> base;
+    std::vector<std::uint8_t> temp;
+    std::vector<std::uint8_t> journal;
+    const bool have_base = files_.readFile(kBasePath, base);
+    const bool have_temp = files_.readFile(kTempPath, temp);
+    const bool have_journal = files_.readFile(kJournalPath, journal);
+
+    if (have_temp && validImage(temp)) {
+        // A base rewrite synced its new image but did not get to the rename; that image is the newest
+        files_.removeFile(kJournalPath);
+        files_.renameFile(kTempPath, kBasePath);
+        live_ = std::move(temp);
+        base_size_ = static_cast<std::uint32_t>(live_.size());
+        base_crc_ = imageCrc(live_);
+        stats_.promoted_temp = true;
+        image = live_;
+        report = "finished an interrupted rewrite (" + std::to_string(live_.size()) + " bytes)";
+        return Recovery::RECOVERED;
+    }
+    if (have_temp) {
+        files_.removeFile(kTempPath);  // Torn: the base and journal still hold the state before it
+    }
+    if (!have_base || !validImage(base)) {
+        report = have_base ? "config image damaged" : "no config image";
+        return have_base || have_journal ? Recovery::DAMAGED : Recovery::EMPTY;
+    }
+
+    live_ = std::move(base);
+    base_size_ = static_cast<std::uint32_t>(live_.size());
+    base_crc_ = imageCrc(live_);
+    report = "base " + std::to_string(live_.size()) + " bytes";
+    if (!have_journal) {
+        image = live_;
+        return Recovery::RECOVERED;
+    }
+
+    std::size_t used = 0;
+    std::vector<std::uint8_t> replayed = live_;
+    if (!replay(journal, replayed, used)) {
+        files_.removeFile(kJournalPath);  // Written against an older base, or never finished its header
+        report += ", stale journal dropped";
+        image = live_;
+        return Recovery::RECOVERED;
+    }
+    live_ = std::move(replayed);
+    stats_.journal_bytes = static_cast<std::uint32_t>(used);
+    stats_.journal_records = stats_.replayed_records;
+    report += " + " + std::to_string(stats_.replayed_records) + " journal records";
+    if (used < journal.size()) {
+        // Appending after the torn record would hide every later one from replay; fold it all into a new base
+        stats_.torn_tail = true;
+        report += ", torn tail dropped";
+        if (writeBase(live_)) {
+            ++stats_.compactions;
+        }
+    }
+    image = live_;
+    return Recovery::RECOVERED;
+}
+
+bool ConfigJournal::save(const std::vector<std::uint8_t>& image) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (image == live_) {
+        return true;
+    }
+    const bool journal_usable = !live_.empty() && stats_.journal_bytes < 2 * kCompactBytes;
+    std::vector<std::uint8_t> record = journal_usable ? buildRecord(live_, image) : std::vector<std::uint8_t>();
+    if (!record.empty()) {
+        bool written;
+        const std::size_t before = stats_.journal_bytes;
+        if (before == 0) {
+            ConfigJournalHeader header{};
+            header.magic = kConfigJournalMagic;
+            header.version = kConfigJournalVersion;
+            header.base_size = base_size_;
+            header.base_crc = base_crc_;
+            record.insert(record.begin(), reinterpret_cast<const std::uint8_t*>(&header),
+                          reinterpret_cast<const std::uint8_t*>(&header) + sizeof(header));
+            written = files_.writeFile(kJournalPath, record.data(), record.size());
+        } else {
+            written = files_.appendFile(kJournalPath, record.data(), record.size());
+        }
+        if (written) {
+            live_ = image;
+            stats_.journal_bytes = static_cast<std::uint32_t>(before + record.size());
+            ++stats_.journal_records;
+            ++stats_.journal_appends;
+            return true;
+        }
+        // Whatever part of the record reached flash is a torn tail now; a new base leaves it behind
+        ++stats_.write_failures;
+    }
+    return writeBase(image);
+}
+
+bool ConfigJournal::compact(const std::vector<std::uint8_t>& image) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stats_.journal_bytes == 0 && image == live_) {
+        return true;
+    }
+    if (!writeBase(image)) {
+        return false;
+    }
+    ++stats_.compactions;
+    return true;
+}
+
+bool ConfigJournal::compactionDue() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_.journal_bytes >= kCompactBytes;
+}
+
+std::vector<std::uint8_t> ConfigJournal::current() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return live_;
+}
+
+ConfigJournal::Stats ConfigJournal::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+std::vector<std::uint8_t> ConfigJournal::buildRecord(const std::vector<std::uint8_t>& from,
+                                                     const std::vector<std::uint8_t>& to) {
+    struct Run {
+        std::size_t offset;
+        std::size_t length;
+    };
+    std::vector<Run> runs;
+    std::size_t payload = 0;
+    const std::size_t common = std::min(from.size(), to.size());
+    for (std::size_t i = 0; i < common; ++i) {
+        if (from[i] == to[i]) {
+            continue;
+        }
+        std::size_t last = i;
+        for (std::size_t j = i + 1; j < common && j - last <= kMergeGap; ++j) {
+            if (from[j] != to[j]) {
+                last = j;
+            }
+        }
+        runs.push_back({i, last + 1 - i});
+        payload += sizeof(ConfigJournalPatch) + last + 1 - i;
+        i = last;
+        if (payload > kMaxRecordBytes) {
+            return {};
+        }
+    }
+    if (to.size() > from.size()) {
+        if (!runs.empty() && from.size() - (runs.back().offset + runs.back().length) <= kMergeGap) {
+            payload += to.size() - (runs.back().offset + runs.back().length);
+            runs.back().length = to.size() - runs.back().offset;
+        } else {
+            runs.push_back({from.size(), to.size() - from.size()});
+            payload += sizeof(ConfigJournalPatch) + to.size() - from.size();
+        }
+    }
+    if (payload > kMaxRecordBytes || runs.size() > 0xFFFF) {
+        return {};
+    }
+
+    ConfigJournalRecord record{};
+    record.magic = kConfigJournalRecordMagic;
+    record.image_size = static_cast<std::uint32_t>(to.size());
+    record.payload_size = static_cast<std::uint32_t>(payload);
+    record.patch_count = static_cast<std::uint16_t>(runs.size());
+
+    std::vector<std::uint8_t> out;
+    out.reserve(sizeof(record) + payload);
+    appendBytes(out, record);
+    for (const Run& run : runs) {
+        appendBytes(out, ConfigJournalPatch{static_cast<std::uint32_t>(run.offset),
+                                            static_cast<std::uint32_t>(run.length)});
+        out.insert(out.end(), to.begin() + run.offset, to.begin() + run.offset + run.length);
+    }
+    record.crc = recordCrc(record, out.data() + sizeof(record));
+    std::memcpy(out.data(), &record, sizeof(record));
+    return out;
+}
+
+bool ConfigJournal::applyRecord(const ConfigJournalRecord& record, const std::uint8_t* payload,
+                                std::vector<std::uint8_t>& image) {
+    if (record.image_size > kMaxImageBytes) {
+        return false;
+    }
+    image.resize(record.image_size);
+    std::size_t position = 0;
+    for (std::uint16_t i = 0; i < record.patch_count; ++i) {
+        ConfigJournalPatch patch;
+        if (record.payload_size - position < sizeof(patch)) {
+            return false;
+        }
+        std::memcpy(&patch, payload + position, sizeof(patch));
+        position += sizeof(patch);
+        if (patch.length > record.payload_size - position || patch.offset > image.size() ||
+            patch.length > image.size() - patch.offset) {
+            return false;
+        }
+        std::memcpy(image.data() + patch.offset, payload + position, patch.length);
+        position += patch.length;
+    }
+    return position == record.payload_size;
+}
+
+bool ConfigJournal::writeBase(const std::vector<std::uint8_t>& image) {
+    // The new image is complete on flash before anything else changes; recover() promotes it from here on
+    if (!files_.writeFile(kTempPath, image.data(), image.size())) {
+        files_.removeFile(kTempPath);
+        ++stats_.write_failures;
+        return false;
+    }
+    files_.removeFile(kJournalPath);
+    if (!files_.renameFile(kTempPath, kBasePath)) {
+        ++stats_.write_failures;
+        stats_.journal_bytes = 2 * kCompactBytes;  // The journal is gone; only another base write is safe
+        return false;
+    }
+    live_ = image;
+    base_size_ = static_cast<std::uint32_t>(image.size());
+    base_crc_ = imageCrc(image);
+    stats_.journal_bytes = 0;
+    stats_.journal_records = 0;
+    ++stats_.base_writes;
+    return true;
+}
+
+bool ConfigJournal::replay(const std::vector<std::uint8_t>& journal, std::vector<std::uint8_t>& image,
+                           std::size_t& used) {
+    ConfigJournalHeader header;
+    if (journal.size() < sizeof(header)) {
+        return false;
+    }
+    std::memcpy(&header, journal.data(), sizeof(header));
+    if (header.magic != kConfigJournalMagic || header.version != kConfigJournalVersion ||
+        header.base_size != base_size_ || header.base_crc != base_crc_) {
+        return false;
+    }
+
+    const std::vector<std::uint8_t> base = image;
+    std::size_t position = sizeof(header);
+    std::uint32_t records = 0;
+    while (journal.size() - position >= sizeof(ConfigJournalRecord)) {
+        ConfigJournalRecord record;
+        std::memcpy(&record, journal.data() + position, sizeof(record));
+        const std::uint8_t* payload = journal.data() + position + sizeof(record);
+        if (record.magic != kConfigJournalRecordMagic ||
+            record.payload_size > journal.size() - position - sizeof(record) ||
+            recordCrc(record, payload) != record.crc || !applyRecord(record, payload, image)) {
+            break;
+        }
+        position += sizeof(record) + record.payload_size;
+        ++records;
+    }
+
+    if (records && !validImage(image)) {
+        // Every record checked out yet the result does not; trust the base alone
+        image = base;
+        used = sizeof(header);
+        stats_.replayed_records = 0;
+        return true;
+    }
+    used = position;
+    stats_.replayed_records = records;
+    return true;
+}
+
+#ifdef ARDUINO
+namespace {
+class LittleFsConfigFiles : public ConfigFileSystem {
+public:
+    bool readFile(const char* path, std::vector<std::uint8_t>& out) override {
+        if (!LittleFS.exists(path)) {
+            return false;
+        }
+        File file = LittleFS.open(path, FILE_READ);
+        if (!file) {
+            return false;
+        }
+        out.resize(file.size());
+        const std::size_t read = file.read(out.data(), out.size());
+        file.close();
+        return read == out.size();
+    }
+
+    bool writeFile(const char* path, const std::uint8_t* data, std::size_t length) override {
+        return store(LittleFS.open(path, FILE_WRITE), data, length);
+    }
+
+    bool appendFile(const char* path, const std::uint8_t* data, std::size_t length) override {
+        return store(LittleFS.open(path, FILE_APPEND), data, length);
+    }
+
+    bool renameFile(const char* from, const char* to) override {
+        return LittleFS.rename(from, to);
+    }
+
+    bool removeFile(const char* path) override {
+        return !LittleFS.exists(path) || LittleFS.remove(path);
+    }
+
+private:
+    static bool store(File file, const std::uint8_t* data, std::size_t length) {
+        if (!file) {
+            return false;
+        }
+        const bool written = file.write(data, length) == length;
+        file.flush();  // fsync: the data is on flash before the caller's next step depends on it
+        file.close();
+        return written;
+    }
+};
+}
+
+ConfigFileSystem& littleFsConfigFiles() {
+    static LittleFsConfigFiles files;
+    return files;
+}
+#endif
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Power-safe persistence of the binary config image (config_store.h).
+//
+// The base image (/config.bin) is only ever replaced whole: written to
+// /config.tmp, synced, then renamed over the old one. Edits in between are
+// appended to /config.jnl as records that patch the previous image byte
+// ranges; with images encoded against their predecessor (encodeConfigImage
+// with `previous`) a typical edit is a few dozen bytes. A journal names the
+// base it applies to by CRC, so a base that was replaced after the journal
+// was written makes that journal void rather than misapplied.
+//
+// Each step leaves flash in a state recover() turns back into either the
+// image before the save or the one being saved:
+//   - a torn /config.tmp fails its CRC and is dropped;
+//   - a complete /config.tmp that was never renamed is newer than everything
+//     else and is promoted;
+//   - a torn journal record fails its CRC and replay stops before it.
+// The journal is compacted (folded into a new base) once it grows past
+// kCompactBytes; the host harness (config_journal_host_main.cpp) cuts power
+// at every byte of a run of saves and checks recovery after each.
+
+struct ConfigJournalHeader {
+    std::uint32_t magic;      // kConfigJournalMagic
+    std::uint16_t version;    // kConfigJournalVersion
+    std::uint16_t reserved;
+    std::uint32_t base_size;  // The /config.bin the records apply to
+    std::uint32_t base_crc;   // Its ConfigImageHeader::crc
+};
+static_assert(sizeof(ConfigJournalHeader) == 16, "ConfigJournalHeader is part of the file format");
+
+// Followed by patch_count ConfigJournalPatch entries, each followed by its bytes
+struct ConfigJournalRecord {
+    std::uint32_t magic;         // kConfigJournalRecordMagic
+    std::uint32_t image_size;    // The image is resized to this before the patches apply
+    std::uint32_t payload_size;  // Bytes after this record header
+    std::uint16_t patch_count;
+    std::uint16_t reserved;
+    std::uint32_t crc;           // CRC-32 of this header (crc zeroed) and the payload
+};
+static_assert(sizeof(ConfigJournalRecord) == 20, "ConfigJournalRecord is part of the file format");
+
+struct ConfigJournalPatch {
+    std::uint32_t offset;
+    std::uint32_t length;
+};
+static_assert(sizeof(ConfigJournalPatch) == 8, "ConfigJournalPatch is part of the file format");
+
+constexpr std::uint32_t kConfigJournalMagic = 0x4A474643;        // "CFGJ"
+constexpr std::uint32_t kConfigJournalRecordMagic = 0x52474643;  // "CFGR"
+constexpr std::uint16_t kConfigJournalVersion = 1;
+
+// The few file operations the journal needs: LittleFS on the device, simulated flash in the host harness
+class ConfigFileSystem {
+public:
+    virtual ~ConfigFileSystem() = default;
+
+    // False when the file does not exist
+    virtual bool readFile(const char* path, std::vector<std::uint8_t>& out) = 0;
+    // Creates or truncates, writes, syncs
+    virtual bool writeFile(const char* path, const std::uint8_t* data, std::size_t length) = 0;
+    // Appends and syncs
+    virtual bool appendFile(const char* path, const std::uint8_t* data, std::size_t length) = 0;
+    // Replaces `to` in one step
+    virtual bool renameFile(const char* from, const char* to) = 0;
+    virtual bool removeFile(const char* path) = 0;
+};
+
+#ifdef ARDUINO
+ConfigFileSystem& littleFsConfigFiles();
+#endif
+
+class ConfigJournal {
+public:
+    static constexpr const char* kBasePath = "/config.bin";
+    static constexpr const char* kTempPath = "/config.tmp";
+    static constexpr const char* kJournalPath = "/config.jnl";
+    static constexpr std::size_t kCompactBytes = 16 * 1024;  // Journal size that makes compaction due
+    static constexpr std::size_t kMaxRecordBytes = 4096;     // Bigger edits rewrite the base instead
+
+    enum class Recovery {
+        EMPTY,      // No config on flash
+        RECOVERED,
+        DAMAGED,    // Files exist but none holds a usable image
+    };
+
+    struct Stats {
+        std::uint32_t base_writes = 0;
+        std::uint32_t journal_appends = 0;
+        std::uint32_t compactions = 0;
+        std::uint32_t write_failures = 0;
+        std::uint32_t replayed_records = 0;  // By the last recover()
+        std::uint32_t journal_bytes = 0;
+        std::uint32_t journal_records = 0;
+        bool torn_tail = false;              // recover() dropped a partial record
+        bool promoted_temp = false;          // recover() finished an interrupted base rewrite
+    };
+
+    explicit ConfigJournal(ConfigFileSystem& files) : files_(files) {}
+
+    // Rebuilds the newest complete image; leaves flash tidy (no temp file, no torn journal tail)
+    Recovery recover(std::vector<std::uint8_t>& image, std::string& report);
+
+    // Persists `image`: a journal record when it is a small change from the last one, else a new base
+    bool save(const std::vector<std::uint8_t>& image);
+    // Folds the journal into a new base holding `image`, which must be what the journal already describes
+    // or newer; an encode without `previous` also drops the unused strings that edits left behind
+    bool compact(const std::vector<std::uint8_t>& image);
+    bool compactionDue() const;
+
+    // The image as flash holds it now, for encoding the next save against
+    std::vector<std::uint8_t> current() const;
+    Stats stats() const;
+
+    // Patch records that turn `from` into `to`; empty when the change is too big to journal
+    static std::vector<std::uint8_t> buildRecord(const std::vector<std::uint8_t>& from,
+                                                 const std::vector<std::uint8_t>& to);
+    // Applies one record's payload to `image`; false if it does not fit
+    static bool applyRecord(const ConfigJournalRecord& record, const std::uint8_t* payload,
+                            std::vector<std::uint8_t>& image);
+
+private:
+    bool writeBase(const std::vector<std::uint8_t>& image);
+    bool replay(const std::vector<std::uint8_t>& journal, std::vector<std::uint8_t>& image, std::size_t& used);
+
+    ConfigFileSystem& files_;
+    mutable std::mutex mutex_;
+    std::vector<std::uint8_t> live_;  // Base plus journal: what recover() would return now
+    std::uint32_t base_size_ = 0;
+    std::uint32_t base_crc_ = 0;
+    Stats stats_{};
+};
@@ -0,0 +1,394 @@
+// Host harness for config persistence.
+//
+// Power cuts: runs a series of saves (journal appends, base rewrites, a
+// compaction) on simulated flash, cuts power at every byte written and before
+// every rename or remove, reboots, and checks that recovery yields the config
+// from just before or just after the save that was cut, and that the next
+// save after recovery survives too. Writes tear at the byte, which is harsher
+// than LittleFS (it commits whole files on sync).
+//
+// Editing session: 50 edits in bursts, saved the old way (a synchronous save
+// in every handler) and through ConfigSaveScheduler (handlers mark the config
+// dirty, a worker polled every 100 ms of simulated time writes it), reporting
+// handler time and flash writes for each. Handler times are host times on
+// simulated flash; on the device each write also waits on LittleFS.
+//
+// Built by the PlatformIO `native_journal` environment (pio run -e
+// native_journal, then .pio/build/native_journal/program); the device
+// firmware never sees this file.
+
+#ifndef ARDUINO
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "config_journal.h"
+#include "config_save_scheduler.h"
+#include "config_store.h"
+
+namespace {
+constexpr std::size_t kUnlimited = std::numeric_limits<std::size_t>::max();
+
+// Files in memory with a power budget: one unit per byte written, per file open and per rename or remove
+class SimFlash : public ConfigFileSystem {
+public:
+    void arm(std::size_t budget) { budget_ = budget; used_ = 0; dead_ = false; }
+    bool dead() const { return dead_; }
+    std::size_t used() const { return used_; }
+    std::size_t writes() const { return writes_; }
+
+    bool readFile(const char* path, std::vector<std::uint8_t>& out) override {
+        auto it = files_.find(path);
+        if (it == files_.end()) {
+            return false;
+        }
+        out = it->second;
+        return true;
+    }
+
+    bool writeFile(const char* path, const std::uint8_t* data, std::size_t length) override {
+        if (!spend()) {
+            return false;
+        }
+        ++writes_;
+        files_[path].clear();
+        return put(files_[path], data, length);
+    }
+
+    bool appendFile(const char* path, const std::uint8_t* data, std::size_t length) override {
+        if (!spend()) {
+            return false;
+        }
+        ++writes_;
+        return put(files_[path], data, length);
+    }
+
+    bool renameFile(const char* from, const char* to) override {
+        auto it = files_.find(from);
+        if (it == files_.end() || !spend()) {
+            return false;
+        }
+        files_[to] = std::move(it->second);
+        files_.erase(from);
+        return true;
+    }
+
+    bool removeFile(const char* path) override {
+        if (!files_.count(path)) {
+            return true;
+        }
+        if (!spend()) {
+            return false;
+        }
+        files_.erase(path);
+        return true;
+    }
+
+private:
+    bool spend() {
+        if (dead_ || used_ == budget_) {
+            dead_ = true;
+            return false;
+        }
+        ++used_;
+        return true;
+    }
+
+    bool put(std::vector<std::uint8_t>& file, const std::uint8_t* data, std::size_t length) {
+        for (std::size_t i = 0; i < length; ++i) {
+            if (!spend()) {
+                return false;
+            }
+            file.push_back(data[i]);
+        }
+        return true;
+    }
+
+    std::map<std::string, std::vector<std::uint8_t>> files_;
+    std::size_t budget_ = kUnlimited;
+    std::size_t used_ = 0;
+    std::size_t writes_ = 0;
+    bool dead_ = false;
+};
+
+DeviceConfig smallConfig() {
+    static const char* const kColors[] = {"#FF8A00", "#1ABC9C", "#2980B9"};
+    DeviceConfig config;
+    for (int p = 0; p < 2; ++p) {
+        PageConfig page;
+        page.id = "page_" + std::to_string(p);
+        page.name = "Page " + std::to_string(p + 1);
+        for (int b = 0; b < 4; ++b) {
+            ButtonConfig button;
+            button.id = page.id + "_btn_" + std::to_string(b);
+            button.label = "Output " + std::to_string(p * 4 + b + 1);
+            button.color = kColors[b % 3];
+            button.row = static_cast<std::uint8_t>(b / 2);
+            button.col = static_cast<std::uint8_t>(b % 2);
+            button.can.enabled = true;
+            button.can.pgn = 0xFF01;
+            button.can.data[0] = static_cast<std::uint8_t>(b);
+            page.buttons.push_back(button);
+        }
+        config.pages.push_back(page);
+    }
+    return config;
+}
+
+struct Step {
+    const char* name;
+    std::function<void(DeviceConfig&)> edit;
+    bool compact;
+};
+
+const std::vector<Step>& steps() {
+    static const std::vector<Step> kSteps = {
+        {"first save", [](DeviceConfig&) {}, false},
+        {"button colour", [](DeviceConfig& c) { c.pages[0].buttons[1].color = "#E74C3C"; }, false},
+        {"button label", [](DeviceConfig& c) { c.pages[1].buttons[2].label = "Fog lights"; }, false},
+        {"theme accent", [](DeviceConfig& c) { c.theme.accent_color = "#00C2FF"; }, false},
+        {"brightness", [](DeviceConfig& c) { c.display.brightness = 40; }, false},
+        {"add button", [](DeviceConfig& c) {
+             ButtonConfig button = c.pages[0].buttons[0];
+             button.id = "page_0_btn_4";
+             button.label = "Winch";
+             c.pages[0].buttons.push_back(button);
+         }, false},
+        {"button colour", [](DeviceConfig& c) { c.pages[0].buttons[4].color = "#27AE60"; }, false},
+        {"compaction", [](DeviceConfig&) {}, true},
+        {"button label", [](DeviceConfig& c) { c.pages[0].buttons[0].label = "Headlights"; }, false},
+        {"remove page", [](DeviceConfig& c) { c.pages.pop_back(); }, false},
+    };
+    return kSteps;
+}
+
+std::vector<std::uint8_t> canonical(const DeviceConfig& config) {
+    std::vector<std::uint8_t> image;
+    encodeConfigImage(config, image);
+    return image;
+}
+
+// ConfigManager::save(): encode against what flash holds, then journal it
+bool save(ConfigJournal& journal, const DeviceConfig& config, bool compact) {
+    std::vector<std::uint8_t> image;
+    if (compact) {
+        encodeConfigImage(config, image);
+        return journal.compact(image);
+    }
+    const std::vector<std::uint8_t> current = journal.current();
+    ConfigImage previous;
+    std::string error;
+    const bool incremental = previous.open(current.data(), current.size(), error);
+    encodeConfigImage(config, image, incremental ? &previous : nullptr);
+    return journal.save(image);
+}
+
+bool recoverConfig(SimFlash& flash, DeviceConfig& config, ConfigJournal::Recovery& recovery) {
+    ConfigJournal journal(flash);
+    std::vector<std::uint8_t> image;
+    std::string report;
+    recovery = journal.recover(image, report);
+    if (recovery != ConfigJournal::Recovery::RECOVERED) {
+        return false;
+    }
+    ConfigImage view;
+    std::string error;
+    config = DeviceConfig{};
+    return view.open(image.data(), image.size(), error) && decodeConfigImage(view, config, error);
+}
+
+enum class Outcome { BEFORE, AFTER, FAILED };
+
+// Runs the steps until the budget runs out, reboots, and classifies what came back
+Outcome runCut(std::size_t budget, const std::vector<std::vector<std::uint8_t>>& expected, std::size_t& cut_step) {
+    SimFlash flash;
+    flash.arm(budget);
+    DeviceConfig config = smallConfig();
+    {
+        ConfigJournal journal(flash);
+        std::vector<std::uint8_t> image;
+        std::string report;
+        journal.recover(image, report);
+        cut_step = steps().size();
+        for (std::size_t i = 0; i < steps().size(); ++i) {
+            steps()[i].edit(config);
+            save(journal, config, steps()[i].compact);
+            if (flash.dead()) {
+                cut_step = i;
+                break;
+            }
+        }
+    }
+
+    flash.arm(kUnlimited);
+    DeviceConfig recovered;
+    ConfigJournal::Recovery recovery;
+    Outcome outcome = Outcome::FAILED;
+    if (recoverConfig(flash, recovered, recovery)) {
+        const std::vector<std::uint8_t> image = canonical(recovered);
+        if (image == expected[cut_step + 1]) {
+            outcome = Outcome::AFTER;
+        } else if (image == expected[cut_step]) {
+            outcome = Outcome::BEFORE;
+        }
+    } else if (recovery == ConfigJournal::Recovery::EMPTY && cut_step == 0) {
+        outcome = Outcome::BEFORE;  // Cut during the very first save: nothing was there before either
+        recovered = smallConfig();
+    }
+    if (outcome == Outcome::FAILED) {
+        return outcome;
+    }
+
+    // Life goes on after the reboot: one more edit must land and survive the next boot
+    {
+        ConfigJournal journal(flash);
+        std::vector<std::uint8_t> image;
+        std::string report;
+        journal.recover(image, report);
+        recovered.display.brightness = 77;
+        if (!save(journal, recovered, false)) {
+            return Outcome::FAILED;
+        }
+    }
+    DeviceConfig again;
+    if (!recoverConfig(flash, again, recovery) || canonical(again) != canonical(recovered)) {
+        return Outcome::FAILED;
+    }
+    return outcome;
+}
+
+struct SessionResult {
+    std::vector<double> handler_us;
+    std::size_t flash_writes = 0;
+    std::size_t flash_units = 0;
+    std::vector<std::uint8_t> final_image;
+};
+
+// 50 edits: five bursts of ten, 150 ms apart (a slider drag, a run of form posts), 4 s between bursts
+void sessionEdit(DeviceConfig& config, int edit) {
+    if (edit % 2 == 0) {
+        config.display.brightness = static_cast<std::uint8_t>(20 + edit);
+    } else {
+        config.pages[0].buttons[edit % 4].label = "Edit " + std::to_string(edit);
+    }
+}
+
+std::uint32_t sessionTime(int edit) {
+    return static_cast<std::uint32_t>((edit / 10) * 4000 + (edit % 10) * 150);
+}
+
+double elapsedUs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+SessionResult runSession(bool deferred) {
+    SessionResult result;
+    SimFlash flash;
+    ConfigJournal journal(flash);
+    DeviceConfig config = smallConfig();
+    save(journal, config, false);
+    const std::size_t writes_before = flash.writes();
+    const std::size_t units_before = flash.used();
+
+    ConfigSaveScheduler scheduler;
+    auto tick = [&](std::uint32_t now_ms) {
+        if (scheduler.due(now_ms)) {
+            const std::uint32_t generation = scheduler.beginWrite();
+            scheduler.endWrite(generation, save(journal, config, false), now_ms);
+        }
+    };
+
+    std::uint32_t now_ms = 0;
+    for (int edit = 0; edit < 50; ++edit) {
+        for (; now_ms < sessionTime(edit); now_ms += 100) {
+            tick(now_ms);
+        }
+        const auto start = std::chrono::steady_clock::now();
+        sessionEdit(config, edit);
+        if (deferred) {
+            scheduler.markDirty(now_ms);
+        } else {
+            save(journal, config, false);
+        }
+        result.handler_us.push_back(elapsedUs(start));
+    }
+    for (std::uint32_t end = now_ms + ConfigSaveScheduler::kMaxDelayMs; now_ms <= end; now_ms += 100) {
+        tick(now_ms);
+    }
+
+    result.flash_writes = flash.writes() - writes_before;
+    result.flash_units = flash.used() - units_before;
+    result.final_image = canonical(config);
+    DeviceConfig recovered;
+    ConfigJournal::Recovery recovery;
+    if (!recoverConfig(flash, recovered, recovery) || canonical(recovered) != result.final_image) {
+        result.final_image.clear();  // The last edit did not reach flash
+    }
+    return result;
+}
+
+void printSession(const char* name, SessionResult result) {
+    std::sort(result.handler_us.begin(), result.handler_us.end());
+    std::printf("    %-26s handler median %7.2f us, max %7.2f us; %2zu flash writes, %5zu bytes%s\n", name,
+                result.handler_us[result.handler_us.size() / 2], result.handler_us.back(), result.flash_writes,
+                result.flash_units, result.final_image.empty() ? " (LOST EDITS)" : "");
+}
+}
+
+int main() {
+    // expected[i] is the config once i steps have been saved (expected[0]: nothing saved yet)
+    std::vector<std::vector<std::uint8_t>> expected;
+    DeviceConfig config = smallConfig();
+    expected.push_back({});
+    SimFlash flash;
+    ConfigJournal journal(flash);
+    std::printf("Config journal: what each save writes\n");
+    for (const Step& step : steps()) {
+        step.edit(config);
+        const std::size_t before = flash.used();
+        const ConfigJournal::Stats stats = journal.stats();
+        save(journal, config, step.compact);
+        const ConfigJournal::Stats after = journal.stats();
+        std::printf("    %-14s %6zu flash units, %s\n", step.name, flash.used() - before,
+                    after.journal_appends > stats.journal_appends ? "journal record"
+                    : after.compactions > stats.compactions      ? "compaction"
+                                                                 : "new base image");
+        expected.push_back(canonical(config));
+    }
+    const std::size_t total = flash.used();
+    expected.push_back(expected.back());  // A cut past the last step has nothing after it
+
+    std::size_t before = 0;
+    std::size_t after = 0;
+    std::size_t failed = 0;
+    for (std::size_t budget = 0; budget < total; ++budget) {
+        std::size_t cut_step = 0;
+        switch (runCut(budget, expected, cut_step)) {
+            case Outcome::BEFORE: ++before; break;
+            case Outcome::AFTER: ++after; break;
+            case Outcome::FAILED:
+                if (failed++ < 10) {
+                    std::printf("    FAILED: power cut at unit %zu (during \"%s\")\n", budget, steps()[cut_step].name);
+                }
+                break;
+        }
+    }
+    std::printf("Power cut at each of %zu points: %zu recovered the previous save, %zu the new one, %zu failed\n",
+                total, before, after, failed);
+
+    std::printf("Editing session: 50 edits in five bursts\n");
+    const SessionResult sync = runSession(false);
+    const SessionResult deferred = runSession(true);
+    printSession("save in every handler", sync);
+    printSession("deferred, coalesced", deferred);
+    const bool lost = sync.final_image.empty() || deferred.final_image.empty();
+    return failed == 0 && !lost ? 0 : 1;
+}
+
+#endif
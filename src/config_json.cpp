@@ -0,0 +1,1074 @@
+#include "config_json.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <sstream>
+
+#include "can_types.h"
+#include "version_auto.h"
+
+namespace {
+template <typename T>
+T clampValue(T value, T min_value, T max_value) {
+    return std::min(max_value, std::max(min_value, value));
+}
+
+std::string safeString(JsonVariantConst value, const std::string& fallback) {
+    if (value.is<const char*>()) {
+        return std::string(value.as<const char*>());
+    }
+    if (value.is<std::string>()) {
+        return value.as<std::string>();
+    }
+    if (value.is<long>()) {
+        return std::to_string(value.as<long>());
+    }
+    if (value.is<unsigned long>()) {
+        return std::to_string(value.as<unsigned long>());
+    }
+    return fallback;
+}
+
+std::string sanitizeColor(const std::string& hex) {
+    if (hex.size() == 7 && hex[0] == '#') {
+        return hex;
+    }
+    return "#FFA500";
+}
+
+bool isValidHexColor(const std::string& hex) {
+    if (hex.size() != 7 || hex[0] != '#') {
+        return false;
+    }
+    for (std::size_t i = 1; i < hex.size(); ++i) {
+        if (!std::isxdigit(static_cast<unsigned char>(hex[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string sanitizeColorOptional(const std::string& hex, const std::string& fallback = "") {
+    if (hex.empty()) {
+        return fallback;
+    }
+    return isValidHexColor(hex) ? hex : fallback;
+}
+
+std::string trimCopy(const std::string& value) {
+    const std::size_t start = value.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos) {
+        return "";
+    }
+    const std::size_t end = value.find_last_not_of(" \t\r\n");
+    return value.substr(start, end - start + 1);
+}
+
+std::string fallbackId(const char* prefix, std::size_t index) {
+    std::ostringstream oss;
+    oss << prefix << '_' << index;
+    return oss.str();
+}
+
+// Infinitybox IPM1 frames are proprietary PGNs 0xFF01/0xFF02 from the tool address 0x80
+CanSequenceStep infinityboxStep(std::uint32_t pgn, std::uint8_t byte0, std::uint8_t byte1 = 0x00) {
+    CanSequenceStep step;
+    step.pgn = pgn;
+    step.priority = 6;
+    step.source_address = 0x80;
+    step.data[0] = byte0;
+    step.data[1] = byte1;
+    step.delay_ms = 10;
+    return step;
+}
+
+CanSequenceConfig infinityboxSequence(const char* id, const char* name, const char* group,
+                                      std::vector<CanSequenceStep> steps) {
+    CanSequenceConfig seq;
+    seq.id = id;
+    seq.name = name;
+    seq.group = group;
+    seq.overlap = "restart";
+    seq.steps = std::move(steps);
+    return seq;
+}
+}
+
+DeviceConfig buildDefaultConfig() {
+    DeviceConfig cfg;
+    cfg.version = APP_VERSION;
+    cfg.header.title = "CAN Control";
+    cfg.header.subtitle = "Configuration Interface";
+    cfg.header.show_logo = true;
+    cfg.header.logo_variant = "";  // Empty by default - no built-in logo
+    cfg.header.title_font = "montserrat_24";
+    cfg.header.subtitle_font = "montserrat_12";
+    cfg.header.logo_target_height = 64;
+    cfg.header.logo_preserve_aspect = true;
+    cfg.header.nav_spacing = 12;
+
+    cfg.display.brightness = 100;
+    cfg.display.sleep_enabled = false;
+    cfg.display.sleep_timeout_seconds = 60;
+
+    // Ensure WiFi AP is always enabled by default
+    cfg.wifi.ap.enabled = true;
+    cfg.wifi.ap.ssid = "CAN-Control";
+    cfg.wifi.ap.password.clear();
+    cfg.wifi.sta.enabled = false;
+
+    cfg.ota.enabled = true;
+    // cfg.ota.auto_apply = true;  // Removed - manual-only
+    cfg.ota.manifest_url = kOtaManifestUrl;
+    cfg.ota.channel = "stable";
+    // cfg.ota.check_interval_minutes = 60;  // Removed - manual-only
+
+    // Initialize available fonts
+    cfg.available_fonts.clear();
+    FontConfig font_12; font_12.name = "montserrat_12"; font_12.display_name = "Montserrat 12"; font_12.size = 12;
+    cfg.available_fonts.push_back(font_12);
+    FontConfig font_14; font_14.name = "montserrat_14"; font_14.display_name = "Montserrat 14"; font_14.size = 14;
+    cfg.available_fonts.push_back(font_14);
+    FontConfig font_16; font_16.name = "montserrat_16"; font_16.display_name = "Montserrat 16"; font_16.size = 16;
+    cfg.available_fonts.push_back(font_16);
+    FontConfig font_18; font_18.name = "montserrat_18"; font_18.display_name = "Montserrat 18"; font_18.size = 18;
+    cfg.available_fonts.push_back(font_18);
+    FontConfig font_20; font_20.name = "montserrat_20"; font_20.display_name = "Montserrat 20"; font_20.size = 20;
+    cfg.available_fonts.push_back(font_20);
+    FontConfig font_22; font_22.name = "montserrat_22"; font_22.display_name = "Montserrat 22"; font_22.size = 22;
+    cfg.available_fonts.push_back(font_22);
+    FontConfig font_24; font_24.name = "montserrat_24"; font_24.display_name = "Montserrat 24"; font_24.size = 24;
+    cfg.available_fonts.push_back(font_24);
+    FontConfig font_26; font_26.name = "montserrat_26"; font_26.display_name = "Montserrat 26"; font_26.size = 26;
+    cfg.available_fonts.push_back(font_26);
+    FontConfig font_28; font_28.name = "montserrat_28"; font_28.display_name = "Montserrat 28"; font_28.size = 28;
+    cfg.available_fonts.push_back(font_28);
+    FontConfig font_30; font_30.name = "montserrat_30"; font_30.display_name = "Montserrat 30"; font_30.size = 30;
+    cfg.available_fonts.push_back(font_30);
+    FontConfig font_32; font_32.name = "montserrat_32"; font_32.display_name = "Montserrat 32"; font_32.size = 32;
+    cfg.available_fonts.push_back(font_32);
+    FontConfig font_34; font_34.name = "montserrat_34"; font_34.display_name = "Montserrat 34"; font_34.size = 34;
+    cfg.available_fonts.push_back(font_34);
+    FontConfig font_36; font_36.name = "montserrat_36"; font_36.display_name = "Montserrat 36"; font_36.size = 36;
+    cfg.available_fonts.push_back(font_36);
+    FontConfig font_38; font_38.name = "montserrat_38"; font_38.display_name = "Montserrat 38"; font_38.size = 38;
+    cfg.available_fonts.push_back(font_38);
+    FontConfig font_40; font_40.name = "montserrat_40"; font_40.display_name = "Montserrat 40"; font_40.size = 40;
+    cfg.available_fonts.push_back(font_40);
+    FontConfig font_42; font_42.name = "montserrat_42"; font_42.display_name = "Montserrat 42"; font_42.size = 42;
+    cfg.available_fonts.push_back(font_42);
+    FontConfig font_44; font_44.name = "montserrat_44"; font_44.display_name = "Montserrat 44"; font_44.size = 44;
+    cfg.available_fonts.push_back(font_44);
+    FontConfig font_46; font_46.name = "montserrat_46"; font_46.display_name = "Montserrat 46"; font_46.size = 46;
+    cfg.available_fonts.push_back(font_46);
+    FontConfig font_48; font_48.name = "montserrat_48"; font_48.display_name = "Montserrat 48"; font_48.size = 48;
+    cfg.available_fonts.push_back(font_48);
+    FontConfig font_dejavu16; font_dejavu16.name = "dejavu_16"; font_dejavu16.display_name = "DejaVu 16 (Persian/Hebrew)"; font_dejavu16.size = 16;
+    cfg.available_fonts.push_back(font_dejavu16);
+    FontConfig font_simsun16; font_simsun16.name = "simsun_16"; font_simsun16.display_name = "SimSun 16 (CJK)"; font_simsun16.size = 16;
+    cfg.available_fonts.push_back(font_simsun16);
+    FontConfig font_unscii8; font_unscii8.name = "unscii_8"; font_unscii8.display_name = "UNSCII 8"; font_unscii8.size = 8;
+    cfg.available_fonts.push_back(font_unscii8);
+    FontConfig font_unscii16; font_unscii16.name = "unscii_16"; font_unscii16.display_name = "UNSCII 16"; font_unscii16.size = 16;
+    cfg.available_fonts.push_back(font_unscii16);
+
+    PageConfig home;
+    home.id = "home";
+    home.name = "Factory Home";
+    home.rows = 2;
+    home.cols = 2;
+
+    ButtonConfig windows;
+    windows.id = "windows";
+    windows.label = "Windows";
+    windows.color = "#FF8A00";
+    windows.row = 0;
+    windows.col = 0;
+
+    ButtonConfig locks;
+    locks.id = "locks";
+    locks.label = "Locks";
+    locks.color = "#1ABC9C";
+    locks.row = 0;
+    locks.col = 1;
+
+    ButtonConfig running;
+    running.id = "running";
+    running.label = "Running Boards";
+    running.color = "#2980B9";
+    running.row = 1;
+    running.col = 0;
+
+    ButtonConfig aux;
+    aux.id = "aux";
+    aux.label = "Aux";
+    aux.color = "#9B59B6";
+    aux.row = 1;
+    aux.col = 1;
+
+    home.buttons = {windows, locks, running, aux};
+    cfg.pages = {home};
+
+    // Infinitybox output sequences (exact frame order from the working sketch)
+    constexpr std::uint32_t kFF01 = 0x00FF01;
+    constexpr std::uint32_t kFF02 = 0x00FF02;
+    cfg.can_sequences = {
+        infinityboxSequence("infinitybox_output1_on", "Infinitybox Output 1 ON", "infinitybox_output1",
+                            {infinityboxStep(kFF02, 0x00), infinityboxStep(kFF01, 0xA0),
+                             infinityboxStep(kFF02, 0x80), infinityboxStep(kFF01, 0x20),
+                             infinityboxStep(kFF02, 0x00)}),
+        infinityboxSequence("infinitybox_output1_off", "Infinitybox Output 1 OFF", "infinitybox_output1",
+                            {infinityboxStep(kFF02, 0x00), infinityboxStep(kFF01, 0x20),
+                             infinityboxStep(kFF02, 0x00)}),
+        infinityboxSequence("infinitybox_output9_on", "Infinitybox Output 9 ON", "infinitybox_output9",
+                            {infinityboxStep(kFF02, 0x00), infinityboxStep(kFF01, 0x20, 0x80),
+                             infinityboxStep(kFF02, 0x80), infinityboxStep(kFF01, 0x20, 0x80),
+                             infinityboxStep(kFF02, 0x00)}),
+        infinityboxSequence("infinitybox_output9_off", "Infinitybox Output 9 OFF", "infinitybox_output9",
+                            {infinityboxStep(kFF02, 0x00), infinityboxStep(kFF01, 0x20),
+                             infinityboxStep(kFF02, 0x00)}),
+    };
+
+    return cfg;
+}
+
+void encodeThemeJson(const ThemeConfig& theme, JsonObject obj) {
+    obj["bg_color"] = theme.bg_color.c_str();
+    obj["surface_color"] = theme.surface_color.c_str();
+    obj["page_bg_color"] = theme.page_bg_color.c_str();
+    obj["accent_color"] = theme.accent_color.c_str();
+    obj["text_primary"] = theme.text_primary.c_str();
+    obj["text_secondary"] = theme.text_secondary.c_str();
+    obj["border_color"] = theme.border_color.c_str();
+    obj["header_border_color"] = theme.header_border_color.c_str();
+    obj["nav_button_color"] = theme.nav_button_color.c_str();
+    obj["nav_button_active_color"] = theme.nav_button_active_color.c_str();
+    obj["nav_button_text_color"] = theme.nav_button_text_color.c_str();
+    obj["nav_button_radius"] = theme.nav_button_radius;
+    obj["button_radius"] = theme.button_radius;
+    obj["border_width"] = theme.border_width;
+    obj["header_border_width"] = theme.header_border_width;
+}
+
+void decodeThemeJson(JsonObjectConst obj, ThemeConfig& theme) {
+    theme.bg_color = sanitizeColor(safeString(obj["bg_color"], theme.bg_color));
+    theme.surface_color = sanitizeColor(safeString(obj["surface_color"], theme.surface_color));
+    theme.page_bg_color = sanitizeColor(safeString(obj["page_bg_color"], theme.page_bg_color));
+    theme.accent_color = sanitizeColor(safeString(obj["accent_color"], theme.accent_color));
+    theme.text_primary = sanitizeColor(safeString(obj["text_primary"], theme.text_primary));
+    theme.text_secondary = sanitizeColor(safeString(obj["text_secondary"], theme.text_secondary));
+    theme.border_color = sanitizeColor(safeString(obj["border_color"], theme.border_color));
+    theme.header_border_color = sanitizeColor(safeString(obj["header_border_color"], theme.header_border_color));
+    theme.nav_button_color = sanitizeColor(safeString(obj["nav_button_color"], theme.nav_button_color));
+    theme.nav_button_active_color = sanitizeColor(safeString(obj["nav_button_active_color"], theme.nav_button_active_color));
+    theme.nav_button_text_color = sanitizeColor(safeString(obj["nav_button_text_color"], theme.nav_button_text_color));
+    theme.nav_button_radius = clampValue<std::uint8_t>(obj["nav_button_radius"] | theme.nav_button_radius, 0u, 50u);
+    theme.button_radius = clampValue<std::uint8_t>(obj["button_radius"] | theme.button_radius, 0u, 50u);
+    theme.border_width = clampValue<std::uint8_t>(obj["border_width"] | theme.border_width, 0u, 10u);
+    theme.header_border_width = clampValue<std::uint8_t>(obj["header_border_width"] | theme.header_border_width, 0u, 10u);
+}
+
+void encodeButtonJson(const ButtonConfig& button, JsonObject btn_obj) {
+    btn_obj["id"] = button.id.c_str();
+    btn_obj["label"] = button.label.c_str();
+    btn_obj["color"] = button.color.c_str();
+    btn_obj["pressed_color"] = button.pressed_color.c_str();
+    btn_obj["text_color"] = button.text_color.c_str();
+    btn_obj["icon"] = button.icon.c_str();
+    btn_obj["row"] = button.row;
+    btn_obj["col"] = button.col;
+    btn_obj["row_span"] = button.row_span;
+    btn_obj["col_span"] = button.col_span;
+    btn_obj["momentary"] = button.momentary;
+    btn_obj["font_size"] = button.font_size;
+    btn_obj["font_family"] = button.font_family.c_str();
+    btn_obj["font_weight"] = button.font_weight.c_str();
+    btn_obj["font_name"] = button.font_name.c_str();
+    btn_obj["text_align"] = button.text_align.c_str();
+    btn_obj["corner_radius"] = button.corner_radius;
+    btn_obj["border_width"] = button.border_width;
+    btn_obj["border_color"] = button.border_color.c_str();
+
+    JsonObject can_obj = btn_obj["can"].to<JsonObject>();
+    can_obj["enabled"] = button.can.enabled;
+    can_obj["pgn"] = button.can.pgn;
+    can_obj["priority"] = button.can.priority;
+    can_obj["source_address"] = button.can.source_address;
+    can_obj["destination_address"] = button.can.destination_address;
+
+    JsonArray data_arr = can_obj["data"].to<JsonArray>();
+    for (std::uint8_t i = 0; i < button.can.length; ++i) {
+        data_arr.add(button.can.data[i]);
+    }
+
+    JsonObject can_off_obj = btn_obj["can_off"].to<JsonObject>();
+    can_off_obj["enabled"] = button.can_off.enabled;
+    can_off_obj["pgn"] = button.can_off.pgn;
+    can_off_obj["priority"] = button.can_off.priority;
+    can_off_obj["source_address"] = button.can_off.source_address;
+    can_off_obj["destination_address"] = button.can_off.destination_address;
+
+    JsonArray off_data_arr = can_off_obj["data"].to<JsonArray>();
+    for (std::uint8_t i = 0; i < button.can_off.length; ++i) {
+        off_data_arr.add(button.can_off.data[i]);
+    }
+
+    btn_obj["sequence"] = button.sequence.c_str();
+    btn_obj["sequence_off"] = button.sequence_off.c_str();
+    btn_obj["module"] = button.module.c_str();
+    btn_obj["module_output"] = button.module_output;
+}
+
+ButtonConfig decodeButtonJson(JsonObjectConst btn_obj, const PageConfig& page, std::size_t button_index) {
+    ButtonConfig button;
+    button.id = safeString(btn_obj["id"], fallbackId("btn", button_index));
+    button.label = safeString(btn_obj["label"], button.id);
+    button.color = sanitizeColor(safeString(btn_obj["color"], button.color));
+    button.pressed_color = sanitizeColor(safeString(btn_obj["pressed_color"], button.pressed_color));
+    button.text_color = sanitizeColorOptional(safeString(btn_obj["text_color"], ""));
+    button.icon = safeString(btn_obj["icon"], "");
+    button.row = clampValue<std::uint8_t>(btn_obj["row"] | 0, 0, page.rows - 1);
+    button.col = clampValue<std::uint8_t>(btn_obj["col"] | 0, 0, page.cols - 1);
+    button.row_span = clampValue<std::uint8_t>(btn_obj["row_span"] | 1, 1, page.rows - button.row);
+    button.col_span = clampValue<std::uint8_t>(btn_obj["col_span"] | 1, 1, page.cols - button.col);
+    button.momentary = btn_obj["momentary"] | false;
+    button.font_size = clampValue<std::uint8_t>(btn_obj["font_size"] | 24, 8, 72);
+    button.font_family = safeString(btn_obj["font_family"], "montserrat");
+    button.font_weight = safeString(btn_obj["font_weight"], "400");
+    button.font_name = safeString(btn_obj["font_name"], "montserrat_16");
+    button.text_align = safeString(btn_obj["text_align"], "center");
+    button.corner_radius = clampValue<std::uint8_t>(btn_obj["corner_radius"] | 12, 0, 50);
+    button.border_width = clampValue<std::uint8_t>(btn_obj["border_width"] | 0, 0, 10);
+    button.border_color = sanitizeColor(safeString(btn_obj["border_color"], "#FFFFFF"));
+
+    JsonObjectConst can_obj = btn_obj["can"];
+    if (!can_obj.isNull()) {
+        button.can.enabled = can_obj["enabled"] | false;
+        button.can.pgn = can_obj["pgn"] | button.can.pgn;
+        button.can.priority = clampValue<std::uint8_t>(can_obj["priority"] | button.can.priority, 0u, 7u);
+        button.can.source_address = can_obj["source_address"] | button.can.source_address;
+        button.can.destination_address = can_obj["destination_address"] | button.can.destination_address;
+
+        JsonArrayConst data_arr = can_obj["data"].as<JsonArrayConst>();
+        if (!data_arr.isNull()) {
+            std::size_t i = 0;
+            for (JsonVariantConst byte_val : data_arr) {
+                if (i >= button.can.data.size()) {
+                    break;
+                }
+                button.can.data[i] = clampValue<std::uint8_t>(byte_val | 0, 0u, 255u);
+                ++i;
+            }
+            button.can.length = static_cast<std::uint8_t>(i);  // Set length based on actual data bytes
+        }
+    }
+
+    JsonObjectConst can_off_obj = btn_obj["can_off"];
+    if (!can_off_obj.isNull()) {
+        button.can_off.enabled = can_off_obj["enabled"] | false;
+        button.can_off.pgn = can_off_obj["pgn"] | button.can_off.pgn;
+        button.can_off.priority = clampValue<std::uint8_t>(can_off_obj["priority"] | button.can_off.priority, 0u, 7u);
+        button.can_off.source_address = can_off_obj["source_address"] | button.can_off.source_address;
+        button.can_off.destination_address = can_off_obj["destination_address"] | button.can_off.destination_address;
+
+        JsonArrayConst off_data_arr = can_off_obj["data"].as<JsonArrayConst>();
+        if (!off_data_arr.isNull()) {
+            std::size_t i = 0;
+            for (JsonVariantConst byte_val : off_data_arr) {
+                if (i >= button.can_off.data.size()) {
+                    break;
+                }
+                button.can_off.data[i] = clampValue<std::uint8_t>(byte_val | 0, 0u, 255u);
+                ++i;
+            }
+            button.can_off.length = static_cast<std::uint8_t>(i);  // Set length based on actual data bytes
+        }
+    }
+
+    button.sequence = safeString(btn_obj["sequence"], "");
+    button.sequence_off = safeString(btn_obj["sequence_off"], "");
+    button.module = safeString(btn_obj["module"], "");
+    button.module_output = clampValue<std::uint8_t>(btn_obj["module_output"] | 0, 0u, 10u);
+    return button;
+}
+
+void encodePageJson(const PageConfig& page, JsonObject page_obj, bool with_buttons) {
+    page_obj["id"] = page.id.c_str();
+    page_obj["name"] = page.name.c_str();
+    page_obj["nav_text"] = page.nav_text.c_str();
+    page_obj["nav_color"] = page.nav_color.c_str();
+    page_obj["nav_inactive_color"] = page.nav_inactive_color.c_str();
+    page_obj["nav_text_color"] = page.nav_text_color.c_str();
+    if (page.nav_button_radius >= 0) {
+        page_obj["nav_button_radius"] = page.nav_button_radius;
+    }
+    page_obj["bg_color"] = page.bg_color.c_str();
+    page_obj["text_color"] = page.text_color.c_str();
+    page_obj["button_color"] = page.button_color.c_str();
+    page_obj["button_pressed_color"] = page.button_pressed_color.c_str();
+    page_obj["button_border_color"] = page.button_border_color.c_str();
+    page_obj["button_border_width"] = page.button_border_width;
+    page_obj["button_radius"] = page.button_radius;
+    page_obj["rows"] = page.rows;
+    page_obj["cols"] = page.cols;
+
+    if (!with_buttons) {
+        return;
+    }
+    JsonArray buttons = page_obj["buttons"].to<JsonArray>();
+    for (const auto& button : page.buttons) {
+        encodeButtonJson(button, buttons.createNestedObject());
+    }
+}
+
+PageConfig decodePageJson(JsonObjectConst page_obj, std::size_t page_index, bool with_buttons) {
+    PageConfig page;
+    page.id = safeString(page_obj["id"], fallbackId("page", page_index));
+    std::string raw_name = trimCopy(safeString(page_obj["name"], ""));
+    if (raw_name.empty()) {
+        raw_name = page.id;
+    }
+    page.name = raw_name;
+    page.nav_text = trimCopy(safeString(page_obj["nav_text"], ""));
+    page.nav_color = sanitizeColorOptional(safeString(page_obj["nav_color"], ""));
+    page.nav_inactive_color = sanitizeColorOptional(safeString(page_obj["nav_inactive_color"], ""));
+    page.nav_text_color = sanitizeColorOptional(safeString(page_obj["nav_text_color"], ""));
+    JsonVariantConst nav_radius_variant = page_obj["nav_button_radius"];
+    if (!nav_radius_variant.isNull()) {
+        int radius_value = nav_radius_variant | -1;
+        radius_value = std::max(-1, std::min(50, radius_value));
+        page.nav_button_radius = radius_value;
+    } else {
+        page.nav_button_radius = -1;
+    }
+    page.bg_color = sanitizeColorOptional(safeString(page_obj["bg_color"], ""));
+    page.text_color = sanitizeColorOptional(safeString(page_obj["text_color"], ""));
+    page.button_color = sanitizeColorOptional(safeString(page_obj["button_color"], ""));
+    page.button_pressed_color = sanitizeColorOptional(safeString(page_obj["button_pressed_color"], ""));
+    page.button_border_color = sanitizeColorOptional(safeString(page_obj["button_border_color"], ""));
+    page.button_border_width = clampValue<std::uint8_t>(page_obj["button_border_width"] | page.button_border_width, 0u, 10u);
+    page.button_radius = clampValue<std::uint8_t>(page_obj["button_radius"] | page.button_radius, 0u, 50u);
+    page.rows = clampValue<std::uint8_t>(page_obj["rows"] | 2, 1, 4);
+    page.cols = clampValue<std::uint8_t>(page_obj["cols"] | 2, 1, 4);
+
+    JsonArrayConst buttons = page_obj["buttons"].as<JsonArrayConst>();
+    if (!with_buttons || buttons.isNull()) {
+        return page;
+    }
+    std::size_t button_index = 0;
+    for (JsonObjectConst btn_obj : buttons) {
+        if (button_index >= MAX_BUTTONS_PER_PAGE) {
+            break;
+        }
+        page.buttons.push_back(decodeButtonJson(btn_obj, page, button_index));
+        ++button_index;
+    }
+    return page;
+}
+
+namespace {
+void encodeVersionSection(const DeviceConfig& source, JsonObject parent) {
+    parent["version"] = source.version.c_str();
+}
+
+void encodeHeaderSection(const DeviceConfig& source, JsonObject parent) {
+    JsonObject header = parent["header"].to<JsonObject>();
+    header["title"] = source.header.title.c_str();
+    header["subtitle"] = source.header.subtitle.c_str();
+    header["show_logo"] = source.header.show_logo;
+    header["logo_variant"] = source.header.logo_variant.c_str();
+    header["logo_base64"] = source.header.logo_base64.c_str();
+    header["title_font"] = source.header.title_font.c_str();
+    header["subtitle_font"] = source.header.subtitle_font.c_str();
+    header["title_align"] = source.header.title_align.c_str();
+    header["logo_position"] = source.header.logo_position.c_str();
+    header["logo_target_height"] = source.header.logo_target_height;
+    header["logo_preserve_aspect"] = source.header.logo_preserve_aspect;
+    header["nav_spacing"] = source.header.nav_spacing;
+}
+
+void encodeDisplaySection(const DeviceConfig& source, JsonObject parent) {
+    JsonObject display = parent["display"].to<JsonObject>();
+    display["brightness"] = source.display.brightness;
+    display["sleep_enabled"] = source.display.sleep_enabled;
+    display["sleep_timeout_seconds"] = source.display.sleep_timeout_seconds;
+    display["sleep_icon_base64"] = source.display.sleep_icon_base64.c_str();
+}
+
+void encodeImagesSection(const DeviceConfig& source, JsonObject parent) {
+    JsonObject images = parent["images"].to<JsonObject>();
+    images["header_logo"] = source.images.header_logo.c_str();
+    images["splash_logo"] = source.images.splash_logo.c_str();
+    images["background_image"] = source.images.background_image.c_str();
+    images["sleep_logo"] = source.images.sleep_logo.c_str();
+}
+
+void encodeThemeSection(const DeviceConfig& source, JsonObject parent) {
+    encodeThemeJson(source.theme, parent["theme"].to<JsonObject>());
+}
+
+void encodeWifiSection(const DeviceConfig& source, JsonObject parent) {
+    JsonObject wifi = parent["wifi"].to<JsonObject>();
+    JsonObject ap = wifi["ap"].to<JsonObject>();
+    ap["enabled"] = source.wifi.ap.enabled;
+    ap["ssid"] = source.wifi.ap.ssid.c_str();
+    ap["password"] = source.wifi.ap.password.c_str();
+
+    JsonObject sta = wifi["sta"].to<JsonObject>();
+    sta["enabled"] = source.wifi.sta.enabled;
+    sta["ssid"] = source.wifi.sta.ssid.c_str();
+    sta["password"] = source.wifi.sta.password.c_str();
+}
+
+void encodeOtaSection(const DeviceConfig& source, JsonObject parent) {
+    JsonObject ota = parent["ota"].to<JsonObject>();
+    ota["enabled"] = source.ota.enabled;
+    // ota["auto_apply"] = source.ota.auto_apply;  // Removed - manual-only
+    ota["manifest_url"] = source.ota.manifest_url.c_str();
+    ota["channel"] = source.ota.channel.c_str();
+    // ota["check_interval_minutes"] = source.ota.check_interval_minutes;  // Removed - manual-only
+}
+
+void encodePageElement(const DeviceConfig& source, std::size_t index, JsonObject page_obj) {
+    encodePageJson(source.pages[index], page_obj);
+}
+
+void encodeCanMessageElement(const DeviceConfig& source, std::size_t index, JsonObject msg_obj) {
+    const auto& msg = source.can_library[index];
+    msg_obj["id"] = msg.id.c_str();
+    msg_obj["name"] = msg.name.c_str();
+    msg_obj["pgn"] = msg.pgn;
+    msg_obj["priority"] = msg.priority;
+    msg_obj["source_address"] = msg.source_address;
+    msg_obj["destination_address"] = msg.destination_address;
+    msg_obj["description"] = msg.description.c_str();
+
+    JsonArray data_arr = msg_obj["data"].to<JsonArray>();
+    for (std::uint8_t byte : msg.data) {
+        data_arr.add(byte);
+    }
+}
+
+void encodeCanSequenceElement(const DeviceConfig& source, std::size_t index, JsonObject seq_obj) {
+    const auto& seq = source.can_sequences[index];
+    seq_obj["id"] = seq.id.c_str();
+    seq_obj["name"] = seq.name.c_str();
+    seq_obj["overlap"] = seq.overlap.c_str();
+    seq_obj["group"] = seq.group.c_str();
+    seq_obj["start_delay_ms"] = seq.start_delay_ms;
+
+    JsonArray steps = seq_obj["steps"].to<JsonArray>();
+    for (const auto& step : seq.steps) {
+        JsonObject step_obj = steps.createNestedObject();
+        step_obj["pgn"] = step.pgn;
+        step_obj["priority"] = step.priority;
+        step_obj["source_address"] = step.source_address;
+        step_obj["destination_address"] = step.destination_address;
+        step_obj["delay_ms"] = step.delay_ms;
+        step_obj["condition"] = step.condition.c_str();
+
+        JsonArray data_arr = step_obj["data"].to<JsonArray>();
+        for (std::uint8_t i = 0; i < step.length; ++i) {
+            data_arr.add(step.data[i]);
+        }
+    }
+}
+
+void encodeCanPeriodicElement(const DeviceConfig& source, std::size_t index, JsonObject entry_obj) {
+    const auto& entry = source.can_periodic[index];
+    entry_obj["id"] = entry.id.c_str();
+    entry_obj["name"] = entry.name.c_str();
+    entry_obj["enabled"] = entry.enabled;
+    entry_obj["pgn"] = entry.pgn;
+    entry_obj["priority"] = entry.priority;
+    entry_obj["source_address"] = entry.source_address;
+    entry_obj["destination_address"] = entry.destination_address;
+    entry_obj["period_ms"] = entry.period_ms;
+    entry_obj["phase_ms"] = entry.phase_ms;
+
+    JsonArray data_arr = entry_obj["data"].to<JsonArray>();
+    for (std::uint8_t i = 0; i < entry.length; ++i) {
+        data_arr.add(entry.data[i]);
+    }
+}
+
+void encodeCanModuleElement(const DeviceConfig& source, std::size_t index, JsonObject module_obj) {
+    const auto& module = source.can_modules[index];
+    module_obj["id"] = module.id.c_str();
+    module_obj["name"] = module.name.c_str();
+    module_obj["type"] = module.type.c_str();
+    module_obj["address"] = module.address;
+    module_obj["poll_interval_ms"] = module.poll_interval_ms;
+}
+
+void encodeCanSignalElement(const DeviceConfig& source, std::size_t index, JsonObject signal_obj) {
+    const auto& signal = source.can_signals[index];
+    signal_obj["name"] = signal.name.c_str();
+    signal_obj["unit"] = signal.unit.c_str();
+    signal_obj["pgn"] = signal.pgn;
+    signal_obj["source_address"] = signal.source_address;
+    signal_obj["start_bit"] = signal.start_bit;
+    signal_obj["length"] = signal.length;
+    signal_obj["byte_order"] = signal.little_endian ? "little_endian" : "big_endian";
+    signal_obj["signed"] = signal.is_signed;
+    signal_obj["scale"] = signal.scale;
+    signal_obj["offset"] = signal.offset;
+}
+
+void encodeCanBusSection(const DeviceConfig& source, JsonObject parent) {
+    JsonObject can_bus = parent["can_bus"].to<JsonObject>();
+    can_bus["bitrate"] = source.can_bus.bitrate;
+    can_bus["auto_baud"] = source.can_bus.auto_baud;
+}
+
+void encodeCanCoalesceSection(const DeviceConfig& source, JsonObject parent) {
+    JsonObject can_coalesce = parent["can_coalesce"].to<JsonObject>();
+    can_coalesce["enabled"] = source.can_coalesce.enabled;
+    can_coalesce["duplicate_window_ms"] = source.can_coalesce.duplicate_window_ms;
+    can_coalesce["min_spacing_ms"] = source.can_coalesce.min_spacing_ms;
+}
+
+void encodeCanFilterSection(const DeviceConfig& source, JsonObject parent) {
+    JsonObject can_filter = parent["can_filter"].to<JsonObject>();
+    can_filter["enabled"] = source.can_filter.enabled;
+    JsonArray extra_pgns = can_filter["extra_pgns"].to<JsonArray>();
+    for (std::uint32_t pgn : source.can_filter.extra_pgns) {
+        extra_pgns.add(pgn);
+    }
+}
+
+void encodeCanRecorderSection(const DeviceConfig& source, JsonObject parent) {
+    JsonObject can_recorder = parent["can_recorder"].to<JsonObject>();
+    can_recorder["enabled"] = source.can_recorder.enabled;
+    can_recorder["max_segment_kb"] = source.can_recorder.max_segment_kb;
+    can_recorder["max_total_kb"] = source.can_recorder.max_total_kb;
+    can_recorder["flush_interval_ms"] = source.can_recorder.flush_interval_ms;
+}
+
+void encodeJ1939Section(const DeviceConfig& source, JsonObject parent) {
+    JsonObject j1939 = parent["j1939"].to<JsonObject>();
+    j1939["address_claim"] = source.j1939.address_claim;
+    j1939["preferred_address"] = source.j1939.preferred_address;
+    j1939["address_min"] = source.j1939.address_min;
+    j1939["address_max"] = source.j1939.address_max;
+    j1939["arbitrary_address_capable"] = source.j1939.arbitrary_address_capable;
+    j1939["industry_group"] = source.j1939.industry_group;
+    j1939["vehicle_system"] = source.j1939.vehicle_system;
+    j1939["vehicle_system_instance"] = source.j1939.vehicle_system_instance;
+    j1939["function"] = source.j1939.function;
+    j1939["function_instance"] = source.j1939.function_instance;
+    j1939["ecu_instance"] = source.j1939.ecu_instance;
+    j1939["manufacturer_code"] = source.j1939.manufacturer_code;
+    j1939["identity_number"] = source.j1939.identity_number;
+}
+
+void encodeFontElement(const DeviceConfig& source, std::size_t index, JsonObject font_obj) {
+    const auto& font = source.available_fonts[index];
+    font_obj["name"] = font.name.c_str();
+    font_obj["display_name"] = font.display_name.c_str();
+    font_obj["size"] = font.size;
+}
+}
+
+const ConfigJsonSection kConfigJsonSections[] = {
+    {"version", encodeVersionSection, nullptr, nullptr},
+    {"header", encodeHeaderSection, nullptr, nullptr},
+    {"display", encodeDisplaySection, nullptr, nullptr},
+    {"images", encodeImagesSection, nullptr, nullptr},
+    {"theme", encodeThemeSection, nullptr, nullptr},
+    {"wifi", encodeWifiSection, nullptr, nullptr},
+    {"ota", encodeOtaSection, nullptr, nullptr},
+    {"pages", nullptr, [](const DeviceConfig& source) { return source.pages.size(); }, encodePageElement},
+    {"can_library", nullptr, [](const DeviceConfig& source) { return source.can_library.size(); },
+     encodeCanMessageElement},
+    {"can_sequences", nullptr, [](const DeviceConfig& source) { return source.can_sequences.size(); },
+     encodeCanSequenceElement},
+    {"can_periodic", nullptr, [](const DeviceConfig& source) { return source.can_periodic.size(); },
+     encodeCanPeriodicElement},
+    {"can_modules", nullptr, [](const DeviceConfig& source) { return source.can_modules.size(); },
+     encodeCanModuleElement},
+    {"can_signals", nullptr, [](const DeviceConfig& source) { return source.can_signals.size(); },
+     encodeCanSignalElement},
+    {"can_bus", encodeCanBusSection, nullptr, nullptr},
+    {"can_coalesce", encodeCanCoalesceSection, nullptr, nullptr},
+    {"can_filter", encodeCanFilterSection, nullptr, nullptr},
+    {"can_recorder", encodeCanRecorderSection, nullptr, nullptr},
+    {"j1939", encodeJ1939Section, nullptr, nullptr},
+    {"available_fonts", nullptr, [](const DeviceConfig& source) { return source.available_fonts.size(); },
+     encodeFontElement},
+};
+const std::size_t kConfigJsonSectionCount = sizeof(kConfigJsonSections) / sizeof(kConfigJsonSections[0]);
+static_assert(sizeof(kConfigJsonSections) / sizeof(kConfigJsonSections[0]) <= 32,
+              "configJsonSectionBit() gives each section one bit of a uint32_t");
+
+std::uint32_t configJsonSectionBit(const char* key) {
+    for (std::size_t i = 0; i < kConfigJsonSectionCount; ++i) {
+        if (std::strcmp(kConfigJsonSections[i].key, key) == 0) {
+            return 1u << i;
+        }
+    }
+    return 0;
+}
+
+void encodeConfigJson(const DeviceConfig& source, JsonDocument& doc) {
+    doc.clear();
+    JsonObject root = doc.to<JsonObject>();
+    for (std::size_t s = 0; s < kConfigJsonSectionCount; ++s) {
+        const ConfigJsonSection& section = kConfigJsonSections[s];
+        if (section.encode) {
+            section.encode(source, root);
+            continue;
+        }
+        JsonArray elements = root[section.key].to<JsonArray>();
+        const std::size_t count = section.count(source);
+        for (std::size_t i = 0; i < count; ++i) {
+            section.encodeElement(source, i, elements.createNestedObject());
+        }
+    }
+}
+
+bool decodeConfigJson(JsonVariantConst json, DeviceConfig& target, std::string& error) {
+    if (json.isNull()) {
+        error = "JSON payload is empty";
+        return false;
+    }
+
+    target.version = safeString(json["version"], "1.0.0");
+
+    JsonObjectConst header = json["header"];
+    if (!header.isNull()) {
+        target.header.title = safeString(header["title"], target.header.title);
+        target.header.subtitle = safeString(header["subtitle"], target.header.subtitle);
+        target.header.show_logo = header["show_logo"] | target.header.show_logo;
+        target.header.logo_variant = safeString(header["logo_variant"], target.header.logo_variant);
+        target.header.logo_base64 = safeString(header["logo_base64"], target.header.logo_base64);
+        target.header.title_font = safeString(header["title_font"], target.header.title_font);
+        target.header.subtitle_font = safeString(header["subtitle_font"], target.header.subtitle_font);
+        target.header.title_align = safeString(header["title_align"], target.header.title_align);
+        target.header.logo_position = safeString(header["logo_position"], target.header.logo_position);
+        target.header.logo_target_height = clampValue<std::uint16_t>(header["logo_target_height"] | target.header.logo_target_height, 16u, 128u);
+        target.header.logo_preserve_aspect = header["logo_preserve_aspect"] | target.header.logo_preserve_aspect;
+        target.header.nav_spacing = clampValue<std::uint8_t>(header["nav_spacing"] | target.header.nav_spacing, 0u, 60u);
+    }
+
+    JsonObjectConst display = json["display"];
+    if (!display.isNull()) {
+        target.display.brightness = clampValue<std::uint8_t>(display["brightness"] | target.display.brightness, 0u, 100u);
+        target.display.sleep_enabled = display["sleep_enabled"] | target.display.sleep_enabled;
+        target.display.sleep_timeout_seconds = clampValue<std::uint16_t>(display["sleep_timeout_seconds"] | target.display.sleep_timeout_seconds, 5u, 3600u);
+        target.display.sleep_icon_base64 = safeString(display["sleep_icon_base64"], target.display.sleep_icon_base64);
+    }
+
+    JsonObjectConst images = json["images"];
+    if (!images.isNull()) {
+        target.images.header_logo = safeString(images["header_logo"], target.images.header_logo);
+        target.images.splash_logo = safeString(images["splash_logo"], target.images.splash_logo);
+        target.images.background_image = safeString(images["background_image"], target.images.background_image);
+        target.images.sleep_logo = safeString(images["sleep_logo"], target.images.sleep_logo);
+    }
+
+    JsonObjectConst theme = json["theme"];
+    if (!theme.isNull()) {
+        decodeThemeJson(theme, target.theme);
+    }
+
+    JsonObjectConst wifi = json["wifi"];
+    if (!wifi.isNull()) {
+        JsonObjectConst ap = wifi["ap"];
+        if (!ap.isNull()) {
+            target.wifi.ap.enabled = ap["enabled"] | true;
+            target.wifi.ap.ssid = safeString(ap["ssid"], target.wifi.ap.ssid);
+            target.wifi.ap.password = safeString(ap["password"], target.wifi.ap.password);
+        }
+
+        JsonObjectConst sta = wifi["sta"];
+        if (!sta.isNull()) {
+            target.wifi.sta.enabled = sta["enabled"] | false;
+            target.wifi.sta.ssid = safeString(sta["ssid"], target.wifi.sta.ssid);
+            target.wifi.sta.password = safeString(sta["password"], target.wifi.sta.password);
+        }
+    }
+
+    target.ota.manifest_url = kOtaManifestUrl;  // OTA endpoint is centrally managed
+    JsonObjectConst ota = json["ota"];
+    if (!ota.isNull()) {
+        target.ota.enabled = ota["enabled"] | target.ota.enabled;
+        // target.ota.auto_apply = ota["auto_apply"] | target.ota.auto_apply;  // Removed - manual-only
+        target.ota.channel = safeString(ota["channel"], target.ota.channel);
+        // const std::uint32_t interval = ota["check_interval_minutes"] | target.ota.check_interval_minutes;  // Removed - manual-only
+        // target.ota.check_interval_minutes = clampValue<std::uint32_t>(interval, 5u, 1440u);  // Removed - manual-only
+    }
+
+    target.pages.clear();
+    JsonArrayConst pages = json["pages"].as<JsonArrayConst>();
+    if (!pages.isNull()) {
+        std::size_t page_index = 0;
+        for (JsonObjectConst page_obj : pages) {
+            if (page_index >= MAX_PAGES) {
+                break;
+            }
+            target.pages.push_back(decodePageJson(page_obj, page_index));
+            ++page_index;
+        }
+    }
+
+    if (target.pages.empty()) {
+        target.pages = buildDefaultConfig().pages;
+    }
+
+    // Decode CAN library
+    target.can_library.clear();
+    JsonArrayConst can_library = json["can_library"].as<JsonArrayConst>();
+    if (!can_library.isNull()) {
+        std::size_t msg_index = 0;
+        for (JsonObjectConst msg_obj : can_library) {
+            if (msg_index >= 50) {  // Reasonable limit for CAN library
+                break;
+            }
+
+            CanMessage msg;
+            msg.id = safeString(msg_obj["id"], fallbackId("can_msg", msg_index));
+            msg.name = safeString(msg_obj["name"], msg.id);
+            msg.pgn = msg_obj["pgn"] | 0;
+            msg.priority = clampValue<std::uint8_t>(msg_obj["priority"] | 6, 0u, 7u);
+            msg.source_address = msg_obj["source_address"] | 0xF9;
+            msg.destination_address = msg_obj["destination_address"] | 0xFF;
+            msg.description = safeString(msg_obj["description"], "");
+
+            JsonArrayConst data_arr = msg_obj["data"].as<JsonArrayConst>();
+            if (!data_arr.isNull()) {
+                std::size_t i = 0;
+                for (JsonVariantConst byte_val : data_arr) {
+                    if (i >= msg.data.size()) {
+                        break;
+                    }
+                    msg.data[i] = clampValue<std::uint8_t>(byte_val | 0, 0u, 255u);
+                    ++i;
+                }
+            }
+
+            target.can_library.push_back(std::move(msg));
+            ++msg_index;
+        }
+    }
+
+    // Decode CAN sequences (omitted key keeps the current sequences)
+    JsonArrayConst can_sequences = json["can_sequences"].as<JsonArrayConst>();
+    if (!can_sequences.isNull()) {
+        target.can_sequences.clear();
+        std::size_t seq_index = 0;
+        for (JsonObjectConst seq_obj : can_sequences) {
+            if (seq_index >= MAX_CAN_SEQUENCES) {
+                break;
+            }
+
+            CanSequenceConfig seq;
+            seq.id = safeString(seq_obj["id"], fallbackId("seq", seq_index));
+            seq.name = safeString(seq_obj["name"], seq.id);
+            seq.overlap = safeString(seq_obj["overlap"], "restart");
+            seq.group = safeString(seq_obj["group"], "");
+            seq.start_delay_ms = clampValue<std::uint16_t>(seq_obj["start_delay_ms"] | 0, 0u, 10000u);
+
+            JsonArrayConst steps = seq_obj["steps"].as<JsonArrayConst>();
+            if (!steps.isNull()) {
+                for (JsonObjectConst step_obj : steps) {
+                    if (seq.steps.size() >= MAX_CAN_SEQUENCE_STEPS) {
+                        break;
+                    }
+
+                    CanSequenceStep step;
+                    step.pgn = step_obj["pgn"] | step.pgn;
+                    step.priority = clampValue<std::uint8_t>(step_obj["priority"] | step.priority, 0u, 7u);
+                    step.source_address = step_obj["source_address"] | step.source_address;
+                    step.destination_address = step_obj["destination_address"] | step.destination_address;
+                    step.delay_ms = clampValue<std::uint16_t>(step_obj["delay_ms"] | step.delay_ms, 0u, 10000u);
+                    step.condition = safeString(step_obj["condition"], step.condition);
+
+                    JsonArrayConst data_arr = step_obj["data"].as<JsonArrayConst>();
+                    if (!data_arr.isNull()) {
+                        std::size_t i = 0;
+                        for (JsonVariantConst byte_val : data_arr) {
+                            if (i >= step.data.size()) {
+                                break;
+                            }
+                            step.data[i] = clampValue<std::uint8_t>(byte_val | 0, 0u, 255u);
+                            ++i;
+                        }
+                        step.length = static_cast<std::uint8_t>(i);
+                    }
+                    seq.steps.push_back(std::move(step));
+                }
+            }
+
+            target.can_sequences.push_back(std::move(seq));
+            ++seq_index;
+        }
+    }
+
+    // Decode periodic CAN frames (omitted key keeps the current list)
+    JsonArrayConst can_periodic = json["can_periodic"].as<JsonArrayConst>();
+    if (!can_periodic.isNull()) {
+        target.can_periodic.clear();
+        std::size_t entry_index = 0;
+        for (JsonObjectConst entry_obj : can_periodic) {
+            if (entry_index >= MAX_CAN_PERIODIC) {
+                break;
+            }
+
+            CanPeriodicConfig entry;
+            entry.id = safeString(entry_obj["id"], fallbackId("periodic", entry_index));
+            entry.name = safeString(entry_obj["name"], entry.id);
+            entry.enabled = entry_obj["enabled"] | true;
+            entry.pgn = entry_obj["pgn"] | entry.pgn;
+            entry.priority = clampValue<std::uint8_t>(entry_obj["priority"] | entry.priority, 0u, 7u);
+            entry.source_address = entry_obj["source_address"] | entry.source_address;
+            entry.destination_address = entry_obj["destination_address"] | entry.destination_address;
+            entry.period_ms = clampValue<std::uint32_t>(entry_obj["period_ms"] | entry.period_ms, 10u, 600000u);
+            entry.phase_ms = entry_obj["phase_ms"] | entry.phase_ms;
+
+            JsonArrayConst data_arr = entry_obj["data"].as<JsonArrayConst>();
+            if (!data_arr.isNull()) {
+                std::size_t i = 0;
+                for (JsonVariantConst byte_val : data_arr) {
+                    if (i >= entry.data.size()) {
+                        break;
+                    }
+                    entry.data[i] = clampValue<std::uint8_t>(byte_val | 0, 0u, 255u);
+                    ++i;
+                }
+                entry.length = static_cast<std::uint8_t>(i);
+            }
+
+            target.can_periodic.push_back(std::move(entry));
+            ++entry_index;
+        }
+    }
+
+    // Decode status-tracked modules (omitted key keeps the current list)
+    JsonArrayConst can_modules = json["can_modules"].as<JsonArrayConst>();
+    if (!can_modules.isNull()) {
+        target.can_modules.clear();
+        std::size_t module_index = 0;
+        for (JsonObjectConst module_obj : can_modules) {
+            if (module_index >= MAX_CAN_MODULES) {
+                break;
+            }
+
+            CanModuleConfig module;
+            module.id = safeString(module_obj["id"], fallbackId("module", module_index));
+            module.name = safeString(module_obj["name"], module.id);
+            module.type = safeString(module_obj["type"], module.type) == "inmotion" ? "inmotion" : "powercell";
+            module.address = clampValue<std::uint8_t>(module_obj["address"] | module.address, 1u, 16u);
+            module.poll_interval_ms = module_obj["poll_interval_ms"] | module.poll_interval_ms;
+            if (module.poll_interval_ms) {
+                module.poll_interval_ms = clampValue<std::uint32_t>(module.poll_interval_ms, 100u, 60000u);
+            }
+
+            target.can_modules.push_back(std::move(module));
+            ++module_index;
+        }
+    }
+
+    JsonArrayConst can_signals = json["can_signals"].as<JsonArrayConst>();
+    if (!can_signals.isNull()) {
+        target.can_signals.clear();
+        std::size_t signal_index = 0;
+        for (JsonObjectConst signal_obj : can_signals) {
+            if (signal_index >= MAX_CAN_SIGNALS) {
+                break;
+            }
+
+            CanSignalConfig signal;
+            signal.name = safeString(signal_obj["name"], fallbackId("signal", signal_index));
+            signal.unit = safeString(signal_obj["unit"], signal.unit);
+            signal.pgn = (signal_obj["pgn"] | signal.pgn) & 0x3FFFFu;
+            signal.source_address = signal_obj["source_address"] | signal.source_address;
+            signal.start_bit = clampValue<std::uint8_t>(signal_obj["start_bit"] | signal.start_bit, 0u, 63u);
+            signal.length = clampValue<std::uint8_t>(signal_obj["length"] | signal.length, 1u, 64u);
+            signal.little_endian = safeString(signal_obj["byte_order"], "little_endian") != "big_endian";
+            signal.is_signed = signal_obj["signed"] | signal.is_signed;
+            signal.scale = signal_obj["scale"] | signal.scale;
+            signal.offset = signal_obj["offset"] | signal.offset;
+
+            target.can_signals.push_back(std::move(signal));
+            ++signal_index;
+        }
+    }
+
+    JsonObjectConst can_bus = json["can_bus"];
+    if (!can_bus.isNull()) {
+        const std::uint32_t bitrate = can_bus["bitrate"] | target.can_bus.bitrate;
+        if (canBitrateSupported(bitrate)) {
+            target.can_bus.bitrate = bitrate;
+        }
+        target.can_bus.auto_baud = can_bus["auto_baud"] | target.can_bus.auto_baud;
+    }
+
+    JsonObjectConst can_coalesce = json["can_coalesce"];
+    if (!can_coalesce.isNull()) {
+        CanCoalesceConfig& cfg = target.can_coalesce;
+        cfg.enabled = can_coalesce["enabled"] | cfg.enabled;
+        cfg.duplicate_window_ms = clampValue<std::uint16_t>(can_coalesce["duplicate_window_ms"] | cfg.duplicate_window_ms, 0u, 5000u);
+        cfg.min_spacing_ms = clampValue<std::uint16_t>(can_coalesce["min_spacing_ms"] | cfg.min_spacing_ms, 0u, 1000u);
+    }
+
+    JsonObjectConst can_filter = json["can_filter"];
+    if (!can_filter.isNull()) {
+        target.can_filter.enabled = can_filter["enabled"] | target.can_filter.enabled;
+        JsonArrayConst extra_pgns = can_filter["extra_pgns"].as<JsonArrayConst>();
+        if (!extra_pgns.isNull()) {
+            target.can_filter.extra_pgns.clear();
+            for (JsonVariantConst pgn : extra_pgns) {
+                target.can_filter.extra_pgns.push_back((pgn | 0u) & 0x3FFFFu);
+            }
+        }
+    }
+
+    JsonObjectConst can_recorder = json["can_recorder"];
+    if (!can_recorder.isNull()) {
+        CanRecorderConfig& cfg = target.can_recorder;
+        cfg.enabled = can_recorder["enabled"] | cfg.enabled;
+        cfg.max_segment_kb = clampValue<std::uint32_t>(can_recorder["max_segment_kb"] | cfg.max_segment_kb, 16u, 4096u);
+        cfg.max_total_kb = clampValue<std::uint32_t>(can_recorder["max_total_kb"] | cfg.max_total_kb, cfg.max_segment_kb, 8192u);
+        cfg.flush_interval_ms = clampValue<std::uint32_t>(can_recorder["flush_interval_ms"] | cfg.flush_interval_ms, 100u, 60000u);
+    }
+
+    JsonObjectConst j1939 = json["j1939"];
+    if (!j1939.isNull()) {
+        J1939Config& cfg = target.j1939;
+        cfg.address_claim = j1939["address_claim"] | cfg.address_claim;
+        cfg.preferred_address = clampValue<std::uint8_t>(j1939["preferred_address"] | cfg.preferred_address, 0u, 253u);
+        cfg.address_min = clampValue<std::uint8_t>(j1939["address_min"] | cfg.address_min, 0u, 253u);
+        cfg.address_max = clampValue<std::uint8_t>(j1939["address_max"] | cfg.address_max, cfg.address_min, 253u);
+        cfg.arbitrary_address_capable = j1939["arbitrary_address_capable"] | cfg.arbitrary_address_capable;
+        cfg.industry_group = clampValue<std::uint8_t>(j1939["industry_group"] | cfg.industry_group, 0u, 7u);
+        cfg.vehicle_system = clampValue<std::uint8_t>(j1939["vehicle_system"] | cfg.vehicle_system, 0u, 127u);
+        cfg.vehicle_system_instance = clampValue<std::uint8_t>(j1939["vehicle_system_instance"] | cfg.vehicle_system_instance, 0u, 15u);
+        cfg.function = j1939["function"] | cfg.function;
+        cfg.function_instance = clampValue<std::uint8_t>(j1939["function_instance"] | cfg.function_instance, 0u, 31u);
+        cfg.ecu_instance = clampValue<std::uint8_t>(j1939["ecu_instance"] | cfg.ecu_instance, 0u, 7u);
+        cfg.manufacturer_code = clampValue<std::uint16_t>(j1939["manufacturer_code"] | cfg.manufacturer_code, 0u, 2047u);
+        cfg.identity_number = clampValue<std::uint32_t>(j1939["identity_number"] | cfg.identity_number, 0u, 0x1FFFFFu);
+    }
+
+    // Decode available fonts
+    target.available_fonts.clear();
+    JsonArrayConst fonts = json["available_fonts"].as<JsonArrayConst>();
+    if (!fonts.isNull()) {
+        for (JsonObjectConst font_obj : fonts) {
+            FontConfig font;
+            font.name = safeString(font_obj["name"], "montserrat_16");
+            font.display_name = safeString(font_obj["display_name"], "Montserrat 16");
+            font.size = clampValue<std::uint8_t>(font_obj["size"] | 16, 8, 72);
+            target.available_fonts.push_back(std::move(font));
+        }
+    }
+    
+    // If no fonts defined, use default list
+    if (target.available_fonts.empty()) {
+        target.available_fonts = buildDefaultConfig().available_fonts;
+    }
+
+    return true;
+}
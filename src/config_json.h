@@ -0,0 +1,52 @@
+#pragma once
+
+#include <ArduinoJson.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "config_types.h"
+#include "psram_alloc.h"
+
+// JSON form of DeviceConfig: the web UI's import/export format. The copy on
+// flash is the binary image (config_store.h); JSON only appears on the wire
+// and when migrating a /config.json written by older firmware.
+
+// Documents holding config JSON keep their pool in PSRAM, whatever their size
+using PsramJsonDocument = BasicJsonDocument<PsramJsonAllocator>;
+
+DeviceConfig buildDefaultConfig();
+void encodeConfigJson(const DeviceConfig& source, JsonDocument& doc);
+// Applies `json` over `target`, clamping values as it goes; most omitted sections keep what target has
+bool decodeConfigJson(JsonVariantConst json, DeviceConfig& target, std::string& error);
+
+// Per-section codecs that decodeConfigJson is built from; JSON Patch (config_patch.h) uses them to
+// re-validate only the section an operation touched
+void encodeThemeJson(const ThemeConfig& theme, JsonObject obj);
+// Omitted fields keep what `theme` has
+void decodeThemeJson(JsonObjectConst obj, ThemeConfig& theme);
+void encodePageJson(const PageConfig& page, JsonObject obj, bool with_buttons = true);
+// Omitted fields take their defaults; `index` names a page that has no id
+PageConfig decodePageJson(JsonObjectConst obj, std::size_t index, bool with_buttons = true);
+void encodeButtonJson(const ButtonConfig& button, JsonObject obj);
+// Position and spans are clamped to `page`'s grid
+ButtonConfig decodeButtonJson(JsonObjectConst obj, const PageConfig& page, std::size_t index);
+
+// The top-level members of the JSON form, in output order. encodeConfigJson writes them all into one
+// document; ConfigJsonStream (config_json_stream.h) encodes one member, array element or button at a time.
+struct ConfigJsonSection {
+    const char* key;
+    // Writes parent[key]; null for arrays
+    void (*encode)(const DeviceConfig& source, JsonObject parent);
+    // Arrays: element count and one element's encoder
+    std::size_t (*count)(const DeviceConfig& source);
+    void (*encodeElement)(const DeviceConfig& source, std::size_t index, JsonObject obj);
+};
+
+extern const ConfigJsonSection kConfigJsonSections[];
+extern const std::size_t kConfigJsonSectionCount;
+
+// Bit i stands for kConfigJsonSections[i]; ConfigManager::markEdited() records which sections an edit touched
+constexpr std::uint32_t kAllConfigJsonSections = 0xFFFFFFFFu;
+// 0 when no section has that key
+std::uint32_t configJsonSectionBit(const char* key);
@@ -0,0 +1,131 @@
+#include "config_json_stream.h"
+
+#include <ArduinoJson.h>
+#include <algorithm>
+#include <cstring>
+
+#include "config_json.h"
+
+std::size_t ConfigJsonStream::fill(std::uint8_t* buffer, std::size_t max_len) {
+    std::size_t out = 0;
+    while (out < max_len) {
+        if (text_pos_ < text_.size()) {
+            const std::size_t chunk = std::min(max_len - out, text_.size() - text_pos_);
+            std::memcpy(buffer + out, text_.data() + text_pos_, chunk);
+            text_pos_ += chunk;
+            out += chunk;
+            continue;
+        }
+        if (stage_ == Stage::DONE) {
+            break;
+        }
+        text_.clear();
+        text_pos_ = 0;
+        next();
+    }
+    return out;
+}
+
+// Serializes what `encode` writes into a fresh object as the next piece. `unwrap` drops the object's
+// braces, leaving its members to splice into an enclosing object. False, and the stream failed, when the
+// piece does not fit kMaxPieceDocBytes or the document could not be allocated.
+template <typename Encode>
+bool ConfigJsonStream::encodePiece(bool comma, bool unwrap, Encode encode) {
+    for (;;) {
+        PsramJsonDocument doc(doc_bytes_);
+        encode(doc.to<JsonObject>());
+        if (!doc.overflowed()) {
+            serializeJson(doc, text_);
+            break;
+        }
+        if (doc_bytes_ >= kMaxPieceDocBytes || doc.capacity() == 0) {
+            failed_ = true;
+            stage_ = Stage::DONE;
+            text_.clear();
+            return false;
+        }
+        doc_bytes_ *= 2;
+    }
+    if (unwrap) {
+        text_.erase(0, 1);
+        text_.pop_back();
+    }
+    if (comma) {
+        text_.insert(0, 1, ',');
+    }
+    return true;
+}
+
+void ConfigJsonStream::next() {
+    switch (stage_) {
+        case Stage::OPEN:
+            text_ = "{";
+            stage_ = Stage::SECTION;
+            break;
+
+        case Stage::SECTION: {
+            if (section_ == kConfigJsonSectionCount) {
+                text_ = "}";
+                stage_ = Stage::DONE;
+                break;
+            }
+            const ConfigJsonSection& section = kConfigJsonSections[section_];
+            if (section.encode) {
+                if (encodePiece(section_ > 0, true, [&](JsonObject obj) { section.encode(config_, obj); })) {
+                    ++section_;
+                }
+                break;
+            }
+            text_ = section_ > 0 ? ",\"" : "\"";
+            text_ += section.key;
+            text_ += "\":[";
+            element_ = 0;
+            stage_ = Stage::ELEMENTS;
+            break;
+        }
+
+        case Stage::ELEMENTS: {
+            const ConfigJsonSection& section = kConfigJsonSections[section_];
+            if (element_ >= section.count(config_)) {
+                text_ = "]";
+                ++section_;
+                stage_ = Stage::SECTION;
+                break;
+            }
+            if (std::strcmp(section.key, "pages") != 0) {
+                if (encodePiece(element_ > 0, false,
+                                [&](JsonObject obj) { section.encodeElement(config_, element_, obj); })) {
+                    ++element_;
+                }
+                break;
+            }
+            // A page: its fields, then its buttons one at a time (they close the page object, as in the full form)
+            if (!encodePiece(element_ > 0, false,
+                             [&](JsonObject obj) { encodePageJson(config_.pages[element_], obj, false); })) {
+                break;
+            }
+            text_.pop_back();
+            text_ += ",\"buttons\":[";
+            button_ = 0;
+            stage_ = Stage::BUTTONS;
+            break;
+        }
+
+        case Stage::BUTTONS: {
+            if (element_ >= config_.pages.size() || button_ >= config_.pages[element_].buttons.size()) {
+                text_ = "]}";
+                ++element_;
+                stage_ = Stage::ELEMENTS;
+                break;
+            }
+            if (encodePiece(button_ > 0, false,
+                            [&](JsonObject obj) { encodeButtonJson(config_.pages[element_].buttons[button_], obj); })) {
+                ++button_;
+            }
+            break;
+        }
+
+        case Stage::DONE:
+            break;
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "config_types.h"
+
+// The JSON form of a DeviceConfig (config_json.h) produced a piece at a time
+// for a chunked HTTP response: one top-level member, one array element, or
+// for pages their fields and then one button at a time. Each piece goes
+// through a small JSON document and the same encoders as encodeConfigJson,
+// so the bytes are identical to serializing the whole document, but memory
+// is bounded by the largest piece (a button or a section, around 1 KB of
+// document and text) rather than the whole config. Images are asset
+// references by the time a config is live (asset_store.h), so no piece
+// carries image data.
+//
+// The config is read by index on every fill(): callers serialise fill()
+// against edits (ConfigManager::editLock()), and end the response early when
+// an edit between two fills touched section() or a later member
+// (ConfigManager::editedSince()), as the rest would not match what was
+// already sent. Edits to earlier members only leave the response as it was.
+//
+// A piece that still overflows kMaxPieceDocBytes fails the stream: fill()
+// stops there and returns 0, leaving the body unterminated (so no client
+// parses it as a config) rather than emitting a piece missing members.
+class ConfigJsonStream {
+public:
+    explicit ConfigJsonStream(const DeviceConfig& config) : config_(config) {}
+
+    // Copies the next bytes into `buffer`; 0 once the closing brace is out
+    std::size_t fill(std::uint8_t* buffer, std::size_t max_len);
+    bool failed() const { return failed_; }
+    // Index into kConfigJsonSections of the first top-level member not fully encoded yet; earlier ones are
+    // sent or buffered whole, so edits to them no longer reach this response
+    std::size_t section() const { return section_; }
+
+private:
+    static constexpr std::size_t kPieceDocBytes = 1024;  // Doubled for a piece that overflows it
+    static constexpr std::size_t kMaxPieceDocBytes = 32768;
+
+    enum class Stage { OPEN, SECTION, ELEMENTS, BUTTONS, DONE };
+
+    void next();
+    template <typename Encode>
+    bool encodePiece(bool comma, bool unwrap, Encode encode);
+
+    const DeviceConfig& config_;
+    Stage stage_ = Stage::OPEN;
+    std::size_t section_ = 0;
+    std::size_t element_ = 0;
+    std::size_t button_ = 0;
+    std::size_t doc_bytes_ = kPieceDocBytes;
+    std::string text_;  // The current piece, drained by fill()
+    std::size_t text_pos_ = 0;
+    bool failed_ = false;
+};
@@ -1,33 +1,95 @@
 #pragma once
 
 #include <ArduinoJson.h>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
 #include <string>
+#include <vector>
 
+#include "config_journal.h"
+#include "config_json.h"
+#include "config_patch.h"
+#include "config_save_scheduler.h"
 #include "config_types.h"
 
+/**
+ * Owns the live DeviceConfig. Flash holds it as a binary image
+ * (/config.bin, see config_store.h) that loads without a JSON parse; JSON is
+ * the web UI's import/export format (config_json.h). A /config.json left by
+ * older firmware is migrated on the first boot and then removed.
+ *
+ * Images are not part of either: the config holds "asset:<id>" references
+ * into the asset store (asset_store.h), and inline images from older
+ * firmware or an imported JSON file are moved there as they arrive.
+ *
+ * Saves go through a power-safe journal (config_journal.h): small edits are
+ * appended as patches and folded into a new base image once the journal has
+ * grown and saves have gone quiet.
+ *
+ * Edits made at runtime call requestSave() rather than save(): the config is
+ * marked dirty and a low-priority worker writes it once edits go quiet
+ * (config_save_scheduler.h), so a burst of edits costs one flash write and
+ * the web and LVGL handlers never wait on flash. Code that changes the config
+ * from another task holds editLock() while it does, so the worker never
+ * encodes a half-made edit. Pending edits are flushed by a shutdown handler
+ * before esp_restart().
+ */
 class ConfigManager {
 public:
     static ConfigManager& instance();
 
     bool begin();
+    // Writes the config now, on the caller's task
     bool save() const;
+    // Marks the config dirty; the save worker writes it after the quiet period. `sections` as for markEdited()
+    void requestSave(std::uint32_t sections = kAllConfigJsonSections);
+    // Writes pending edits now; true when nothing is left unsaved
+    bool flush();
     bool resetToDefaults();
 
+    std::unique_lock<std::mutex> editLock() const { return std::unique_lock<std::mutex>(edit_mutex_); }
+    // Changes with every edit, so a reader that spans several editLock() sections (the streamed
+    // GET /api/config) can tell the config changed under it. requestSave() counts an edit; one that is
+    // not saved, or that another task could read before requestSave(), calls markEdited() under editLock()
+    std::uint32_t editGeneration() const { return edit_generation_.load(); }
+    // `sections` (configJsonSectionBit) are the top-level members the edit touched; all of them by default
+    void markEdited(std::uint32_t sections = kAllConfigJsonSections);
+    // True when an edit after `generation` touched kConfigJsonSections[first_section] or a later one
+    bool editedSince(std::uint32_t generation, std::size_t first_section) const;
+    bool savePending() const { return scheduler_.pending(); }
+    std::uint32_t savePendingForMs() const;
+    ConfigSaveStats saveStats() const { return scheduler_.stats(); }
+
     DeviceConfig& getConfig() { return config_; }
     const DeviceConfig& getConfig() const { return config_; }
 
-    std::string toJson() const;
     bool updateFromJson(JsonVariantConst json, std::string& error);
+    // Applies an RFC 6902 patch (config_patch.h) in place; nothing changes when it fails
+    bool applyPatch(JsonVariantConst json, ConfigPatchResult& result, std::string& error);
 
 private:
-    ConfigManager() = default;
+    ConfigManager();
 
     DeviceConfig config_{};
+    mutable ConfigJournal journal_;
+    mutable ConfigSaveScheduler scheduler_;
+    mutable std::mutex edit_mutex_;   // config_ while another task changes or encodes it
+    mutable std::mutex write_mutex_;  // One save or compaction at a time
+    std::atomic<std::uint32_t> edit_generation_{0};
+    std::array<std::atomic<std::uint32_t>, 32> section_generation_{};  // Generation of each section's last edit
+    mutable uint32_t last_save_ms_ = 0;
+    bool worker_started_ = false;
 
-    bool loadFromStorage();
-    bool writeToStorage(const std::string& json) const;
-    DeviceConfig buildDefaultConfig() const;
+    bool load();
+    void startSaveWorker();
+    static void saveWorker(void* arg);
+    void saveTick();
+    void compact();
+    bool loadImage(const std::vector<std::uint8_t>& data, uint32_t start_us);
+    bool loadLegacyJson();
+    static bool internImages(DeviceConfig& config, bool& changed, std::string& error);
     static int compareVersions(const std::string& lhs, const std::string& rhs);
-    bool decodeConfig(JsonVariantConst json, DeviceConfig& target, std::string& error) const;
-    void encodeConfig(const DeviceConfig& source, DynamicJsonDocument& doc) const;
 };
@@ -0,0 +1,514 @@
+#include "config_patch.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#include "config_json.h"
+
+namespace {
+// JSON documents for one section; linked strings point into the config, so these hold structure only
+constexpr std::size_t kThemeDocBytes = 1024;
+constexpr std::size_t kPageDocBytes = 1024;    // Page fields, without its buttons
+constexpr std::size_t kButtonDocBytes = 2048;  // One button, room left for the value being patched in
+
+enum class Op { ADD, REMOVE, REPLACE, TEST };
+
+bool parseOp(const char* name, Op& op) {
+    static const struct {
+        const char* name;
+        Op op;
+    } kOps[] = {{"add", Op::ADD}, {"remove", Op::REMOVE}, {"replace", Op::REPLACE}, {"test", Op::TEST}};
+    for (const auto& entry : kOps) {
+        if (std::strcmp(name, entry.name) == 0) {
+            op = entry.op;
+            return true;
+        }
+    }
+    return false;
+}
+
+// RFC 6901: "/pages/0/label" -> {"pages", "0", "label"}, with ~1 read as '/' and ~0 as '~'
+bool splitPointer(const char* path, std::vector<std::string>& tokens) {
+    tokens.clear();
+    if (*path != '/') {
+        return false;
+    }
+    for (const char* p = path; *p == '/';) {
+        std::string token;
+        for (++p; *p && *p != '/'; ++p) {
+            if (*p != '~') {
+                token.push_back(*p);
+            } else if (p[1] == '0' || p[1] == '1') {
+                token.push_back(p[1] == '0' ? '~' : '/');
+                ++p;
+            } else {
+                return false;
+            }
+        }
+        tokens.push_back(std::move(token));
+    }
+    return true;
+}
+
+// An array index: decimal without a leading zero, below `size`; `size` itself (or "-") only where `allow_end`
+bool parseIndex(const std::string& token, std::size_t size, bool allow_end, std::size_t& index) {
+    if (token == "-") {
+        index = size;
+        return allow_end;
+    }
+    if (token.empty() || token.size() > 4 || (token.size() > 1 && token[0] == '0') ||
+        !std::all_of(token.begin(), token.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+        return false;
+    }
+    index = static_cast<std::size_t>(std::atoi(token.c_str()));
+    return index < size || (allow_end && index == size);
+}
+
+JsonVariant child(JsonVariant parent, const std::string& token) {
+    JsonObject object = parent.as<JsonObject>();
+    if (!object.isNull()) {
+        return object.containsKey(token) ? object.getMember(token) : JsonVariant();
+    }
+    JsonArray array = parent.as<JsonArray>();
+    std::size_t index = 0;
+    if (!array.isNull() && parseIndex(token, array.size(), false, index)) {
+        return array.getElement(index);
+    }
+    return JsonVariant();
+}
+
+bool stored(bool ok, std::string& error) {
+    if (!ok) {
+        error = "value too large";
+    }
+    return ok;
+}
+
+bool testFailed(ConfigPatchResult& result, std::string& error) {
+    result.conflict = true;
+    error = "test failed";
+    return false;
+}
+
+// Applies one operation at tokens[first..] inside `root`, a section encoded to JSON
+bool applyInDocument(JsonVariant root, const std::vector<std::string>& tokens, std::size_t first, Op op,
+                     JsonVariantConst value, ConfigPatchResult& result, std::string& error) {
+    if (first == tokens.size()) {
+        if (op == Op::TEST) {
+            return JsonVariantConst(root) == value || testFailed(result, error);
+        }
+        if (op == Op::REMOVE || value.as<JsonObjectConst>().isNull()) {
+            error = op == Op::REMOVE ? "cannot remove this path" : "value must be an object";
+            return false;
+        }
+        return stored(root.set(value), error);
+    }
+
+    JsonVariant parent = root;
+    for (std::size_t i = first; i + 1 < tokens.size() && !parent.isNull(); ++i) {
+        parent = child(parent, tokens[i]);
+    }
+    const std::string& key = tokens.back();
+
+    JsonObject object = parent.as<JsonObject>();
+    if (!object.isNull()) {
+        const bool exists = object.containsKey(key);
+        if (!exists && op != Op::ADD) {
+            error = "no such path";
+            return false;
+        }
+        switch (op) {
+            case Op::TEST:
+                return JsonVariantConst(object.getMember(key)) == value || testFailed(result, error);
+            case Op::REMOVE:
+                object.remove(key);
+                return true;
+            default:
+                return stored(object[key].set(value), error);
+        }
+    }
+
+    JsonArray array = parent.as<JsonArray>();
+    std::size_t index = 0;
+    if (array.isNull() || !parseIndex(key, array.size(), op == Op::ADD, index)) {
+        error = "no such path";
+        return false;
+    }
+    switch (op) {
+        case Op::TEST:
+            return JsonVariantConst(array.getElement(index)) == value || testFailed(result, error);
+        case Op::REMOVE:
+            array.remove(index);
+            return true;
+        case Op::REPLACE:
+            return stored(array.getElement(index).set(value), error);
+        case Op::ADD:
+            break;
+    }
+    // Insert: append, shift the tail up one, then drop the value into the gap
+    if (!stored(array.add(0), error)) {
+        return false;
+    }
+    for (std::size_t i = array.size() - 1; i > index; --i) {
+        array.getElement(i).set(array.getElement(i - 1));
+    }
+    return stored(array.getElement(index).set(value), error);
+}
+
+class PatchApplier {
+public:
+    PatchApplier(DeviceConfig& config, ConfigPatchResult& result, std::string& error)
+        : config_(config), result_(result), error_(error) {}
+
+    bool apply(JsonObjectConst op_obj);
+    void rollback();
+
+private:
+    // What an operation replaced, so a later failure can put it back
+    struct Undo {
+        enum class Kind { THEME, PAGE, PAGE_INSERTED, PAGE_REMOVED, PAGES } kind;
+        std::size_t index = 0;
+        ThemeConfig theme{};
+        PageConfig page{};
+        ConfigList<PageConfig> pages;
+    };
+
+    bool applyTheme(Op op, JsonVariantConst value);
+    bool applyPages(Op op, JsonVariantConst value);
+    bool applyPage(std::size_t index, Op op, JsonVariantConst value);
+    bool applyPageField(std::size_t index, Op op, JsonVariantConst value);
+    bool applyButtons(std::size_t index, Op op, JsonVariantConst value);
+    bool applyButton(std::size_t page_index, Op op, JsonVariantConst value);
+    bool applyButtonField(std::size_t page_index, std::size_t button_index, Op op, JsonVariantConst value);
+
+    void savePage(std::size_t index);
+    void changed(const std::string& region);
+    bool fail(const char* message) {
+        error_ = message;
+        return false;
+    }
+
+    DeviceConfig& config_;
+    ConfigPatchResult& result_;
+    std::string& error_;
+    std::vector<std::string> tokens_;
+    std::vector<Undo> undo_;
+};
+
+void PatchApplier::changed(const std::string& region) {
+    if (std::find(result_.changed.begin(), result_.changed.end(), region) == result_.changed.end()) {
+        result_.changed.push_back(region);
+    }
+}
+
+void PatchApplier::savePage(std::size_t index) {
+    Undo undo;
+    undo.kind = Undo::Kind::PAGE;
+    undo.index = index;
+    undo.page = config_.pages[index];
+    undo_.push_back(std::move(undo));
+}
+
+void PatchApplier::rollback() {
+    for (auto it = undo_.rbegin(); it != undo_.rend(); ++it) {
+        switch (it->kind) {
+            case Undo::Kind::THEME:
+                config_.theme = std::move(it->theme);
+                break;
+            case Undo::Kind::PAGE:
+                config_.pages[it->index] = std::move(it->page);
+                break;
+            case Undo::Kind::PAGE_INSERTED:
+                config_.pages.erase(config_.pages.begin() + it->index);
+                break;
+            case Undo::Kind::PAGE_REMOVED:
+                config_.pages.insert(config_.pages.begin() + it->index, std::move(it->page));
+                break;
+            case Undo::Kind::PAGES:
+                config_.pages = std::move(it->pages);
+                break;
+        }
+    }
+    undo_.clear();
+    result_.changed.clear();
+}
+
+bool PatchApplier::apply(JsonObjectConst op_obj) {
+    Op op;
+    const char* name = op_obj["op"] | "";
+    if (!parseOp(name, op)) {
+        return fail(std::strcmp(name, "move") == 0 || std::strcmp(name, "copy") == 0 ? "move and copy are not supported"
+                                                                                     : "unknown op");
+    }
+    const char* path = op_obj["path"] | "";
+    if (!splitPointer(path, tokens_)) {
+        return fail("path must be a JSON Pointer");
+    }
+    if (op != Op::REMOVE && !op_obj.containsKey("value")) {
+        return fail("value is required");
+    }
+    const JsonVariantConst value = op_obj["value"];
+
+    if (tokens_[0] == "theme") {
+        return applyTheme(op, value);
+    }
+    if (tokens_[0] != "pages") {
+        return fail("only /pages and /theme can be patched");
+    }
+    if (tokens_.size() == 1) {
+        return applyPages(op, value);
+    }
+    std::size_t index = 0;
+    if (!parseIndex(tokens_[1], config_.pages.size(), tokens_.size() == 2 && op == Op::ADD, index)) {
+        return fail("no such page");
+    }
+    if (tokens_.size() == 2) {
+        return applyPage(index, op, value);
+    }
+    if (tokens_[2] != "buttons") {
+        return applyPageField(index, op, value);
+    }
+    if (tokens_.size() == 3) {
+        return applyButtons(index, op, value);
+    }
+    return applyButton(index, op, value);
+}
+
+bool PatchApplier::applyTheme(Op op, JsonVariantConst value) {
+    PsramJsonDocument doc(kThemeDocBytes);
+    encodeThemeJson(config_.theme, doc.to<JsonObject>());
+    if (!applyInDocument(doc.as<JsonVariant>(), tokens_, 1, op, value, result_, error_)) {
+        return false;
+    }
+    if (op == Op::TEST) {
+        return true;
+    }
+    ThemeConfig theme;  // Decoded over the defaults, as a page or button is: a removed field is reset
+    decodeThemeJson(doc.as<JsonObjectConst>(), theme);
+    Undo undo;
+    undo.kind = Undo::Kind::THEME;
+    undo.theme = std::move(config_.theme);
+    undo_.push_back(std::move(undo));
+    config_.theme = std::move(theme);
+    changed("theme");
+    return true;
+}
+
+bool PatchApplier::applyPages(Op op, JsonVariantConst value) {
+    if (op != Op::ADD && op != Op::REPLACE) {
+        return fail(op == Op::TEST ? "test a page or a field, not every page" : "a config needs at least one page");
+    }
+    JsonArrayConst pages = value.as<JsonArrayConst>();
+    if (pages.isNull() || pages.size() == 0 || pages.size() > MAX_PAGES) {
+        return fail("pages must be an array of 1 to 20 pages");
+    }
+    ConfigList<PageConfig> decoded;
+    decoded.reserve(pages.size());
+    for (JsonVariantConst page : pages) {
+        decoded.push_back(decodePageJson(page.as<JsonObjectConst>(), decoded.size()));
+    }
+    Undo undo;
+    undo.kind = Undo::Kind::PAGES;
+    undo.pages = std::move(config_.pages);
+    undo_.push_back(std::move(undo));
+    config_.pages = std::move(decoded);
+    changed("nav");
+    changed("pages");
+    return true;
+}
+
+bool PatchApplier::applyPage(std::size_t index, Op op, JsonVariantConst value) {
+    if (op == Op::TEST) {
+        const PageConfig& page = config_.pages[index];
+        PsramJsonDocument doc(kPageDocBytes + page.buttons.size() * kButtonDocBytes);
+        encodePageJson(page, doc.to<JsonObject>());
+        return applyInDocument(doc.as<JsonVariant>(), tokens_, 2, op, value, result_, error_);
+    }
+    if (op == Op::REMOVE) {
+        if (config_.pages.size() == 1) {
+            return fail("a config needs at least one page");
+        }
+        changed("nav");
+        changed("page:" + config_.pages[index].id);
+        Undo undo;
+        undo.kind = Undo::Kind::PAGE_REMOVED;
+        undo.index = index;
+        undo.page = std::move(config_.pages[index]);
+        undo_.push_back(std::move(undo));
+        config_.pages.erase(config_.pages.begin() + index);
+        return true;
+    }
+    JsonObjectConst page_obj = value.as<JsonObjectConst>();
+    if (page_obj.isNull()) {
+        return fail("value must be an object");
+    }
+    if (op == Op::ADD && config_.pages.size() >= MAX_PAGES) {
+        return fail("too many pages");
+    }
+    PageConfig page = decodePageJson(page_obj, index);
+    changed("nav");
+    changed("page:" + page.id);
+    if (op == Op::ADD) {
+        Undo undo;
+        undo.kind = Undo::Kind::PAGE_INSERTED;
+        undo.index = index;
+        undo_.push_back(std::move(undo));
+        config_.pages.insert(config_.pages.begin() + index, std::move(page));
+        return true;
+    }
+    changed("page:" + config_.pages[index].id);
+    savePage(index);
+    config_.pages[index] = std::move(page);
+    return true;
+}
+
+bool PatchApplier::applyPageField(std::size_t index, Op op, JsonVariantConst value) {
+    static const char* const kNavFields[] = {"id", "name", "nav_text", "nav_color", "nav_inactive_color",
+                                             "nav_text_color", "nav_button_radius"};
+    PageConfig& page = config_.pages[index];
+    PsramJsonDocument doc(kPageDocBytes);
+    encodePageJson(page, doc.to<JsonObject>(), false);
+    if (doc.overflowed()) {
+        return fail("page too large to patch");
+    }
+    if (!applyInDocument(doc.as<JsonVariant>(), tokens_, 2, op, value, result_, error_)) {
+        return false;
+    }
+    if (op == Op::TEST) {
+        return true;
+    }
+    PageConfig patched = decodePageJson(doc.as<JsonObjectConst>(), index, false);
+    if (patched.rows == page.rows && patched.cols == page.cols) {
+        patched.buttons = page.buttons;
+    } else {
+        // A smaller grid moves and shrinks the buttons that no longer fit, exactly as a full decode would
+        for (std::size_t i = 0; i < page.buttons.size(); ++i) {
+            PsramJsonDocument button_doc(kButtonDocBytes);
+            encodeButtonJson(page.buttons[i], button_doc.to<JsonObject>());
+            patched.buttons.push_back(decodeButtonJson(button_doc.as<JsonObjectConst>(), patched, i));
+        }
+    }
+    for (const char* field : kNavFields) {
+        if (tokens_[2] == field) {
+            changed("nav");
+        }
+    }
+    changed("page:" + page.id);
+    changed("page:" + patched.id);
+    savePage(index);
+    page = std::move(patched);
+    return true;
+}
+
+bool PatchApplier::applyButtons(std::size_t index, Op op, JsonVariantConst value) {
+    PageConfig& page = config_.pages[index];
+    if (op == Op::TEST) {
+        PsramJsonDocument doc(kPageDocBytes + page.buttons.size() * kButtonDocBytes);
+        encodePageJson(page, doc.to<JsonObject>());
+        return applyInDocument(doc.as<JsonVariant>(), tokens_, 2, op, value, result_, error_);
+    }
+    if (op == Op::REMOVE) {
+        return fail("cannot remove this path");
+    }
+    JsonArrayConst buttons = value.as<JsonArrayConst>();
+    if (buttons.isNull() || buttons.size() > MAX_BUTTONS_PER_PAGE) {
+        return fail("buttons must be an array of up to 12 buttons");
+    }
+    ConfigList<ButtonConfig> decoded;
+    decoded.reserve(buttons.size());
+    for (JsonVariantConst button : buttons) {
+        decoded.push_back(decodeButtonJson(button.as<JsonObjectConst>(), page, decoded.size()));
+    }
+    savePage(index);
+    page.buttons = std::move(decoded);
+    changed("page:" + page.id);
+    return true;
+}
+
+bool PatchApplier::applyButton(std::size_t page_index, Op op, JsonVariantConst value) {
+    PageConfig& page = config_.pages[page_index];
+    std::size_t index = 0;
+    if (!parseIndex(tokens_[3], page.buttons.size(), tokens_.size() == 4 && op == Op::ADD, index)) {
+        return fail("no such button");
+    }
+    if (tokens_.size() > 4 || op == Op::TEST) {
+        return applyButtonField(page_index, index, op, value);
+    }
+    if (op == Op::REMOVE) {
+        savePage(page_index);
+        page.buttons.erase(page.buttons.begin() + index);
+        changed("page:" + page.id);
+        return true;
+    }
+    JsonObjectConst button_obj = value.as<JsonObjectConst>();
+    if (button_obj.isNull()) {
+        return fail("value must be an object");
+    }
+    if (op == Op::ADD && page.buttons.size() >= MAX_BUTTONS_PER_PAGE) {
+        return fail("too many buttons on this page");
+    }
+    ButtonConfig button = decodeButtonJson(button_obj, page, index);
+    savePage(page_index);
+    if (op == Op::ADD) {
+        page.buttons.insert(page.buttons.begin() + index, std::move(button));
+        changed("page:" + page.id);
+        return true;
+    }
+    changed("button:" + page.id + "/" + page.buttons[index].id);
+    changed("button:" + page.id + "/" + button.id);
+    page.buttons[index] = std::move(button);
+    return true;
+}
+
+bool PatchApplier::applyButtonField(std::size_t page_index, std::size_t button_index, Op op,
+                                    JsonVariantConst value) {
+    PageConfig& page = config_.pages[page_index];
+    PsramJsonDocument doc(kButtonDocBytes);
+    encodeButtonJson(page.buttons[button_index], doc.to<JsonObject>());
+    if (doc.overflowed()) {
+        return fail("button too large to patch");
+    }
+    if (!applyInDocument(doc.as<JsonVariant>(), tokens_, 4, op, value, result_, error_)) {
+        return false;
+    }
+    if (op == Op::TEST) {
+        return true;
+    }
+    ButtonConfig button = decodeButtonJson(doc.as<JsonObjectConst>(), page, button_index);
+    changed("button:" + page.id + "/" + page.buttons[button_index].id);
+    changed("button:" + page.id + "/" + button.id);
+    savePage(page_index);
+    page.buttons[button_index] = std::move(button);
+    return true;
+}
+}
+
+bool applyConfigPatch(JsonArrayConst ops, DeviceConfig& config, ConfigPatchResult& result, std::string& error) {
+    result = ConfigPatchResult{};
+    if (ops.isNull()) {
+        error = "a JSON Patch is an array of operations";
+        return false;
+    }
+    if (ops.size() > kMaxConfigPatchOps) {
+        error = "too many operations";
+        return false;
+    }
+    PatchApplier applier(config, result, error);
+    std::size_t index = 0;
+    for (JsonVariantConst op : ops) {
+        JsonObjectConst op_obj = op.as<JsonObjectConst>();
+        if (op_obj.isNull() || !applier.apply(op_obj)) {
+            if (op_obj.isNull()) {
+                error = "operation must be an object";
+            }
+            applier.rollback();
+            result.failed_op = index;
+            error = "op " + std::to_string(index) + ": " + error;
+            return false;
+        }
+        ++index;
+    }
+    return true;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <ArduinoJson.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "config_types.h"
+
+// RFC 6902 JSON Patch over the pages, buttons and theme of a DeviceConfig,
+// applied in place: PATCH /api/config carries
+//   [{"op":"replace","path":"/pages/0/buttons/2/label","value":"Fog lights"}]
+// instead of the whole config. Paths are JSON Pointers into the JSON form
+// (config_json.h) and may name /theme, /pages, a page, its buttons array, a
+// button, or any field inside one of those. Each operation re-encodes only
+// the page, button or theme it lands in, applies the change there and decodes
+// that section back through the same clamping decodeConfigJson uses, so
+// nothing outside the touched section is parsed or validated.
+//
+// add, remove, replace and test are supported; move and copy are not.
+// Removing a field of the theme, a page or a button resets it to its default
+// (the config_types.h initializer), and replacing one of those with an
+// object does the same for the fields the object leaves out. The patch is
+// atomic: when an operation fails, the ones before it are undone.
+
+constexpr std::size_t kMaxConfigPatchOps = 64;
+
+struct ConfigPatchResult {
+    // UI regions the patch changed: "theme", "nav" (page names and nav styling), "pages" (all of them),
+    // "page:<page id>" (a page's layout or styling) and "button:<page id>/<button id>"
+    std::vector<std::string> changed;
+    std::size_t failed_op = 0;  // Index of the operation that failed
+    bool conflict = false;      // It was a test that did not match (HTTP 409 rather than 400)
+};
+
+bool applyConfigPatch(JsonArrayConst ops, DeviceConfig& config, ConfigPatchResult& result, std::string& error);
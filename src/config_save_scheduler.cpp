@@ -0,0 +1,69 @@
+#include "config_save_scheduler.h"
+
+namespace {
+// Wrap-safe age of a millisecond timestamp
+std::uint32_t age(std::uint32_t now_ms, std::uint32_t then_ms) {
+    return now_ms - then_ms;
+}
+}
+
+void ConfigSaveScheduler::markDirty(std::uint32_t now_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (dirty_generation_ == written_generation_) {
+        first_dirty_ms_ = now_ms;
+    }
+    ++dirty_generation_;
+    last_dirty_ms_ = now_ms;
+    ++stats_.requests;
+}
+
+bool ConfigSaveScheduler::pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dirty_generation_ != written_generation_;
+}
+
+bool ConfigSaveScheduler::due(std::uint32_t now_ms) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (dirty_generation_ == written_generation_) {
+        return false;
+    }
+    if (failed_ && age(now_ms, failed_ms_) < kRetryMs) {
+        return false;
+    }
+    return age(now_ms, last_dirty_ms_) >= kQuietMs || age(now_ms, first_dirty_ms_) >= kMaxDelayMs;
+}
+
+std::uint32_t ConfigSaveScheduler::pendingForMs(std::uint32_t now_ms) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dirty_generation_ == written_generation_ ? 0 : age(now_ms, first_dirty_ms_);
+}
+
+std::uint32_t ConfigSaveScheduler::beginWrite() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dirty_generation_;
+}
+
+void ConfigSaveScheduler::endWrite(std::uint32_t generation, bool ok, std::uint32_t now_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!ok) {
+        ++stats_.failures;
+        failed_ = true;
+        failed_ms_ = now_ms;
+        return;
+    }
+    const std::uint32_t covered = generation - written_generation_;
+    ++stats_.writes;
+    if (covered > 1) {
+        stats_.coalesced += covered - 1;
+    }
+    failed_ = false;
+    written_generation_ = generation;
+    if (dirty_generation_ != written_generation_) {
+        first_dirty_ms_ = now_ms;  // Edits made during the write start a new window
+    }
+}
+
+ConfigSaveStats ConfigSaveScheduler::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+
+struct ConfigSaveStats {
+    std::uint32_t requests = 0;   // Edits that asked for a save
+    std::uint32_t writes = 0;     // Saves that reached flash
+    std::uint32_t coalesced = 0;  // Requests folded into a write made for a later one
+    std::uint32_t failures = 0;
+};
+
+/**
+ * Decides when a dirty config is written back.
+ *
+ * Edits only mark the config dirty; the save worker asks due() and writes
+ * once edits have been quiet for kQuietMs (a slider drag or a run of form
+ * posts becomes one write), or kMaxDelayMs after the first unsaved edit so a
+ * steady stream of edits cannot hold a save off forever. Every edit bumps a
+ * generation; a write covers the generation it started from, so an edit that
+ * lands while the image is being written stays pending. A failed write is
+ * retried after kRetryMs.
+ */
+class ConfigSaveScheduler {
+public:
+    static constexpr std::uint32_t kQuietMs = 1000;
+    static constexpr std::uint32_t kMaxDelayMs = 5000;
+    static constexpr std::uint32_t kRetryMs = 5000;
+
+    void markDirty(std::uint32_t now_ms);
+    bool pending() const;
+    bool due(std::uint32_t now_ms) const;
+    // Ms since the oldest unsaved edit; 0 when nothing is pending
+    std::uint32_t pendingForMs(std::uint32_t now_ms) const;
+
+    // The writer is about to encode the config: returns the generation the write will cover
+    std::uint32_t beginWrite() const;
+    void endWrite(std::uint32_t generation, bool ok, std::uint32_t now_ms);
+
+    ConfigSaveStats stats() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::uint32_t dirty_generation_ = 0;
+    std::uint32_t written_generation_ = 0;
+    std::uint32_t first_dirty_ms_ = 0;
+    std::uint32_t last_dirty_ms_ = 0;
+    std::uint32_t failed_ms_ = 0;
+    bool failed_ = false;
+    ConfigSaveStats stats_{};
+};
@@ -0,0 +1,832 @@
+#include "config_store.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "can_log_format.h"
+
+namespace {
+constexpr std::size_t kAlign = 4;
+
+// String reference in a record default: the reader leaves the field as the config struct initialized it
+constexpr ConfigImageString kUnsetString{UINT32_MAX, 0};
+
+std::size_t alignUp(std::size_t value) {
+    return (value + kAlign - 1) & ~(kAlign - 1);
+}
+
+class ImageWriter {
+public:
+    ImageWriter() {
+        strings_.push_back('\0');  // Offset 0 is the empty string
+    }
+
+    // Stores nothing and returns kUnsetString for every string; builds the record defaults
+    static ImageWriter unsetStrings() {
+        ImageWriter writer;
+        writer.unset_strings_ = true;
+        return writer;
+    }
+
+    // Starts from an earlier image's string table so the strings it has keep their offsets
+    explicit ImageWriter(std::string_view previous) : strings_(previous) {
+        for (std::size_t offset = 1; offset < previous.size();) {
+            const std::size_t end = previous.find('\0', offset);
+            if (end > offset) {
+                // Keys view the previous image, which the caller keeps alive through the encode
+                interned_.emplace(previous.substr(offset, end - offset),
+                                  ConfigImageString{static_cast<std::uint32_t>(offset),
+                                                    static_cast<std::uint32_t>(end - offset)});
+            }
+            offset = end + 1;
+        }
+    }
+
+    ConfigImageString str(const std::string& value) {
+        if (unset_strings_) {
+            return kUnsetString;
+        }
+        if (value.empty()) {
+            return ConfigImageString{0, 0};
+        }
+        // Keys view the caller's config, which outlives the writer
+        auto it = interned_.find(std::string_view(value));
+        if (it != interned_.end()) {
+            return it->second;
+        }
+        const ConfigImageString ref{static_cast<std::uint32_t>(strings_.size()),
+                                    static_cast<std::uint32_t>(value.size())};
+        strings_.append(value);
+        strings_.push_back('\0');
+        interned_.emplace(std::string_view(value), ref);
+        return ref;
+    }
+
+    template <typename T>
+    void add(ConfigSection id, const std::vector<T>& records) {
+        add(id, records.data(), sizeof(T), records.size());
+    }
+
+    void add(ConfigSection id, const void* records, std::size_t record_size, std::size_t count) {
+        Pending pending;
+        pending.id = id;
+        pending.record_size = static_cast<std::uint16_t>(record_size);
+        pending.count = static_cast<std::uint32_t>(count);
+        pending.data = static_cast<const std::uint8_t*>(records);
+        sections_.push_back(pending);
+    }
+
+    void finish(std::vector<std::uint8_t>& out) {
+        add(ConfigSection::STRINGS, strings_.data(), 1, strings_.size());
+
+        std::size_t offset = alignUp(sizeof(ConfigImageHeader) + sections_.size() * sizeof(ConfigImageSection));
+        std::vector<ConfigImageSection> table;
+        table.reserve(sections_.size());
+        for (const Pending& pending : sections_) {
+            table.push_back({static_cast<std::uint16_t>(pending.id), pending.record_size, pending.count,
+                             static_cast<std::uint32_t>(offset)});
+            offset = alignUp(offset + static_cast<std::size_t>(pending.record_size) * pending.count);
+        }
+
+        out.assign(offset, 0);
+        std::memcpy(out.data() + sizeof(ConfigImageHeader), table.data(), table.size() * sizeof(ConfigImageSection));
+        for (std::size_t i = 0; i < sections_.size(); ++i) {
+            const std::size_t bytes = static_cast<std::size_t>(sections_[i].record_size) * sections_[i].count;
+            if (bytes) {
+                std::memcpy(out.data() + table[i].offset, sections_[i].data, bytes);
+            }
+        }
+
+        ConfigImageHeader header{};
+        header.magic = kConfigImageMagic;
+        header.version = kConfigImageVersion;
+        header.section_count = static_cast<std::uint16_t>(table.size());
+        header.size = static_cast<std::uint32_t>(out.size());
+        header.crc = canLogCrc32(out.data() + sizeof(header), out.size() - sizeof(header));
+        std::memcpy(out.data(), &header, sizeof(header));
+    }
+
+private:
+    struct Pending {
+        ConfigSection id;
+        std::uint16_t record_size;
+        std::uint32_t count;
+        const std::uint8_t* data;
+    };
+
+    std::string strings_;
+    std::unordered_map<std::string_view, ConfigImageString> interned_;
+    std::vector<Pending> sections_;
+    bool unset_strings_ = false;
+};
+
+void readText(const ConfigImage& image, std::string& target, const ConfigImageString& ref) {
+    if (ref.offset == kUnsetString.offset) {
+        return;
+    }
+    const std::string_view value = image.string(ref);
+    target.assign(value.data(), value.size());
+}
+
+template <std::size_t N>
+void copyBytes(std::uint8_t (&dst)[N], const std::array<std::uint8_t, N>& src) {
+    std::copy(src.begin(), src.end(), dst);
+}
+
+template <std::size_t N>
+void copyBytes(std::array<std::uint8_t, N>& dst, const std::uint8_t (&src)[N]) {
+    std::copy(src, src + N, dst.begin());
+}
+
+ConfigImageFrame frameRecord(const CanFrameConfig& frame) {
+    ConfigImageFrame rec{};
+    rec.pgn = frame.pgn;
+    rec.enabled = frame.enabled;
+    rec.priority = frame.priority;
+    rec.source_address = frame.source_address;
+    rec.destination_address = frame.destination_address;
+    rec.length = frame.length;
+    copyBytes(rec.data, frame.data);
+    return rec;
+}
+
+void readFrame(const ConfigImageFrame& rec, CanFrameConfig& frame) {
+    frame.enabled = rec.enabled != 0;
+    frame.pgn = rec.pgn;
+    frame.priority = rec.priority;
+    frame.source_address = rec.source_address;
+    frame.destination_address = rec.destination_address;
+    frame.length = std::min<std::uint8_t>(rec.length, 8);
+    copyBytes(frame.data, rec.data);
+}
+
+ConfigImageDevice deviceRecord(const DeviceConfig& config, ImageWriter& writer) {
+    ConfigImageDevice rec{};
+    rec.version = writer.str(config.version);
+    rec.title = writer.str(config.header.title);
+    rec.subtitle = writer.str(config.header.subtitle);
+    rec.logo_variant = writer.str(config.header.logo_variant);
+    rec.logo_base64 = writer.str(config.header.logo_base64);
+    rec.title_font = writer.str(config.header.title_font);
+    rec.subtitle_font = writer.str(config.header.subtitle_font);
+    rec.title_align = writer.str(config.header.title_align);
+    rec.logo_position = writer.str(config.header.logo_position);
+    rec.sleep_icon_base64 = writer.str(config.display.sleep_icon_base64);
+    rec.header_logo = writer.str(config.images.header_logo);
+    rec.splash_logo = writer.str(config.images.splash_logo);
+    rec.background_image = writer.str(config.images.background_image);
+    rec.sleep_logo = writer.str(config.images.sleep_logo);
+    rec.bg_color = writer.str(config.theme.bg_color);
+    rec.surface_color = writer.str(config.theme.surface_color);
+    rec.page_bg_color = writer.str(config.theme.page_bg_color);
+    rec.accent_color = writer.str(config.theme.accent_color);
+    rec.text_primary = writer.str(config.theme.text_primary);
+    rec.text_secondary = writer.str(config.theme.text_secondary);
+    rec.border_color = writer.str(config.theme.border_color);
+    rec.header_border_color = writer.str(config.theme.header_border_color);
+    rec.nav_button_color = writer.str(config.theme.nav_button_color);
+    rec.nav_button_active_color = writer.str(config.theme.nav_button_active_color);
+    rec.nav_button_text_color = writer.str(config.theme.nav_button_text_color);
+    rec.ap_ssid = writer.str(config.wifi.ap.ssid);
+    rec.ap_password = writer.str(config.wifi.ap.password);
+    rec.sta_ssid = writer.str(config.wifi.sta.ssid);
+    rec.sta_password = writer.str(config.wifi.sta.password);
+    rec.ota_manifest_url = writer.str(config.ota.manifest_url);
+    rec.ota_channel = writer.str(config.ota.channel);
+
+    rec.can_bitrate = config.can_bus.bitrate;
+    rec.recorder_max_segment_kb = config.can_recorder.max_segment_kb;
+    rec.recorder_max_total_kb = config.can_recorder.max_total_kb;
+    rec.recorder_flush_interval_ms = config.can_recorder.flush_interval_ms;
+    rec.j1939_identity_number = config.j1939.identity_number;
+    rec.logo_target_height = config.header.logo_target_height;
+    rec.sleep_timeout_seconds = config.display.sleep_timeout_seconds;
+    rec.coalesce_duplicate_window_ms = config.can_coalesce.duplicate_window_ms;
+    rec.coalesce_min_spacing_ms = config.can_coalesce.min_spacing_ms;
+    rec.j1939_manufacturer_code = config.j1939.manufacturer_code;
+    rec.show_logo = config.header.show_logo;
+    rec.logo_preserve_aspect = config.header.logo_preserve_aspect;
+    rec.nav_spacing = config.header.nav_spacing;
+    rec.brightness = config.display.brightness;
+    rec.sleep_enabled = config.display.sleep_enabled;
+    rec.nav_button_radius = config.theme.nav_button_radius;
+    rec.button_radius = config.theme.button_radius;
+    rec.border_width = config.theme.border_width;
+    rec.header_border_width = config.theme.header_border_width;
+    rec.ap_enabled = config.wifi.ap.enabled;
+    rec.sta_enabled = config.wifi.sta.enabled;
+    rec.ota_enabled = config.ota.enabled;
+    rec.can_auto_baud = config.can_bus.auto_baud;
+    rec.coalesce_enabled = config.can_coalesce.enabled;
+    rec.filter_enabled = config.can_filter.enabled;
+    rec.recorder_enabled = config.can_recorder.enabled;
+    rec.j1939_address_claim = config.j1939.address_claim;
+    rec.j1939_preferred_address = config.j1939.preferred_address;
+    rec.j1939_address_min = config.j1939.address_min;
+    rec.j1939_address_max = config.j1939.address_max;
+    rec.j1939_arbitrary_address_capable = config.j1939.arbitrary_address_capable;
+    rec.j1939_industry_group = config.j1939.industry_group;
+    rec.j1939_vehicle_system = config.j1939.vehicle_system;
+    rec.j1939_vehicle_system_instance = config.j1939.vehicle_system_instance;
+    rec.j1939_function = config.j1939.function;
+    rec.j1939_function_instance = config.j1939.function_instance;
+    rec.j1939_ecu_instance = config.j1939.ecu_instance;
+    return rec;
+}
+
+void readDevice(const ConfigImage& image, const ConfigImageDevice& rec, DeviceConfig& config) {
+    auto text = [&image](std::string& target, const ConfigImageString& ref) { readText(image, target, ref); };
+    text(config.version, rec.version);
+    text(config.header.title, rec.title);
+    text(config.header.subtitle, rec.subtitle);
+    text(config.header.logo_variant, rec.logo_variant);
+    text(config.header.logo_base64, rec.logo_base64);
+    text(config.header.title_font, rec.title_font);
+    text(config.header.subtitle_font, rec.subtitle_font);
+    text(config.header.title_align, rec.title_align);
+    text(config.header.logo_position, rec.logo_position);
+    text(config.display.sleep_icon_base64, rec.sleep_icon_base64);
+    text(config.images.header_logo, rec.header_logo);
+    text(config.images.splash_logo, rec.splash_logo);
+    text(config.images.background_image, rec.background_image);
+    text(config.images.sleep_logo, rec.sleep_logo);
+    text(config.theme.bg_color, rec.bg_color);
+    text(config.theme.surface_color, rec.surface_color);
+    text(config.theme.page_bg_color, rec.page_bg_color);
+    text(config.theme.accent_color, rec.accent_color);
+    text(config.theme.text_primary, rec.text_primary);
+    text(config.theme.text_secondary, rec.text_secondary);
+    text(config.theme.border_color, rec.border_color);
+    text(config.theme.header_border_color, rec.header_border_color);
+    text(config.theme.nav_button_color, rec.nav_button_color);
+    text(config.theme.nav_button_active_color, rec.nav_button_active_color);
+    text(config.theme.nav_button_text_color, rec.nav_button_text_color);
+    text(config.wifi.ap.ssid, rec.ap_ssid);
+    text(config.wifi.ap.password, rec.ap_password);
+    text(config.wifi.sta.ssid, rec.sta_ssid);
+    text(config.wifi.sta.password, rec.sta_password);
+    text(config.ota.manifest_url, rec.ota_manifest_url);
+    text(config.ota.channel, rec.ota_channel);
+
+    config.can_bus.bitrate = rec.can_bitrate;
+    config.can_recorder.max_segment_kb = rec.recorder_max_segment_kb;
+    config.can_recorder.max_total_kb = rec.recorder_max_total_kb;
+    config.can_recorder.flush_interval_ms = rec.recorder_flush_interval_ms;
+    config.j1939.identity_number = rec.j1939_identity_number;
+    config.header.logo_target_height = rec.logo_target_height;
+    config.display.sleep_timeout_seconds = rec.sleep_timeout_seconds;
+    config.can_coalesce.duplicate_window_ms = rec.coalesce_duplicate_window_ms;
+    config.can_coalesce.min_spacing_ms = rec.coalesce_min_spacing_ms;
+    config.j1939.manufacturer_code = rec.j1939_manufacturer_code;
+    config.header.show_logo = rec.show_logo != 0;
+    config.header.logo_preserve_aspect = rec.logo_preserve_aspect != 0;
+    config.header.nav_spacing = rec.nav_spacing;
+    config.display.brightness = rec.brightness;
+    config.display.sleep_enabled = rec.sleep_enabled != 0;
+    config.theme.nav_button_radius = rec.nav_button_radius;
+    config.theme.button_radius = rec.button_radius;
+    config.theme.border_width = rec.border_width;
+    config.theme.header_border_width = rec.header_border_width;
+    config.wifi.ap.enabled = rec.ap_enabled != 0;
+    config.wifi.sta.enabled = rec.sta_enabled != 0;
+    config.ota.enabled = rec.ota_enabled != 0;
+    config.can_bus.auto_baud = rec.can_auto_baud != 0;
+    config.can_coalesce.enabled = rec.coalesce_enabled != 0;
+    config.can_filter.enabled = rec.filter_enabled != 0;
+    config.can_recorder.enabled = rec.recorder_enabled != 0;
+    config.j1939.address_claim = rec.j1939_address_claim != 0;
+    config.j1939.preferred_address = rec.j1939_preferred_address;
+    config.j1939.address_min = rec.j1939_address_min;
+    config.j1939.address_max = rec.j1939_address_max;
+    config.j1939.arbitrary_address_capable = rec.j1939_arbitrary_address_capable != 0;
+    config.j1939.industry_group = rec.j1939_industry_group;
+    config.j1939.vehicle_system = rec.j1939_vehicle_system;
+    config.j1939.vehicle_system_instance = rec.j1939_vehicle_system_instance;
+    config.j1939.function = rec.j1939_function;
+    config.j1939.function_instance = rec.j1939_function_instance;
+    config.j1939.ecu_instance = rec.j1939_ecu_instance;
+}
+
+ConfigImagePage pageRecord(const PageConfig& page, ImageWriter& writer) {
+    ConfigImagePage rec{};
+    rec.id = writer.str(page.id);
+    rec.name = writer.str(page.name);
+    rec.nav_text = writer.str(page.nav_text);
+    rec.nav_color = writer.str(page.nav_color);
+    rec.nav_inactive_color = writer.str(page.nav_inactive_color);
+    rec.nav_text_color = writer.str(page.nav_text_color);
+    rec.bg_color = writer.str(page.bg_color);
+    rec.text_color = writer.str(page.text_color);
+    rec.button_color = writer.str(page.button_color);
+    rec.button_pressed_color = writer.str(page.button_pressed_color);
+    rec.button_border_color = writer.str(page.button_border_color);
+    rec.nav_button_radius = page.nav_button_radius;
+    rec.button_border_width = page.button_border_width;
+    rec.button_radius = page.button_radius;
+    rec.rows = page.rows;
+    rec.cols = page.cols;
+    return rec;
+}
+
+ConfigImageButton buttonRecord(const ButtonConfig& button, ImageWriter& writer) {
+    ConfigImageButton rec{};
+    rec.id = writer.str(button.id);
+    rec.label = writer.str(button.label);
+    rec.color = writer.str(button.color);
+    rec.pressed_color = writer.str(button.pressed_color);
+    rec.text_color = writer.str(button.text_color);
+    rec.icon = writer.str(button.icon);
+    rec.font_family = writer.str(button.font_family);
+    rec.font_weight = writer.str(button.font_weight);
+    rec.font_name = writer.str(button.font_name);
+    rec.text_align = writer.str(button.text_align);
+    rec.border_color = writer.str(button.border_color);
+    rec.sequence = writer.str(button.sequence);
+    rec.sequence_off = writer.str(button.sequence_off);
+    rec.module = writer.str(button.module);
+    rec.can = frameRecord(button.can);
+    rec.can_off = frameRecord(button.can_off);
+    rec.row = button.row;
+    rec.col = button.col;
+    rec.row_span = button.row_span;
+    rec.col_span = button.col_span;
+    rec.momentary = button.momentary;
+    rec.font_size = button.font_size;
+    rec.corner_radius = button.corner_radius;
+    rec.border_width = button.border_width;
+    rec.module_output = button.module_output;
+    return rec;
+}
+
+ConfigImageMessage messageRecord(const CanMessage& msg, ImageWriter& writer) {
+    ConfigImageMessage rec{};
+    rec.id = writer.str(msg.id);
+    rec.name = writer.str(msg.name);
+    rec.description = writer.str(msg.description);
+    rec.pgn = msg.pgn;
+    rec.priority = msg.priority;
+    rec.source_address = msg.source_address;
+    rec.destination_address = msg.destination_address;
+    copyBytes(rec.data, msg.data);
+    return rec;
+}
+
+ConfigImageSequence sequenceRecord(const CanSequenceConfig& seq, ImageWriter& writer) {
+    ConfigImageSequence rec{};
+    rec.id = writer.str(seq.id);
+    rec.name = writer.str(seq.name);
+    rec.overlap = writer.str(seq.overlap);
+    rec.group = writer.str(seq.group);
+    rec.start_delay_ms = seq.start_delay_ms;
+    return rec;
+}
+
+ConfigImageStep stepRecord(const CanSequenceStep& step, ImageWriter& writer) {
+    ConfigImageStep rec{};
+    rec.condition = writer.str(step.condition);
+    rec.pgn = step.pgn;
+    rec.delay_ms = step.delay_ms;
+    rec.priority = step.priority;
+    rec.source_address = step.source_address;
+    rec.destination_address = step.destination_address;
+    rec.length = step.length;
+    copyBytes(rec.data, step.data);
+    return rec;
+}
+
+ConfigImagePeriodic periodicRecord(const CanPeriodicConfig& entry, ImageWriter& writer) {
+    ConfigImagePeriodic rec{};
+    rec.id = writer.str(entry.id);
+    rec.name = writer.str(entry.name);
+    rec.pgn = entry.pgn;
+    rec.period_ms = entry.period_ms;
+    rec.phase_ms = entry.phase_ms;
+    rec.enabled = entry.enabled;
+    rec.priority = entry.priority;
+    rec.source_address = entry.source_address;
+    rec.destination_address = entry.destination_address;
+    rec.length = entry.length;
+    copyBytes(rec.data, entry.data);
+    return rec;
+}
+
+ConfigImageSignal signalRecord(const CanSignalConfig& signal, ImageWriter& writer) {
+    ConfigImageSignal rec{};
+    rec.name = writer.str(signal.name);
+    rec.unit = writer.str(signal.unit);
+    rec.pgn = signal.pgn;
+    rec.scale = signal.scale;
+    rec.offset = signal.offset;
+    rec.source_address = signal.source_address;
+    rec.start_bit = signal.start_bit;
+    rec.length = signal.length;
+    rec.little_endian = signal.little_endian;
+    rec.is_signed = signal.is_signed;
+    return rec;
+}
+
+ConfigImageModule moduleRecord(const CanModuleConfig& module, ImageWriter& writer) {
+    ConfigImageModule rec{};
+    rec.id = writer.str(module.id);
+    rec.name = writer.str(module.name);
+    rec.type = writer.str(module.type);
+    rec.poll_interval_ms = module.poll_interval_ms;
+    rec.address = module.address;
+    return rec;
+}
+
+ConfigImageFont fontRecord(const FontConfig& font, ImageWriter& writer) {
+    ConfigImageFont rec{};
+    rec.name = writer.str(font.name);
+    rec.display_name = writer.str(font.display_name);
+    rec.size = font.size;
+    return rec;
+}
+
+// Each record type encoded from its default-constructed config struct. The decoder starts every record
+// from one of these before reading, so fields a shorter record from an older writer lacks keep the
+// struct's defaults, strings included
+struct RecordDefaults {
+    ConfigImageDevice device;
+    ConfigImagePage page;
+    ConfigImageButton button;
+    ConfigImageMessage message;
+    ConfigImageSequence sequence;
+    ConfigImageStep step;
+    ConfigImagePeriodic periodic;
+    ConfigImageSignal signal;
+    ConfigImageModule module;
+    ConfigImageFont font;
+};
+
+const RecordDefaults& recordDefaults() {
+    static const RecordDefaults defaults = [] {
+        ImageWriter writer = ImageWriter::unsetStrings();
+        RecordDefaults out;
+        out.device = deviceRecord(DeviceConfig{}, writer);
+        out.page = pageRecord(PageConfig{}, writer);
+        out.button = buttonRecord(ButtonConfig{}, writer);
+        out.message = messageRecord(CanMessage{}, writer);
+        out.sequence = sequenceRecord(CanSequenceConfig{}, writer);
+        out.step = stepRecord(CanSequenceStep{}, writer);
+        out.periodic = periodicRecord(CanPeriodicConfig{}, writer);
+        out.signal = signalRecord(CanSignalConfig{}, writer);
+        out.module = moduleRecord(CanModuleConfig{}, writer);
+        out.font = fontRecord(FontConfig{}, writer);
+        return out;
+    }();
+    return defaults;
+}
+
+// A child range (buttons of a page, steps of a sequence) must lie inside its section
+bool rangeValid(std::uint32_t first, std::uint32_t count, std::size_t total) {
+    return first <= total && count <= total - first;
+}
+}
+
+bool ConfigImage::open(const std::uint8_t* data, std::size_t size, std::string& error) {
+    data_ = nullptr;
+    ConfigImageHeader header;
+    if (!data || size < sizeof(header)) {
+        error = "Config image truncated";
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != kConfigImageMagic) {
+        error = "Not a config image";
+        return false;
+    }
+    if (header.version != kConfigImageVersion) {
+        error = "Unsupported config image version " + std::to_string(header.version);
+        return false;
+    }
+    if (header.size != size ||
+        size < sizeof(header) + static_cast<std::size_t>(header.section_count) * sizeof(ConfigImageSection)) {
+        error = "Config image truncated";
+        return false;
+    }
+    if (canLogCrc32(data + sizeof(header), size - sizeof(header)) != header.crc) {
+        error = "Config image CRC mismatch";
+        return false;
+    }
+
+    const auto* table = reinterpret_cast<const ConfigImageSection*>(data + sizeof(header));
+    for (std::uint16_t i = 0; i < header.section_count; ++i) {
+        const ConfigImageSection& entry = table[i];
+        const std::uint64_t end = entry.offset + static_cast<std::uint64_t>(entry.record_size) * entry.count;
+        if (entry.record_size == 0 || end > size) {
+            error = "Config image section " + std::to_string(entry.id) + " out of bounds";
+            return false;
+        }
+    }
+
+    data_ = data;
+    size_ = size;
+    version_ = header.version;
+    table_ = table;
+    section_count_ = header.section_count;
+    const ConfigImageSection* strings = find(ConfigSection::STRINGS);
+    if (!strings || strings->count == 0 || data[strings->offset + strings->count - 1] != '\0') {
+        data_ = nullptr;
+        error = "Config image has no string table";
+        return false;
+    }
+    strings_ = reinterpret_cast<const char*>(data + strings->offset);
+    strings_size_ = strings->count;
+    return true;
+}
+
+const ConfigImageSection* ConfigImage::find(ConfigSection section) const {
+    if (!data_) {
+        return nullptr;
+    }
+    for (std::uint16_t i = 0; i < section_count_; ++i) {
+        if (table_[i].id == static_cast<std::uint16_t>(section)) {
+            return &table_[i];
+        }
+    }
+    return nullptr;
+}
+
+std::size_t ConfigImage::count(ConfigSection section) const {
+    const ConfigImageSection* entry = find(section);
+    return entry ? entry->count : 0;
+}
+
+std::string_view ConfigImage::string(const ConfigImageString& ref) const {
+    if (ref.offset >= strings_size_ || ref.length >= strings_size_ - ref.offset) {
+        return std::string_view();
+    }
+    return std::string_view(strings_ + ref.offset, ref.length);
+}
+
+void encodeConfigImage(const DeviceConfig& config, std::vector<std::uint8_t>& out, const ConfigImage* previous) {
+    ImageWriter writer = previous && !previous->strings().empty() ? ImageWriter(previous->strings()) : ImageWriter();
+    const ConfigImageDevice device = deviceRecord(config, writer);
+    writer.add(ConfigSection::DEVICE, &device, sizeof(device), 1);
+
+    std::vector<ConfigImagePage> pages;
+    std::vector<ConfigImageButton> buttons;
+    pages.reserve(config.pages.size());
+    for (const PageConfig& page : config.pages) {
+        ConfigImagePage rec = pageRecord(page, writer);
+        rec.first_button = static_cast<std::uint32_t>(buttons.size());
+        rec.button_count = static_cast<std::uint32_t>(page.buttons.size());
+        pages.push_back(rec);
+
+        for (const ButtonConfig& button : page.buttons) {
+            buttons.push_back(buttonRecord(button, writer));
+        }
+    }
+    writer.add(ConfigSection::PAGES, pages);
+    writer.add(ConfigSection::BUTTONS, buttons);
+
+    std::vector<ConfigImageMessage> messages;
+    messages.reserve(config.can_library.size());
+    for (const CanMessage& msg : config.can_library) {
+        messages.push_back(messageRecord(msg, writer));
+    }
+    writer.add(ConfigSection::CAN_LIBRARY, messages);
+
+    std::vector<ConfigImageSequence> sequences;
+    std::vector<ConfigImageStep> steps;
+    sequences.reserve(config.can_sequences.size());
+    for (const CanSequenceConfig& seq : config.can_sequences) {
+        ConfigImageSequence rec = sequenceRecord(seq, writer);
+        rec.first_step = static_cast<std::uint32_t>(steps.size());
+        rec.step_count = static_cast<std::uint32_t>(seq.steps.size());
+        sequences.push_back(rec);
+
+        for (const CanSequenceStep& step : seq.steps) {
+            steps.push_back(stepRecord(step, writer));
+        }
+    }
+    writer.add(ConfigSection::SEQUENCES, sequences);
+    writer.add(ConfigSection::SEQUENCE_STEPS, steps);
+
+    std::vector<ConfigImagePeriodic> periodic;
+    periodic.reserve(config.can_periodic.size());
+    for (const CanPeriodicConfig& entry : config.can_periodic) {
+        periodic.push_back(periodicRecord(entry, writer));
+    }
+    writer.add(ConfigSection::PERIODIC, periodic);
+
+    std::vector<ConfigImageSignal> signals;
+    signals.reserve(config.can_signals.size());
+    for (const CanSignalConfig& signal : config.can_signals) {
+        signals.push_back(signalRecord(signal, writer));
+    }
+    writer.add(ConfigSection::SIGNALS, signals);
+
+    std::vector<ConfigImageModule> modules;
+    modules.reserve(config.can_modules.size());
+    for (const CanModuleConfig& module : config.can_modules) {
+        modules.push_back(moduleRecord(module, writer));
+    }
+    writer.add(ConfigSection::MODULES, modules);
+
+    writer.add(ConfigSection::FILTER_PGNS, config.can_filter.extra_pgns);
+
+    std::vector<ConfigImageFont> fonts;
+    fonts.reserve(config.available_fonts.size());
+    for (const FontConfig& font : config.available_fonts) {
+        fonts.push_back(fontRecord(font, writer));
+    }
+    writer.add(ConfigSection::FONTS, fonts);
+
+    writer.finish(out);
+}
+
+bool decodeConfigImage(const ConfigImage& image, DeviceConfig& config, std::string& error) {
+    auto text = [&image](std::string& target, const ConfigImageString& ref) { readText(image, target, ref); };
+    const RecordDefaults& defaults = recordDefaults();
+
+    ConfigImageDevice device = defaults.device;
+    if (!image.read(ConfigSection::DEVICE, 0, device)) {
+        error = "Config image has no device record";
+        return false;
+    }
+    const std::size_t page_count = image.count(ConfigSection::PAGES);
+    const std::size_t button_total = image.count(ConfigSection::BUTTONS);
+    const std::size_t sequence_count = image.count(ConfigSection::SEQUENCES);
+    const std::size_t step_total = image.count(ConfigSection::SEQUENCE_STEPS);
+    if (page_count > MAX_PAGES || sequence_count > MAX_CAN_SEQUENCES ||
+        image.count(ConfigSection::PERIODIC) > MAX_CAN_PERIODIC ||
+        image.count(ConfigSection::SIGNALS) > MAX_CAN_SIGNALS ||
+        image.count(ConfigSection::MODULES) > MAX_CAN_MODULES) {
+        error = "Config image exceeds configuration limits";
+        return false;
+    }
+
+    DeviceConfig result;
+    readDevice(image, device, result);
+
+    result.pages.resize(page_count);
+    for (std::size_t i = 0; i < page_count; ++i) {
+        ConfigImagePage rec = defaults.page;
+        image.read(ConfigSection::PAGES, i, rec);
+        if (rec.button_count > MAX_BUTTONS_PER_PAGE || !rangeValid(rec.first_button, rec.button_count, button_total)) {
+            error = "Config image page " + std::to_string(i) + " has a bad button range";
+            return false;
+        }
+        PageConfig& page = result.pages[i];
+        text(page.id, rec.id);
+        text(page.name, rec.name);
+        text(page.nav_text, rec.nav_text);
+        text(page.nav_color, rec.nav_color);
+        text(page.nav_inactive_color, rec.nav_inactive_color);
+        text(page.nav_text_color, rec.nav_text_color);
+        text(page.bg_color, rec.bg_color);
+        text(page.text_color, rec.text_color);
+        text(page.button_color, rec.button_color);
+        text(page.button_pressed_color, rec.button_pressed_color);
+        text(page.button_border_color, rec.button_border_color);
+        page.nav_button_radius = rec.nav_button_radius;
+        page.button_border_width = rec.button_border_width;
+        page.button_radius = rec.button_radius;
+        page.rows = rec.rows;
+        page.cols = rec.cols;
+
+        page.buttons.resize(rec.button_count);
+        for (std::uint32_t b = 0; b < rec.button_count; ++b) {
+            ConfigImageButton btn = defaults.button;
+            image.read(ConfigSection::BUTTONS, rec.first_button + b, btn);
+            ButtonConfig& button = page.buttons[b];
+            text(button.id, btn.id);
+            text(button.label, btn.label);
+            text(button.color, btn.color);
+            text(button.pressed_color, btn.pressed_color);
+            text(button.text_color, btn.text_color);
+            text(button.icon, btn.icon);
+            text(button.font_family, btn.font_family);
+            text(button.font_weight, btn.font_weight);
+            text(button.font_name, btn.font_name);
+            text(button.text_align, btn.text_align);
+            text(button.border_color, btn.border_color);
+            text(button.sequence, btn.sequence);
+            text(button.sequence_off, btn.sequence_off);
+            text(button.module, btn.module);
+            readFrame(btn.can, button.can);
+            readFrame(btn.can_off, button.can_off);
+            button.row = btn.row;
+            button.col = btn.col;
+            button.row_span = btn.row_span;
+            button.col_span = btn.col_span;
+            button.momentary = btn.momentary != 0;
+            button.font_size = btn.font_size;
+            button.corner_radius = btn.corner_radius;
+            button.border_width = btn.border_width;
+            button.module_output = btn.module_output;
+        }
+    }
+
+    result.can_library.resize(image.count(ConfigSection::CAN_LIBRARY));
+    for (std::size_t i = 0; i < result.can_library.size(); ++i) {
+        ConfigImageMessage rec = defaults.message;
+        image.read(ConfigSection::CAN_LIBRARY, i, rec);
+        CanMessage& msg = result.can_library[i];
+        text(msg.id, rec.id);
+        text(msg.name, rec.name);
+        text(msg.description, rec.description);
+        msg.pgn = rec.pgn;
+        msg.priority = rec.priority;
+        msg.source_address = rec.source_address;
+        msg.destination_address = rec.destination_address;
+        copyBytes(msg.data, rec.data);
+    }
+
+    result.can_sequences.resize(sequence_count);
+    for (std::size_t i = 0; i < sequence_count; ++i) {
+        ConfigImageSequence rec = defaults.sequence;
+        image.read(ConfigSection::SEQUENCES, i, rec);
+        if (rec.step_count > MAX_CAN_SEQUENCE_STEPS || !rangeValid(rec.first_step, rec.step_count, step_total)) {
+            error = "Config image sequence " + std::to_string(i) + " has a bad step range";
+            return false;
+        }
+        CanSequenceConfig& seq = result.can_sequences[i];
+        text(seq.id, rec.id);
+        text(seq.name, rec.name);
+        text(seq.overlap, rec.overlap);
+        text(seq.group, rec.group);
+        seq.start_delay_ms = rec.start_delay_ms;
+        seq.steps.resize(rec.step_count);
+        for (std::uint32_t s = 0; s < rec.step_count; ++s) {
+            ConfigImageStep srec = defaults.step;
+            image.read(ConfigSection::SEQUENCE_STEPS, rec.first_step + s, srec);
+            CanSequenceStep& step = seq.steps[s];
+            text(step.condition, srec.condition);
+            step.pgn = srec.pgn;
+            step.delay_ms = srec.delay_ms;
+            step.priority = srec.priority;
+            step.source_address = srec.source_address;
+            step.destination_address = srec.destination_address;
+            step.length = std::min<std::uint8_t>(srec.length, 8);
+            copyBytes(step.data, srec.data);
+        }
+    }
+
+    result.can_periodic.resize(image.count(ConfigSection::PERIODIC));
+    for (std::size_t i = 0; i < result.can_periodic.size(); ++i) {
+        ConfigImagePeriodic rec = defaults.periodic;
+        image.read(ConfigSection::PERIODIC, i, rec);
+        CanPeriodicConfig& entry = result.can_periodic[i];
+        text(entry.id, rec.id);
+        text(entry.name, rec.name);
+        entry.pgn = rec.pgn;
+        entry.period_ms = rec.period_ms;
+        entry.phase_ms = rec.phase_ms;
+        entry.enabled = rec.enabled != 0;
+        entry.priority = rec.priority;
+        entry.source_address = rec.source_address;
+        entry.destination_address = rec.destination_address;
+        entry.length = std::min<std::uint8_t>(rec.length, 8);
+        copyBytes(entry.data, rec.data);
+    }
+
+    result.can_signals.resize(image.count(ConfigSection::SIGNALS));
+    for (std::size_t i = 0; i < result.can_signals.size(); ++i) {
+        ConfigImageSignal rec = defaults.signal;
+        image.read(ConfigSection::SIGNALS, i, rec);
+        CanSignalConfig& signal = result.can_signals[i];
+        text(signal.name, rec.name);
+        text(signal.unit, rec.unit);
+        signal.pgn = rec.pgn;
+        signal.scale = rec.scale;
+        signal.offset = rec.offset;
+        signal.source_address = rec.source_address;
+        signal.start_bit = rec.start_bit;
+        signal.length = rec.length;
+        signal.little_endian = rec.little_endian != 0;
+        signal.is_signed = rec.is_signed != 0;
+    }
+
+    result.can_modules.resize(image.count(ConfigSection::MODULES));
+    for (std::size_t i = 0; i < result.can_modules.size(); ++i) {
+        ConfigImageModule rec = defaults.module;
+        image.read(ConfigSection::MODULES, i, rec);
+        CanModuleConfig& module = result.can_modules[i];
+        text(module.id, rec.id);
+        text(module.name, rec.name);
+        text(module.type, rec.type);
+        module.poll_interval_ms = rec.poll_interval_ms;
+        module.address = rec.address;
+    }
+
+    result.can_filter.extra_pgns.resize(image.count(ConfigSection::FILTER_PGNS));
+    for (std::size_t i = 0; i < result.can_filter.extra_pgns.size(); ++i) {
+        image.read(ConfigSection::FILTER_PGNS, i, result.can_filter.extra_pgns[i]);
+    }
+
+    result.available_fonts.resize(image.count(ConfigSection::FONTS));
+    for (std::size_t i = 0; i < result.available_fonts.size(); ++i) {
+        ConfigImageFont rec = defaults.font;
+        image.read(ConfigSection::FONTS, i, rec);
+        FontConfig& font = result.available_fonts[i];
+        text(font.name, rec.name);
+        text(font.display_name, rec.display_name);
+        font.size = rec.size;
+    }
+
+    config = std::move(result);
+    return true;
+}
@@ -0,0 +1,340 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "config_types.h"
+
+// Binary configuration image (/config.bin), little-endian.
+//
+// One header, a section table, then the sections, each 4-byte aligned. A
+// section is an array of fixed-size records; strings live once in the
+// STRINGS section (NUL terminated, so they can be used in place) and records
+// refer to them by offset. Nothing is parsed: a loader checks the header and
+// CRC and reads records straight out of the file buffer.
+//
+// Compatibility: records carry their size in the section table. Fields are
+// only ever appended. The reader starts every record from one encoded from
+// the default-constructed config struct, so fields an older writer did not
+// have come out at the struct's defaults (strings included).
+// kConfigImageVersion only changes when an existing field changes meaning.
+struct ConfigImageHeader {
+    std::uint32_t magic;          // kConfigImageMagic
+    std::uint16_t version;        // kConfigImageVersion
+    std::uint16_t section_count;  // Entries in the table that follows
+    std::uint32_t size;           // Whole image, header included
+    std::uint32_t crc;            // CRC-32 (zlib) of everything after the header
+};
+static_assert(sizeof(ConfigImageHeader) == 16, "ConfigImageHeader is part of the file format");
+
+struct ConfigImageSection {
+    std::uint16_t id;           // ConfigSection
+    std::uint16_t record_size;
+    std::uint32_t count;
+    std::uint32_t offset;       // From the start of the image
+};
+static_assert(sizeof(ConfigImageSection) == 12, "ConfigImageSection is part of the file format");
+
+enum class ConfigSection : std::uint16_t {
+    DEVICE = 1,      // One ConfigImageDevice
+    PAGES,           // ConfigImagePage
+    BUTTONS,         // ConfigImageButton, page after page
+    CAN_LIBRARY,     // ConfigImageMessage
+    SEQUENCES,       // ConfigImageSequence
+    SEQUENCE_STEPS,  // ConfigImageStep, sequence after sequence
+    PERIODIC,        // ConfigImagePeriodic
+    SIGNALS,         // ConfigImageSignal
+    MODULES,         // ConfigImageModule
+    FILTER_PGNS,     // std::uint32_t
+    FONTS,           // ConfigImageFont
+    STRINGS,         // Bytes
+};
+
+constexpr std::uint32_t kConfigImageMagic = 0x42474643;  // "CFGB"
+constexpr std::uint16_t kConfigImageVersion = 1;
+
+struct ConfigImageString {
+    std::uint32_t offset;  // Into the STRINGS section
+    std::uint32_t length;  // Without the terminating NUL
+};
+
+struct ConfigImageFrame {
+    std::uint32_t pgn;
+    std::uint8_t enabled;
+    std::uint8_t priority;
+    std::uint8_t source_address;
+    std::uint8_t destination_address;
+    std::uint8_t length;
+    std::uint8_t reserved[3];
+    std::uint8_t data[8];
+};
+static_assert(sizeof(ConfigImageFrame) == 20, "ConfigImageFrame is part of the file format");
+
+struct ConfigImageDevice {
+    ConfigImageString version;
+    ConfigImageString title;
+    ConfigImageString subtitle;
+    ConfigImageString logo_variant;
+    ConfigImageString logo_base64;
+    ConfigImageString title_font;
+    ConfigImageString subtitle_font;
+    ConfigImageString title_align;
+    ConfigImageString logo_position;
+    ConfigImageString sleep_icon_base64;
+    ConfigImageString header_logo;
+    ConfigImageString splash_logo;
+    ConfigImageString background_image;
+    ConfigImageString sleep_logo;
+    ConfigImageString bg_color;
+    ConfigImageString surface_color;
+    ConfigImageString page_bg_color;
+    ConfigImageString accent_color;
+    ConfigImageString text_primary;
+    ConfigImageString text_secondary;
+    ConfigImageString border_color;
+    ConfigImageString header_border_color;
+    ConfigImageString nav_button_color;
+    ConfigImageString nav_button_active_color;
+    ConfigImageString nav_button_text_color;
+    ConfigImageString ap_ssid;
+    ConfigImageString ap_password;
+    ConfigImageString sta_ssid;
+    ConfigImageString sta_password;
+    ConfigImageString ota_manifest_url;
+    ConfigImageString ota_channel;
+    std::uint32_t can_bitrate;
+    std::uint32_t recorder_max_segment_kb;
+    std::uint32_t recorder_max_total_kb;
+    std::uint32_t recorder_flush_interval_ms;
+    std::uint32_t j1939_identity_number;
+    std::uint16_t logo_target_height;
+    std::uint16_t sleep_timeout_seconds;
+    std::uint16_t coalesce_duplicate_window_ms;
+    std::uint16_t coalesce_min_spacing_ms;
+    std::uint16_t j1939_manufacturer_code;
+    std::uint8_t show_logo;
+    std::uint8_t logo_preserve_aspect;
+    std::uint8_t nav_spacing;
+    std::uint8_t brightness;
+    std::uint8_t sleep_enabled;
+    std::uint8_t nav_button_radius;
+    std::uint8_t button_radius;
+    std::uint8_t border_width;
+    std::uint8_t header_border_width;
+    std::uint8_t ap_enabled;
+    std::uint8_t sta_enabled;
+    std::uint8_t ota_enabled;
+    std::uint8_t can_auto_baud;
+    std::uint8_t coalesce_enabled;
+    std::uint8_t filter_enabled;
+    std::uint8_t recorder_enabled;
+    std::uint8_t j1939_address_claim;
+    std::uint8_t j1939_preferred_address;
+    std::uint8_t j1939_address_min;
+    std::uint8_t j1939_address_max;
+    std::uint8_t j1939_arbitrary_address_capable;
+    std::uint8_t j1939_industry_group;
+    std::uint8_t j1939_vehicle_system;
+    std::uint8_t j1939_vehicle_system_instance;
+    std::uint8_t j1939_function;
+    std::uint8_t j1939_function_instance;
+    std::uint8_t j1939_ecu_instance;
+    std::uint8_t reserved[3];
+};
+static_assert(sizeof(ConfigImageDevice) == 308, "ConfigImageDevice is part of the file format");
+
+struct ConfigImagePage {
+    ConfigImageString id;
+    ConfigImageString name;
+    ConfigImageString nav_text;
+    ConfigImageString nav_color;
+    ConfigImageString nav_inactive_color;
+    ConfigImageString nav_text_color;
+    ConfigImageString bg_color;
+    ConfigImageString text_color;
+    ConfigImageString button_color;
+    ConfigImageString button_pressed_color;
+    ConfigImageString button_border_color;
+    std::uint32_t first_button;  // Index into BUTTONS
+    std::uint32_t button_count;
+    std::int16_t nav_button_radius;
+    std::uint8_t button_border_width;
+    std::uint8_t button_radius;
+    std::uint8_t rows;
+    std::uint8_t cols;
+    std::uint8_t reserved[2];
+};
+static_assert(sizeof(ConfigImagePage) == 104, "ConfigImagePage is part of the file format");
+
+struct ConfigImageButton {
+    ConfigImageString id;
+    ConfigImageString label;
+    ConfigImageString color;
+    ConfigImageString pressed_color;
+    ConfigImageString text_color;
+    ConfigImageString icon;
+    ConfigImageString font_family;
+    ConfigImageString font_weight;
+    ConfigImageString font_name;
+    ConfigImageString text_align;
+    ConfigImageString border_color;
+    ConfigImageString sequence;
+    ConfigImageString sequence_off;
+    ConfigImageString module;
+    ConfigImageFrame can;
+    ConfigImageFrame can_off;
+    std::uint8_t row;
+    std::uint8_t col;
+    std::uint8_t row_span;
+    std::uint8_t col_span;
+    std::uint8_t momentary;
+    std::uint8_t font_size;
+    std::uint8_t corner_radius;
+    std::uint8_t border_width;
+    std::uint8_t module_output;
+    std::uint8_t reserved[3];
+};
+static_assert(sizeof(ConfigImageButton) == 164, "ConfigImageButton is part of the file format");
+
+struct ConfigImageMessage {
+    ConfigImageString id;
+    ConfigImageString name;
+    ConfigImageString description;
+    std::uint32_t pgn;
+    std::uint8_t priority;
+    std::uint8_t source_address;
+    std::uint8_t destination_address;
+    std::uint8_t reserved;
+    std::uint8_t data[8];
+};
+static_assert(sizeof(ConfigImageMessage) == 40, "ConfigImageMessage is part of the file format");
+
+struct ConfigImageSequence {
+    ConfigImageString id;
+    ConfigImageString name;
+    ConfigImageString overlap;
+    ConfigImageString group;
+    std::uint32_t first_step;  // Index into SEQUENCE_STEPS
+    std::uint32_t step_count;
+    std::uint16_t start_delay_ms;
+    std::uint8_t reserved[2];
+};
+static_assert(sizeof(ConfigImageSequence) == 44, "ConfigImageSequence is part of the file format");
+
+struct ConfigImageStep {
+    ConfigImageString condition;
+    std::uint32_t pgn;
+    std::uint16_t delay_ms;
+    std::uint8_t priority;
+    std::uint8_t source_address;
+    std::uint8_t destination_address;
+    std::uint8_t length;
+    std::uint8_t reserved[2];
+    std::uint8_t data[8];
+};
+static_assert(sizeof(ConfigImageStep) == 28, "ConfigImageStep is part of the file format");
+
+struct ConfigImagePeriodic {
+    ConfigImageString id;
+    ConfigImageString name;
+    std::uint32_t pgn;
+    std::uint32_t period_ms;
+    std::int32_t phase_ms;
+    std::uint8_t enabled;
+    std::uint8_t priority;
+    std::uint8_t source_address;
+    std::uint8_t destination_address;
+    std::uint8_t length;
+    std::uint8_t reserved[3];
+    std::uint8_t data[8];
+};
+static_assert(sizeof(ConfigImagePeriodic) == 44, "ConfigImagePeriodic is part of the file format");
+
+struct ConfigImageSignal {
+    ConfigImageString name;
+    ConfigImageString unit;
+    std::uint32_t pgn;
+    float scale;
+    float offset;
+    std::uint8_t source_address;
+    std::uint8_t start_bit;
+    std::uint8_t length;
+    std::uint8_t little_endian;
+    std::uint8_t is_signed;
+    std::uint8_t reserved[3];
+};
+static_assert(sizeof(ConfigImageSignal) == 36, "ConfigImageSignal is part of the file format");
+
+struct ConfigImageModule {
+    ConfigImageString id;
+    ConfigImageString name;
+    ConfigImageString type;
+    std::uint32_t poll_interval_ms;
+    std::uint8_t address;
+    std::uint8_t reserved[3];
+};
+static_assert(sizeof(ConfigImageModule) == 32, "ConfigImageModule is part of the file format");
+
+struct ConfigImageFont {
+    ConfigImageString name;
+    ConfigImageString display_name;
+    std::uint8_t size;
+    std::uint8_t reserved[3];
+};
+static_assert(sizeof(ConfigImageFont) == 20, "ConfigImageFont is part of the file format");
+
+/**
+ * Read-only view of an image in memory. open() validates the header, CRC and
+ * section bounds once; after that records are copied out with read() and
+ * strings are returned as views into the buffer, so the buffer must outlive
+ * the view.
+ */
+class ConfigImage {
+public:
+    bool open(const std::uint8_t* data, std::size_t size, std::string& error);
+
+    std::uint16_t version() const { return version_; }
+    std::size_t count(ConfigSection section) const;
+
+    // Copies record `index`; a shorter record from an older writer leaves the remaining fields of `out` alone
+    template <typename T>
+    bool read(ConfigSection section, std::size_t index, T& out) const {
+        static_assert(std::is_trivially_copyable<T>::value, "image records are plain data");
+        const ConfigImageSection* entry = find(section);
+        if (!entry || index >= entry->count) {
+            return false;
+        }
+        const std::size_t bytes = entry->record_size < sizeof(T) ? entry->record_size : sizeof(T);
+        std::memcpy(&out, data_ + entry->offset + index * entry->record_size, bytes);
+        return true;
+    }
+
+    // Empty for a reference outside the STRINGS section
+    std::string_view string(const ConfigImageString& ref) const;
+    // The whole STRINGS section, terminating NULs included
+    std::string_view strings() const { return std::string_view(strings_, strings_size_); }
+
+private:
+    const ConfigImageSection* find(ConfigSection section) const;
+
+    const std::uint8_t* data_ = nullptr;
+    std::size_t size_ = 0;
+    std::uint16_t version_ = 0;
+    const ConfigImageSection* table_ = nullptr;
+    std::uint16_t section_count_ = 0;
+    const char* strings_ = nullptr;
+    std::size_t strings_size_ = 0;
+};
+
+// Replaces `out` with the image of `config`; each distinct string is stored once. With `previous`, its
+// string table is kept as is (unused strings included) and new strings go on the end, so an edit only
+// changes the bytes it touched; that is what keeps config journal records small (config_journal.h).
+void encodeConfigImage(const DeviceConfig& config, std::vector<std::uint8_t>& out,
+                       const ConfigImage* previous = nullptr);
+// Replaces `config` with the image's contents
+bool decodeConfigImage(const ConfigImage& image, DeviceConfig& config, std::string& error);
@@ -6,9 +6,21 @@
 #include <string>
 #include <vector>
 
+#include "psram_alloc.h"
+
 // Limits that align with the documentation
 constexpr std::size_t MAX_PAGES = 20;
 constexpr std::size_t MAX_BUTTONS_PER_PAGE = 12;
+constexpr std::size_t MAX_CAN_SEQUENCES = 32;
+constexpr std::size_t MAX_CAN_SEQUENCE_STEPS = 16;  // Per sequence
+constexpr std::size_t MAX_CAN_PERIODIC = 64;
+constexpr std::size_t MAX_CAN_SIGNALS = 128;
+constexpr std::size_t MAX_CAN_MODULES = 16;
+
+// Pages and their buttons are most of a config (a ButtonConfig is about 400 bytes on the
+// device), so their storage lives in PSRAM rather than internal RAM
+template <typename T>
+using ConfigList = std::vector<T, PsramAllocator<T>>;
 
 constexpr const char kOtaManifestUrl[] =
     "https://image-optimizer-still-flower-1282.fly.dev/ota/manifest";
@@ -17,7 +29,7 @@ struct CanFrameConfig {
     bool enabled = false;
     std::uint32_t pgn = 0x00FF00;  // Default to proprietary B frame
     std::uint8_t priority = 3;
-    std::uint8_t source_address = 0x80;
+    std::uint8_t source_address = 0x80;       // Ignored on transmit: frames go out under the j1939 address
     std::uint8_t destination_address = 0xFF;  // Broadcast by default
     std::array<std::uint8_t, 8> data{};
     std::uint8_t length = 0;  // Actual number of data bytes to transmit (0-8)
@@ -45,6 +57,10 @@ struct ButtonConfig {
     std::string border_color = "#FFFFFF";  // Button border color
     CanFrameConfig can;
     CanFrameConfig can_off;  // Optional OFF/release frame (used by some modules like inMOTION NGX)
+    std::string sequence = "";      // Optional CAN sequence id run instead of the single frame
+    std::string sequence_off = "";  // Optional sequence id run on release (momentary buttons)
+    std::string module = "";           // Optional can_modules id whose output state the button shows
+    std::uint8_t module_output = 0;    // 1-based output on that module (0 = not linked)
 };
 
 struct PageConfig {
@@ -64,7 +80,7 @@ struct PageConfig {
     std::uint8_t button_radius = 0;          // Optional per-page radius (0 means inherit)
     std::uint8_t rows = 2;
     std::uint8_t cols = 2;
-    std::vector<ButtonConfig> buttons;
+    ConfigList<ButtonConfig> buttons;
 };
 
 struct FontConfig {
@@ -103,7 +119,7 @@ struct HeaderConfig {
     std::string subtitle = "Configuration Interface";
     bool show_logo = true;
     std::string logo_variant = "";  // Empty by default - custom logos only
-    std::string logo_base64 = "";  // Custom uploaded logo (base64 encoded image)
+    std::string logo_base64 = "";  // Legacy custom logo; an asset reference once migrated
     std::string title_font = "montserrat_24";
     std::string subtitle_font = "montserrat_12";
     std::string title_align = "center";  // "left", "center", "right"
@@ -113,11 +129,12 @@ struct HeaderConfig {
     std::uint8_t nav_spacing = 12;           // Gap between header and nav (px)
 };
 
+// "asset:<id>" references into the asset store (asset_store.h); the images themselves are not in the config
 struct ImageAssets {
-    std::string header_logo = "";      // Header logo (max 48x36, PNG with alpha)
-    std::string splash_logo = "";      // Splash screen logo (max 400x300, PNG with alpha)
-    std::string background_image = ""; // Background image (800x480, JPG or PNG)
-    std::string sleep_logo = "";       // Sleep overlay logo (max 200x150, PNG with alpha)
+    std::string header_logo = "";      // Header logo (rgb565a pixels)
+    std::string splash_logo = "";      // Splash screen logo (max 400x300, JPEG)
+    std::string background_image = ""; // Background image (max 400x240, JPEG)
+    std::string sleep_logo = "";       // Sleep overlay logo (max 150x113, rgb565a pixels)
 };
 
 struct DisplayConfig {
@@ -150,12 +167,109 @@ struct CanMessage {
     std::string name = "Unnamed";
     std::uint32_t pgn = 0x00FF00;
     std::uint8_t priority = 3;
-    std::uint8_t source_address = 0x80;
+    std::uint8_t source_address = 0x80;  // Ignored on transmit (j1939 address); kept so saved configs load
     std::uint8_t destination_address = 0xFF;
     std::array<std::uint8_t, 8> data{};
     std::string description = "";
 };
 
+struct CanSequenceStep {
+    std::uint32_t pgn = 0x00FF01;
+    std::uint8_t priority = 6;
+    std::uint8_t source_address = 0x80;  // Ignored on transmit (j1939 address); kept so saved configs load
+    std::uint8_t destination_address = 0xFF;
+    std::array<std::uint8_t, 8> data{};
+    std::uint8_t length = 8;
+    std::uint16_t delay_ms = 10;             // Gap before the next step
+    std::string condition = "previous_ok";   // "previous_ok" aborts the run if this step can't be queued, "always" continues
+};
+
+struct CanSequenceConfig {
+    std::string id = "seq_0";
+    std::string name = "Sequence";
+    std::string overlap = "restart";  // Pressed again while running: "restart", "ignore" or "queue"
+    std::string group = "";           // Starting a sequence cancels running sequences in the same group
+    std::uint16_t start_delay_ms = 0;
+    std::vector<CanSequenceStep> steps;
+};
+
+struct CanPeriodicConfig {
+    std::string id = "periodic_0";
+    std::string name = "Periodic";
+    bool enabled = true;
+    std::uint32_t pgn = 0x00FF01;
+    std::uint8_t priority = 6;
+    std::uint8_t source_address = 0x80;  // Ignored on transmit (j1939 address); kept so saved configs load
+    std::uint8_t destination_address = 0xFF;
+    std::array<std::uint8_t, 8> data{};
+    std::uint8_t length = 8;
+    std::uint32_t period_ms = 1000;
+    std::int32_t phase_ms = -1;  // Offset of the first transmission; -1 lets the scheduler spread it
+};
+
+// DBC-style signal: start_bit follows DBC numbering (LSB for little endian, MSB for big endian)
+struct CanSignalConfig {
+    std::string name = "signal_0";
+    std::string unit = "";
+    std::uint32_t pgn = 0x00FF00;
+    std::uint8_t source_address = 0xFF;  // 0xFF decodes the PGN from any sender
+    std::uint8_t start_bit = 0;
+    std::uint8_t length = 8;
+    bool little_endian = true;           // J1939 signals are Intel byte order
+    bool is_signed = false;
+    float scale = 1.0f;
+    float offset = 0.0f;
+};
+
+// POWERCELL / inMOTION module whose outputs are tracked from its FF5x status replies
+struct CanModuleConfig {
+    std::string id = "module_0";
+    std::string name = "Module";
+    std::string type = "powercell";      // "powercell" (10 outputs) or "inmotion" (4 outputs)
+    std::uint8_t address = 1;            // 1-16: polled on PGN FF4x, replies on FF5x (address 16 uses x = 0)
+    std::uint32_t poll_interval_ms = 1000;  // 0 = listen only
+};
+
+struct CanRecorderConfig {
+    bool enabled = true;
+    std::uint32_t max_segment_kb = 256;      // Segment files rotate at this size
+    std::uint32_t max_total_kb = 1024;       // Oldest segments are deleted beyond this
+    std::uint32_t flush_interval_ms = 5000;  // Longest a partial block waits in RAM (data lost on reset)
+};
+
+struct CanBusConfig {
+    std::uint32_t bitrate = 250000;  // 125000, 250000, 500000 or 1000000
+    bool auto_baud = false;          // Listen for the bus rate at startup; bitrate is the fallback
+};
+
+// Debounce for button actions (see CanButtonCoalescer)
+struct CanCoalesceConfig {
+    bool enabled = true;
+    std::uint16_t duplicate_window_ms = 250;  // A button repeating its last command within this is dropped
+    std::uint16_t min_spacing_ms = 20;        // Gap between button frames on the same PGN
+};
+
+struct CanFilterConfig {
+    bool enabled = false;                   // Off keeps the bus monitor seeing every frame
+    std::vector<std::uint32_t> extra_pgns;  // Received PGNs not covered by can_library
+};
+
+struct J1939Config {
+    bool address_claim = true;              // Off uses preferred_address without claiming
+    std::uint8_t preferred_address = 0x80;
+    std::uint8_t address_min = 0x80;        // Self-configurable range used after losing a claim
+    std::uint8_t address_max = 0xF7;
+    bool arbitrary_address_capable = true;
+    std::uint8_t industry_group = 0;
+    std::uint8_t vehicle_system = 0;
+    std::uint8_t vehicle_system_instance = 0;
+    std::uint8_t function = 0;
+    std::uint8_t function_instance = 0;
+    std::uint8_t ecu_instance = 0;
+    std::uint16_t manufacturer_code = 0;
+    std::uint32_t identity_number = 0;      // 0 derives a unique number from the MAC address
+};
+
 struct DeviceConfig {
     std::string version = "1.0.0";
     WifiConfig wifi{};
@@ -164,7 +278,16 @@ struct DeviceConfig {
     ThemeConfig theme{};
     DisplayConfig display{};
     ImageAssets images{};
-    std::vector<PageConfig> pages;
+    ConfigList<PageConfig> pages;
     std::vector<CanMessage> can_library;
+    std::vector<CanSequenceConfig> can_sequences;
+    std::vector<CanPeriodicConfig> can_periodic;
+    std::vector<CanSignalConfig> can_signals;
+    std::vector<CanModuleConfig> can_modules;
+    CanBusConfig can_bus{};
+    CanCoalesceConfig can_coalesce{};
+    CanFilterConfig can_filter{};
+    CanRecorderConfig can_recorder{};
+    J1939Config j1939{};
     std::vector<FontConfig> available_fonts;  // List of available fonts for UI
 };
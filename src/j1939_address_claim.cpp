@@ -0,0 +1,178 @@
+#include "j1939_address_claim.h"
+
+#include "can_types.h"
+
+namespace {
+constexpr std::uint8_t kClaimPriority = 6;
+
+bool isDue(std::uint32_t now_ms, std::uint32_t due_ms) {
+    return static_cast<std::int32_t>(now_ms - due_ms) >= 0;
+}
+}
+
+std::uint64_t J1939Name::encode() const {
+    return (static_cast<std::uint64_t>(arbitrary_address_capable ? 1 : 0) << 63) |
+           (static_cast<std::uint64_t>(industry_group & 0x07) << 60) |
+           (static_cast<std::uint64_t>(vehicle_system_instance & 0x0F) << 56) |
+           (static_cast<std::uint64_t>(vehicle_system & 0x7F) << 49) |
+           (static_cast<std::uint64_t>(function) << 40) |
+           (static_cast<std::uint64_t>(function_instance & 0x1F) << 35) |
+           (static_cast<std::uint64_t>(ecu_instance & 0x07) << 32) |
+           (static_cast<std::uint64_t>(manufacturer_code & 0x7FF) << 21) |
+           (identity_number & 0x1FFFFF);
+}
+
+bool J1939AddressClaim::configure(const J1939Name& name, std::uint8_t preferred, std::uint8_t range_min,
+                                  std::uint8_t range_max) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::uint64_t encoded = name.encode();
+    const bool changed = encoded != name_ || preferred != preferred_ || range_min != range_min_ ||
+                         range_max != range_max_;
+    name_ = encoded;
+    arbitrary_ = name.arbitrary_address_capable;
+    preferred_ = preferred;
+    range_min_ = range_min;
+    range_max_ = range_max < range_min ? range_min : range_max;
+    if (state_.load() == State::IDLE) {
+        address_.store(preferred_, std::memory_order_release);
+    }
+    return changed;
+}
+
+void J1939AddressClaim::start(std::uint32_t now_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    taken_.reset();
+    cannot_claim_pending_ = false;
+    claim(preferred_, now_ms);
+}
+
+void J1939AddressClaim::assignFixed() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cannot_claim_pending_ = false;
+    address_.store(preferred_, std::memory_order_release);
+    state_.store(State::FIXED, std::memory_order_release);
+}
+
+void J1939AddressClaim::claim(std::uint8_t address, std::uint32_t now_ms) {
+    address_.store(address, std::memory_order_release);
+    state_.store(State::CLAIMING, std::memory_order_release);
+    settle_due_ms_ = now_ms + kClaimSettleMs;
+    sendClaim(address);
+}
+
+void J1939AddressClaim::sendClaim(std::uint8_t source) {
+    if (!sink_) {
+        return;
+    }
+    std::uint8_t payload[8];
+    for (int i = 0; i < 8; ++i) {
+        payload[i] = static_cast<std::uint8_t>(name_ >> (8 * i));
+    }
+    sink_(buildJ1939Identifier(kClaimPriority, kPgnAddressClaimed, source, kGlobalAddress), payload, 8);
+}
+
+bool J1939AddressClaim::pickAddress(std::uint8_t& out) const {
+    const std::uint8_t current = address_.load(std::memory_order_relaxed);
+    const unsigned span = static_cast<unsigned>(range_max_ - range_min_) + 1;
+    const unsigned start = (current >= range_min_ && current <= range_max_) ? current - range_min_ + 1 : 0;
+    for (unsigned i = 0; i < span; ++i) {
+        const std::uint8_t candidate = static_cast<std::uint8_t>(range_min_ + (start + i) % span);
+        if (candidate != current && !taken_.test(candidate)) {
+            out = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+void J1939AddressClaim::scheduleCannotClaim(std::uint32_t now_ms) {
+    const std::uint32_t jitter = random_ ? random_() % (kMaxCannotClaimDelayMs + 1) : 0;
+    cannot_claim_pending_ = true;
+    cannot_claim_due_ms_ = now_ms + jitter;
+}
+
+void J1939AddressClaim::lose(std::uint32_t now_ms) {
+    std::uint8_t next = 0;
+    if (arbitrary_ && pickAddress(next)) {
+        claim(next, now_ms);
+        return;
+    }
+    address_.store(kNullAddress, std::memory_order_release);
+    state_.store(State::CANNOT_CLAIM, std::memory_order_release);
+    scheduleCannotClaim(now_ms);
+}
+
+void J1939AddressClaim::onFrame(std::uint32_t identifier, const std::uint8_t* data, std::uint8_t length,
+                                std::uint32_t now_ms) {
+    const std::uint8_t pdu_format = (identifier >> 16) & 0xFF;
+    const std::uint8_t destination = (identifier >> 8) & 0xFF;
+    const std::uint8_t source = identifier & 0xFF;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const State state = state_.load();
+    if (state == State::IDLE) {
+        return;
+    }
+    const bool fixed = state == State::FIXED;
+    const std::uint8_t current = address_.load();
+
+    if (pdu_format == (kPgnAddressClaimed >> 8) && length >= 8) {
+        std::uint64_t their_name = 0;
+        for (int i = 7; i >= 0; --i) {
+            their_name = (their_name << 8) | data[i];
+        }
+        if (source >= kNullAddress || their_name == name_) {
+            return;
+        }
+        taken_.set(source);
+
+        if (state != State::CANNOT_CLAIM && source == current) {
+            contentions_.fetch_add(1, std::memory_order_relaxed);
+            if (fixed) {
+                return;  // Not claiming: the clash is only reported
+            }
+            if (name_ < their_name) {
+                sendClaim(current);  // We win: re-assert so the other node moves
+            } else {
+                lose(now_ms);
+            }
+        }
+        return;
+    }
+
+    if (pdu_format == (kPgnRequest >> 8) && length >= 3 && !fixed) {
+        const std::uint32_t requested = data[0] | (static_cast<std::uint32_t>(data[1]) << 8) |
+                                        (static_cast<std::uint32_t>(data[2]) << 16);
+        if (requested != kPgnAddressClaimed || (destination != kGlobalAddress && destination != current)) {
+            return;
+        }
+        if (state == State::CANNOT_CLAIM) {
+            scheduleCannotClaim(now_ms);
+        } else {
+            sendClaim(current);
+        }
+    }
+}
+
+std::uint32_t J1939AddressClaim::tick(std::uint32_t now_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::uint32_t next_wait = kIdle;
+
+    if (state_.load() == State::CLAIMING) {
+        if (isDue(now_ms, settle_due_ms_)) {
+            state_.store(State::CLAIMED, std::memory_order_release);
+        } else {
+            next_wait = settle_due_ms_ - now_ms;
+        }
+    }
+
+    if (cannot_claim_pending_) {
+        if (isDue(now_ms, cannot_claim_due_ms_)) {
+            cannot_claim_pending_ = false;
+            sendClaim(kNullAddress);
+        } else if (cannot_claim_due_ms_ - now_ms < next_wait) {
+            next_wait = cannot_claim_due_ms_ - now_ms;
+        }
+    }
+    return next_wait;
+}
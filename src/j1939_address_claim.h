@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <bitset>
+#include <cstdint>
+#include <mutex>
+
+// J1939-81 NAME. Lower encoded value wins address contention.
+struct J1939Name {
+    bool arbitrary_address_capable = true;
+    std::uint8_t industry_group = 0;            // 3 bits
+    std::uint8_t vehicle_system_instance = 0;   // 4 bits
+    std::uint8_t vehicle_system = 0;            // 7 bits
+    std::uint8_t function = 0;
+    std::uint8_t function_instance = 0;         // 5 bits
+    std::uint8_t ecu_instance = 0;              // 3 bits
+    std::uint16_t manufacturer_code = 0;        // 11 bits
+    std::uint32_t identity_number = 0;          // 21 bits, unique per unit
+
+    std::uint64_t encode() const;
+};
+
+/**
+ * J1939-81 address claim state machine.
+ *
+ * Claims the preferred address at start-up and answers requests for
+ * Address Claimed. When another node claims the same address the lower
+ * NAME keeps it; the loser moves to a free address in the self-configurable
+ * range if its NAME says it is arbitrary-address capable, otherwise it sends
+ * Cannot Claim (from the null address after a random 0-153 ms delay) and
+ * stays silent.
+ *
+ * With claiming disabled (assignFixed) the preferred address is used as is:
+ * nothing is ever sent, requests go unanswered, and a foreign claim for the
+ * same address is only counted in contentions(); the address never moves.
+ *
+ * Plain C++ with explicit time so several nodes can be run against one
+ * simulated bus.
+ */
+class J1939AddressClaim {
+public:
+    static constexpr std::uint32_t kPgnAddressClaimed = 0x00EE00;
+    static constexpr std::uint32_t kPgnRequest = 0x00EA00;
+    static constexpr std::uint8_t kNullAddress = 0xFE;
+    static constexpr std::uint8_t kGlobalAddress = 0xFF;
+    static constexpr std::uint32_t kClaimSettleMs = 250;
+    static constexpr std::uint32_t kMaxCannotClaimDelayMs = 153;
+    static constexpr std::uint32_t kIdle = UINT32_MAX;
+
+    enum class State : std::uint8_t { IDLE, CLAIMING, CLAIMED, CANNOT_CLAIM, FIXED };
+
+    using FrameSink = bool (*)(std::uint32_t identifier, const std::uint8_t* data, std::uint8_t length);
+    using Random = std::uint32_t (*)();
+
+    void setSink(FrameSink sink) { sink_ = sink; }
+    void setRandom(Random random) { random_ = random; }
+
+    // Returns true when NAME or addressing changed (a running claim should restart)
+    bool configure(const J1939Name& name, std::uint8_t preferred, std::uint8_t range_min, std::uint8_t range_max);
+    void start(std::uint32_t now_ms);
+    // Uses the preferred address without claiming (address claim disabled)
+    void assignFixed();
+
+    void onFrame(std::uint32_t identifier, const std::uint8_t* data, std::uint8_t length, std::uint32_t now_ms);
+    // Returns ms until the next timed action (kIdle when none)
+    std::uint32_t tick(std::uint32_t now_ms);
+
+    State state() const { return state_.load(std::memory_order_acquire); }
+    std::uint8_t address() const { return address_.load(std::memory_order_acquire); }
+    std::uint64_t name() const { return name_; }
+    std::uint32_t contentions() const { return contentions_.load(std::memory_order_relaxed); }
+
+private:
+    void claim(std::uint8_t address, std::uint32_t now_ms);
+    void lose(std::uint32_t now_ms);
+    void scheduleCannotClaim(std::uint32_t now_ms);
+    bool pickAddress(std::uint8_t& out) const;
+    void sendClaim(std::uint8_t source);
+
+    std::mutex mutex_;
+    std::uint64_t name_ = 0;
+    bool arbitrary_ = true;
+    std::uint8_t preferred_ = 0x80;
+    std::uint8_t range_min_ = 0x80;
+    std::uint8_t range_max_ = 0xF7;
+    std::bitset<256> taken_;            // Addresses other nodes have claimed
+    std::uint32_t settle_due_ms_ = 0;
+    bool cannot_claim_pending_ = false;
+    std::uint32_t cannot_claim_due_ms_ = 0;
+
+    std::atomic<State> state_{State::IDLE};
+    std::atomic<std::uint8_t> address_{0x80};
+    std::atomic<std::uint32_t> contentions_{0};
+    FrameSink sink_ = nullptr;
+    Random random_ = nullptr;
+};
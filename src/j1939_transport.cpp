@@ -0,0 +1,557 @@
+#include "j1939_transport.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "can_types.h"
+#include "psram_alloc.h"
+
+namespace {
+constexpr std::uint8_t kControlRts = 16;
+constexpr std::uint8_t kControlCts = 17;
+constexpr std::uint8_t kControlEndOfMsgAck = 19;
+constexpr std::uint8_t kControlBam = 32;
+constexpr std::uint8_t kControlAbort = 255;
+
+constexpr std::uint8_t kAbortBusy = 1;
+constexpr std::uint8_t kAbortResources = 2;
+constexpr std::uint8_t kAbortTimeout = 3;
+
+constexpr std::uint8_t kGlobal = 0xFF;
+constexpr std::uint8_t kBytesPerPacket = 7;
+
+bool isDue(std::uint32_t now_ms, std::uint32_t due_ms) {
+    return static_cast<std::int32_t>(now_ms - due_ms) >= 0;
+}
+
+std::uint32_t readPgn(const std::uint8_t* data) {
+    return data[5] | (static_cast<std::uint32_t>(data[6]) << 8) | (static_cast<std::uint32_t>(data[7]) << 16);
+}
+
+void writePgn(std::uint8_t (&payload)[8], std::uint32_t pgn) {
+    payload[5] = pgn & 0xFF;
+    payload[6] = (pgn >> 8) & 0xFF;
+    payload[7] = (pgn >> 16) & 0xFF;
+}
+
+std::uint8_t packetCount(std::uint16_t size) {
+    return static_cast<std::uint8_t>((size + kBytesPerPacket - 1) / kBytesPerPacket);
+}
+}
+
+J1939Transport::~J1939Transport() {
+    if (pool_) {
+        psramFree(pool_);
+    }
+}
+
+bool J1939Transport::begin() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pool_) {
+        return true;
+    }
+    pool_ = static_cast<std::uint8_t*>(psramAlloc(kPoolBuffers * kMaxMessageSize));
+    if (!pool_) {
+        return false;
+    }
+    pool_free_ = static_cast<std::uint8_t>((1u << kPoolBuffers) - 1);
+    return true;
+}
+
+void J1939Transport::setAddress(std::uint8_t address) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    address_ = address;
+}
+
+bool J1939Transport::addHandler(MessageHandler handler, void* context) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::size_t i = 0; i < kMaxHandlers; ++i) {
+        if (!handlers_[i]) {
+            handlers_[i] = handler;
+            handler_contexts_[i] = context;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::int8_t J1939Transport::acquireBuffer() {
+    for (std::size_t i = 0; i < kPoolBuffers; ++i) {
+        if (pool_free_ & (1u << i)) {
+            pool_free_ &= static_cast<std::uint8_t>(~(1u << i));
+            return static_cast<std::int8_t>(i);
+        }
+    }
+    ++stats_.pool_exhausted;
+    return -1;
+}
+
+void J1939Transport::releaseBuffer(std::int8_t index) {
+    if (index >= 0) {
+        pool_free_ |= static_cast<std::uint8_t>(1u << index);
+    }
+}
+
+std::uint8_t* J1939Transport::bufferData(std::int8_t index) const {
+    return pool_ + static_cast<std::size_t>(index) * kMaxMessageSize;
+}
+
+J1939Transport::RxSession* J1939Transport::findRx(std::uint8_t source, std::uint8_t destination) {
+    for (RxSession& session : rx_) {
+        if (session.active && session.source == source && session.destination == destination) {
+            return &session;
+        }
+    }
+    return nullptr;
+}
+
+J1939Transport::TxSession* J1939Transport::findTx(std::uint8_t destination, std::uint32_t pgn) {
+    for (TxSession& session : tx_) {
+        if (session.active && session.destination == destination && session.pgn == pgn) {
+            return &session;
+        }
+    }
+    return nullptr;
+}
+
+bool J1939Transport::sendControl(std::uint8_t destination, const std::uint8_t (&payload)[8]) {
+    if (!sink_) {
+        return false;
+    }
+    return sink_(buildJ1939Identifier(7, kPgnTpCm, address_, destination), payload, 8);
+}
+
+std::uint8_t J1939Transport::firstMissing(const RxSession& session) {
+    for (std::uint16_t seq = 1; seq <= session.packets; ++seq) {
+        if (!(session.seen[seq >> 5] & (1u << (seq & 31)))) {
+            return static_cast<std::uint8_t>(seq);
+        }
+    }
+    return static_cast<std::uint8_t>(session.packets + 1);
+}
+
+bool J1939Transport::send(std::uint32_t pgn, std::uint8_t priority, std::uint8_t destination,
+                          const std::uint8_t* data, std::uint16_t length, std::uint32_t now_ms,
+                          CompletionHandler done, void* context) {
+    if (!data || length <= 8 || length > kMaxMessageSize) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!pool_ || !sink_) {
+        return false;
+    }
+
+    // One connection per destination; one BAM at a time
+    TxSession* session = nullptr;
+    for (TxSession& candidate : tx_) {
+        if (candidate.active && candidate.destination == destination) {
+            return false;
+        }
+        if (!candidate.active && !session) {
+            session = &candidate;
+        }
+    }
+    if (!session) {
+        return false;
+    }
+
+    const std::int8_t buffer = acquireBuffer();
+    if (buffer < 0) {
+        return false;
+    }
+    std::memcpy(bufferData(buffer), data, length);
+
+    *session = TxSession{};
+    session->bam = destination == kGlobal;
+    session->destination = destination;
+    session->priority = priority & 0x7;
+    session->pgn = pgn;
+    session->size = length;
+    session->packets = packetCount(length);
+    session->buffer = buffer;
+    session->done = done;
+    session->context = context;
+
+    std::uint8_t payload[8] = {session->bam ? kControlBam : kControlRts,
+                               static_cast<std::uint8_t>(length & 0xFF),
+                               static_cast<std::uint8_t>(length >> 8),
+                               session->packets, 0xFF, 0, 0, 0};
+    writePgn(payload, pgn);
+    if (!sendControl(destination, payload)) {
+        releaseBuffer(buffer);
+        return false;
+    }
+
+    session->active = true;
+    if (session->bam) {
+        session->state = TxState::SEND_DT;
+        session->window_end = session->packets;
+        session->due_ms = now_ms + kBamGapMs;
+    } else {
+        session->state = TxState::WAIT_CTS;
+        session->deadline_ms = now_ms + kT3Ms;
+    }
+    return true;
+}
+
+void J1939Transport::onFrame(std::uint32_t identifier, const std::uint8_t* data, std::uint8_t length,
+                             std::uint32_t now_ms) {
+    const std::uint8_t pdu_format = (identifier >> 16) & 0xFF;
+    if (length < 8 || (pdu_format != (kPgnTpCm >> 8) && pdu_format != (kPgnTpDt >> 8))) {
+        return;
+    }
+
+    const std::uint8_t source = identifier & 0xFF;
+    const std::uint8_t destination = (identifier >> 8) & 0xFF;
+
+    Deferred deferred;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!pool_ || (destination != kGlobal && destination != address_)) {
+            return;
+        }
+        if (pdu_format == (kPgnTpCm >> 8)) {
+            handleControl(source, destination, data, now_ms, deferred);
+        } else {
+            handleData(source, destination, data, now_ms, deferred);
+        }
+    }
+    runDeferred(deferred);
+}
+
+void J1939Transport::handleControl(std::uint8_t source, std::uint8_t destination, const std::uint8_t* data,
+                                   std::uint32_t now_ms, Deferred& deferred) {
+    const std::uint32_t pgn = readPgn(data);
+
+    switch (data[0]) {
+        case kControlBam:
+            if (destination == kGlobal) {
+                startRx(source, destination, data, true, now_ms);
+            }
+            break;
+
+        case kControlRts:
+            if (destination == address_) {
+                startRx(source, destination, data, false, now_ms);
+            }
+            break;
+
+        case kControlCts: {
+            TxSession* session = findTx(source, pgn);
+            if (!session || session->bam) {
+                break;
+            }
+            const std::uint8_t count = data[1];
+            const std::uint8_t next = data[2];
+            if (count == 0) {
+                session->state = TxState::WAIT_CTS;  // Receiver asked us to hold
+                session->deadline_ms = now_ms + kT4Ms;
+            } else if (next >= 1 && next <= session->packets) {
+                session->next_packet = next;
+                session->window_end = static_cast<std::uint8_t>(
+                    std::min<std::uint16_t>(session->packets, next + count - 1));
+                session->state = TxState::SEND_DT;
+                session->due_ms = now_ms;
+            }
+            break;
+        }
+
+        case kControlEndOfMsgAck: {
+            TxSession* session = findTx(source, pgn);
+            if (session && !session->bam) {
+                finishTx(*session, true, deferred);
+            }
+            break;
+        }
+
+        case kControlAbort: {
+            if (TxSession* session = findTx(source, pgn)) {
+                finishTx(*session, false, deferred);
+            }
+            RxSession* session = findRx(source, destination);
+            if (session && session->pgn == pgn) {
+                dropRx(*session, false, 0);
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+void J1939Transport::startRx(std::uint8_t source, std::uint8_t destination, const std::uint8_t* data, bool bam,
+                             std::uint32_t now_ms) {
+    const std::uint16_t size = data[1] | (static_cast<std::uint16_t>(data[2]) << 8);
+    const std::uint8_t packets = data[3];
+    const std::uint32_t pgn = readPgn(data);
+
+    auto refuse = [&](std::uint8_t reason) {
+        if (!bam) {
+            std::uint8_t payload[8] = {kControlAbort, reason, 0xFF, 0xFF, 0xFF, 0, 0, 0};
+            writePgn(payload, pgn);
+            sendControl(source, payload);
+        }
+    };
+
+    if (size <= 8 || size > kMaxMessageSize || packets != packetCount(size)) {
+        refuse(kAbortResources);
+        return;
+    }
+
+    // A new announcement from the same peer supersedes the old transfer
+    if (RxSession* existing = findRx(source, destination)) {
+        dropRx(*existing, false, 0);
+    }
+
+    RxSession* session = nullptr;
+    for (RxSession& candidate : rx_) {
+        if (!candidate.active) {
+            session = &candidate;
+            break;
+        }
+    }
+    if (!session) {
+        refuse(kAbortBusy);
+        return;
+    }
+    const std::int8_t buffer = acquireBuffer();
+    if (buffer < 0) {
+        refuse(kAbortResources);
+        return;
+    }
+
+    *session = RxSession{};
+    session->active = true;
+    session->bam = bam;
+    session->source = source;
+    session->destination = destination;
+    session->pgn = pgn;
+    session->size = size;
+    session->packets = packets;
+    session->max_per_cts = bam ? 0xFF : data[4];
+    session->buffer = buffer;
+
+    if (bam) {
+        session->window_end = packets;
+        session->deadline_ms = now_ms + kT1Ms;
+    } else {
+        requestWindow(*session, now_ms);
+    }
+}
+
+void J1939Transport::requestWindow(RxSession& session, std::uint32_t now_ms) {
+    const std::uint8_t first = firstMissing(session);
+    const std::uint8_t limit = std::min<std::uint8_t>(kCtsWindow, session.max_per_cts ? session.max_per_cts : 1);
+    const std::uint8_t count = static_cast<std::uint8_t>(std::min<std::uint16_t>(limit, session.packets - first + 1));
+    session.window_end = static_cast<std::uint8_t>(first + count - 1);
+    // Re-request well inside the sender's T3 if the CTS itself was lost; T2 still bounds the whole retry budget
+    session.deadline_ms = now_ms + (session.retransmits < kMaxRetransmits ? kT1Ms : kT2Ms);
+
+    std::uint8_t payload[8] = {kControlCts, count, first, 0xFF, 0xFF, 0, 0, 0};
+    writePgn(payload, session.pgn);
+    sendControl(session.source, payload);
+}
+
+void J1939Transport::handleData(std::uint8_t source, std::uint8_t destination, const std::uint8_t* data,
+                                std::uint32_t now_ms, Deferred& deferred) {
+    RxSession* session = findRx(source, destination);
+    const std::uint8_t seq = data[0];
+    if (!session || seq == 0 || seq > session->packets) {
+        return;
+    }
+
+    const std::uint32_t bit = 1u << (seq & 31);
+    if (session->seen[seq >> 5] & bit) {
+        return;  // Duplicate from a retransmitted window
+    }
+    session->seen[seq >> 5] |= bit;
+    ++session->received;
+
+    const std::size_t offset = static_cast<std::size_t>(seq - 1) * kBytesPerPacket;
+    const std::size_t bytes = std::min<std::size_t>(kBytesPerPacket, session->size - offset);
+    std::memcpy(bufferData(session->buffer) + offset, data + 1, bytes);
+
+    if (session->received == session->packets) {
+        if (!session->bam) {
+            std::uint8_t payload[8] = {kControlEndOfMsgAck,
+                                       static_cast<std::uint8_t>(session->size & 0xFF),
+                                       static_cast<std::uint8_t>(session->size >> 8),
+                                       session->packets, 0xFF, 0, 0, 0};
+            writePgn(payload, session->pgn);
+            sendControl(session->source, payload);
+        }
+        finishRx(*session, deferred);
+        return;
+    }
+
+    if (session->bam) {
+        session->deadline_ms = now_ms + kT1Ms;
+    } else if (firstMissing(*session) > session->window_end) {
+        session->retransmits = 0;
+        requestWindow(*session, now_ms);
+    } else if (seq == session->window_end) {
+        // Window tail arrived with holes: give stragglers a moment, then re-request
+        session->deadline_ms = now_ms + kGapWaitMs;
+    } else {
+        session->deadline_ms = now_ms + kT1Ms;
+    }
+}
+
+void J1939Transport::finishRx(RxSession& session, Deferred& deferred) {
+    deferred.deliver = true;
+    deferred.buffer = session.buffer;
+    deferred.message.pgn = session.pgn;
+    deferred.message.priority = 7;
+    deferred.message.source_address = session.source;
+    deferred.message.destination_address = session.destination;
+    deferred.message.data = bufferData(session.buffer);
+    deferred.message.length = session.size;
+    session.buffer = -1;  // Ownership moves to the deferred delivery
+    session.active = false;
+    ++stats_.rx_completed;
+}
+
+void J1939Transport::dropRx(RxSession& session, bool send_abort, std::uint8_t reason) {
+    if (send_abort) {
+        std::uint8_t payload[8] = {kControlAbort, reason, 0xFF, 0xFF, 0xFF, 0, 0, 0};
+        writePgn(payload, session.pgn);
+        sendControl(session.source, payload);
+    }
+    releaseBuffer(session.buffer);
+    session.buffer = -1;
+    session.active = false;
+    ++stats_.rx_aborted;
+}
+
+void J1939Transport::finishTx(TxSession& session, bool success, Deferred& deferred) {
+    releaseBuffer(session.buffer);
+    session.buffer = -1;
+    session.active = false;
+    if (success) {
+        ++stats_.tx_completed;
+    } else {
+        ++stats_.tx_aborted;
+    }
+    deferred.done = session.done;
+    deferred.context = session.context;
+    deferred.done_pgn = session.pgn;
+    deferred.done_destination = session.destination;
+    deferred.done_success = success;
+}
+
+void J1939Transport::sendDt(TxSession& session) {
+    const std::size_t offset = static_cast<std::size_t>(session.next_packet - 1) * kBytesPerPacket;
+    const std::size_t bytes = std::min<std::size_t>(kBytesPerPacket, session.size - offset);
+
+    std::uint8_t payload[8];
+    std::memset(payload, 0xFF, sizeof(payload));  // Unused bytes of the last packet are 0xFF
+    payload[0] = session.next_packet;
+    std::memcpy(payload + 1, bufferData(session.buffer) + offset, bytes);
+
+    if (sink_ && sink_(buildJ1939Identifier(session.priority, kPgnTpDt, address_, session.destination), payload, 8)) {
+        ++session.next_packet;
+    }
+}
+
+void J1939Transport::runDeferred(Deferred& deferred) {
+    if (deferred.deliver) {
+        for (std::size_t i = 0; i < kMaxHandlers; ++i) {
+            if (handlers_[i]) {
+                handlers_[i](deferred.message, handler_contexts_[i]);
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        releaseBuffer(deferred.buffer);
+    }
+    if (deferred.done) {
+        deferred.done(deferred.done_pgn, deferred.done_destination, deferred.done_success, deferred.context);
+    }
+}
+
+std::uint32_t J1939Transport::tick(std::uint32_t now_ms) {
+    std::array<Deferred, kMaxTxSessions> completions{};
+    std::uint32_t next_wait = kIdle;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        for (RxSession& session : rx_) {
+            if (!session.active) {
+                continue;
+            }
+            if (isDue(now_ms, session.deadline_ms)) {
+                if (session.bam) {
+                    dropRx(session, false, 0);
+                } else if (session.retransmits < kMaxRetransmits) {
+                    ++session.retransmits;
+                    ++stats_.rx_retransmits;
+                    requestWindow(session, now_ms);
+                } else {
+                    dropRx(session, true, kAbortTimeout);
+                }
+            }
+            if (session.active) {
+                next_wait = std::min(next_wait, session.deadline_ms - now_ms);
+            }
+        }
+
+        for (std::size_t i = 0; i < kMaxTxSessions; ++i) {
+            TxSession& session = tx_[i];
+            if (!session.active) {
+                continue;
+            }
+
+            if (session.state == TxState::SEND_DT) {
+                if (isDue(now_ms, session.due_ms)) {
+                    const std::uint8_t before = session.next_packet;
+                    sendDt(session);
+                    if (session.next_packet == before) {
+                        session.due_ms = now_ms + 1;  // TX queue full; retry shortly
+                    } else if (session.next_packet > session.window_end) {
+                        if (session.bam) {
+                            finishTx(session, true, completions[i]);
+                            continue;
+                        }
+                        session.state = session.window_end == session.packets ? TxState::WAIT_EOMA
+                                                                              : TxState::WAIT_CTS;
+                        session.deadline_ms = now_ms + kT3Ms;
+                    } else {
+                        session.due_ms = now_ms + (session.bam ? kBamGapMs : kDtGapMs);
+                    }
+                }
+            } else if (isDue(now_ms, session.deadline_ms)) {
+                std::uint8_t payload[8] = {kControlAbort, kAbortTimeout, 0xFF, 0xFF, 0xFF, 0, 0, 0};
+                writePgn(payload, session.pgn);
+                sendControl(session.destination, payload);
+                finishTx(session, false, completions[i]);
+                continue;
+            }
+
+            const std::uint32_t wake = session.state == TxState::SEND_DT ? session.due_ms : session.deadline_ms;
+            next_wait = std::min(next_wait, isDue(now_ms, wake) ? 0u : wake - now_ms);
+        }
+    }
+
+    for (Deferred& deferred : completions) {
+        runDeferred(deferred);
+    }
+    return next_wait;
+}
+
+J1939TransportStats J1939Transport::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+std::size_t J1939Transport::activeSessions() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t count = 0;
+    for (const RxSession& session : rx_) {
+        count += session.active ? 1 : 0;
+    }
+    for (const TxSession& session : tx_) {
+        count += session.active ? 1 : 0;
+    }
+    return count;
+}
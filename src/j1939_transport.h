@@ -0,0 +1,176 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+// A reassembled (or to-be-segmented) J1939 message. data points into a pooled
+// buffer that is only valid for the duration of the handler call.
+struct J1939Message {
+    std::uint32_t pgn = 0;
+    std::uint8_t priority = 6;
+    std::uint8_t source_address = 0xFF;
+    std::uint8_t destination_address = 0xFF;
+    const std::uint8_t* data = nullptr;
+    std::uint16_t length = 0;
+};
+
+struct J1939TransportStats {
+    std::uint32_t rx_completed = 0;
+    std::uint32_t rx_aborted = 0;      // Sessions dropped on timeout, abort or lack of resources
+    std::uint32_t rx_retransmits = 0;  // CTS re-requests for lost packets
+    std::uint32_t tx_completed = 0;
+    std::uint32_t tx_aborted = 0;
+    std::uint32_t pool_exhausted = 0;
+};
+
+/**
+ * J1939-21 transport protocol: BAM and RTS/CTS connection mode.
+ *
+ * Inbound sessions are tracked per (source, destination) pair and reassemble
+ * TP.DT payloads straight into fixed-size pooled buffers; handlers get a view
+ * of the buffer, nothing is copied. Packets are stored by sequence number so
+ * reordered frames are accepted, and connection-mode gaps are re-requested
+ * with a CTS instead of failing the whole transfer.
+ *
+ * Outbound messages longer than 8 bytes are segmented: broadcasts use BAM
+ * with the mandated 50 ms packet gap, addressed messages use RTS/CTS and
+ * follow the receiver's flow control.
+ *
+ * Plain C++: frames go in through onFrame(), out through the sink, and time
+ * is passed in explicitly so sessions can be driven on a virtual bus.
+ */
+class J1939Transport {
+public:
+    static constexpr std::uint32_t kPgnTpCm = 0x00EC00;
+    static constexpr std::uint32_t kPgnTpDt = 0x00EB00;
+    static constexpr std::uint16_t kMaxMessageSize = 1785;  // 255 packets x 7 bytes
+    static constexpr std::size_t kPoolBuffers = 8;
+    static constexpr std::size_t kMaxRxSessions = 6;
+    static constexpr std::size_t kMaxTxSessions = 2;
+    static constexpr std::size_t kMaxHandlers = 4;
+    static constexpr std::uint32_t kIdle = UINT32_MAX;
+
+    // J1939-21 timing (ms)
+    static constexpr std::uint32_t kT1Ms = 750;    // Receiver: gap between TP.DT packets
+    static constexpr std::uint32_t kT2Ms = 1250;   // Receiver: CTS sent, waiting for data
+    static constexpr std::uint32_t kT3Ms = 1250;   // Sender: waiting for CTS or EOMA
+    static constexpr std::uint32_t kT4Ms = 1050;   // Sender: receiver asked to hold
+    static constexpr std::uint32_t kBamGapMs = 50;
+    static constexpr std::uint32_t kDtGapMs = 2;   // Pacing inside a CTS window
+    static constexpr std::uint32_t kGapWaitMs = 20;  // Grace for reordered packets before re-requesting
+    static constexpr std::uint8_t kCtsWindow = 16;
+    static constexpr std::uint8_t kMaxRetransmits = 3;
+
+    using FrameSink = bool (*)(std::uint32_t identifier, const std::uint8_t* data, std::uint8_t length);
+    using MessageHandler = void (*)(const J1939Message& message, void* context);
+    using CompletionHandler = void (*)(std::uint32_t pgn, std::uint8_t destination, bool success, void* context);
+
+    J1939Transport() = default;
+    ~J1939Transport();
+    J1939Transport(const J1939Transport&) = delete;
+    J1939Transport& operator=(const J1939Transport&) = delete;
+
+    bool begin();
+    void setSink(FrameSink sink) { sink_ = sink; }
+    void setAddress(std::uint8_t address);
+    std::uint8_t address() const { return address_; }
+    bool addHandler(MessageHandler handler, void* context);
+
+    // Starts an outbound session: BAM when destination is 0xFF, RTS/CTS otherwise
+    bool send(std::uint32_t pgn, std::uint8_t priority, std::uint8_t destination, const std::uint8_t* data,
+              std::uint16_t length, std::uint32_t now_ms, CompletionHandler done = nullptr, void* context = nullptr);
+
+    void onFrame(std::uint32_t identifier, const std::uint8_t* data, std::uint8_t length, std::uint32_t now_ms);
+
+    // Drives pacing and timeouts; returns ms until the next action (kIdle when nothing is open)
+    std::uint32_t tick(std::uint32_t now_ms);
+
+    J1939TransportStats stats() const;
+    std::size_t activeSessions() const;
+
+private:
+    enum class TxState : std::uint8_t { SEND_DT, WAIT_CTS, WAIT_EOMA };
+
+    struct RxSession {
+        bool active = false;
+        bool bam = false;
+        std::uint8_t source = 0;
+        std::uint8_t destination = 0;
+        std::uint32_t pgn = 0;
+        std::uint16_t size = 0;
+        std::uint8_t packets = 0;
+        std::uint8_t received = 0;
+        std::uint8_t max_per_cts = 0xFF;
+        std::uint8_t window_end = 0;
+        std::uint8_t retransmits = 0;
+        std::int8_t buffer = -1;
+        std::uint32_t deadline_ms = 0;
+        std::array<std::uint32_t, 8> seen{};  // Bit per sequence number 1..255
+    };
+
+    struct TxSession {
+        bool active = false;
+        bool bam = false;
+        TxState state = TxState::SEND_DT;
+        std::uint8_t destination = 0;
+        std::uint8_t priority = 6;
+        std::uint32_t pgn = 0;
+        std::uint16_t size = 0;
+        std::uint8_t packets = 0;
+        std::uint8_t next_packet = 1;
+        std::uint8_t window_end = 0;
+        std::int8_t buffer = -1;
+        std::uint32_t due_ms = 0;
+        std::uint32_t deadline_ms = 0;
+        CompletionHandler done = nullptr;
+        void* context = nullptr;
+    };
+
+    // Work collected under the lock and run after it is released
+    struct Deferred {
+        bool deliver = false;
+        J1939Message message;
+        std::int8_t buffer = -1;
+        CompletionHandler done = nullptr;
+        void* context = nullptr;
+        std::uint32_t done_pgn = 0;
+        std::uint8_t done_destination = 0;
+        bool done_success = false;
+    };
+
+    std::int8_t acquireBuffer();
+    void releaseBuffer(std::int8_t index);
+    std::uint8_t* bufferData(std::int8_t index) const;
+
+    void handleControl(std::uint8_t source, std::uint8_t destination, const std::uint8_t* data,
+                       std::uint32_t now_ms, Deferred& deferred);
+    void handleData(std::uint8_t source, std::uint8_t destination, const std::uint8_t* data,
+                    std::uint32_t now_ms, Deferred& deferred);
+    void startRx(std::uint8_t source, std::uint8_t destination, const std::uint8_t* data, bool bam,
+                 std::uint32_t now_ms);
+    void requestWindow(RxSession& session, std::uint32_t now_ms);
+    void finishRx(RxSession& session, Deferred& deferred);
+    void dropRx(RxSession& session, bool send_abort, std::uint8_t reason);
+    void finishTx(TxSession& session, bool success, Deferred& deferred);
+    void sendDt(TxSession& session);
+    void runDeferred(Deferred& deferred);
+
+    RxSession* findRx(std::uint8_t source, std::uint8_t destination);
+    TxSession* findTx(std::uint8_t destination, std::uint32_t pgn);
+    bool sendControl(std::uint8_t destination, const std::uint8_t (&payload)[8]);
+
+    static std::uint8_t firstMissing(const RxSession& session);
+
+    mutable std::mutex mutex_;
+    std::uint8_t* pool_ = nullptr;
+    std::uint8_t pool_free_ = 0;  // Bit per free buffer
+    std::array<RxSession, kMaxRxSessions> rx_{};
+    std::array<TxSession, kMaxTxSessions> tx_{};
+    std::array<MessageHandler, kMaxHandlers> handlers_{};
+    std::array<void*, kMaxHandlers> handler_contexts_{};
+    FrameSink sink_ = nullptr;
+    std::uint8_t address_ = 0x80;
+    J1939TransportStats stats_{};
+};
@@ -18,6 +18,12 @@
 #include <esp_ota_ops.h>
 
 #include "can_manager.h"
+#include "can_module_status.h"
+#include "can_periodic.h"
+#include "can_recorder.h"
+#include "can_sequence.h"
+#include "can_signal_db.h"
+#include "can_trace.h"
 #include "config_manager.h"
 #include "ui_builder.h"
 #include "ui_theme.h"
@@ -102,9 +108,15 @@ bool notify_lvgl_flush_ready(void* user_ctx) {
 
 #if ESP_PANEL_USE_LCD_TOUCH
 void lvgl_port_tp_read(lv_indev_drv_t* indev, lv_indev_data_t* data) {
+    static bool was_touched = false;
     panel->getLcdTouch()->readData();
 
     bool touched = panel->getLcdTouch()->getTouchState();
+    if (touched != was_touched) {
+        // Press and release both trigger actions; LVGL dispatches the edge's events in this same pass
+        CanLatencyTracer::instance().touchEdge(canMicros());
+        was_touched = touched;
+    }
     if (!touched) {
         data->state = LV_INDEV_STATE_REL;
         return;
@@ -241,6 +253,11 @@ void setup() {
     } else {
         Serial.println("[CAN] ✗ TWAI driver FAILED - CAN will not work");
     }
+    // Multi-packet messages (DM1, software ID, ...) are rare enough to announce on the console
+    CanManager::instance().addJ1939Handler([](const J1939Message& message, void*) {
+        Serial.printf("[J1939] PGN 0x%05lX from 0x%02X: %u bytes\n",
+                      static_cast<unsigned long>(message.pgn), message.source_address, message.length);
+    });
     Serial.println();
 
     // Enable backlight
@@ -268,6 +285,25 @@ void setup() {
         Serial.println("[Boot] Version updated and saved");
     }
 
+    std::string sequence_error;
+    if (!CanSequenceEngine::instance().load(config.can_sequences, sequence_error)) {
+        Serial.printf("[Boot] CAN sequences not loaded: %s\n", sequence_error.c_str());
+    }
+    if (!CanPeriodicScheduler::instance().load(config.can_periodic, sequence_error)) {
+        Serial.printf("[Boot] Periodic CAN frames not loaded: %s\n", sequence_error.c_str());
+    }
+    if (!CanSignalDatabase::instance().load(config.can_signals, sequence_error)) {
+        Serial.printf("[Boot] CAN signals not loaded: %s\n", sequence_error.c_str());
+    }
+    if (!CanModuleStatus::instance().load(config.can_modules, sequence_error)) {
+        Serial.printf("[Boot] CAN modules not loaded: %s\n", sequence_error.c_str());
+    }
+    CanManager::instance().configureBus(config.can_bus);
+    CanManager::instance().configureFilters(config);
+    CanManager::instance().configureAddressing(config);
+    CanManager::instance().configureCoalescing(config.can_coalesce);
+    CanRecorder::instance().configure(config.can_recorder);
+
     // CAN was already initialized before panel (see above)
     // Build the themed UI once before networking spins up
     lvgl_port_lock(-1);
@@ -347,50 +383,48 @@ void loop() {
                 delay(400);
             }
         } else if (cmd.startsWith("canpoll ")) {
-            // Poll POWERCELL NGX: canpoll <address>
+            // Poll POWERCELL NGX: canpoll <address>; the reply lands in the module table (canmodules)
             int address = cmd.substring(8).toInt();
             if (address >= 1 && address <= 16) {
-                Serial.printf("[CAN] Polling POWERCELL NGX at address %d\n", address);
-                
-                // Build polling CAN ID: FF4X with source address 0x63
-                uint32_t pgn = 0xFF40 + (address == 16 ? 0 : address);
-                CanFrameConfig frame;
-                frame.enabled = true;
-                frame.pgn = pgn;
-                frame.priority = 6;
-                frame.source_address = 0x63;
-                frame.destination_address = 0xFF;
-                frame.data = {0x11, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-                
-                if (CanManager::instance().sendFrame(frame)) {
-                    Serial.println("[CAN] Poll message sent - listening for response...");
-                    
-                    // Listen for response (FF5X)
-                    uint32_t start = millis();
-                    while (millis() - start < 1000) {
-                        CanRxMessage msg;
-                        if (CanManager::instance().receiveMessage(msg, 50)) {
-                            Serial.printf("[CAN] RX ID: 0x%08lX, DLC: %d, Data: ", msg.identifier, msg.length);
-                            for (uint8_t i = 0; i < msg.length; i++) {
-                                Serial.printf("%02X ", msg.data[i]);
-                            }
-                            Serial.println();
-                        }
-                    }
+                if (CanModuleStatus::instance().pollNow(static_cast<uint8_t>(address))) {
+                    Serial.printf("[CAN] Polled module %d (PGN 0x%04lX); replies on 0x%04lX, see canmodules\n", address,
+                                  static_cast<unsigned long>(CanModuleStatus::pollPgn(address)),
+                                  static_cast<unsigned long>(CanModuleStatus::replyPgn(address)));
                 } else {
                     Serial.println("[CAN] Failed to send poll message");
                 }
             } else {
                 Serial.println("[CMD] Usage: canpoll <1-16>");
             }
+        } else if (cmd == "canmodules") {
+            const auto modules = CanModuleStatus::instance().snapshot();
+            if (modules.empty()) {
+                Serial.println("[CAN] No modules configured (can_modules)");
+            }
+            const uint32_t now = millis();
+            for (const auto& module : modules) {
+                Serial.printf("%-16s %-9s addr %2u  %s", module.id.c_str(), module.type.c_str(), module.address,
+                              module.online ? "online" : "offline");
+                if (module.replies) {
+                    Serial.printf(" (reply %lu ms ago)", static_cast<unsigned long>(now - module.last_reply_ms));
+                }
+                Serial.printf("  polls %lu, replies %lu\n", static_cast<unsigned long>(module.polls),
+                              static_cast<unsigned long>(module.replies));
+                for (std::size_t i = 0; i < module.outputs.size(); ++i) {
+                    Serial.printf("  out%-2u %-7s %5.2f A\n", static_cast<unsigned>(i + 1),
+                                  CanModuleStatus::stateName(module.outputs[i].state),
+                                  module.outputs[i].current_ma / 1000.0f);
+                }
+            }
         } else if (cmd == "canmon") {
             // Monitor CAN bus for 10 seconds
             Serial.println("[CAN] Monitoring CAN bus for 10 seconds...");
+            CanRxCursor cursor = CanManager::instance().openRxCursor();
             uint32_t start = millis();
             int count = 0;
             while (millis() - start < 10000) {
                 CanRxMessage msg;
-                if (CanManager::instance().receiveMessage(msg, 100)) {
+                if (CanManager::instance().readRx(cursor, msg, 100)) {
                     count++;
                     Serial.printf("[CAN] #%d ID: 0x%08lX, DLC: %d, Data: ", count, msg.identifier, msg.length);
                     for (uint8_t i = 0; i < msg.length; i++) {
@@ -399,7 +433,8 @@ void loop() {
                     Serial.println();
                 }
             }
-            Serial.printf("[CAN] Monitoring complete. Received %d messages.\n", count);
+            Serial.printf("[CAN] Monitoring complete. Received %d messages (%lu dropped).\n",
+                          count, static_cast<unsigned long>(cursor.dropped));
         } else if (cmd.startsWith("canconfig ")) {
             // Send configuration to POWERCELL NGX: canconfig <address>
             int address = cmd.substring(10).toInt();
@@ -407,13 +442,12 @@ void loop() {
                 Serial.printf("[CAN] Configuring POWERCELL NGX at address %d\n", address);
                 Serial.println("[CAN] Config: 250kb/s, 10s LOC timer, 250ms reporting, 200Hz PWM");
                 
-                // Build configuration CAN ID: FF4X with source address 0x63
+                // Build configuration CAN ID: FF4X; the source byte is our J1939 address (CanManager stamps it)
                 uint32_t pgn = 0xFF40 + (address == 16 ? 0 : address);
                 CanFrameConfig frame;
                 frame.enabled = true;
                 frame.pgn = pgn;
                 frame.priority = 6;
-                frame.source_address = 0x63;
                 frame.destination_address = 0xFF;
                 // Configuration: 0x99 confirmation, 0x01 (250kb/s, 10s, 250ms, 200Hz), all outputs maintain state, config rev 0
                 frame.data = {0x99, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
@@ -439,7 +473,6 @@ void loop() {
                 frame.enabled = true;
                 frame.pgn = pgn;
                 frame.priority = 6;
-                frame.source_address = 0x63;
                 frame.destination_address = 0xFF;
                 frame.data = {0, 0, 0, 0, 0, 0, 0, 0};
                 
@@ -474,9 +507,233 @@ void loop() {
             Serial.printf("CAN Ready: %s\n", CanManager::instance().isReady() ? "YES" : "NO");
             Serial.printf("TX Pin: GPIO%u\n", (unsigned)CanManager::instance().txPin());
             Serial.printf("RX Pin: GPIO%u\n", (unsigned)CanManager::instance().rxPin());
-            Serial.println("Bitrate: 250 kbps");
-            Serial.println("Mode: NO_ACK (for testing without termination)");
+            Serial.printf("Bitrate: %lu kbps (configured %lu kbps)\n",
+                          static_cast<unsigned long>(CanManager::instance().bitrate() / 1000),
+                          static_cast<unsigned long>(CanManager::instance().configuredBitrate() / 1000));
+            if (CanManager::instance().autoBaudEnabled()) {
+                const CanAutoBaudResult& baud = CanManager::instance().autoBaudResult();
+                Serial.printf("Auto-baud: %s in %lu ms (%lu probes, %lu with errors)\n",
+                              baud.locked ? "locked" : "no lock",
+                              static_cast<unsigned long>(baud.elapsed_ms),
+                              static_cast<unsigned long>(baud.probes),
+                              static_cast<unsigned long>(baud.rejected));
+            }
+            const CanBusSnapshot bus = CanManager::instance().busStats();
+            Serial.printf("State: %s, TEC: %lu, REC: %lu, bus load: %.1f%% (peak %.1f%%)\n",
+                          bus.bus_state,
+                          static_cast<unsigned long>(bus.tx_error_counter),
+                          static_cast<unsigned long>(bus.rx_error_counter),
+                          bus.load_percent, bus.peak_load_percent);
+            const CanRxStats rx = CanManager::instance().rxStats();
+            Serial.printf("RX frames: %lu, protocol task dropped: %lu, driver missed: %lu, filtered: %lu\n",
+                          static_cast<unsigned long>(rx.frames),
+                          static_cast<unsigned long>(rx.proto_dropped),
+                          static_cast<unsigned long>(rx.driver_missed),
+                          static_cast<unsigned long>(rx.filtered));
+            const CanTxStats tx = CanManager::instance().txStats();
+            Serial.printf("TX sent: %lu, failed: %lu, rejected: %lu, queue: %lu (peak %lu), recoveries: %lu\n",
+                          static_cast<unsigned long>(tx.sent),
+                          static_cast<unsigned long>(tx.failed),
+                          static_cast<unsigned long>(tx.rejected),
+                          static_cast<unsigned long>(tx.queue_depth),
+                          static_cast<unsigned long>(tx.queue_high_water),
+                          static_cast<unsigned long>(tx.recoveries));
+            const CanCoalesceStats coalesce = CanManager::instance().coalesceStats();
+            Serial.printf("Button events: %lu, frames sent: %lu, duplicates dropped: %lu, deferred: %lu, superseded: %lu\n",
+                          static_cast<unsigned long>(coalesce.events),
+                          static_cast<unsigned long>(coalesce.sent),
+                          static_cast<unsigned long>(coalesce.duplicates),
+                          static_cast<unsigned long>(coalesce.deferred),
+                          static_cast<unsigned long>(coalesce.superseded));
+            static const char* const kClaimStates[] = {"idle", "claiming", "claimed", "cannot claim", "fixed"};
+            Serial.printf("J1939 address: 0x%02X (%s), NAME 0x%016llX, contentions: %lu\n",
+                          CanManager::instance().sourceAddress(),
+                          kClaimStates[static_cast<int>(CanManager::instance().addressState())],
+                          static_cast<unsigned long long>(CanManager::instance().j1939Name()),
+                          static_cast<unsigned long>(CanManager::instance().addressContentions()));
+            const J1939TransportStats tp = CanManager::instance().transportStats();
+            Serial.printf("J1939 TP rx: %lu done, %lu aborted, %lu re-requests | tx: %lu done, %lu aborted | pool exhausted: %lu\n",
+                          static_cast<unsigned long>(tp.rx_completed),
+                          static_cast<unsigned long>(tp.rx_aborted),
+                          static_cast<unsigned long>(tp.rx_retransmits),
+                          static_cast<unsigned long>(tp.tx_completed),
+                          static_cast<unsigned long>(tp.tx_aborted),
+                          static_cast<unsigned long>(tp.pool_exhausted));
+            auto& periodic = CanPeriodicScheduler::instance();
+            Serial.printf("Periodic frames: %u, scheduled load: %.1f%%\n",
+                          static_cast<unsigned>(periodic.size()), periodic.busLoadPercent(CanManager::instance().bitrate()));
+            for (const auto& entry : periodic.stats()) {
+                Serial.printf("  %-20s %5lu ms @%4lu  sent %lu, rejected %lu, missed %lu, late avg/max %lu/%lu us\n",
+                              entry.id.c_str(),
+                              static_cast<unsigned long>(entry.period_ms),
+                              static_cast<unsigned long>(entry.phase_ms),
+                              static_cast<unsigned long>(entry.sent),
+                              static_cast<unsigned long>(entry.rejected),
+                              static_cast<unsigned long>(entry.missed),
+                              static_cast<unsigned long>(entry.avg_late_us),
+                              static_cast<unsigned long>(entry.max_late_us));
+            }
             Serial.println("======================\n");
+        } else if (cmd == "canlog") {
+            const CanRecorder::Status status = CanRecorder::instance().status();
+            Serial.printf("[CAN] Recorder %s, segment %lu: %lu blocks / %lu records written, %lu dropped, %lu write errors\n",
+                          status.enabled ? "on" : "off",
+                          static_cast<unsigned long>(status.segment),
+                          static_cast<unsigned long>(status.blocks_written),
+                          static_cast<unsigned long>(status.records_written),
+                          static_cast<unsigned long>(status.records_dropped),
+                          static_cast<unsigned long>(status.write_errors));
+            for (const auto& segment : CanRecorder::instance().segments()) {
+                Serial.printf("  %s  %lu bytes\n", CanRecorder::segmentPath(segment.index).c_str(),
+                              static_cast<unsigned long>(segment.size));
+            }
+        } else if (cmd.startsWith("cantrace")) {
+            // Deferred CAN trace: cantrace on|off|dump
+            String arg = cmd.substring(8);
+            arg.trim();
+            CanTrace& trace = CanTrace::instance();
+            if (arg == "on") {
+                trace.setEcho(true, true);
+                Serial.println("[CAN] Trace echo ON (frames + bus state)");
+            } else if (arg == "off") {
+                trace.setEcho(false, true);
+                Serial.println("[CAN] Trace echo OFF (bus state only)");
+            } else if (arg == "dump") {
+                static CanTraceRecord records[64];
+                const std::size_t count = trace.copyRecent(records, 64);
+                char line[96];
+                for (std::size_t i = 0; i < count; ++i) {
+                    CanTrace::format(records[i], line, sizeof(line));
+                    Serial.println(line);
+                }
+                Serial.printf("[CAN] %u records shown, %lu recorded, %lu dropped\n",
+                              static_cast<unsigned>(count),
+                              static_cast<unsigned long>(trace.recorded()),
+                              static_cast<unsigned long>(trace.dropped()));
+            } else {
+                Serial.println("[CMD] Usage: cantrace on|off|dump");
+            }
+        } else if (cmd.startsWith("canreplay") || cmd.startsWith("cangen ")) {
+            // canreplay [stop] | canreplay <segment> [speed] [bus] | cangen <load%> [constant|ramp|burst] [speed] [bus]
+            CanManager& can = CanManager::instance();
+            const CanReplayTarget target = cmd.endsWith(" bus") ? CanReplayTarget::BUS : CanReplayTarget::VIRTUAL;
+            CanReplayOptions options;
+            std::string error;
+            bool started = true;
+            char word[16] = {};
+            unsigned long segment = 0;
+            float value = 0.0f;
+            if (cmd == "canreplay stop") {
+                can.stopReplay();
+            } else if (sscanf(cmd.c_str(), "canreplay %lu %f", &segment, &options.speed) >= 1) {
+                started = can.startReplay(static_cast<uint32_t>(segment), target, options, error);
+            } else if (sscanf(cmd.c_str(), "cangen %f %15s %f", &value, word, &options.speed) >= 1) {
+                CanTrafficProfile profile;
+                profile.load_percent = value;
+                profile.pattern = strcmp(word, "ramp") == 0    ? CanTrafficProfile::Pattern::RAMP
+                                  : strcmp(word, "burst") == 0 ? CanTrafficProfile::Pattern::BURST
+                                                               : CanTrafficProfile::Pattern::CONSTANT;
+                started = can.startGenerator(profile, target, options, error);
+            } else if (cmd != "canreplay") {
+                Serial.println("[CMD] Usage: canreplay [stop] | canreplay <segment> [speed] [bus] | "
+                               "cangen <load%> [constant|ramp|burst] [speed] [bus]");
+            }
+            if (!started) {
+                Serial.printf("[CAN] Replay not started: %s\n", error.c_str());
+            }
+            const CanReplayEngine::Status status = can.replayStatus();
+            Serial.printf("[CAN] Replay %s at %.1fx: frame %lu/%lu, sent %lu, retried %lu, loops %lu, max late %lu us\n",
+                          CanReplayEngine::modeName(status.mode), status.speed,
+                          static_cast<unsigned long>(status.position), static_cast<unsigned long>(status.total),
+                          static_cast<unsigned long>(status.sent), static_cast<unsigned long>(status.rejected),
+                          static_cast<unsigned long>(status.loops), static_cast<unsigned long>(status.max_late_us));
+        } else if (cmd == "canfilter") {
+            // Show the acceptance filter plan and predict its pass-through on 2 s of live traffic
+            CanManager& can = CanManager::instance();
+            const CanFilterPlan& plan = can.filterPlan();
+            const char* mode = plan.mode == CanFilterPlan::Mode::SINGLE ? "single"
+                             : plan.mode == CanFilterPlan::Mode::DUAL ? "dual" : "accept-all";
+            Serial.printf("[CAN] Filter %s: %s code=0x%08lX mask=0x%08lX, %u PGN rules, %.3f%% of ID space\n",
+                          ConfigManager::instance().getConfig().can_filter.enabled ? "enabled" : "disabled",
+                          mode,
+                          static_cast<unsigned long>(plan.acceptance_code),
+                          static_cast<unsigned long>(plan.acceptance_mask),
+                          static_cast<unsigned>(can.filterRuleCount()),
+                          plan.id_space_fraction * 100.0f);
+            Serial.println("[CAN] Sampling traffic for 2 s...");
+            const CanFilterReport report = can.predictFilter(2000);
+            Serial.printf("[CAN] %lu frames: hardware would pass %lu (%.1f%%), wanted %lu, wanted-but-blocked %lu\n",
+                          static_cast<unsigned long>(report.frames),
+                          static_cast<unsigned long>(report.hw_accepted),
+                          report.passRate() * 100.0f,
+                          static_cast<unsigned long>(report.wanted),
+                          static_cast<unsigned long>(report.missed));
+        } else if (cmd == "canstats" || cmd == "canstats reset") {
+            if (cmd.endsWith("reset")) {
+                CanManager::instance().resetBusStats();
+                CanManager::instance().resetCoalesceStats();
+            }
+            const CanBusSnapshot bus = CanManager::instance().busStats();
+            const uint32_t now = millis();
+            Serial.printf("\n=== CAN Bus Statistics ===\nState: %s, TEC: %lu, REC: %lu\n", bus.bus_state,
+                          static_cast<unsigned long>(bus.tx_error_counter),
+                          static_cast<unsigned long>(bus.rx_error_counter));
+            Serial.printf("Frames rx: %lu, tx: %lu, load: %.1f%% (peak %.1f%%), untracked: %lu\n",
+                          static_cast<unsigned long>(bus.rx_frames),
+                          static_cast<unsigned long>(bus.tx_frames),
+                          bus.load_percent, bus.peak_load_percent,
+                          static_cast<unsigned long>(bus.untracked_frames));
+            Serial.print("Alerts:");
+            for (std::size_t i = 0; i < bus.alerts.size(); ++i) {
+                Serial.printf(" %s=%lu", CanBusStats::alertName(static_cast<CanBusAlert>(i)),
+                              static_cast<unsigned long>(bus.alerts[i]));
+            }
+            Serial.println();
+            Serial.println("  PGN        rx     rx/s       tx     tx/s   last seen");
+            for (const auto& pgn : bus.pgns) {
+                const uint32_t last = std::max(pgn.rx_frames ? pgn.last_rx_ms : 0, pgn.tx_frames ? pgn.last_tx_ms : 0);
+                Serial.printf("  %05lX %8lu %8.1f %8lu %8.1f %8lu ms ago\n",
+                              static_cast<unsigned long>(pgn.pgn),
+                              static_cast<unsigned long>(pgn.rx_frames), pgn.rx_per_sec,
+                              static_cast<unsigned long>(pgn.tx_frames), pgn.tx_per_sec,
+                              static_cast<unsigned long>(now - last));
+            }
+        } else if (cmd.startsWith("canbaud ")) {
+            // Runtime bitrate change (not saved): canbaud <125|250|500|1000|auto>
+            String arg = cmd.substring(8);
+            arg.trim();
+            CanBusConfig bus;
+            bus.bitrate = CanManager::instance().configuredBitrate();
+            bus.auto_baud = arg == "auto";
+            if (!bus.auto_baud) {
+                bus.bitrate = static_cast<uint32_t>(arg.toInt()) * 1000;
+            }
+            if (!canBitrateSupported(bus.bitrate)) {
+                Serial.println("[CMD] Usage: canbaud <125|250|500|1000|auto>");
+            } else if (CanManager::instance().configureBus(bus)) {
+                Serial.printf("[CAN] Running at %lu kbps\n",
+                              static_cast<unsigned long>(CanManager::instance().bitrate() / 1000));
+            } else {
+                Serial.println("[CAN] Bitrate change failed");
+            }
+        } else if (cmd == "canlat" || cmd == "canlat reset") {
+            CanLatencyTracer& tracer = CanLatencyTracer::instance();
+            if (cmd.endsWith("reset")) {
+                tracer.reset();
+            }
+            const CanLatencySnapshot lat = tracer.snapshot();
+            Serial.printf("\n=== Button Press Latency ===\nPresses: %lu, on the wire: %lu, abandoned: %lu\n",
+                          static_cast<unsigned long>(lat.presses), static_cast<unsigned long>(lat.completed),
+                          static_cast<unsigned long>(lat.abandoned));
+            Serial.println("  stage               count    p50 us    p99 us    max us   last us");
+            for (std::size_t i = 0; i < lat.stages.size(); ++i) {
+                const CanLatencySnapshot::Stage& stage = lat.stages[i];
+                Serial.printf("  %-18s %6lu %9lu %9lu %9lu %9lu\n",
+                              CanLatencyTracer::stageName(static_cast<CanLatencyStage>(i)),
+                              static_cast<unsigned long>(stage.count), static_cast<unsigned long>(stage.p50_us),
+                              static_cast<unsigned long>(stage.p99_us), static_cast<unsigned long>(stage.max_us),
+                              static_cast<unsigned long>(lat.last[i]));
+            }
         } else if (cmd.startsWith("canreinit ")) {
             // Reinitialize CAN with custom pins: canreinit <tx_pin> <rx_pin>
             String params = cmd.substring(9);
@@ -485,9 +742,11 @@ void loop() {
             if (spaceIdx > 0) {
                 int tx = params.substring(0, spaceIdx).toInt();
                 int rx = params.substring(spaceIdx + 1).toInt();
-                Serial.printf("[CAN] Reinit with TX=%d RX=%d at 250kbps...\n", tx, rx);
+                const uint32_t bitrate = CanManager::instance().configuredBitrate();
+                Serial.printf("[CAN] Reinit with TX=%d RX=%d at %lukbps...\n", tx, rx,
+                              static_cast<unsigned long>(bitrate / 1000));
                 CanManager::instance().stop();
-                if (CanManager::instance().begin(static_cast<gpio_num_t>(tx), static_cast<gpio_num_t>(rx), 250000)) {
+                if (CanManager::instance().begin(tx, rx, bitrate)) {
                     Serial.println("[CAN] Reinitialized successfully");
                 } else {
                     Serial.println("[CAN] Reinit failed");
@@ -511,10 +770,21 @@ void loop() {
             Serial.println("CAN BUS (Infinitybox POWERCELL NGX):");
             Serial.println("  canstatus        - Show CAN bus status");
             Serial.println("  canpoll <1-16>   - Poll POWERCELL NGX at address");
+            Serial.println("  canmodules       - Module output states from status replies");
             Serial.println("  canconfig <1-16> - Configure POWERCELL NGX (default settings)");
             Serial.println("  canmon           - Monitor CAN bus for 10 seconds");
             Serial.println("  cansend <pgn> <data> - Send raw CAN frame");
             Serial.println("                     Example: cansend FF41 11 00 00 00 00 00 00 00");
+            Serial.println("  cantrace on|off  - Echo TX/RX trace records to serial");
+            Serial.println("  cantrace dump    - Print the most recent trace records");
+            Serial.println("  canlog           - Flight recorder status and segments (/api/can/log)");
+            Serial.println("  canreplay <seg> [speed] [bus] - Replay a log segment (virtual bus unless 'bus')");
+            Serial.println("  cangen <load%> [constant|ramp|burst] [speed] [bus] - Generate bus load");
+            Serial.println("  canreplay [stop] - Replay/generator status, or stop it");
+            Serial.println("  canfilter        - Show acceptance filter plan and predicted pass-through");
+            Serial.println("  canstats [reset] - Per-PGN counters, alerts and bus load");
+            Serial.println("  canlat [reset]   - Button press-to-wire latency (p50/p99 per stage)");
+            Serial.println("  canbaud <kbps|auto> - Switch bitrate or auto-detect it (until reboot)");
             Serial.println("GENERAL:");
             Serial.println("  help or ?        - Show this help");
             Serial.println("======================\n");
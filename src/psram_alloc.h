@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
+#include <new>
+
+#ifdef ARDUINO
+#include <esp_heap_caps.h>
+#endif
+
+// Large, long-lived buffers belong in the 8 MB PSRAM rather than internal RAM.
+// Falls back to the default heap when PSRAM is missing (and on host builds).
+inline void* psramAlloc(std::size_t bytes) {
+#ifdef ARDUINO
+    void* ptr = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!ptr) {
+        ptr = heap_caps_malloc(bytes, MALLOC_CAP_8BIT);
+    }
+    return ptr;
+#else
+    return std::malloc(bytes);
+#endif
+}
+
+inline void psramFree(void* ptr) {
+#ifdef ARDUINO
+    heap_caps_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+inline void* psramRealloc(void* ptr, std::size_t bytes) {
+#ifdef ARDUINO
+    void* grown = heap_caps_realloc(ptr, bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!grown) {
+        grown = heap_caps_realloc(ptr, bytes, MALLOC_CAP_8BIT);
+    }
+    return grown;
+#else
+    return std::realloc(ptr, bytes);
+#endif
+}
+
+// Standard allocator over psramAlloc for containers of config records. malloc() keeps requests
+// under 4 KB in internal RAM (CONFIG_SPIRAM_MALLOC_ALWAYSINTERNAL), so without it a page's
+// button vector sits there while it is small and passes through it on every regrowth.
+// Out of memory throws std::bad_alloc as std::allocator does; ConfigManager::updateFromJson()
+// turns it into a rejected import.
+template <typename T>
+struct PsramAllocator {
+    using value_type = T;
+
+    PsramAllocator() = default;
+    template <typename U>
+    PsramAllocator(const PsramAllocator<U>&) {}
+
+    T* allocate(std::size_t count) {
+        if (count > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        void* ptr = psramAlloc(count * sizeof(T));
+        if (!ptr) {
+            throw std::bad_alloc();  // Both heaps are exhausted
+        }
+        return static_cast<T*>(ptr);
+    }
+    void deallocate(T* ptr, std::size_t) { psramFree(ptr); }
+};
+
+template <typename T, typename U>
+bool operator==(const PsramAllocator<T>&, const PsramAllocator<U>&) {
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const PsramAllocator<T>&, const PsramAllocator<U>&) {
+    return false;
+}
+
+// Allocator policy for BasicJsonDocument: the document's memory pool comes from PSRAM
+struct PsramJsonAllocator {
+    void* allocate(std::size_t bytes) { return psramAlloc(bytes); }
+    void deallocate(void* ptr) { psramFree(ptr); }
+    void* reallocate(void* ptr, std::size_t bytes) { return psramRealloc(ptr, bytes); }
+};
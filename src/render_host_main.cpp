@@ -0,0 +1,234 @@
+// Host bench for the page render model (render_model.h).
+//
+// Times the config lookups UIBuilder::buildPage makes for a 12-button page,
+// the old way (every page switch parses each "#RRGGBB" string, walks the
+// button -> page -> theme fallbacks, matches font names and text_align
+// strings) and the new way (reading the RenderButtons buildRenderModel
+// resolved on the last config change), plus what that resolution costs. The
+// LVGL calls that follow are the same either way and need a display, so they
+// are not part of either time. Also checks that both ways pick the same
+// colours, fonts and placements for every button.
+//
+// Built by the PlatformIO `native_render` environment (pio run -e
+// native_render, then .pio/build/native_render/program); the device firmware
+// never sees this file.
+
+#ifndef ARDUINO
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "render_model.h"
+
+namespace {
+constexpr int kIterations = 20000;
+constexpr std::size_t kButtons = 12;
+
+// What buildPage needs per button, however it was worked out
+struct ResolvedButton {
+    std::uint32_t color;
+    std::uint32_t pressed_color;
+    bool derive_pressed;
+    std::uint32_t border_color;
+    std::uint32_t text_color;
+    RenderFont font;
+    RenderPlacement placement;
+};
+
+volatile std::uint32_t g_sink = 0;
+
+// UIBuilder::colorFromHex before this change, minus the lv_color_t
+std::uint32_t legacyColorFromHex(const std::string& hex, std::uint32_t fallback) {
+    if (hex.size() != 7 || hex[0] != '#') {
+        return fallback;
+    }
+    char* end_ptr = nullptr;
+    unsigned long value = strtoul(hex.c_str() + 1, &end_ptr, 16);
+    if (end_ptr == nullptr || *end_ptr != '\0') {
+        return fallback;
+    }
+    return static_cast<std::uint32_t>(value);
+}
+
+// UIBuilder::fontFromName before this change: a chain of string compares
+RenderFont legacyFontFromName(const std::string& name) {
+    static const char* const kNames[] = {
+        "montserrat_12", "montserrat_14", "montserrat_16", "montserrat_18", "montserrat_20", "montserrat_22",
+        "montserrat_24", "montserrat_26", "montserrat_28", "montserrat_30", "montserrat_32", "montserrat_34",
+        "montserrat_36", "montserrat_38", "montserrat_40", "montserrat_42", "montserrat_44", "montserrat_46",
+        "montserrat_48", "dejavu_16", "simsun_16", "unscii_8", "unscii_16",
+    };
+    for (std::size_t i = 0; i < sizeof(kNames) / sizeof(kNames[0]); ++i) {
+        if (name == kNames[i]) {
+            return static_cast<RenderFont>(i);
+        }
+    }
+    return RenderFont::MONTSERRAT_16;
+}
+
+// The lookups in buildPage's button loop before this change
+ResolvedButton legacyResolve(const DeviceConfig& config, const PageConfig& page, const ButtonConfig& button) {
+    ResolvedButton out;
+    out.border_color = !button.border_color.empty()
+        ? legacyColorFromHex(button.border_color, 0x3A3A3A)
+        : legacyColorFromHex(config.theme.border_color, 0x3A3A3A);
+
+    const std::string button_color_hex = !button.color.empty() ? button.color : config.theme.accent_color;
+    out.color = legacyColorFromHex(button_color_hex, 0xFFA500);
+
+    const std::string pressed_hex = !button.pressed_color.empty() ? button.pressed_color : "";
+    out.derive_pressed = pressed_hex.empty() || legacyColorFromHex(pressed_hex, 0x1000000) == 0x1000000;
+    out.pressed_color = out.derive_pressed ? 0 : legacyColorFromHex(pressed_hex, 0);
+
+    const std::uint32_t theme_text_fallback = legacyColorFromHex(config.theme.text_primary, 0xFFFFFF);
+    const std::uint32_t page_text_fallback = !page.text_color.empty()
+        ? legacyColorFromHex(page.text_color, theme_text_fallback)
+        : theme_text_fallback;
+    out.text_color = page_text_fallback;
+    if (!button.text_color.empty()) {
+        out.text_color = legacyColorFromHex(button.text_color, page_text_fallback);
+    }
+
+    if (!button.font_name.empty() && button.font_name != "montserrat_16") {
+        out.font = legacyFontFromName(button.font_name);
+    } else if (!button.font_family.empty() && button.font_family != "montserrat") {
+        std::string fontKey = button.font_family + "_" + std::to_string(button.font_size);
+        out.font = legacyFontFromName(fontKey);
+    } else {
+        if (button.font_size <= 13) out.font = RenderFont::MONTSERRAT_12;
+        else if (button.font_size <= 15) out.font = RenderFont::MONTSERRAT_14;
+        else if (button.font_size <= 17) out.font = RenderFont::MONTSERRAT_16;
+        else if (button.font_size <= 19) out.font = RenderFont::MONTSERRAT_18;
+        else if (button.font_size <= 21) out.font = RenderFont::MONTSERRAT_20;
+        else if (button.font_size <= 23) out.font = RenderFont::MONTSERRAT_22;
+        else if (button.font_size <= 25) out.font = RenderFont::MONTSERRAT_24;
+        else if (button.font_size <= 27) out.font = RenderFont::MONTSERRAT_26;
+        else if (button.font_size <= 29) out.font = RenderFont::MONTSERRAT_28;
+        else if (button.font_size <= 31) out.font = RenderFont::MONTSERRAT_30;
+        else out.font = RenderFont::MONTSERRAT_32;
+    }
+
+    out.placement = RenderPlacement::CENTER;
+    if (button.text_align == "top-left") out.placement = RenderPlacement::TOP_LEFT;
+    else if (button.text_align == "top-center") out.placement = RenderPlacement::TOP_CENTER;
+    else if (button.text_align == "top-right") out.placement = RenderPlacement::TOP_RIGHT;
+    else if (button.text_align == "center") out.placement = RenderPlacement::CENTER;
+    else if (button.text_align == "bottom-left") out.placement = RenderPlacement::BOTTOM_LEFT;
+    else if (button.text_align == "bottom-center") out.placement = RenderPlacement::BOTTOM_CENTER;
+    else if (button.text_align == "bottom-right") out.placement = RenderPlacement::BOTTOM_RIGHT;
+    return out;
+}
+
+ResolvedButton modelResolve(const RenderButton& button) {
+    return ResolvedButton{button.color, button.pressed_color, button.derive_pressed, button.border_color,
+                          button.text_color, button.font, button.placement};
+}
+
+bool sameButton(const ResolvedButton& a, const ResolvedButton& b) {
+    return a.color == b.color && a.derive_pressed == b.derive_pressed &&
+           (a.derive_pressed || a.pressed_color == b.pressed_color) && a.border_color == b.border_color &&
+           a.text_color == b.text_color && a.font == b.font && a.placement == b.placement;
+}
+
+void consume(const ResolvedButton& button) {
+    g_sink = g_sink + button.color + button.pressed_color + button.border_color + button.text_color +
+             static_cast<std::uint32_t>(button.font) + static_cast<std::uint32_t>(button.placement);
+}
+
+// A themed page of 12 buttons the way the web editor leaves them: some inherit everything, others
+// override colours, fonts and alignment, a few with values the decoder lets through but that do not parse
+DeviceConfig benchConfig() {
+    static const char* const kAligns[] = {"center", "top-left", "bottom-right", "top-center", "bottom-left", ""};
+    static const char* const kFamilies[] = {"montserrat", "montserrat", "unscii", "dejavu"};
+
+    DeviceConfig config;
+    config.theme.accent_color = "#FF8800";
+    config.theme.border_color = "#444444";
+    config.theme.text_primary = "#F0F0F0";
+    config.theme.text_secondary = "#909090";
+    config.theme.page_bg_color = "#101418";
+
+    PageConfig page;
+    page.id = "controls";
+    page.name = "Controls";
+    page.rows = 3;
+    page.cols = 4;
+    page.text_color = "#FAFAFA";
+    for (std::size_t i = 0; i < kButtons; ++i) {
+        ButtonConfig button;
+        button.id = "button_" + std::to_string(i);
+        button.label = "Output " + std::to_string(i + 1);
+        button.row = static_cast<std::uint8_t>(i / page.cols);
+        button.col = static_cast<std::uint8_t>(i % page.cols);
+        button.color = i % 3 == 0 ? "" : "#2266AA";
+        button.pressed_color = i % 4 == 0 ? "#113355" : i % 4 == 1 ? "" : i % 4 == 2 ? "#GG0000" : "#0A0A0A";
+        button.border_color = i % 2 == 0 ? "" : "#8899AA";
+        button.text_color = i % 5 == 0 ? "#000000" : i % 5 == 1 ? "bad" : "";
+        button.font_family = kFamilies[i % 4];
+        button.font_size = static_cast<std::uint8_t>(12 + 2 * (i % 11));
+        button.font_name = i % 6 == 5 ? "montserrat_40" : "";
+        button.text_align = kAligns[i % 6];
+        page.buttons.push_back(button);
+    }
+    config.pages.push_back(page);
+
+    PageConfig empty;
+    empty.id = "empty";
+    empty.bg_color = "#202020";
+    config.pages.push_back(empty);
+    return config;
+}
+
+template <typename Fn>
+double meanMicros(Fn fn) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+        fn();
+    }
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / kIterations;
+}
+}
+
+int main() {
+    const DeviceConfig config = benchConfig();
+    const PageConfig& page = config.pages.front();
+
+    RenderModel model;
+    buildRenderModel(config, 0, model);
+    const RenderPage& render_page = model.pages.front();
+    const RenderButton* render_buttons = model.pageButtons(render_page);
+
+    bool same = render_page.button_count == page.buttons.size();
+    for (std::size_t i = 0; same && i < page.buttons.size(); ++i) {
+        same = sameButton(legacyResolve(config, page, page.buttons[i]), modelResolve(render_buttons[i]));
+    }
+
+    const double legacy_us = meanMicros([&] {
+        for (const ButtonConfig& button : page.buttons) {
+            consume(legacyResolve(config, page, button));
+        }
+    });
+    const double model_us = meanMicros([&] {
+        const RenderPage& current = model.pages.front();
+        const RenderButton* buttons = model.pageButtons(current);
+        for (std::size_t i = 0; i < current.button_count; ++i) {
+            consume(modelResolve(buttons[i]));
+        }
+    });
+    RenderModel rebuilt;
+    const double build_us = meanMicros([&] {
+        buildRenderModel(config, 0, rebuilt);
+        g_sink = g_sink + static_cast<std::uint32_t>(rebuilt.buttons.size());
+    });
+
+    std::printf("Page build lookups, %zu-button page (%d runs)\n", kButtons, kIterations);
+    std::printf("    config strings: %8.3f us per page switch\n", legacy_us);
+    std::printf("    render model  : %8.3f us per page switch\n", model_us);
+    std::printf("    model rebuild : %8.3f us per config change (all %zu pages)\n", build_us, config.pages.size());
+    std::printf("    resolved styles: %s\n", same ? "identical" : "differ");
+    return same ? 0 : 1;
+}
+
+#endif
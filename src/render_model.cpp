@@ -0,0 +1,156 @@
+#include "render_model.h"
+
+namespace {
+// UITheme's palette, for colours the config leaves unset or malformed
+constexpr std::uint32_t kSurfaceRgb = 0x2A2A2A;
+constexpr std::uint32_t kAccentRgb = 0xFFA500;
+constexpr std::uint32_t kTextPrimaryRgb = 0xFFFFFF;
+constexpr std::uint32_t kTextSecondaryRgb = 0xAAAAAA;
+constexpr std::uint32_t kBorderRgb = 0x3A3A3A;
+
+const struct {
+    const char* name;
+    RenderFont font;
+} kFontNames[] = {
+    {"montserrat_12", RenderFont::MONTSERRAT_12}, {"montserrat_14", RenderFont::MONTSERRAT_14},
+    {"montserrat_16", RenderFont::MONTSERRAT_16}, {"montserrat_18", RenderFont::MONTSERRAT_18},
+    {"montserrat_20", RenderFont::MONTSERRAT_20}, {"montserrat_22", RenderFont::MONTSERRAT_22},
+    {"montserrat_24", RenderFont::MONTSERRAT_24}, {"montserrat_26", RenderFont::MONTSERRAT_26},
+    {"montserrat_28", RenderFont::MONTSERRAT_28}, {"montserrat_30", RenderFont::MONTSERRAT_30},
+    {"montserrat_32", RenderFont::MONTSERRAT_32}, {"montserrat_34", RenderFont::MONTSERRAT_34},
+    {"montserrat_36", RenderFont::MONTSERRAT_36}, {"montserrat_38", RenderFont::MONTSERRAT_38},
+    {"montserrat_40", RenderFont::MONTSERRAT_40}, {"montserrat_42", RenderFont::MONTSERRAT_42},
+    {"montserrat_44", RenderFont::MONTSERRAT_44}, {"montserrat_46", RenderFont::MONTSERRAT_46},
+    {"montserrat_48", RenderFont::MONTSERRAT_48}, {"dejavu_16", RenderFont::DEJAVU_16},
+    {"simsun_16", RenderFont::SIMSUN_16},         {"unscii_8", RenderFont::UNSCII_8},
+    {"unscii_16", RenderFont::UNSCII_16},
+};
+
+const struct {
+    const char* name;
+    RenderPlacement placement;
+} kPlacementNames[] = {
+    {"top-left", RenderPlacement::TOP_LEFT},       {"top-center", RenderPlacement::TOP_CENTER},
+    {"top-right", RenderPlacement::TOP_RIGHT},     {"center", RenderPlacement::CENTER},
+    {"bottom-left", RenderPlacement::BOTTOM_LEFT}, {"bottom-center", RenderPlacement::BOTTOM_CENTER},
+    {"bottom-right", RenderPlacement::BOTTOM_RIGHT},
+};
+
+std::uint32_t colorOr(const std::string& hex, std::uint32_t fallback) {
+    std::uint32_t rgb = 0;
+    return parseHexColor(hex, rgb) ? rgb : fallback;
+}
+
+// The first non-empty of button > page > theme decides; a malformed override falls to the palette, not further
+std::uint32_t overrideOr(const std::string& hex, std::uint32_t inherited, std::uint32_t palette) {
+    return hex.empty() ? inherited : colorOr(hex, palette);
+}
+
+RenderPlacement placementFromName(const std::string& name) {
+    for (const auto& entry : kPlacementNames) {
+        if (name == entry.name) {
+            return entry.placement;
+        }
+    }
+    return RenderPlacement::CENTER;
+}
+
+// font_name wins unless it is the default; then a non-default family at font_size; else Montserrat at the
+// nearest size at or below font_size (rounded to even sizes 12..32)
+RenderFont buttonFont(const ButtonConfig& button) {
+    if (!button.font_name.empty() && button.font_name != "montserrat_16") {
+        return renderFontFromName(button.font_name);
+    }
+    if (!button.font_family.empty() && button.font_family != "montserrat") {
+        return renderFontFromName(button.font_family + "_" + std::to_string(button.font_size));
+    }
+    if (button.font_size <= 13) {
+        return RenderFont::MONTSERRAT_12;
+    }
+    if (button.font_size > 31) {
+        return RenderFont::MONTSERRAT_32;
+    }
+    const unsigned step = (button.font_size - 12u) / 2u;  // 14-15 -> 1, ..., 30-31 -> 9
+    return static_cast<RenderFont>(static_cast<unsigned>(RenderFont::MONTSERRAT_12) + step);
+}
+}
+
+bool parseHexColor(const std::string& hex, std::uint32_t& rgb) {
+    if (hex.size() != 7 || hex[0] != '#') {
+        return false;
+    }
+    std::uint32_t value = 0;
+    for (std::size_t i = 1; i < hex.size(); ++i) {
+        const char c = hex[i];
+        std::uint32_t digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            return false;
+        }
+        value = (value << 4) | digit;
+    }
+    rgb = value;
+    return true;
+}
+
+RenderFont renderFontFromName(const std::string& name) {
+    for (const auto& entry : kFontNames) {
+        if (name == entry.name) {
+            return entry.font;
+        }
+    }
+    return RenderFont::MONTSERRAT_16;
+}
+
+void buildRenderModel(const DeviceConfig& config, std::uint32_t generation, RenderModel& model) {
+    model.pages.clear();
+    model.buttons.clear();
+    model.generation = generation;
+    model.pages.reserve(config.pages.size());
+    std::size_t total_buttons = 0;
+    for (const PageConfig& page : config.pages) {
+        total_buttons += page.buttons.size();
+    }
+    model.buttons.reserve(total_buttons);
+
+    const ThemeConfig& theme = config.theme;
+    const std::uint32_t theme_text = colorOr(theme.text_primary, kTextPrimaryRgb);
+    const std::uint32_t theme_border = colorOr(theme.border_color, kBorderRgb);
+    const std::uint32_t theme_accent = colorOr(theme.accent_color, kAccentRgb);
+    const std::uint32_t theme_page_bg = colorOr(theme.page_bg_color, kSurfaceRgb);
+    const std::uint32_t theme_secondary = colorOr(theme.text_secondary, kTextSecondaryRgb);
+
+    for (const PageConfig& page : config.pages) {
+        RenderPage out;
+        out.bg_color = overrideOr(page.bg_color, theme_page_bg, kSurfaceRgb);
+        out.empty_text_color = theme_secondary;
+        out.rows = page.rows;
+        out.cols = page.cols;
+        out.first_button = static_cast<std::uint16_t>(model.buttons.size());
+        out.button_count = static_cast<std::uint16_t>(page.buttons.size());
+        const std::uint32_t page_text = overrideOr(page.text_color, theme_text, theme_text);
+
+        for (const ButtonConfig& button : page.buttons) {
+            RenderButton rb;
+            rb.color = overrideOr(button.color, theme_accent, kAccentRgb);
+            rb.derive_pressed = !parseHexColor(button.pressed_color, rb.pressed_color);
+            rb.border_color = overrideOr(button.border_color, theme_border, kBorderRgb);
+            rb.text_color = overrideOr(button.text_color, page_text, page_text);
+            rb.font = buttonFont(button);
+            rb.placement = placementFromName(button.text_align);
+            rb.row = button.row;
+            rb.col = button.col;
+            rb.row_span = button.row_span;
+            rb.col_span = button.col_span;
+            rb.corner_radius = button.corner_radius;
+            rb.border_width = button.border_width;
+            model.buttons.push_back(rb);
+        }
+        model.pages.push_back(out);
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "config_types.h"
+
+// What UIBuilder::buildPage draws, resolved once per config change
+// (UIBuilder::applyConfig) instead of on every page switch: colours parsed to
+// 0xRRGGBB, fonts and text placement turned into enums, and the button ->
+// page -> theme fallbacks already applied. Nothing here touches LVGL, so the
+// host bench (render_host_main.cpp) builds it too; UIBuilder maps the enums
+// to LVGL fonts and alignments with lookup tables.
+
+enum class RenderFont : std::uint8_t {
+    MONTSERRAT_12,
+    MONTSERRAT_14,
+    MONTSERRAT_16,
+    MONTSERRAT_18,
+    MONTSERRAT_20,
+    MONTSERRAT_22,
+    MONTSERRAT_24,
+    MONTSERRAT_26,
+    MONTSERRAT_28,
+    MONTSERRAT_30,
+    MONTSERRAT_32,
+    MONTSERRAT_34,
+    MONTSERRAT_36,
+    MONTSERRAT_38,
+    MONTSERRAT_40,
+    MONTSERRAT_42,
+    MONTSERRAT_44,
+    MONTSERRAT_46,
+    MONTSERRAT_48,
+    DEJAVU_16,
+    SIMSUN_16,
+    UNSCII_8,
+    UNSCII_16,
+    COUNT
+};
+
+// ButtonConfig::text_align
+enum class RenderPlacement : std::uint8_t {
+    TOP_LEFT,
+    TOP_CENTER,
+    TOP_RIGHT,
+    CENTER,
+    BOTTOM_LEFT,
+    BOTTOM_CENTER,
+    BOTTOM_RIGHT,
+    COUNT
+};
+
+// Button i of a page is config.pages[page].buttons[i]: label, icon, CAN actions and module binding
+struct RenderButton {
+    std::uint32_t color = 0;      // 0xRRGGBB
+    std::uint32_t pressed_color = 0;
+    std::uint32_t border_color = 0;
+    std::uint32_t text_color = 0;
+    bool derive_pressed = true;   // No pressed colour: darken `color` when drawing
+    RenderFont font = RenderFont::MONTSERRAT_16;
+    RenderPlacement placement = RenderPlacement::CENTER;
+    std::uint8_t row = 0;
+    std::uint8_t col = 0;
+    std::uint8_t row_span = 1;
+    std::uint8_t col_span = 1;
+    std::uint8_t corner_radius = 0;
+    std::uint8_t border_width = 0;
+};
+
+struct RenderPage {
+    std::uint32_t bg_color = 0;
+    std::uint32_t empty_text_color = 0;  // The "no buttons" message
+    std::uint8_t rows = 1;
+    std::uint8_t cols = 1;
+    std::uint16_t first_button = 0;      // Into RenderModel::buttons
+    std::uint16_t button_count = 0;
+};
+
+struct RenderModel {
+    std::vector<RenderPage> pages;
+    std::vector<RenderButton> buttons;  // Every page's buttons, page by page
+    std::uint32_t generation = 0;       // ConfigManager::editGeneration() of the config it was built from
+
+    const RenderButton* pageButtons(const RenderPage& page) const { return buttons.data() + page.first_button; }
+};
+
+// Rebuilds `model` from `config`, which must not change meanwhile (hold ConfigManager::editLock()). The model
+// keeps no pointers into config: a reader that goes back to config for a button first checks that
+// `generation` is still the current one, under the same lock
+void buildRenderModel(const DeviceConfig& config, std::uint32_t generation, RenderModel& model);
+
+// "#RRGGBB" -> 0xRRGGBB; false for anything else
+bool parseHexColor(const std::string& hex, std::uint32_t& rgb);
+// Config font names ("montserrat_24", "unscii_8"); unknown names give MONTSERRAT_16
+RenderFont renderFontFromName(const std::string& name);
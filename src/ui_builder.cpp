@@ -11,7 +11,9 @@
 
 #include <ESP_Panel_Library.h>
 
+#include "asset_store.h"
 #include "can_manager.h"
+#include "can_module_status.h"
 #include "config_manager.h"
 #include "ota_manager.h"
 #include "icon_library.h"
@@ -21,6 +23,22 @@
 
 extern ESP_Panel* panel;
 
+namespace {
+// An action button's event user data: its page and its index on that page, not a pointer into the config,
+// which a web edit can reallocate before applyConfig() rebuilds the page
+constexpr unsigned kButtonIndexBits = 16;
+
+void* packButtonRef(std::size_t page, std::size_t button) {
+    return reinterpret_cast<void*>(static_cast<uintptr_t>((page << kButtonIndexBits) | button));
+}
+
+void unpackButtonRef(const void* ref, std::size_t& page, std::size_t& button) {
+    const uintptr_t value = reinterpret_cast<uintptr_t>(ref);
+    page = static_cast<std::size_t>(value >> kButtonIndexBits);
+    button = static_cast<std::size_t>(value & ((uintptr_t{1} << kButtonIndexBits) - 1));
+}
+}
+
 UIBuilder& UIBuilder::instance() {
     static UIBuilder inst;
     return inst;
@@ -28,6 +46,7 @@ UIBuilder& UIBuilder::instance() {
 
 void UIBuilder::begin() {
     config_ = &ConfigManager::instance().getConfig();
+    rebuildRenderModel();
 
     // Apply display settings before constructing UI
     loadSleepIcon();
@@ -63,6 +82,7 @@ void UIBuilder::begin() {
 
 void UIBuilder::applyConfig(const DeviceConfig& config) {
     config_ = &config;
+    rebuildRenderModel();
 
     loadSleepIcon();
     setBrightness(config.display.brightness);
@@ -80,6 +100,12 @@ void UIBuilder::applyConfig(const DeviceConfig& config) {
     updateHeaderBranding();
 }
 
+void UIBuilder::rebuildRenderModel() {
+    ConfigManager& config_mgr = ConfigManager::instance();
+    auto lock = config_mgr.editLock();
+    buildRenderModel(*config_, config_mgr.editGeneration(), render_model_);
+}
+
 void UIBuilder::markDirty() {
     dirty_ = true;
 }
@@ -408,6 +434,8 @@ void UIBuilder::buildEmptyState() {
         return;
     }
 
+    module_bindings_.clear();
+    drawn_button_ids_.clear();
     lv_obj_clean(page_container_);
     lv_obj_remove_style_all(page_container_);
     lv_color_t bg = config_ ? colorFromHex(config_->theme.page_bg_color, UITheme::COLOR_SURFACE) : UITheme::COLOR_SURFACE;
@@ -432,7 +460,20 @@ void UIBuilder::buildEmptyState() {
 }
 
 void UIBuilder::buildPage(std::size_t index) {
-    if (!config_ || index >= config_->pages.size()) {
+    if (!config_) {
+        buildEmptyState();
+        return;
+    }
+
+    // A web edit since the last build may have moved or freed the pages and buttons the model was built from
+    // (applyConfig() only runs on the next loop()), so rebuild it first; the lock keeps config_ as it is until
+    // the page is drawn
+    ConfigManager& config_mgr = ConfigManager::instance();
+    auto lock = config_mgr.editLock();
+    if (render_model_.generation != config_mgr.editGeneration()) {
+        buildRenderModel(*config_, config_mgr.editGeneration(), render_model_);
+    }
+    if (index >= render_model_.pages.size()) {
         buildEmptyState();
         return;
     }
@@ -441,18 +482,17 @@ void UIBuilder::buildPage(std::size_t index) {
         return;
     }
 
+    // Colours, fonts and alignment come pre-resolved from render_model_; only LVGL work happens here
     active_page_ = index;
-    const PageConfig& page = config_->pages[index];
-
-    const std::string page_bg_hex = !page.bg_color.empty()
-        ? page.bg_color
-        : (config_ ? config_->theme.page_bg_color : "#0F0F0F");
+    const RenderPage& page = render_model_.pages[index];
 
+    module_bindings_.clear();
+    drawn_button_ids_.clear();
     lv_obj_clean(page_container_);
     lv_obj_remove_style_all(page_container_);
     lv_obj_set_width(page_container_, lv_pct(100));
     lv_obj_set_flex_grow(page_container_, 1);
-    lv_obj_set_style_bg_color(page_container_, colorFromHex(page_bg_hex, UITheme::COLOR_SURFACE), 0);
+    lv_obj_set_style_bg_color(page_container_, lv_color_hex(page.bg_color), 0);
     lv_obj_set_style_bg_opa(page_container_, LV_OPA_COVER, 0);
     lv_obj_set_style_radius(page_container_, 0, 0);
     lv_obj_set_style_pad_all(page_container_, UITheme::SPACE_MD, 0);
@@ -471,7 +511,7 @@ void UIBuilder::buildPage(std::size_t index) {
     }
     grid_rows_.back() = LV_GRID_TEMPLATE_LAST;
 
-    if (page.buttons.empty()) {
+    if (page.button_count == 0) {
         // No grid layout - just center the message
         lv_obj_set_layout(page_container_, LV_LAYOUT_FLEX);
         lv_obj_set_flex_flow(page_container_, LV_FLEX_FLOW_COLUMN);
@@ -480,8 +520,7 @@ void UIBuilder::buildPage(std::size_t index) {
         lv_obj_t* label = lv_label_create(page_container_);
         lv_label_set_text(label, "This page has no buttons yet.");
         lv_obj_set_style_text_font(label, UITheme::FONT_BODY, 0);
-        lv_color_t secondary = config_ ? colorFromHex(config_->theme.text_secondary, UITheme::COLOR_TEXT_SECONDARY) : UITheme::COLOR_TEXT_SECONDARY;
-        lv_obj_set_style_text_color(label, secondary, 0);
+        lv_obj_set_style_text_color(label, lv_color_hex(page.empty_text_color), 0);
         updateNavSelection();
         return;
     }
@@ -491,33 +530,44 @@ void UIBuilder::buildPage(std::size_t index) {
     lv_obj_set_style_pad_gap(page_container_, UITheme::SPACE_SM, 0);
     lv_obj_set_grid_dsc_array(page_container_, grid_cols_.data(), grid_rows_.data());
 
-    for (const auto& button : page.buttons) {
+    // RenderPlacement -> label alignment within the button, and text alignment within the label
+    static const lv_align_t kPlacementAlign[] = {
+        LV_ALIGN_TOP_LEFT, LV_ALIGN_TOP_MID, LV_ALIGN_TOP_RIGHT, LV_ALIGN_CENTER,
+        LV_ALIGN_BOTTOM_LEFT, LV_ALIGN_BOTTOM_MID, LV_ALIGN_BOTTOM_RIGHT,
+    };
+    static const lv_text_align_t kPlacementTextAlign[] = {
+        LV_TEXT_ALIGN_LEFT, LV_TEXT_ALIGN_CENTER, LV_TEXT_ALIGN_RIGHT, LV_TEXT_ALIGN_CENTER,
+        LV_TEXT_ALIGN_LEFT, LV_TEXT_ALIGN_CENTER, LV_TEXT_ALIGN_RIGHT,
+    };
+    static_assert(sizeof(kPlacementAlign) / sizeof(kPlacementAlign[0]) == static_cast<std::size_t>(RenderPlacement::COUNT) &&
+                  sizeof(kPlacementTextAlign) / sizeof(kPlacementTextAlign[0]) == static_cast<std::size_t>(RenderPlacement::COUNT),
+                  "placement tables must list every RenderPlacement");
+
+    const RenderButton* buttons = render_model_.pageButtons(page);
+    const auto& page_buttons = config_->pages[index].buttons;
+    for (std::size_t i = 0; i < page.button_count; ++i) {
+        const RenderButton& style = buttons[i];
+        const ButtonConfig& button = page_buttons[i];
+        drawn_button_ids_.push_back(button.id);
         lv_obj_t* btn = lv_btn_create(page_container_);
         lv_obj_remove_style_all(btn);
 
-        // Apply per-button styling; fall back to theme only when button fields are empty
-        lv_obj_set_style_radius(btn, button.corner_radius, 0);
-        lv_obj_set_style_border_width(btn, button.border_width, 0);
-        const lv_color_t border_color = !button.border_color.empty()
-            ? colorFromHex(button.border_color, UITheme::COLOR_BORDER)
-            : (config_ ? colorFromHex(config_->theme.border_color, UITheme::COLOR_BORDER) : UITheme::COLOR_BORDER);
-        lv_obj_set_style_border_color(btn, border_color, 0);
-        lv_obj_set_style_border_opa(btn, button.border_width > 0 ? LV_OPA_COVER : LV_OPA_TRANSP, 0);
+        lv_obj_set_style_radius(btn, style.corner_radius, 0);
+        lv_obj_set_style_border_width(btn, style.border_width, 0);
+        lv_obj_set_style_border_color(btn, lv_color_hex(style.border_color), 0);
+        lv_obj_set_style_border_opa(btn, style.border_width > 0 ? LV_OPA_COVER : LV_OPA_TRANSP, 0);
 
-        const std::string button_color_hex = !button.color.empty()
-            ? button.color
-            : (config_ ? config_->theme.accent_color : "#FFA500");
-        lv_color_t btn_color = colorFromHex(button_color_hex, UITheme::COLOR_ACCENT);
+        const lv_color_t btn_color = lv_color_hex(style.color);
         lv_obj_set_style_bg_color(btn, btn_color, 0);
         lv_obj_set_style_bg_opa(btn, LV_OPA_COVER, 0);
 
         // Pressed state color - use button override or derive from base color
-        const std::string pressed_hex = !button.pressed_color.empty() ? button.pressed_color : "";
-        lv_color_t pressed_color = pressed_hex.empty()
+        const lv_color_t pressed_color = style.derive_pressed
             ? lv_color_darken(btn_color, LV_OPA_40)
-            : colorFromHex(pressed_hex, lv_color_darken(btn_color, LV_OPA_40));
+            : lv_color_hex(style.pressed_color);
         lv_obj_set_style_bg_color(btn, pressed_color, LV_STATE_PRESSED);
         lv_obj_set_style_bg_opa(btn, LV_OPA_COVER, LV_STATE_PRESSED);
+        bindModuleOutput(btn, button, pressed_color);
 
         lv_obj_set_style_pad_all(btn, UITheme::SPACE_MD, 0);
         lv_obj_set_style_min_height(btn, 88, 0);
@@ -525,11 +575,12 @@ void UIBuilder::buildPage(std::size_t index) {
         lv_obj_set_style_shadow_color(btn, lv_color_hex(0x000000), 0);
         lv_obj_set_style_shadow_opa(btn, LV_OPA_20, 0);
         lv_obj_set_grid_cell(btn,
-                     LV_GRID_ALIGN_STRETCH, button.col, button.col_span,
-                     LV_GRID_ALIGN_STRETCH, button.row, button.row_span);
-        lv_obj_add_event_cb(btn, actionButtonEvent, LV_EVENT_PRESSED, (void*)&button);
-        lv_obj_add_event_cb(btn, actionButtonEvent, LV_EVENT_RELEASED, (void*)&button);
-        lv_obj_add_event_cb(btn, actionButtonEvent, LV_EVENT_CLICKED, (void*)&button);
+                     LV_GRID_ALIGN_STRETCH, style.col, style.col_span,
+                     LV_GRID_ALIGN_STRETCH, style.row, style.row_span);
+        void* button_ref = packButtonRef(index, i);
+        lv_obj_add_event_cb(btn, actionButtonEvent, LV_EVENT_PRESSED, button_ref);
+        lv_obj_add_event_cb(btn, actionButtonEvent, LV_EVENT_RELEASED, button_ref);
+        lv_obj_add_event_cb(btn, actionButtonEvent, LV_EVENT_CLICKED, button_ref);
 
         // Create icon if specified
         if (!button.icon.empty() && button.icon != "none") {
@@ -544,63 +595,73 @@ void UIBuilder::buildPage(std::size_t index) {
 
         lv_obj_t* title = lv_label_create(btn);
         lv_label_set_text(title, button.label.c_str());
-        // Button text color priority: per-button > page override > theme default
-        const lv_color_t theme_text_fallback = config_
-            ? colorFromHex(config_->theme.text_primary, UITheme::COLOR_TEXT_PRIMARY)
-            : UITheme::COLOR_TEXT_PRIMARY;
-        const lv_color_t page_text_fallback = !page.text_color.empty()
-            ? colorFromHex(page.text_color, theme_text_fallback)
-            : theme_text_fallback;
-        lv_color_t label_color = page_text_fallback;
-        if (!button.text_color.empty()) {
-            label_color = colorFromHex(button.text_color, page_text_fallback);
-        }
-        lv_obj_set_style_text_color(title, label_color, 0);
-
-        // Use font_name if specified, otherwise use font_family + font_size
-        const lv_font_t* font;
-        if (!button.font_name.empty() && button.font_name != "montserrat_16") {
-            font = fontFromName(button.font_name);
-        } else if (!button.font_family.empty() && button.font_family != "montserrat") {
-            // Use font family with size
-            std::string fontKey = button.font_family + "_" + std::to_string(button.font_size);
-            font = fontFromName(fontKey);
-        } else {
-            // Default montserrat with size mapping
-            if (button.font_size <= 13) font = &lv_font_montserrat_12;
-            else if (button.font_size <= 15) font = &lv_font_montserrat_14;
-            else if (button.font_size <= 17) font = &lv_font_montserrat_16;
-            else if (button.font_size <= 19) font = &lv_font_montserrat_18;
-            else if (button.font_size <= 21) font = &lv_font_montserrat_20;
-            else if (button.font_size <= 23) font = &lv_font_montserrat_22;
-            else if (button.font_size <= 25) font = &lv_font_montserrat_24;
-            else if (button.font_size <= 27) font = &lv_font_montserrat_26;
-            else if (button.font_size <= 29) font = &lv_font_montserrat_28;
-            else if (button.font_size <= 31) font = &lv_font_montserrat_30;
-            else font = &lv_font_montserrat_32;
-        }
-        lv_obj_set_style_text_font(title, font, 0);
+        lv_obj_set_style_text_color(title, lv_color_hex(style.text_color), 0);
+        lv_obj_set_style_text_font(title, fontFor(style.font), 0);
 
         // Apply text alignment - set label to full button width for text alignment to work
         lv_obj_set_width(title, lv_pct(100));
         lv_label_set_long_mode(title, LV_LABEL_LONG_WRAP);
-        
-        lv_align_t align = LV_ALIGN_CENTER;
-        lv_text_align_t text_align = LV_TEXT_ALIGN_CENTER;
-        if (button.text_align == "top-left") { align = LV_ALIGN_TOP_LEFT; text_align = LV_TEXT_ALIGN_LEFT; }
-        else if (button.text_align == "top-center") { align = LV_ALIGN_TOP_MID; text_align = LV_TEXT_ALIGN_CENTER; }
-        else if (button.text_align == "top-right") { align = LV_ALIGN_TOP_RIGHT; text_align = LV_TEXT_ALIGN_RIGHT; }
-        else if (button.text_align == "center") { align = LV_ALIGN_CENTER; text_align = LV_TEXT_ALIGN_CENTER; }
-        else if (button.text_align == "bottom-left") { align = LV_ALIGN_BOTTOM_LEFT; text_align = LV_TEXT_ALIGN_LEFT; }
-        else if (button.text_align == "bottom-center") { align = LV_ALIGN_BOTTOM_MID; text_align = LV_TEXT_ALIGN_CENTER; }
-        else if (button.text_align == "bottom-right") { align = LV_ALIGN_BOTTOM_RIGHT; text_align = LV_TEXT_ALIGN_RIGHT; }
-        lv_obj_align(title, align, 0, 0);
-        lv_obj_set_style_text_align(title, text_align, 0);
+        const std::size_t placement = static_cast<std::size_t>(style.placement);
+        lv_obj_align(title, kPlacementAlign[placement], 0, 0);
+        lv_obj_set_style_text_align(title, kPlacementTextAlign[placement], 0);
     }
 
+    refreshModuleStates(true);
     updateNavSelection();
 }
 
+void UIBuilder::bindModuleOutput(lv_obj_t* btn, const ButtonConfig& button, lv_color_t on_color) {
+    if (button.module.empty() || button.module_output == 0) {
+        return;
+    }
+    // On shows the pressed fill; a fault adds an error border; unknown (module offline) dims the button
+    lv_obj_set_style_bg_color(btn, on_color, LV_STATE_CHECKED);
+    lv_obj_set_style_border_color(btn, UITheme::COLOR_ERROR, LV_STATE_USER_1);
+    lv_obj_set_style_border_width(btn, 3, LV_STATE_USER_1);
+    lv_obj_set_style_border_opa(btn, LV_OPA_COVER, LV_STATE_USER_1);
+    lv_obj_set_style_opa(btn, LV_OPA_60, LV_STATE_USER_2);
+    module_bindings_.push_back(ModuleBinding{btn, button.module, button.module_output});
+
+    if (!module_timer_) {
+        // One check per display refresh: any number of status replies in between costs one redraw
+        module_timer_ = lv_timer_create([](lv_timer_t*) {
+            UIBuilder::instance().refreshModuleStates(false);
+        }, LV_DISP_DEF_REFR_PERIOD, nullptr);
+    }
+}
+
+void UIBuilder::refreshModuleStates(bool force) {
+    if (module_bindings_.empty()) {
+        return;
+    }
+    CanModuleStatus& modules = CanModuleStatus::instance();
+    const std::uint32_t generation = modules.generation();
+    if (!force && generation == module_generation_) {
+        return;
+    }
+    module_generation_ = generation;
+
+    for (const ModuleBinding& binding : module_bindings_) {
+        const CanOutputState state = modules.output(modules.find(binding.module), binding.output).state;
+        // lv_obj_add/clear_state only invalidate when the state actually changes
+        if (state == CanOutputState::ON) {
+            lv_obj_add_state(binding.button, LV_STATE_CHECKED);
+        } else {
+            lv_obj_clear_state(binding.button, LV_STATE_CHECKED);
+        }
+        if (state == CanOutputState::FAULT) {
+            lv_obj_add_state(binding.button, LV_STATE_USER_1);
+        } else {
+            lv_obj_clear_state(binding.button, LV_STATE_USER_1);
+        }
+        if (state == CanOutputState::UNKNOWN) {
+            lv_obj_add_state(binding.button, LV_STATE_USER_2);
+        } else {
+            lv_obj_clear_state(binding.button, LV_STATE_USER_2);
+        }
+    }
+}
+
 void UIBuilder::updateNavSelection() {
     for (std::size_t i = 0; i < nav_buttons_.size(); ++i) {
         lv_obj_t* btn = nav_buttons_[i];
@@ -632,140 +693,73 @@ void UIBuilder::navButtonEvent(lv_event_t* e) {
 
 void UIBuilder::actionButtonEvent(lv_event_t* e) {
     const lv_event_code_t code = lv_event_get_code(e);
-    auto* config = static_cast<const ButtonConfig*>(lv_event_get_user_data(e));
-    if (!config) {
+    UIBuilder& ui = UIBuilder::instance();
+    std::size_t page_index = 0;
+    std::size_t button_index = 0;
+    unpackButtonRef(lv_event_get_user_data(e), page_index, button_index);
+
+    // The page on screen was drawn at render_model_.generation. After any later edit (a brightness change
+    // counts too) these indices may name another button or none until applyConfig() redraws the page, so the
+    // press only goes out if the button there still has the id it was drawn with
+    ConfigManager& config_mgr = ConfigManager::instance();
+    auto lock = config_mgr.editLock();
+    if (!ui.config_ || page_index != ui.active_page_ || page_index >= ui.config_->pages.size() ||
+        button_index >= ui.config_->pages[page_index].buttons.size() || button_index >= ui.drawn_button_ids_.size()) {
+        return;
+    }
+    const ButtonConfig* config = &ui.config_->pages[page_index].buttons[button_index];
+    if (ui.render_model_.generation != config_mgr.editGeneration() && config->id != ui.drawn_button_ids_[button_index]) {
         return;
     }
 
+    // Each action is traced from the touch read that caused it to the TX-complete alert
+    CanLatencyTracer& tracer = CanLatencyTracer::instance();
     if (config->momentary) {
         if (code == LV_EVENT_PRESSED) {
-            CanManager::instance().sendButtonAction(*config);
+            CanManager::instance().sendButtonAction(*config, tracer.beginPress(canMicros()));
         } else if (code == LV_EVENT_RELEASED) {
             if (config->can_off.enabled) {
-                CanManager::instance().sendButtonReleaseAction(*config);
+                CanManager::instance().sendButtonReleaseAction(*config, tracer.beginPress(canMicros()));
             }
         }
         return;
     }
 
     if (code == LV_EVENT_CLICKED) {
-        CanManager::instance().sendButtonAction(*config);
+        CanManager::instance().sendButtonAction(*config, tracer.beginPress(canMicros()));
     }
 }
 
 lv_color_t UIBuilder::colorFromHex(const std::string& hex, lv_color_t fallback) {
-    if (hex.size() != 7 || hex[0] != '#') {
-        return fallback;
-    }
-    char* end_ptr = nullptr;
-    unsigned long value = strtoul(hex.c_str() + 1, &end_ptr, 16);
-    if (end_ptr == nullptr || *end_ptr != '\0') {
-        return fallback;
-    }
-    return lv_color_hex(static_cast<uint32_t>(value));
+    std::uint32_t rgb = 0;
+    return parseHexColor(hex, rgb) ? lv_color_hex(rgb) : fallback;
 }
 
-// Base64 decoder for logo images
-std::vector<uint8_t> UIBuilder::decodeBase64Logo(const std::string& data_uri) {
-    std::vector<uint8_t> result;
-    
-    // Find the base64 data after "base64,"
-    const std::string prefix = "base64,";
-    size_t pos = data_uri.find(prefix);
-    std::string base64_data;
-    if (pos == std::string::npos) {
-        base64_data = data_uri;
-    } else {
-        base64_data = data_uri.substr(pos + prefix.length());
-    }
-    
-    // Base64 decode table
-    static const uint8_t decode_table[256] = {
-        64,64,64,64,64,64,64,64,64,64,64,64,64,64,64,64,
-        64,64,64,64,64,64,64,64,64,64,64,64,64,64,64,64,
-        64,64,64,64,64,64,64,64,64,64,64,62,64,64,64,63,
-        52,53,54,55,56,57,58,59,60,61,64,64,64,64,64,64,
-        64, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,10,11,12,13,14,
-        15,16,17,18,19,20,21,22,23,24,25,64,64,64,64,64,
-        64,26,27,28,29,30,31,32,33,34,35,36,37,38,39,40,
-        41,42,43,44,45,46,47,48,49,50,51,64,64,64,64,64,
-        64,64,64,64,64,64,64,64,64,64,64,64,64,64,64,64,
-        64,64,64,64,64,64,64,64,64,64,64,64,64,64,64,64,
-        64,64,64,64,64,64,64,64,64,64,64,64,64,64,64,64,
-        64,64,64,64,64,64,64,64,64,64,64,64,64,64,64,64,
-        64,64,64,64,64,64,64,64,64,64,64,64,64,64,64,64,
-        64,64,64,64,64,64,64,64,64,64,64,64,64,64,64,64,
-        64,64,64,64,64,64,64,64,64,64,64,64,64,64,64,64,
-        64,64,64,64,64,64,64,64,64,64,64,64,64,64,64,64
-    };
-    
-    // Reserve approximate size (3 bytes per 4 characters)
-    result.reserve(base64_data.length() * 3 / 4);
-    
-    // Decode
-    uint32_t val = 0;
-    int valb = -8;
-    for (uint8_t c : base64_data) {
-        if (decode_table[c] == 64) break;
-        val = (val << 6) + decode_table[c];
-        valb += 6;
-        if (valb >= 0) {
-            result.push_back((val >> valb) & 0xFF);
-            valb -= 8;
-        }
-    }
-    
-    return result;
-}
-
-bool UIBuilder::loadImageDescriptor(const std::string& data_uri,
+// Pixels for an "asset:<id>" reference, or an inline lvimg payload the config has not handed to the asset store yet
+bool UIBuilder::loadImageDescriptor(const std::string& source,
                                     std::vector<uint8_t>& pixel_buffer,
                                     lv_img_dsc_t& descriptor,
                                     bool scrub_white_background) {
-    if (data_uri.rfind("lvimg:", 0) != 0) {
-        Serial.println("[UI] Unsupported image payload (missing lvimg: prefix)");
-        return false;
-    }
-
-    const size_t fmt_sep = data_uri.find(':', 6);
-    if (fmt_sep == std::string::npos) {
-        Serial.println("[UI] Malformed lvimg payload (format separator missing)");
-        return false;
-    }
-    const std::string format = data_uri.substr(6, fmt_sep - 6);
-
-    const size_t size_sep = data_uri.find(':', fmt_sep + 1);
-    if (size_sep == std::string::npos) {
-        Serial.println("[UI] Malformed lvimg payload (size separator missing)");
-        return false;
-    }
-    const std::string size_part = data_uri.substr(fmt_sep + 1, size_sep - (fmt_sep + 1));
-    const size_t x_pos = size_part.find('x');
-    if (x_pos == std::string::npos) {
-        Serial.println("[UI] Malformed lvimg payload (widthxheight missing)");
-        return false;
-    }
-
-    const uint16_t width = static_cast<uint16_t>(std::atoi(size_part.substr(0, x_pos).c_str()));
-    const uint16_t height = static_cast<uint16_t>(std::atoi(size_part.substr(x_pos + 1).c_str()));
-    if (width == 0 || height == 0) {
-        Serial.println("[UI] Invalid lvimg dimensions");
-        return false;
-    }
-
-    const std::string base64_data = data_uri.substr(size_sep + 1);
-    pixel_buffer = decodeBase64Logo(base64_data);
-    if (pixel_buffer.empty()) {
-        Serial.println("[UI] Failed to decode lvimg base64 payload");
+    AssetHeader asset{};
+    AssetId id = 0;
+    std::string error;
+    const bool loaded = parseAssetRef(source, id)
+                            ? AssetStore::instance().load(id, asset, pixel_buffer, error)
+                            : decodeInlineImage(source, asset, pixel_buffer, error);
+    if (!loaded) {
+        Serial.printf("[UI] Image unavailable: %s\n", error.c_str());
         return false;
     }
+    const AssetFormat format = static_cast<AssetFormat>(asset.format);
+    const uint16_t width = asset.width;
+    const uint16_t height = asset.height;
 
     descriptor = lv_img_dsc_t{};
     descriptor.header.always_zero = 0;
     descriptor.header.w = width;
     descriptor.header.h = height;
 
-    if (format == "rgb565a") {
+    if (format == AssetFormat::RGB565A) {
         const size_t expected = static_cast<size_t>(width) * static_cast<size_t>(height) * 3;
         if (pixel_buffer.size() != expected) {
             Serial.printf("[UI] lvimg buffer mismatch (%u vs %u)\n",
@@ -798,7 +792,7 @@ bool UIBuilder::loadImageDescriptor(const std::string& data_uri,
             }
         }
         descriptor.header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
-    } else if (format == "rgb565") {
+    } else if (format == AssetFormat::RGB565) {
         const size_t expected = static_cast<size_t>(width) * static_cast<size_t>(height) * 2;
         if (pixel_buffer.size() != expected) {
             Serial.println("[UI] lvimg rgb565 buffer mismatch");
@@ -806,7 +800,7 @@ bool UIBuilder::loadImageDescriptor(const std::string& data_uri,
         }
         descriptor.header.cf = LV_IMG_CF_TRUE_COLOR;
     } else {
-        Serial.printf("[UI] Unsupported lvimg format: %s\n", format.c_str());
+        Serial.printf("[UI] %s images cannot be drawn directly\n", assetFormatName(format));
         return false;
     }
 
@@ -1028,12 +1022,16 @@ void UIBuilder::updateHeaderBranding() {
     }
 
     if (config_->header.show_logo) {
-        // Priority 1: Custom uploaded header logo
-        if (!config_->images.header_logo.empty()) {
-            Serial.printf("[UI] Custom header logo found, length=%d\n", config_->images.header_logo.length());
-            Serial.printf("[UI] Data URL prefix: %.50s...\n", config_->images.header_logo.c_str());
-            
-            if (loadImageDescriptor(config_->images.header_logo, logo_buffer_, header_logo_dsc_, true)) {
+        // Priority 1: Custom uploaded header logo; a legacy header.logo_base64 moved to the asset store counts too
+        AssetId legacy_logo = 0;
+        const std::string& custom_logo =
+            config_->images.header_logo.empty() && parseAssetRef(config_->header.logo_base64, legacy_logo)
+                ? config_->header.logo_base64
+                : config_->images.header_logo;
+        if (!custom_logo.empty()) {
+            Serial.printf("[UI] Custom header logo: %.50s\n", custom_logo.c_str());
+
+            if (loadImageDescriptor(custom_logo, logo_buffer_, header_logo_dsc_, true)) {
                 header_logo_ready_ = true;
                 lv_img_set_src(header_logo_img_, &header_logo_dsc_);
                 showLogoArea();
@@ -1947,9 +1945,19 @@ uint8_t UIBuilder::clampBrightness(uint8_t percent) const {
 
 void UIBuilder::setBrightnessInternal(uint8_t percent, bool persist) {
     percent = clampBrightness(percent);
-    DeviceConfig& cfg = ConfigManager::instance().getConfig();
-    const bool changed = cfg.display.brightness != percent;
-    cfg.display.brightness = percent;
+    ConfigManager& config_mgr = ConfigManager::instance();
+    const std::uint32_t display_section = configJsonSectionBit("display");
+    bool changed = false;
+    {
+        // The web server encodes this config on its own task; a drag that is not saved yet still counts as an edit
+        auto lock = config_mgr.editLock();
+        DeviceConfig& cfg = config_mgr.getConfig();
+        changed = cfg.display.brightness != percent;
+        cfg.display.brightness = percent;
+        if (changed) {
+            config_mgr.markEdited(display_section);
+        }
+    }
 
     applySoftBrightness(percent);
 
@@ -1977,7 +1985,7 @@ void UIBuilder::setBrightnessInternal(uint8_t percent, bool persist) {
     }
 
     if (persist && changed) {
-        ConfigManager::instance().save();
+        config_mgr.requestSave(display_section);  // A slider drag lands as one write once it settles
     }
 }
 
@@ -2092,37 +2100,24 @@ void UIBuilder::hideSleepOverlay() {
 }
 
 const lv_font_t* UIBuilder::fontFromName(const std::string& name) const {
-    // Map font names to actual LVGL fonts - Montserrat
-    if (name == "montserrat_12") return &lv_font_montserrat_12;
-    if (name == "montserrat_14") return &lv_font_montserrat_14;
-    if (name == "montserrat_16") return &lv_font_montserrat_16;
-    if (name == "montserrat_18") return &lv_font_montserrat_18;
-    if (name == "montserrat_20") return &lv_font_montserrat_20;
-    if (name == "montserrat_22") return &lv_font_montserrat_22;
-    if (name == "montserrat_24") return &lv_font_montserrat_24;
-    if (name == "montserrat_26") return &lv_font_montserrat_26;
-    if (name == "montserrat_28") return &lv_font_montserrat_28;
-    if (name == "montserrat_30") return &lv_font_montserrat_30;
-    if (name == "montserrat_32") return &lv_font_montserrat_32;
-    if (name == "montserrat_34") return &lv_font_montserrat_34;
-    if (name == "montserrat_36") return &lv_font_montserrat_36;
-    if (name == "montserrat_38") return &lv_font_montserrat_38;
-    if (name == "montserrat_40") return &lv_font_montserrat_40;
-    if (name == "montserrat_42") return &lv_font_montserrat_42;
-    if (name == "montserrat_44") return &lv_font_montserrat_44;
-    if (name == "montserrat_46") return &lv_font_montserrat_46;
-    if (name == "montserrat_48") return &lv_font_montserrat_48;
-    
-    // Special fonts
-    if (name == "dejavu_16") return &lv_font_dejavu_16_persian_hebrew;
-    if (name == "simsun_16") return &lv_font_simsun_16_cjk;
-    
-    // UNSCII monospace fonts
-    if (name == "unscii_8") return &lv_font_unscii_8;
-    if (name == "unscii_16") return &lv_font_unscii_16;
-    
-    // Default fallback
-    return &lv_font_montserrat_16;
+    return fontFor(renderFontFromName(name));
+}
+
+const lv_font_t* UIBuilder::fontFor(RenderFont font) {
+    // Indexed by RenderFont
+    static const lv_font_t* const kFonts[] = {
+        &lv_font_montserrat_12, &lv_font_montserrat_14, &lv_font_montserrat_16, &lv_font_montserrat_18,
+        &lv_font_montserrat_20, &lv_font_montserrat_22, &lv_font_montserrat_24, &lv_font_montserrat_26,
+        &lv_font_montserrat_28, &lv_font_montserrat_30, &lv_font_montserrat_32, &lv_font_montserrat_34,
+        &lv_font_montserrat_36, &lv_font_montserrat_38, &lv_font_montserrat_40, &lv_font_montserrat_42,
+        &lv_font_montserrat_44, &lv_font_montserrat_46, &lv_font_montserrat_48,
+        &lv_font_dejavu_16_persian_hebrew, &lv_font_simsun_16_cjk,
+        &lv_font_unscii_8, &lv_font_unscii_16,
+    };
+    static_assert(sizeof(kFonts) / sizeof(kFonts[0]) == static_cast<std::size_t>(RenderFont::COUNT),
+                  "kFonts must list every RenderFont");
+    const std::size_t index = static_cast<std::size_t>(font);
+    return index < static_cast<std::size_t>(RenderFont::COUNT) ? kFonts[index] : &lv_font_montserrat_16;
 }
 
 const lv_font_t* UIBuilder::navLabelFontForText(const std::string& text) const {
@@ -8,6 +8,7 @@
 #include <vector>
 
 #include "config_types.h"
+#include "render_model.h"
 #include "ui_theme.h"
 
 class UIBuilder {
@@ -36,8 +37,11 @@ private:
     void createBaseScreen();
     void buildNavigation();
     void buildEmptyState();
+    void rebuildRenderModel();
     void buildPage(std::size_t index);
     void updateNavSelection();
+    void bindModuleOutput(lv_obj_t* btn, const ButtonConfig& button, lv_color_t on_color);
+    void refreshModuleStates(bool force);
     void updateHeaderBranding();
     void createInfoModal();
     void showInfoModal();
@@ -50,10 +54,10 @@ private:
     void applySoftBrightness(uint8_t percent);
     const lv_img_dsc_t* iconForId(const std::string& id) const;
     const lv_font_t* fontFromName(const std::string& name) const;
+    static const lv_font_t* fontFor(RenderFont font);
     const lv_font_t* navLabelFontForText(const std::string& text) const;
     uint32_t nextUtf8Codepoint(const std::string& text, std::size_t& index) const;
-    std::vector<uint8_t> decodeBase64Logo(const std::string& data_uri);
-    bool loadImageDescriptor(const std::string& data_uri, std::vector<uint8_t>& pixel_buffer, lv_img_dsc_t& descriptor, bool scrub_white_background = false);
+    bool loadImageDescriptor(const std::string& source, std::vector<uint8_t>& pixel_buffer, lv_img_dsc_t& descriptor, bool scrub_white_background = false);
     void applyHeaderNavSpacing();
     void applyHeaderLogoSizing(uint16_t src_width, uint16_t src_height, bool inline_layout);
     void refreshOtaStatusLabel();
@@ -84,6 +88,8 @@ private:
     static lv_color_t colorFromHex(const std::string& hex, lv_color_t fallback);
 
     const DeviceConfig* config_ = nullptr;
+    RenderModel render_model_;  // config_ resolved for buildPage; rebuilt on begin(), applyConfig() and a stale buildPage()
+    std::vector<std::string> drawn_button_ids_;  // The active page's button ids as drawn, checked on press
     lv_obj_t* base_screen_ = nullptr;
     lv_obj_t* header_bar_ = nullptr;
     lv_obj_t* header_brand_row_ = nullptr;
@@ -128,6 +134,15 @@ private:
     lv_obj_t* status_ap_label_ = nullptr;
     lv_obj_t* status_sta_label_ = nullptr;
     lv_obj_t* page_container_ = nullptr;
+    // Buttons on the current page that mirror a module output (ButtonConfig::module)
+    struct ModuleBinding {
+        lv_obj_t* button = nullptr;
+        std::string module;
+        std::uint8_t output = 0;
+    };
+    std::vector<ModuleBinding> module_bindings_;
+    lv_timer_t* module_timer_ = nullptr;
+    std::uint32_t module_generation_ = 0;
     std::vector<lv_obj_t*> nav_buttons_;
     std::vector<lv_coord_t> grid_cols_;
     std::vector<lv_coord_t> grid_rows_;
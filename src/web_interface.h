@@ -576,6 +576,7 @@ function switchTab(tabName){
 
 <script>
 let config = {};
+let savedConfig = null;  // What the device last confirmed, without images; saves diff against it
 let activePageIndex = 0;
 let editingButton = { row: -1, col: -1 };
 let wifiNetworks = [];
@@ -625,12 +626,9 @@ function handleNavSpacingInput(value){
 }
 
 function getHeaderLogoDimensions(value){
-	if (!value) return null;
-	if (value.startsWith('lvimg:')) {
-		const parsed = parseLvimgPayload(value);
-		if (parsed) {
-			return { width: parsed.width, height: parsed.height };
-		}
+	const cached = value ? assetPreviewCache.get(value) : null;
+	if (cached && cached.width && cached.height) {
+		return { width: cached.width, height: cached.height };
 	}
 	return null;
 }
@@ -1812,12 +1810,15 @@ async function refreshStatus(){
 		const firmwareVersion = status.firmware_version || statusContainer.dataset.version || '—';
 		const deviceIp = status.device_ip || status.sta_ip || status.ap_ip || '—';
 		const connectedNetwork = status.connected_network || (status.sta_connected ? 'Hidden network' : '—');
+		const persist = status.config_persist || {};
+		const configState = persist.failures && persist.pending_writes ? 'Write failed, retrying' : persist.pending_writes ? 'Saving…' : 'Saved';
 		statusContainer.innerHTML = `
 			<div class="status-chip"><span>Firmware</span>v${firmwareVersion}</div>
 			<div class="status-chip"><span>Device IP</span>${deviceIp || '—'}</div>
 			<div class="status-chip"><span>Connected Network</span>${connectedNetwork || '—'}</div>
 			<div class="status-chip"><span>AP IP</span>${status.ap_ip || 'N/A'}</div>
 			<div class="status-chip"><span>Station IP</span>${status.sta_ip || '—'}</div>
+			<div class="status-chip"><span>Config</span>${configState}</div>
 		`;
 	}catch(err){
 		const firmwareVersion = statusContainer.dataset.version || '—';
@@ -1882,7 +1883,8 @@ const IMAGE_CONFIGS = {
 };
 
 const LVGL_IMAGE_TYPES = new Set(['header','sleep']);
-const lvimgPreviewCache = new Map();
+// "asset:<id>" -> { src, width, height } once fetched; { pending: true } while the request is out
+const assetPreviewCache = new Map();
 
 function needsLvglPayload(imageType) {
 	return LVGL_IMAGE_TYPES.has(imageType);
@@ -1911,20 +1913,6 @@ function blobToDataUrl(blob) {
 	});
 }
 
-function bufferToBase64(buffer) {
-	let binary = '';
-	const chunkSize = 0x8000;
-	for (let i = 0; i < buffer.length; i += chunkSize) {
-		const chunk = buffer.subarray(i, i + chunkSize);
-		let str = '';
-		for (let j = 0; j < chunk.length; j++) {
-			str += String.fromCharCode(chunk[j]);
-		}
-		binary += str;
-	}
-	return btoa(binary);
-}
-
 function rgbaToRgb565a(rgbaPixels) {
 	const pixelCount = rgbaPixels.length / 4;
 	const buffer = new Uint8Array(pixelCount * 3);
@@ -2003,7 +1991,8 @@ async function blobToLvglPayload(blob, options = {}) {
 	const { width, height, data } = imageData;
 	const rgb565a = rgbaToRgb565a(data);
 	return {
-		payload: `lvimg:rgb565a:${width}x${height}:${bufferToBase64(rgb565a)}`,
+		format: 'rgb565a',
+		pixels: rgb565a,
 		previewDataUrl: canvas.toDataURL('image/png'),
 		rawBytes: rgb565a.length,
 		width,
@@ -2011,46 +2000,9 @@ async function blobToLvglPayload(blob, options = {}) {
 	};
 }
 
-function base64ToUint8Array(base64) {
-	try {
-		const binary = atob(base64);
-		const len = binary.length;
-		const bytes = new Uint8Array(len);
-		for (let i = 0; i < len; i++) {
-			bytes[i] = binary.charCodeAt(i);
-		}
-		return bytes;
-	} catch (err) {
-		console.error('lvimg decode failed', err);
-		return null;
-	}
-}
-
-function parseLvimgPayload(payload) {
-	if (!payload || payload.indexOf('lvimg:') !== 0) {
-		return null;
-	}
-	const fmtSep = payload.indexOf(':', 6);
-	if (fmtSep === -1) return null;
-	const sizeSep = payload.indexOf(':', fmtSep + 1);
-	if (sizeSep === -1) return null;
-	const sizePart = payload.slice(fmtSep + 1, sizeSep);
-	const [wStr, hStr] = sizePart.split('x');
-	const width = parseInt(wStr, 10);
-	const height = parseInt(hStr, 10);
-	if (!width || !height) return null;
-	const base64 = payload.slice(sizeSep + 1);
-	const buffer = base64ToUint8Array(base64);
-	if (!buffer) return null;
-	return { format: payload.slice(6, fmtSep), width, height, buffer };
-}
-
-function lvimgToDataUrl(payload) {
-	const parsed = parseLvimgPayload(payload);
-	if (!parsed) return null;
-	const { format, width, height, buffer } = parsed;
+function rgb565ToDataUrl(format, width, height, buffer) {
 	const bytesPerPixel = format === 'rgb565a' ? 3 : (format === 'rgb565' ? 2 : 0);
-	if (!bytesPerPixel) return null;
+	if (!bytesPerPixel || !width || !height) return null;
 	const expected = width * height * bytesPerPixel;
 	if (buffer.length !== expected) return null;
 	const rgba = new Uint8ClampedArray(width * height * 4);
@@ -2076,17 +2028,39 @@ function lvimgToDataUrl(payload) {
 	return canvas.toDataURL('image/png');
 }
 
+// Images are stored on the device as assets; fetch one and turn it into something an <img> can show
+async function loadAssetPreview(ref) {
+	assetPreviewCache.set(ref, { pending: true });
+	try {
+		const res = await fetch(`/api/assets/${ref.slice('asset:'.length)}`);
+		if (!res.ok) throw new Error(res.statusText);
+		const format = res.headers.get('X-Asset-Format') || '';
+		const width = parseInt(res.headers.get('X-Asset-Width') || '0', 10);
+		const height = parseInt(res.headers.get('X-Asset-Height') || '0', 10);
+		let src;
+		if (format === 'png' || format === 'jpeg') {
+			src = URL.createObjectURL(await res.blob());
+		} else {
+			src = rgb565ToDataUrl(format, width, height, new Uint8Array(await res.arrayBuffer()));
+		}
+		assetPreviewCache.set(ref, { src, width, height });
+	} catch (err) {
+		console.error(`Asset preview failed for ${ref}`, err);
+		assetPreviewCache.set(ref, { src: null });
+	}
+	hydrateImagePreviews();
+	renderPreview();
+}
+
 function getImagePreviewSrc(value) {
 	if (!value) return null;
-	if (value.startsWith('lvimg:')) {
-		if (lvimgPreviewCache.has(value)) {
-			return lvimgPreviewCache.get(value);
-		}
-		const dataUrl = lvimgToDataUrl(value);
-		if (dataUrl) {
-			lvimgPreviewCache.set(value, dataUrl);
+	if (value.startsWith('asset:')) {
+		const cached = assetPreviewCache.get(value);
+		if (!cached) {
+			loadAssetPreview(value);
+			return null;
 		}
-		return dataUrl;
+		return cached.src || null;
 	}
 	return value;
 }
@@ -2239,19 +2213,28 @@ async function handleImageUpload(evt, imageType) {
 		console.log(`Optimized ${imageType}: ${(optimizedBlob.size / 1024).toFixed(1)}KB via Fly`);
 
 		const needsLvgl = needsLvglPayload(imageType);
-		let storagePayload;
+		let assetBody = optimizedBlob;
+		let assetQuery;
 		let previewDataUrl;
+		let previewWidth = 0;
+		let previewHeight = 0;
 		let payloadBytes = optimizedBlob.size;
 		if (needsLvgl) {
 			const lvglOptions = (imageType === 'header') ? { stripWhiteBg: true, bgTolerance: 24 } : {};
 			const lvglPayload = await blobToLvglPayload(optimizedBlob, lvglOptions);
-			storagePayload = lvglPayload.payload;
+			assetBody = lvglPayload.pixels;
+			assetQuery = new URLSearchParams({
+				format: lvglPayload.format,
+				width: lvglPayload.width.toString(),
+				height: lvglPayload.height.toString()
+			});
 			previewDataUrl = lvglPayload.previewDataUrl;
+			previewWidth = lvglPayload.width;
+			previewHeight = lvglPayload.height;
 			payloadBytes = lvglPayload.rawBytes;
-			lvimgPreviewCache.set(storagePayload, previewDataUrl);
 		} else {
 			previewDataUrl = await blobToDataUrl(optimizedBlob);
-			storagePayload = previewDataUrl;
+			assetQuery = new URLSearchParams({ format: format === 'png' ? 'png' : 'jpeg' });
 		}
 
 		if (payloadBytes > imgConfig.maxBytes) {
@@ -2260,14 +2243,26 @@ async function handleImageUpload(evt, imageType) {
 			return;
 		}
 		
-		// Upload to ESP32
+		// Upload to ESP32: the raw bytes go to the asset store, then the image slot points at them
 		showBanner(`Uploading optimized ${imageType} to device...`, 'info');
+		const assetResponse = await fetch(`/api/assets?${assetQuery}`, {
+			method: 'POST',
+			headers: { 'Content-Type': 'application/octet-stream' },
+			body: assetBody
+		});
+		const assetResult = await assetResponse.json().catch(() => ({}));
+		if (!assetResponse.ok || !assetResult.ref) {
+			throw new Error(`ESP32 upload failed: ${assetResult.message || assetResponse.statusText}`);
+		}
+		const assetRef = assetResult.ref;
+		assetPreviewCache.set(assetRef, { src: previewDataUrl, width: previewWidth, height: previewHeight });
+
 		const response = await fetch('/api/image/upload', {
 			method: 'POST',
 			headers: { 'Content-Type': 'application/json' },
 			body: JSON.stringify({
 				type: imageType,
-				data: storagePayload
+				ref: assetRef
 			})
 		});
 		
@@ -2279,7 +2274,7 @@ async function handleImageUpload(evt, imageType) {
 		if (!config.images) config.images = {};
 		const configPath = IMAGE_CONFIGS[imageType].configPath.split('.');
 		if (configPath[0] === 'images') {
-			config.images[configPath[1]] = storagePayload;
+			config.images[configPath[1]] = assetRef;
 		}
 		if (imageType === 'header') {
 			config.header = config.header || {};
@@ -2329,13 +2324,12 @@ function clearImage(imageType) {
 		headers: { 'Content-Type': 'application/json' },
 		body: JSON.stringify({
 			type: imageType,
-			data: ''
+			ref: ''
 		})
 	}).then(response => {
 		if (response.ok) {
 			const previewDiv = document.getElementById(`${imageType}-logo-preview`);
 			const uploadInput = document.getElementById(`${imageType}-logo-upload`);
-			lvimgPreviewCache.clear();
 			
 			if (previewDiv) previewDiv.style.display = 'none';
 			if (uploadInput) uploadInput.value = '';
@@ -2359,7 +2353,18 @@ function hydrateDisplay(){
 	const sleepTimeout = document.getElementById('sleep-timeout');
 	if (sleepTimeout) sleepTimeout.value = display.sleep_timeout_seconds ?? 60;
 
-	// Hydrate image assets
+	hydrateImagePreviews();
+
+	// Legacy sleep icon support
+	if(display.sleep_icon_base64){
+		if (!config.images) config.images = {};
+		if (!config.images.sleep_logo) {
+			config.images.sleep_logo = display.sleep_icon_base64;
+		}
+	}
+}
+
+function hydrateImagePreviews(){
 	const images = config.images || {};
 	
 	const headerPreviewSrc = getImagePreviewSrc(images.header_logo);
@@ -2393,21 +2398,21 @@ function hydrateDisplay(){
 		if (sleepImg) sleepImg.src = sleepPreviewSrc;
 		if (sleepPreview) sleepPreview.style.display = 'block';
 	}
+}
 
-	// Legacy sleep icon support
-	if(display.sleep_icon_base64){
-		if (!config.images) config.images = {};
-		if (!config.images.sleep_logo) {
-			config.images.sleep_logo = display.sleep_icon_base64;
-		}
+// The device cuts GET /api/config short (unparseable JSON) when an edit lands in a part it has not sent yet
+async function fetchConfig(){
+	for (let attempt = 1; ; attempt++){
+		const res = await fetch('/api/config');
+		try{ return await res.json(); }
+		catch(err){ if (attempt >= 3) throw err; }
 	}
 }
 
 async function loadConfig(){
 	try{
-		const res = await fetch('/api/config');
-		config = await res.json();
-		lvimgPreviewCache.clear();
+		config = await fetchConfig();
+		savedConfig = configWithoutImages(config);
 		ensurePages();
 		populateFontSelects();  // Must populate fonts BEFORE hydrating header fields
 		hydrateThemeFields();
@@ -2474,23 +2479,132 @@ async function saveConfig(){
 		sleep_icon_base64: existingDisplay.sleep_icon_base64 || ''
 	};
 	
-	// Remove images from config - they're uploaded separately via /api/image/upload
-	const configToSave = JSON.parse(JSON.stringify(config));
-	delete configToSave.images;
-	if (configToSave.header) {
-		delete configToSave.header.logo_base64;
-	}
-	if (configToSave.display) {
-		delete configToSave.display.sleep_icon_base64;
+	const configToSave = configWithoutImages(config);
+	const patch = buildConfigPatch(savedConfig, configToSave);
+	if (patch && patch.length === 0) {
+		showBanner('No changes to save','success');
+		return;
 	}
 
 	try{
-		const res = await fetch('/api/config',{ method:'POST', headers:{'Content-Type':'application/json'}, body: JSON.stringify(configToSave) });
-		if(!res.ok){ const text = await res.text(); throw new Error(text); }
+		if (!patch || !(await patchConfig(patch))) {
+			const res = await fetch('/api/config',{ method:'POST', headers:{'Content-Type':'application/json'}, body: JSON.stringify(configToSave) });
+			if(!res.ok){ const text = await res.text(); throw new Error(text); }
+		}
+		savedConfig = configToSave;
 		showBanner('Configuration saved. Reboot device to apply display changes.','success');
 	}catch(err){ showBanner('Save failed: '+err.message,'error'); }
 }
 
+// Images are uploaded separately via /api/image/upload, so they never travel with the config
+function configWithoutImages(source){
+	const copy = JSON.parse(JSON.stringify(source));
+	delete copy.images;
+	if (copy.header) {
+		delete copy.header.logo_base64;
+	}
+	if (copy.display) {
+		delete copy.display.sleep_icon_base64;
+	}
+	return copy;
+}
+
+const CONFIG_PATCH_SECTIONS = ['pages', 'theme'];
+const CONFIG_PATCH_MAX_OPS = 64;
+
+function jsonEqual(a, b){
+	if (a === b) return true;
+	if (typeof a !== 'object' || typeof b !== 'object' || a === null || b === null) return false;
+	if (Array.isArray(a) !== Array.isArray(b)) return false;
+	const keysA = Object.keys(a);
+	const keysB = Object.keys(b);
+	if (keysA.length !== keysB.length) return false;
+	return keysA.every(key => Object.prototype.hasOwnProperty.call(b, key) && jsonEqual(a[key], b[key]));
+}
+
+function isJsonObject(value){
+	return typeof value === 'object' && value !== null && !Array.isArray(value);
+}
+
+function pointerToken(key){
+	return String(key).replace(/~/g, '~0').replace(/\//g, '~1');
+}
+
+// RFC 6902 operations turning `before` into `after`: members one by one, arrays element by element
+// when the length holds, one add or remove when a single element was inserted or deleted, otherwise
+// the whole array
+function diffJson(before, after, path, ops){
+	if (jsonEqual(before, after)) return;
+	if (isJsonObject(before) && isJsonObject(after)) {
+		Object.keys(before).forEach(key => {
+			if (!Object.prototype.hasOwnProperty.call(after, key)) ops.push({ op:'remove', path: path + '/' + pointerToken(key) });
+		});
+		Object.keys(after).forEach(key => {
+			const child = path + '/' + pointerToken(key);
+			if (!Object.prototype.hasOwnProperty.call(before, key)) ops.push({ op:'add', path: child, value: after[key] });
+			else diffJson(before[key], after[key], child, ops);
+		});
+		return;
+	}
+	if (Array.isArray(before) && Array.isArray(after)) {
+		if (before.length === after.length) {
+			before.forEach((item, i) => diffJson(item, after[i], path + '/' + i, ops));
+			return;
+		}
+		let first = 0;
+		const shorter = Math.min(before.length, after.length);
+		while (first < shorter && jsonEqual(before[first], after[first])) first++;
+		if (after.length === before.length + 1 &&
+			jsonEqual(before.slice(first), after.slice(first + 1))) {
+			ops.push({ op:'add', path: path + '/' + (first === before.length ? '-' : first), value: after[first] });
+			return;
+		}
+		if (after.length === before.length - 1 &&
+			jsonEqual(before.slice(first + 1), after.slice(first))) {
+			ops.push({ op:'remove', path: path + '/' + first });
+			return;
+		}
+	}
+	ops.push({ op:'replace', path, value: after });
+}
+
+// A JSON Patch for PATCH /api/config, or null when the edit reaches outside pages and theme (or
+// is too big to be worth patching) and the whole config has to be sent
+function buildConfigPatch(before, after){
+	if (!before) return null;
+	const keys = new Set(Object.keys(before).concat(Object.keys(after)));
+	for (const key of keys) {
+		if (!CONFIG_PATCH_SECTIONS.includes(key) && !jsonEqual(before[key], after[key])) return null;
+	}
+	const ops = [];
+	CONFIG_PATCH_SECTIONS.forEach(key => {
+		if (before[key] === undefined || after[key] === undefined) {
+			if (!jsonEqual(before[key], after[key])) ops.push(null);
+			return;
+		}
+		diffJson(before[key], after[key], '/' + key, ops);
+	});
+	if (ops.includes(null) || ops.length > CONFIG_PATCH_MAX_OPS) return null;
+	return ops;
+}
+
+// False only when the device has no PATCH route (404/405, older firmware); the caller then sends the
+// whole config. A rejected patch (400 bad op, 409 device config changed since it was loaded) throws,
+// since posting the full config would silently overwrite whatever the patch tripped over
+async function patchConfig(ops){
+	const res = await fetch('/api/config',{ method:'PATCH', headers:{'Content-Type':'application/json'}, body: JSON.stringify(ops) });
+	if (res.ok) return true;
+	if (res.status === 404 || res.status === 405) {
+		console.warn('Config patch not supported, sending the full config', res.status);
+		return false;
+	}
+	const text = await res.text();
+	let message = text;
+	try{ message = JSON.parse(text).message || text; }catch(e){}
+	if (res.status === 409) throw new Error(`${message}. The device config changed since it was loaded; reload it and reapply your edits.`);
+	throw new Error(message || `HTTP ${res.status}`);
+}
+
 async function checkForUpdates(){
 	const btn = document.querySelector('button[onclick="checkForUpdates()"]');
 	if (btn) btn.disabled = true;
@@ -3,9 +3,23 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <AsyncJson.h>
+#include <LittleFS.h>
+#include <esp_heap_caps.h>
+#include <algorithm>
 #include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
 
+#include "asset_store.h"
 #include "can_manager.h"
+#include "can_module_status.h"
+#include "can_periodic.h"
+#include "can_recorder.h"
+#include "can_sequence.h"
+#include "can_signal_db.h"
+#include "can_trace.h"
+#include "config_json_stream.h"
 #include "config_manager.h"
 #include "ota_manager.h"
 #include "ui_builder.h"
@@ -18,10 +32,12 @@ const IPAddress kApIp(192, 168, 4, 250);
 const IPAddress kApGateway(192, 168, 4, 250);
 const IPAddress kApMask(255, 255, 255, 0);
 constexpr std::size_t kConfigJsonLimit = 2097152;  // 2MB to allow larger configs (base64 assets)
+constexpr std::size_t kConfigPatchJsonLimit = 16384;  // kMaxConfigPatchOps small edits; bigger changes go through POST
 constexpr std::size_t kWifiConnectJsonLimit = 1024;
 constexpr std::size_t kImageUploadJsonLimit = 2097152;  // 2MB limit for header/base64 payloads
 constexpr std::size_t kImageUploadContentLimit = 2097152;
 constexpr std::uint32_t kWifiReconfigureDelayMs = 750;  // Allow HTTP responses to finish before toggling radios
+constexpr std::size_t kCanReceiveMaxMessages = 64;  // Keeps /api/can/receive responses bounded; remaining frames wait for the next poll
 
 const char* AuthModeToString(wifi_auth_mode_t mode) {
     switch (mode) {
@@ -38,12 +54,93 @@ const char* AuthModeToString(wifi_auth_mode_t mode) {
     }
 }
 
+// Converts one recorder segment to text while it is being sent
+struct CanLogTextStream {
+    explicit CanLogTextStream(bool asc_format) : asc(asc_format), reader(&CanLogTextStream::read, this) {}
+
+    static std::size_t read(void* context, std::uint8_t* buffer, std::size_t length) {
+        return static_cast<CanLogTextStream*>(context)->file.read(buffer, length);
+    }
+
+    std::size_t fill(std::uint8_t* buffer, std::size_t max_len) {
+        std::size_t out = 0;
+        while (out < max_len) {
+            if (line_pos < line_len) {
+                const std::size_t chunk = std::min(max_len - out, line_len - line_pos);
+                memcpy(buffer + out, line + line_pos, chunk);
+                line_pos += chunk;
+                out += chunk;
+                continue;
+            }
+            if (finished) {
+                break;
+            }
+            line_pos = 0;
+            line_len = 0;
+            CanLogEntry entry;
+            if (reader.next(entry)) {
+                if (!based) {
+                    base_us = entry.time_us;
+                    based = true;
+                }
+                line_len = asc ? canLogFormatAsc(entry, base_us, line, sizeof(line))
+                               : canLogFormatCandump(entry, "can0", line, sizeof(line));
+            } else {
+                finished = true;
+                if (asc) {
+                    line_len = canLogAscFooter(line, sizeof(line));
+                }
+            }
+        }
+        return out;
+    }
+
+    bool asc;
+    File file;
+    CanLogReader reader;
+    char line[96] = {};
+    std::size_t line_len = 0;
+    std::size_t line_pos = 0;
+    std::uint64_t base_us = 0;
+    bool based = false;
+    bool finished = false;
+};
+
+// /api/can/receive polls share one cursor, so each returns what arrived since the last one from any client
+struct CanReceiveCursor {
+    std::mutex mutex;  // Requests on different connections may be handled concurrently
+    CanRxCursor cursor = CanManager::instance().openRxCursor();
+};
+
+CanReceiveCursor& canReceiveCursor() {
+    static CanReceiveCursor shared;
+    return shared;
+}
+
 bool WifiConfigEquals(const WifiConfig& lhs, const WifiConfig& rhs) {
     const auto creds_equal = [](const WifiCredentials& a, const WifiCredentials& b) {
         return a.enabled == b.enabled && a.ssid == b.ssid && a.password == b.password;
     };
     return creds_equal(lhs.ap, rhs.ap) && creds_equal(lhs.sta, rhs.sta);
 }
+
+// ?format=&width=&height= of a POST /api/assets body of `size` bytes
+bool assetHeaderFromRequest(AsyncWebServerRequest* request, std::size_t size, AssetHeader& header,
+                            std::string& error) {
+    AssetFormat format;
+    if (!request->hasParam("format") || !parseAssetFormat(request->getParam("format")->value().c_str(), format)) {
+        error = "format must be rgb565, rgb565a, png or jpeg";
+        return false;
+    }
+    const long width = request->hasParam("width") ? request->getParam("width")->value().toInt() : 0;
+    const long height = request->hasParam("height") ? request->getParam("height")->value().toInt() : 0;
+    if (width < 0 || width > 0xFFFF || height < 0 || height > 0xFFFF) {
+        error = "invalid image dimensions";
+        return false;
+    }
+    return makeAssetHeader(format, static_cast<std::uint16_t>(width), static_cast<std::uint16_t>(height), size, header,
+                           error);
+}
 }
 
 WebServerManager& WebServerManager::instance() {
@@ -114,12 +211,15 @@ void WebServerManager::configureWifi() {
     const bool sta_configured = wifi.sta.enabled && !wifi.sta.ssid.empty();
     if ((!wifi.ap.enabled || ap_suppressed_) && !sta_configured) {
         Serial.println("[WebServer] WARNING: Station credentials missing. Enabling fallback AP.");
-        wifi.ap.enabled = true;
-        ap_suppressed_ = false;
-        if (wifi.ap.ssid.empty()) {
-            wifi.ap.ssid = "CAN-Control";
+        {
+            auto lock = ConfigManager::instance().editLock();
+            wifi.ap.enabled = true;
+            if (wifi.ap.ssid.empty()) {
+                wifi.ap.ssid = "CAN-Control";
+            }
         }
-        ConfigManager::instance().save();
+        ap_suppressed_ = false;
+        ConfigManager::instance().requestSave(configJsonSectionBit("wifi"));
     }
 
     if (ap_suppressed_ && !sta_connected_) {
@@ -226,7 +326,7 @@ void WebServerManager::setupRoutes() {
     });
 
     server_.on("/api/status", HTTP_GET, [this](AsyncWebServerRequest* request) {
-        DynamicJsonDocument doc(384);
+        DynamicJsonDocument doc(768);
         doc["firmware_version"] = APP_VERSION;
         doc["ap_ip"] = ap_ip_.toString();
         doc["sta_ip"] = sta_ip_.toString();
@@ -257,15 +357,56 @@ void WebServerManager::setupRoutes() {
 
         doc["uptime_ms"] = millis();
         doc["heap"] = ESP.getFreeHeap();
+
+        // Internal RAM is what LVGL, WiFi and the TCP stack compete for: low-water mark since boot, and how
+        // fragmented the free space is (largest block against the total)
+        JsonObject internal = doc.createNestedObject("heap_internal");
+        internal["free"] = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+        internal["min_free"] = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+        internal["largest_block"] = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+        doc["psram_free"] = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+
+        // Edits are written by a background worker; pending_writes stays true until the latest one is on flash
+        const auto& config_mgr = ConfigManager::instance();
+        const ConfigSaveStats saves = config_mgr.saveStats();
+        JsonObject persist = doc.createNestedObject("config_persist");
+        persist["pending_writes"] = config_mgr.savePending();
+        persist["pending_ms"] = config_mgr.savePendingForMs();
+        persist["requests"] = saves.requests;
+        persist["writes"] = saves.writes;
+        persist["coalesced"] = saves.coalesced;
+        persist["failures"] = saves.failures;
         String payload;
         serializeJson(doc, payload);
         request->send(200, "application/json", payload);
     });
 
+    // Streamed a piece at a time (config_json_stream.h) rather than built as one document and String.
+    // An edit between chunks that only touched sections already sent (a brightness drag, new Wi-Fi
+    // credentials) leaves the response as the config was before it. One that touched a section not yet
+    // (fully) sent ends the body early, unterminated, so the client fails to parse it rather than loading a
+    // config spliced from before and after the edit; the web UI retries the GET (fetchConfig).
     server_.on("/api/config", HTTP_GET, [](AsyncWebServerRequest* request) {
-        std::string json = ConfigManager::instance().toJson();
-        String payload(json.c_str());
-        request->send(200, "application/json", payload);
+        ConfigManager& config_mgr = ConfigManager::instance();
+        auto stream = std::make_shared<ConfigJsonStream>(config_mgr.getConfig());
+        const uint32_t generation = config_mgr.editGeneration();
+        request->send(request->beginChunkedResponse(
+            "application/json", [stream, generation](uint8_t* buffer, size_t max_len, size_t) -> size_t {
+                ConfigManager& config_mgr = ConfigManager::instance();
+                auto lock = config_mgr.editLock();
+                if (stream->failed()) {
+                    return 0;
+                }
+                if (config_mgr.editGeneration() != generation && config_mgr.editedSince(generation, stream->section())) {
+                    Serial.println("[WebServer] Config changed during GET /api/config; response cut short");
+                    return 0;
+                }
+                const size_t written = stream->fill(buffer, max_len);
+                if (stream->failed()) {
+                    Serial.println("[WebServer] Config piece too large to stream; response cut short");
+                }
+                return written;
+            }));
     });
 
     auto* handler = new AsyncCallbackJsonWebHandler("/api/config",
@@ -283,13 +424,28 @@ void WebServerManager::setupRoutes() {
                 return;
             }
 
-            const bool wifi_changed = !WifiConfigEquals(previous_wifi, config_mgr.getConfig().wifi);
-
-            if (!config_mgr.save()) {
-                request->send(500, "application/json", "{\"status\":\"error\",\"message\":\"Failed to persist\"}");
+            if (!CanSequenceEngine::instance().load(config_mgr.getConfig().can_sequences, error) ||
+                !CanPeriodicScheduler::instance().load(config_mgr.getConfig().can_periodic, error) ||
+                !CanSignalDatabase::instance().load(config_mgr.getConfig().can_signals, error) ||
+                !CanModuleStatus::instance().load(config_mgr.getConfig().can_modules, error)) {
+                DynamicJsonDocument doc(256);
+                doc["status"] = "error";
+                doc["message"] = error.c_str();
+                String payload;
+                serializeJson(doc, payload);
+                request->send(400, "application/json", payload);
                 return;
             }
 
+            CanManager::instance().configureBus(config_mgr.getConfig().can_bus);
+            CanManager::instance().configureFilters(config_mgr.getConfig());
+            CanManager::instance().configureAddressing(config_mgr.getConfig());
+            CanManager::instance().configureCoalescing(config_mgr.getConfig().can_coalesce);
+            CanRecorder::instance().configure(config_mgr.getConfig().can_recorder);
+
+            const bool wifi_changed = !WifiConfigEquals(previous_wifi, config_mgr.getConfig().wifi);
+
+            config_mgr.requestSave();
             UIBuilder::instance().markDirty();
 
             if (wifi_changed) {
@@ -304,9 +460,46 @@ void WebServerManager::setupRoutes() {
             serializeJson(doc, payload);
             request->send(200, "application/json", payload);
         }, kConfigJsonLimit);
+    handler->setMethod(HTTP_POST | HTTP_PUT);  // PATCH has its own handler below
     handler->setMaxContentLength(kConfigJsonLimit);  // CRITICAL: Also set max content length to 2MB
     server_.addHandler(handler);
 
+    // RFC 6902 edits to pages, buttons and theme (config_patch.h); replies with the UI regions that changed
+    auto* patch_handler = new AsyncCallbackJsonWebHandler("/api/config",
+        [](AsyncWebServerRequest* request, JsonVariant& json) {
+            auto& config_mgr = ConfigManager::instance();
+            ConfigPatchResult result;
+            std::string error;
+            if (!config_mgr.applyPatch(json.as<JsonVariantConst>(), result, error)) {
+                DynamicJsonDocument doc(256);
+                doc["status"] = "error";
+                doc["message"] = error.c_str();
+                doc["failed_op"] = result.failed_op;
+                String payload;
+                serializeJson(doc, payload);
+                request->send(result.conflict ? 409 : 400, "application/json", payload);
+                return;
+            }
+
+            if (!result.changed.empty()) {
+                config_mgr.requestSave();
+                UIBuilder::instance().markDirty();
+            }
+
+            DynamicJsonDocument doc(256 + result.changed.size() * 64);
+            doc["status"] = "ok";
+            JsonArray changed = doc.createNestedArray("changed");
+            for (const std::string& region : result.changed) {
+                changed.add(region.c_str());
+            }
+            String payload;
+            serializeJson(doc, payload);
+            request->send(200, "application/json", payload);
+        }, kConfigPatchJsonLimit);
+    patch_handler->setMethod(HTTP_PATCH);
+    patch_handler->setMaxContentLength(kConfigPatchJsonLimit);
+    server_.addHandler(patch_handler);
+
     auto* wifi_handler = new AsyncCallbackJsonWebHandler("/api/wifi/connect",
         [this](AsyncWebServerRequest* request, JsonVariant& json) {
             String ssid = json["ssid"] | "";
@@ -324,13 +517,15 @@ void WebServerManager::setupRoutes() {
             }
 
             auto& cfg = ConfigManager::instance().getConfig();
-            cfg.wifi.sta.enabled = true;
-            cfg.wifi.sta.ssid = ssid.c_str();
-            cfg.wifi.sta.password = password.c_str();
-
-            if (persist && !ConfigManager::instance().save()) {
-                request->send(500, "application/json", "{\"status\":\"error\",\"message\":\"Failed to persist\"}");
-                return;
+            {
+                auto lock = ConfigManager::instance().editLock();
+                cfg.wifi.sta.enabled = true;
+                cfg.wifi.sta.ssid = ssid.c_str();
+                cfg.wifi.sta.password = password.c_str();
+                ConfigManager::instance().markEdited(configJsonSectionBit("wifi"));  // Also when it is not persisted
+            }
+            if (persist) {
+                ConfigManager::instance().requestSave(configJsonSectionBit("wifi"));
             }
 
             request->onDisconnect([this]() {
@@ -346,49 +541,64 @@ void WebServerManager::setupRoutes() {
         }, kWifiConnectJsonLimit);
     server_.addHandler(wifi_handler);
 
-    // Dedicated image upload endpoints (separate from main config to avoid size limits)
+    // Points an image slot at a stored asset: {"type":"header","ref":"asset:<id>"}, an empty ref clears it.
+    // An inline "data" payload (lvimg or data URL) is still accepted and moved to the asset store first.
     auto* image_handler = new AsyncCallbackJsonWebHandler("/api/image/upload",
         [this](AsyncWebServerRequest* request, JsonVariant& json) {
             String imageType = json["type"] | "";
-            String imageData = json["data"] | "";
-            
+            std::string ref = json["ref"] | "";
+            if (ref.empty()) {
+                ref = json["data"] | "";
+            }
+
             if (imageType.isEmpty()) {
                 request->send(400, "application/json", "{\"status\":\"error\",\"message\":\"Missing type\"}");
                 return;
             }
-            
-            // Allow empty data for clearing images
-            Serial.printf("[WebServer] Image upload: type=%s, data_length=%d\n", imageType.c_str(), imageData.length());
-            
+
+            std::string error;
+            AssetId id = 0;
+            if (!AssetStore::instance().internInline(ref, error) ||
+                (!ref.empty() && (!parseAssetRef(ref, id) || !AssetStore::instance().exists(id)))) {
+                DynamicJsonDocument doc(256);
+                doc["status"] = "error";
+                doc["message"] = error.empty() ? "Unknown asset" : error.c_str();
+                String payload;
+                serializeJson(doc, payload);
+                request->send(400, "application/json", payload);
+                return;
+            }
+            Serial.printf("[WebServer] Image upload: type=%s, ref=%s\n", imageType.c_str(),
+                          ref.empty() ? "(cleared)" : ref.c_str());
+
             auto& cfg = ConfigManager::instance().getConfig();
-            
-            // Store image in appropriate field
+            auto lock = ConfigManager::instance().editLock();
+
             if (imageType == "header") {
-                cfg.images.header_logo = imageData.c_str();
+                cfg.images.header_logo = ref;
                 // Toggle logo display based on whether we have data
-                cfg.header.show_logo = !imageData.isEmpty();
+                cfg.header.show_logo = !ref.empty();
                 // Clear logo_variant when custom header is uploaded
-                if (!imageData.isEmpty()) {
+                if (!ref.empty()) {
                     cfg.header.logo_variant = "";
                 }
             } else if (imageType == "splash") {
-                cfg.images.splash_logo = imageData.c_str();
+                cfg.images.splash_logo = ref;
             } else if (imageType == "background") {
-                cfg.images.background_image = imageData.c_str();
+                cfg.images.background_image = ref;
             } else if (imageType == "sleep") {
-                cfg.images.sleep_logo = imageData.c_str();
+                cfg.images.sleep_logo = ref;
             } else {
                 request->send(400, "application/json", "{\"status\":\"error\",\"message\":\"Invalid image type\"}");
                 return;
             }
-            
-            if (!ConfigManager::instance().save()) {
-                request->send(500, "application/json", "{\"status\":\"error\",\"message\":\"Failed to save\"}");
-                return;
-            }
-            
+
+            lock.unlock();
+            // The asset it replaced is collected once that lands
+            ConfigManager::instance().requestSave(configJsonSectionBit("images") | configJsonSectionBit("header"));
+
             UIBuilder::instance().markDirty();
-            
+
             DynamicJsonDocument doc(64);
             doc["status"] = "ok";
             String payload;
@@ -398,6 +608,95 @@ void WebServerManager::setupRoutes() {
     image_handler->setMaxContentLength(kImageUploadContentLimit);
     server_.addHandler(image_handler);
 
+    // Asset store: list, or one asset's payload (/api/assets/<id>) with its shape in X-Asset-* headers
+    server_.on("/api/assets", HTTP_GET, [](AsyncWebServerRequest* request) {
+        const String url = request->url();
+        const int slash = url.lastIndexOf('/');
+        AssetId id = 0;
+        if (url == "/api/assets") {
+            const auto assets = AssetStore::instance().list();
+            const std::vector<AssetId> live = referencedAssets(ConfigManager::instance().getConfig());
+            DynamicJsonDocument doc(256 + assets.size() * 160);
+            JsonArray array = doc.createNestedArray("assets");
+            std::uint32_t total = 0;
+            for (const auto& asset : assets) {
+                JsonObject obj = array.createNestedObject();
+                obj["ref"] = assetRef(asset.id);
+                obj["format"] = assetFormatName(static_cast<AssetFormat>(asset.header.format));
+                obj["width"] = asset.header.width;
+                obj["height"] = asset.header.height;
+                obj["bytes"] = asset.header.data_size;
+                obj["referenced"] = std::find(live.begin(), live.end(), asset.id) != live.end();
+                total += asset.header.data_size;
+            }
+            doc["bytes"] = total;
+            String payload;
+            serializeJson(doc, payload);
+            request->send(200, "application/json", payload);
+            return;
+        }
+        if (!parseAssetRef(std::string(kAssetRefPrefix) + url.substring(slash + 1).c_str(), id)) {
+            request->send(400, "application/json", "{\"error\":\"Invalid asset id\"}");
+            return;
+        }
+
+        AssetHeader header{};
+        auto file = std::make_shared<File>(AssetStore::instance().open(id, header));
+        if (!*file) {
+            request->send(404, "application/json", "{\"error\":\"No such asset\"}");
+            return;
+        }
+        const AssetFormat format = static_cast<AssetFormat>(header.format);
+        AsyncWebServerResponse* response = request->beginResponse(
+            assetMimeType(format), header.data_size, [file](uint8_t* buffer, size_t max_len, size_t) -> size_t {
+                return file->read(buffer, max_len);
+            });
+        response->addHeader("Cache-Control", "public, max-age=31536000, immutable");  // Contents never change under an id
+        response->addHeader("X-Asset-Format", assetFormatName(format));
+        response->addHeader("X-Asset-Width", String(header.width));
+        response->addHeader("X-Asset-Height", String(header.height));
+        request->send(response);
+    });
+
+    // Streams a raw payload into the store: POST /api/assets?format=rgb565a&width=W&height=H, body = pixels
+    // (or a PNG/JPEG file with format=png|jpeg). Replies with the asset's reference for /api/image/upload.
+    server_.on("/api/assets", HTTP_POST,
+        [](AsyncWebServerRequest* request) {
+            AssetHeader header;
+            std::string error;
+            AssetId id = 0;
+            if (!assetHeaderFromRequest(request, request->contentLength(), header, error) ||
+                !AssetStore::instance().finishUpload(id, error)) {
+                AssetStore::instance().abortUpload();
+                DynamicJsonDocument doc(256);
+                doc["status"] = "error";
+                doc["message"] = error.c_str();
+                String payload;
+                serializeJson(doc, payload);
+                request->send(400, "application/json", payload);
+                return;
+            }
+            DynamicJsonDocument doc(128);
+            doc["status"] = "ok";
+            doc["ref"] = assetRef(id);
+            String payload;
+            serializeJson(doc, payload);
+            request->send(200, "application/json", payload);
+        },
+        nullptr,
+        [](AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+            AssetStore& store = AssetStore::instance();
+            if (index == 0) {
+                AssetHeader header;
+                std::string error;
+                if (!assetHeaderFromRequest(request, total, header, error) || !store.beginUpload(header, error)) {
+                    store.abortUpload();
+                    return;  // Reported once the body is in
+                }
+            }
+            store.writeUpload(data, len);
+        });
+
     server_.on("/api/wifi/scan", HTTP_GET, [](AsyncWebServerRequest* request) {
         const int16_t count = WiFi.scanNetworks(/*async=*/false, /*show_hidden=*/true);
         if (count < 0) {
@@ -484,7 +783,6 @@ void WebServerManager::setupRoutes() {
             frame.enabled = true;
             frame.pgn = doc["pgn"] | 0xFF01;
             frame.priority = doc["priority"] | 6;
-            frame.source_address = doc["source"] | 0xF9;
             frame.destination_address = doc["destination"] | 0xFF;
             
             JsonArray dataArray = doc["data"];
@@ -500,6 +798,7 @@ void WebServerManager::setupRoutes() {
             }
             frame.length = static_cast<uint8_t>(idx);  // Set actual data length
 
+            // Queued for the TX scheduler; the handler no longer waits on the bus
             bool success = CanManager::instance().sendFrame(frame);
             
             DynamicJsonDocument response(256);
@@ -512,22 +811,29 @@ void WebServerManager::setupRoutes() {
             request->send(success ? 200 : 500, "application/json", payload);
         });
 
-    // Receive CAN messages endpoint
+    // Receive CAN messages endpoint: returns what is already buffered and never waits, since this runs on the
+    // AsyncTCP task. A "timeout" parameter from older clients is ignored; they poll again instead
     server_.on("/api/can/receive", HTTP_GET, [](AsyncWebServerRequest* request) {
-        uint32_t timeout = 500;
-        if (request->hasParam("timeout")) {
-            timeout = request->getParam("timeout")->value().toInt();
+        std::vector<CanRxMessage> messages;
+        uint32_t dropped = 0;
+        uint32_t pending = 0;
+        {
+            CanReceiveCursor& shared = canReceiveCursor();
+            std::lock_guard<std::mutex> lock(shared.mutex);
+            const uint32_t dropped_before = shared.cursor.dropped;
+            messages = CanManager::instance().readAll(shared.cursor, kCanReceiveMaxMessages, 0);
+            dropped = shared.cursor.dropped - dropped_before;
+            pending = CanManager::instance().rxPending(shared.cursor);
         }
 
-        std::vector<CanRxMessage> messages = CanManager::instance().receiveAll(timeout);
-        
-        DynamicJsonDocument doc(4096);
+        DynamicJsonDocument doc(8192);
         JsonArray array = doc.createNestedArray("messages");
         
         for (const auto& msg : messages) {
             JsonObject msgObj = array.createNestedObject();
             msgObj["id"] = String(msg.identifier, HEX);
             msgObj["timestamp"] = msg.timestamp;
+            msgObj["timestamp_us"] = msg.timestamp_us;
             
             JsonArray dataArray = msgObj.createNestedArray("data");
             for (uint8_t i = 0; i < msg.length; i++) {
@@ -536,12 +842,366 @@ void WebServerManager::setupRoutes() {
         }
         
         doc["count"] = messages.size();
+        doc["dropped"] = dropped;
+        doc["pending"] = pending;
         
         String payload;
         serializeJson(doc, payload);
         request->send(200, "application/json", payload);
     });
 
+    // Binary dump of the CAN trace ring (decode with tools/can_trace_decode.py)
+    server_.on("/api/can/trace", HTTP_GET, [](AsyncWebServerRequest* request) {
+        std::size_t max_records = CanTrace::kCapacity;
+        if (request->hasParam("count")) {
+            max_records = std::min<std::size_t>(max_records, request->getParam("count")->value().toInt());
+        }
+
+        std::vector<CanTraceRecord> records(max_records);
+        const std::size_t count = CanTrace::instance().copyRecent(records.data(), records.size());
+
+        CanTrace::DumpHeader header{};
+        header.magic = CanTrace::kDumpMagic;
+        header.version = CanTrace::kDumpVersion;
+        header.record_size = sizeof(CanTraceRecord);
+        header.count = count;
+        header.dropped = CanTrace::instance().dropped();
+
+        AsyncResponseStream* response = request->beginResponseStream("application/octet-stream");
+        response->addHeader("Content-Disposition", "attachment; filename=\"can_trace.bin\"");
+        response->write(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+        response->write(reinterpret_cast<const uint8_t*>(records.data()), count * sizeof(CanTraceRecord));
+        request->send(response);
+    });
+
+    // Flight recorder: segment list, or one segment as raw/candump/asc (?segment=N&format=)
+    server_.on("/api/can/log", HTTP_GET, [](AsyncWebServerRequest* request) {
+        CanRecorder& recorder = CanRecorder::instance();
+        if (!request->hasParam("segment")) {
+            const CanRecorder::Status status = recorder.status();
+            const auto segments = recorder.segments();
+            DynamicJsonDocument doc(512 + segments.size() * 64);
+            doc["enabled"] = status.enabled;
+            doc["segment"] = status.segment;
+            doc["blocks_written"] = status.blocks_written;
+            doc["records_written"] = status.records_written;
+            doc["records_dropped"] = status.records_dropped;
+            doc["write_errors"] = status.write_errors;
+            doc["bytes_on_disk"] = status.bytes_on_disk;
+            JsonArray array = doc.createNestedArray("segments");
+            for (const auto& segment : segments) {
+                JsonObject obj = array.createNestedObject();
+                obj["index"] = segment.index;
+                obj["size"] = segment.size;
+            }
+            String payload;
+            serializeJson(doc, payload);
+            request->send(200, "application/json", payload);
+            return;
+        }
+
+        const uint32_t index = request->getParam("segment")->value().toInt();
+        const std::string path = CanRecorder::segmentPath(index);
+        if (!LittleFS.exists(path.c_str())) {
+            request->send(404, "application/json", "{\"error\":\"No such segment\"}");
+            return;
+        }
+        recorder.flush();
+
+        const String format = request->hasParam("format") ? request->getParam("format")->value() : "raw";
+        if (format == "raw") {
+            request->send(LittleFS, path.c_str(), "application/octet-stream", true);
+            return;
+        }
+        if (format != "candump" && format != "asc") {
+            request->send(400, "application/json", "{\"error\":\"format must be raw, candump or asc\"}");
+            return;
+        }
+
+        auto stream = std::make_shared<CanLogTextStream>(format == "asc");
+        stream->file = LittleFS.open(path.c_str(), FILE_READ);
+        if (stream->asc) {
+            stream->line_len = canLogAscHeader(stream->line, sizeof(stream->line));
+        }
+        AsyncWebServerResponse* response = request->beginChunkedResponse(
+            "text/plain", [stream](uint8_t* buffer, size_t max_len, size_t) -> size_t {
+                return stream->fill(buffer, max_len);
+            });
+        char filename[48];
+        snprintf(filename, sizeof(filename), "canlog_%08lu.%s", static_cast<unsigned long>(index),
+                 stream->asc ? "asc" : "log");
+        response->addHeader("Content-Disposition", String("attachment; filename=\"") + filename + "\"");
+        request->send(response);
+    });
+
+    // Replay / traffic generator status
+    server_.on("/api/can/replay", HTTP_GET, [](AsyncWebServerRequest* request) {
+        const CanReplayEngine::Status status = CanManager::instance().replayStatus();
+        DynamicJsonDocument doc(384);
+        doc["mode"] = CanReplayEngine::modeName(status.mode);
+        doc["target"] = CanManager::instance().replayTarget() == CanReplayTarget::BUS ? "bus" : "virtual";
+        doc["speed"] = status.speed;
+        doc["loop"] = status.loop;
+        doc["position"] = status.position;
+        doc["total"] = status.total;
+        doc["sent"] = status.sent;
+        doc["rejected"] = status.rejected;
+        doc["loops"] = status.loops;
+        doc["max_late_us"] = status.max_late_us;
+        doc["elapsed_ms"] = static_cast<uint32_t>(status.elapsed_us / 1000);
+        String payload;
+        serializeJson(doc, payload);
+        request->send(200, "application/json", payload);
+    });
+
+    // {"mode":"replay","segment":3} | {"mode":"generator","load_percent":40,"pattern":"burst"} | {"mode":"stop"}
+    // Common: "target":"virtual"|"bus", "speed":1-50, "loop", "include_tx"
+    server_.on("/api/can/replay", HTTP_POST, [](AsyncWebServerRequest* request) {}, nullptr,
+        [](AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+            DynamicJsonDocument doc(1024);
+            if (deserializeJson(doc, data, len)) {
+                request->send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+                return;
+            }
+
+            CanManager& can = CanManager::instance();
+            const String mode = doc["mode"] | "replay";
+            if (mode == "stop") {
+                can.stopReplay();
+                request->send(200, "application/json", "{\"success\":true}");
+                return;
+            }
+
+            const String target_name = doc["target"] | "virtual";
+            const CanReplayTarget target = target_name == "bus" ? CanReplayTarget::BUS : CanReplayTarget::VIRTUAL;
+            CanReplayOptions options;
+            options.speed = doc["speed"] | 1.0f;
+            options.loop = doc["loop"] | false;
+            options.include_tx = doc["include_tx"] | false;
+
+            std::string error;
+            bool success = false;
+            if (mode == "replay") {
+                if (!doc.containsKey("segment")) {
+                    request->send(400, "application/json", "{\"error\":\"Missing segment\"}");
+                    return;
+                }
+                success = can.startReplay(doc["segment"].as<uint32_t>(), target, options, error);
+            } else if (mode == "generator") {
+                CanTrafficProfile profile;
+                const String pattern = doc["pattern"] | "constant";
+                profile.pattern = pattern == "ramp"    ? CanTrafficProfile::Pattern::RAMP
+                                  : pattern == "burst" ? CanTrafficProfile::Pattern::BURST
+                                                       : CanTrafficProfile::Pattern::CONSTANT;
+                profile.load_percent = doc["load_percent"] | profile.load_percent;
+                profile.period_ms = doc["period_ms"] | profile.period_ms;
+                profile.duty_percent = doc["duty_percent"] | profile.duty_percent;
+                profile.length = doc["length"] | profile.length;
+                for (JsonVariant id : doc["identifiers"].as<JsonArray>()) {
+                    profile.identifiers.push_back(id.as<uint32_t>() & 0x1FFFFFFF);
+                }
+                success = can.startGenerator(profile, target, options, error);
+            } else {
+                error = "mode must be replay, generator or stop";
+            }
+
+            DynamicJsonDocument response(256);
+            response["success"] = success;
+            if (!success) {
+                response["error"] = error.c_str();
+            }
+            String payload;
+            serializeJson(response, payload);
+            request->send(success ? 200 : 400, "application/json", payload);
+        });
+
+    // Periodic transmit schedule with per-frame release jitter
+    server_.on("/api/can/periodic", HTTP_GET, [](AsyncWebServerRequest* request) {
+        auto& periodic = CanPeriodicScheduler::instance();
+        if (request->hasParam("reset")) {
+            periodic.resetStats();
+        }
+
+        const auto entries = periodic.stats();
+        DynamicJsonDocument doc(256 + entries.size() * 256);
+        doc["bus_load_percent"] = periodic.busLoadPercent(CanManager::instance().bitrate());
+        JsonArray array = doc.createNestedArray("frames");
+        for (const auto& entry : entries) {
+            JsonObject obj = array.createNestedObject();
+            obj["id"] = entry.id.c_str();
+            obj["period_ms"] = entry.period_ms;
+            obj["phase_ms"] = entry.phase_ms;
+            obj["sent"] = entry.sent;
+            obj["rejected"] = entry.rejected;
+            obj["missed"] = entry.missed;
+            obj["avg_late_us"] = entry.avg_late_us;
+            obj["max_late_us"] = entry.max_late_us;
+        }
+
+        String payload;
+        serializeJson(doc, payload);
+        request->send(200, "application/json", payload);
+    });
+
+    // Bus health: controller state, alert counts, load and per-PGN traffic
+    server_.on("/api/can/stats", HTTP_GET, [](AsyncWebServerRequest* request) {
+        if (request->hasParam("reset")) {
+            CanManager::instance().resetBusStats();
+            CanManager::instance().resetCoalesceStats();
+        }
+        const CanBusSnapshot bus = CanManager::instance().busStats();
+        const uint32_t now = millis();
+        DynamicJsonDocument doc(1024 + bus.pgns.size() * 160);
+        doc["state"] = bus.bus_state;
+        doc["bitrate"] = CanManager::instance().bitrate();
+        if (CanManager::instance().autoBaudEnabled()) {
+            const CanAutoBaudResult& baud = CanManager::instance().autoBaudResult();
+            JsonObject auto_baud = doc.createNestedObject("auto_baud");
+            auto_baud["locked"] = baud.locked;
+            auto_baud["detect_ms"] = baud.elapsed_ms;
+            auto_baud["probes"] = baud.probes;
+            auto_baud["rejected"] = baud.rejected;
+        }
+        const CanCoalesceStats coalesce = CanManager::instance().coalesceStats();
+        JsonObject buttons = doc.createNestedObject("button_coalescing");
+        buttons["events"] = coalesce.events;
+        buttons["sent"] = coalesce.sent;
+        buttons["duplicates"] = coalesce.duplicates;
+        buttons["deferred"] = coalesce.deferred;
+        buttons["superseded"] = coalesce.superseded;
+        doc["tx_error_counter"] = bus.tx_error_counter;
+        doc["rx_error_counter"] = bus.rx_error_counter;
+        doc["rx_frames"] = bus.rx_frames;
+        doc["tx_frames"] = bus.tx_frames;
+        doc["load_percent"] = bus.load_percent;
+        doc["peak_load_percent"] = bus.peak_load_percent;
+        doc["untracked_frames"] = bus.untracked_frames;
+        JsonObject alerts = doc.createNestedObject("alerts");
+        for (std::size_t i = 0; i < bus.alerts.size(); ++i) {
+            alerts[CanBusStats::alertName(static_cast<CanBusAlert>(i))] = bus.alerts[i];
+        }
+        JsonArray pgns = doc.createNestedArray("pgns");
+        for (const auto& entry : bus.pgns) {
+            JsonObject obj = pgns.createNestedObject();
+            obj["pgn"] = entry.pgn;
+            obj["rx"] = entry.rx_frames;
+            obj["tx"] = entry.tx_frames;
+            obj["rx_per_sec"] = entry.rx_per_sec;
+            obj["tx_per_sec"] = entry.tx_per_sec;
+            if (entry.rx_frames) {
+                obj["rx_age_ms"] = now - entry.last_rx_ms;
+            }
+            if (entry.tx_frames) {
+                obj["tx_age_ms"] = now - entry.last_tx_ms;
+            }
+        }
+
+        String payload;
+        serializeJson(doc, payload);
+        request->send(200, "application/json", payload);
+    });
+
+    // Button press-to-wire latency: per-stage histograms summarised as p50/p99 (?reset to clear)
+    server_.on("/api/can/latency", HTTP_GET, [](AsyncWebServerRequest* request) {
+        CanLatencyTracer& tracer = CanLatencyTracer::instance();
+        if (request->hasParam("reset")) {
+            tracer.reset();
+        }
+        const CanLatencySnapshot lat = tracer.snapshot();
+        DynamicJsonDocument doc(1536);
+        doc["presses"] = lat.presses;
+        doc["completed"] = lat.completed;
+        doc["abandoned"] = lat.abandoned;
+        JsonObject stages = doc.createNestedObject("stages");
+        for (std::size_t i = 0; i < lat.stages.size(); ++i) {
+            const CanLatencySnapshot::Stage& stage = lat.stages[i];
+            JsonObject obj = stages.createNestedObject(CanLatencyTracer::stageName(static_cast<CanLatencyStage>(i)));
+            obj["count"] = stage.count;
+            obj["p50_us"] = stage.p50_us;
+            obj["p99_us"] = stage.p99_us;
+            obj["max_us"] = stage.max_us;
+            obj["mean_us"] = stage.mean_us;
+            obj["last_us"] = lat.last[i];
+        }
+
+        String payload;
+        serializeJson(doc, payload);
+        request->send(200, "application/json", payload);
+    });
+
+    // Latest decoded value of every configured signal
+    server_.on("/api/can/signals", HTTP_GET, [](AsyncWebServerRequest* request) {
+        const auto signals = CanSignalDatabase::instance().snapshot();
+        const uint32_t now = millis();
+        DynamicJsonDocument doc(256 + signals.size() * 256);
+        JsonArray array = doc.createNestedArray("signals");
+        for (const auto& signal : signals) {
+            JsonObject obj = array.createNestedObject();
+            obj["name"] = signal.name.c_str();
+            obj["unit"] = signal.unit.c_str();
+            obj["pgn"] = signal.pgn;
+            obj["updates"] = signal.updates;
+            if (signal.updates == 0) {
+                obj["value"] = nullptr;
+                continue;
+            }
+            obj["value"] = signal.value;
+            obj["raw"] = signal.raw;
+            obj["age_ms"] = now - signal.timestamp;
+        }
+
+        String payload;
+        serializeJson(doc, payload);
+        request->send(200, "application/json", payload);
+    });
+
+    // Output state of every configured module, as last reported on FF5x
+    server_.on("/api/can/modules", HTTP_GET, [](AsyncWebServerRequest* request) {
+        const auto modules = CanModuleStatus::instance().snapshot();
+        const uint32_t now = millis();
+        DynamicJsonDocument doc(256 + modules.size() * (256 + CanModuleStatus::kMaxOutputs * 64));
+        JsonArray array = doc.createNestedArray("modules");
+        for (const auto& module : modules) {
+            JsonObject obj = array.createNestedObject();
+            obj["id"] = module.id.c_str();
+            obj["name"] = module.name.c_str();
+            obj["type"] = module.type.c_str();
+            obj["address"] = module.address;
+            obj["online"] = module.online;
+            obj["polls"] = module.polls;
+            obj["replies"] = module.replies;
+            if (module.replies) {
+                obj["age_ms"] = now - module.last_reply_ms;
+            }
+            JsonArray outputs = obj.createNestedArray("outputs");
+            for (const auto& output : module.outputs) {
+                JsonObject out = outputs.createNestedObject();
+                out["state"] = CanModuleStatus::stateName(output.state);
+                out["current_ma"] = output.current_ma;
+            }
+        }
+
+        String payload;
+        serializeJson(doc, payload);
+        request->send(200, "application/json", payload);
+    });
+
+    // Run a configured CAN sequence by id
+    server_.on("/api/can/sequence", HTTP_POST, [](AsyncWebServerRequest* request) {
+        if (!request->hasParam("id")) {
+            request->send(400, "application/json", "{\"error\":\"Missing id parameter\"}");
+            return;
+        }
+        const std::string id = request->getParam("id")->value().c_str();
+        bool success = CanManager::instance().startSequence(id);
+        DynamicJsonDocument response(256);
+        response["success"] = success;
+        response["id"] = id.c_str();
+        String payload;
+        serializeJson(response, payload);
+        request->send(success ? 200 : 404, "application/json", payload);
+    });
+
     // Infinitybox Output1 ON
     server_.on("/api/infinitybox/output1/on", HTTP_POST, [](AsyncWebServerRequest* request) {
         bool success = CanManager::instance().sendInfinityboxOutput1On();
@@ -0,0 +1,136 @@
+"""Convert CAN flight recorder segments from the panel to candump or Vector ASC.
+
+List the segments with:
+    curl http://<device-ip>/api/can/log
+fetch one with:
+    curl -o 00000003.clg "http://<device-ip>/api/can/log?segment=3"
+then run:
+    python tools/can_log_convert.py 00000003.clg > bus.log
+    python tools/can_log_convert.py --asc 00000002.clg 00000003.clg > bus.asc
+
+Segments can also be given as URLs. The panel can do the same conversion
+itself with ?format=candump or ?format=asc.
+
+File layout matches src/can_log_format.h (little-endian): a 32-byte segment
+header, then blocks of a 20-byte header plus CanTraceRecord entries. Each
+block carries a CRC-32 of its records; conversion stops at the first block
+that fails it (the tail torn by a reset or power loss).
+"""
+
+import argparse
+import struct
+import sys
+import urllib.request
+import zlib
+
+SEGMENT = struct.Struct("<IHHIIQQ")  # magic, version, record_size, segment, reserved, start_us, start_unix_us
+BLOCK = struct.Struct("<IIHHII")     # magic, sequence, count, reserved, dropped, crc
+RECORD = struct.Struct("<II8sBBH")   # timestamp_us, identifier, data, event, length, arg
+SEGMENT_MAGIC = 0x474F4C43           # "CLOG"
+BLOCK_MAGIC = 0x4B4C4243             # "CBLK"
+EVENT_TX = 1
+EVENT_RX = 4
+STANDARD_FRAME = 0x0001              # Flag in arg for 11-bit identifiers
+
+
+def read_segment(blob, name):
+    """Yields (time_us, record) for every frame; returns (dropped, torn) via StopIteration."""
+    if len(blob) < SEGMENT.size:
+        raise ValueError(f"{name}: too short for a segment header")
+    magic, version, record_size, _, _, start_us, start_unix_us = SEGMENT.unpack_from(blob, 0)
+    if magic != SEGMENT_MAGIC:
+        raise ValueError(f"{name}: not a CAN log segment (magic 0x{magic:08X})")
+    if record_size != RECORD.size:
+        raise ValueError(f"{name}: unsupported record size {record_size} (version {version})")
+
+    offset = SEGMENT.size
+    last_us = start_us
+    dropped = 0
+    while offset < len(blob):
+        if offset + BLOCK.size > len(blob):
+            return dropped, True
+        magic, _, count, _, block_dropped, crc = BLOCK.unpack_from(blob, offset)
+        body = blob[offset + BLOCK.size:offset + BLOCK.size + count * RECORD.size]
+        if magic != BLOCK_MAGIC or count == 0 or len(body) != count * RECORD.size or zlib.crc32(body) != crc:
+            return dropped, True
+        dropped += block_dropped
+        for index in range(count):
+            record = RECORD.unpack_from(body, index * RECORD.size)
+            # Records carry the low 32 bits of esp_timer; unwrap against the previous one
+            delta = (record[0] - last_us) & 0xFFFFFFFF
+            if delta >= 0x80000000:
+                delta -= 0x100000000
+            last_us += delta
+            time_us = start_unix_us + (last_us - start_us) if start_unix_us else last_us
+            yield time_us, record
+        offset += BLOCK.size + count * RECORD.size
+    return dropped, False
+
+
+def format_candump(time_us, record):
+    _, identifier, data, _, length, arg = record
+    if arg & STANDARD_FRAME:
+        can_id = f"{identifier & 0x7FF:03X}"
+    else:
+        can_id = f"{identifier & 0x1FFFFFFF:08X}"
+    return f"({time_us // 1000000}.{time_us % 1000000:06d}) can0 {can_id}#{data[:length].hex().upper()}"
+
+
+def format_asc(time_us, record, base_us):
+    _, identifier, data, event, length, arg = record
+    relative = time_us - base_us
+    if arg & STANDARD_FRAME:
+        can_id = f"{identifier & 0x7FF:<15X}"
+    else:
+        can_id = f"{identifier & 0x1FFFFFFF:X}x{'':<6}"
+    direction = "Tx" if event == EVENT_TX else "Rx"
+    payload = "".join(f" {b:02X}" for b in data[:length])
+    return f"{relative // 1000000:7d}.{relative % 1000000:06d} 1  {can_id} {direction}   d {length}{payload}"
+
+
+def load(source):
+    if source.startswith("http://"):
+        with urllib.request.urlopen(source, timeout=10) as resp:
+            return resp.read()
+    with open(source, "rb") as handle:
+        return handle.read()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert panel CAN log segments (.clg)")
+    parser.add_argument("segments", nargs="+", help=".clg files or http://device/api/can/log?segment=N URLs")
+    parser.add_argument("--asc", action="store_true", help="Vector ASC output instead of candump")
+    args = parser.parse_args()
+
+    if args.asc:
+        print("date Thu Jan 1 00:00:00.000 1970\nbase hex  timestamps absolute\n"
+              "no internal events logged\nBegin Triggerblock")
+
+    base_us = None
+    frames = 0
+    for source in args.segments:
+        reader = read_segment(load(source), source)
+        while True:
+            try:
+                time_us, record = next(reader)
+            except StopIteration as done:
+                dropped, torn = done.value
+                break
+            if record[3] not in (EVENT_TX, EVENT_RX):
+                continue
+            if base_us is None:
+                base_us = time_us
+            print(format_asc(time_us, record, base_us) if args.asc else format_candump(time_us, record))
+            frames += 1
+        if dropped:
+            print(f"{source}: {dropped} records dropped on the panel", file=sys.stderr)
+        if torn:
+            print(f"{source}: stopped at a torn block (reset while writing)", file=sys.stderr)
+
+    if args.asc:
+        print("End TriggerBlock")
+    print(f"{frames} frames", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
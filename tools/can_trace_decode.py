@@ -0,0 +1,90 @@
+"""Decode a binary CAN trace dump from the panel.
+
+Fetch the dump with:
+    curl -o trace.bin http://<device-ip>/api/can/trace
+then run:
+    python tools/can_trace_decode.py trace.bin
+
+Record layout matches CanTraceRecord in src/can_trace.h (20 bytes, little-endian).
+"""
+
+import struct
+import sys
+import urllib.request
+
+HEADER = struct.Struct("<IHHII")     # magic, version, record_size, count, dropped
+RECORD = struct.Struct("<II8sBBH")   # timestamp_us, identifier, data, event, length, arg
+MAGIC = 0x43525443                   # "CTRC"
+
+EVENTS = {
+    1: "TX",
+    2: "TX_FAIL",
+    3: "TX_REJECT",
+    4: "RX",
+    5: "BUS_STATE",
+    6: "BUS_RECOVERY",
+}
+TWAI_STATES = {0: "STOPPED", 1: "RUNNING", 2: "BUS_OFF", 3: "RECOVERING"}
+
+
+def decode(blob):
+    magic, version, record_size, count, dropped = HEADER.unpack_from(blob, 0)
+    if magic != MAGIC:
+        raise ValueError(f"Not a CAN trace dump (magic 0x{magic:08X})")
+    if record_size != RECORD.size:
+        raise ValueError(f"Unsupported record size {record_size} (version {version})")
+
+    offset = HEADER.size
+    records = []
+    for _ in range(count):
+        if offset + RECORD.size > len(blob):
+            break
+        records.append(RECORD.unpack_from(blob, offset))
+        offset += RECORD.size
+    return records, dropped
+
+
+def format_record(record, base_us):
+    timestamp_us, identifier, data, event, length, arg = record
+    name = EVENTS.get(event, f"EV{event}")
+    rel_ms = ((timestamp_us - base_us) & 0xFFFFFFFF) / 1000.0
+    if name in ("TX", "RX"):
+        pgn = (identifier >> 8) & 0x3FFFF
+        if ((pgn >> 8) & 0xFF) < 240:
+            pgn &= 0x3FF00
+        payload = " ".join(f"{b:02X}" for b in data[:length])
+        return (f"{rel_ms:12.3f} ms {name:<12} ID=0x{identifier:08X} "
+                f"PGN=0x{pgn:05X} SA=0x{identifier & 0xFF:02X} [{length}] {payload}")
+    if name == "BUS_STATE":
+        return f"{rel_ms:12.3f} ms {name:<12} {TWAI_STATES.get(arg, arg)}"
+    if name == "TX_FAIL":
+        return f"{rel_ms:12.3f} ms {name:<12} ID=0x{identifier:08X} esp_err=0x{arg:X}"
+    return f"{rel_ms:12.3f} ms {name:<12} ID=0x{identifier:08X} arg={arg}"
+
+
+def main():
+    if len(sys.argv) != 2:
+        print("Usage: can_trace_decode.py <trace.bin | http://device/api/can/trace>")
+        sys.exit(1)
+
+    source = sys.argv[1]
+    if source.startswith("http://"):
+        with urllib.request.urlopen(source, timeout=5) as resp:
+            blob = resp.read()
+    else:
+        with open(source, "rb") as handle:
+            blob = handle.read()
+
+    records, dropped = decode(blob)
+    if not records:
+        print("Trace is empty")
+        return
+
+    base_us = records[0][0]
+    for record in records:
+        print(format_record(record, base_us))
+    print(f"\n{len(records)} records, {dropped} dropped by the drain task")
+
+
+if __name__ == "__main__":
+    main()